@@ -18,6 +18,7 @@
 #include "grpcpp/client_context.h"
 #include "intrinsic/icon/cc_client/operational_status.h"
 #include "intrinsic/icon/cc_client/robot_config.h"
+#include "intrinsic/icon/cc_client/status_watcher.h"
 #include "intrinsic/icon/common/part_properties.h"
 #include "intrinsic/icon/common/slot_part_map.h"
 #include "intrinsic/icon/control/logging_mode.h"
@@ -101,6 +102,30 @@ absl::StatusOr<intrinsic_proto::icon::PartStatus> Client::GetSinglePartStatus(
   return part_status_it->second;
 }
 
+absl::StatusOr<std::unique_ptr<StatusWatcher>> Client::WatchStatus(
+    const WatchStatusOptions& options) const {
+  if (options.min_interval < absl::ZeroDuration()) {
+    return absl::InvalidArgumentError("min_interval must not be negative.");
+  }
+  intrinsic_proto::icon::WatchStatusRequest request;
+  request.mutable_part_names()->Add(options.part_names.begin(),
+                                    options.part_names.end());
+  request.mutable_status_mask()->mutable_paths()->Add(
+      options.status_fields.begin(), options.status_fields.end());
+  request.mutable_state_variable_paths()->Add(
+      options.state_variable_paths.begin(), options.state_variable_paths.end());
+  request.set_include_operational_status(options.include_operational_status);
+  INTR_RETURN_IF_ERROR(
+      intrinsic::FromAbslDuration(options.min_interval,
+                                  request.mutable_min_interval()));
+
+  std::unique_ptr<::grpc::ClientContext> context = client_context_factory_();
+  std::unique_ptr<
+      ::grpc::ClientReaderInterface<intrinsic_proto::icon::WatchStatusResponse>>
+      reader = stub_->WatchStatus(context.get(), request);
+  return std::make_unique<StatusWatcher>(std::move(context), std::move(reader));
+}
+
 absl::Status Client::RestartServer() const {
   std::unique_ptr<::grpc::ClientContext> context = client_context_factory_();
   context->set_deadline(::grpc::DeadlineFromDuration(timeout_));
@@ -16,6 +16,7 @@
 #include "absl/types/span.h"
 #include "intrinsic/icon/cc_client/operational_status.h"
 #include "intrinsic/icon/cc_client/robot_config.h"
+#include "intrinsic/icon/cc_client/status_watcher.h"
 #include "intrinsic/icon/common/part_properties.h"
 #include "intrinsic/icon/common/slot_part_map.h"
 #include "intrinsic/icon/control/logging_mode.h"
@@ -113,6 +114,33 @@ class Client {
   absl::StatusOr<intrinsic_proto::icon::PartStatus> GetSinglePartStatus(
       absl::string_view part_name) const;
 
+  // Opens a subscription to the server-side status that is selected by
+  // `options`. The server sends the complete selected status once, and after
+  // that only what changed, at most once per `options.min_interval`.
+  //
+  // Prefer this over repeatedly calling GetStatus(), GetSinglePartStatus() or
+  // GetOperationalStatus() to monitor the status over time.
+  //
+  // Example:
+  //
+  //  INTR_ASSIGN_OR_RETURN(
+  //      std::unique_ptr<StatusWatcher> watcher,
+  //      icon_client.WatchStatus({.part_names = {"my_part"},
+  //                               .status_fields = {"part_status"},
+  //                               .min_interval = absl::Milliseconds(100)}));
+  //  while (watcher->Next().ok()) {
+  //    const intrinsic_proto::icon::PartStatus& my_part_status =
+  //        watcher->snapshot().status.part_status().at("my_part");
+  //  }
+  //
+  // Unlike the other requests, the subscription has no deadline.
+  //
+  // Servers that do not implement WatchStatus end the call right away, so the
+  // first StatusWatcher::Next() returns kUnimplemented. Callers that must work
+  // with such servers can fall back to polling GetStatus() then.
+  absl::StatusOr<std::unique_ptr<StatusWatcher>> WatchStatus(
+      const WatchStatusOptions& options) const;
+
   // Makes a request to the server to determine if action type
   // `action_type_name` is compatible with part `part_name`.
   absl::StatusOr<bool> IsActionCompatible(
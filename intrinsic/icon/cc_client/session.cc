@@ -2,6 +2,7 @@
 
 #include "intrinsic/icon/cc_client/session.h"
 
+#include <cstdint>
 #include <functional>
 #include <iterator>
 #include <memory>
@@ -21,6 +22,7 @@
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
 #include "absl/time/time.h"
 #include "absl/types/optional.h"
 #include "absl/types/span.h"
@@ -28,6 +30,8 @@
 #include "google/protobuf/any.pb.h"
 #include "google/rpc/status.pb.h"
 #include "grpcpp/client_context.h"
+#include "grpcpp/support/client_callback.h"
+#include "grpcpp/support/status.h"
 #include "grpcpp/support/sync_stream.h"
 #include "intrinsic/icon/cc_client/condition.h"
 #include "intrinsic/icon/common/id_types.h"
@@ -256,6 +260,157 @@ ActionDescriptor& ActionDescriptor::WithReaction(
 
 Action::Action(ActionInstanceId id) : id_(id) {}
 
+class Session::StreamingOutputSubscription
+    : public grpc::ClientReadReactor<
+          intrinsic_proto::icon::WatchStreamingOutputResponse> {
+ public:
+  using Callback =
+      std::function<void(const ::intrinsic_proto::icon::StreamingOutput&)>;
+
+  // What the watcher loop has to do for this subscription.
+  struct Update {
+    // The output to pass to the callback, if any.
+    std::optional<::intrinsic_proto::icon::StreamingOutput> output;
+    // The status of the call, once it has ended.
+    std::optional<absl::Status> call_status;
+  };
+
+  StreamingOutputSubscription(Callback callback,
+                              const StreamingOutputSubscriptionOptions& options,
+                              std::function<void()> wake_up)
+      : callback_(std::move(callback)),
+        options_(options),
+        wake_up_(std::move(wake_up)) {}
+
+  // Starts the call. The hold keeps the call alive while reading is paused,
+  // and is released once a read fails.
+  void Start(intrinsic_proto::icon::IconApi::StubInterface::async_interface*
+                 async_stub,
+             std::unique_ptr<grpc::ClientContext> context,
+             const intrinsic_proto::icon::WatchStreamingOutputRequest&
+                 request) {
+    context_ = std::move(context);
+    request_ = request;
+    async_stub->WatchStreamingOutput(context_.get(), &request_, this);
+    AddHold();
+    StartRead(&response_);
+    StartCall();
+  }
+
+  // Cancels the call and blocks until it has ended.
+  void Cancel() {
+    context_->TryCancel();
+    Resume();
+    done_.WaitForNotification();
+  }
+
+  // Takes the pending output and resumes reading if it was paused. Drops
+  // outputs that the server sent twice or earlier than
+  // `options_.min_interval` after the last delivered one.
+  Update TakeUpdate() {
+    Update update;
+    {
+      absl::MutexLock lock(&mutex_);
+      update.output = std::exchange(pending_output_, std::nullopt);
+      wake_up_pending_ = false;
+      if (call_ended_) {
+        update.call_status = call_status_;
+      }
+    }
+    if (update.call_status.has_value()) {
+      // OnDone() returns right after notifying.
+      done_.WaitForNotification();
+    } else {
+      Resume();
+    }
+    if (update.output.has_value()) {
+      const int64_t timestamp_ns = update.output->timestamp_ns();
+      if (last_delivered_timestamp_ns_.has_value() &&
+          (timestamp_ns == *last_delivered_timestamp_ns_ ||
+           (timestamp_ns > *last_delivered_timestamp_ns_ &&
+            timestamp_ns - *last_delivered_timestamp_ns_ <
+                absl::ToInt64Nanoseconds(options_.min_interval)))) {
+        update.output.reset();
+      } else {
+        last_delivered_timestamp_ns_ = timestamp_ns;
+      }
+    }
+    return update;
+  }
+
+  const Callback& callback() const { return callback_; }
+  const StreamingOutputSubscriptionOptions& options() const {
+    return options_;
+  }
+
+  void OnReadDone(bool ok) override {
+    if (!ok) {
+      RemoveHold();
+      return;
+    }
+    bool wake_up;
+    {
+      absl::MutexLock lock(&mutex_);
+      pending_output_ = std::move(*response_.mutable_output());
+      wake_up = !std::exchange(wake_up_pending_, true);
+      paused_ = !options_.latest_only;
+    }
+    if (wake_up) {
+      wake_up_();
+    }
+    if (options_.latest_only) {
+      StartRead(&response_);
+    }
+  }
+
+  void OnDone(const grpc::Status& status) override {
+    bool wake_up;
+    {
+      absl::MutexLock lock(&mutex_);
+      call_ended_ = true;
+      call_status_ = ToAbslStatus(status);
+      wake_up = !std::exchange(wake_up_pending_, true);
+    }
+    if (wake_up) {
+      wake_up_();
+    }
+    done_.Notify();
+  }
+
+ private:
+  // Starts the next read if reading was paused.
+  void Resume() {
+    bool paused;
+    {
+      absl::MutexLock lock(&mutex_);
+      paused = std::exchange(paused_, false);
+    }
+    if (paused) {
+      StartRead(&response_);
+    }
+  }
+
+  const Callback callback_;
+  const StreamingOutputSubscriptionOptions options_;
+  const std::function<void()> wake_up_;
+
+  std::unique_ptr<grpc::ClientContext> context_;
+  intrinsic_proto::icon::WatchStreamingOutputRequest request_;
+  intrinsic_proto::icon::WatchStreamingOutputResponse response_;
+  absl::Notification done_;
+
+  absl::Mutex mutex_;
+  std::optional<::intrinsic_proto::icon::StreamingOutput> pending_output_
+      ABSL_GUARDED_BY(mutex_);
+  bool wake_up_pending_ ABSL_GUARDED_BY(mutex_) = false;
+  bool paused_ ABSL_GUARDED_BY(mutex_) = false;
+  bool call_ended_ ABSL_GUARDED_BY(mutex_) = false;
+  absl::Status call_status_ ABSL_GUARDED_BY(mutex_);
+
+  // Only accessed by the watcher loop.
+  std::optional<int64_t> last_delivered_timestamp_ns_;
+};
+
 absl::StatusOr<std::unique_ptr<Session>> Session::Start(
     std::shared_ptr<ChannelInterface> icon_channel,
     absl::Span<const std::string> parts,
@@ -511,8 +666,7 @@ absl::Status Session::StopAllActions() {
 absl::Status Session::RunWatcherLoop(absl::Time deadline) {
   quit_watcher_loop_ = false;
   while (true) {
-    absl::StatusOr<std::optional<intrinsic_proto::icon::WatchReactionsResponse>>
-        response;
+    absl::StatusOr<WatcherEvent> response;
     ReadResult result =
         reactions_queue_.Reader().ReadWithTimeout(response, deadline);
     if (result == ReadResult::kDeadlineExceeded) {
@@ -541,14 +695,21 @@ absl::Status Session::RunWatcherLoop(absl::Time deadline) {
       return response.status();
     }
 
-    // nullopt is only a workaround to notify this thread that
+    // QuitWatcherLoopEvent is only a workaround to notify this thread that
     // `quit_watcher_loop_` was set.
-    if (*response == std::nullopt) {
+    if (std::holds_alternative<QuitWatcherLoopEvent>(*response)) {
       return absl::OkStatus();
     }
 
     // Normal case, service reaction callbacks.
-    TriggerReactionCallbacks(response->value());
+    if (const auto* reaction =
+            std::get_if<intrinsic_proto::icon::WatchReactionsResponse>(
+                &*response)) {
+      TriggerReactionCallbacks(*reaction);
+    }
+    // Also after reactions, in case a StreamingOutputEvent did not fit into
+    // the queue.
+    DeliverStreamingOutputs();
   }
 }
 
@@ -561,8 +722,8 @@ void Session::QuitWatcherLoop() {
     return;
   }
 
-  // send a null event to wake up the watcher loop
-  if (!reactions_queue_.Writer().Write(std::nullopt)) {
+  // send a quit event to wake up the watcher loop
+  if (!reactions_queue_.Writer().Write(WatcherEvent(QuitWatcherLoopEvent{}))) {
     LOG(ERROR) << "Failed to quit watcher loop, event queue full.";
   }
 }
@@ -580,6 +741,55 @@ Session::GetLatestOutput(ActionInstanceId id, absl::Time deadline) {
   return response.output();
 }
 
+absl::StatusOr<StreamingOutputSubscriptionId> Session::SubscribeStreamingOutput(
+    ActionInstanceId id,
+    std::function<void(const ::intrinsic_proto::icon::StreamingOutput&)>
+        callback,
+    const StreamingOutputSubscriptionOptions& options) {
+  if (session_ended_) {
+    return absl::FailedPreconditionError(kAlreadyEndedErrorMessage);
+  }
+  if (callback == nullptr) {
+    return absl::InvalidArgumentError("The callback must not be empty.");
+  }
+  if (options.min_interval < absl::ZeroDuration()) {
+    return absl::InvalidArgumentError("min_interval must not be negative.");
+  }
+  auto* async_stub = stub_->async();
+  if (async_stub == nullptr) {
+    return absl::UnimplementedError(
+        "The IconApi stub does not support asynchronous calls.");
+  }
+  ::intrinsic_proto::icon::WatchStreamingOutputRequest request;
+  request.set_session_id(session_id_.value());
+  request.set_action_id(id.value());
+  INTR_RETURN_IF_ERROR(::intrinsic::FromAbslDuration(
+      options.min_interval, request.mutable_min_interval()));
+
+  const StreamingOutputSubscriptionId subscription_id =
+      next_streaming_output_subscription_id_++;
+  auto subscription = std::make_shared<StreamingOutputSubscription>(
+      std::move(callback), options,
+      [this] { WakeUpWatcherLoopForStreamingOutputs(); });
+  streaming_output_subscriptions_.emplace(subscription_id, subscription);
+  subscription->Start(async_stub, client_context_factory_(), request);
+  return subscription_id;
+}
+
+absl::Status Session::UnsubscribeStreamingOutput(
+    StreamingOutputSubscriptionId id) {
+  auto it = streaming_output_subscriptions_.find(id);
+  if (it == streaming_output_subscriptions_.end()) {
+    return absl::NotFoundError(absl::StrCat(
+        "There is no streaming output subscription with id ", id.value()));
+  }
+  std::shared_ptr<StreamingOutputSubscription> subscription =
+      std::move(it->second);
+  streaming_output_subscriptions_.erase(it);
+  subscription->Cancel();
+  return absl::OkStatus();
+}
+
 absl::StatusOr<::intrinsic_proto::icon::JointTrajectoryPVA>
 Session::GetPlannedTrajectory(ActionInstanceId id) {
   std::unique_ptr<grpc::ClientContext> context = client_context_factory_();
@@ -595,12 +805,13 @@ Session::GetPlannedTrajectory(ActionInstanceId id) {
   std::vector<::intrinsic_proto::icon::JointTrajectoryPVA>
       planned_trajectory_segments;
   while (stream->Read(&response)) {
+    // Moves the segment out of `response`, which Read() overwrites anyway.
     planned_trajectory_segments.push_back(
-        response.planned_trajectory_segment());
+        std::move(*response.mutable_planned_trajectory_segment()));
   }
   INTR_RETURN_IF_ERROR(ToAbslStatus(stream->Finish()));
 
-  return ConcatenateTrajectoryProtos(planned_trajectory_segments);
+  return ConcatenateTrajectoryProtos(std::move(planned_trajectory_segments));
 }
 
 absl::Status Session::RunWatcherLoopUntilReaction(
@@ -647,6 +858,7 @@ absl::Status Session::End() {
   // watcher_stream_.Read() concurrently from multiple threads.
   watcher_read_thread_.Join();
   CleanUpWatcherCall();
+  CancelStreamingOutputSubscriptions();
   return session_call_status;
 }
 
@@ -764,12 +976,16 @@ void Session::TriggerReactionCallbacks(
 }
 
 void Session::CleanUpWatcherCall() {
-  absl::StatusOr<std::optional<intrinsic_proto::icon::WatchReactionsResponse>>
-      response = std::nullopt;
+  absl::StatusOr<WatcherEvent> response;
   while (reactions_queue_.Reader().Read(response) == ReadResult::kConsumed) {
-    if (response.ok() && response->has_value()) {
+    if (!response.ok()) {
+      continue;
+    }
+    if (const auto* reaction =
+            std::get_if<intrinsic_proto::icon::WatchReactionsResponse>(
+                &*response)) {
       DLOG(INFO) << "Had reaction event in queue after quitting watcher loop: "
-                 << response->value();
+                 << *reaction;
     }
   }
   LOG(INFO) << "Ended watcher call";
@@ -796,7 +1012,8 @@ void Session::WatchReactionsThreadBody() {
   while (watcher_stream_->Read(&watcher_reactions_response)) {
     // Block until the response can be written to the queue.
     absl::MutexLock l(&reactions_queue_writer_mutex_);
-    while (!reactions_queue_.Writer().Write(watcher_reactions_response)) {
+    while (!reactions_queue_.Writer().Write(
+        WatcherEvent(watcher_reactions_response))) {
     }
   }
   grpc::Status grpc_status = watcher_stream_->Finish();
@@ -809,6 +1026,68 @@ void Session::WatchReactionsThreadBody() {
   reactions_queue_.Writer().Close();
 }
 
+void Session::WakeUpWatcherLoopForStreamingOutputs() {
+  absl::MutexLock l(&reactions_queue_writer_mutex_);
+  if (reactions_queue_.Writer().Closed()) {
+    return;
+  }
+  // If the queue is full, the watcher loop delivers the pending outputs after
+  // the next queued event.
+  if (!reactions_queue_.Writer().Write(WatcherEvent(StreamingOutputEvent{}))) {
+    DLOG(INFO) << "Watcher event queue full, deferring streaming outputs.";
+  }
+}
+
+void Session::DeliverStreamingOutputs() {
+  std::vector<StreamingOutputSubscriptionId> ids;
+  ids.reserve(streaming_output_subscriptions_.size());
+  for (const auto& [id, subscription] : streaming_output_subscriptions_) {
+    ids.push_back(id);
+  }
+  for (StreamingOutputSubscriptionId id : ids) {
+    // Callbacks may unsubscribe or end the session.
+    auto it = streaming_output_subscriptions_.find(id);
+    if (it == streaming_output_subscriptions_.end()) {
+      continue;
+    }
+    std::shared_ptr<StreamingOutputSubscription> subscription = it->second;
+    StreamingOutputSubscription::Update update = subscription->TakeUpdate();
+    if (update.output.has_value()) {
+      subscription->callback()(*update.output);
+    }
+    if (!update.call_status.has_value()) {
+      continue;
+    }
+    streaming_output_subscriptions_.erase(id);
+    if (update.call_status->ok()) {
+      continue;
+    }
+    if (absl::IsUnimplemented(*update.call_status)) {
+      // Servers that predate WatchStreamingOutput end the call right away.
+      update.call_status = absl::UnimplementedError(absl::StrCat(
+          "The ICON server does not support streaming output subscriptions, "
+          "poll GetLatestOutput() instead: ",
+          update.call_status->message()));
+    }
+    if (subscription->options().error_callback) {
+      subscription->options().error_callback(*update.call_status);
+    } else {
+      LOG(ERROR) << "Streaming output subscription " << id.value()
+                 << " ended with status: " << *update.call_status;
+    }
+  }
+}
+
+void Session::CancelStreamingOutputSubscriptions() {
+  absl::flat_hash_map<StreamingOutputSubscriptionId,
+                      std::shared_ptr<StreamingOutputSubscription>>
+      subscriptions = std::move(streaming_output_subscriptions_);
+  streaming_output_subscriptions_.clear();
+  for (auto& [id, subscription] : subscriptions) {
+    subscription->Cancel();
+  }
+}
+
 // static
 std::vector<Action> Session::MakeActionVector(
     absl::Span<const ActionDescriptor> action_descriptors) {
@@ -10,6 +10,7 @@
 #include <optional>
 #include <string>
 #include <utility>
+#include <variant>
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
@@ -47,6 +48,9 @@ namespace icon {
 // Client-side identifier for a Reaction.
 DEFINE_STRONG_INT_TYPE(ReactionHandle, int64_t);
 
+// Client-side identifier for a streaming output subscription.
+DEFINE_STRONG_INT_TYPE(StreamingOutputSubscriptionId, int64_t);
+
 // Describes a reaction consisting of a condition that is evaluated on the
 // robot, and possible events that are triggered when the condition is true.
 // A reaction is triggered if
@@ -202,6 +206,26 @@ class Action {
   ActionInstanceId id_;
 };
 
+// Options for Session::SubscribeStreamingOutput().
+struct StreamingOutputSubscriptionOptions {
+  // If non-zero, delivers at most one output per `min_interval`, as measured
+  // by the output timestamps. The server skips the outputs in between, and so
+  // does the client if the server sends them anyway.
+  absl::Duration min_interval = absl::ZeroDuration();
+
+  // If true, only the latest output received since the last callback is
+  // delivered, so that a slow consumer always sees the most recent output.
+  // If false, the subscription stops reading from the server until the
+  // pending output was delivered, so that every output the server sends is
+  // delivered in order.
+  bool latest_only = true;
+
+  // Called on the watcher loop thread when the subscription ends with an
+  // error, e.g. because the action does not exist. Errors are logged if this
+  // is not set.
+  std::function<void(absl::Status)> error_callback;
+};
+
 // A `Session` scopes control of a set of parts to a single session. The
 // `Session` provides the ability to manipulate those parts by adding actions
 // and/or reactions.
@@ -369,11 +393,58 @@ class Session {
         channel_ ? channel_->GetClientContextFactory() : nullptr);
   }
 
+  // Creates an AsyncStreamWriter for the given `input_name` of the given
+  // action. Unlike the writer returned by StreamWriter(), its Write() does not
+  // wait for the server to acknowledge the value, so that a control loop can
+  // stream values at a higher rate than the round trip time permits.
+  //
+  // Returns an aborted error if the session ended. Other errors may be returned
+  // due to mismatched types, an input already in use, etc.
+  template <typename T>
+  absl::StatusOr<std::unique_ptr<::intrinsic::icon::AsyncStreamWriter<T>>>
+  AsyncStreamWriter(const Action& action, absl::string_view input_name,
+                    const StreamWriterOptions& options = {}) {
+    return ::intrinsic::icon::AsyncStreamWriter<T>::Open(
+        session_id_, action.id(), input_name, stub_.get(), options,
+        channel_ ? channel_->GetClientContextFactory() : nullptr);
+  }
+
   // Returns the latest output of the Action with `id`. Blocks until `deadline`
   // if that Action is active, but has not published an output value yet.
+  //
+  // Prefer SubscribeStreamingOutput() to monitor an output over time.
   absl::StatusOr<::intrinsic_proto::icon::StreamingOutput> GetLatestOutput(
       ActionInstanceId id, absl::Time deadline);
 
+  // Subscribes to the streaming output of the Action with `id`. The server
+  // sends each new output once, so unlike polling GetLatestOutput() the cost
+  // scales with the rate at which the action writes its output.
+  //
+  // `callback` is invoked from the watcher loop, i.e. on the thread that runs
+  // RunWatcherLoop(), like the callbacks of reactions. Outputs that arrive
+  // while the watcher loop is not running are delivered once it runs again,
+  // subject to `options.latest_only`.
+  //
+  // The subscription ends when it is cancelled with
+  // UnsubscribeStreamingOutput(), when the action is removed or when the
+  // session ends. Returns a failed precondition error if the session has
+  // already ended.
+  //
+  // Servers that do not implement WatchStreamingOutput end the subscription
+  // right away, so `options.error_callback` receives kUnimplemented from the
+  // watcher loop. Callers that must work with such servers can fall back to
+  // polling GetLatestOutput() then.
+  absl::StatusOr<StreamingOutputSubscriptionId> SubscribeStreamingOutput(
+      ActionInstanceId id,
+      std::function<void(const ::intrinsic_proto::icon::StreamingOutput&)>
+          callback,
+      const StreamingOutputSubscriptionOptions& options = {});
+
+  // Cancels the subscription with `id`. No callbacks of the subscription are
+  // invoked after this returns. Returns a not found error if there is no such
+  // subscription, e.g. because it has already ended.
+  absl::Status UnsubscribeStreamingOutput(StreamingOutputSubscriptionId id);
+
   absl::StatusOr<::intrinsic_proto::icon::JointTrajectoryPVA>
   GetPlannedTrajectory(ActionInstanceId id);
 
@@ -384,6 +455,18 @@ class Session {
   SessionId Id() const { return session_id_; }
 
  private:
+  // Receives the outputs of one SubscribeStreamingOutput() call.
+  class StreamingOutputSubscription;
+
+  // Events read by the watcher loop. A StreamingOutputEvent signals that a
+  // streaming output subscription has a pending output or has ended.
+  struct QuitWatcherLoopEvent {};
+  struct StreamingOutputEvent {};
+  using WatcherEvent =
+      std::variant<QuitWatcherLoopEvent,
+                   intrinsic_proto::icon::WatchReactionsResponse,
+                   StreamingOutputEvent>;
+
   // Common implementation of Start.
   static absl::StatusOr<std::unique_ptr<Session>> StartImpl(
       const intrinsic_proto::data_logger::Context& context,
@@ -448,6 +531,17 @@ class Session {
   // `reactions_queue_`.
   void WatchReactionsThreadBody();
 
+  // Queues a StreamingOutputEvent to wake up the watcher loop. Does nothing if
+  // the queue is closed. This method is thread-safe.
+  void WakeUpWatcherLoopForStreamingOutputs();
+
+  // Invokes the callbacks of all streaming output subscriptions with pending
+  // outputs, and removes the subscriptions that have ended.
+  void DeliverStreamingOutputs();
+
+  // Cancels all streaming output subscriptions and waits until they ended.
+  void CancelStreamingOutputSubscriptions();
+
   // Hold onto the channel, if any, so that callers do not need to worry about
   // its lifetime. May be nullptr depending on the version of Start used to
   // construct this session.
@@ -476,11 +570,10 @@ class Session {
 
   // Reaction events are written to the `reactions_queue_` from the
   // `watcher_read_thread_`, and read during `RunWatcherLoop()` on the calling
-  // thread. Passing a nullopt quits the watcher loop.
-  absl::Mutex reactions_queue_writer_mutex_;  // we write from two threads
-  RealtimeWriteQueue<absl::StatusOr<
-      std::optional<intrinsic_proto::icon::WatchReactionsResponse>>>
-      reactions_queue_;
+  // thread. Passing a QuitWatcherLoopEvent quits the watcher loop. Streaming
+  // output subscriptions write StreamingOutputEvents from gRPC threads.
+  absl::Mutex reactions_queue_writer_mutex_;  // we write from several threads
+  RealtimeWriteQueue<absl::StatusOr<WatcherEvent>> reactions_queue_;
   std::atomic<bool> quit_watcher_loop_ = false;
 
   // Used to read reaction events in the background. `watcher_stream_::Read()`
@@ -498,6 +591,13 @@ class Session {
 
   SessionId session_id_;
 
+  // Active streaming output subscriptions. The watcher loop holds a reference
+  // while it invokes a callback, so that callbacks may unsubscribe.
+  absl::flat_hash_map<StreamingOutputSubscriptionId,
+                      std::shared_ptr<StreamingOutputSubscription>>
+      streaming_output_subscriptions_;
+  StreamingOutputSubscriptionId next_streaming_output_subscription_id_{0};
+
   // Factory function that produces ::grpc::ClientContext objects before each
   // gRPC request. This is required to make new grpc calls on the fly since we
   // need to propagate the original icon connection parameters stored in here.
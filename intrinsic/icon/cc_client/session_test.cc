@@ -0,0 +1,338 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/icon/cc_client/session.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "grpcpp/server.h"
+#include "grpcpp/server_builder.h"
+#include "grpcpp/server_context.h"
+#include "grpcpp/support/channel_arguments.h"
+#include "grpcpp/support/status.h"
+#include "grpcpp/support/sync_stream.h"
+#include "intrinsic/icon/common/id_types.h"
+#include "intrinsic/icon/proto/service.grpc.pb.h"
+#include "intrinsic/icon/proto/service.pb.h"
+#include "intrinsic/icon/proto/streaming_output.pb.h"
+#include "intrinsic/util/testing/gtest_wrapper.h"
+
+namespace intrinsic {
+namespace icon {
+namespace {
+
+using ::intrinsic::testing::StatusIs;
+using ::intrinsic_proto::icon::StreamingOutput;
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+using ::testing::IsEmpty;
+using ::testing::Lt;
+using ::testing::SizeIs;
+
+constexpr int64_t kSessionId = 1;
+constexpr ActionInstanceId kActionId(1);
+
+// Opens sessions, keeps the reaction streams open until the session ends and
+// sends the outputs that the test publishes to every WatchStreamingOutput
+// call. Like the server, it does not apply `min_interval`.
+class FakeIconApiService : public intrinsic_proto::icon::IconApi::Service {
+ public:
+  grpc::Status OpenSession(
+      grpc::ServerContext* context,
+      grpc::ServerReaderWriter<intrinsic_proto::icon::OpenSessionResponse,
+                               intrinsic_proto::icon::OpenSessionRequest>*
+          stream) override {
+    intrinsic_proto::icon::OpenSessionRequest request;
+    if (!stream->Read(&request) || !request.has_initial_session_data()) {
+      return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                          "Expected initial session data.");
+    }
+    intrinsic_proto::icon::OpenSessionResponse response;
+    response.mutable_initial_session_data()->set_session_id(kSessionId);
+    stream->Write(response);
+    while (stream->Read(&request)) {
+      stream->Write(intrinsic_proto::icon::OpenSessionResponse());
+    }
+    absl::MutexLock lock(&mutex_);
+    session_ended_ = true;
+    return grpc::Status::OK;
+  }
+
+  grpc::Status WatchReactions(
+      grpc::ServerContext* context,
+      const intrinsic_proto::icon::WatchReactionsRequest* request,
+      grpc::ServerWriter<intrinsic_proto::icon::WatchReactionsResponse>*
+          writer) override {
+    writer->Write(intrinsic_proto::icon::WatchReactionsResponse());
+    absl::MutexLock lock(&mutex_);
+    while (!session_ended_ && !context->IsCancelled()) {
+      mutex_.AwaitWithTimeout(absl::Condition(&session_ended_),
+                              absl::Milliseconds(10));
+    }
+    return grpc::Status::OK;
+  }
+
+  grpc::Status WatchStreamingOutput(
+      grpc::ServerContext* context,
+      const intrinsic_proto::icon::WatchStreamingOutputRequest* request,
+      grpc::ServerWriter<intrinsic_proto::icon::WatchStreamingOutputResponse>*
+          writer) override {
+    if (!implement_watch_streaming_output_) {
+      return grpc::Status(grpc::StatusCode::UNIMPLEMENTED,
+                          "WatchStreamingOutput is not implemented.");
+    }
+    size_t num_sent = 0;
+    while (true) {
+      std::vector<StreamingOutput> outputs;
+      {
+        absl::MutexLock lock(&mutex_);
+        auto has_news = [this, num_sent]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(
+                            mutex_) {
+          return session_ended_ || num_sent < outputs_.size();
+        };
+        mutex_.AwaitWithTimeout(absl::Condition(&has_news),
+                                absl::Milliseconds(10));
+        if (context->IsCancelled()) {
+          ++num_cancelled_streams_;
+          return grpc::Status::CANCELLED;
+        }
+        if (session_ended_) {
+          return grpc::Status::OK;
+        }
+        outputs.assign(outputs_.begin() + num_sent, outputs_.end());
+        num_sent = outputs_.size();
+      }
+      for (const StreamingOutput& output : outputs) {
+        intrinsic_proto::icon::WatchStreamingOutputResponse response;
+        *response.mutable_output() = output;
+        writer->Write(response);
+      }
+    }
+  }
+
+  // Lets WatchStreamingOutput fail like on servers that predate it. Must be
+  // called before the service is started.
+  void DisableWatchStreamingOutput() {
+    implement_watch_streaming_output_ = false;
+  }
+
+  // Sends an output with `timestamp_ns` to all WatchStreamingOutput calls.
+  void Publish(int64_t timestamp_ns) {
+    absl::MutexLock lock(&mutex_);
+    StreamingOutput& output = outputs_.emplace_back();
+    output.set_timestamp_ns(timestamp_ns);
+  }
+
+  // Returns true once `num_streams` WatchStreamingOutput calls saw that they
+  // were cancelled, false if that takes until `deadline`.
+  bool AwaitCancelledStreams(int num_streams, absl::Time deadline) const {
+    absl::MutexLock lock(&mutex_);
+    auto cancelled = [this, num_streams]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(
+                         mutex_) {
+      return num_cancelled_streams_ >= num_streams;
+    };
+    return mutex_.AwaitWithDeadline(absl::Condition(&cancelled), deadline);
+  }
+
+ private:
+  bool implement_watch_streaming_output_ = true;
+
+  mutable absl::Mutex mutex_;
+  bool session_ended_ ABSL_GUARDED_BY(mutex_) = false;
+  std::vector<StreamingOutput> outputs_ ABSL_GUARDED_BY(mutex_);
+  int num_cancelled_streams_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
+class SessionStreamingOutputTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    grpc::ServerBuilder builder;
+    builder.RegisterService(&service_);
+    server_ = builder.BuildAndStart();
+    ASSERT_OK_AND_ASSIGN(
+        session_,
+        Session::Start(intrinsic_proto::icon::IconApi::NewStub(
+                           server_->InProcessChannel(grpc::ChannelArguments())),
+                       {"arm"}));
+  }
+
+  void TearDown() override {
+    session_.reset();
+    server_->Shutdown();
+  }
+
+  // Subscribes to kActionId with `options`. The subscription records the
+  // timestamps of the delivered outputs in `delivered_` and quits the watcher
+  // loop once it delivered `last_timestamp_ns`.
+  absl::StatusOr<StreamingOutputSubscriptionId> Subscribe(
+      int64_t last_timestamp_ns,
+      const StreamingOutputSubscriptionOptions& options = {}) {
+    return session_->SubscribeStreamingOutput(
+        kActionId,
+        [this, last_timestamp_ns](const StreamingOutput& output) {
+          delivered_.push_back(output.timestamp_ns());
+          if (output.timestamp_ns() == last_timestamp_ns) {
+            session_->QuitWatcherLoop();
+          }
+        },
+        options);
+  }
+
+  // Runs the watcher loop until a callback quits it.
+  absl::Status RunWatcherLoop() {
+    return session_->RunWatcherLoop(absl::Now() + absl::Seconds(10));
+  }
+
+  FakeIconApiService service_;
+  std::unique_ptr<grpc::Server> server_;
+  std::unique_ptr<Session> session_;
+  std::vector<int64_t> delivered_;
+};
+
+TEST_F(SessionStreamingOutputTest, DeliversEveryOutputInOrder) {
+  ASSERT_OK(Subscribe(/*last_timestamp_ns=*/3, {.latest_only = false}));
+
+  // All outputs arrive before the watcher loop runs. The subscription stops
+  // reading after the first, and resumes once that was delivered.
+  service_.Publish(1);
+  service_.Publish(2);
+  service_.Publish(3);
+  ASSERT_OK(RunWatcherLoop());
+
+  EXPECT_THAT(delivered_, ElementsAre(1, 2, 3));
+}
+
+TEST_F(SessionStreamingOutputTest, LatestOnlySkipsOutputsOfSlowConsumers) {
+  constexpr int kNumOutputs = 100;
+  bool published = false;
+  ASSERT_OK(session_->SubscribeStreamingOutput(
+      kActionId, [&](const StreamingOutput& output) {
+        delivered_.push_back(output.timestamp_ns());
+        if (!published) {
+          // Keep the watcher loop busy while the remaining outputs arrive.
+          published = true;
+          for (int i = 2; i <= kNumOutputs; ++i) {
+            service_.Publish(i);
+          }
+          absl::SleepFor(absl::Milliseconds(200));
+        }
+        if (output.timestamp_ns() == kNumOutputs) {
+          session_->QuitWatcherLoop();
+        }
+      }));
+
+  service_.Publish(1);
+  ASSERT_OK(RunWatcherLoop());
+
+  // The first and the latest output are always delivered.
+  EXPECT_EQ(delivered_.front(), 1);
+  EXPECT_EQ(delivered_.back(), kNumOutputs);
+  EXPECT_THAT(delivered_, SizeIs(Lt(kNumOutputs)));
+}
+
+TEST_F(SessionStreamingOutputTest, DropsOutputsWithTheSameTimestamp) {
+  ASSERT_OK(Subscribe(/*last_timestamp_ns=*/2, {.latest_only = false}));
+
+  service_.Publish(1);
+  service_.Publish(1);
+  service_.Publish(2);
+  ASSERT_OK(RunWatcherLoop());
+
+  EXPECT_THAT(delivered_, ElementsAre(1, 2));
+}
+
+TEST_F(SessionStreamingOutputTest, DropsOutputsWithinMinInterval) {
+  // The fake service sends all outputs, so the client has to filter them.
+  ASSERT_OK(Subscribe(/*last_timestamp_ns=*/130,
+                      {.min_interval = absl::Nanoseconds(10),
+                       .latest_only = false}));
+
+  for (int64_t timestamp_ns : {100, 105, 110, 119, 130}) {
+    service_.Publish(timestamp_ns);
+  }
+  ASSERT_OK(RunWatcherLoop());
+
+  EXPECT_THAT(delivered_, ElementsAre(100, 110, 130));
+}
+
+TEST_F(SessionStreamingOutputTest, UnsubscribeCancelsTheCall) {
+  StreamingOutputSubscriptionId id(-1);
+  ASSERT_OK_AND_ASSIGN(
+      id, session_->SubscribeStreamingOutput(
+              kActionId, [&](const StreamingOutput& output) {
+                delivered_.push_back(output.timestamp_ns());
+                EXPECT_OK(session_->UnsubscribeStreamingOutput(id));
+                session_->QuitWatcherLoop();
+              }));
+
+  service_.Publish(1);
+  ASSERT_OK(RunWatcherLoop());
+  ASSERT_TRUE(service_.AwaitCancelledStreams(
+      1, absl::Now() + absl::Seconds(10)));
+
+  // Later outputs are not delivered.
+  service_.Publish(2);
+  EXPECT_THAT(session_->RunWatcherLoop(absl::Now() + absl::Milliseconds(50)),
+              StatusIs(absl::StatusCode::kDeadlineExceeded));
+  EXPECT_THAT(delivered_, ElementsAre(1));
+  EXPECT_THAT(session_->UnsubscribeStreamingOutput(id),
+              StatusIs(absl::StatusCode::kNotFound));
+}
+
+TEST_F(SessionStreamingOutputTest, EndingTheSessionEndsSubscriptions) {
+  ASSERT_OK_AND_ASSIGN(StreamingOutputSubscriptionId id, Subscribe(1));
+
+  ASSERT_OK(session_->End());
+
+  EXPECT_THAT(session_->UnsubscribeStreamingOutput(id),
+              StatusIs(absl::StatusCode::kNotFound));
+  EXPECT_THAT(Subscribe(1), StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
+TEST_F(SessionStreamingOutputTest, RejectsInvalidArguments) {
+  EXPECT_THAT(session_->SubscribeStreamingOutput(kActionId, nullptr),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(Subscribe(1, {.min_interval = absl::Nanoseconds(-1)}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+class SessionWithoutStreamingOutputTest : public SessionStreamingOutputTest {
+ protected:
+  void SetUp() override {
+    service_.DisableWatchStreamingOutput();
+    SessionStreamingOutputTest::SetUp();
+  }
+};
+
+TEST_F(SessionWithoutStreamingOutputTest, ReportsUnimplemented) {
+  std::optional<absl::Status> error;
+  ASSERT_OK_AND_ASSIGN(
+      StreamingOutputSubscriptionId id,
+      Subscribe(1, {.error_callback = [&](absl::Status status) {
+                      error = status;
+                      session_->QuitWatcherLoop();
+                    }}));
+
+  ASSERT_OK(RunWatcherLoop());
+
+  ASSERT_TRUE(error.has_value());
+  EXPECT_THAT(*error, StatusIs(absl::StatusCode::kUnimplemented,
+                               HasSubstr("GetLatestOutput()")));
+  EXPECT_THAT(delivered_, IsEmpty());
+  EXPECT_THAT(session_->UnsubscribeStreamingOutput(id),
+              StatusIs(absl::StatusCode::kNotFound));
+}
+
+}  // namespace
+}  // namespace icon
+}  // namespace intrinsic
@@ -0,0 +1,109 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/icon/cc_client/status_watcher.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/field_mask.pb.h"
+#include "google/protobuf/util/field_mask_util.h"
+#include "grpcpp/client_context.h"
+#include "grpcpp/support/sync_stream.h"
+#include "intrinsic/icon/cc_client/operational_status.h"
+#include "intrinsic/icon/proto/service.pb.h"
+#include "intrinsic/util/status/status_conversion_grpc.h"
+#include "intrinsic/util/status/status_macros.h"
+
+namespace intrinsic {
+namespace icon {
+
+absl::Status ApplyStatusUpdate(
+    const intrinsic_proto::icon::WatchStatusResponse& update,
+    StatusSnapshot& snapshot) {
+  // Map fields carry only the changed entries, so they are merged entry by
+  // entry instead of through `updated_status_fields`.
+  const google::protobuf::Descriptor* descriptor =
+      intrinsic_proto::icon::GetStatusResponse::descriptor();
+  for (const std::string& path : update.updated_status_fields().paths()) {
+    const google::protobuf::FieldDescriptor* field =
+        descriptor->FindFieldByName(path);
+    if (field == nullptr || field->is_map()) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Invalid entry in updated_status_fields: ", path));
+    }
+  }
+  if (update.updated_status_fields().paths_size() > 0) {
+    google::protobuf::util::FieldMaskUtil::MergeOptions merge_options;
+    merge_options.set_replace_message_fields(true);
+    merge_options.set_replace_repeated_fields(true);
+    google::protobuf::util::FieldMaskUtil::MergeMessageTo(
+        update.status(), update.updated_status_fields(), merge_options,
+        &snapshot.status);
+  }
+
+  for (const auto& [part_name, part_status] : update.status().part_status()) {
+    (*snapshot.status.mutable_part_status())[part_name] = part_status;
+  }
+  for (const std::string& part_name : update.removed_parts()) {
+    snapshot.status.mutable_part_status()->erase(part_name);
+  }
+  for (const auto& [session_id, session] : update.status().sessions()) {
+    (*snapshot.status.mutable_sessions())[session_id] = session;
+  }
+  for (uint64_t session_id : update.removed_sessions()) {
+    snapshot.status.mutable_sessions()->erase(session_id);
+  }
+
+  for (const auto& [path, value] : update.state_variables()) {
+    snapshot.state_variables.insert_or_assign(path, value);
+  }
+
+  if (update.has_operational_status()) {
+    INTR_ASSIGN_OR_RETURN(snapshot.operational_status,
+                          FromProto(update.operational_status()));
+  }
+  return absl::OkStatus();
+}
+
+StatusWatcher::StatusWatcher(
+    std::unique_ptr<::grpc::ClientContext> context,
+    std::unique_ptr<
+        ::grpc::ClientReaderInterface<intrinsic_proto::icon::WatchStatusResponse>>
+        reader)
+    : context_(std::move(context)), reader_(std::move(reader)) {}
+
+StatusWatcher::~StatusWatcher() {
+  if (call_status_.has_value()) {
+    return;
+  }
+  context_->TryCancel();
+  // Finish() requires all incoming messages to be read.
+  while (reader_->Read(&update_)) {
+  }
+  reader_->Finish();
+}
+
+absl::Status StatusWatcher::Next() {
+  if (call_status_.has_value()) {
+    return *call_status_;
+  }
+  if (!reader_->Read(&update_)) {
+    call_status_ = ToAbslStatus(reader_->Finish());
+    if (call_status_->ok()) {
+      // The server only ends the call on its own if something went wrong.
+      call_status_ = absl::AbortedError("The server ended the status watch.");
+    }
+    return *call_status_;
+  }
+  return ApplyStatusUpdate(update_, snapshot_);
+}
+
+void StatusWatcher::Cancel() { context_->TryCancel(); }
+
+}  // namespace icon
+}  // namespace intrinsic
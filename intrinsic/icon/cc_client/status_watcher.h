@@ -0,0 +1,111 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#ifndef INTRINSIC_ICON_CC_CLIENT_STATUS_WATCHER_H_
+#define INTRINSIC_ICON_CC_CLIENT_STATUS_WATCHER_H_
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/time/time.h"
+#include "grpcpp/client_context.h"
+#include "grpcpp/support/sync_stream.h"
+#include "intrinsic/icon/cc_client/operational_status.h"
+#include "intrinsic/icon/proto/service.pb.h"
+
+namespace intrinsic {
+namespace icon {
+
+// Selects what Client::WatchStatus() watches.
+struct WatchStatusOptions {
+  // The parts whose status to watch. Watches all parts if empty.
+  std::vector<std::string> part_names;
+
+  // The top-level fields of intrinsic_proto::icon::GetStatusResponse to watch,
+  // e.g. "part_status" or "safety_status". Watches all fields if empty.
+  std::vector<std::string> status_fields;
+
+  // Paths of state variables to watch, see state_variable_path.h.
+  std::vector<std::string> state_variable_paths;
+
+  // If true, also watches the operational status.
+  bool include_operational_status = false;
+
+  // If non-zero, the server sends at most one update per `min_interval`.
+  // Otherwise it sends an update whenever the watched status changes.
+  absl::Duration min_interval = absl::ZeroDuration();
+};
+
+// The status assembled from the updates a StatusWatcher received so far.
+struct StatusSnapshot {
+  // Contains the watched fields, and only the watched parts in `part_status`.
+  intrinsic_proto::icon::GetStatusResponse status;
+
+  // Set if WatchStatusOptions::include_operational_status was true.
+  std::optional<OperationalStatus> operational_status;
+
+  // The values of the watched state variables, keyed by path.
+  absl::flat_hash_map<std::string,
+                      intrinsic_proto::icon::WatchStatusResponse::
+                          StateVariableValue>
+      state_variables;
+};
+
+// Applies `update`, which contains the changes since the previous update, to
+// `snapshot`. Returns an error if `update` is malformed, in which case
+// `snapshot` may be partially updated.
+absl::Status ApplyStatusUpdate(
+    const intrinsic_proto::icon::WatchStatusResponse& update,
+    StatusSnapshot& snapshot);
+
+// Receives the updates of a Client::WatchStatus() call.
+//
+// Cancel() is thread-safe, all other methods are not.
+class StatusWatcher {
+ public:
+  // Takes ownership of a WatchStatus call that was started with `context`.
+  // Use Client::WatchStatus() instead of calling this directly.
+  StatusWatcher(std::unique_ptr<::grpc::ClientContext> context,
+                std::unique_ptr<::grpc::ClientReaderInterface<
+                    intrinsic_proto::icon::WatchStatusResponse>>
+                    reader);
+
+  // Cancels the call if it has not ended yet.
+  ~StatusWatcher();
+
+  StatusWatcher(const StatusWatcher&) = delete;
+  StatusWatcher& operator=(const StatusWatcher&) = delete;
+
+  // Blocks until the server sends the next update and applies it to
+  // snapshot(). The first update contains the complete watched status.
+  //
+  // Returns the status the call ended with once there are no more updates,
+  // e.g. kCancelled after Cancel(), or kNotFound if a watched part or state
+  // variable does not exist. Keeps returning that status afterwards.
+  absl::Status Next();
+
+  // The status assembled from all updates so far.
+  const StatusSnapshot& snapshot() const { return snapshot_; }
+
+  // Cancels the call, which makes a pending or subsequent Next() return.
+  // This method is thread-safe.
+  void Cancel();
+
+ private:
+  std::unique_ptr<::grpc::ClientContext> context_;
+  std::unique_ptr<
+      ::grpc::ClientReaderInterface<intrinsic_proto::icon::WatchStatusResponse>>
+      reader_;
+  // Set once the call has ended.
+  std::optional<absl::Status> call_status_;
+  intrinsic_proto::icon::WatchStatusResponse update_;
+  StatusSnapshot snapshot_;
+};
+
+}  // namespace icon
+}  // namespace intrinsic
+
+#endif  // INTRINSIC_ICON_CC_CLIENT_STATUS_WATCHER_H_
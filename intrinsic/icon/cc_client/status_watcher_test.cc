@@ -0,0 +1,252 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/icon/cc_client/status_watcher.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "absl/status/status.h"
+#include "intrinsic/icon/cc_client/operational_status.h"
+#include "intrinsic/icon/proto/service.pb.h"
+#include "intrinsic/util/proto/parse_text_proto.h"
+#include "intrinsic/util/testing/gtest_wrapper.h"
+
+namespace intrinsic {
+namespace icon {
+namespace {
+
+using ::intrinsic::testing::EqualsProto;
+using ::intrinsic::testing::StatusIs;
+using ::intrinsic_proto::icon::WatchStatusResponse;
+using ::testing::Eq;
+using ::testing::IsEmpty;
+using ::testing::Optional;
+using ::testing::Property;
+using ::testing::SizeIs;
+
+TEST(ApplyStatusUpdateTest, FirstUpdateSetsWatchedStatus) {
+  StatusSnapshot snapshot;
+  ASSERT_OK(ApplyStatusUpdate(ParseTextProtoOrDie(R"pb(
+                                status {
+                                  part_status {
+                                    key: "arm"
+                                    value {
+                                      joint_states { position_sensed: 1.0 }
+                                    }
+                                  }
+                                  current_speed_override: 0.5
+                                }
+                                updated_status_fields {
+                                  paths: "current_speed_override"
+                                }
+                              )pb"),
+                              snapshot));
+
+  EXPECT_THAT(snapshot.status, EqualsProto(R"pb(
+                part_status {
+                  key: "arm"
+                  value { joint_states { position_sensed: 1.0 } }
+                }
+                current_speed_override: 0.5
+              )pb"));
+  EXPECT_FALSE(snapshot.operational_status.has_value());
+  EXPECT_THAT(snapshot.state_variables, IsEmpty());
+}
+
+TEST(ApplyStatusUpdateTest, ReplacesChangedPartsAndKeepsOthers) {
+  StatusSnapshot snapshot;
+  ASSERT_OK(ApplyStatusUpdate(
+      ParseTextProtoOrDie(R"pb(
+        status {
+          part_status {
+            key: "arm"
+            value {
+              joint_states { position_sensed: 1.0 }
+              joint_states { position_sensed: 2.0 }
+            }
+          }
+          part_status {
+            key: "gripper"
+            value { joint_states { position_sensed: 3.0 } }
+          }
+        }
+      )pb"),
+      snapshot));
+
+  // The changed part is sent in full and replaces the previous status, so
+  // joints that are no longer reported disappear.
+  ASSERT_OK(ApplyStatusUpdate(ParseTextProtoOrDie(R"pb(
+                                status {
+                                  part_status {
+                                    key: "arm"
+                                    value {
+                                      joint_states { position_sensed: 4.0 }
+                                    }
+                                  }
+                                }
+                              )pb"),
+                              snapshot));
+
+  EXPECT_THAT(snapshot.status, EqualsProto(R"pb(
+                part_status {
+                  key: "arm"
+                  value { joint_states { position_sensed: 4.0 } }
+                }
+                part_status {
+                  key: "gripper"
+                  value { joint_states { position_sensed: 3.0 } }
+                }
+              )pb"));
+}
+
+TEST(ApplyStatusUpdateTest, RemovesPartsAndSessions) {
+  StatusSnapshot snapshot;
+  ASSERT_OK(ApplyStatusUpdate(ParseTextProtoOrDie(R"pb(
+                                status {
+                                  part_status {
+                                    key: "arm"
+                                    value {}
+                                  }
+                                  part_status {
+                                    key: "gripper"
+                                    value {}
+                                  }
+                                  sessions {
+                                    key: 1
+                                    value { action_ids: 7 }
+                                  }
+                                  sessions {
+                                    key: 2
+                                    value { action_ids: 8 }
+                                  }
+                                }
+                              )pb"),
+                              snapshot));
+
+  ASSERT_OK(ApplyStatusUpdate(ParseTextProtoOrDie(R"pb(
+                                removed_parts: "gripper"
+                                removed_sessions: 1
+                                # Removing what is not there is not an error.
+                                removed_parts: "unknown"
+                                removed_sessions: 3
+                              )pb"),
+                              snapshot));
+
+  EXPECT_THAT(snapshot.status, EqualsProto(R"pb(
+                part_status {
+                  key: "arm"
+                  value {}
+                }
+                sessions {
+                  key: 2
+                  value { action_ids: 8 }
+                }
+              )pb"));
+}
+
+TEST(ApplyStatusUpdateTest, ClearsListedFieldsThatAreNotSet) {
+  StatusSnapshot snapshot;
+  ASSERT_OK(ApplyStatusUpdate(ParseTextProtoOrDie(R"pb(
+                                status {
+                                  current_speed_override: 0.5
+                                  safety_status {
+                                    mode_of_safe_operation:
+                                        MODE_OF_SAFE_OPERATION_AUTOMATIC
+                                  }
+                                }
+                                updated_status_fields {
+                                  paths: "current_speed_override"
+                                  paths: "safety_status"
+                                }
+                              )pb"),
+                              snapshot));
+
+  ASSERT_OK(ApplyStatusUpdate(ParseTextProtoOrDie(R"pb(
+                                status {}
+                                updated_status_fields { paths: "safety_status" }
+                              )pb"),
+                              snapshot));
+
+  EXPECT_THAT(snapshot.status, EqualsProto(R"pb(
+                current_speed_override: 0.5
+              )pb"));
+}
+
+TEST(ApplyStatusUpdateTest, IgnoresUnlistedNonMapFields) {
+  StatusSnapshot snapshot;
+  ASSERT_OK(ApplyStatusUpdate(ParseTextProtoOrDie(R"pb(
+                                status { current_speed_override: 0.5 }
+                              )pb"),
+                              snapshot));
+
+  EXPECT_THAT(snapshot.status, EqualsProto(""));
+}
+
+TEST(ApplyStatusUpdateTest, MergesStateVariables) {
+  StatusSnapshot snapshot;
+  ASSERT_OK(ApplyStatusUpdate(ParseTextProtoOrDie(R"pb(
+                                state_variables {
+                                  key: "a"
+                                  value { double_value: 1.0 }
+                                }
+                                state_variables {
+                                  key: "b"
+                                  value { bool_value: true }
+                                }
+                              )pb"),
+                              snapshot));
+  ASSERT_OK(ApplyStatusUpdate(ParseTextProtoOrDie(R"pb(
+                                state_variables {
+                                  key: "a"
+                                  value { int64_value: 2 }
+                                }
+                              )pb"),
+                              snapshot));
+
+  ASSERT_THAT(snapshot.state_variables, SizeIs(2));
+  EXPECT_THAT(snapshot.state_variables.at("a"),
+              EqualsProto(R"pb(int64_value: 2)pb"));
+  EXPECT_THAT(snapshot.state_variables.at("b"),
+              EqualsProto(R"pb(bool_value: true)pb"));
+}
+
+TEST(ApplyStatusUpdateTest, UpdatesOperationalStatusOnlyWhenSent) {
+  StatusSnapshot snapshot;
+  WatchStatusResponse update;
+  *update.mutable_operational_status() =
+      ToProto(OperationalStatus::Faulted("broken"));
+  ASSERT_OK(ApplyStatusUpdate(update, snapshot));
+  ASSERT_TRUE(snapshot.operational_status.has_value());
+  EXPECT_TRUE(IsFaulted(*snapshot.operational_status));
+  EXPECT_THAT(snapshot.operational_status,
+              Optional(Property(&OperationalStatus::fault_reason,
+                                Eq("broken"))));
+
+  ASSERT_OK(ApplyStatusUpdate(WatchStatusResponse(), snapshot));
+  ASSERT_TRUE(snapshot.operational_status.has_value());
+  EXPECT_TRUE(IsFaulted(*snapshot.operational_status));
+}
+
+TEST(ApplyStatusUpdateTest, RejectsMapFieldsInUpdatedStatusFields) {
+  StatusSnapshot snapshot;
+  EXPECT_THAT(ApplyStatusUpdate(ParseTextProtoOrDie(R"pb(
+                                  updated_status_fields { paths: "part_status" }
+                                )pb"),
+                                snapshot),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(ApplyStatusUpdateTest, RejectsUnknownUpdatedStatusFields) {
+  StatusSnapshot snapshot;
+  EXPECT_THAT(ApplyStatusUpdate(ParseTextProtoOrDie(R"pb(
+                                  updated_status_fields {
+                                    paths: "safety_status.mode_of_safe_operation"
+                                  }
+                                )pb"),
+                                snapshot),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace icon
+}  // namespace intrinsic
@@ -2,21 +2,55 @@
 
 #include "intrinsic/icon/cc_client/stream.h"
 
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "absl/log/log.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 #include "google/protobuf/any.pb.h"
+#include "google/protobuf/message.h"
+#include "google/rpc/status.pb.h"
+#include "grpcpp/client_context.h"
 #include "grpcpp/support/sync_stream.h"
 #include "intrinsic/icon/common/id_types.h"
+#include "intrinsic/icon/proto/service.grpc.pb.h"
 #include "intrinsic/icon/proto/service.pb.h"
+#include "intrinsic/util/grpc/channel_interface.h"
 #include "intrinsic/util/status/status_conversion_grpc.h"
 #include "intrinsic/util/status/status_conversion_rpc.h"
 #include "intrinsic/util/status/status_macros.h"
+#include "intrinsic/util/thread/thread.h"
 
 namespace intrinsic::icon::internal {
 
+absl::StatusOr<std::unique_ptr<GenericStreamWriter>> OpenGenericStreamWriter(
+    SessionId session_id, ActionInstanceId action_instance_id,
+    absl::string_view input_name,
+    intrinsic_proto::icon::IconApi::StubInterface* stub,
+    const ClientContextFactory& client_context_factory) {
+  std::unique_ptr<::grpc::ClientContext> context;
+  if (client_context_factory) {
+    context = client_context_factory();
+  } else {
+    context = std::make_unique<::grpc::ClientContext>();
+  }
+  auto grpc_stream = stub->OpenWriteStream(context.get());
+  auto generic_stream_writer = std::make_unique<GenericStreamWriter>(
+      std::move(context), std::move(grpc_stream));
+  INTR_RETURN_IF_ERROR(generic_stream_writer->OpenStreamWriter(
+      session_id, action_instance_id, input_name));
+  return generic_stream_writer;
+}
+
 GenericStreamWriter::~GenericStreamWriter() {
   if (absl::Status status = FinishIfNeeded(); !status.ok()) {
     LOG(ERROR) << "Stream closing with status: " << status;
@@ -61,36 +95,54 @@ absl::Status GenericStreamWriter::OpenStreamWriter(
 
 absl::Status GenericStreamWriter::WriteToStream(
     const google::protobuf::Message& value) {
-  intrinsic_proto::icon::OpenWriteStreamRequest req;
-  req.mutable_write_value()->mutable_value()->PackFrom(value);
-
-  if (!grpc_stream_->Write(req)) {
+  if (!WriteValue(value)) {
     INTR_RETURN_IF_ERROR(FinishIfNeeded());
     return absl::AbortedError("Failed to write to stream.");
   }
 
+  absl::StatusOr<google::rpc::Status> write_status = ReadWriteValueResponse();
+  if (!write_status.ok()) {
+    INTR_RETURN_IF_ERROR(FinishIfNeeded());
+    return write_status.status();
+  }
+  return intrinsic::MakeStatusFromRpcStatus(*write_status);
+}
+
+bool GenericStreamWriter::WriteValue(const google::protobuf::Message& value) {
+  intrinsic_proto::icon::OpenWriteStreamRequest req;
+  req.mutable_write_value()->mutable_value()->PackFrom(value);
+  return grpc_stream_->Write(req);
+}
+
+absl::StatusOr<google::rpc::Status>
+GenericStreamWriter::ReadWriteValueResponse() {
   intrinsic_proto::icon::OpenWriteStreamResponse resp;
   if (!grpc_stream_->Read(&resp)) {
-    INTR_RETURN_IF_ERROR(FinishIfNeeded());
     return absl::AbortedError("Failed to write to stream.");
   }
 
   if (!resp.has_write_value_response()) {
-    INTR_RETURN_IF_ERROR(FinishIfNeeded());
     return absl::InternalError(
         "Stream write response is missing `write_value_response` field after "
         "writing a value.");
   }
 
-  return intrinsic::MakeStatusFromRpcStatus(resp.write_value_response());
+  return std::move(*resp.mutable_write_value_response());
+}
+
+bool GenericStreamWriter::WritesDone() {
+  writes_done_ = true;
+  return grpc_stream_->WritesDone();
 }
 
+void GenericStreamWriter::Cancel() { channel_context_->TryCancel(); }
+
 absl::Status GenericStreamWriter::FinishIfNeeded() {
   if (finish_status_.has_value()) {
     return *finish_status_;
   }
   // WritesDone must be called only once.
-  if (!grpc_stream_->WritesDone()) {
+  if (!writes_done_ && !grpc_stream_->WritesDone()) {
     intrinsic_proto::icon::OpenWriteStreamResponse resp;
     while (grpc_stream_->Read(&resp)) {
       LOG(ERROR) << "Received unexpected response from the server:" << resp;
@@ -100,4 +152,157 @@ absl::Status GenericStreamWriter::FinishIfNeeded() {
   return *finish_status_;
 }
 
+GenericAsyncStreamWriter::GenericAsyncStreamWriter(
+    std::unique_ptr<GenericStreamWriter> stream_writer,
+    const StreamWriterOptions& options)
+    : options_(options), stream_writer_(std::move(stream_writer)) {
+  writer_thread_ = Thread([this] { RunWriter(); });
+  reader_thread_ = Thread([this] { RunReader(); });
+}
+
+GenericAsyncStreamWriter::~GenericAsyncStreamWriter() {
+  if (absl::Status status = Close(); !status.ok()) {
+    LOG(ERROR) << "Stream closing with status: " << status;
+  }
+}
+
+absl::Status GenericAsyncStreamWriter::Write(
+    const google::protobuf::Message& value) {
+  // Copies the value outside of the lock. Packing it into the request is left
+  // to the writer thread.
+  std::unique_ptr<google::protobuf::Message> copy(value.New());
+  copy->CopyFrom(value);
+
+  absl::MutexLock lock(&mutex_);
+  INTR_RETURN_IF_ERROR(status_);
+  if (closing_) {
+    return absl::FailedPreconditionError("The stream writer is closed.");
+  }
+  if (options_.latest_value_wins) {
+    completed_ += queue_.size();
+    queue_.clear();
+  } else if (queue_.size() >=
+             static_cast<size_t>(options_.max_queued_values)) {
+    return absl::ResourceExhaustedError(
+        "The queue of values to write to the stream is full.");
+  }
+  queue_.push_back(std::move(copy));
+  ++enqueued_;
+  return absl::OkStatus();
+}
+
+absl::Status GenericAsyncStreamWriter::Flush(absl::Time deadline) {
+  absl::MutexLock lock(&mutex_);
+  const int64_t enqueued = enqueued_;
+  auto flushed = [this, enqueued]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return completed_ >= enqueued || stream_ended_;
+  };
+  if (!mutex_.AwaitWithDeadline(absl::Condition(&flushed), deadline)) {
+    return absl::DeadlineExceededError(
+        "Deadline exceeded while waiting for the stream to acknowledge the "
+        "written values.");
+  }
+  return status_;
+}
+
+absl::Status GenericAsyncStreamWriter::Close() {
+  absl::MutexLock close_lock(&close_mutex_);
+  if (close_status_.has_value()) {
+    return *close_status_;
+  }
+  {
+    absl::MutexLock lock(&mutex_);
+    closing_ = true;
+  }
+  writer_thread_.Join();
+  reader_thread_.Join();
+  absl::Status finish_status = stream_writer_->FinishIfNeeded();
+
+  absl::MutexLock lock(&mutex_);
+  RecordError(finish_status);
+  close_status_ = status_;
+  return status_;
+}
+
+void GenericAsyncStreamWriter::RunWriter() {
+  absl::MutexLock lock(&mutex_);
+  while (true) {
+    auto has_work = [this]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+      return stream_ended_ || (closing_ && queue_.empty()) ||
+             (!queue_.empty() &&
+              unacknowledged_ < options_.max_unacknowledged_values);
+    };
+    mutex_.Await(absl::Condition(&has_work));
+    if (queue_.empty() || stream_ended_) {
+      break;
+    }
+    std::unique_ptr<google::protobuf::Message> value =
+        std::move(queue_.front());
+    queue_.pop_front();
+    ++unacknowledged_;
+
+    mutex_.Unlock();
+    const bool written = stream_writer_->WriteValue(*value);
+    mutex_.Lock();
+    if (!written) {
+      // The reader sees the broken stream, too, and records the error.
+      return;
+    }
+  }
+  mutex_.Unlock();
+  // Lets the server end the call once it answered all values, which ends the
+  // reader.
+  stream_writer_->WritesDone();
+  mutex_.Lock();
+}
+
+void GenericAsyncStreamWriter::RunReader() {
+  while (true) {
+    absl::StatusOr<google::rpc::Status> write_status =
+        stream_writer_->ReadWriteValueResponse();
+    std::vector<absl::Status> errors;
+    bool cancel = false;
+    {
+      absl::MutexLock lock(&mutex_);
+      if (!write_status.ok()) {
+        stream_ended_ = true;
+        // The call ends regularly after WritesDone().
+        if (!(closing_ && queue_.empty() && unacknowledged_ == 0)) {
+          RecordError(write_status.status());
+          errors.push_back(write_status.status());
+          cancel = true;
+        }
+      } else {
+        --unacknowledged_;
+        ++completed_;
+        if (absl::Status status = intrinsic::MakeStatusFromRpcStatus(
+                *write_status);
+            !status.ok()) {
+          RecordError(status);
+          errors.push_back(std::move(status));
+        }
+      }
+    }
+    if (options_.error_callback) {
+      for (const absl::Status& error : errors) {
+        options_.error_callback(error);
+      }
+    }
+    if (cancel) {
+      // Nobody reads the responses anymore, so the server may block on
+      // writing them and stop reading values, which blocks the writer.
+      stream_writer_->Cancel();
+    }
+    if (!write_status.ok()) {
+      return;
+    }
+  }
+}
+
+void GenericAsyncStreamWriter::RecordError(const absl::Status& status) {
+  if (status_.ok()) {
+    status_ = status;
+  }
+}
+
 }  // namespace intrinsic::icon::internal
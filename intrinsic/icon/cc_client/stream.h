@@ -3,14 +3,21 @@
 #ifndef INTRINSIC_ICON_CC_CLIENT_STREAM_H_
 #define INTRINSIC_ICON_CC_CLIENT_STREAM_H_
 
+#include <cstdint>
+#include <deque>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <utility>
 
+#include "absl/base/thread_annotations.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "google/rpc/status.pb.h"
 #include "grpcpp/client_context.h"
 #include "grpcpp/support/sync_stream.h"
 #include "intrinsic/icon/common/id_types.h"
@@ -18,6 +25,7 @@
 #include "intrinsic/icon/proto/service.pb.h"
 #include "intrinsic/util/grpc/channel_interface.h"
 #include "intrinsic/util/status/status_macros.h"
+#include "intrinsic/util/thread/thread.h"
 
 namespace intrinsic::icon {
 
@@ -34,6 +42,26 @@ class StreamWriterInterface {
   virtual absl::Status Write(const T& value) = 0;
 };
 
+// Configures an AsyncStreamWriter.
+struct StreamWriterOptions {
+  // Maximum number of values which were passed to Write() but not written to
+  // the stream yet.
+  int max_queued_values = 16;
+
+  // If true, Write() replaces the queued values with the new one, so that only
+  // the most recent value is sent once the stream catches up. Useful for
+  // setpoints, where an outdated value is of no use.
+  bool latest_value_wins = false;
+
+  // Maximum number of values which were written to the stream, but not
+  // acknowledged by the server yet.
+  int max_unacknowledged_values = 16;
+
+  // Called on a background thread with each error: values the server rejected
+  // as well as the failure of the stream itself.
+  std::function<void(absl::Status)> error_callback;
+};
+
 namespace internal {
 
 class GenericStreamWriter {
@@ -55,6 +83,22 @@ class GenericStreamWriter {
   absl::Status WriteToStream(const google::protobuf::Message& value);
   absl::Status FinishIfNeeded();
 
+  // Building blocks of WriteToStream(), which GenericAsyncStreamWriter calls
+  // from different threads. One thread may write while another one reads.
+
+  // Writes `value` without waiting for the response. Returns false if the
+  // stream is broken.
+  bool WriteValue(const google::protobuf::Message& value);
+  // Reads the response to one written value and returns the status the server
+  // reported for it. Returns an error if the stream is broken.
+  absl::StatusOr<google::rpc::Status> ReadWriteValueResponse();
+  // Signals that no more values will be written. FinishIfNeeded() must not
+  // read concurrently afterwards, so the responses must have been read.
+  bool WritesDone();
+  // Cancels the call, so that pending and later reads and writes fail. May be
+  // called concurrently with reads and writes.
+  void Cancel();
+
  private:
   std::unique_ptr<::grpc::ClientContext> channel_context_;
   std::unique_ptr<::grpc::ClientReaderWriterInterface<
@@ -63,6 +107,58 @@ class GenericStreamWriter {
       grpc_stream_;
   // If set, gprc_stream_ must not be used.
   std::optional<absl::Status> finish_status_;
+  bool writes_done_ = false;
+};
+
+// Opens an OpenWriteStream call and adds the write stream for `input_name`.
+absl::StatusOr<std::unique_ptr<GenericStreamWriter>> OpenGenericStreamWriter(
+    SessionId session_id, ActionInstanceId action_instance_id,
+    absl::string_view input_name,
+    intrinsic_proto::icon::IconApi::StubInterface* stub,
+    const ClientContextFactory& client_context_factory);
+
+// Writes values asynchronously: Write() queues the value, a writer thread
+// writes it to the stream, and a reader thread collects the responses. Values
+// are written without waiting for the previous response, up to
+// StreamWriterOptions::max_unacknowledged_values. Thread-safe.
+class GenericAsyncStreamWriter {
+ public:
+  GenericAsyncStreamWriter(std::unique_ptr<GenericStreamWriter> stream_writer,
+                           const StreamWriterOptions& options);
+  ~GenericAsyncStreamWriter();
+
+  absl::Status Write(const google::protobuf::Message& value);
+  absl::Status Flush(absl::Time deadline);
+  absl::Status Close();
+
+ private:
+  void RunWriter();
+  void RunReader();
+  // Keeps `status` if it is the first error.
+  void RecordError(const absl::Status& status)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  const StreamWriterOptions options_;
+  std::unique_ptr<GenericStreamWriter> stream_writer_;
+
+  absl::Mutex mutex_;
+  std::deque<std::unique_ptr<google::protobuf::Message>> queue_
+      ABSL_GUARDED_BY(mutex_);
+  // Number of values passed to Write().
+  int64_t enqueued_ ABSL_GUARDED_BY(mutex_) = 0;
+  // Number of values which were acknowledged or replaced by a newer value.
+  int64_t completed_ ABSL_GUARDED_BY(mutex_) = 0;
+  int unacknowledged_ ABSL_GUARDED_BY(mutex_) = 0;
+  bool closing_ ABSL_GUARDED_BY(mutex_) = false;
+  bool stream_ended_ ABSL_GUARDED_BY(mutex_) = false;
+  // The first error.
+  absl::Status status_ ABSL_GUARDED_BY(mutex_);
+
+  absl::Mutex close_mutex_;
+  std::optional<absl::Status> close_status_ ABSL_GUARDED_BY(close_mutex_);
+
+  Thread writer_thread_;
+  Thread reader_thread_;
 };
 
 template <class T>
@@ -76,21 +172,12 @@ class StreamWriter : public StreamWriterInterface<T> {
       absl::string_view input_name,
       intrinsic_proto::icon::IconApi::StubInterface* stub,
       const ClientContextFactory& client_context_factory = nullptr) {
-    std::unique_ptr<::grpc::ClientContext> context;
-    if (client_context_factory) {
-      context = client_context_factory();
-    } else {
-      context = std::make_unique<::grpc::ClientContext>();
-    }
-    auto grpc_stream = stub->OpenWriteStream(context.get());
-    auto generic_stream_writer = std::make_unique<GenericStreamWriter>(
-        std::move(context), std::move(grpc_stream));
-    auto stream_writer =
-        std::make_unique<::intrinsic::icon::internal::StreamWriter<T>>(
-            std::move(generic_stream_writer));
-    INTR_RETURN_IF_ERROR(stream_writer->stream_writer_->OpenStreamWriter(
-        session_id, action_instance_id, input_name));
-    return stream_writer;
+    INTR_ASSIGN_OR_RETURN(
+        std::unique_ptr<GenericStreamWriter> generic_stream_writer,
+        OpenGenericStreamWriter(session_id, action_instance_id, input_name,
+                                stub, client_context_factory));
+    return std::make_unique<::intrinsic::icon::internal::StreamWriter<T>>(
+        std::move(generic_stream_writer));
   }
 
   absl::Status Write(const T& value) override {
@@ -102,6 +189,58 @@ class StreamWriter : public StreamWriterInterface<T> {
 };
 
 }  // namespace internal
+
+// A StreamWriter whose Write() does not wait for the server. It queues the
+// value and returns right away, and the value is written and acknowledged in
+// the background. This allows streaming at a higher rate than the round trip
+// time of the connection permits.
+//
+// Write() returns ResourceExhausted if the queue is full, unless
+// StreamWriterOptions::latest_value_wins is set. Once a value was rejected or
+// the stream failed, Write() and Flush() return the first such error.
+// Thread-safe.
+template <class T>
+class AsyncStreamWriter : public StreamWriterInterface<T> {
+ public:
+  explicit AsyncStreamWriter(
+      std::unique_ptr<internal::GenericAsyncStreamWriter> stream_writer)
+      : stream_writer_(std::move(stream_writer)) {}
+
+  static absl::StatusOr<std::unique_ptr<AsyncStreamWriter<T>>> Open(
+      SessionId session_id, ActionInstanceId action_instance_id,
+      absl::string_view input_name,
+      intrinsic_proto::icon::IconApi::StubInterface* stub,
+      const StreamWriterOptions& options = {},
+      const ClientContextFactory& client_context_factory = nullptr) {
+    INTR_ASSIGN_OR_RETURN(
+        std::unique_ptr<internal::GenericStreamWriter> generic_stream_writer,
+        internal::OpenGenericStreamWriter(session_id, action_instance_id,
+                                          input_name, stub,
+                                          client_context_factory));
+    return std::make_unique<AsyncStreamWriter<T>>(
+        std::make_unique<internal::GenericAsyncStreamWriter>(
+            std::move(generic_stream_writer), options));
+  }
+
+  // Queues `value` for writing.
+  absl::Status Write(const T& value) override {
+    return stream_writer_->Write(value);
+  }
+
+  // Waits until the values queued before the call are acknowledged, or
+  // replaced by newer ones.
+  absl::Status Flush(absl::Time deadline) {
+    return stream_writer_->Flush(deadline);
+  }
+
+  // Writes the queued values, waits for their acknowledgements and closes the
+  // stream. Called by the destructor. Write() fails afterwards.
+  absl::Status Close() { return stream_writer_->Close(); }
+
+ private:
+  std::unique_ptr<internal::GenericAsyncStreamWriter> stream_writer_;
+};
+
 }  // namespace intrinsic::icon
 
 #endif  // INTRINSIC_ICON_CC_CLIENT_STREAM_H_
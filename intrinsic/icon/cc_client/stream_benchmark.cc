@@ -0,0 +1,181 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+// Streams joint setpoints at 1kHz through the blocking StreamWriter and the
+// AsyncStreamWriter to a fake IconApi server on an in-process channel. The
+// server answers each value after a simulated latency of 0us, 500us and 2ms,
+// so the blocking writer cannot keep up once the round trip exceeds the cycle
+// time. The `overruns` counter reports the cycles in which Write() took longer
+// than one cycle.
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <memory>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/log/check.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "benchmark/benchmark.h"
+#include "grpcpp/server.h"
+#include "grpcpp/server_builder.h"
+#include "grpcpp/server_context.h"
+#include "grpcpp/support/channel_arguments.h"
+#include "grpcpp/support/status.h"
+#include "grpcpp/support/sync_stream.h"
+#include "intrinsic/icon/cc_client/stream.h"
+#include "intrinsic/icon/common/id_types.h"
+#include "intrinsic/icon/proto/joint_space.pb.h"
+#include "intrinsic/icon/proto/service.grpc.pb.h"
+#include "intrinsic/icon/proto/service.pb.h"
+#include "intrinsic/util/thread/thread.h"
+
+namespace intrinsic::icon {
+namespace {
+
+using ::intrinsic_proto::icon::OpenWriteStreamRequest;
+using ::intrinsic_proto::icon::OpenWriteStreamResponse;
+
+constexpr absl::Duration kCycleTime = absl::Milliseconds(1);
+
+// Accepts every write stream and acknowledges each value `latency` after it
+// arrived. Values are acknowledged in order, but the latencies of consecutive
+// values overlap like those of a network link.
+class FakeIconApi : public intrinsic_proto::icon::IconApi::Service {
+ public:
+  explicit FakeIconApi(absl::Duration latency) : latency_(latency) {}
+
+  grpc::Status OpenWriteStream(
+      grpc::ServerContext* context,
+      grpc::ServerReaderWriter<OpenWriteStreamResponse, OpenWriteStreamRequest>*
+          stream) override {
+    OpenWriteStreamRequest request;
+    if (!stream->Read(&request)) {
+      return grpc::Status::OK;
+    }
+    OpenWriteStreamResponse response;
+    response.mutable_add_stream_response()->mutable_status();
+    stream->Write(response);
+
+    absl::Mutex mutex;
+    std::deque<absl::Time> due;
+    bool done = false;
+    Thread responder([&] {
+      OpenWriteStreamResponse response;
+      response.mutable_write_value_response();
+      while (true) {
+        absl::Time next;
+        {
+          absl::MutexLock lock(&mutex);
+          auto has_work = [&]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex) {
+            return !due.empty() || done;
+          };
+          mutex.Await(absl::Condition(&has_work));
+          if (due.empty()) {
+            return;
+          }
+          next = due.front();
+          due.pop_front();
+        }
+        absl::SleepFor(next - absl::Now());
+        stream->Write(response);
+      }
+    });
+    while (stream->Read(&request)) {
+      absl::MutexLock lock(&mutex);
+      due.push_back(absl::Now() + latency_);
+    }
+    {
+      absl::MutexLock lock(&mutex);
+      done = true;
+    }
+    responder.Join();
+    return grpc::Status::OK;
+  }
+
+ private:
+  const absl::Duration latency_;
+};
+
+class FakeIconServer {
+ public:
+  explicit FakeIconServer(absl::Duration latency) : service_(latency) {
+    grpc::ServerBuilder builder;
+    builder.RegisterService(&service_);
+    server_ = builder.BuildAndStart();
+    CHECK(server_ != nullptr);
+    stub_ = intrinsic_proto::icon::IconApi::NewStub(
+        server_->InProcessChannel(grpc::ChannelArguments()));
+  }
+  ~FakeIconServer() { server_->Shutdown(); }
+
+  intrinsic_proto::icon::IconApi::StubInterface* stub() { return stub_.get(); }
+
+ private:
+  FakeIconApi service_;
+  std::unique_ptr<grpc::Server> server_;
+  std::unique_ptr<intrinsic_proto::icon::IconApi::StubInterface> stub_;
+};
+
+intrinsic_proto::icon::JointVec Setpoint(int64_t cycle) {
+  intrinsic_proto::icon::JointVec setpoint;
+  for (int i = 0; i < 6; ++i) {
+    setpoint.add_joints(0.001 * cycle + i);
+  }
+  return setpoint;
+}
+
+// Writes one setpoint per cycle and sleeps for the rest of the cycle.
+void StreamAt1kHz(benchmark::State& state,
+                  StreamWriterInterface<intrinsic_proto::icon::JointVec>&
+                      writer) {
+  int64_t cycle = 0;
+  int64_t overruns = 0;
+  absl::Time next_cycle = absl::Now();
+  for (auto _ : state) {
+    const absl::Time start = absl::Now();
+    CHECK_OK(writer.Write(Setpoint(cycle++)));
+    if (absl::Now() - start > kCycleTime) {
+      ++overruns;
+    }
+    next_cycle = std::max(next_cycle + kCycleTime, absl::Now());
+    absl::SleepFor(next_cycle - absl::Now());
+  }
+  state.counters["overruns"] = overruns;
+  state.SetItemsProcessed(cycle);
+}
+
+void BM_StreamWriter(benchmark::State& state) {
+  FakeIconServer server(absl::Microseconds(state.range(0)));
+  auto writer = internal::StreamWriter<intrinsic_proto::icon::JointVec>::Open(
+      SessionId(1), ActionInstanceId(1), "setpoints", server.stub());
+  CHECK_OK(writer.status());
+  StreamAt1kHz(state, **writer);
+}
+
+void BM_AsyncStreamWriter(benchmark::State& state) {
+  FakeIconServer server(absl::Microseconds(state.range(0)));
+  auto writer = AsyncStreamWriter<intrinsic_proto::icon::JointVec>::Open(
+      SessionId(1), ActionInstanceId(1), "setpoints", server.stub(),
+      {.latest_value_wins = true});
+  CHECK_OK(writer.status());
+  StreamAt1kHz(state, **writer);
+  CHECK_OK((*writer)->Close());
+}
+
+BENCHMARK(BM_StreamWriter)
+    ->Arg(0)
+    ->Arg(500)
+    ->Arg(2000)
+    ->Iterations(2000)
+    ->UseRealTime();
+BENCHMARK(BM_AsyncStreamWriter)
+    ->Arg(0)
+    ->Arg(500)
+    ->Arg(2000)
+    ->Iterations(2000)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace intrinsic::icon
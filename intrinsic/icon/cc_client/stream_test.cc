@@ -0,0 +1,355 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/icon/cc_client/stream.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "google/rpc/status.pb.h"
+#include "grpcpp/server.h"
+#include "grpcpp/server_builder.h"
+#include "grpcpp/server_context.h"
+#include "grpcpp/support/channel_arguments.h"
+#include "grpcpp/support/status.h"
+#include "grpcpp/support/sync_stream.h"
+#include "intrinsic/icon/common/id_types.h"
+#include "intrinsic/icon/proto/joint_space.pb.h"
+#include "intrinsic/icon/proto/service.grpc.pb.h"
+#include "intrinsic/icon/proto/service.pb.h"
+#include "intrinsic/util/testing/gtest_wrapper.h"
+
+namespace intrinsic {
+namespace icon {
+namespace {
+
+using ::intrinsic::testing::StatusIs;
+using ::intrinsic_proto::icon::JointVec;
+using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
+using ::testing::HasSubstr;
+using ::testing::IsEmpty;
+using ::testing::SizeIs;
+
+constexpr SessionId kSessionId(1);
+constexpr ActionInstanceId kActionId(1);
+constexpr char kInputName[] = "setpoints";
+
+JointVec MakeValue(int key) {
+  JointVec value;
+  value.add_joints(key);
+  return value;
+}
+
+// Adds the write streams and answers each written value. The first joint of a
+// value is its key, by which tests select how single values are answered.
+class FakeWriteStreamService : public intrinsic_proto::icon::IconApi::Service {
+ public:
+  grpc::Status OpenWriteStream(
+      grpc::ServerContext* context,
+      grpc::ServerReaderWriter<intrinsic_proto::icon::OpenWriteStreamResponse,
+                               intrinsic_proto::icon::OpenWriteStreamRequest>*
+          stream) override {
+    intrinsic_proto::icon::OpenWriteStreamRequest request;
+    if (!stream->Read(&request) || !request.has_add_write_stream() ||
+        request.session_id() != kSessionId.value()) {
+      return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                          "Expected a write stream for the session.");
+    }
+    intrinsic_proto::icon::OpenWriteStreamResponse response;
+    response.mutable_add_stream_response()->mutable_status()->set_code(
+        static_cast<int>(add_stream_code_));
+    stream->Write(response);
+
+    while (stream->Read(&request)) {
+      JointVec value;
+      if (!request.write_value().value().UnpackTo(&value) ||
+          value.joints_size() != 1) {
+        return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                            "Expected a JointVec with one joint.");
+      }
+      const int key = value.joints(0);
+      response.Clear();
+      {
+        absl::MutexLock lock(&mutex_);
+        received_.push_back(key);
+        if (key == end_call_key_) {
+          return grpc::Status(grpc::StatusCode::UNAVAILABLE,
+                              "The server went away.");
+        }
+        auto unblocked = [this]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+          return !responses_blocked_;
+        };
+        while (!unblocked() && !context->IsCancelled()) {
+          mutex_.AwaitWithTimeout(absl::Condition(&unblocked),
+                                  absl::Milliseconds(10));
+        }
+        if (malformed_response_keys_.contains(key)) {
+          response.mutable_add_stream_response();
+        } else {
+          google::rpc::Status* write_status =
+              response.mutable_write_value_response();
+          if (rejected_keys_.contains(key)) {
+            write_status->set_code(
+                static_cast<int>(grpc::StatusCode::INVALID_ARGUMENT));
+            write_status->set_message("The value is out of range.");
+          }
+        }
+      }
+      stream->Write(response);
+    }
+    return grpc::Status::OK;
+  }
+
+  // Answers the request to add a write stream with `code`. Must be called
+  // before a stream is opened.
+  void SetAddStreamCode(absl::StatusCode code) { add_stream_code_ = code; }
+
+  // Rejects the value with `key`.
+  void RejectValue(int key) {
+    absl::MutexLock lock(&mutex_);
+    rejected_keys_.insert(key);
+  }
+
+  // Answers the value with `key` without a write_value_response.
+  void SendMalformedResponseTo(int key) {
+    absl::MutexLock lock(&mutex_);
+    malformed_response_keys_.insert(key);
+  }
+
+  // Ends the call with an error instead of answering the value with `key`.
+  void EndCallAt(int key) {
+    absl::MutexLock lock(&mutex_);
+    end_call_key_ = key;
+  }
+
+  // Holds back the responses to the received values while `blocked` is true.
+  void BlockResponses(bool blocked) {
+    absl::MutexLock lock(&mutex_);
+    responses_blocked_ = blocked;
+  }
+
+  // Waits until `num_values` values were received.
+  void AwaitReceived(int num_values) const {
+    absl::MutexLock lock(&mutex_);
+    auto received = [this, num_values]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+      return received_.size() >= static_cast<size_t>(num_values);
+    };
+    mutex_.Await(absl::Condition(&received));
+  }
+
+  // Returns the keys of the received values in the order of their arrival.
+  std::vector<int> received() const {
+    absl::MutexLock lock(&mutex_);
+    return received_;
+  }
+
+ private:
+  absl::StatusCode add_stream_code_ = absl::StatusCode::kOk;
+
+  mutable absl::Mutex mutex_;
+  absl::flat_hash_set<int> rejected_keys_ ABSL_GUARDED_BY(mutex_);
+  absl::flat_hash_set<int> malformed_response_keys_ ABSL_GUARDED_BY(mutex_);
+  int end_call_key_ ABSL_GUARDED_BY(mutex_) = -1;
+  bool responses_blocked_ ABSL_GUARDED_BY(mutex_) = false;
+  std::vector<int> received_ ABSL_GUARDED_BY(mutex_);
+};
+
+class AsyncStreamWriterTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    grpc::ServerBuilder builder;
+    builder.RegisterService(&service_);
+    server_ = builder.BuildAndStart();
+    stub_ = intrinsic_proto::icon::IconApi::NewStub(
+        server_->InProcessChannel(grpc::ChannelArguments()));
+  }
+
+  void TearDown() override { server_->Shutdown(); }
+
+  // Opens a writer whose errors are collected in `errors_`.
+  absl::StatusOr<std::unique_ptr<AsyncStreamWriter<JointVec>>> Open(
+      StreamWriterOptions options = {}) {
+    options.error_callback = [this](absl::Status status) {
+      absl::MutexLock lock(&errors_mutex_);
+      errors_.push_back(std::move(status));
+    };
+    return AsyncStreamWriter<JointVec>::Open(kSessionId, kActionId, kInputName,
+                                             stub_.get(), options);
+  }
+
+  std::vector<absl::Status> errors() {
+    absl::MutexLock lock(&errors_mutex_);
+    return errors_;
+  }
+
+  FakeWriteStreamService service_;
+  std::unique_ptr<grpc::Server> server_;
+  std::unique_ptr<intrinsic_proto::icon::IconApi::StubInterface> stub_;
+
+  absl::Mutex errors_mutex_;
+  std::vector<absl::Status> errors_ ABSL_GUARDED_BY(errors_mutex_);
+};
+
+TEST_F(AsyncStreamWriterTest, WritesValuesInOrder) {
+  constexpr int kNumValues = 50;
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<AsyncStreamWriter<JointVec>> writer,
+                       Open({.max_queued_values = kNumValues,
+                             .max_unacknowledged_values = 4}));
+
+  std::vector<int> keys;
+  for (int key = 0; key < kNumValues; ++key) {
+    ASSERT_OK(writer->Write(MakeValue(key)));
+    keys.push_back(key);
+  }
+  ASSERT_OK(writer->Close());
+
+  EXPECT_THAT(service_.received(), ElementsAreArray(keys));
+  EXPECT_THAT(errors(), IsEmpty());
+}
+
+TEST_F(AsyncStreamWriterTest, FlushWaitsForTheAcknowledgements) {
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<AsyncStreamWriter<JointVec>> writer,
+                       Open());
+  service_.BlockResponses(true);
+  ASSERT_OK(writer->Write(MakeValue(0)));
+  ASSERT_OK(writer->Write(MakeValue(1)));
+  service_.AwaitReceived(1);
+
+  EXPECT_THAT(writer->Flush(absl::Now() + absl::Milliseconds(20)),
+              StatusIs(absl::StatusCode::kDeadlineExceeded));
+
+  service_.BlockResponses(false);
+  ASSERT_OK(writer->Flush(absl::InfiniteFuture()));
+  EXPECT_THAT(service_.received(), ElementsAre(0, 1));
+  ASSERT_OK(writer->Close());
+}
+
+TEST_F(AsyncStreamWriterTest, RejectsWritesIfTheQueueIsFull) {
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<AsyncStreamWriter<JointVec>> writer,
+                       Open({.max_queued_values = 2,
+                             .max_unacknowledged_values = 1}));
+  service_.BlockResponses(true);
+  // The first value is written, the next ones wait for its acknowledgement.
+  ASSERT_OK(writer->Write(MakeValue(0)));
+  service_.AwaitReceived(1);
+  ASSERT_OK(writer->Write(MakeValue(1)));
+  ASSERT_OK(writer->Write(MakeValue(2)));
+
+  EXPECT_THAT(writer->Write(MakeValue(3)),
+              StatusIs(absl::StatusCode::kResourceExhausted));
+
+  service_.BlockResponses(false);
+  ASSERT_OK(writer->Close());
+  EXPECT_THAT(service_.received(), ElementsAre(0, 1, 2));
+}
+
+TEST_F(AsyncStreamWriterTest, LatestValueWinsReplacesQueuedValues) {
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<AsyncStreamWriter<JointVec>> writer,
+                       Open({.max_queued_values = 1,
+                             .latest_value_wins = true,
+                             .max_unacknowledged_values = 1}));
+  service_.BlockResponses(true);
+  ASSERT_OK(writer->Write(MakeValue(0)));
+  service_.AwaitReceived(1);
+  for (int key = 1; key <= 3; ++key) {
+    ASSERT_OK(writer->Write(MakeValue(key)));
+  }
+
+  service_.BlockResponses(false);
+  ASSERT_OK(writer->Flush(absl::InfiniteFuture()));
+  EXPECT_THAT(service_.received(), ElementsAre(0, 3));
+  ASSERT_OK(writer->Close());
+}
+
+TEST_F(AsyncStreamWriterTest, CloseWritesQueuedValuesAndEndsWrites) {
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<AsyncStreamWriter<JointVec>> writer,
+                       Open({.max_unacknowledged_values = 1}));
+  service_.BlockResponses(true);
+  ASSERT_OK(writer->Write(MakeValue(0)));
+  service_.AwaitReceived(1);
+  ASSERT_OK(writer->Write(MakeValue(1)));
+  ASSERT_OK(writer->Write(MakeValue(2)));
+  service_.BlockResponses(false);
+
+  ASSERT_OK(writer->Close());
+
+  EXPECT_THAT(service_.received(), ElementsAre(0, 1, 2));
+  EXPECT_THAT(writer->Write(MakeValue(3)),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+  EXPECT_OK(writer->Flush(absl::InfiniteFuture()));
+  EXPECT_OK(writer->Close());
+}
+
+TEST_F(AsyncStreamWriterTest, ReportsRejectedValues) {
+  service_.RejectValue(1);
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<AsyncStreamWriter<JointVec>> writer,
+                       Open());
+  for (int key = 0; key < 3; ++key) {
+    ASSERT_OK(writer->Write(MakeValue(key)));
+  }
+
+  EXPECT_THAT(writer->Flush(absl::InfiniteFuture()),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("out of range")));
+  // The first error sticks.
+  EXPECT_THAT(writer->Write(MakeValue(3)),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(writer->Close(), StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(service_.received(), ElementsAre(0, 1, 2));
+  EXPECT_THAT(errors(), ElementsAre(StatusIs(absl::StatusCode::kInvalidArgument,
+                                             HasSubstr("out of range"))));
+}
+
+TEST_F(AsyncStreamWriterTest, ReportsABrokenStream) {
+  service_.EndCallAt(1);
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<AsyncStreamWriter<JointVec>> writer,
+                       Open());
+  ASSERT_OK(writer->Write(MakeValue(0)));
+  ASSERT_OK(writer->Write(MakeValue(1)));
+
+  EXPECT_THAT(writer->Flush(absl::InfiniteFuture()),
+              StatusIs(absl::StatusCode::kAborted));
+  EXPECT_THAT(writer->Write(MakeValue(2)),
+              StatusIs(absl::StatusCode::kAborted));
+  EXPECT_THAT(writer->Close(), StatusIs(absl::StatusCode::kAborted));
+  EXPECT_THAT(errors(), ElementsAre(StatusIs(absl::StatusCode::kAborted)));
+}
+
+TEST_F(AsyncStreamWriterTest, ReportsMalformedResponses) {
+  service_.SendMalformedResponseTo(1);
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<AsyncStreamWriter<JointVec>> writer,
+                       Open());
+  for (int key = 0; key < 4; ++key) {
+    ASSERT_OK(writer->Write(MakeValue(key)));
+  }
+
+  EXPECT_THAT(writer->Flush(absl::InfiniteFuture()),
+              StatusIs(absl::StatusCode::kInternal));
+  // The responses after the malformed one are left unread, which must not
+  // block closing the call.
+  EXPECT_THAT(writer->Close(), StatusIs(absl::StatusCode::kInternal));
+  EXPECT_THAT(errors(), ElementsAre(StatusIs(absl::StatusCode::kInternal)));
+}
+
+TEST_F(AsyncStreamWriterTest, OpenFailsIfTheStreamIsRejected) {
+  service_.SetAddStreamCode(absl::StatusCode::kNotFound);
+
+  EXPECT_THAT(Open(), StatusIs(absl::StatusCode::kNotFound));
+  EXPECT_THAT(service_.received(), SizeIs(0));
+}
+
+}  // namespace
+}  // namespace icon
+}  // namespace intrinsic
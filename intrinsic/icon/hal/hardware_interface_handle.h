@@ -5,9 +5,11 @@
 
 #include <sys/types.h>
 
+#include <cstddef>
 #include <cstdint>
 #include <utility>
 
+#include "absl/types/span.h"
 #include "flatbuffers/flatbuffers.h"                 // IWYU pragma: keep
 #include "intrinsic/icon/hal/icon_state_register.h"  // IWYU pragma: keep
 #include "intrinsic/icon/hal/interfaces/icon_state.fbs.h"
@@ -54,6 +56,33 @@ class HardwareInterfaceHandle {
     return segment_.Header().LastUpdatedCycle();
   }
 
+  // Returns the size of the serialized interface in bytes, i.e. the minimum
+  // size of the buffer passed to `ReadConsistent`.
+  size_t PayloadSize() const { return segment_.Header().PayloadSize(); }
+
+  // Copies the interface into `buffer` and returns a pointer to the copy. The
+  // copy is never torn by a writer that brackets its modifications with
+  // `MutableHardwareInterfaceHandle::BeginWrite()`/`EndWrite()`, and the
+  // writer is never blocked by this call.
+  // Returns InvalidArgumentError if `buffer` is smaller than `PayloadSize()`,
+  // and UnavailableError if the writer kept modifying the interface during
+  // `max_attempts` attempts.
+  RealtimeStatusOr<const T*> ReadConsistent(
+      absl::Span<uint8_t> buffer,
+      int max_attempts = MemorySegment::kDefaultReadAttempts) const {
+    if (buffer.size() < PayloadSize()) {
+      return InvalidArgumentError(RealtimeStatus::StrCat(
+          "Buffer of size ", buffer.size(), " is too small for interface of ",
+          "size ", PayloadSize()));
+    }
+    if (!segment_.ReadConsistentRawValue(buffer.first(PayloadSize()),
+                                         max_attempts)) {
+      return UnavailableError(
+          "Interface was modified concurrently during all read attempts.");
+    }
+    return flatbuffers::GetRoot<T>(buffer.data());
+  }
+
  private:
   ReadOnlyMemorySegment<T> segment_;
   const T* hardware_interface_ = nullptr;
@@ -105,6 +134,12 @@ class MutableHardwareInterfaceHandle {
     segment_.UpdatedAt(time, Cycle::GetCurrentCycle());
   }
 
+  // Brackets modifications of the interface so that readers using
+  // `HardwareInterfaceHandle::ReadConsistent()` never observe a partially
+  // written interface. Realtime safe and never blocks on readers.
+  void BeginWrite() { segment_.BeginWrite(); }
+  void EndWrite() { segment_.EndWrite(); }
+
  private:
   ReadWriteMemorySegment<T> segment_;
   T* hardware_interface_ = nullptr;
@@ -224,6 +259,10 @@ class MutableStrictHardwareInterfaceHandle {
   // and increments an update counter.
   void UpdatedAt(Time time) { hardware_interface_.UpdatedAt(time); }
 
+  // See MutableHardwareInterfaceHandle::BeginWrite()/EndWrite().
+  void BeginWrite() { hardware_interface_.BeginWrite(); }
+  void EndWrite() { hardware_interface_.EndWrite(); }
+
  private:
   MutableHardwareInterfaceHandle<T> hardware_interface_;
   HardwareInterfaceHandle<intrinsic_fbs::IconState> icon_state_;
@@ -4,6 +4,7 @@
 
 #include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <list>
 #include <memory>
@@ -42,8 +43,7 @@
 #include "intrinsic/icon/utils/log.h"
 #include "intrinsic/icon/utils/realtime_status.h"
 #include "intrinsic/platform/common/buffers/rt_promise.h"
-#include "intrinsic/platform/common/buffers/rt_queue.h"
-#include "intrinsic/platform/common/buffers/rt_queue_multi_writer.h"
+#include "intrinsic/platform/common/buffers/rt_mpsc_queue.h"
 #include "intrinsic/util/status/status_macros.h"
 #include "intrinsic/util/thread/thread.h"
 #include "intrinsic/util/thread/thread_options.h"
@@ -291,6 +291,17 @@ class HardwareModuleRuntime::CallbackHandler final {
     }
   }
 
+  // Server callback for the cycle trigger. Runs `ReadStatus` and then
+  // `ApplyCommand`, depending on the `HardwareModuleCycleOpcode`s in `opcodes`.
+  void OnCycle(uint32_t opcodes) INTRINSIC_CHECK_REALTIME_SAFE {
+    if (opcodes & kCycleReadStatus) {
+      OnReadStatus();
+    }
+    if (opcodes & kCycleApplyCommand) {
+      OnApplyCommand();
+    }
+  }
+
   // Sets the internal state *and* the state in shared memory directly. Only
   // call this, when you *know* that no other thread/process might be reading
   // the state in shared memory at the same time.
@@ -439,9 +450,12 @@ class HardwareModuleRuntime::CallbackHandler final {
           return absl::FailedPreconditionError(
               "Request cancelled due to deactivation");
         }
-        INTR_RETURN_IF_ERROR(request_queue_writer_.Insert(
-            AsyncRequest(AsyncRequestData{from, to, fault_reason, Clock::Now()},
-                         std::move(promise))));
+        if (!request_queue_.writer()->Insert(AsyncRequest(
+                AsyncRequestData{from, to, fault_reason, Clock::Now()},
+                std::move(promise)))) {
+          return absl::ResourceExhaustedError(
+              "RealtimeMpscQueue capacity exhausted");
+        }
       }
 
       // Timeout until the state should have been processed. The state is
@@ -577,14 +591,13 @@ class HardwareModuleRuntime::CallbackHandler final {
   AsyncBuffer<intrinsic_fbs::HardwareModuleState> hwm_state_buffer_
       ABSL_GUARDED_BY(non_rt_buffer_lock_);
 
-  // The thread safe queue of pending requests that. The rt thread will read
-  // from the queue in `OnReadStatus()`.
-  intrinsic::RealtimeQueue<AsyncRequest> request_queue_;
-  // The thread safe writer for the `request_queue_` that can be written from
-  // all non rt-callbacks (onEnable, etc.).
+  // The thread safe queue of pending requests. It can be written from all non
+  // rt-callbacks (onEnable, etc.) and the rt thread will read from the queue in
+  // `OnReadStatus()`.
+  intrinsic::RealtimeMpscQueue<AsyncRequest> request_queue_;
+  // Serializes new requests with `reject_new_requests_` and guards the
+  // non-rt-only state below.
   absl::Mutex non_rt_buffer_lock_;
-  intrinsic::RealtimeQueueMultiWriter<AsyncRequest> request_queue_writer_
-      ABSL_GUARDED_BY(non_rt_buffer_lock_){*request_queue_.writer()};
   // While this is true, HardwareModuleRuntime rejects any new non-rt requests
   // (e.g. EnableMotion()).
   std::atomic_bool reject_new_requests_ = false;
@@ -626,6 +639,7 @@ HardwareModuleRuntime::HardwareModuleRuntime(
       disable_motion_server_(nullptr),
       read_status_server_(nullptr),
       apply_command_server_(nullptr),
+      cycle_server_(nullptr),
       stop_requested_(std::make_unique<std::atomic<bool>>(false)) {}
 
 HardwareModuleRuntime::~HardwareModuleRuntime() {
@@ -660,6 +674,7 @@ HardwareModuleRuntime::HardwareModuleRuntime(HardwareModuleRuntime&& other)
       read_status_server_(std::exchange(other.read_status_server_, nullptr)),
       apply_command_server_(
           std::exchange(other.apply_command_server_, nullptr)),
+      cycle_server_(std::exchange(other.cycle_server_, nullptr)),
       hardware_module_state_interface_(
           std::move(other.hardware_module_state_interface_)),
       stop_requested_(std::exchange(other.stop_requested_, nullptr)),
@@ -682,6 +697,7 @@ HardwareModuleRuntime& HardwareModuleRuntime::operator=(
   clear_faults_server_ = std::exchange(other.clear_faults_server_, nullptr);
   read_status_server_ = std::exchange(other.read_status_server_, nullptr);
   apply_command_server_ = std::exchange(other.apply_command_server_, nullptr);
+  cycle_server_ = std::exchange(other.cycle_server_, nullptr);
   hardware_module_state_interface_ =
       std::move(other.hardware_module_state_interface_);
   stop_requested_ = std::exchange(other.stop_requested_, nullptr);
@@ -791,6 +807,17 @@ absl::Status HardwareModuleRuntime::Connect() {
   apply_command_server_ =
       std::make_unique<RemoteTriggerServer>(std::move(apply_command_server));
 
+  INTR_ASSIGN_OR_RETURN(
+      auto cycle_server,
+      RemoteTriggerServer::CreateWithOpcodes(
+          MemoryName(memory_namespace, hardware_module_.config.GetName(),
+                     kCycleTriggerName),
+          [callback_handler = callback_handler_.get()](uint32_t opcodes) {
+            callback_handler->OnCycle(opcodes);
+          }));
+  cycle_server_ =
+      std::make_unique<RemoteTriggerServer>(std::move(cycle_server));
+
   return absl::OkStatus();
 }
 
@@ -838,6 +865,9 @@ absl::Status HardwareModuleRuntime::Run(grpc::ServerBuilder& server_builder,
   intrinsic::ThreadOptions apply_command_thread_options;
   apply_command_thread_options.SetName("ApplyCommand");
 
+  intrinsic::ThreadOptions cycle_thread_options;
+  cycle_thread_options.SetName("Cycle");
+
   if (is_realtime) {
     state_change_thread_options.SetRealtimeLowPriorityAndScheduler();
     state_change_thread_options.SetAffinity(cpu_affinity);
@@ -847,6 +877,8 @@ absl::Status HardwareModuleRuntime::Run(grpc::ServerBuilder& server_builder,
     read_status_thread_options.SetAffinity(cpu_affinity);
     apply_command_thread_options.SetRealtimeHighPriorityAndScheduler();
     apply_command_thread_options.SetAffinity(cpu_affinity);
+    cycle_thread_options.SetRealtimeHighPriorityAndScheduler();
+    cycle_thread_options.SetAffinity(cpu_affinity);
   }
 
   intrinsic::ThreadOptions deactivate_thread_options = activate_thread_options;
@@ -877,12 +909,15 @@ absl::Status HardwareModuleRuntime::Run(grpc::ServerBuilder& server_builder,
       read_status_server_->StartAsync(read_status_thread_options)));
   INTR_RETURN_IF_ERROR(set_init_failed_on_error(
       apply_command_server_->StartAsync(apply_command_thread_options)));
+  INTR_RETURN_IF_ERROR(set_init_failed_on_error(
+      cycle_server_->StartAsync(cycle_thread_options)));
 
   return absl::OkStatus();
 }
 
 absl::Status HardwareModuleRuntime::Stop() {
   callback_handler_->Shutdown();
+  cycle_server_->Stop();
   apply_command_server_->Stop();
   read_status_server_->Stop();
   stop_requested_->store(true);
@@ -897,6 +932,7 @@ bool HardwareModuleRuntime::IsStarted() const {
   bool started = state_change_thread_.Joinable();
   started &= read_status_server_->IsStarted();
   started &= apply_command_server_->IsStarted();
+  started &= cycle_server_->IsStarted();
 
   return started;
 }
@@ -104,6 +104,8 @@ class HardwareModuleRuntime final {
   std::unique_ptr<RemoteTriggerServer> clear_faults_server_;
   std::unique_ptr<RemoteTriggerServer> read_status_server_;
   std::unique_ptr<RemoteTriggerServer> apply_command_server_;
+  // Runs `ReadStatus` and `ApplyCommand` with a single trigger per cycle.
+  std::unique_ptr<RemoteTriggerServer> cycle_server_;
   MutableHardwareInterfaceHandle<intrinsic_fbs::HardwareModuleState>
       hardware_module_state_interface_;
   HardwareInterfaceHandle<intrinsic_fbs::IconState> icon_state_interface_;
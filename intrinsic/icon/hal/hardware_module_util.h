@@ -3,6 +3,7 @@
 #ifndef INTRINSIC_ICON_HAL_HARDWARE_MODULE_UTIL_H_
 #define INTRINSIC_ICON_HAL_HARDWARE_MODULE_UTIL_H_
 
+#include <cstdint>
 #include <string>
 
 #include "absl/strings/str_format.h"
@@ -19,6 +20,18 @@ void AbslStringify(Sink& sink, StateCode e) {
 
 namespace intrinsic::icon {
 
+// Name of the remote trigger that executes a whole cycle of a hardware module,
+// see `HardwareModuleCycleOpcode`.
+inline constexpr char kCycleTriggerName[] = "cycle";
+
+// Opcodes of the cycle trigger. Each cycle, ICON sets the operations to execute
+// in a bitmask. The hardware module executes them in the order below with a
+// single wake-up and response, instead of one round-trip per operation.
+enum HardwareModuleCycleOpcode : uint32_t {
+  kCycleReadStatus = 1 << 0,
+  kCycleApplyCommand = 1 << 1,
+};
+
 enum class TransitionGuardResult { kNoOp, kAllowed, kProhibited };
 
 // Returns whether the transition from `from` to `to` is allowed, prohibited or
@@ -3,8 +3,10 @@
 #include "intrinsic/icon/interprocess/binary_futex.h"
 
 #include <linux/futex.h>
+#include <sched.h>
 #include <sys/syscall.h>
 
+#include <algorithm>
 #include <atomic>
 #include <cerrno>
 #include <cstdint>
@@ -13,8 +15,10 @@
 
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
+#include "intrinsic/icon/interprocess/futex_wait_policy.h"
 #include "intrinsic/icon/testing/realtime_annotations.h"
 #include "intrinsic/icon/utils/realtime_status.h"
+#include "intrinsic/icon/utils/realtime_status_macro.h"
 
 namespace intrinsic::icon {
 namespace {
@@ -73,8 +77,65 @@ RealtimeStatus Wait(std::atomic<uint32_t> &val, const timespec *ts,
   }
 }
 
+// Number of spin iterations between two clock reads. Reading the clock is much
+// more expensive than a CPU relax hint.
+constexpr int kSpinsPerClockRead = 64;
+
+int64_t MonotonicNowNs() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return int64_t{ts.tv_sec} * 1'000'000'000 + ts.tv_nsec;
+}
+
+// Tells the CPU that we're in a spin loop, which saves power and frees
+// resources for the sibling hyperthread.
+inline void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield" ::: "memory");
+#endif
+}
+
+// Busy-waits until the value is one or `spin_until` has passed. Returns true
+// and sets the value to zero in the former case.
+bool SpinWait(std::atomic<uint32_t> &val, absl::Time spin_until) {
+  while (true) {
+    for (int i = 0; i < kSpinsPerClockRead; ++i) {
+      // Only attempt the (exclusive) compare-exchange once the value changed,
+      // so that spinning doesn't steal the cache line from the poster.
+      if (val.load(std::memory_order_relaxed) == 1 && TryWait(val)) {
+        return true;
+      }
+      CpuRelax();
+    }
+    if (absl::Now() >= spin_until) {
+      return false;
+    }
+  }
+}
+
+// Yields the CPU until the value is one or `deadline` has passed. Returns true
+// and sets the value to zero in the former case.
+bool YieldWait(std::atomic<uint32_t> &val,
+               absl::Time deadline) INTRINSIC_SUPPRESS_REALTIME_CHECK {
+  while (true) {
+    if (TryWait(val)) {
+      return true;
+    }
+    if (absl::Now() >= deadline) {
+      return false;
+    }
+    sched_yield();
+  }
+}
+
 }  // namespace
 
+// The layout is part of the shared memory segment layout, see
+// `SegmentHeader::ExpectedVersion()`.
+static_assert(sizeof(BinaryFutex) == 16);
+
 BinaryFutex::BinaryFutex(bool posted, bool private_futex)
     : val_(posted == true ? 1 : 0), private_futex_(private_futex) {}
 BinaryFutex::BinaryFutex(BinaryFutex &&other) : val_(other.val_.load()) {}
@@ -95,6 +156,11 @@ RealtimeStatus BinaryFutex::Post() {
   // Take the address before, since the class instance could be destroyed before
   // `futex()` is called.
   std::atomic<uint32_t> *val_addr = &val_;
+  // Published by the compare-exchange below. Skips the clock read unless post
+  // timestamps are enabled.
+  if (record_post_time_.load(std::memory_order_relaxed)) {
+    post_time_ns_.store(MonotonicNowNs(), std::memory_order_relaxed);
+  }
   if (val_.compare_exchange_strong(zero, 1)) {
     // `futex` could fail with EFAULT, if `val_addr` is not a valid
     // user-space address anymore. This can happen if another thread destroyed
@@ -111,6 +177,10 @@ RealtimeStatus BinaryFutex::Post() {
   return OkStatus();
 }
 
+void BinaryFutex::EnablePostTimestamps() const {
+  record_post_time_.store(true, std::memory_order_relaxed);
+}
+
 RealtimeStatus BinaryFutex::WaitUntil(absl::Time deadline) const {
   if (deadline < absl::Now()) {
     return DeadlineExceededError("Specified deadline is in the past");
@@ -126,6 +196,68 @@ RealtimeStatus BinaryFutex::WaitFor(absl::Duration timeout) const {
   return WaitUntil(absl::Now() + timeout);
 }
 
+RealtimeStatus BinaryFutex::WaitUntil(
+    absl::Time deadline, const FutexWaitPolicy &policy,
+    WakeupLatencyHistogram *histogram) const {
+  const absl::Time now = absl::Now();
+  if (deadline < now) {
+    return DeadlineExceededError("Specified deadline is in the past");
+  }
+  using WakeupPhase = WakeupLatencyHistogram::WakeupPhase;
+  WakeupPhase phase = WakeupPhase::kSpin;
+  switch (policy.mode) {
+    case FutexWaitPolicy::Mode::kFutex:
+      if (!icon::TryWait(val_)) {
+        phase = WakeupPhase::kFutex;
+        INTRINSIC_RT_RETURN_IF_ERROR(WaitUntil(deadline));
+      }
+      break;
+    case FutexWaitPolicy::Mode::kSpin:
+      if (!SpinWait(val_, deadline)) {
+        return DeadlineExceededError(RealtimeStatus::StrCat(
+            "Timeout after spinning for ",
+            absl::ToDoubleMilliseconds(absl::Now() - now), " ms"));
+      }
+      break;
+    case FutexWaitPolicy::Mode::kSpinThenYield:
+      if (!SpinWait(val_, std::min(deadline, now + policy.spin_budget))) {
+        phase = WakeupPhase::kYield;
+        if (!YieldWait(val_, deadline)) {
+          return DeadlineExceededError(RealtimeStatus::StrCat(
+              "Timeout after ", absl::ToDoubleMilliseconds(absl::Now() - now),
+              " ms"));
+        }
+      }
+      break;
+    case FutexWaitPolicy::Mode::kSpinThenFutex:
+      if (!SpinWait(val_, std::min(deadline, now + policy.spin_budget))) {
+        if (absl::Now() >= deadline) {
+          return DeadlineExceededError(RealtimeStatus::StrCat(
+              "Timeout after spinning for ",
+              absl::ToDoubleMilliseconds(absl::Now() - now), " ms"));
+        }
+        phase = WakeupPhase::kFutex;
+        INTRINSIC_RT_RETURN_IF_ERROR(WaitUntil(deadline));
+      }
+      break;
+  }
+  if (histogram != nullptr) {
+    // 0 if the post happened before post timestamps were enabled.
+    const int64_t post_time_ns =
+        post_time_ns_.load(std::memory_order_relaxed);
+    if (post_time_ns != 0) {
+      histogram->Record(MonotonicNowNs() - post_time_ns, phase);
+    }
+  }
+  return OkStatus();
+}
+
+RealtimeStatus BinaryFutex::WaitFor(absl::Duration timeout,
+                                    const FutexWaitPolicy &policy,
+                                    WakeupLatencyHistogram *histogram) const {
+  return WaitUntil(absl::Now() + timeout, policy, histogram);
+}
+
 bool BinaryFutex::TryWait() const { return icon::TryWait(val_); }
 
 uint32_t BinaryFutex::Value() const { return val_; }
@@ -7,6 +7,7 @@
 #include <cstdint>
 
 #include "absl/time/time.h"
+#include "intrinsic/icon/interprocess/futex_wait_policy.h"
 #include "intrinsic/icon/utils/realtime_status.h"
 
 namespace intrinsic::icon {
@@ -84,6 +85,12 @@ class BinaryFutex {
   // Thread-safe.
   RealtimeStatus Post();
 
+  // Makes `Post()` store its time, which `WaitUntil()` needs to record wake-up
+  // latencies. Costs a clock read per `Post()`, so it is off by default. Posts
+  // before this call are not recorded.
+  // Thread-safe.
+  void EnablePostTimestamps() const;
+
   // Waits until the futex becomes one or the deadline exceeds.
   // When futex becomes one, immediately sets it to zero and returns ok.
   // Returns an internal error if the futex could not be accessed.
@@ -91,6 +98,15 @@ class BinaryFutex {
   // Thread-safe.
   RealtimeStatus WaitUntil(absl::Time deadline) const;
 
+  // Like `WaitUntil()` above, but waits according to `policy`, e.g. spins for
+  // a while before sleeping in the futex syscall. If `histogram` is not null,
+  // records the time between the `Post()` and the return from this call. This
+  // requires `EnablePostTimestamps()`, otherwise nothing is recorded.
+  // Real-time safe when `deadline` is close enough.
+  // Thread-safe.
+  RealtimeStatus WaitUntil(absl::Time deadline, const FutexWaitPolicy &policy,
+                           WakeupLatencyHistogram *histogram = nullptr) const;
+
   // Waits until the futex becomes one or the timeout exceeds.
   // When futex becomes one, immediately sets it to zero and returns ok.
   // Returns an internal error if the futex could not be accessed.
@@ -98,6 +114,11 @@ class BinaryFutex {
   // Thread-safe.
   RealtimeStatus WaitFor(absl::Duration timeout) const;
 
+  // Like `WaitFor()` above, but waits according to `policy`, see
+  // `WaitUntil()`.
+  RealtimeStatus WaitFor(absl::Duration timeout, const FutexWaitPolicy &policy,
+                         WakeupLatencyHistogram *histogram = nullptr) const;
+
   // Returns true if the current value is one and, in this case, sets the value
   // to zero.
   bool TryWait() const;
@@ -115,8 +136,18 @@ class BinaryFutex {
   static_assert(
       std::atomic<uint32_t>::is_always_lock_free,
       "Atomic operations need to be lock free for multi-process communication");
+  static_assert(std::atomic<bool>::is_always_lock_free);
+  static_assert(std::atomic<int64_t>::is_always_lock_free);
+  // Changes of the members below change the layout of shared memory segments
+  // and thus require a new `SegmentHeader::ExpectedVersion()`.
   mutable std::atomic<uint32_t> val_ = {0};
   const bool private_futex_ = false;
+  // Set by `EnablePostTimestamps()`. Only then `Post()` sets `post_time_ns_`.
+  mutable std::atomic<bool> record_post_time_ = {false};
+  // CLOCK_MONOTONIC time of the latest `Post()` in nanoseconds, which is the
+  // same in all processes on a machine, or 0 if unknown. Written before
+  // `val_`, so that a waiter which observes the post also observes its time.
+  std::atomic<int64_t> post_time_ns_ = {0};
 };
 
 }  // namespace intrinsic::icon
@@ -0,0 +1,72 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/icon/interprocess/futex_wait_policy.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "absl/time/time.h"
+#include "intrinsic/icon/interprocess/log2_histogram.h"
+
+namespace intrinsic::icon {
+
+void WakeupLatencyHistogram::Record(int64_t latency_ns, WakeupPhase phase) {
+  latency_ns = std::max<int64_t>(latency_ns, 0);
+  buckets_[Log2HistogramBucket(latency_ns)].fetch_add(
+      1, std::memory_order_relaxed);
+  phases_[static_cast<size_t>(phase)].fetch_add(1, std::memory_order_relaxed);
+  int64_t max_ns = max_ns_.load(std::memory_order_relaxed);
+  while (latency_ns > max_ns &&
+         !max_ns_.compare_exchange_weak(max_ns, latency_ns,
+                                        std::memory_order_relaxed)) {
+  }
+}
+
+uint64_t WakeupLatencyHistogram::Count() const {
+  uint64_t count = 0;
+  for (const std::atomic<uint64_t>& bucket : buckets_) {
+    count += bucket.load(std::memory_order_relaxed);
+  }
+  return count;
+}
+
+uint64_t WakeupLatencyHistogram::BucketCount(size_t bucket) const {
+  return bucket < kNumBuckets ? buckets_[bucket].load(std::memory_order_relaxed)
+                              : 0;
+}
+
+uint64_t WakeupLatencyHistogram::PhaseCount(WakeupPhase phase) const {
+  return phases_[static_cast<size_t>(phase)].load(std::memory_order_relaxed);
+}
+
+absl::Duration WakeupLatencyHistogram::Max() const {
+  return absl::Nanoseconds(max_ns_.load(std::memory_order_relaxed));
+}
+
+absl::Duration WakeupLatencyHistogram::Percentile(double quantile) const {
+  std::array<uint64_t, kNumBuckets> buckets;
+  for (size_t i = 0; i < kNumBuckets; ++i) {
+    buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+  }
+  return Log2HistogramPercentile(
+      buckets, max_ns_.load(std::memory_order_relaxed), quantile);
+}
+
+void WakeupLatencyHistogram::Reset() {
+  for (std::atomic<uint64_t>& bucket : buckets_) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+  for (std::atomic<uint64_t>& phase : phases_) {
+    phase.store(0, std::memory_order_relaxed);
+  }
+  max_ns_.store(0, std::memory_order_relaxed);
+}
+
+int64_t WakeupLatencyHistogram::BucketUpperBoundNs(size_t bucket) {
+  return Log2HistogramBucketUpperBoundNs(bucket);
+}
+
+}  // namespace intrinsic::icon
@@ -0,0 +1,113 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#ifndef INTRINSIC_ICON_INTERPROCESS_FUTEX_WAIT_POLICY_H_
+#define INTRINSIC_ICON_INTERPROCESS_FUTEX_WAIT_POLICY_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "absl/time/time.h"
+#include "intrinsic/icon/interprocess/log2_histogram.h"
+
+namespace intrinsic::icon {
+
+// Describes how a thread waits for a `BinaryFutex` to be posted.
+//
+// Sleeping in the futex syscall frees the CPU, but the waiter then has to be
+// woken up and scheduled by the kernel, which takes several microseconds.
+// Spinning keeps the CPU busy, but notices a post within nanoseconds. On
+// isolated realtime cores with short cycles, spinning for (part of) the wait
+// can therefore reduce jitter considerably.
+struct FutexWaitPolicy {
+  enum class Mode {
+    // Always sleeps in the futex syscall. This is the default.
+    kFutex,
+    // Busy-waits with a CPU relax hint until the futex is posted or the
+    // deadline expires. Never gives up the CPU.
+    kSpin,
+    // Busy-waits for `spin_budget`, then calls sched_yield() in a loop. Lets
+    // other threads of the same priority run, but never sleeps.
+    kSpinThenYield,
+    // Busy-waits for `spin_budget`, then sleeps in the futex syscall.
+    kSpinThenFutex,
+  };
+
+  static constexpr FutexWaitPolicy Futex() { return {}; }
+  static constexpr FutexWaitPolicy Spin() { return {.mode = Mode::kSpin}; }
+  static constexpr FutexWaitPolicy SpinThenYield(absl::Duration spin_budget) {
+    return {.mode = Mode::kSpinThenYield, .spin_budget = spin_budget};
+  }
+  static constexpr FutexWaitPolicy SpinThenFutex(absl::Duration spin_budget) {
+    return {.mode = Mode::kSpinThenFutex, .spin_budget = spin_budget};
+  }
+
+  Mode mode = Mode::kFutex;
+  // How long to busy-wait before yielding or sleeping. Ignored for `kFutex`
+  // and `kSpin`.
+  absl::Duration spin_budget = absl::ZeroDuration();
+};
+
+// Histogram of the wake-up latency of a waiter, i.e. the time between a
+// `BinaryFutex::Post()` and the waiter returning from its wait.
+//
+// The buckets are powers of two in nanoseconds, see log2_histogram.h.
+// Additionally counts in which phase of the wait policy the waiter noticed the
+// post.
+//
+// Recording is lock-free and realtime safe. Readers may run concurrently with
+// a recording thread, but might then see a slightly inconsistent snapshot.
+class WakeupLatencyHistogram {
+ public:
+  static constexpr size_t kNumBuckets = kNumLog2HistogramBuckets;
+
+  // The phase of the wait in which the post was noticed.
+  enum class WakeupPhase {
+    // The futex was posted already, or was posted while spinning.
+    kSpin,
+    // The post was noticed after yielding the CPU.
+    kYield,
+    // The waiter was woken up from the futex syscall.
+    kFutex,
+  };
+  static constexpr size_t kNumPhases = 3;
+
+  WakeupLatencyHistogram() = default;
+  WakeupLatencyHistogram(const WakeupLatencyHistogram&) = delete;
+  WakeupLatencyHistogram& operator=(const WakeupLatencyHistogram&) = delete;
+
+  // Records a single wake-up. Negative latencies (e.g. when the futex was
+  // posted by a process with a clock offset) are recorded as zero.
+  // Realtime safe.
+  void Record(int64_t latency_ns, WakeupPhase phase);
+
+  // Returns the total number of recorded wake-ups.
+  uint64_t Count() const;
+  // Returns the number of wake-ups in `bucket`.
+  uint64_t BucketCount(size_t bucket) const;
+  // Returns the number of wake-ups that were noticed in `phase`.
+  uint64_t PhaseCount(WakeupPhase phase) const;
+  // Returns the largest recorded latency.
+  absl::Duration Max() const;
+
+  // Returns an upper bound of the `quantile` (in [0, 1]) of the recorded
+  // latencies, see Log2HistogramPercentile(). Returns zero if nothing was
+  // recorded.
+  absl::Duration Percentile(double quantile) const;
+
+  // Clears all buckets. Not thread-safe with respect to `Record()`.
+  void Reset();
+
+  // Returns the upper end of `bucket` in nanoseconds.
+  static int64_t BucketUpperBoundNs(size_t bucket);
+
+ private:
+  std::array<std::atomic<uint64_t>, kNumBuckets> buckets_ = {};
+  std::array<std::atomic<uint64_t>, kNumPhases> phases_ = {};
+  std::atomic<int64_t> max_ns_ = 0;
+};
+
+}  // namespace intrinsic::icon
+
+#endif  // INTRINSIC_ICON_INTERPROCESS_FUTEX_WAIT_POLICY_H_
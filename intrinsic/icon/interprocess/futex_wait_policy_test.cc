@@ -0,0 +1,137 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/icon/interprocess/futex_wait_policy.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+#include "absl/status/status.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "intrinsic/icon/interprocess/binary_futex.h"
+#include "intrinsic/util/testing/gtest_wrapper.h"
+#include "intrinsic/util/thread/thread.h"
+
+namespace intrinsic::icon {
+namespace {
+
+using WakeupPhase = WakeupLatencyHistogram::WakeupPhase;
+
+TEST(WakeupLatencyHistogramTest, SortsLatenciesIntoPowerOfTwoBuckets) {
+  WakeupLatencyHistogram histogram;
+  histogram.Record(0, WakeupPhase::kSpin);
+  histogram.Record(1, WakeupPhase::kSpin);
+  histogram.Record(1000, WakeupPhase::kYield);
+  histogram.Record(1023, WakeupPhase::kFutex);
+  histogram.Record(-5, WakeupPhase::kFutex);
+
+  EXPECT_EQ(histogram.Count(), 5);
+  EXPECT_EQ(histogram.BucketCount(0), 3);
+  // 1000 and 1023 are both in [512, 1024).
+  EXPECT_EQ(histogram.BucketCount(9), 2);
+  EXPECT_EQ(histogram.PhaseCount(WakeupPhase::kSpin), 2);
+  EXPECT_EQ(histogram.PhaseCount(WakeupPhase::kYield), 1);
+  EXPECT_EQ(histogram.PhaseCount(WakeupPhase::kFutex), 2);
+  EXPECT_EQ(histogram.Max(), absl::Nanoseconds(1023));
+
+  histogram.Reset();
+  EXPECT_EQ(histogram.Count(), 0);
+  EXPECT_EQ(histogram.Max(), absl::ZeroDuration());
+}
+
+TEST(WakeupLatencyHistogramTest, ComputesPercentileUpperBounds) {
+  WakeupLatencyHistogram histogram;
+  EXPECT_EQ(histogram.Percentile(0.99), absl::ZeroDuration());
+
+  for (int i = 0; i < 990; ++i) {
+    histogram.Record(100, WakeupPhase::kSpin);
+  }
+  for (int i = 0; i < 10; ++i) {
+    histogram.Record(50'000, WakeupPhase::kFutex);
+  }
+  // 100ns is in [64, 128).
+  EXPECT_EQ(histogram.Percentile(0.5), absl::Nanoseconds(128));
+  EXPECT_EQ(histogram.Percentile(0.99), absl::Nanoseconds(128));
+  // The bound of the last bucket is the maximum.
+  EXPECT_EQ(histogram.Percentile(0.999), absl::Nanoseconds(50'000));
+  EXPECT_EQ(histogram.Percentile(1.0), absl::Nanoseconds(50'000));
+}
+
+class BinaryFutexWaitPolicyTest
+    : public ::testing::TestWithParam<FutexWaitPolicy> {};
+
+TEST_P(BinaryFutexWaitPolicyTest, WakesUpOnPost) {
+  BinaryFutex request;
+  BinaryFutex response;
+  WakeupLatencyHistogram histogram;
+  constexpr int kIterations = 100;
+  request.EnablePostTimestamps();
+
+  intrinsic::Thread waiter([&]() {
+    for (int i = 0; i < kIterations; ++i) {
+      ASSERT_TRUE(request
+                      .WaitUntil(absl::Now() + absl::Seconds(10), GetParam(),
+                                 &histogram)
+                      .ok());
+      ASSERT_TRUE(response.Post().ok());
+    }
+  });
+  for (int i = 0; i < kIterations; ++i) {
+    ASSERT_TRUE(request.Post().ok());
+    ASSERT_TRUE(response.WaitFor(absl::Seconds(10)).ok());
+  }
+  waiter.Join();
+
+  EXPECT_EQ(histogram.Count(), kIterations);
+  EXPECT_GT(histogram.Max(), absl::ZeroDuration());
+  if (GetParam().mode == FutexWaitPolicy::Mode::kSpin) {
+    EXPECT_EQ(histogram.PhaseCount(WakeupPhase::kSpin), kIterations);
+  }
+}
+
+TEST_P(BinaryFutexWaitPolicyTest, ReturnsImmediatelyIfPosted) {
+  BinaryFutex futex(/*posted=*/true);
+  futex.EnablePostTimestamps();
+  WakeupLatencyHistogram histogram;
+  EXPECT_TRUE(
+      futex.WaitFor(absl::Seconds(10), GetParam(), &histogram).ok());
+  EXPECT_EQ(futex.Value(), 0);
+  // Posted before post timestamps were enabled, so there is no post time.
+  EXPECT_EQ(histogram.Count(), 0);
+
+  ASSERT_TRUE(futex.Post().ok());
+  EXPECT_TRUE(
+      futex.WaitFor(absl::Seconds(10), GetParam(), &histogram).ok());
+  EXPECT_EQ(histogram.PhaseCount(WakeupPhase::kSpin), 1);
+}
+
+TEST_P(BinaryFutexWaitPolicyTest, DoesNotRecordWithoutPostTimestamps) {
+  BinaryFutex futex;
+  WakeupLatencyHistogram histogram;
+  // Passing a histogram doesn't enable timestamps for later posts.
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_TRUE(futex.Post().ok());
+    EXPECT_TRUE(
+        futex.WaitFor(absl::Seconds(10), GetParam(), &histogram).ok());
+  }
+  EXPECT_EQ(histogram.Count(), 0);
+}
+
+TEST_P(BinaryFutexWaitPolicyTest, TimesOut) {
+  BinaryFutex futex;
+  WakeupLatencyHistogram histogram;
+  EXPECT_EQ(
+      futex.WaitFor(absl::Milliseconds(5), GetParam(), &histogram).code(),
+      absl::StatusCode::kDeadlineExceeded);
+  EXPECT_EQ(histogram.Count(), 0);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    WaitPolicies, BinaryFutexWaitPolicyTest,
+    ::testing::Values(FutexWaitPolicy::Futex(), FutexWaitPolicy::Spin(),
+                      FutexWaitPolicy::SpinThenYield(absl::Microseconds(20)),
+                      FutexWaitPolicy::SpinThenFutex(absl::Microseconds(20))));
+
+}  // namespace
+}  // namespace intrinsic::icon
@@ -0,0 +1,56 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/icon/interprocess/log2_histogram.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+
+namespace intrinsic::icon {
+
+size_t Log2HistogramBucket(int64_t duration_ns) {
+  if (duration_ns < 2) {
+    return 0;
+  }
+  return std::min<size_t>(
+      std::bit_width(static_cast<uint64_t>(duration_ns)) - 1,
+      kNumLog2HistogramBuckets - 1);
+}
+
+int64_t Log2HistogramBucketUpperBoundNs(size_t bucket) {
+  if (bucket >= kNumLog2HistogramBuckets - 1) {
+    return std::numeric_limits<int64_t>::max();
+  }
+  return int64_t{2} << bucket;
+}
+
+absl::Duration Log2HistogramPercentile(absl::Span<const uint64_t> buckets,
+                                       int64_t max_ns, double quantile) {
+  uint64_t count = 0;
+  for (uint64_t bucket : buckets) {
+    count += bucket;
+  }
+  if (count == 0) {
+    return absl::ZeroDuration();
+  }
+  quantile = std::clamp(quantile, 0.0, 1.0);
+  // The number of values that are at most as large as the quantile.
+  const uint64_t rank = std::max<uint64_t>(
+      1, static_cast<uint64_t>(quantile * static_cast<double>(count) + 0.5));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < buckets.size(); ++i) {
+    seen += buckets[i];
+    if (seen >= rank) {
+      return absl::Nanoseconds(
+          std::min(Log2HistogramBucketUpperBoundNs(i), max_ns));
+    }
+  }
+  return absl::Nanoseconds(max_ns);
+}
+
+}  // namespace intrinsic::icon
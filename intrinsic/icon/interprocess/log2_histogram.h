@@ -0,0 +1,44 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#ifndef INTRINSIC_ICON_INTERPROCESS_LOG2_HISTOGRAM_H_
+#define INTRINSIC_ICON_INTERPROCESS_LOG2_HISTOGRAM_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+
+namespace intrinsic::icon {
+
+// Helpers for histograms of durations with power-of-two buckets in
+// nanoseconds: Bucket 0 holds durations below 2ns, bucket i > 0 holds
+// durations in [2^i, 2^(i+1)) ns and the last bucket holds everything above.
+//
+// The histograms keep their counts in whatever storage fits them, e.g. arrays
+// of atomics for lock-free recording, and use these helpers to sort values
+// into buckets and to compute percentiles.
+
+// Number of buckets of a histogram.
+inline constexpr size_t kNumLog2HistogramBuckets = 32;
+
+// Returns the bucket of `duration_ns`. Negative durations are sorted into
+// bucket 0. Realtime safe.
+size_t Log2HistogramBucket(int64_t duration_ns);
+
+// Returns the upper end of `bucket` in nanoseconds. The last bucket has no
+// upper end, so returns the largest int64_t for it.
+int64_t Log2HistogramBucketUpperBoundNs(size_t bucket);
+
+// Returns an upper bound of the `quantile` (in [0, 1]) of the durations
+// counted in `buckets`, i.e. the upper end of the bucket that contains it.
+// `max_ns` is the largest recorded duration, which bounds every bucket
+// tighter than its upper end once it is reached. In particular, percentiles in
+// the last bucket are reported as `max_ns`. Returns zero if `buckets` holds no
+// values.
+absl::Duration Log2HistogramPercentile(absl::Span<const uint64_t> buckets,
+                                       int64_t max_ns, double quantile);
+
+}  // namespace intrinsic::icon
+
+#endif  // INTRINSIC_ICON_INTERPROCESS_LOG2_HISTOGRAM_H_
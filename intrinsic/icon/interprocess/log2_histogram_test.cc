@@ -0,0 +1,61 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/icon/interprocess/log2_histogram.h"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdint>
+#include <limits>
+
+#include "absl/time/time.h"
+#include "intrinsic/util/testing/gtest_wrapper.h"
+
+namespace intrinsic::icon {
+namespace {
+
+using Buckets = std::array<uint64_t, kNumLog2HistogramBuckets>;
+
+TEST(Log2HistogramTest, SortsDurationsIntoPowerOfTwoBuckets) {
+  EXPECT_EQ(Log2HistogramBucket(-5), 0);
+  EXPECT_EQ(Log2HistogramBucket(0), 0);
+  EXPECT_EQ(Log2HistogramBucket(1), 0);
+  EXPECT_EQ(Log2HistogramBucket(2), 1);
+  EXPECT_EQ(Log2HistogramBucket(1023), 9);
+  EXPECT_EQ(Log2HistogramBucket(1024), 10);
+  EXPECT_EQ(Log2HistogramBucket(std::numeric_limits<int64_t>::max()),
+            kNumLog2HistogramBuckets - 1);
+
+  EXPECT_EQ(Log2HistogramBucketUpperBoundNs(0), 2);
+  EXPECT_EQ(Log2HistogramBucketUpperBoundNs(9), 1024);
+  EXPECT_EQ(Log2HistogramBucketUpperBoundNs(kNumLog2HistogramBuckets - 1),
+            std::numeric_limits<int64_t>::max());
+}
+
+TEST(Log2HistogramTest, PercentileIsUpperEndOfBucket) {
+  EXPECT_EQ(Log2HistogramPercentile(Buckets{}, 0, 0.5), absl::ZeroDuration());
+
+  Buckets buckets = {};
+  // 990 values in [64, 128) and 10 values in [32768, 65536), up to 50us.
+  buckets[6] = 990;
+  buckets[15] = 10;
+  EXPECT_EQ(Log2HistogramPercentile(buckets, 50'000, 0.0),
+            absl::Nanoseconds(128));
+  EXPECT_EQ(Log2HistogramPercentile(buckets, 50'000, 0.99),
+            absl::Nanoseconds(128));
+  // The maximum is a tighter bound for the bucket that contains it.
+  EXPECT_EQ(Log2HistogramPercentile(buckets, 50'000, 0.999),
+            absl::Nanoseconds(50'000));
+  EXPECT_EQ(Log2HistogramPercentile(buckets, 50'000, 2.0),
+            absl::Nanoseconds(50'000));
+}
+
+TEST(Log2HistogramTest, PercentileInLastBucketIsMaximum) {
+  Buckets buckets = {};
+  buckets[kNumLog2HistogramBuckets - 1] = 1;
+  EXPECT_EQ(Log2HistogramPercentile(buckets, int64_t{1} << 40, 0.5),
+            absl::Nanoseconds(int64_t{1} << 40));
+}
+
+}  // namespace
+}  // namespace intrinsic::icon
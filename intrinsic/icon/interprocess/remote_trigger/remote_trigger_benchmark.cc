@@ -0,0 +1,156 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+// Compares the round-trip latency of one cycle of a hardware module, i.e.
+// `ReadStatus` followed by `ApplyCommand`:
+// * with one remote trigger per operation (two round-trips per cycle) and
+// * with a single remote trigger that carries both operations as opcodes.
+//
+// The combined trigger is measured with each `FutexWaitPolicy` on both the
+// client and the server side.
+//
+// Besides the mean, reports the p50, p99 and p999 cycle latency in
+// nanoseconds. Run with `bazel run -c opt` on isolated CPUs for meaningful
+// numbers; the spinning policies need one CPU each for client and server.
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "absl/strings/str_cat.h"
+#include "absl/time/time.h"
+#include "benchmark/benchmark.h"
+#include "intrinsic/icon/interprocess/futex_wait_policy.h"
+#include "intrinsic/icon/interprocess/remote_trigger/remote_trigger_client.h"
+#include "intrinsic/icon/interprocess/remote_trigger/remote_trigger_server.h"
+#include "intrinsic/icon/interprocess/shared_memory_manager/memory_segment.h"
+
+namespace intrinsic::icon {
+namespace {
+
+constexpr uint32_t kReadStatus = 1 << 0;
+constexpr uint32_t kApplyCommand = 1 << 1;
+
+constexpr FutexWaitPolicy kWaitPolicies[] = {
+    FutexWaitPolicy::Futex(),
+    FutexWaitPolicy::Spin(),
+    FutexWaitPolicy::SpinThenYield(absl::Microseconds(50)),
+    FutexWaitPolicy::SpinThenFutex(absl::Microseconds(50)),
+};
+
+MemoryName BenchmarkServerName(absl::string_view name) {
+  return MemoryName("", absl::StrCat("remote_trigger_benchmark_", getpid()),
+                    name);
+}
+
+// Records the latency of every iteration and reports its percentiles.
+class LatencyRecorder {
+ public:
+  explicit LatencyRecorder(benchmark::State& state) : state_(state) {
+    latencies_.reserve(state.max_iterations);
+  }
+
+  void Start() { start_ = std::chrono::steady_clock::now(); }
+  void Stop() {
+    latencies_.push_back(std::chrono::duration<double, std::nano>(
+                             std::chrono::steady_clock::now() - start_)
+                             .count());
+  }
+
+  // Adds the percentiles of all recorded latencies to the state's counters.
+  void Report() {
+    if (latencies_.empty()) {
+      return;
+    }
+    std::sort(latencies_.begin(), latencies_.end());
+    auto percentile = [this](double p) {
+      return latencies_[static_cast<size_t>(p * (latencies_.size() - 1))];
+    };
+    state_.counters["p50_ns"] = percentile(0.5);
+    state_.counters["p99_ns"] = percentile(0.99);
+    state_.counters["p999_ns"] = percentile(0.999);
+  }
+
+ private:
+  benchmark::State& state_;
+  std::chrono::steady_clock::time_point start_;
+  std::vector<double> latencies_;
+};
+
+void BM_SeparateTriggers(benchmark::State& state) {
+  uint64_t read_status_calls = 0;
+  uint64_t apply_command_calls = 0;
+  auto read_status_server =
+      RemoteTriggerServer::Create(BenchmarkServerName("read_status"),
+                                  [&]() { ++read_status_calls; });
+  CHECK_OK(read_status_server.status());
+  auto apply_command_server =
+      RemoteTriggerServer::Create(BenchmarkServerName("apply_command"),
+                                  [&]() { ++apply_command_calls; });
+  CHECK_OK(apply_command_server.status());
+  CHECK_OK(read_status_server->StartAsync());
+  CHECK_OK(apply_command_server->StartAsync());
+  auto read_status_client =
+      RemoteTriggerClient::Create(BenchmarkServerName("read_status"));
+  CHECK_OK(read_status_client.status());
+  auto apply_command_client =
+      RemoteTriggerClient::Create(BenchmarkServerName("apply_command"));
+  CHECK_OK(apply_command_client.status());
+
+  LatencyRecorder recorder(state);
+  for (auto _ : state) {
+    recorder.Start();
+    CHECK(read_status_client->Trigger().ok());
+    CHECK(apply_command_client->Trigger().ok());
+    recorder.Stop();
+  }
+  recorder.Report();
+  read_status_server->Stop();
+  apply_command_server->Stop();
+  CHECK_EQ(read_status_calls, apply_command_calls);
+}
+
+void BM_CombinedTrigger(benchmark::State& state) {
+  const FutexWaitPolicy& wait_policy = kWaitPolicies[state.range(0)];
+  uint64_t read_status_calls = 0;
+  uint64_t apply_command_calls = 0;
+  auto cycle_server = RemoteTriggerServer::CreateWithOpcodes(
+      BenchmarkServerName("cycle"), [&](uint32_t opcodes) {
+        if (opcodes & kReadStatus) {
+          ++read_status_calls;
+        }
+        if (opcodes & kApplyCommand) {
+          ++apply_command_calls;
+        }
+      },
+      wait_policy);
+  CHECK_OK(cycle_server.status());
+  CHECK_OK(cycle_server->StartAsync());
+  auto cycle_client = RemoteTriggerClient::Create(
+      BenchmarkServerName("cycle"), /*auto_connect=*/true, wait_policy);
+  CHECK_OK(cycle_client.status());
+
+  LatencyRecorder recorder(state);
+  for (auto _ : state) {
+    recorder.Start();
+    CHECK(cycle_client->TriggerWithOpcodes(kReadStatus | kApplyCommand).ok());
+    recorder.Stop();
+  }
+  recorder.Report();
+  cycle_server->Stop();
+  CHECK_EQ(read_status_calls, apply_command_calls);
+}
+
+BENCHMARK(BM_SeparateTriggers)->UseRealTime();
+BENCHMARK(BM_CombinedTrigger)
+    ->UseRealTime()
+    ->ArgName("wait_policy")
+    ->DenseRange(0, std::size(kWaitPolicies) - 1);
+
+}  // namespace
+}  // namespace intrinsic::icon
@@ -3,6 +3,7 @@
 #include "intrinsic/icon/interprocess/remote_trigger/remote_trigger_client.h"
 
 #include <atomic>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <utility>
@@ -14,6 +15,7 @@
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "intrinsic/icon/interprocess/binary_futex.h"
+#include "intrinsic/icon/interprocess/futex_wait_policy.h"
 #include "intrinsic/icon/interprocess/remote_trigger/remote_trigger_constants.h"
 #include "intrinsic/icon/interprocess/shared_memory_manager/memory_segment.h"
 #include "intrinsic/icon/utils/realtime_status.h"
@@ -78,16 +80,24 @@ RealtimeStatus RemoteTriggerClient::AsyncRequest::WaitUntil(
 }
 
 absl::StatusOr<RemoteTriggerClient> RemoteTriggerClient::Create(
-    const MemoryName& server_name, bool auto_connect) {
-  RemoteTriggerClient client(server_name);
+    const MemoryName& server_name, bool auto_connect,
+    const FutexWaitPolicy& wait_policy, bool record_wakeup_latencies) {
+  RemoteTriggerClient client(server_name, wait_policy,
+                             record_wakeup_latencies);
   if (auto_connect) {
     INTR_RETURN_IF_ERROR(client.Connect());
   }
   return client;
 }
 
-RemoteTriggerClient::RemoteTriggerClient(const MemoryName& server_name)
-    : server_name_(server_name) {}
+RemoteTriggerClient::RemoteTriggerClient(const MemoryName& server_name,
+                                         const FutexWaitPolicy& wait_policy,
+                                         bool record_wakeup_latencies)
+    : server_name_(server_name),
+      wait_policy_(wait_policy),
+      wakeup_latencies_(record_wakeup_latencies
+                            ? std::make_unique<WakeupLatencyHistogram>()
+                            : nullptr) {}
 
 RemoteTriggerClient::RemoteTriggerClient(
     const MemoryName& server_name,
@@ -103,6 +113,10 @@ RemoteTriggerClient::RemoteTriggerClient(RemoteTriggerClient&& other) noexcept
                                    ReadWriteMemorySegment<BinaryFutex>())),
       response_futex_(std::exchange(other.response_futex_,
                                     ReadOnlyMemorySegment<BinaryFutex>())),
+      opcodes_(
+          std::exchange(other.opcodes_, ReadWriteMemorySegment<uint32_t>())),
+      wait_policy_(other.wait_policy_),
+      wakeup_latencies_(std::move(other.wakeup_latencies_)),
       request_started_(false) {}
 
 RemoteTriggerClient& RemoteTriggerClient::operator=(
@@ -113,6 +127,10 @@ RemoteTriggerClient& RemoteTriggerClient::operator=(
                                    ReadWriteMemorySegment<BinaryFutex>());
     response_futex_ = std::exchange(other.response_futex_,
                                     ReadOnlyMemorySegment<BinaryFutex>());
+    opcodes_ =
+        std::exchange(other.opcodes_, ReadWriteMemorySegment<uint32_t>());
+    wait_policy_ = other.wait_policy_;
+    wakeup_latencies_ = std::move(other.wakeup_latencies_);
     request_started_.store(false);
   }
   return *this;
@@ -126,11 +144,22 @@ absl::Status RemoteTriggerClient::Connect() {
   request_memory.Append(kSemRequestSuffix);
   MemoryName response_memory = server_name_;
   response_memory.Append(kSemResponseSuffix);
+  MemoryName opcodes_memory = server_name_;
+  opcodes_memory.Append(kOpcodesSuffix);
+  // Only servers created with `CreateWithOpcodes()` have opcodes. They are
+  // created before the futexes, so they exist if the futexes exist.
+  if (auto opcodes = ReadWriteMemorySegment<uint32_t>::Get(opcodes_memory);
+      opcodes.ok()) {
+    opcodes_ = *std::move(opcodes);
+  }
   INTR_ASSIGN_OR_RETURN(
       request_futex_, ReadWriteMemorySegment<BinaryFutex>::Get(request_memory));
   INTR_ASSIGN_OR_RETURN(
       response_futex_,
       ReadOnlyMemorySegment<BinaryFutex>::Get(response_memory));
+  if (wakeup_latencies_ != nullptr) {
+    response_futex_.GetValue().EnablePostTimestamps();
+  }
   return absl::OkStatus();
 }
 
@@ -157,7 +186,8 @@ RealtimeStatus RemoteTriggerClient::Trigger(absl::Time deadline) {
   // Signal the server to start the execution.
   INTRINSIC_RT_RETURN_IF_ERROR(request_futex_.GetValue().Post());
   // Wait for the response from the server.
-  return response_futex_.GetValue().WaitUntil(deadline);
+  return response_futex_.GetValue().WaitUntil(deadline, wait_policy_,
+                                              wakeup_latencies_.get());
 }
 
 RealtimeStatusOr<RemoteTriggerClient::AsyncRequest>
@@ -175,4 +205,37 @@ RemoteTriggerClient::TriggerAsync() {
   return AsyncRequest(&response_futex_, &request_started_);
 }
 
+const WakeupLatencyHistogram* RemoteTriggerClient::WakeupLatencies() const {
+  return wakeup_latencies_.get();
+}
+
+bool RemoteTriggerClient::SupportsOpcodes() const {
+  return opcodes_.IsValid();
+}
+
+RealtimeStatus RemoteTriggerClient::TriggerWithOpcodes(uint32_t opcodes,
+                                                       absl::Time deadline) {
+  if (!IsConnected()) {
+    return InvalidArgumentError("client not connected");
+  }
+  if (!SupportsOpcodes()) {
+    return FailedPreconditionError("server does not accept opcodes");
+  }
+  if (absl::Now() > deadline) {
+    return DeadlineExceededError("specified deadline is in the past");
+  }
+  if (bool expected = false;
+      !request_started_.compare_exchange_strong(expected, true)) {
+    return AlreadyExistsError("request already triggered");
+  }
+
+  absl::Cleanup clear_request_flag = [this] { request_started_.store(false); };
+
+  // Posting the request futex publishes the opcodes to the server.
+  opcodes_.SetValue(opcodes);
+  INTRINSIC_RT_RETURN_IF_ERROR(request_futex_.GetValue().Post());
+  return response_futex_.GetValue().WaitUntil(deadline, wait_policy_,
+                                              wakeup_latencies_.get());
+}
+
 }  // namespace intrinsic::icon
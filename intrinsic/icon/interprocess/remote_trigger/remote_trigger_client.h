@@ -4,6 +4,7 @@
 #define INTRINSIC_ICON_INTERPROCESS_REMOTE_TRIGGER_REMOTE_TRIGGER_CLIENT_H_
 
 #include <atomic>
+#include <cstdint>
 #include <memory>
 #include <string>
 
@@ -12,6 +13,7 @@
 #include "absl/strings/string_view.h"
 #include "absl/time/time.h"
 #include "intrinsic/icon/interprocess/binary_futex.h"
+#include "intrinsic/icon/interprocess/futex_wait_policy.h"
 #include "intrinsic/icon/interprocess/shared_memory_manager/memory_segment.h"
 #include "intrinsic/icon/utils/realtime_status.h"
 #include "intrinsic/icon/utils/realtime_status_or.h"
@@ -88,8 +90,15 @@ class RemoteTriggerClient {
   // argument to false to create an unconnected client instance.
   // In order to trigger an execution on the server, we have to explicitly call
   // `Connect()` before in order to establish a working connection.
+  // `wait_policy` determines how `Trigger()` and `TriggerWithOpcodes()` wait
+  // for the server's response, e.g. whether they spin before going to sleep.
+  // If `record_wakeup_latencies` is true, the client records the latencies
+  // returned by `WakeupLatencies()`, which costs the server a clock read per
+  // response.
   static absl::StatusOr<RemoteTriggerClient> Create(
-      const MemoryName& server_name, bool auto_connect = true);
+      const MemoryName& server_name, bool auto_connect = true,
+      const FutexWaitPolicy& wait_policy = FutexWaitPolicy::Futex(),
+      bool record_wakeup_latencies = false);
 
   // This class is move-only.
   RemoteTriggerClient(RemoteTriggerClient& other) = delete;
@@ -124,8 +133,26 @@ class RemoteTriggerClient {
   // clients without them waiting on each other.
   RealtimeStatusOr<AsyncRequest> TriggerAsync();
 
+  // Indicates whether the server accepts opcodes, i.e. was created with
+  // `RemoteTriggerServer::CreateWithOpcodes()`.
+  bool SupportsOpcodes() const;
+
+  // Like `Trigger()`, but passes the bitmask `opcodes` to the server's
+  // callback. This lets a single request dispatch several operations on the
+  // server, which costs a single round-trip instead of one per operation.
+  // Returns a `FailedPrecondition` error if the server doesn't accept opcodes.
+  RealtimeStatus TriggerWithOpcodes(
+      uint32_t opcodes, absl::Time deadline = absl::InfiniteFuture());
+
+  // Returns the latencies between the server's response and `Trigger()` or
+  // `TriggerWithOpcodes()` waking up to return it, or nullptr if the client
+  // was created without `record_wakeup_latencies` or was moved from.
+  const WakeupLatencyHistogram* WakeupLatencies() const;
+
  private:
-  explicit RemoteTriggerClient(const MemoryName& server_name);
+  RemoteTriggerClient(const MemoryName& server_name,
+                      const FutexWaitPolicy& wait_policy,
+                      bool record_wakeup_latencies);
 
   RemoteTriggerClient(const MemoryName& server_name,
                       ReadWriteMemorySegment<BinaryFutex>&& request_futex,
@@ -136,6 +163,12 @@ class RemoteTriggerClient {
   // server and its clients.
   ReadWriteMemorySegment<BinaryFutex> request_futex_;
   ReadOnlyMemorySegment<BinaryFutex> response_futex_;
+  // Only valid if the server accepts opcodes.
+  ReadWriteMemorySegment<uint32_t> opcodes_;
+  FutexWaitPolicy wait_policy_;
+  // Heap allocated, so that the histogram stays valid when the client is moved.
+  // Null unless the client records wake-up latencies.
+  std::unique_ptr<WakeupLatencyHistogram> wakeup_latencies_;
 
   // We have to bookmark whether a request is currently active. A call to
   // `Trigger()` as well as `TriggerAsync()` starts a request. The former
@@ -6,6 +6,7 @@
 namespace intrinsic::icon {
 inline constexpr char kSemRequestSuffix[] = ".req";
 inline constexpr char kSemResponseSuffix[] = ".res";
+inline constexpr char kOpcodesSuffix[] = ".ops";
 }  // namespace intrinsic::icon
 
 #endif  // INTRINSIC_ICON_INTERPROCESS_REMOTE_TRIGGER_REMOTE_TRIGGER_CONSTANTS_H_
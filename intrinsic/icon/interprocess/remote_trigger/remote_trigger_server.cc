@@ -3,7 +3,9 @@
 #include "intrinsic/icon/interprocess/remote_trigger/remote_trigger_server.h"
 
 #include <atomic>
+#include <cstdint>
 #include <functional>
+#include <memory>
 #include <utility>
 
 #include "absl/status/status.h"
@@ -12,6 +14,7 @@
 #include "absl/strings/string_view.h"
 #include "absl/time/time.h"
 #include "intrinsic/icon/interprocess/binary_futex.h"
+#include "intrinsic/icon/interprocess/futex_wait_policy.h"
 #include "intrinsic/icon/interprocess/remote_trigger/remote_trigger_constants.h"
 #include "intrinsic/icon/interprocess/shared_memory_manager/memory_segment.h"
 #include "intrinsic/icon/interprocess/shared_memory_manager/shared_memory_manager.h"
@@ -24,7 +27,8 @@ namespace intrinsic::icon {
 
 absl::StatusOr<RemoteTriggerServer> RemoteTriggerServer::Create(
     const MemoryName& server_memory_name,
-    RemoteTriggerServerCallback&& callback) {
+    RemoteTriggerServerCallback&& callback,
+    const FutexWaitPolicy& wait_policy, bool record_wakeup_latencies) {
   MemoryName request_memory = server_memory_name;
   request_memory.Append(kSemRequestSuffix);
   MemoryName response_memory = server_memory_name;
@@ -43,20 +47,72 @@ absl::StatusOr<RemoteTriggerServer> RemoteTriggerServer::Create(
 
   return RemoteTriggerServer(
       server_memory_name, std::forward<RemoteTriggerServerCallback>(callback),
+      /*opcode_callback=*/nullptr, std::move(shm_manager),
+      std::move(request_futex), std::move(response_futex),
+      ReadOnlyMemorySegment<uint32_t>(), wait_policy, record_wakeup_latencies);
+}
+
+absl::StatusOr<RemoteTriggerServer> RemoteTriggerServer::CreateWithOpcodes(
+    const MemoryName& server_memory_name,
+    RemoteTriggerServerOpcodeCallback&& callback,
+    const FutexWaitPolicy& wait_policy, bool record_wakeup_latencies) {
+  MemoryName request_memory = server_memory_name;
+  request_memory.Append(kSemRequestSuffix);
+  MemoryName response_memory = server_memory_name;
+  response_memory.Append(kSemResponseSuffix);
+  MemoryName opcodes_memory = server_memory_name;
+  opcodes_memory.Append(kOpcodesSuffix);
+  intrinsic::icon::SharedMemoryManager shm_manager;
+  // The opcodes are added first, so that a client which finds the futexes
+  // also finds the opcodes.
+  INTR_RETURN_IF_ERROR(shm_manager.AddSegment(
+      opcodes_memory, /*must_be_used=*/false, uint32_t{0}));
+  INTR_RETURN_IF_ERROR(shm_manager.AddSegment(
+      request_memory, /*must_be_used=*/false, BinaryFutex()));
+  INTR_RETURN_IF_ERROR(shm_manager.AddSegment(
+      response_memory, /*must_be_used=*/false, BinaryFutex()));
+  INTR_ASSIGN_OR_RETURN(auto opcodes,
+                        ReadOnlyMemorySegment<uint32_t>::Get(opcodes_memory));
+  INTR_ASSIGN_OR_RETURN(
+      auto request_futex,
+      ReadOnlyMemorySegment<BinaryFutex>::Get(request_memory));
+  INTR_ASSIGN_OR_RETURN(
+      auto response_futex,
+      ReadWriteMemorySegment<BinaryFutex>::Get(response_memory));
+
+  return RemoteTriggerServer(
+      server_memory_name, /*callback=*/nullptr,
+      std::forward<RemoteTriggerServerOpcodeCallback>(callback),
       std::move(shm_manager), std::move(request_futex),
-      std::move(response_futex));
+      std::move(response_futex), std::move(opcodes), wait_policy,
+      record_wakeup_latencies);
 }
 
 RemoteTriggerServer::RemoteTriggerServer(
     const MemoryName& server_memory_name,
-    RemoteTriggerServerCallback&& callback, SharedMemoryManager&& shm_manager,
+    RemoteTriggerServerCallback&& callback,
+    RemoteTriggerServerOpcodeCallback&& opcode_callback,
+    SharedMemoryManager&& shm_manager,
     ReadOnlyMemorySegment<BinaryFutex>&& request_futex,
-    ReadWriteMemorySegment<BinaryFutex>&& response_futex)
+    ReadWriteMemorySegment<BinaryFutex>&& response_futex,
+    ReadOnlyMemorySegment<uint32_t>&& opcodes,
+    const FutexWaitPolicy& wait_policy, bool record_wakeup_latencies)
     : server_memory_name_(server_memory_name),
       callback_(std::forward<RemoteTriggerServerCallback>(callback)),
+      opcode_callback_(
+          std::forward<RemoteTriggerServerOpcodeCallback>(opcode_callback)),
       shm_manager_(std::forward<decltype(shm_manager)>(shm_manager)),
       request_futex_(std::forward<decltype(request_futex)>(request_futex)),
-      response_futex_(std::forward<decltype(response_futex)>(response_futex)) {}
+      response_futex_(std::forward<decltype(response_futex)>(response_futex)),
+      opcodes_(std::forward<decltype(opcodes)>(opcodes)),
+      wait_policy_(wait_policy),
+      wakeup_latencies_(record_wakeup_latencies
+                            ? std::make_unique<WakeupLatencyHistogram>()
+                            : nullptr) {
+  if (wakeup_latencies_ != nullptr) {
+    request_futex_.GetValue().EnablePostTimestamps();
+  }
+}
 
 RemoteTriggerServer::RemoteTriggerServer(RemoteTriggerServer&& other) noexcept
     : server_memory_name_(MemoryName("", "")) {
@@ -66,12 +122,16 @@ RemoteTriggerServer::RemoteTriggerServer(RemoteTriggerServer&& other) noexcept
   server_memory_name_ =
       std::exchange(other.server_memory_name_, MemoryName("", ""));
   callback_ = std::exchange(other.callback_, nullptr);
+  opcode_callback_ = std::exchange(other.opcode_callback_, nullptr);
   is_running_.store(false);
   shm_manager_ = std::exchange(other.shm_manager_, SharedMemoryManager());
   request_futex_ =
       std::exchange(other.request_futex_, ReadOnlyMemorySegment<BinaryFutex>());
   response_futex_ = std::exchange(other.response_futex_,
                                   ReadWriteMemorySegment<BinaryFutex>());
+  opcodes_ = std::exchange(other.opcodes_, ReadOnlyMemorySegment<uint32_t>());
+  wait_policy_ = other.wait_policy_;
+  wakeup_latencies_ = std::move(other.wakeup_latencies_);
 }
 
 RemoteTriggerServer& RemoteTriggerServer::operator=(
@@ -83,12 +143,16 @@ RemoteTriggerServer& RemoteTriggerServer::operator=(
     server_memory_name_ =
         std::exchange(other.server_memory_name_, MemoryName("", ""));
     callback_ = std::exchange(other.callback_, nullptr);
+    opcode_callback_ = std::exchange(other.opcode_callback_, nullptr);
     is_running_.store(false);
     shm_manager_ = std::exchange(other.shm_manager_, SharedMemoryManager());
     request_futex_ = std::exchange(other.request_futex_,
                                    ReadOnlyMemorySegment<BinaryFutex>());
     response_futex_ = std::exchange(other.response_futex_,
                                     ReadWriteMemorySegment<BinaryFutex>());
+    opcodes_ = std::exchange(other.opcodes_, ReadOnlyMemorySegment<uint32_t>());
+    wait_policy_ = other.wait_policy_;
+    wakeup_latencies_ = std::move(other.wakeup_latencies_);
   }
 
   return *this;
@@ -144,7 +208,8 @@ bool RemoteTriggerServer::Query() {
     return false;
   }
 
-  auto wait_status = request_futex_.GetValue().WaitFor(absl::Milliseconds(100));
+  auto wait_status = request_futex_.GetValue().WaitFor(
+      absl::Milliseconds(100), wait_policy_, wakeup_latencies_.get());
   // If we woke up because of timeout, don't execute the callback.
   if (wait_status.code() == absl::StatusCode::kDeadlineExceeded) {
     return false;
@@ -157,13 +222,11 @@ bool RemoteTriggerServer::Query() {
   }
 
   // We woke up because we got a request.
-  // If the object was moved or went out of scope, the callback_ might be
+  // If the object was moved or went out of scope, the callback might be
   // invalid.
-  if (callback_ == nullptr) {
+  if (!ExecuteCallback()) {
     return false;
   }
-  // Call the passed in user callback.
-  callback_();
 
   // Notify the caller.
   auto post_status = response_futex_.GetValue().Post();
@@ -178,13 +241,29 @@ bool RemoteTriggerServer::Query() {
   return true;
 }
 
+const WakeupLatencyHistogram* RemoteTriggerServer::WakeupLatencies() const {
+  return wakeup_latencies_.get();
+}
+
+bool RemoteTriggerServer::ExecuteCallback() {
+  if (opcode_callback_ != nullptr && opcodes_.IsValid()) {
+    opcode_callback_(opcodes_.GetValue());
+    return true;
+  }
+  if (callback_ != nullptr) {
+    callback_();
+    return true;
+  }
+  return false;
+}
+
 void RemoteTriggerServer::Run() {
   // Given its asynchronous nature, we have to make sure that the server
   // instance is valid at every point. That is, while the server is running, the
   // object may have been moved and destroyed.
   while (is_running_.load()) {
-    auto wait_status =
-        request_futex_.GetValue().WaitFor(absl::Milliseconds(100));
+    auto wait_status = request_futex_.GetValue().WaitFor(
+        absl::Milliseconds(100), wait_policy_, wakeup_latencies_.get());
     // If we woke up because of timeout, don't execute the callback.
     if (wait_status.code() == absl::StatusCode::kDeadlineExceeded) {
       continue;
@@ -202,14 +281,12 @@ void RemoteTriggerServer::Run() {
     }
 
     // We woke up because we got a request.
-    // If the object was moved or went out of scope, the callback_ might be
+    // If the object was moved or went out of scope, the callback might be
     // invalid.
-    if (callback_ == nullptr) {
+    if (!ExecuteCallback()) {
       Stop();
       return;
     }
-    // Call the passed in user callback.
-    callback_();
 
     // Notify the caller.
     auto post_status = response_futex_.GetValue().Post();
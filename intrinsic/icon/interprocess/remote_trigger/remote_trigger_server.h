@@ -4,13 +4,16 @@
 #define INTRINSIC_ICON_INTERPROCESS_REMOTE_TRIGGER_REMOTE_TRIGGER_SERVER_H_
 
 #include <atomic>
+#include <cstdint>
 #include <functional>
+#include <memory>
 #include <string>
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "intrinsic/icon/interprocess/binary_futex.h"
+#include "intrinsic/icon/interprocess/futex_wait_policy.h"
 #include "intrinsic/icon/interprocess/shared_memory_manager/memory_segment.h"
 #include "intrinsic/icon/interprocess/shared_memory_manager/shared_memory_manager.h"
 #include "intrinsic/util/thread/thread.h"
@@ -19,6 +22,9 @@
 namespace intrinsic::icon {
 
 using RemoteTriggerServerCallback = std::function<void(void)>;
+// Callback of a server that receives a bitmask of opcodes with each request,
+// see `RemoteTriggerServer::CreateWithOpcodes()`.
+using RemoteTriggerServerOpcodeCallback = std::function<void(uint32_t opcodes)>;
 
 // A RemoteTriggerServer listens to incoming requests from a client and executes
 // its callback when a request is issued.
@@ -38,9 +44,28 @@ class RemoteTriggerServer final {
   // Creates a new server instance on a specified server id.
   // When the server is signaled, it executes the callback and signals a
   // response back to the client when done.
+  // `wait_policy` determines how the server waits for requests, e.g. whether
+  // it spins before going to sleep.
+  // If `record_wakeup_latencies` is true, the server records the latencies
+  // returned by `WakeupLatencies()`, which costs the clients a clock read per
+  // request.
   static absl::StatusOr<RemoteTriggerServer> Create(
       const MemoryName& server_memory_name,
-      RemoteTriggerServerCallback&& callback);
+      RemoteTriggerServerCallback&& callback,
+      const FutexWaitPolicy& wait_policy = FutexWaitPolicy::Futex(),
+      bool record_wakeup_latencies = false);
+
+  // Creates a new server instance whose requests carry a bitmask of opcodes.
+  // The client sets the opcodes with
+  // `RemoteTriggerClient::TriggerWithOpcodes()`, which are then passed to the
+  // callback. This allows a single server (and thus a single wake-up and
+  // response per request) to dispatch several operations, instead of one
+  // server per operation.
+  static absl::StatusOr<RemoteTriggerServer> CreateWithOpcodes(
+      const MemoryName& server_memory_name,
+      RemoteTriggerServerOpcodeCallback&& callback,
+      const FutexWaitPolicy& wait_policy = FutexWaitPolicy::Futex(),
+      bool record_wakeup_latencies = false);
 
   // This class is move-only.
   RemoteTriggerServer(const RemoteTriggerServer& other) = delete;
@@ -83,6 +108,11 @@ class RemoteTriggerServer final {
   // Returns true if a callback was triggered, false if not.
   bool Query();
 
+  // Returns the latencies between a client's request and the server waking
+  // up to handle it, or nullptr if the server was created without
+  // `record_wakeup_latencies` or was moved from.
+  const WakeupLatencyHistogram* WakeupLatencies() const;
+
  private:
   // Main loop function.
   // Waits for an incoming trigger sent by a client and calls the provided
@@ -91,14 +121,25 @@ class RemoteTriggerServer final {
   // completed.
   void Run();
 
+  // Executes the callback for the current request.
+  // Returns false if there is no valid callback.
+  bool ExecuteCallback();
+
   RemoteTriggerServer(const MemoryName& server_memory_name,
                       RemoteTriggerServerCallback&& callback,
+                      RemoteTriggerServerOpcodeCallback&& opcode_callback,
                       SharedMemoryManager&& shm_manager,
                       ReadOnlyMemorySegment<BinaryFutex>&& request_futex,
-                      ReadWriteMemorySegment<BinaryFutex>&& response_futex);
+                      ReadWriteMemorySegment<BinaryFutex>&& response_futex,
+                      ReadOnlyMemorySegment<uint32_t>&& opcodes,
+                      const FutexWaitPolicy& wait_policy,
+                      bool record_wakeup_latencies);
 
   MemoryName server_memory_name_;
+  // Exactly one of the two callbacks is set, depending on whether the server
+  // was created with `Create()` or `CreateWithOpcodes()`.
   RemoteTriggerServerCallback callback_;
+  RemoteTriggerServerOpcodeCallback opcode_callback_;
   // initialize to `false`, indicating the system is currently stopped.
   std::atomic<bool> is_running_{false};
   // The interprocess signaling is done via two semaphores shared between a
@@ -106,6 +147,14 @@ class RemoteTriggerServer final {
   SharedMemoryManager shm_manager_;
   ReadOnlyMemorySegment<BinaryFutex> request_futex_;
   ReadWriteMemorySegment<BinaryFutex> response_futex_;
+  // Opcodes of the current request, only valid for servers created with
+  // `CreateWithOpcodes()`. The client writes them before posting the request
+  // futex, which orders the write before the server reads them.
+  ReadOnlyMemorySegment<uint32_t> opcodes_;
+  FutexWaitPolicy wait_policy_;
+  // Heap allocated, so that the histogram stays valid when the server is moved.
+  // Null unless the server records wake-up latencies.
+  std::unique_ptr<WakeupLatencyHistogram> wakeup_latencies_;
 
   intrinsic::Thread async_thread_;
 };
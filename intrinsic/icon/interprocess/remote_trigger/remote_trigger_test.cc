@@ -0,0 +1,117 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "intrinsic/icon/interprocess/futex_wait_policy.h"
+#include "intrinsic/icon/interprocess/remote_trigger/remote_trigger_client.h"
+#include "intrinsic/icon/interprocess/remote_trigger/remote_trigger_server.h"
+#include "intrinsic/icon/interprocess/shared_memory_manager/memory_segment.h"
+#include "intrinsic/util/testing/gtest_wrapper.h"
+
+namespace intrinsic::icon {
+namespace {
+
+// Server names must be unique across concurrently running tests.
+MemoryName UniqueServerName(absl::string_view test) {
+  return MemoryName("", absl::StrCat("remote_trigger_test_", getpid()), test);
+}
+
+TEST(RemoteTriggerTest, TriggersCallback) {
+  const MemoryName name = UniqueServerName("trigger");
+  std::atomic<int> calls = 0;
+  ASSERT_OK_AND_ASSIGN(
+      RemoteTriggerServer server,
+      RemoteTriggerServer::Create(name, [&calls]() { ++calls; }));
+  ASSERT_OK(server.StartAsync());
+  ASSERT_OK_AND_ASSIGN(RemoteTriggerClient client,
+                       RemoteTriggerClient::Create(name));
+
+  EXPECT_TRUE(client.Trigger(absl::Now() + absl::Seconds(10)).ok());
+  EXPECT_TRUE(client.Trigger(absl::Now() + absl::Seconds(10)).ok());
+  EXPECT_EQ(calls, 2);
+
+  // The server doesn't accept opcodes.
+  EXPECT_FALSE(client.SupportsOpcodes());
+  EXPECT_EQ(client.TriggerWithOpcodes(1).code(),
+            absl::StatusCode::kFailedPrecondition);
+  server.Stop();
+}
+
+TEST(RemoteTriggerTest, PassesOpcodesToCallback) {
+  const MemoryName name = UniqueServerName("opcodes");
+  absl::Mutex mutex;
+  std::vector<uint32_t> received;
+  ASSERT_OK_AND_ASSIGN(
+      RemoteTriggerServer server,
+      RemoteTriggerServer::CreateWithOpcodes(
+          name, [&mutex, &received](uint32_t opcodes) {
+            absl::MutexLock lock(&mutex);
+            received.push_back(opcodes);
+          }));
+  ASSERT_OK(server.StartAsync());
+  ASSERT_OK_AND_ASSIGN(RemoteTriggerClient client,
+                       RemoteTriggerClient::Create(name));
+  ASSERT_TRUE(client.SupportsOpcodes());
+
+  const absl::Time deadline = absl::Now() + absl::Seconds(10);
+  EXPECT_TRUE(client.TriggerWithOpcodes(0b01, deadline).ok());
+  EXPECT_TRUE(client.TriggerWithOpcodes(0b11, deadline).ok());
+  EXPECT_TRUE(client.TriggerWithOpcodes(0b10, deadline).ok());
+  server.Stop();
+
+  absl::MutexLock lock(&mutex);
+  EXPECT_EQ(received, (std::vector<uint32_t>{0b01, 0b11, 0b10}));
+}
+
+TEST(RemoteTriggerTest, RecordsWakeupLatenciesOnlyIfRequested) {
+  const MemoryName name = UniqueServerName("latencies");
+  ASSERT_OK_AND_ASSIGN(RemoteTriggerServer server,
+                       RemoteTriggerServer::Create(name, []() {}));
+  ASSERT_OK_AND_ASSIGN(RemoteTriggerClient client,
+                       RemoteTriggerClient::Create(name));
+  EXPECT_EQ(server.WakeupLatencies(), nullptr);
+  EXPECT_EQ(client.WakeupLatencies(), nullptr);
+
+  const MemoryName recording_name = UniqueServerName("recording_latencies");
+  ASSERT_OK_AND_ASSIGN(
+      RemoteTriggerServer recording_server,
+      RemoteTriggerServer::Create(recording_name, []() {},
+                                  FutexWaitPolicy::Futex(),
+                                  /*record_wakeup_latencies=*/true));
+  ASSERT_OK(recording_server.StartAsync());
+  ASSERT_OK_AND_ASSIGN(
+      RemoteTriggerClient recording_client,
+      RemoteTriggerClient::Create(recording_name, /*auto_connect=*/true,
+                                  FutexWaitPolicy::Futex(),
+                                  /*record_wakeup_latencies=*/true));
+  constexpr int kTriggers = 3;
+  for (int i = 0; i < kTriggers; ++i) {
+    EXPECT_TRUE(recording_client.Trigger(absl::Now() + absl::Seconds(10)).ok());
+  }
+  recording_server.Stop();
+
+  ASSERT_NE(recording_server.WakeupLatencies(), nullptr);
+  EXPECT_EQ(recording_server.WakeupLatencies()->Count(), kTriggers);
+  ASSERT_NE(recording_client.WakeupLatencies(), nullptr);
+  EXPECT_EQ(recording_client.WakeupLatencies()->Count(), kTriggers);
+
+  // A moved-from client has no histogram.
+  RemoteTriggerClient moved_client = std::move(recording_client);
+  EXPECT_EQ(recording_client.WakeupLatencies(), nullptr);  // NOLINT
+  EXPECT_NE(moved_client.WakeupLatencies(), nullptr);
+}
+
+}  // namespace
+}  // namespace intrinsic::icon
@@ -30,6 +30,9 @@ absl::StatusOr<SharedMemoryLockstep> GetSharedMemoryLockstep(
     const MemoryName& memory_name) {
   INTR_ASSIGN_OR_RETURN(auto segment,
                         ReadWriteMemorySegment<Lockstep>::Get(memory_name));
+  // Connected() counts the writers, so the handle of a previous incarnation of
+  // a restarted peer must not linger.
+  segment.ReclaimDeadHolders();
   return SharedMemoryLockstep(std::move(segment));
 }
 
@@ -69,6 +69,8 @@ absl::StatusOr<SharedMemoryLockstep> CreateSharedMemoryLockstep(
 // Obtains a SharedMemoryLockstep that is stored in a shared memory segment
 // named `memory_name`. The SharedMemoryManager that created the memory segment
 // must outlive the returned SharedMemoryLockstep.
+// Releases the handles of terminated processes on the segment first, so that a
+// restarted process can connect again.
 absl::StatusOr<SharedMemoryLockstep> GetSharedMemoryLockstep(
     const MemoryName& memory_name);
 
@@ -8,7 +8,10 @@
 #include <stdint.h>
 #include <string.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
 
+#include <cstring>
+#include <optional>
 #include <string>
 #include <utility>
 
@@ -17,7 +20,10 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "intrinsic/icon/interprocess/shared_memory_manager/segment_header.h"
+#include "intrinsic/icon/interprocess/shared_memory_manager/shared_memory_arena.h"
+#include "intrinsic/util/status/status_macros.h"
 
 namespace intrinsic::icon {
 
@@ -33,13 +39,63 @@ const SegmentHeader& MemorySegment::Header() const {
   return *header_;
 }
 
+namespace hal {
+
+std::optional<std::string> ArenaNameForSegment(absl::string_view segment_name) {
+  const size_t delimiter = segment_name.rfind(kDelimiter);
+  if (delimiter == absl::string_view::npos) {
+    return std::nullopt;
+  }
+  std::string arena_name =
+      absl::StrCat(segment_name.substr(0, delimiter), kDelimiter, kArenaName);
+  if (arena_name == segment_name) {
+    return std::nullopt;
+  }
+  return arena_name;
+}
+
+}  // namespace hal
+
 absl::StatusOr<uint8_t*> MemorySegment::Get(const MemoryName& name,
                                             size_t segment_size) {
+  // Modules without an arena are remembered, so that looking up their
+  // segments doesn't open the arena again.
+  const std::optional<std::string> arena_name =
+      hal::ArenaNameForSegment(name.GetName());
+  if (arena_name.has_value()) {
+    INTR_ASSIGN_OR_RETURN(
+        uint8_t* data,
+        FindSharedMemoryArenaSegment(*arena_name, name.GetName(),
+                                     segment_size));
+    if (data != nullptr) {
+      return data;
+    }
+  }
+
   auto shm_fd = shm_open(name.GetName(), O_RDWR, kShmMode);
   if (shm_fd == -1) {
+    const int open_error = errno;
+    if (open_error == ENOENT && arena_name.has_value()) {
+      // The arena may have been created since it was found missing.
+      INTR_ASSIGN_OR_RETURN(
+          uint8_t* data,
+          FindSharedMemoryArenaSegment(*arena_name, name.GetName(),
+                                       segment_size, /*recheck_missing=*/true));
+      if (data != nullptr) {
+        return data;
+      }
+    }
     return absl::InternalError(
         absl::StrCat("Unable to open shared memory segment: ", name.GetName(),
-                     " [", strerror(errno), "]"));
+                     " [", strerror(open_error), "]"));
+  }
+
+  // Segments holding variable sized data (e.g. flatbuffers) can be larger than
+  // the size of their type, so we map the whole segment if possible.
+  struct stat file_attributes;
+  if (fstat(shm_fd, &file_attributes) == 0 &&
+      static_cast<size_t>(file_attributes.st_size) > segment_size) {
+    segment_size = file_attributes.st_size;
   }
 
   uint8_t* data = static_cast<uint8_t*>(mmap(
@@ -72,9 +128,36 @@ MemorySegment::MemorySegment(MemorySegment&& other) noexcept
       header_(std::exchange(other.header_, nullptr)),
       value_(std::exchange(other.value_, nullptr)) {}
 
+int MemorySegment::ReclaimDeadHolders() {
+  const int reclaimed = header_->ReclaimDeadHolders();
+  if (reclaimed > 0) {
+    LOG(INFO) << "Reclaimed " << reclaimed
+              << " references of terminated processes on '" << Name() << "'.";
+  }
+  return reclaimed;
+}
+
 SegmentHeader* MemorySegment::HeaderPointer() { return header_; }
 
 uint8_t* MemorySegment::Value() { return value_; }
 const uint8_t* MemorySegment::Value() const { return value_; }
 
+bool MemorySegment::CopyConsistent(absl::Span<uint8_t> destination,
+                                   int max_attempts) const {
+  for (int attempt = 0; attempt < max_attempts; ++attempt) {
+    const uint64_t sequence = header_->ReadBegin();
+    if ((sequence & 1) != 0) {
+      // A write is in progress; don't bother copying.
+      continue;
+    }
+    // The writer may modify the value while we copy it. That's fine, since
+    // ReadValidate() detects it and we discard the copy.
+    std::memcpy(destination.data(), value_, destination.size());
+    if (header_->ReadValidate(sequence)) {
+      return true;
+    }
+  }
+  return false;
+}
+
 }  // namespace intrinsic::icon
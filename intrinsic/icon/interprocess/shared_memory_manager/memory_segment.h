@@ -6,7 +6,10 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include <cstring>
+#include <optional>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #include "absl/log/check.h"
@@ -25,6 +28,9 @@
 namespace intrinsic::icon {
 namespace hal {
 static constexpr char kDelimiter[] = "__";
+// Segment name of the arena that holds all segments of a module, see
+// `SharedMemoryManager::CreateWithArena()`.
+static constexpr char kArenaName[] = "shm_arena";
 
 // Internal helper to get a list of segment names from a list of memory location
 // names.
@@ -53,6 +59,13 @@ SegmentNamesFromMemoryNames(absl::Span<const std::string> memory_names) {
   return segment_names;
 }
 
+// Returns the name of the arena that holds the segment `segment_name` if its
+// module uses one, i.e. "/<namespace><module>__shm_arena" for
+// "/<namespace><module>__<segment>".
+// Returns std::nullopt if `segment_name` doesn't follow that norm or is the
+// arena itself.
+std::optional<std::string> ArenaNameForSegment(absl::string_view segment_name);
+
 }  // namespace hal
 
 // A strong type for filenames of shared memory segments. Ensures that the
@@ -105,6 +118,14 @@ class MemorySegment {
     HeaderPointer()->UpdatedAt(time, current_cycle);
   }
 
+  // Releases the references that terminated processes still hold on the
+  // segment, see SegmentHeader::ReclaimDeadHolders(). Returns the number of
+  // reclaimed references. Not realtime safe.
+  int ReclaimDeadHolders();
+
+  // Default number of attempts for the seqlock-protected reads below.
+  static constexpr int kDefaultReadAttempts = 16;
+
  protected:
   MemorySegment() = default;
 
@@ -112,6 +133,9 @@ class MemorySegment {
   // Returns a pointer to the untyped memory segment and maps it into
   // user-space. Fails if the shared memory segment with the given name was not
   // previously allocated by the `SharedMemoryManager`.
+  // Segments of a module that uses an arena are looked up in the arena, which
+  // is mapped only once per process. Modules without an arena are remembered
+  // as well, so that their segments cost a single shm_open().
   static absl::StatusOr<uint8_t*> Get(const MemoryName& name, size_t size);
 
   // Returns the SegmentHeader of the shared memory segment.
@@ -121,6 +145,14 @@ class MemorySegment {
   uint8_t* Value();
   const uint8_t* Value() const;
 
+  // Copies the first `destination.size()` bytes of the value into
+  // `destination`, retrying up to `max_attempts` times while a writer modifies
+  // the segment (see SegmentHeader::BeginWrite()). Never blocks the writer and
+  // is realtime safe.
+  // Returns false if no consistent copy could be made, in which case the
+  // contents of `destination` are unspecified.
+  bool CopyConsistent(absl::Span<uint8_t> destination, int max_attempts) const;
+
   MemorySegment(const MemoryName& name, uint8_t* segment);
   MemorySegment(const MemorySegment& other) noexcept;
   MemorySegment& operator=(const MemorySegment& other) noexcept = default;
@@ -170,6 +202,27 @@ class ReadOnlyMemorySegment final : public MemorySegment {
   const T& GetValue() const { return *reinterpret_cast<const T*>(Value()); }
   const uint8_t* GetRawValue() const { return Value(); }
 
+  // Copies the value into `value` such that it is never torn by a concurrent
+  // writer that uses BeginWrite()/EndWrite(). Never blocks the writer.
+  // Returns false if the writer kept modifying the segment for
+  // `max_attempts` attempts.
+  bool ReadConsistentValue(
+      T& value, int max_attempts = kDefaultReadAttempts) const {
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "Consistent reads require a trivially copyable type.");
+    return CopyConsistent(
+        absl::MakeSpan(reinterpret_cast<uint8_t*>(&value), sizeof(T)),
+        max_attempts);
+  }
+
+  // Like ReadConsistentValue, but copies the first `destination.size()` bytes
+  // of the untyped value, e.g. a flatbuffer.
+  bool ReadConsistentRawValue(
+      absl::Span<uint8_t> destination,
+      int max_attempts = kDefaultReadAttempts) const {
+    return CopyConsistent(destination, max_attempts);
+  }
+
  private:
   ReadOnlyMemorySegment(const MemoryName& name, uint8_t* segment)
       : MemorySegment(name, segment) {
@@ -179,13 +232,15 @@ class ReadOnlyMemorySegment final : public MemorySegment {
 
 // Read-Write access to a shared memory segment of type `T`.
 // The Read-Write is thread-compatible, however there is currently no
-// concurrency model implemented, which means that multiple writers are
-// potentially introducing a data race when trying to update the same shared
-// memory segments at the same time. Note that depending on the data type of the
-// shared memory segment, there might also be a race between a single writer and
-// a single reader in which the reader might potentially read an inconsistent
-// value while the writer updates it. It's therefore the application's
-// responsiblity to guarantee a safe execution when featuring multiple writers.
+// concurrency model implemented for multiple writers, which means that multiple
+// writers are potentially introducing a data race when trying to update the
+// same shared memory segments at the same time. It's therefore the
+// application's responsiblity to guarantee a safe execution when featuring
+// multiple writers.
+// A single writer can protect readers from observing half-written values by
+// bracketing modifications with BeginWrite()/EndWrite() (SetValue does this
+// implicitly). Readers then use ReadOnlyMemorySegment::ReadConsistentValue()
+// or ReadConsistentRawValue() to obtain a consistent copy.
 template <class T>
 class ReadWriteMemorySegment final : public MemorySegment {
  public:
@@ -222,7 +277,16 @@ class ReadWriteMemorySegment final : public MemorySegment {
   const uint8_t* GetRawValue() const { return Value(); }
 
   // Updates the value of the shared memory segment.
-  void SetValue(const T& value) { *reinterpret_cast<T*>(Value()) = value; }
+  void SetValue(const T& value) {
+    BeginWrite();
+    *reinterpret_cast<T*>(Value()) = value;
+    EndWrite();
+  }
+
+  // Marks the start and end of a modification through GetValue() or
+  // GetRawValue(). See SegmentHeader::BeginWrite(). Realtime safe.
+  void BeginWrite() { HeaderPointer()->BeginWrite(); }
+  void EndWrite() { HeaderPointer()->EndWrite(); }
 
  private:
   ReadWriteMemorySegment(const MemoryName& name, uint8_t* segment)
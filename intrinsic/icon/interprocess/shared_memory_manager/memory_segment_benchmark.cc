@@ -0,0 +1,96 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+// Measures the overhead of the seqlock that protects shared memory segments,
+// i.e. BeginWrite()/EndWrite() on the writer side and ReadConsistentValue()
+// compared to a plain copy on the reader side.
+//
+// Run with `bazel run -c opt` for meaningful numbers.
+
+#include <unistd.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "absl/log/check.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+#include "intrinsic/icon/interprocess/shared_memory_manager/memory_segment.h"
+#include "intrinsic/icon/interprocess/shared_memory_manager/shared_memory_manager.h"
+
+namespace intrinsic::icon {
+namespace {
+
+template <size_t kSize>
+struct Payload {
+  std::array<uint8_t, kSize> bytes;
+};
+
+template <size_t kSize>
+MemoryName BenchmarkSegmentName() {
+  return MemoryName("", absl::StrCat("memory_segment_benchmark_", getpid()),
+                    absl::StrCat("payload_", kSize));
+}
+
+template <size_t kSize>
+void BM_SetValue(benchmark::State& state) {
+  SharedMemoryManager manager;
+  const MemoryName name = BenchmarkSegmentName<kSize>();
+  CHECK_OK(manager.AddSegmentWithDefaultValue<Payload<kSize>>(
+      name, /*must_be_used=*/false));
+  auto writer = ReadWriteMemorySegment<Payload<kSize>>::Get(name);
+  CHECK_OK(writer.status());
+  Payload<kSize> payload = {};
+  for (auto _ : state) {
+    ++payload.bytes[0];
+    writer->SetValue(payload);
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * kSize);
+}
+
+template <size_t kSize>
+void BM_PlainRead(benchmark::State& state) {
+  SharedMemoryManager manager;
+  const MemoryName name = BenchmarkSegmentName<kSize>();
+  CHECK_OK(manager.AddSegmentWithDefaultValue<Payload<kSize>>(
+      name, /*must_be_used=*/false));
+  auto reader = ReadOnlyMemorySegment<Payload<kSize>>::Get(name);
+  CHECK_OK(reader.status());
+  Payload<kSize> copy;
+  for (auto _ : state) {
+    copy = reader->GetValue();
+    benchmark::DoNotOptimize(copy);
+  }
+  state.SetBytesProcessed(state.iterations() * kSize);
+}
+
+template <size_t kSize>
+void BM_ReadConsistentValue(benchmark::State& state) {
+  SharedMemoryManager manager;
+  const MemoryName name = BenchmarkSegmentName<kSize>();
+  CHECK_OK(manager.AddSegmentWithDefaultValue<Payload<kSize>>(
+      name, /*must_be_used=*/false));
+  auto reader = ReadOnlyMemorySegment<Payload<kSize>>::Get(name);
+  CHECK_OK(reader.status());
+  Payload<kSize> copy;
+  for (auto _ : state) {
+    bool success = reader->ReadConsistentValue(copy);
+    benchmark::DoNotOptimize(success);
+    benchmark::DoNotOptimize(copy);
+  }
+  state.SetBytesProcessed(state.iterations() * kSize);
+}
+
+BENCHMARK(BM_SetValue<64>);
+BENCHMARK(BM_SetValue<1024>);
+BENCHMARK(BM_SetValue<16384>);
+BENCHMARK(BM_PlainRead<64>);
+BENCHMARK(BM_PlainRead<1024>);
+BENCHMARK(BM_PlainRead<16384>);
+BENCHMARK(BM_ReadConsistentValue<64>);
+BENCHMARK(BM_ReadConsistentValue<1024>);
+BENCHMARK(BM_ReadConsistentValue<16384>);
+
+}  // namespace
+}  // namespace intrinsic::icon
@@ -0,0 +1,161 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/icon/interprocess/shared_memory_manager/memory_segment.h"
+
+#include <gtest/gtest.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "intrinsic/icon/interprocess/shared_memory_manager/shared_memory_manager.h"
+#include "intrinsic/util/testing/gtest_wrapper.h"
+
+namespace intrinsic::icon {
+namespace {
+
+// A payload that spans several cache lines. Every writer update sets all
+// entries to the same value, so a torn read shows up as differing entries.
+struct Payload {
+  std::array<uint64_t, 64> values;
+};
+
+bool IsConsistent(const Payload& payload) {
+  for (uint64_t value : payload.values) {
+    if (value != payload.values[0]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Segment names must be unique across concurrently running tests.
+MemoryName UniqueName(absl::string_view operation) {
+  return MemoryName("", absl::StrCat("memory_segment_test_", getpid()),
+                    operation);
+}
+
+TEST(MemorySegmentTest, ReadsLastWrittenValue) {
+  SharedMemoryManager manager;
+  const MemoryName name = UniqueName("last_written");
+  ASSERT_OK(manager.AddSegmentWithDefaultValue<Payload>(name,
+                                                        /*must_be_used=*/false));
+  ASSERT_OK_AND_ASSIGN(auto writer,
+                       ReadWriteMemorySegment<Payload>::Get(name));
+  ASSERT_OK_AND_ASSIGN(auto reader, ReadOnlyMemorySegment<Payload>::Get(name));
+  EXPECT_EQ(reader.Header().PayloadSize(), sizeof(Payload));
+
+  const uint64_t version_before = reader.Header().WriteVersion();
+  Payload payload;
+  payload.values.fill(42);
+  writer.SetValue(payload);
+  EXPECT_EQ(reader.Header().WriteVersion(), version_before + 1);
+
+  Payload copy;
+  ASSERT_TRUE(reader.ReadConsistentValue(copy));
+  EXPECT_EQ(copy.values, payload.values);
+}
+
+TEST(MemorySegmentTest, ReadFailsWhileWriteIsInProgress) {
+  SharedMemoryManager manager;
+  const MemoryName name = UniqueName("in_progress");
+  ASSERT_OK(manager.AddSegmentWithDefaultValue<Payload>(name,
+                                                        /*must_be_used=*/false));
+  ASSERT_OK_AND_ASSIGN(auto writer,
+                       ReadWriteMemorySegment<Payload>::Get(name));
+  ASSERT_OK_AND_ASSIGN(auto reader, ReadOnlyMemorySegment<Payload>::Get(name));
+
+  Payload copy;
+  writer.BeginWrite();
+  writer.GetValue().values.fill(1);
+  EXPECT_FALSE(reader.ReadConsistentValue(copy, /*max_attempts=*/4));
+  writer.EndWrite();
+  ASSERT_TRUE(reader.ReadConsistentValue(copy, /*max_attempts=*/1));
+  EXPECT_EQ(copy.values[0], 1);
+}
+
+TEST(MemorySegmentTest, ReadsRawValue) {
+  SharedMemoryManager manager;
+  const MemoryName name = UniqueName("raw");
+  constexpr size_t kSize = 100;
+  ASSERT_OK(manager.AddSegment(name, /*must_be_used=*/false, kSize));
+  ASSERT_OK_AND_ASSIGN(auto writer,
+                       ReadWriteMemorySegment<uint8_t>::Get(name));
+  ASSERT_OK_AND_ASSIGN(auto reader, ReadOnlyMemorySegment<uint8_t>::Get(name));
+  EXPECT_EQ(reader.Header().PayloadSize(), kSize);
+
+  writer.BeginWrite();
+  for (size_t i = 0; i < kSize; ++i) {
+    writer.GetRawValue()[i] = static_cast<uint8_t>(i);
+  }
+  writer.EndWrite();
+
+  std::array<uint8_t, kSize> copy;
+  ASSERT_TRUE(reader.ReadConsistentRawValue(absl::MakeSpan(copy)));
+  EXPECT_EQ(copy[kSize - 1], kSize - 1);
+}
+
+// Runs one writer and several reader processes against the same segment and
+// checks that no reader ever observes a torn value.
+TEST(MemorySegmentTest, ConcurrentProcessesNeverObserveTornValues) {
+  constexpr int kNumReaders = 3;
+  constexpr uint64_t kNumWrites = 20000;
+  // Exit codes of the reader processes.
+  constexpr int kTornRead = 1;
+  constexpr int kSegmentError = 2;
+
+  SharedMemoryManager manager;
+  const MemoryName name = UniqueName("stress");
+  ASSERT_OK(manager.AddSegmentWithDefaultValue<Payload>(name,
+                                                        /*must_be_used=*/false));
+
+  std::vector<pid_t> readers;
+  for (int r = 0; r < kNumReaders; ++r) {
+    const pid_t pid = fork();
+    ASSERT_NE(pid, -1);
+    if (pid == 0) {
+      auto reader = ReadOnlyMemorySegment<Payload>::Get(name);
+      if (!reader.ok()) {
+        _exit(kSegmentError);
+      }
+      // Reads until the final value shows up. A failed attempt only means
+      // that the writer was busy; the copy must never be inconsistent when the
+      // read reports success.
+      Payload copy;
+      copy.values.fill(0);
+      while (copy.values[0] != kNumWrites) {
+        if (reader->ReadConsistentValue(copy) && !IsConsistent(copy)) {
+          _exit(kTornRead);
+        }
+      }
+      _exit(0);
+    }
+    readers.push_back(pid);
+  }
+
+  {
+    ASSERT_OK_AND_ASSIGN(auto writer,
+                         ReadWriteMemorySegment<Payload>::Get(name));
+    for (uint64_t i = 1; i <= kNumWrites; ++i) {
+      writer.BeginWrite();
+      for (uint64_t& value : writer.GetValue().values) {
+        value = i;
+      }
+      writer.EndWrite();
+    }
+  }
+
+  for (pid_t pid : readers) {
+    int status = 0;
+    ASSERT_EQ(waitpid(pid, &status, 0), pid);
+    ASSERT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 0) << "Reader process " << pid << " failed";
+  }
+}
+
+}  // namespace
+}  // namespace intrinsic::icon
@@ -2,81 +2,289 @@
 
 #include "intrinsic/icon/interprocess/shared_memory_manager/segment_header.h"
 
-#include <semaphore.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
 
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
 #include <initializer_list>
 #include <limits>
 #include <string>
 
 #include "absl/log/log.h"
+#include "absl/strings/str_cat.h"
 #include "intrinsic/icon/utils/clock.h"
 #include "intrinsic/icon/utils/log.h"
 
 namespace intrinsic::icon {
 namespace {
-void IncrementRefCount(int& counter, sem_t* mutex) {
-  sem_wait(mutex);
-  ++counter;
-  sem_post(mutex);
+
+// Marks a ProcessRefCount entry that is being reclaimed.
+constexpr uint64_t kReclaimingHolder = ~uint64_t{0};
+
+// Identifies a process across PID namespaces and PID reuse.
+struct ProcessIdentity {
+  pid_t pid = 0;
+  // Inode of the PID namespace that `pid` belongs to, 0 if unknown.
+  uint64_t pid_namespace = 0;
+  // Start time of the process in clock ticks since boot, 0 if unknown.
+  uint64_t start_time = 0;
+  // Combines the fields above. Never 0 or kReclaimingHolder.
+  uint64_t holder = 0;
+};
+
+// Returns the start time of a process from the contents of its
+// /proc/<pid>/stat file, or 0 if it can't be parsed.
+uint64_t ParseStartTime(const char* stat, size_t size) {
+  // The second field is the command name in parentheses, which may contain
+  // spaces and parentheses itself, so the fields are counted from the last
+  // closing parenthesis.
+  size_t i = size;
+  while (i > 0 && stat[i - 1] != ')') {
+    --i;
+  }
+  if (i == 0) {
+    return 0;
+  }
+  // The start time is the 22nd field.
+  for (int field = 2; i < size && field < 22; ++i) {
+    if (stat[i] == ' ') {
+      ++field;
+    }
+  }
+  uint64_t start_time = 0;
+  for (; i < size && stat[i] >= '0' && stat[i] <= '9'; ++i) {
+    start_time = start_time * 10 + (stat[i] - '0');
+  }
+  return start_time;
 }
 
-void DecrementRefCount(int& counter, sem_t* mutex) {
-  sem_wait(mutex);
-  // A reference counter can't be lower than zero.
-  if (counter > 0) {
-    --counter;
+// Reads the start time from the /proc/<pid>/stat file at `path`. Returns 0 and
+// sets errno if the file can't be read. Async-signal-safe.
+uint64_t ReadStartTime(const char* path) {
+  const int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    return 0;
+  }
+  char stat[1024];
+  const ssize_t size = read(fd, stat, sizeof(stat));
+  close(fd);
+  return size > 0 ? ParseStartTime(stat, static_cast<size_t>(size)) : 0;
+}
+
+uint64_t Mix(uint64_t value) {
+  // The finalizer of SplitMix64.
+  value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9;
+  value = (value ^ (value >> 27)) * 0x94d049bb133111eb;
+  return value ^ (value >> 31);
+}
+
+// getpid() is a system call and the namespace and start time are read from
+// /proc, so the identity is cached and refreshed in the child after fork().
+ProcessIdentity cached_identity;
+
+// Async-signal-safe, as required after fork().
+void RefreshCachedIdentity() {
+  ProcessIdentity identity;
+  identity.pid = getpid();
+  struct stat namespace_attributes;
+  if (stat("/proc/self/ns/pid", &namespace_attributes) == 0) {
+    identity.pid_namespace = namespace_attributes.st_ino;
+  }
+  identity.start_time = ReadStartTime("/proc/self/stat");
+  identity.holder =
+      Mix(identity.pid_namespace ^
+          Mix(static_cast<uint64_t>(identity.pid) ^ Mix(identity.start_time)));
+  if (identity.holder == 0 || identity.holder == kReclaimingHolder) {
+    identity.holder = 1;
+  }
+  cached_identity = identity;
+}
+
+const ProcessIdentity& CurrentIdentity() {
+  static const bool kRegistered = [] {
+    RefreshCachedIdentity();
+    pthread_atfork(/*prepare=*/nullptr, /*parent=*/nullptr,
+                   /*child=*/&RefreshCachedIdentity);
+    return true;
+  }();
+  (void)kRegistered;
+  return cached_identity;
+}
+
+// Returns false if the process with `pid` and `start_time` in `pid_namespace`
+// no longer exists. Returns true if that is unknown, e.g. because the process
+// is in another PID namespace.
+bool ProcessIsAlive(pid_t pid, uint64_t pid_namespace, uint64_t start_time) {
+  if (pid <= 0 || pid_namespace == 0 ||
+      pid_namespace != CurrentIdentity().pid_namespace) {
+    return true;
+  }
+  const std::string path = absl::StrCat("/proc/", pid, "/stat");
+  errno = 0;
+  const uint64_t current_start_time = ReadStartTime(path.c_str());
+  if (current_start_time == 0) {
+    // The process doesn't exist, unless /proc is unreadable otherwise.
+    return errno != ENOENT && errno != ESRCH;
+  }
+  // A different start time means that the PID was reused by a new process.
+  return start_time == 0 || current_start_time == start_time;
+}
+
+// Decrements `counter` by up to `amount` without going below zero.
+void SaturatingSubtract(std::atomic<int32_t>& counter, int32_t amount) {
+  int32_t value = counter.load(std::memory_order_relaxed);
+  while (value > 0 && !counter.compare_exchange_weak(
+                          value, value > amount ? value - amount : 0,
+                          std::memory_order_acq_rel,
+                          std::memory_order_relaxed)) {
   }
-  sem_post(mutex);
 }
+
 }  // namespace
 
 SegmentHeader::SegmentHeader() noexcept : SegmentHeader("UNDEFINED") {}
 
-SegmentHeader::SegmentHeader(const std::string& type_id) noexcept
-    : type_info_(TypeInfo(type_id)), flags_(0) {
-  // Initialize the unnamed semaphore as process-shared by setting second
-  // argument to non-zero. See
-  // https://man7.org/linux/man-pages/man3/sem_init.3.html for details.
-  // We can feature an unnamed semaphore here as this header information will
-  // be part of the shared memory segment and thus shared between multiple
-  // processes.
-  sem_init(&mutex_, 1, 1);
-}
+SegmentHeader::SegmentHeader(const std::string& type_id,
+                             size_t payload_size) noexcept
+    : type_info_(TypeInfo(type_id)), flags_(0), payload_size_(payload_size) {}
 
 SegmentHeader::SegmentHeader(const std::string& type_id,
-                             const std::initializer_list<Flags>& flags) noexcept
-    : SegmentHeader(type_id) {
+                             const std::initializer_list<Flags>& flags,
+                             size_t payload_size) noexcept
+    : SegmentHeader(type_id, payload_size) {
   for (const auto flag : flags) {
     flags_.set(static_cast<int>(flag));
   }
 }
 
 SegmentHeader::~SegmentHeader() noexcept {
-  if (ref_count_reader_ != 0 || ref_count_writer_ != 0) {
+  const int ref_count = ReaderRefCount() + WriterRefCount();
+  if (ref_count != 0) {
     LOG(WARNING) << "Shared memory segment cleaned up while being used by "
-                 << (ref_count_reader_ + ref_count_writer_)
-                 << " other entities.";
+                 << ref_count << " other entities.";
   }
 
   flags_.reset();
-  sem_destroy(&mutex_);
 }
 
-int SegmentHeader::ReaderRefCount() const { return ref_count_reader_; }
+int SegmentHeader::ReaderRefCount() const {
+  return ref_count_reader_.load(std::memory_order_acquire);
+}
 void SegmentHeader::IncrementReaderRefCount() {
-  IncrementRefCount(ref_count_reader_, &mutex_);
+  IncrementRefCount(Role::kReader);
 }
 void SegmentHeader::DecrementReaderRefCount() {
-  DecrementRefCount(ref_count_reader_, &mutex_);
+  DecrementRefCount(Role::kReader);
 }
 
-int SegmentHeader::WriterRefCount() const { return ref_count_writer_; }
+int SegmentHeader::WriterRefCount() const {
+  return ref_count_writer_.load(std::memory_order_acquire);
+}
 void SegmentHeader::IncrementWriterRefCount() {
-  return IncrementRefCount(ref_count_writer_, &mutex_);
+  IncrementRefCount(Role::kWriter);
 }
 void SegmentHeader::DecrementWriterRefCount() {
-  return DecrementRefCount(ref_count_writer_, &mutex_);
+  DecrementRefCount(Role::kWriter);
+}
+
+SegmentHeader::ProcessRefCount* SegmentHeader::FindOrClaimProcessEntry() {
+  const ProcessIdentity& identity = CurrentIdentity();
+  for (ProcessRefCount& entry : process_ref_counts_) {
+    if (entry.holder.load(std::memory_order_acquire) == identity.holder) {
+      return &entry;
+    }
+  }
+  // Entries are only released by ReclaimDeadHolders(), so two threads of the
+  // same process may race to claim two different entries. That is harmless,
+  // the references of a process are simply spread over both.
+  for (ProcessRefCount& entry : process_ref_counts_) {
+    uint64_t unused = 0;
+    if (entry.holder.compare_exchange_strong(unused, identity.holder,
+                                             std::memory_order_acq_rel)) {
+      entry.pid.store(identity.pid, std::memory_order_relaxed);
+      entry.start_time.store(identity.start_time, std::memory_order_relaxed);
+      entry.pid_namespace.store(identity.pid_namespace,
+                                std::memory_order_release);
+      return &entry;
+    }
+  }
+  return nullptr;
+}
+
+SegmentHeader::ProcessRefCount* SegmentHeader::FindProcessEntryWithRef(
+    Role role) {
+  const uint64_t holder = CurrentIdentity().holder;
+  for (ProcessRefCount& entry : process_ref_counts_) {
+    if (entry.holder.load(std::memory_order_acquire) != holder) {
+      continue;
+    }
+    const auto& count = role == Role::kReader ? entry.reader : entry.writer;
+    if (count.load(std::memory_order_relaxed) > 0) {
+      return &entry;
+    }
+  }
+  return nullptr;
+}
+
+void SegmentHeader::IncrementRefCount(Role role) {
+  if (ProcessRefCount* entry = FindOrClaimProcessEntry(); entry != nullptr) {
+    (role == Role::kReader ? entry->reader : entry->writer)
+        .fetch_add(1, std::memory_order_relaxed);
+  }
+  (role == Role::kReader ? ref_count_reader_ : ref_count_writer_)
+      .fetch_add(1, std::memory_order_acq_rel);
+}
+
+void SegmentHeader::DecrementRefCount(Role role) {
+  // The entry may be missing, e.g. for handles that were inherited through
+  // fork() or if the process was not tracked.
+  if (ProcessRefCount* entry = FindProcessEntryWithRef(role);
+      entry != nullptr) {
+    SaturatingSubtract(role == Role::kReader ? entry->reader : entry->writer,
+                       1);
+  }
+  // A reference counter can't be lower than zero.
+  SaturatingSubtract(
+      role == Role::kReader ? ref_count_reader_ : ref_count_writer_, 1);
+}
+
+int SegmentHeader::ReclaimDeadHolders() {
+  int reclaimed = 0;
+  for (ProcessRefCount& entry : process_ref_counts_) {
+    uint64_t holder = entry.holder.load(std::memory_order_acquire);
+    if (holder == 0 || holder == kReclaimingHolder) {
+      continue;
+    }
+    const uint64_t pid_namespace =
+        entry.pid_namespace.load(std::memory_order_acquire);
+    if (ProcessIsAlive(entry.pid.load(std::memory_order_relaxed),
+                       pid_namespace,
+                       entry.start_time.load(std::memory_order_relaxed))) {
+      continue;
+    }
+    // Only one reclaiming process gets to move the entry out of the way. This
+    // also fails if the entry was reclaimed and claimed again meanwhile.
+    if (!entry.holder.compare_exchange_strong(holder, kReclaimingHolder,
+                                              std::memory_order_acq_rel)) {
+      continue;
+    }
+    const int32_t reader = entry.reader.exchange(0, std::memory_order_acq_rel);
+    const int32_t writer = entry.writer.exchange(0, std::memory_order_acq_rel);
+    SaturatingSubtract(ref_count_reader_, reader);
+    SaturatingSubtract(ref_count_writer_, writer);
+    entry.pid_namespace.store(0, std::memory_order_relaxed);
+    entry.start_time.store(0, std::memory_order_relaxed);
+    entry.pid.store(0, std::memory_order_relaxed);
+    entry.holder.store(0, std::memory_order_release);
+    reclaimed += reader + writer;
+  }
+  return reclaimed;
 }
 
 SegmentHeader::TypeInfo SegmentHeader::Type() const { return type_info_; }
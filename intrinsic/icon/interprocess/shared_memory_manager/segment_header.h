@@ -3,9 +3,11 @@
 #ifndef INTRINSIC_ICON_INTERPROCESS_SHARED_MEMORY_MANAGER_SEGMENT_HEADER_H_
 #define INTRINSIC_ICON_INTERPROCESS_SHARED_MEMORY_MANAGER_SEGMENT_HEADER_H_
 
-#include <semaphore.h>
 #include <stddef.h>
+#include <sys/types.h>
 
+#include <array>
+#include <atomic>
 #include <bitset>
 #include <cstdint>
 #include <cstring>
@@ -30,6 +32,20 @@ namespace intrinsic::icon {
 //
 // The SegmentHeader class is aligned to 64bit in order to guarantee a valid
 // data representation across different platforms.
+//
+// Besides the metadata, the header holds a seqlock-style write sequence that
+// lets readers in other processes copy the payload without ever blocking the
+// (realtime) writer:
+//
+//  * The writer brackets every modification of the payload with
+//    `BeginWrite()` and `EndWrite()`. The sequence is odd while a write is in
+//    progress.
+//  * A reader calls `ReadBegin()`, copies the payload and then calls
+//    `ReadValidate()` with the sequence it got from `ReadBegin()`. If that
+//    returns false, the copy may be torn and has to be retried.
+//
+// Segments whose writer never calls `BeginWrite()` keep an even sequence, so
+// readers always validate successfully, just like before the sequence existed.
 class alignas(64) SegmentHeader final {
  public:
   // The TypeInfo class contains convenience functions around the type string
@@ -74,17 +90,33 @@ class alignas(64) SegmentHeader final {
     kExclusiveOwnership = 0,
   };
 
-  // The SegmentHeader class is move-only.
+  // The SegmentHeader class is neither copyable nor movable; it is constructed
+  // in place in shared memory.
   SegmentHeader() noexcept;
-  explicit SegmentHeader(const std::string& type_id) noexcept;
+  explicit SegmentHeader(const std::string& type_id,
+                         size_t payload_size = 0) noexcept;
   SegmentHeader(const std::string& type_id,
-                const std::initializer_list<Flags>& flags) noexcept;
+                const std::initializer_list<Flags>& flags,
+                size_t payload_size = 0) noexcept;
   SegmentHeader(const SegmentHeader& other) noexcept = delete;
   SegmentHeader& operator=(const SegmentHeader& other) noexcept = delete;
-  SegmentHeader(SegmentHeader&& other) noexcept = default;
+  SegmentHeader(SegmentHeader&& other) noexcept = delete;
   SegmentHeader& operator=(SegmentHeader&& other) noexcept = delete;
   ~SegmentHeader() noexcept;
 
+  // The reference counts below are lock-free atomics, so copying or destroying
+  // a handle never blocks, even if another process crashed while holding one.
+  // Additionally, the counts are attributed to the holding process (for up to
+  // `kMaxTrackedProcesses` processes) so that references of processes that
+  // terminated without releasing them can be reclaimed with
+  // `ReclaimDeadHolders()`. A holding process is identified by its PID, its
+  // PID namespace and its start time, so that neither equal PIDs in different
+  // containers nor reused PIDs are mistaken for each other.
+
+  // Maximum number of processes whose references can be reclaimed. References
+  // of additional processes are still counted, but never reclaimed.
+  static constexpr size_t kMaxTrackedProcesses = 32;
+
   // Gets the current reference count of read-only access handles.
   int ReaderRefCount() const;
   // Increments the current reference count of read-only access handles.
@@ -99,9 +131,23 @@ class alignas(64) SegmentHeader final {
   // Decrements the current reference count of writer access handles.
   void DecrementWriterRefCount();
 
+  // Releases all references held by processes that no longer exist, e.g.
+  // because they crashed. Returns the number of reclaimed references.
+  // Only reclaims the references of processes in the PID namespace of the
+  // calling process, since the others can't be checked. Not realtime safe.
+  //
+  // This is not done implicitly when a segment is opened. Call it on restart
+  // paths, where the references of a previous incarnation would otherwise
+  // linger, see e.g. GetSharedMemoryLockstep().
+  int ReclaimDeadHolders();
+
   // Returns the type information for this segment.
   TypeInfo Type() const;
 
+  // Returns the size of the payload following this header in bytes. Returns 0
+  // if the creator of the segment did not specify it.
+  size_t PayloadSize() const { return payload_size_; }
+
   // Queries if a specified flag is set.
   bool FlagIsSet(Flags flag) const;
 
@@ -124,14 +170,51 @@ class alignas(64) SegmentHeader final {
   // 'current_cycle' is the control cycle that the segment was updated.
   void UpdatedAt(Time time, uint64_t current_cycle);
 
+  // Marks the start of a modification of the payload. Must be followed by
+  // `EndWrite()`. Only a single writer may modify the payload at a time.
+  // Realtime safe and wait-free.
+  void BeginWrite() {
+    const uint64_t sequence = write_sequence_.load(std::memory_order_relaxed);
+    write_sequence_.store(sequence + 1, std::memory_order_relaxed);
+    // Orders the odd sequence before any of the following payload stores.
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  // Marks the end of a modification of the payload that was started with
+  // `BeginWrite()`. Realtime safe and wait-free.
+  void EndWrite() {
+    const uint64_t sequence = write_sequence_.load(std::memory_order_relaxed);
+    write_sequence_.store(sequence + 1, std::memory_order_release);
+  }
+
+  // Returns the write sequence to pass to `ReadValidate()` after copying the
+  // payload. An odd value means that a write is in progress, in which case
+  // `ReadValidate()` is guaranteed to fail.
+  uint64_t ReadBegin() const {
+    return write_sequence_.load(std::memory_order_acquire);
+  }
+
+  // Returns true if no write happened since `ReadBegin()` returned `sequence`,
+  // i.e. if the payload copied in between is consistent.
+  bool ReadValidate(uint64_t sequence) const {
+    // Orders the payload loads before the sequence load below.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return (sequence & 1) == 0 &&
+           write_sequence_.load(std::memory_order_relaxed) == sequence;
+  }
+
+  // Returns the number of completed writes, i.e. the version of the payload.
+  uint64_t WriteVersion() const { return ReadBegin() / 2; }
+
   // The expected version of the SegmentHeader not stored in shared memory.
   static constexpr size_t ExpectedVersion() {
     // Version of the SegmentHeader.
     // Increment on changes that break backwards compatibility. E.g. if the size
-    // of the members changes.
+    // of the members changes, or the layout of a type that is shared through
+    // segments, like BinaryFutex.
     // Is static to compare the expected version to the version in the shared
     // memory segment.
-    return 2;
+    return 6;
   }
 
   // The version of the SegmentHeader as stored in shared memory.
@@ -141,16 +224,49 @@ class alignas(64) SegmentHeader final {
   // See go/totw/135.
   friend class SegmentHeaderTestPeer;
 
+  // The references held by a single process.
+  struct ProcessRefCount {
+    // Identifies the holding process, 0 for an unused entry. Combines the
+    // fields below.
+    std::atomic<uint64_t> holder = 0;
+    // Inode of the PID namespace of the holder, 0 while unknown. Set after
+    // `pid` and `start_time`, so that those are valid once this is set.
+    std::atomic<uint64_t> pid_namespace = 0;
+    // Start time of the holder in clock ticks since boot, 0 if unknown.
+    std::atomic<uint64_t> start_time = 0;
+    std::atomic<pid_t> pid = 0;
+    std::atomic<int32_t> reader = 0;
+    std::atomic<int32_t> writer = 0;
+  };
+
+  enum class Role { kReader, kWriter };
+
+  // Returns the entry for the calling process, claiming an unused one if
+  // needed. Returns nullptr if all entries are taken by other processes.
+  ProcessRefCount* FindOrClaimProcessEntry();
+  // Returns an entry of the calling process that holds a reference of `role`,
+  // or nullptr if there is none.
+  ProcessRefCount* FindProcessEntryWithRef(Role role);
+
+  void IncrementRefCount(Role role);
+  void DecrementRefCount(Role role);
+
   // Initializes a new shared memory segment with the expected version.
   const size_t kVersion = ExpectedVersion();
-  // Unnamed process-shared semaphore to protect header modifications.
-  mutable sem_t mutex_;
+
+  // Lock-free atomics are address-free and thus safe to use across processes.
+  static_assert(std::atomic<int32_t>::is_always_lock_free);
+  static_assert(std::atomic<pid_t>::is_always_lock_free);
+  static_assert(std::atomic<uint64_t>::is_always_lock_free);
 
   // A reference counter on read-only access handles.
-  int ref_count_reader_ = 0;
+  std::atomic<int32_t> ref_count_reader_ = 0;
 
   // A reference counter on writer access handles.
-  int ref_count_writer_ = 0;
+  std::atomic<int32_t> ref_count_writer_ = 0;
+
+  // Per-process breakdown of the counters above.
+  std::array<ProcessRefCount, kMaxTrackedProcesses> process_ref_counts_;
 
   // The type information associated with that segment.
   TypeInfo type_info_;
@@ -158,6 +274,13 @@ class alignas(64) SegmentHeader final {
   // Bitmask for single bit flags.
   std::bitset<8> flags_;
 
+  // Size of the payload in bytes.
+  size_t payload_size_ = 0;
+
+  // Seqlock sequence for the payload, see `BeginWrite()` and `ReadBegin()`.
+  static_assert(std::atomic<uint64_t>::is_always_lock_free);
+  std::atomic<uint64_t> write_sequence_ = 0;
+
   // Time for the last time the segment was updated. This is used to detect
   // stale information in segments.
   //
@@ -184,7 +307,8 @@ class alignas(64) SegmentHeader final {
 
 template <class T>
 struct SegmentTraits {
-  static constexpr size_t kSegmentSize = sizeof(SegmentHeader) + sizeof(T);
+  static constexpr size_t kPayloadSize = sizeof(T);
+  static constexpr size_t kSegmentSize = sizeof(SegmentHeader) + kPayloadSize;
   static constexpr size_t kDataOffset = sizeof(SegmentHeader);
 };
 
@@ -0,0 +1,199 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/icon/interprocess/shared_memory_manager/segment_header.h"
+
+#include <gtest/gtest.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "intrinsic/util/testing/gtest_wrapper.h"
+#include "intrinsic/util/thread/thread.h"
+
+namespace intrinsic::icon {
+
+class SegmentHeaderTestPeer {
+ public:
+  // Overwrites what identifies the process `pid` in its entry of `header`.
+  static void SetIdentity(SegmentHeader& header, pid_t pid,
+                          uint64_t pid_namespace, uint64_t start_time) {
+    for (SegmentHeader::ProcessRefCount& entry : header.process_ref_counts_) {
+      if (entry.pid.load() == pid) {
+        entry.start_time.store(start_time);
+        entry.pid_namespace.store(pid_namespace);
+      }
+    }
+  }
+
+  // Returns the identity stored for process `pid` in `header`, or {0, 0}.
+  static std::pair<uint64_t, uint64_t> GetIdentity(const SegmentHeader& header,
+                                                   pid_t pid) {
+    for (const SegmentHeader::ProcessRefCount& entry :
+         header.process_ref_counts_) {
+      if (entry.pid.load() == pid) {
+        return {entry.pid_namespace.load(), entry.start_time.load()};
+      }
+    }
+    return {0, 0};
+  }
+};
+
+namespace {
+
+// Allocates a SegmentHeader in anonymous shared memory, so that it is shared
+// with forked child processes.
+class SharedSegmentHeader {
+ public:
+  SharedSegmentHeader() {
+    memory_ = mmap(nullptr, sizeof(SegmentHeader), PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    CHECK(memory_ != MAP_FAILED);
+    header_ = new (memory_) SegmentHeader("test");
+  }
+  ~SharedSegmentHeader() {
+    header_->~SegmentHeader();
+    munmap(memory_, sizeof(SegmentHeader));
+  }
+
+  SegmentHeader* operator->() { return header_; }
+  SegmentHeader& operator*() { return *header_; }
+
+ private:
+  void* memory_;
+  SegmentHeader* header_;
+};
+
+TEST(SegmentHeaderTest, CountsReferences) {
+  SharedSegmentHeader header;
+  header->IncrementReaderRefCount();
+  header->IncrementReaderRefCount();
+  header->IncrementWriterRefCount();
+  EXPECT_EQ(header->ReaderRefCount(), 2);
+  EXPECT_EQ(header->WriterRefCount(), 1);
+
+  header->DecrementReaderRefCount();
+  header->DecrementWriterRefCount();
+  // A reference counter can't be lower than zero.
+  header->DecrementWriterRefCount();
+  EXPECT_EQ(header->ReaderRefCount(), 1);
+  EXPECT_EQ(header->WriterRefCount(), 0);
+
+  // References of live processes are never reclaimed.
+  EXPECT_EQ(header->ReclaimDeadHolders(), 0);
+  EXPECT_EQ(header->ReaderRefCount(), 1);
+}
+
+TEST(SegmentHeaderTest, ConcurrentIncrementsAndDecrementsBalance) {
+  constexpr int kNumThreads = 4;
+  constexpr int kIterations = 10000;
+  SharedSegmentHeader header;
+
+  std::vector<intrinsic::Thread> threads;
+  for (int t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&header]() {
+      for (int i = 0; i < kIterations; ++i) {
+        header->IncrementReaderRefCount();
+        header->IncrementWriterRefCount();
+        header->DecrementReaderRefCount();
+        header->DecrementWriterRefCount();
+      }
+    });
+  }
+  for (intrinsic::Thread& thread : threads) {
+    thread.Join();
+  }
+  EXPECT_EQ(header->ReaderRefCount(), 0);
+  EXPECT_EQ(header->WriterRefCount(), 0);
+}
+
+TEST(SegmentHeaderTest, ReclaimsReferencesOfTerminatedProcesses) {
+  SharedSegmentHeader header;
+  header->IncrementWriterRefCount();
+
+  // The child takes references and terminates without releasing them, just
+  // like a crashing process.
+  const pid_t pid = fork();
+  ASSERT_NE(pid, -1);
+  if (pid == 0) {
+    header->IncrementReaderRefCount();
+    header->IncrementReaderRefCount();
+    header->IncrementWriterRefCount();
+    _exit(0);
+  }
+  int status = 0;
+  ASSERT_EQ(waitpid(pid, &status, 0), pid);
+  EXPECT_EQ(header->ReaderRefCount(), 2);
+  EXPECT_EQ(header->WriterRefCount(), 2);
+
+  EXPECT_EQ(header->ReclaimDeadHolders(), 3);
+  EXPECT_EQ(header->ReaderRefCount(), 0);
+  EXPECT_EQ(header->WriterRefCount(), 1);
+  EXPECT_EQ(header->ReclaimDeadHolders(), 0);
+}
+
+TEST(SegmentHeaderTest, ReclaimedEntriesAreReused) {
+  SharedSegmentHeader header;
+  // More terminated processes than tracked entries.
+  for (size_t i = 0; i < 2 * SegmentHeader::kMaxTrackedProcesses; ++i) {
+    const pid_t pid = fork();
+    ASSERT_NE(pid, -1);
+    if (pid == 0) {
+      header->IncrementReaderRefCount();
+      _exit(0);
+    }
+    int status = 0;
+    ASSERT_EQ(waitpid(pid, &status, 0), pid);
+    EXPECT_EQ(header->ReclaimDeadHolders(), 1);
+  }
+  EXPECT_EQ(header->ReaderRefCount(), 0);
+}
+
+TEST(SegmentHeaderTest, KeepsReferencesOfOtherPidNamespaces) {
+  SharedSegmentHeader header;
+  const pid_t pid = fork();
+  ASSERT_NE(pid, -1);
+  if (pid == 0) {
+    header->IncrementWriterRefCount();
+    _exit(0);
+  }
+  int status = 0;
+  ASSERT_EQ(waitpid(pid, &status, 0), pid);
+  const auto [pid_namespace, start_time] =
+      SegmentHeaderTestPeer::GetIdentity(*header, pid);
+  ASSERT_NE(pid_namespace, 0);
+
+  // From the namespace of the caller, the PID of a process in another
+  // namespace is meaningless, so its references must be kept.
+  SegmentHeaderTestPeer::SetIdentity(*header, pid, pid_namespace + 1,
+                                     start_time);
+  EXPECT_EQ(header->ReclaimDeadHolders(), 0);
+  EXPECT_EQ(header->WriterRefCount(), 1);
+
+  SegmentHeaderTestPeer::SetIdentity(*header, pid, pid_namespace, start_time);
+  EXPECT_EQ(header->ReclaimDeadHolders(), 1);
+  EXPECT_EQ(header->WriterRefCount(), 0);
+}
+
+TEST(SegmentHeaderTest, ReclaimsReferencesOfReusedPids) {
+  SharedSegmentHeader header;
+  header->IncrementReaderRefCount();
+  const auto [pid_namespace, start_time] =
+      SegmentHeaderTestPeer::GetIdentity(*header, getpid());
+  ASSERT_NE(start_time, 0);
+
+  // Looks like a terminated process whose PID now belongs to this process.
+  SegmentHeaderTestPeer::SetIdentity(*header, getpid(), pid_namespace,
+                                     start_time - 1);
+  EXPECT_EQ(header->ReclaimDeadHolders(), 1);
+  EXPECT_EQ(header->ReaderRefCount(), 0);
+}
+
+}  // namespace
+}  // namespace intrinsic::icon
@@ -0,0 +1,348 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/icon/interprocess/shared_memory_manager/shared_memory_arena.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+
+#include "absl/base/optimization.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/functional/function_ref.h"
+#include "absl/log/log.h"
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+
+namespace intrinsic::icon {
+
+inline constexpr mode_t kShmMode = 0644;
+
+namespace {
+
+// Identifies a shared memory object as an arena ("ICONAREN").
+constexpr uint64_t kArenaMagic = 0x4e455241'4e4f4349;
+// Increment on changes to the layout of `ArenaDirectory`.
+constexpr uint32_t kArenaVersion = 1;
+constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+
+// The directory at the start of every arena.
+struct ArenaDirectory {
+  struct Entry {
+    char name[SharedMemoryArena::kMaxNameSize];
+    uint64_t offset;
+    uint64_t size;
+  };
+
+  uint64_t magic = kArenaMagic;
+  uint32_t version = kArenaVersion;
+  // Cleared when the creator destroys the arena, so that processes which
+  // still have it mapped know to look up the new one.
+  std::atomic<uint32_t> valid = 1;
+  // Number of published entries. Entries are filled in before this is
+  // incremented, so readers only need to look at the first `num_entries`.
+  std::atomic<uint32_t> num_entries = 0;
+  Entry entries[SharedMemoryArena::kMaxSegments];
+};
+static_assert(std::atomic<uint32_t>::is_always_lock_free);
+
+constexpr size_t AlignUp(size_t value, size_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+// Offset of the first sub-segment.
+constexpr size_t kDataStart =
+    AlignUp(sizeof(ArenaDirectory), ABSL_CACHELINE_SIZE);
+
+ArenaDirectory* DirectoryOf(uint8_t* data) {
+  return reinterpret_cast<ArenaDirectory*>(data);
+}
+
+bool IsValidArena(const ArenaDirectory& directory) {
+  return directory.magic == kArenaMagic &&
+         directory.version == kArenaVersion &&
+         directory.valid.load(std::memory_order_acquire) == 1;
+}
+
+const ArenaDirectory::Entry* FindEntry(const ArenaDirectory& directory,
+                                       absl::string_view segment_name) {
+  const uint32_t num_entries =
+      directory.num_entries.load(std::memory_order_acquire);
+  for (uint32_t i = 0; i < num_entries; ++i) {
+    if (segment_name == directory.entries[i].name) {
+      return &directory.entries[i];
+    }
+  }
+  return nullptr;
+}
+
+// Marks an arena left behind by a previous creator as invalid, so that
+// readers which still have it mapped don't use it anymore.
+void InvalidateStaleArena(const std::string& name) {
+  const int fd = shm_open(name.c_str(), O_RDWR, kShmMode);
+  if (fd == -1) {
+    return;
+  }
+  struct stat file_attributes;
+  if (fstat(fd, &file_attributes) == 0 &&
+      static_cast<size_t>(file_attributes.st_size) >= sizeof(ArenaDirectory)) {
+    void* data = mmap(nullptr, sizeof(ArenaDirectory), PROT_READ | PROT_WRITE,
+                      MAP_SHARED, fd, 0);
+    if (data != MAP_FAILED) {
+      ArenaDirectory* directory = DirectoryOf(static_cast<uint8_t*>(data));
+      if (directory->magic == kArenaMagic) {
+        directory->valid.store(0, std::memory_order_release);
+      }
+      munmap(data, sizeof(ArenaDirectory));
+    }
+  }
+  close(fd);
+}
+
+// The arenas mapped by this process, see FindSharedMemoryArenaSegment.
+class ArenaMappings {
+ public:
+  static ArenaMappings& Get() {
+    static auto* mappings = new ArenaMappings();
+    return *mappings;
+  }
+
+  // Returns the mapped arena `name`, or nullptr if it doesn't exist. Arenas
+  // that didn't exist are only looked for again if `recheck_missing` is set.
+  absl::StatusOr<uint8_t*> GetOrMap(absl::string_view name,
+                                    bool recheck_missing) {
+    {
+      absl::ReaderMutexLock lock(&mutex_);
+      if (auto it = arenas_.find(name); it != arenas_.end()) {
+        if (it->second == nullptr) {
+          if (!recheck_missing) {
+            return nullptr;
+          }
+        } else if (IsValidArena(*DirectoryOf(it->second))) {
+          return it->second;
+        }
+      }
+    }
+
+    absl::MutexLock lock(&mutex_);
+    if (auto it = arenas_.find(name);
+        it != arenas_.end() && it->second != nullptr &&
+        IsValidArena(*DirectoryOf(it->second))) {
+      return it->second;
+    }
+    // A mapping of a destroyed arena is intentionally leaked; handles that
+    // were obtained from the old arena may still point into it.
+    absl::StatusOr<uint8_t*> arena = Map(name);
+    if (arena.ok()) {
+      arenas_.insert_or_assign(std::string(name), *arena);
+    }
+    return arena;
+  }
+
+ private:
+  ArenaMappings() = default;
+
+  // Maps the arena `name`, or returns nullptr if it doesn't exist (yet).
+  static absl::StatusOr<uint8_t*> Map(absl::string_view name) {
+    const std::string name_string(name);
+    const int fd = shm_open(name_string.c_str(), O_RDWR, kShmMode);
+    if (fd == -1) {
+      if (errno == ENOENT) {
+        return nullptr;
+      }
+      return absl::InternalError(absl::StrCat(
+          "Unable to open shared memory arena: ", name, " [", strerror(errno),
+          "]"));
+    }
+    struct stat file_attributes;
+    if (fstat(fd, &file_attributes) == -1) {
+      close(fd);
+      return absl::InternalError(absl::StrCat("Fstat failed for arena: ", name,
+                                              " [", strerror(errno), "]"));
+    }
+    const size_t size = file_attributes.st_size;
+    if (size < sizeof(ArenaDirectory)) {
+      // Not (yet) initialized.
+      close(fd);
+      return nullptr;
+    }
+    void* data =
+        mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+      return absl::InternalError(absl::StrCat(
+          "Unable to map shared memory arena: ", name, " [", strerror(errno),
+          "]"));
+    }
+    uint8_t* arena = static_cast<uint8_t*>(data);
+    if (!IsValidArena(*DirectoryOf(arena))) {
+      munmap(data, size);
+      return nullptr;
+    }
+    return arena;
+  }
+
+  absl::Mutex mutex_;
+  // Holds nullptr for arenas that didn't exist at the last lookup.
+  absl::flat_hash_map<std::string, uint8_t*> arenas_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<SharedMemoryArena>> SharedMemoryArena::Create(
+    absl::string_view name, const SharedMemoryArenaOptions& options) {
+  size_t size = AlignUp(options.size, getpagesize());
+  if (options.huge_pages) {
+    size = AlignUp(size, kHugePageSize);
+  }
+  if (size <= kDataStart) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Shared memory arena \"", name, "\" needs more than ",
+                     kDataStart, " bytes, got ", options.size, "."));
+  }
+
+  const std::string name_string(name);
+  int fd = shm_open(name_string.c_str(), O_CREAT | O_EXCL | O_RDWR, kShmMode);
+  if (fd == -1 && errno == EEXIST) {
+    LOG(WARNING) << "The shared memory arena \"" << name
+                 << "\" already exists. It will be replaced.";
+    InvalidateStaleArena(name_string);
+    shm_unlink(name_string.c_str());
+    fd = shm_open(name_string.c_str(), O_CREAT | O_EXCL | O_RDWR, kShmMode);
+  }
+  if (fd == -1) {
+    return absl::InternalError(
+        absl::StrCat("Unable to open shared memory arena \"", name,
+                     "\" with error: ", strerror(errno), "."));
+  }
+  if (ftruncate(fd, size) == -1) {
+    const int error = errno;
+    close(fd);
+    shm_unlink(name_string.c_str());
+    return absl::InternalError(
+        absl::StrCat("Unable to resize shared memory arena \"", name,
+                     "\" with error: ", strerror(error), "."));
+  }
+  const int flags = MAP_SHARED | (options.populate ? MAP_POPULATE : 0);
+  void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, fd, 0);
+  const int mmap_error = errno;
+  close(fd);
+  if (data == MAP_FAILED) {
+    shm_unlink(name_string.c_str());
+    return absl::InternalError(
+        absl::StrCat("Unable to map shared memory arena \"", name,
+                     "\" with error: ", strerror(mmap_error), "."));
+  }
+
+  if (options.huge_pages && madvise(data, size, MADV_HUGEPAGE) == -1) {
+    LOG(WARNING) << "Huge pages are not available for shared memory arena \""
+                 << name << "\": " << strerror(errno) << ". Continuing anyways.";
+  }
+  if (options.lock_memory && mlock(data, size) == -1) {
+    const int error = errno;
+    munmap(data, size);
+    shm_unlink(name_string.c_str());
+    return absl::InternalError(
+        absl::StrCat("Unable to lock shared memory arena \"", name,
+                     "\" into memory with error: ", strerror(error), "."));
+  }
+
+  new (data) ArenaDirectory();
+  return absl::WrapUnique(
+      new SharedMemoryArena(name, static_cast<uint8_t*>(data), size));
+}
+
+SharedMemoryArena::SharedMemoryArena(absl::string_view name, uint8_t* data,
+                                     size_t size)
+    : name_(name), data_(data), size_(size), used_(kDataStart) {}
+
+SharedMemoryArena::~SharedMemoryArena() {
+  ArenaDirectory* directory = DirectoryOf(data_);
+  directory->valid.store(0, std::memory_order_release);
+  directory->~ArenaDirectory();
+  munmap(data_, size_);
+  shm_unlink(name_.c_str());
+}
+
+absl::StatusOr<uint8_t*> SharedMemoryArena::Allocate(
+    absl::string_view segment_name, size_t size,
+    absl::FunctionRef<void(uint8_t*)> init) {
+  ArenaDirectory* directory = DirectoryOf(data_);
+  if (segment_name.size() >= kMaxNameSize) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Segment name \"", segment_name, "\" can't exceed ",
+                     kMaxNameSize - 1, " characters."));
+  }
+  if (FindEntry(*directory, segment_name) != nullptr) {
+    return absl::AlreadyExistsError(absl::StrCat(
+        "Segment \"", segment_name, "\" exists already in arena \"", name_,
+        "\"."));
+  }
+  const uint32_t index = directory->num_entries.load(std::memory_order_relaxed);
+  if (index >= kMaxSegments) {
+    return absl::ResourceExhaustedError(
+        absl::StrCat("Unable to add \"", segment_name, "\". Max size of ",
+                     kMaxSegments, " segments in arena \"", name_,
+                     "\" exceeded."));
+  }
+  if (size > BytesAvailable()) {
+    return absl::ResourceExhaustedError(absl::StrCat(
+        "Unable to add \"", segment_name, "\" of ", size, " bytes. Only ",
+        BytesAvailable(), " bytes left in arena \"", name_, "\"."));
+  }
+
+  uint8_t* segment = data_ + used_;
+  ArenaDirectory::Entry& entry = directory->entries[index];
+  std::memset(entry.name, '\0', kMaxNameSize);
+  std::memcpy(entry.name, segment_name.data(), segment_name.size());
+  entry.offset = used_;
+  entry.size = size;
+  used_ = AlignUp(used_ + size, ABSL_CACHELINE_SIZE);
+
+  init(segment);
+  // Publishes the entry together with the initialized sub-segment.
+  directory->num_entries.store(index + 1, std::memory_order_release);
+  return segment;
+}
+
+size_t SharedMemoryArena::BytesAvailable() const {
+  return used_ < size_ ? size_ - used_ : 0;
+}
+
+absl::StatusOr<uint8_t*> FindSharedMemoryArenaSegment(
+    absl::string_view arena_name, absl::string_view segment_name,
+    size_t min_size, bool recheck_missing) {
+  absl::StatusOr<uint8_t*> arena =
+      ArenaMappings::Get().GetOrMap(arena_name, recheck_missing);
+  if (!arena.ok() || *arena == nullptr) {
+    return arena;
+  }
+  const ArenaDirectory::Entry* entry =
+      FindEntry(*DirectoryOf(*arena), segment_name);
+  if (entry == nullptr) {
+    return nullptr;
+  }
+  if (entry->size < min_size) {
+    return absl::FailedPreconditionError(absl::StrCat(
+        "Segment \"", segment_name, "\" in arena \"", arena_name, "\" has ",
+        entry->size, " bytes, expected at least ", min_size, "."));
+  }
+  return *arena + entry->offset;
+}
+
+}  // namespace intrinsic::icon
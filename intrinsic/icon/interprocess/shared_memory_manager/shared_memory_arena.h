@@ -0,0 +1,112 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#ifndef INTRINSIC_ICON_INTERPROCESS_SHARED_MEMORY_MANAGER_SHARED_MEMORY_ARENA_H_
+#define INTRINSIC_ICON_INTERPROCESS_SHARED_MEMORY_MANAGER_SHARED_MEMORY_ARENA_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+
+#include "absl/functional/function_ref.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+
+namespace intrinsic::icon {
+
+// Options for a `SharedMemoryArena`.
+struct SharedMemoryArenaOptions {
+  // Total size of the arena in bytes, including its directory.
+  size_t size = 4 * 1024 * 1024;
+  // Asks the kernel to back the arena with transparent huge pages
+  // (madvise(MADV_HUGEPAGE)). POSIX shared memory can't be mapped with
+  // MAP_HUGETLB, so this only takes effect if
+  // /sys/kernel/mm/transparent_hugepage/shmem_enabled allows it.
+  bool huge_pages = false;
+  // Pre-faults all pages of the arena when it is mapped (MAP_POPULATE).
+  bool populate = false;
+  // Locks the arena into RAM (mlock), so that accessing it never page faults.
+  bool lock_memory = false;
+};
+
+// A single shared memory object holding many named sub-segments.
+//
+// The arena starts with a directory of all sub-segments, followed by the
+// sub-segments themselves, each aligned to a cache line:
+//
+// [Directory][Segment 0]..[Segment 1]..[Segment N]
+//
+// Sub-segments are only ever added, never removed, until the arena is
+// destroyed. The directory can be read concurrently by other processes while
+// sub-segments are being added, see `FindSharedMemoryArenaSegment()`.
+//
+// Compared to one shared memory object per segment, this needs a single file
+// descriptor and mapping per module, both on the creating and on the reading
+// side.
+class SharedMemoryArena final {
+ public:
+  // Maximum number of sub-segments in an arena. Matches the capacity of the
+  // `SegmentInfo` flatbuffer.
+  static constexpr size_t kMaxSegments = 100;
+  // Maximum length of a sub-segment name, including the null-terminator.
+  static constexpr size_t kMaxNameSize = 256;
+
+  // Creates the shared memory object `name` and maps it. A stale arena of the
+  // same name, e.g. from a crashed process, is invalidated and replaced.
+  // Returns `absl::InvalidArgumentError` if `options.size` can't even hold the
+  // directory and `absl::InternalError` if a POSIX call fails.
+  static absl::StatusOr<std::unique_ptr<SharedMemoryArena>> Create(
+      absl::string_view name, const SharedMemoryArenaOptions& options);
+
+  // Invalidates the arena for readers and unlinks it.
+  ~SharedMemoryArena();
+
+  SharedMemoryArena(const SharedMemoryArena&) = delete;
+  SharedMemoryArena& operator=(const SharedMemoryArena&) = delete;
+
+  // Reserves `size` bytes for the sub-segment `segment_name`, initializes
+  // them with `init` and then publishes the sub-segment in the directory. The
+  // memory passed to `init` is zero-initialized and aligned to a cache line.
+  // Returns a pointer to the sub-segment.
+  // Returns `absl::AlreadyExistsError` if the name is taken,
+  // `absl::InvalidArgumentError` if the name is too long and
+  // `absl::ResourceExhaustedError` if the arena is full.
+  absl::StatusOr<uint8_t*> Allocate(absl::string_view segment_name, size_t size,
+                                    absl::FunctionRef<void(uint8_t*)> init);
+
+  // Returns the name of the shared memory object.
+  const std::string& Name() const { return name_; }
+
+  // Returns the number of bytes that are still available for sub-segments.
+  size_t BytesAvailable() const;
+
+ private:
+  SharedMemoryArena(absl::string_view name, uint8_t* data, size_t size);
+
+  std::string name_;
+  uint8_t* data_;
+  size_t size_;
+  // Offset of the first unused byte.
+  size_t used_;
+};
+
+// Looks up the sub-segment `segment_name` in the arena `arena_name`.
+//
+// The arena is mapped once per process and then cached, so that subsequent
+// lookups in the same arena don't need any system calls. Arenas that were
+// destroyed by their creator are mapped again on the next lookup. Arenas that
+// don't exist are cached as well, and only looked for again if
+// `recheck_missing` is set, e.g. once the segment wasn't found anywhere else.
+//
+// Returns nullptr if there is no arena `arena_name`, or if it doesn't contain
+// `segment_name`. Returns `absl::FailedPreconditionError` if the sub-segment is
+// smaller than `min_size` bytes and `absl::InternalError` if a POSIX call
+// fails. Thread-safe, not realtime safe.
+absl::StatusOr<uint8_t*> FindSharedMemoryArenaSegment(
+    absl::string_view arena_name, absl::string_view segment_name,
+    size_t min_size, bool recheck_missing = false);
+
+}  // namespace intrinsic::icon
+
+#endif  // INTRINSIC_ICON_INTERPROCESS_SHARED_MEMORY_MANAGER_SHARED_MEMORY_ARENA_H_
@@ -0,0 +1,151 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/icon/interprocess/shared_memory_manager/shared_memory_arena.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "absl/base/optimization.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "intrinsic/icon/interprocess/shared_memory_manager/memory_segment.h"
+#include "intrinsic/icon/interprocess/shared_memory_manager/shared_memory_manager.h"
+#include "intrinsic/util/testing/gtest_wrapper.h"
+
+namespace intrinsic::icon {
+namespace {
+
+using ::intrinsic::testing::IsOkAndHolds;
+using ::intrinsic::testing::StatusIs;
+using ::testing::IsNull;
+
+struct Payload {
+  int64_t a;
+  double b;
+};
+
+// Module names must be unique across concurrently running tests.
+std::string UniqueModuleName(absl::string_view test) {
+  return absl::StrCat("shared_memory_arena_test_", getpid(), "_", test);
+}
+
+TEST(SharedMemoryArenaTest, ReadersFindSegmentsInArena) {
+  const std::string module = UniqueModuleName("find");
+  ASSERT_OK_AND_ASSIGN(SharedMemoryManager manager,
+                       SharedMemoryManager::CreateWithArena("", module));
+  const MemoryName first("", module, "first");
+  const MemoryName second("", module, "second");
+  ASSERT_OK(manager.AddSegment(first, /*must_be_used=*/true,
+                               Payload{.a = 1, .b = 2.0}));
+  ASSERT_OK(manager.AddSegment(second, /*must_be_used=*/false, int64_t{42}));
+
+  ASSERT_OK_AND_ASSIGN(auto first_segment,
+                       ReadOnlyMemorySegment<Payload>::Get(first));
+  ASSERT_OK_AND_ASSIGN(auto second_segment,
+                       ReadOnlyMemorySegment<int64_t>::Get(second));
+  EXPECT_EQ(first_segment.GetValue().a, 1);
+  EXPECT_EQ(first_segment.GetValue().b, 2.0);
+  EXPECT_EQ(second_segment.GetValue(), 42);
+  EXPECT_EQ(first_segment.Header().ReaderRefCount(), 1);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(&second_segment.Header()) %
+                ABSL_CACHELINE_SIZE,
+            0);
+
+  // Writes through the manager are visible to the reader and vice versa.
+  ASSERT_OK(manager.SetSegmentValue(second, int64_t{43}));
+  EXPECT_EQ(second_segment.GetValue(), 43);
+  ASSERT_OK_AND_ASSIGN(auto writer,
+                       ReadWriteMemorySegment<Payload>::Get(first));
+  writer.SetValue(Payload{.a = 5, .b = 6.0});
+  EXPECT_EQ(manager.GetSegmentValue<Payload>(first)->a, 5);
+}
+
+TEST(SharedMemoryArenaTest, RejectsSegmentsOfOtherModules) {
+  const std::string module = UniqueModuleName("other");
+  ASSERT_OK_AND_ASSIGN(SharedMemoryManager manager,
+                       SharedMemoryManager::CreateWithArena("", module));
+  EXPECT_THAT(manager.AddSegment(MemoryName("", "another_module", "segment"),
+                                 /*must_be_used=*/false, int64_t{0}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(SharedMemoryArenaTest, FailsWhenArenaIsFull) {
+  const std::string module = UniqueModuleName("full");
+  ASSERT_OK_AND_ASSIGN(
+      SharedMemoryManager manager,
+      SharedMemoryManager::CreateWithArena("", module,
+                                           {.size = 64 * 1024}));
+  EXPECT_THAT(manager.AddSegment(MemoryName("", module, "large"),
+                                 /*must_be_used=*/false, size_t{1024 * 1024}),
+              StatusIs(absl::StatusCode::kResourceExhausted));
+  EXPECT_OK(manager.AddSegment(MemoryName("", module, "small"),
+                               /*must_be_used=*/false, size_t{1024}));
+}
+
+TEST(SharedMemoryArenaTest, ReportsUnknownSegment) {
+  const std::string module = UniqueModuleName("unknown");
+  ASSERT_OK_AND_ASSIGN(SharedMemoryManager manager,
+                       SharedMemoryManager::CreateWithArena("", module));
+  const MemoryName arena_name("", module, hal::kArenaName);
+  EXPECT_THAT(FindSharedMemoryArenaSegment(
+                  arena_name.GetName(),
+                  MemoryName("", module, "unknown").GetName(), 0),
+              IsOkAndHolds(IsNull()));
+  EXPECT_FALSE(
+      ReadOnlyMemorySegment<int64_t>::Get(MemoryName("", module, "unknown"))
+          .ok());
+}
+
+TEST(SharedMemoryArenaTest, ReadersSeeRecreatedArena) {
+  const std::string module = UniqueModuleName("recreate");
+  const MemoryName name("", module, "value");
+  {
+    ASSERT_OK_AND_ASSIGN(SharedMemoryManager manager,
+                         SharedMemoryManager::CreateWithArena("", module));
+    ASSERT_OK(manager.AddSegment(name, /*must_be_used=*/false, int64_t{1}));
+    ASSERT_OK_AND_ASSIGN(auto segment,
+                         ReadOnlyMemorySegment<int64_t>::Get(name));
+    EXPECT_EQ(segment.GetValue(), 1);
+  }
+  ASSERT_OK_AND_ASSIGN(SharedMemoryManager manager,
+                       SharedMemoryManager::CreateWithArena("", module));
+  ASSERT_OK(manager.AddSegment(name, /*must_be_used=*/false, int64_t{2}));
+  ASSERT_OK_AND_ASSIGN(auto segment, ReadOnlyMemorySegment<int64_t>::Get(name));
+  EXPECT_EQ(segment.GetValue(), 2);
+}
+
+TEST(SharedMemoryArenaTest, ReadersFindArenaCreatedAfterLookup) {
+  const std::string module = UniqueModuleName("late");
+  const MemoryName name("", module, "value");
+  const MemoryName arena_name("", module, hal::kArenaName);
+  EXPECT_FALSE(ReadOnlyMemorySegment<int64_t>::Get(name).ok());
+
+  ASSERT_OK_AND_ASSIGN(SharedMemoryManager manager,
+                       SharedMemoryManager::CreateWithArena("", module));
+  ASSERT_OK(manager.AddSegment(name, /*must_be_used=*/false, int64_t{3}));
+  // The arena is remembered as missing until it's looked for again.
+  EXPECT_THAT(FindSharedMemoryArenaSegment(arena_name.GetName(),
+                                           name.GetName(), 0),
+              IsOkAndHolds(IsNull()));
+  ASSERT_OK_AND_ASSIGN(auto segment, ReadOnlyMemorySegment<int64_t>::Get(name));
+  EXPECT_EQ(segment.GetValue(), 3);
+}
+
+TEST(SharedMemoryArenaTest, AppliesMappingOptions) {
+  const std::string module = UniqueModuleName("options");
+  // Huge pages and memory locking depend on the system configuration, so
+  // only MAP_POPULATE is guaranteed to work here.
+  ASSERT_OK_AND_ASSIGN(SharedMemoryManager manager,
+                       SharedMemoryManager::CreateWithArena(
+                           "", module, {.size = 1024 * 1024, .populate = true}));
+  ASSERT_OK(manager.AddSegment(MemoryName("", module, "value"),
+                               /*must_be_used=*/false, int64_t{7}));
+}
+
+}  // namespace
+}  // namespace intrinsic::icon
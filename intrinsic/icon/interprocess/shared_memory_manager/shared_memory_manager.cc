@@ -14,6 +14,8 @@
 #include <algorithm>
 #include <cstddef>
 #include <cstring>
+#include <memory>
+#include <new>
 #include <string>
 #include <utility>
 #include <vector>
@@ -22,12 +24,14 @@
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
 #include "intrinsic/icon/interprocess/shared_memory_manager/memory_segment.h"
 #include "intrinsic/icon/interprocess/shared_memory_manager/segment_header.h"
 #include "intrinsic/icon/interprocess/shared_memory_manager/segment_info.fbs.h"
+#include "intrinsic/icon/interprocess/shared_memory_manager/shared_memory_arena.h"
 #include "intrinsic/util/status/status_macros.h"
 
 namespace intrinsic::icon {
@@ -84,6 +88,17 @@ SegmentInfo SegmentInfoFromHashMap(
 }
 }  // namespace
 
+absl::StatusOr<SharedMemoryManager> SharedMemoryManager::CreateWithArena(
+    absl::string_view shm_namespace, absl::string_view module_name,
+    const SharedMemoryArenaOptions& options) {
+  const MemoryName arena_name(shm_namespace, module_name, hal::kArenaName);
+  INTR_RETURN_IF_ERROR(VerifyName(arena_name));
+  SharedMemoryManager manager;
+  INTR_ASSIGN_OR_RETURN(manager.arena_,
+                        SharedMemoryArena::Create(arena_name.GetName(), options));
+  return manager;
+}
+
 SharedMemoryManager::~SharedMemoryManager() {
   // unlink all created shm segments
   for (const auto& segment : memory_segments_) {
@@ -91,8 +106,12 @@ SharedMemoryManager::~SharedMemoryManager() {
     // We've used placement new during the initialization. We have to call the
     // destructor explicitly to cleanup.
     header->~SegmentHeader();
-    shm_unlink(segment.first.GetName());
+    if (arena_ == nullptr) {
+      shm_unlink(segment.first.GetName());
+    }
   }
+  // Segments in the arena are unlinked all at once by its destructor.
+  arena_.reset();
 }
 
 const SegmentHeader* SharedMemoryManager::GetSegmentHeader(
@@ -103,8 +122,9 @@ const SegmentHeader* SharedMemoryManager::GetSegmentHeader(
 
 absl::Status SharedMemoryManager::InitSegment(const MemoryName& name,
                                               bool must_be_used,
-                                              size_t segment_size,
+                                              size_t payload_size,
                                               const std::string& type_id) {
+  const size_t segment_size = sizeof(SegmentHeader) + payload_size;
   if (memory_segments_.size() >= kMaxSegmentSize) {
     return absl::ResourceExhaustedError(
         absl::StrCat("Unable to add \"", name.GetName(), "\". Max size of ",
@@ -121,6 +141,34 @@ absl::Status SharedMemoryManager::InitSegment(const MemoryName& name,
   }
   INTR_RETURN_IF_ERROR(VerifyName(name));
 
+  if (arena_ != nullptr) {
+    if (hal::ArenaNameForSegment(name.GetName()) != arena_->Name()) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "Shm segment \"", name.GetName(), "\" doesn't belong to arena \"",
+          arena_->Name(), "\"."));
+    }
+    INTR_ASSIGN_OR_RETURN(
+        uint8_t* data,
+        arena_->Allocate(name.GetName(), segment_size,
+                         [&type_id, payload_size](uint8_t* segment) {
+                           new (segment) SegmentHeader(type_id, payload_size);
+                         }));
+    memory_segments_.insert(
+        {name, {.data = data, .must_be_used = must_be_used}});
+    return absl::OkStatus();
+  }
+
+  INTR_ASSIGN_OR_RETURN(uint8_t* data,
+                        CreateStandaloneSegment(name, segment_size));
+  // We use a placement new operator here to initialize the "raw" segment
+  // data correctly.
+  new (data) SegmentHeader(type_id, payload_size);
+  memory_segments_.insert({name, {.data = data, .must_be_used = must_be_used}});
+  return absl::OkStatus();
+}
+
+absl::StatusOr<uint8_t*> SharedMemoryManager::CreateStandaloneSegment(
+    const MemoryName& name, size_t segment_size) {
   auto shm_fd = shm_open(name.GetName(), O_CREAT | O_EXCL | O_RDWR, kShmMode);
   bool reusing_segment = false;
   if (shm_fd == -1 && errno == EEXIST) {
@@ -206,11 +254,7 @@ absl::Status SharedMemoryManager::InitSegment(const MemoryName& name,
     }
   }
 
-  // We use a placement new operator here to initialize the "raw" segment
-  // data correctly.
-  new (data) SegmentHeader(type_id);
-  memory_segments_.insert({name, {.data = data, .must_be_used = must_be_used}});
-  return absl::OkStatus();
+  return data;
 }
 
 uint8_t* SharedMemoryManager::GetRawHeader(const MemoryName& name) {
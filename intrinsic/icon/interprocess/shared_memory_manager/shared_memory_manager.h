@@ -6,17 +6,20 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include <memory>
 #include <string>
 #include <typeinfo>
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "intrinsic/icon/interprocess/shared_memory_manager/memory_segment.h"
 #include "intrinsic/icon/interprocess/shared_memory_manager/segment_header.h"
 #include "intrinsic/icon/interprocess/shared_memory_manager/segment_info.fbs.h"
+#include "intrinsic/icon/interprocess/shared_memory_manager/shared_memory_arena.h"
 #include "intrinsic/util/status/status_macros.h"
 
 namespace intrinsic::icon {
@@ -50,6 +53,12 @@ inline void AssertSharedMemoryCompatibility() {
 // memory files once there's no further process using them.
 // Once a segment is added via `AddSegment` it is fully initialized with a
 // default value or any given value.
+//
+// By default, every segment is a separate shared memory object. A manager
+// created with `CreateWithArena()` instead places all segments of a module in
+// a single shared memory object (see `SharedMemoryArena`), which readers map
+// only once. `MemorySegment::Get()` transparently looks up segments in either
+// layout.
 class SharedMemoryManager final {
  public:
   struct MemorySegmentInfo {
@@ -61,6 +70,15 @@ class SharedMemoryManager final {
 
   SharedMemoryManager() = default;
 
+  // Creates a manager that allocates all segments in a single arena named
+  // "/<shm_namespace><module_name>__shm_arena". All segments added to it must
+  // be named "/<shm_namespace><module_name>__<segment_name>", see
+  // `MemoryName`.
+  // Returns `absl::InternalError` if the arena can't be created.
+  static absl::StatusOr<SharedMemoryManager> CreateWithArena(
+      absl::string_view shm_namespace, absl::string_view module_name,
+      const SharedMemoryArenaOptions& options = {});
+
   // This class is move-only.
   SharedMemoryManager(const SharedMemoryManager& other) = delete;
   SharedMemoryManager& operator=(const SharedMemoryManager& other) = delete;
@@ -99,7 +117,7 @@ class SharedMemoryManager final {
                                           const std::string& type_id) {
     AssertSharedMemoryCompatibility<T>();
     INTR_RETURN_IF_ERROR(InitSegment(name, must_be_used,
-                                     SegmentTraits<T>::kSegmentSize, type_id));
+                                     SegmentTraits<T>::kPayloadSize, type_id));
     return SetSegmentValue(name, T());
   }
 
@@ -117,7 +135,7 @@ class SharedMemoryManager final {
                           const T& value, const std::string& type_id) {
     AssertSharedMemoryCompatibility<T>();
     INTR_RETURN_IF_ERROR(InitSegment(name, must_be_used,
-                                     SegmentTraits<T>::kSegmentSize, type_id));
+                                     SegmentTraits<T>::kPayloadSize, type_id));
     return SetSegmentValue(name, value);
   }
   template <class T>
@@ -130,11 +148,12 @@ class SharedMemoryManager final {
   absl::Status AddSegment(const MemoryName& name, bool must_be_used, T&& value,
                           const std::string& type_id) {
     INTR_RETURN_IF_ERROR(InitSegment(name, must_be_used,
-                                     SegmentTraits<T>::kSegmentSize, type_id));
+                                     SegmentTraits<T>::kPayloadSize, type_id));
     return SetSegmentValue(name, std::forward<T>(value));
   }
 
   // Allocates a generic memory segment for a byte (uint8_t) array of size `n`.
+  // The segment holds the `SegmentHeader` followed by `n` payload bytes.
   absl::Status AddSegment(const MemoryName& name, bool must_be_used, size_t n) {
     return AddSegment(name, must_be_used, n, typeid(uint8_t).name());
   }
@@ -203,7 +222,11 @@ class SharedMemoryManager final {
 
  private:
   absl::Status InitSegment(const MemoryName& name, bool must_be_used,
-                           size_t segment_size, const std::string& type_id);
+                           size_t payload_size, const std::string& type_id);
+
+  // Creates and maps a separate shared memory object for a segment.
+  absl::StatusOr<uint8_t*> CreateStandaloneSegment(const MemoryName& name,
+                                                   size_t segment_size);
 
   uint8_t* GetRawHeader(const MemoryName& name);
 
@@ -213,6 +236,9 @@ class SharedMemoryManager final {
   // pointer to its allocated memory. That way we can later on provide
   // introspection tools around all allocated memory in the system.
   absl::flat_hash_map<MemoryName, MemorySegmentInfo> memory_segments_;
+
+  // Holds all segments if set, see `CreateWithArena()`.
+  std::unique_ptr<SharedMemoryArena> arena_;
 };
 
 }  // namespace intrinsic::icon
@@ -3,12 +3,57 @@
 #include "intrinsic/icon/proto/concatenate_trajectory_protos.h"
 
 #include <algorithm>
+#include <utility>
 #include <vector>
 
 #include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
 #include "google/protobuf/duration.pb.h"
+#include "intrinsic/util/status/status_macros.h"
 
 namespace intrinsic {
+namespace {
+
+// Returns an error if `trajectory_segments` is empty or if its segments differ
+// in their dynamic limits check mode or interpolation type.
+absl::Status CheckSegmentsCompatible(
+    const std::vector<intrinsic_proto::icon::JointTrajectoryPVA>&
+        trajectory_segments) {
+  if (trajectory_segments.empty())
+    return absl::FailedPreconditionError(
+        "Vector of trajectory protos is empty.");
+
+  const intrinsic_proto::icon::JointTrajectoryPVA& first =
+      trajectory_segments[0];
+  for (int subel = 1; subel < trajectory_segments.size(); subel++) {
+    if (trajectory_segments[subel].joint_dynamic_limits_check_mode() !=
+        first.joint_dynamic_limits_check_mode()) {
+      return absl::InvalidArgumentError(
+          "All trajectory segments should have the same "
+          "dynamic_limits_check_mode.");
+    }
+    if (trajectory_segments[subel].interpolation_type() !=
+        first.interpolation_type()) {
+      return absl::InvalidArgumentError(
+          "All trajectory segments should have the same "
+          "interpolation_type.");
+    }
+  }
+  return absl::OkStatus();
+}
+
+// Returns the total number of waypoints in `trajectory_segments`.
+int TotalLength(const std::vector<intrinsic_proto::icon::JointTrajectoryPVA>&
+                    trajectory_segments) {
+  int total_length = 0;
+  for (const intrinsic_proto::icon::JointTrajectoryPVA& segment :
+       trajectory_segments) {
+    total_length += segment.time_since_start_size();
+  }
+  return total_length;
+}
+
+}  // namespace
 
 absl::StatusOr<std::vector<intrinsic_proto::icon::JointTrajectoryPVA>>
 SplitTrajectoryProto(const intrinsic_proto::icon::JointTrajectoryPVA& proto,
@@ -32,9 +77,11 @@ SplitTrajectoryProto(const intrinsic_proto::icon::JointTrajectoryPVA& proto,
       num_sub_elements);
 
   for (int subel = 0; subel < num_sub_elements; subel++) {
-    for (int i = subel * max_subtrajectory_length;
-         i < std::min(traj_length, (subel + 1) * max_subtrajectory_length);
-         i++) {
+    const int begin = subel * max_subtrajectory_length;
+    const int end = std::min(traj_length, begin + max_subtrajectory_length);
+    split_trajectories[subel].mutable_time_since_start()->Reserve(end - begin);
+    split_trajectories[subel].mutable_state()->Reserve(end - begin);
+    for (int i = begin; i < end; i++) {
       *split_trajectories[subel].add_time_since_start() =
           proto.time_since_start(i);
       *split_trajectories[subel].add_state() = proto.state(i);
@@ -51,30 +98,38 @@ absl::StatusOr<intrinsic_proto::icon::JointTrajectoryPVA>
 ConcatenateTrajectoryProtos(
     const std::vector<intrinsic_proto::icon::JointTrajectoryPVA>&
         trajectory_segments) {
-  if (trajectory_segments.empty())
-    return absl::FailedPreconditionError(
-        "Vector of trajectory protos is empty.");
+  INTR_RETURN_IF_ERROR(CheckSegmentsCompatible(trajectory_segments));
 
   intrinsic_proto::icon::JointTrajectoryPVA trajectory = trajectory_segments[0];
+  const int total_length = TotalLength(trajectory_segments);
+  trajectory.mutable_time_since_start()->Reserve(total_length);
+  trajectory.mutable_state()->Reserve(total_length);
   for (int subel = 1; subel < trajectory_segments.size(); subel++) {
-    if (trajectory_segments[subel].joint_dynamic_limits_check_mode() !=
-        trajectory.joint_dynamic_limits_check_mode()) {
-      return absl::InvalidArgumentError(
-          "All trajectory segments should have the same "
-          "dynamic_limits_check_mode.");
-    }
-    if (trajectory_segments[subel].interpolation_type() !=
-        trajectory.interpolation_type()) {
-      return absl::InvalidArgumentError(
-          "All trajectory segments should have the same "
-          "interpolation_type.");
-    }
-    for (int i = 0; i < trajectory_segments[subel].time_since_start_size();
-         i++) {
-      *trajectory.add_time_since_start() =
-          trajectory_segments[subel].time_since_start(i);
-      *trajectory.add_state() = trajectory_segments[subel].state(i);
-    }
+    trajectory.mutable_time_since_start()->MergeFrom(
+        trajectory_segments[subel].time_since_start());
+    trajectory.mutable_state()->MergeFrom(trajectory_segments[subel].state());
+  }
+
+  return trajectory;
+}
+
+absl::StatusOr<intrinsic_proto::icon::JointTrajectoryPVA>
+ConcatenateTrajectoryProtos(
+    std::vector<intrinsic_proto::icon::JointTrajectoryPVA>&&
+        trajectory_segments) {
+  INTR_RETURN_IF_ERROR(CheckSegmentsCompatible(trajectory_segments));
+
+  const int total_length = TotalLength(trajectory_segments);
+  intrinsic_proto::icon::JointTrajectoryPVA trajectory =
+      std::move(trajectory_segments[0]);
+  trajectory.mutable_time_since_start()->Reserve(total_length);
+  trajectory.mutable_state()->Reserve(total_length);
+  for (int subel = 1; subel < trajectory_segments.size(); subel++) {
+    internal::MoveRepeatedPtrField(
+        *trajectory_segments[subel].mutable_time_since_start(),
+        *trajectory.mutable_time_since_start());
+    internal::MoveRepeatedPtrField(*trajectory_segments[subel].mutable_state(),
+                                   *trajectory.mutable_state());
   }
 
   return trajectory;
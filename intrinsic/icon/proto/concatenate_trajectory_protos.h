@@ -6,6 +6,7 @@
 #include <vector>
 
 #include "absl/status/statusor.h"
+#include "google/protobuf/repeated_ptr_field.h"
 #include "intrinsic/icon/proto/joint_space.pb.h"
 
 namespace intrinsic {
@@ -28,6 +29,38 @@ ConcatenateTrajectoryProtos(
     const std::vector<intrinsic_proto::icon::JointTrajectoryPVA>&
         trajectory_segments);
 
+// Like above, but moves the states and time stamps of `trajectory_segments`
+// into the result instead of copying them, so that a long trajectory is only
+// held once. The contents of `trajectory_segments` are unspecified afterwards.
+absl::StatusOr<intrinsic_proto::icon::JointTrajectoryPVA>
+ConcatenateTrajectoryProtos(
+    std::vector<intrinsic_proto::icon::JointTrajectoryPVA>&&
+        trajectory_segments);
+
+// Implementation details below.
+namespace internal {
+
+// Appends all elements of `from` to `to` and leaves `from` empty. Transfers
+// ownership of the elements instead of copying them if both fields live on
+// the same arena (or on none), which is the case for all heap-allocated
+// trajectories.
+template <typename T>
+void MoveRepeatedPtrField(google::protobuf::RepeatedPtrField<T>& from,
+                          google::protobuf::RepeatedPtrField<T>& to) {
+  if (from.GetArena() != to.GetArena()) {
+    to.MergeFrom(from);
+    from.Clear();
+    return;
+  }
+  const int size = from.size();
+  std::vector<T*> elements(size);
+  from.UnsafeArenaExtractSubrange(0, size, elements.data());
+  for (T* element : elements) {
+    to.UnsafeArenaAddAllocated(element);
+  }
+}
+
+}  // namespace internal
 }  // namespace intrinsic
 
 #endif  // INTRINSIC_ICON_PROTO_CONCATENATE_TRAJECTORY_PROTOS_H_
@@ -0,0 +1,95 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+// Measures SplitTrajectoryProto and both overloads of
+// ConcatenateTrajectoryProtos for trajectories of 10k to 1M waypoints, split
+// into segments of the given length.
+//
+// Run with `bazel run -c opt` for meaningful numbers.
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "benchmark/benchmark.h"
+#include "intrinsic/icon/proto/concatenate_trajectory_protos.h"
+#include "intrinsic/icon/proto/joint_space.pb.h"
+
+namespace intrinsic {
+namespace {
+
+constexpr int kNumJoints = 7;
+
+// Returns a trajectory with `num_waypoints` waypoints for kNumJoints joints,
+// one millisecond apart.
+intrinsic_proto::icon::JointTrajectoryPVA MakeTrajectory(int num_waypoints) {
+  intrinsic_proto::icon::JointTrajectoryPVA trajectory;
+  trajectory.mutable_state()->Reserve(num_waypoints);
+  trajectory.mutable_time_since_start()->Reserve(num_waypoints);
+  for (int i = 0; i < num_waypoints; ++i) {
+    intrinsic_proto::icon::JointStatePVA* state = trajectory.add_state();
+    for (int joint = 0; joint < kNumJoints; ++joint) {
+      state->add_position(0.001 * i + joint);
+      state->add_velocity(0.1);
+      state->add_acceleration(0.0);
+    }
+    google::protobuf::Duration* time_since_start =
+        trajectory.add_time_since_start();
+    time_since_start->set_seconds(i / 1000);
+    time_since_start->set_nanos((i % 1000) * 1000000);
+  }
+  return trajectory;
+}
+
+// Arguments: number of waypoints, segment length.
+void TrajectoryArgs(benchmark::internal::Benchmark* benchmark) {
+  for (int64_t num_waypoints : {10'000, 100'000, 1'000'000}) {
+    benchmark->Args({num_waypoints, 1'000});
+  }
+  benchmark->Unit(benchmark::kMillisecond);
+}
+
+void BM_SplitTrajectoryProto(benchmark::State& state) {
+  const intrinsic_proto::icon::JointTrajectoryPVA trajectory =
+      MakeTrajectory(state.range(0));
+  for (auto _ : state) {
+    auto segments = SplitTrajectoryProto(trajectory, state.range(1));
+    CHECK_OK(segments.status());
+    benchmark::DoNotOptimize(segments);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SplitTrajectoryProto)->Apply(TrajectoryArgs);
+
+void BM_ConcatenateTrajectoryProtosCopy(benchmark::State& state) {
+  const std::vector<intrinsic_proto::icon::JointTrajectoryPVA> segments =
+      *SplitTrajectoryProto(MakeTrajectory(state.range(0)), state.range(1));
+  for (auto _ : state) {
+    auto trajectory = ConcatenateTrajectoryProtos(segments);
+    CHECK_OK(trajectory.status());
+    benchmark::DoNotOptimize(trajectory);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ConcatenateTrajectoryProtosCopy)->Apply(TrajectoryArgs);
+
+void BM_ConcatenateTrajectoryProtosMove(benchmark::State& state) {
+  const std::vector<intrinsic_proto::icon::JointTrajectoryPVA> segments =
+      *SplitTrajectoryProto(MakeTrajectory(state.range(0)), state.range(1));
+  for (auto _ : state) {
+    // Only the concatenation consumes the segments, copying them is not part
+    // of the measurement.
+    state.PauseTiming();
+    std::vector<intrinsic_proto::icon::JointTrajectoryPVA> segments_copy =
+        segments;
+    state.ResumeTiming();
+    auto trajectory = ConcatenateTrajectoryProtos(std::move(segments_copy));
+    CHECK_OK(trajectory.status());
+    benchmark::DoNotOptimize(trajectory);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ConcatenateTrajectoryProtosMove)->Apply(TrajectoryArgs);
+
+}  // namespace
+}  // namespace intrinsic
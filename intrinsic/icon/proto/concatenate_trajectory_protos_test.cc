@@ -0,0 +1,146 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/icon/proto/concatenate_trajectory_protos.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "google/protobuf/arena.h"
+#include "google/protobuf/duration.pb.h"
+#include "intrinsic/icon/proto/joint_space.pb.h"
+#include "intrinsic/kinematics/types/dynamic_limits_check_mode.pb.h"
+#include "intrinsic/util/testing/gtest_wrapper.h"
+
+namespace intrinsic {
+namespace {
+
+using ::intrinsic::testing::EqualsProto;
+using ::intrinsic::testing::IsOkAndHolds;
+using ::intrinsic::testing::StatusIs;
+using ::testing::HasSubstr;
+
+intrinsic_proto::icon::JointTrajectoryPVA MakeTrajectory(int num_waypoints) {
+  intrinsic_proto::icon::JointTrajectoryPVA trajectory;
+  for (int i = 0; i < num_waypoints; ++i) {
+    intrinsic_proto::icon::JointStatePVA* state = trajectory.add_state();
+    state->add_position(0.1 * i);
+    state->add_position(-0.1 * i);
+    state->add_velocity(1.0);
+    state->add_velocity(-1.0);
+    state->add_acceleration(0.0);
+    state->add_acceleration(0.0);
+    trajectory.add_time_since_start()->set_nanos(1000 * i);
+  }
+  trajectory.set_joint_dynamic_limits_check_mode(
+      intrinsic_proto::DYNAMIC_LIMITS_CHECK_MODE_CHECK_NONE);
+  trajectory.set_interpolation_type(
+      intrinsic_proto::icon::INTERPOLATION_TYPE_QUINTIC_POLYNOMIAL);
+  return trajectory;
+}
+
+TEST(ConcatenateTrajectoryProtosTest, CopyAndMoveRestoreTheSplitTrajectory) {
+  const intrinsic_proto::icon::JointTrajectoryPVA trajectory =
+      MakeTrajectory(10);
+  ASSERT_OK_AND_ASSIGN(
+      std::vector<intrinsic_proto::icon::JointTrajectoryPVA> segments,
+      SplitTrajectoryProto(trajectory, /*max_subtrajectory_length=*/3));
+  ASSERT_EQ(segments.size(), 4);
+
+  EXPECT_THAT(ConcatenateTrajectoryProtos(segments),
+              IsOkAndHolds(EqualsProto(trajectory)));
+  EXPECT_THAT(ConcatenateTrajectoryProtos(std::move(segments)),
+              IsOkAndHolds(EqualsProto(trajectory)));
+}
+
+TEST(ConcatenateTrajectoryProtosTest, MoveKeepsTheElementsOfTheSegments) {
+  std::vector<intrinsic_proto::icon::JointTrajectoryPVA> segments(2);
+  segments[0] = MakeTrajectory(2);
+  segments[1] = MakeTrajectory(3);
+  const intrinsic_proto::icon::JointStatePVA* state = &segments[1].state(2);
+  const google::protobuf::Duration* time_since_start =
+      &segments[1].time_since_start(2);
+
+  ASSERT_OK_AND_ASSIGN(
+      const intrinsic_proto::icon::JointTrajectoryPVA trajectory,
+      ConcatenateTrajectoryProtos(std::move(segments)));
+
+  ASSERT_EQ(trajectory.state_size(), 5);
+  ASSERT_EQ(trajectory.time_since_start_size(), 5);
+  EXPECT_EQ(&trajectory.state(4), state);
+  EXPECT_EQ(&trajectory.time_since_start(4), time_since_start);
+}
+
+TEST(ConcatenateTrajectoryProtosTest, RejectsEmptyAndIncompatibleSegments) {
+  EXPECT_THAT(ConcatenateTrajectoryProtos(
+                  std::vector<intrinsic_proto::icon::JointTrajectoryPVA>()),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+
+  std::vector<intrinsic_proto::icon::JointTrajectoryPVA> segments = {
+      MakeTrajectory(2), MakeTrajectory(2)};
+  segments[1].set_interpolation_type(
+      intrinsic_proto::icon::INTERPOLATION_TYPE_CUBIC_POLYNOMIAL);
+  EXPECT_THAT(ConcatenateTrajectoryProtos(segments),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("interpolation_type")));
+  EXPECT_THAT(ConcatenateTrajectoryProtos(std::move(segments)),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("interpolation_type")));
+}
+
+TEST(MoveRepeatedPtrFieldTest, TransfersElementsOnTheSameArena) {
+  google::protobuf::Arena arena;
+  auto* from = google::protobuf::Arena::CreateMessage<
+      intrinsic_proto::icon::JointTrajectoryPVA>(&arena);
+  auto* to = google::protobuf::Arena::CreateMessage<
+      intrinsic_proto::icon::JointTrajectoryPVA>(&arena);
+  *from = MakeTrajectory(3);
+  *to = MakeTrajectory(2);
+  intrinsic_proto::icon::JointTrajectoryPVA expected = MakeTrajectory(2);
+  expected.mutable_state()->MergeFrom(from->state());
+  const intrinsic_proto::icon::JointStatePVA* state = &from->state(0);
+
+  internal::MoveRepeatedPtrField(*from->mutable_state(), *to->mutable_state());
+
+  EXPECT_THAT(*to, EqualsProto(expected));
+  EXPECT_EQ(from->state_size(), 0);
+  EXPECT_EQ(&to->state(2), state);
+}
+
+TEST(MoveRepeatedPtrFieldTest, CopiesElementsBetweenDifferentArenas) {
+  google::protobuf::Arena from_arena;
+  google::protobuf::Arena to_arena;
+  auto* from = google::protobuf::Arena::CreateMessage<
+      intrinsic_proto::icon::JointTrajectoryPVA>(&from_arena);
+  auto* to = google::protobuf::Arena::CreateMessage<
+      intrinsic_proto::icon::JointTrajectoryPVA>(&to_arena);
+  intrinsic_proto::icon::JointTrajectoryPVA heap_trajectory = MakeTrajectory(2);
+  *from = MakeTrajectory(3);
+  *to = MakeTrajectory(2);
+  intrinsic_proto::icon::JointTrajectoryPVA expected = MakeTrajectory(2);
+  expected.mutable_time_since_start()->MergeFrom(from->time_since_start());
+
+  internal::MoveRepeatedPtrField(*from->mutable_time_since_start(),
+                                 *to->mutable_time_since_start());
+  // A heap-allocated field also mismatches the arena of `to`.
+  internal::MoveRepeatedPtrField(*heap_trajectory.mutable_state(),
+                                 *to->mutable_state());
+  expected.mutable_state()->MergeFrom(MakeTrajectory(2).state());
+
+  EXPECT_THAT(*to, EqualsProto(expected));
+  EXPECT_EQ(from->time_since_start_size(), 0);
+  EXPECT_EQ(heap_trajectory.state_size(), 0);
+  for (const google::protobuf::Duration& time_since_start :
+       to->time_since_start()) {
+    EXPECT_EQ(time_since_start.GetArena(), &to_arena);
+  }
+  for (const intrinsic_proto::icon::JointStatePVA& state : to->state()) {
+    EXPECT_EQ(state.GetArena(), &to_arena);
+  }
+}
+
+}  // namespace
+}  // namespace intrinsic
@@ -4,6 +4,7 @@
 #include <cstddef>
 #include <iostream>
 #include <memory>
+#include <optional>
 #include <string>
 
 #include "absl/flags/flag.h"
@@ -17,6 +18,7 @@
 #include "absl/time/time.h"
 #include "intrinsic/icon/cc_client/client.h"
 #include "intrinsic/icon/cc_client/operational_status.h"
+#include "intrinsic/icon/cc_client/status_watcher.h"
 #include "intrinsic/icon/proto/part_status.pb.h"
 #include "intrinsic/icon/release/portable/init_xfa.h"
 #include "intrinsic/util/grpc/channel.h"
@@ -33,7 +35,7 @@ ABSL_FLAG(
 ABSL_FLAG(std::string, part, "arm", "Part to get joint angles for");
 
 ABSL_FLAG(double, refresh, 0.75,
-          "Seconds between refreshes; if 0: prints angles once");
+          "Minimum seconds between refreshes; if 0: prints angles once");
 
 const char* UsageString() {
   return R"(
@@ -45,7 +47,8 @@ Example:
 
   show_joint_angles
 
-This will refresh every 0.75 seconds, by default. To refresh at a different rate (in seconds), use, for example:
+This will refresh whenever the angles change, at most every 0.75 seconds by
+default. To refresh at a different rate (in seconds), use, for example:
 
   show_joint_angles --refresh=2.5
 
@@ -60,23 +63,56 @@ namespace {
 using intrinsic::icon::Channel;
 using intrinsic::icon::Client;
 using intrinsic::icon::OperationalStatus;
+using intrinsic::icon::StatusSnapshot;
+using intrinsic::icon::StatusWatcher;
 using intrinsic::icon::ToString;
 using intrinsic_proto::icon::PartStatus;
 
-absl::Status StrAppendJointAngles(std::string* out, const Client& client,
-                                  absl::string_view part) {
-  absl::StatusOr<PartStatus> part_status = client.GetSinglePartStatus(part);
-  if (!part_status.ok()) {
-    return part_status.status();
-  }
-  for (size_t i = 0; i < part_status->joint_states_size(); ++i) {
+void StrAppendJointAngles(std::string* out, const PartStatus& part_status) {
+  for (size_t i = 0; i < part_status.joint_states_size(); ++i) {
     const intrinsic_proto::icon::PartJointState& joint_state =
-        part_status->joint_states(i);
+        part_status.joint_states(i);
     absl::StrAppend(out, "J", i + 1, ":",
                     absl::StrFormat("%6.3f", joint_state.position_sensed()),
                     "\n");
   }
-  return absl::OkStatus();
+}
+
+// Prints the time, the operational status if known, and the joint angles.
+void PrintJointAngles(absl::Time time,
+                      const std::optional<OperationalStatus>& operational_status,
+                      const PartStatus& part_status) {
+  std::string out = "\033[2J";  // Clear the screen.
+  absl::StrAppend(
+      &out,
+      "Time: ", absl::FormatTime("%H:%M:%E3S", time, absl::LocalTimeZone()),
+      "\n");
+  if (operational_status.has_value()) {
+    absl::StrAppend(&out, "Operational Status: ", ToString(*operational_status),
+                    "\n");
+  }
+  StrAppendJointAngles(&out, part_status);
+  absl::StrAppend(&out, "Press ctrl-C to quit.\n");
+  std::cout << out;
+}
+
+// Polls the joint angles and operational status every `refresh` seconds. This
+// works with servers that do not implement WatchStatus.
+absl::Status PollJointAngles(const Client& client, absl::string_view part,
+                             double refresh) {
+  while (true) {
+    absl::Time start = absl::Now();
+    std::optional<OperationalStatus> operational_status;
+    if (absl::StatusOr<OperationalStatus> status =
+            client.GetOperationalStatus();
+        status.ok()) {
+      operational_status = *status;
+    }
+    INTR_ASSIGN_OR_RETURN(PartStatus part_status,
+                          client.GetSinglePartStatus(part));
+    PrintJointAngles(start, operational_status, part_status);
+    absl::SleepFor(start + absl::Seconds(refresh) - absl::Now());
+  }
 }
 
 absl::Status Run(const intrinsic::ConnectionParams& connection_params,
@@ -85,31 +121,39 @@ absl::Status Run(const intrinsic::ConnectionParams& connection_params,
   Client client(icon_channel);
   if (refresh == 0) {
     // --refresh=0; run once and quit.
+    INTR_ASSIGN_OR_RETURN(PartStatus part_status,
+                          client.GetSinglePartStatus(part));
     std::string out;
-    absl::Status status = StrAppendJointAngles(&out, client, part);
+    StrAppendJointAngles(&out, part_status);
     std::cout << out;
     return absl::OkStatus();
   }
+  // The server pushes the joint angles and operational status when they
+  // change, at most once per refresh interval.
+  INTR_ASSIGN_OR_RETURN(
+      std::unique_ptr<StatusWatcher> watcher,
+      client.WatchStatus({.part_names = {std::string(part)},
+                          .status_fields = {"part_status"},
+                          .include_operational_status = true,
+                          .min_interval = absl::Seconds(refresh)}));
+  bool received_update = false;
   while (true) {
-    std::string out = "\033[2J";  // Clear the screen.
-    absl::Time start = absl::Now();
-    absl::StrAppend(
-        &out,
-        "Time: ", absl::FormatTime("%H:%M:%E3S", start, absl::LocalTimeZone()),
-        "\n");
-    if (absl::StatusOr<OperationalStatus> operational_status =
-            client.GetOperationalStatus();
-        operational_status.ok()) {
-      absl::StrAppend(
-          &out, "Operational Status: ", ToString(*operational_status), "\n");
-    }
-    if (absl::Status status = StrAppendJointAngles(&out, client, part);
-        !status.ok()) {
+    if (absl::Status status = watcher->Next(); !status.ok()) {
+      // Servers without WatchStatus reject the call before sending anything.
+      if (!received_update && absl::IsUnimplemented(status)) {
+        return PollJointAngles(client, part, refresh);
+      }
       return status;
     }
-    absl::StrAppend(&out, "Press ctrl-C to quit.\n");
-    std::cout << out;
-    absl::SleepFor(start + absl::Seconds(refresh) - absl::Now());
+    received_update = true;
+    const StatusSnapshot& snapshot = watcher->snapshot();
+    auto part_status_it = snapshot.status.part_status().find(part);
+    if (part_status_it == snapshot.status.part_status().end()) {
+      return absl::NotFoundError(
+          absl::StrCat("No status for part '", part, "'"));
+    }
+    PrintJointAngles(absl::Now(), snapshot.operational_status,
+                     part_status_it->second);
   }
 }
 
@@ -0,0 +1,146 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/icon/utils/binary_log_args.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+
+namespace intrinsic::icon {
+namespace {
+
+template <typename T>
+T ReadValue(const uint8_t* data) {
+  T value;
+  std::memcpy(&value, data, sizeof(T));
+  return value;
+}
+
+// Splits packed arguments into their string representation. `storage` holds
+// the characters of formatted numbers.
+class UnpackedArgs {
+ public:
+  explicit UnpackedArgs(absl::Span<const uint8_t> packed_args) {
+    size_t offset = 0;
+    while (offset < packed_args.size() && count_ < args_.size()) {
+      const uint8_t* value = &packed_args[offset + 1];
+      const size_t remaining = packed_args.size() - offset - 1;
+      size_t value_size = 0;
+      switch (static_cast<BinaryLogArgType>(packed_args[offset])) {
+        case BinaryLogArgType::kInt64:
+          value_size = sizeof(int64_t);
+          if (remaining < value_size) return;
+          AddNumber(absl::AlphaNum(ReadValue<int64_t>(value)));
+          break;
+        case BinaryLogArgType::kUint64:
+          value_size = sizeof(uint64_t);
+          if (remaining < value_size) return;
+          AddNumber(absl::AlphaNum(ReadValue<uint64_t>(value)));
+          break;
+        case BinaryLogArgType::kDouble:
+          value_size = sizeof(double);
+          if (remaining < value_size) return;
+          AddNumber(absl::AlphaNum(ReadValue<double>(value)));
+          break;
+        case BinaryLogArgType::kBool:
+          value_size = 1;
+          if (remaining < value_size) return;
+          args_[count_++] = *value != 0 ? "true" : "false";
+          break;
+        case BinaryLogArgType::kString: {
+          if (remaining < sizeof(uint16_t)) return;
+          const uint16_t length = ReadValue<uint16_t>(value);
+          value_size = sizeof(uint16_t) + length;
+          if (remaining < value_size) return;
+          args_[count_++] = absl::string_view(
+              reinterpret_cast<const char*>(value + sizeof(uint16_t)), length);
+          break;
+        }
+        default:
+          // Corrupt record, ignore the remaining arguments.
+          return;
+      }
+      offset += 1 + value_size;
+    }
+  }
+
+  absl::string_view Get(size_t index) const {
+    return index < count_ ? args_[index] : absl::string_view();
+  }
+
+ private:
+  void AddNumber(const absl::AlphaNum& number) {
+    const absl::string_view piece = number.Piece();
+    char* destination = numbers_[count_].data();
+    const size_t size = std::min(piece.size(), numbers_[count_].size());
+    std::memcpy(destination, piece.data(), size);
+    args_[count_++] = absl::string_view(destination, size);
+  }
+
+  std::array<absl::string_view, BinaryLogArgs::kMaxArgs> args_;
+  std::array<std::array<char, absl::numbers_internal::kFastToBufferSize>,
+             BinaryLogArgs::kMaxArgs>
+      numbers_;
+  size_t count_ = 0;
+};
+
+}  // namespace
+
+void BinaryLogArgs::AddString(absl::string_view value) {
+  if (size_ + 1 + sizeof(uint16_t) > kMaxSize) {
+    return;
+  }
+  const uint16_t length = static_cast<uint16_t>(
+      std::min(value.size(), kMaxSize - size_ - 1 - sizeof(uint16_t)));
+  buffer_[size_++] = static_cast<uint8_t>(BinaryLogArgType::kString);
+  std::memcpy(&buffer_[size_], &length, sizeof(length));
+  size_ += sizeof(length);
+  std::memcpy(&buffer_[size_], value.data(), length);
+  size_ += length;
+}
+
+int FormatBinaryLogMessage(absl::string_view format,
+                           absl::Span<const uint8_t> packed_args, char* buffer,
+                           int buffer_size) {
+  if (buffer_size <= 0) {
+    return 0;
+  }
+  const UnpackedArgs args(packed_args);
+  size_t size = 0;
+  const size_t capacity = static_cast<size_t>(buffer_size) - 1;
+  auto append = [&](absl::string_view piece) {
+    const size_t n = std::min(piece.size(), capacity - size);
+    std::memcpy(buffer + size, piece.data(), n);
+    size += n;
+  };
+  size_t begin = 0;
+  for (size_t i = 0; i < format.size() && size < capacity; ++i) {
+    if (format[i] != '$' || i + 1 == format.size()) {
+      continue;
+    }
+    const char next = format[i + 1];
+    if (next == '$') {
+      append(format.substr(begin, i + 1 - begin));
+    } else if (next >= '0' && next <= '9') {
+      append(format.substr(begin, i - begin));
+      append(args.Get(next - '0'));
+    } else {
+      continue;
+    }
+    begin = i + 2;
+    ++i;
+  }
+  if (begin < format.size()) {
+    append(format.substr(begin));
+  }
+  buffer[size] = '\0';
+  return static_cast<int>(size);
+}
+
+}  // namespace intrinsic::icon
@@ -0,0 +1,103 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#ifndef INTRINSIC_ICON_UTILS_BINARY_LOG_ARGS_H_
+#define INTRINSIC_ICON_UTILS_BINARY_LOG_ARGS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+
+namespace intrinsic::icon {
+
+// Type tag that precedes every packed argument of a binary log record.
+enum class BinaryLogArgType : uint8_t {
+  kInt64 = 1,
+  kUint64 = 2,
+  kDouble = 3,
+  kBool = 4,
+  // Followed by a uint16_t length and the characters.
+  kString = 5,
+};
+
+// Packs the arguments of a binary log call (see INTRINSIC_RT_BINARY_LOG) into
+// a fixed-size buffer. Every argument is stored as its BinaryLogArgType tag
+// followed by its value in native byte order, without padding.
+//
+// Strings are copied, because the message is formatted later, on another
+// thread. Strings that don't fit are truncated, other arguments that don't fit
+// are dropped.
+//
+// Does not allocate and is realtime safe.
+class BinaryLogArgs {
+ public:
+  // Maximum number of bytes of all packed arguments of one log call.
+  static constexpr size_t kMaxSize = 512;
+  // Maximum number of arguments of one log call, i.e. $0 to $9.
+  static constexpr size_t kMaxArgs = 10;
+
+  BinaryLogArgs() = default;
+
+  template <typename T>
+  void Add(const T& value) {
+    using U = std::decay_t<T>;
+    if constexpr (std::is_same_v<U, bool>) {
+      AddFixed(BinaryLogArgType::kBool, static_cast<uint8_t>(value));
+    } else if constexpr (std::is_enum_v<U>) {
+      Add(static_cast<std::underlying_type_t<U>>(value));
+    } else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>) {
+      AddFixed(BinaryLogArgType::kInt64, static_cast<int64_t>(value));
+    } else if constexpr (std::is_integral_v<U>) {
+      AddFixed(BinaryLogArgType::kUint64, static_cast<uint64_t>(value));
+    } else if constexpr (std::is_floating_point_v<U>) {
+      AddFixed(BinaryLogArgType::kDouble, static_cast<double>(value));
+    } else {
+      static_assert(std::is_convertible_v<const T&, absl::string_view>,
+                    "INTRINSIC_RT_BINARY_LOG supports integers, enums, "
+                    "floating point numbers, bool and strings.");
+      AddString(absl::string_view(value));
+    }
+  }
+
+  // Returns the packed arguments.
+  absl::Span<const uint8_t> data() const {
+    return absl::MakeConstSpan(buffer_, size_);
+  }
+
+ private:
+  template <typename T>
+  void AddFixed(BinaryLogArgType type, T value) {
+    if (size_ + 1 + sizeof(T) > kMaxSize) {
+      return;
+    }
+    buffer_[size_++] = static_cast<uint8_t>(type);
+    std::memcpy(&buffer_[size_], &value, sizeof(T));
+    size_ += sizeof(T);
+  }
+
+  void AddString(absl::string_view value);
+
+  uint8_t buffer_[kMaxSize];
+  size_t size_ = 0;
+};
+
+// Formats `format` into `buffer`, which holds `buffer_size` bytes, and writes
+// a null-terminated C string.
+//
+// Like absl::Substitute, "$0" to "$9" are replaced by the respective argument
+// in `packed_args` and "$$" by a single "$". References to missing arguments
+// are replaced by an empty string. Numbers are formatted like absl::StrCat.
+//
+// Truncates the message if the buffer is too small. Returns the number of
+// characters written (excluding null termination).
+// Does not allocate and is realtime safe.
+int FormatBinaryLogMessage(absl::string_view format,
+                           absl::Span<const uint8_t> packed_args, char* buffer,
+                           int buffer_size);
+
+}  // namespace intrinsic::icon
+
+#endif  // INTRINSIC_ICON_UTILS_BINARY_LOG_ARGS_H_
@@ -0,0 +1,73 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/icon/utils/binary_log_args.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "intrinsic/util/testing/gtest_wrapper.h"
+
+namespace intrinsic::icon {
+namespace {
+
+template <typename... Args>
+std::string Format(absl::string_view format, const Args&... args) {
+  BinaryLogArgs packed_args;
+  (packed_args.Add(args), ...);
+  char buffer[256];
+  const int size = FormatBinaryLogMessage(format, packed_args.data(), buffer,
+                                          sizeof(buffer));
+  return std::string(buffer, size);
+}
+
+enum class Mode : uint8_t { kOff = 0, kOn = 7 };
+
+TEST(BinaryLogArgsTest, FormatsLikeStrCat) {
+  const std::string owned = "owned";
+  EXPECT_EQ(Format("$0 $1 $2 $3 $4 $5 $6", int8_t{-3}, uint64_t{18}, 0.5,
+                   1.0 / 3.0, true, "text", owned),
+            "-3 18 0.5 0.333333 true text owned");
+  EXPECT_EQ(Format("mode: $0", Mode::kOn), "mode: 7");
+}
+
+TEST(BinaryLogArgsTest, SubstitutesInAnyOrder) {
+  EXPECT_EQ(Format("$1-$0-$1", 1, 2), "2-1-2");
+  EXPECT_EQ(Format("no args"), "no args");
+  EXPECT_EQ(Format("$$0 costs $0$", 5), "$0 costs 5$");
+  EXPECT_EQ(Format("$a $"), "$a $");
+}
+
+TEST(BinaryLogArgsTest, ReplacesMissingArgumentsWithEmptyString) {
+  EXPECT_EQ(Format("[$0][$1][$9]", 1), "[1][][]");
+}
+
+TEST(BinaryLogArgsTest, TruncatesLongStrings) {
+  BinaryLogArgs packed_args;
+  packed_args.Add(std::string(2 * BinaryLogArgs::kMaxSize, 'x'));
+  EXPECT_EQ(packed_args.data().size(), BinaryLogArgs::kMaxSize);
+  // Further arguments are dropped.
+  packed_args.Add(1);
+  EXPECT_EQ(packed_args.data().size(), BinaryLogArgs::kMaxSize);
+
+  char buffer[1024];
+  const int size = FormatBinaryLogMessage("$0|$1", packed_args.data(), buffer,
+                                          sizeof(buffer));
+  EXPECT_EQ(std::string(buffer, size),
+            std::string(BinaryLogArgs::kMaxSize - 3, 'x') + "|");
+}
+
+TEST(BinaryLogArgsTest, TruncatesMessageToBuffer) {
+  BinaryLogArgs packed_args;
+  packed_args.Add(123456);
+  char buffer[8];
+  EXPECT_EQ(FormatBinaryLogMessage("value $0", packed_args.data(), buffer,
+                                   sizeof(buffer)),
+            7);
+  EXPECT_STREQ(buffer, "value 1");
+}
+
+}  // namespace
+}  // namespace intrinsic::icon
@@ -0,0 +1,385 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/icon/utils/binary_log_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/functional/function_ref.h"
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "intrinsic/icon/utils/log_sink.h"
+
+namespace intrinsic::icon {
+namespace {
+
+constexpr char kMagic[8] = {'I', 'C', 'O', 'N', 'B', 'L', 'G', '1'};
+
+struct FileHeader {
+  char magic[8];
+  // Number of valid bytes in the file, including this header.
+  uint64_t size;
+};
+
+enum RecordType : uint32_t {
+  // Format of a call site, followed by the filename and the format string.
+  kFormatRecord = 1,
+  // Binary log record, followed by the packed arguments.
+  kBinaryRecord = 2,
+  // Text log record, followed by the filename and the message.
+  kTextRecord = 3,
+};
+
+struct RecordHeader {
+  uint32_t type;
+  uint32_t payload_size;
+};
+
+struct FormatRecord {
+  uint64_t site_id;
+  int32_t priority;
+  int32_t line;
+  uint32_t filename_size;
+  uint32_t format_size;
+};
+
+struct BinaryRecord {
+  uint64_t site_id;
+  int64_t robot_timestamp_ns;
+  int64_t wall_timestamp_ns;
+};
+
+struct TextRecord {
+  int64_t robot_timestamp_ns;
+  int64_t wall_timestamp_ns;
+  int32_t priority;
+  int32_t line;
+  uint32_t filename_size;
+  uint32_t message_size;
+};
+
+uint64_t SiteId(const BinaryLogSite& site) {
+  return reinterpret_cast<uintptr_t>(&site);
+}
+
+// Copies `value` to `destination` and returns the position after it.
+template <typename T>
+uint8_t* Append(uint8_t* destination, const T& value) {
+  std::memcpy(destination, &value, sizeof(T));
+  return destination + sizeof(T);
+}
+
+uint8_t* Append(uint8_t* destination, absl::string_view value) {
+  std::memcpy(destination, value.data(), value.size());
+  return destination + value.size();
+}
+
+// Reads from a byte span and fails gracefully on truncated data.
+class Reader {
+ public:
+  explicit Reader(absl::Span<const uint8_t> data) : data_(data) {}
+
+  template <typename T>
+  bool Read(T& value) {
+    if (data_.size() < sizeof(T)) return false;
+    std::memcpy(&value, data_.data(), sizeof(T));
+    data_.remove_prefix(sizeof(T));
+    return true;
+  }
+
+  bool Read(size_t size, absl::string_view& value) {
+    if (data_.size() < size) return false;
+    value = absl::string_view(reinterpret_cast<const char*>(data_.data()),
+                              size);
+    data_.remove_prefix(size);
+    return true;
+  }
+
+  bool Read(size_t size, absl::Span<const uint8_t>& value) {
+    if (data_.size() < size) return false;
+    value = data_.subspan(0, size);
+    data_.remove_prefix(size);
+    return true;
+  }
+
+  absl::Span<const uint8_t> remaining() const { return data_; }
+  bool empty() const { return data_.empty(); }
+
+ private:
+  absl::Span<const uint8_t> data_;
+};
+
+struct DecodedSite {
+  std::string filename;
+  std::string format;
+  BinaryLogSite site;
+};
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<BinaryLogFileWriter>>
+BinaryLogFileWriter::Create(absl::string_view path, size_t max_size_bytes) {
+  if (max_size_bytes < sizeof(FileHeader)) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Binary log file size must be at least ",
+                     sizeof(FileHeader), " bytes, got ", max_size_bytes));
+  }
+  const std::string path_string(path);
+  int fd = open(path_string.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC,
+                0644);
+  if (fd < 0) {
+    return absl::InternalError(absl::StrCat(
+        "Unable to open binary log file: ", path, " [", strerror(errno), "]"));
+  }
+  if (ftruncate(fd, max_size_bytes) != 0) {
+    const int error = errno;
+    close(fd);
+    return absl::InternalError(absl::StrCat(
+        "Unable to resize binary log file: ", path, " [", strerror(error),
+        "]"));
+  }
+  void* data = mmap(nullptr, max_size_bytes, PROT_READ | PROT_WRITE,
+                    MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED) {
+    const int error = errno;
+    close(fd);
+    return absl::InternalError(absl::StrCat(
+        "Unable to map binary log file: ", path, " [", strerror(error), "]"));
+  }
+  return absl::WrapUnique(new BinaryLogFileWriter(
+      fd, static_cast<uint8_t*>(data), max_size_bytes));
+}
+
+BinaryLogFileWriter::BinaryLogFileWriter(int fd, uint8_t* data,
+                                         size_t capacity)
+    : fd_(fd), data_(data), capacity_(capacity), size_(sizeof(FileHeader)) {
+  FileHeader header;
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.size = size_;
+  std::memcpy(data_, &header, sizeof(header));
+}
+
+BinaryLogFileWriter::~BinaryLogFileWriter() {
+  munmap(data_, capacity_);
+  (void)ftruncate(fd_, size_);
+  close(fd_);
+}
+
+uint8_t* BinaryLogFileWriter::PrepareRecord(uint32_t type,
+                                            size_t payload_size) {
+  const size_t record_size = sizeof(RecordHeader) + payload_size;
+  if (record_size > capacity_ - size_) {
+    return nullptr;
+  }
+  const RecordHeader header{
+      .type = type, .payload_size = static_cast<uint32_t>(payload_size)};
+  pending_size_ = size_ + record_size;
+  return Append(&data_[size_], header);
+}
+
+void BinaryLogFileWriter::CommitRecord() {
+  size_ = pending_size_;
+  const uint64_t size = size_;
+  std::memcpy(&data_[offsetof(FileHeader, size)], &size, sizeof(size));
+}
+
+bool BinaryLogFileWriter::WriteBinary(const BinaryLogSite& site,
+                                      int64_t robot_timestamp_ns,
+                                      int64_t wall_timestamp_ns,
+                                      absl::Span<const uint8_t> packed_args) {
+  if (!known_sites_.contains(&site)) {
+    const absl::string_view filename(site.filename);
+    const absl::string_view format(site.format);
+    uint8_t* payload = PrepareRecord(
+        kFormatRecord, sizeof(FormatRecord) + filename.size() + format.size());
+    if (payload == nullptr) {
+      return false;
+    }
+    payload = Append(
+        payload, FormatRecord{
+                     .site_id = SiteId(site),
+                     .priority = static_cast<int32_t>(site.priority),
+                     .line = site.line,
+                     .filename_size = static_cast<uint32_t>(filename.size()),
+                     .format_size = static_cast<uint32_t>(format.size())});
+    payload = Append(payload, filename);
+    Append(payload, format);
+    CommitRecord();
+    known_sites_.insert(&site);
+  }
+  uint8_t* payload = PrepareRecord(
+      kBinaryRecord, sizeof(BinaryRecord) + packed_args.size());
+  if (payload == nullptr) {
+    return false;
+  }
+  payload = Append(payload,
+                   BinaryRecord{.site_id = SiteId(site),
+                                .robot_timestamp_ns = robot_timestamp_ns,
+                                .wall_timestamp_ns = wall_timestamp_ns});
+  std::memcpy(payload, packed_args.data(), packed_args.size());
+  CommitRecord();
+  return true;
+}
+
+bool BinaryLogFileWriter::WriteText(const LogSinkInterface::LogEntry& entry) {
+  const absl::string_view filename(entry.filename);
+  const absl::string_view message(
+      entry.msg, std::clamp<size_t>(entry.msglen, 0, sizeof(entry.msg) - 1));
+  uint8_t* payload = PrepareRecord(
+      kTextRecord, sizeof(TextRecord) + filename.size() + message.size());
+  if (payload == nullptr) {
+    return false;
+  }
+  payload = Append(
+      payload,
+      TextRecord{.robot_timestamp_ns = entry.robot_timestamp_ns,
+                 .wall_timestamp_ns = entry.wall_timestamp_ns,
+                 .priority = static_cast<int32_t>(entry.priority),
+                 .line = entry.line,
+                 .filename_size = static_cast<uint32_t>(filename.size()),
+                 .message_size = static_cast<uint32_t>(message.size())});
+  payload = Append(payload, filename);
+  Append(payload, message);
+  CommitRecord();
+  return true;
+}
+
+absl::Status DecodeBinaryLogFile(
+    absl::string_view path,
+    absl::FunctionRef<void(const LogSinkInterface::LogEntry&)> callback) {
+  const std::string path_string(path);
+  int fd = open(path_string.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return absl::NotFoundError(absl::StrCat(
+        "Unable to open binary log file: ", path, " [", strerror(errno), "]"));
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0) {
+    const int error = errno;
+    close(fd);
+    return absl::InternalError(absl::StrCat(
+        "Unable to stat binary log file: ", path, " [", strerror(error), "]"));
+  }
+  const size_t file_size = file_stat.st_size;
+  if (file_size < sizeof(FileHeader)) {
+    close(fd);
+    return absl::InvalidArgumentError(
+        absl::StrCat("Not a binary log file: ", path));
+  }
+  void* mapped = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapped == MAP_FAILED) {
+    return absl::InternalError(absl::StrCat(
+        "Unable to map binary log file: ", path, " [", strerror(errno), "]"));
+  }
+  const absl::Span<const uint8_t> data(static_cast<const uint8_t*>(mapped),
+                                       file_size);
+  absl::Status status = [&]() -> absl::Status {
+    FileHeader header;
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+        header.size < sizeof(FileHeader) || header.size > file_size) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Not a binary log file: ", path));
+    }
+    absl::flat_hash_map<uint64_t, std::unique_ptr<DecodedSite>> sites;
+    Reader records(data.subspan(sizeof(FileHeader),
+                                header.size - sizeof(FileHeader)));
+    auto entry = std::make_unique<LogSinkInterface::LogEntry>();
+    while (!records.empty()) {
+      RecordHeader record_header;
+      absl::Span<const uint8_t> payload;
+      if (!records.Read(record_header) ||
+          !records.Read(record_header.payload_size, payload)) {
+        return absl::DataLossError(
+            absl::StrCat("Truncated record in binary log file: ", path));
+      }
+      Reader reader(payload);
+      switch (record_header.type) {
+        case kFormatRecord: {
+          FormatRecord record;
+          absl::string_view filename;
+          absl::string_view format;
+          if (!reader.Read(record) ||
+              !reader.Read(record.filename_size, filename) ||
+              !reader.Read(record.format_size, format)) {
+            return absl::DataLossError(
+                absl::StrCat("Corrupt format record in ", path));
+          }
+          auto site = std::make_unique<DecodedSite>();
+          site->filename = std::string(filename);
+          site->format = std::string(format);
+          site->site = BinaryLogSite{
+              .priority = static_cast<LogPriority>(record.priority),
+              .filename = site->filename.c_str(),
+              .line = record.line,
+              .format = site->format.c_str()};
+          sites[record.site_id] = std::move(site);
+          break;
+        }
+        case kBinaryRecord: {
+          BinaryRecord record;
+          if (!reader.Read(record)) {
+            return absl::DataLossError(
+                absl::StrCat("Corrupt binary record in ", path));
+          }
+          auto site = sites.find(record.site_id);
+          if (site == sites.end()) {
+            return absl::DataLossError(absl::StrCat(
+                "Binary record without format in ", path));
+          }
+          LogEntryFromBinary(site->second->site, record.robot_timestamp_ns,
+                             record.wall_timestamp_ns, reader.remaining(),
+                             *entry);
+          callback(*entry);
+          break;
+        }
+        case kTextRecord: {
+          TextRecord record;
+          absl::string_view filename;
+          absl::string_view message;
+          if (!reader.Read(record) ||
+              !reader.Read(record.filename_size, filename) ||
+              !reader.Read(record.message_size, message)) {
+            return absl::DataLossError(
+                absl::StrCat("Corrupt text record in ", path));
+          }
+          const std::string filename_string(filename);
+          entry->priority = static_cast<LogPriority>(record.priority);
+          entry->robot_timestamp_ns = record.robot_timestamp_ns;
+          entry->wall_timestamp_ns = record.wall_timestamp_ns;
+          entry->filename = filename_string.c_str();
+          entry->line = record.line;
+          entry->msglen = std::min(message.size(), sizeof(entry->msg) - 1);
+          std::memcpy(entry->msg, message.data(), entry->msglen);
+          entry->msg[entry->msglen] = '\0';
+          callback(*entry);
+          break;
+        }
+        default:
+          // Unknown record types are skipped for forward compatibility.
+          break;
+      }
+    }
+    return absl::OkStatus();
+  }();
+  munmap(mapped, file_size);
+  return status;
+}
+
+}  // namespace intrinsic::icon
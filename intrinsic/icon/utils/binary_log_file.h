@@ -0,0 +1,81 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#ifndef INTRINSIC_ICON_UTILS_BINARY_LOG_FILE_H_
+#define INTRINSIC_ICON_UTILS_BINARY_LOG_FILE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/functional/function_ref.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "intrinsic/icon/utils/log_sink.h"
+
+namespace intrinsic::icon {
+
+// Writes log records into a memory-mapped file without formatting them.
+//
+// Binary log records (see INTRINSIC_RT_BINARY_LOG) are stored as the id of
+// their call site and the packed arguments. The format of a call site is
+// stored once, before its first record. Text log records are stored with
+// their message. Use DecodeBinaryLogFile() to read the file.
+//
+// The file has a fixed maximum size. The number of valid bytes is updated in
+// the file header after every record, so the file is readable even if the
+// process crashes. On destruction, the file is truncated to its valid size.
+//
+// Not thread-safe and not realtime safe.
+class BinaryLogFileWriter {
+ public:
+  // Creates (or overwrites) the file at `path`, which holds at most
+  // `max_size_bytes` bytes.
+  static absl::StatusOr<std::unique_ptr<BinaryLogFileWriter>> Create(
+      absl::string_view path, size_t max_size_bytes);
+
+  ~BinaryLogFileWriter();
+
+  BinaryLogFileWriter(const BinaryLogFileWriter&) = delete;
+  BinaryLogFileWriter& operator=(const BinaryLogFileWriter&) = delete;
+
+  // Appends a binary log record. Returns false if the file is full.
+  bool WriteBinary(const BinaryLogSite& site, int64_t robot_timestamp_ns,
+                   int64_t wall_timestamp_ns,
+                   absl::Span<const uint8_t> packed_args);
+
+  // Appends a text log record. Returns false if the file is full.
+  bool WriteText(const LogSinkInterface::LogEntry& entry);
+
+  // Returns the number of valid bytes in the file.
+  size_t size() const { return size_; }
+
+ private:
+  BinaryLogFileWriter(int fd, uint8_t* data, size_t capacity);
+
+  // Returns `payload_size` bytes for a new record of `type`, or nullptr if the
+  // file is full. The record becomes valid with CommitRecord().
+  uint8_t* PrepareRecord(uint32_t type, size_t payload_size);
+  void CommitRecord();
+
+  int fd_;
+  uint8_t* data_;
+  size_t capacity_;
+  size_t size_;
+  size_t pending_size_ = 0;
+  // Call sites whose format has been written already.
+  absl::flat_hash_set<const BinaryLogSite*> known_sites_;
+};
+
+// Reads a file written by BinaryLogFileWriter and invokes `callback` for every
+// record in order. The entry (including its filename) is only valid during
+// the callback.
+absl::Status DecodeBinaryLogFile(
+    absl::string_view path,
+    absl::FunctionRef<void(const LogSinkInterface::LogEntry&)> callback);
+
+}  // namespace intrinsic::icon
+
+#endif  // INTRINSIC_ICON_UTILS_BINARY_LOG_FILE_H_
@@ -0,0 +1,59 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include <cstdio>
+#include <string>
+
+#include "absl/flags/flag.h"
+#include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "intrinsic/icon/release/portable/init_xfa.h"
+#include "intrinsic/icon/utils/binary_log_file.h"
+#include "intrinsic/icon/utils/log_sink.h"
+
+ABSL_FLAG(std::string, file, "",
+          "Binary log file written by EnableRealtimeLogBinaryFile().");
+ABSL_FLAG(std::string, timezone, "UTC",
+          "Time zone for the wall timestamps, e.g. America/Los_Angeles.");
+
+const char* UsageString() {
+  return R"(
+Usage: decode_binary_log --file=<path> [--timezone=<zone>]
+
+Prints the messages of a binary realtime log file in the same format as the
+realtime log sink writes them to stderr.
+)";
+}
+
+namespace {
+
+absl::Status DecodeToStdout(absl::string_view path,
+                            absl::string_view timezone_name) {
+  if (path.empty()) {
+    return absl::FailedPreconditionError("You must provide --file=<path>.");
+  }
+  absl::TimeZone timezone;
+  if (!absl::LoadTimeZone(timezone_name, &timezone)) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Unknown time zone: ", timezone_name));
+  }
+  using ::intrinsic::icon::LogSinkInterface;
+  return intrinsic::icon::DecodeBinaryLogFile(
+      path, [&timezone](const LogSinkInterface::LogEntry& entry) {
+        char buffer[LogSinkInterface::kLogMessageMaxSize];
+        intrinsic::icon::LogEntryFormatToBuffer(buffer, sizeof(buffer), entry,
+                                                timezone);
+        fputs(buffer, stdout);
+      });
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  InitXfa(UsageString(), argc, argv);
+  QCHECK_OK(DecodeToStdout(absl::GetFlag(FLAGS_file),
+                           absl::GetFlag(FLAGS_timezone)));
+  return 0;
+}
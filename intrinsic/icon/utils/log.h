@@ -27,6 +27,16 @@
 //   // Logs at most once every 2 seconds.
 //   INTRINSIC_RT_LOG_THROTTLED(WARNING) << "limit exceeded";
 //
+// BINARY LOGGING
+// --------------
+// INTRINSIC_RT_BINARY_LOG takes an absl::Substitute-style format string
+// literal and up to 10 arguments (integers, enums, floating point numbers, bool
+// and strings). The realtime thread only packs the arguments; the message is
+// formatted on the GlobalLogSink thread. This is considerably cheaper than
+// INTRINSIC_RT_LOG for messages with numbers:
+//
+//   INTRINSIC_RT_BINARY_LOG(INFO, "cycle $0: joint $1 at $2", cycle, i, q[i]);
+//
 // FATAL LOGGING
 // -------------
 // None of these macros is fatal.  For a non-recoverable error use
@@ -83,6 +93,17 @@ void RtLogInitForThisThread();
 // Logs the first time it is called.
 #define INTRINSIC_RT_LOG_FIRST(SEVERITY) INTRINSIC_RT_LOG_FIRST_N(SEVERITY, 1)
 
+// Logs a message with deferred formatting, see "BINARY LOGGING" above.
+#define INTRINSIC_RT_BINARY_LOG(SEVERITY, FORMAT, ...)                        \
+  do {                                                                        \
+    static constexpr ::intrinsic::icon::BinaryLogSite                         \
+        intrinsic_binary_log_site{                                            \
+            ::intrinsic::icon::LogPriority::SEVERITY, __FILE__, __LINE__,     \
+            FORMAT};                                                          \
+    ::intrinsic::icon::internal::LogBinary(                                   \
+        intrinsic_binary_log_site __VA_OPT__(, ) __VA_ARGS__);                \
+  } while (false)
+
 // Documentation for developers of logging:
 // Filtering is implemented similar to absl/log/internal/conditions.h
 // Also, the if clause will error if prefixes (like intrinsic::) are used,
@@ -21,6 +21,7 @@
 #include "absl/log/log.h"
 #include "absl/strings/string_view.h"
 #include "absl/time/time.h"
+#include "absl/types/span.h"
 #include "intrinsic/icon/testing/realtime_annotations.h"
 #include "intrinsic/icon/utils/log_sink.h"
 
@@ -32,6 +33,8 @@ struct LoggerThreadInfo {
   std::unique_ptr<LogSinkInterface> logger;
   // Existing log entry in call stack to detect recursive logging.
   LogSinkInterface::LogEntry* log_entry = nullptr;
+  // Existing binary log call in call stack to detect recursive logging.
+  const BinaryLogSite* binary_log_site = nullptr;
 };
 
 }  // namespace internal
@@ -152,7 +155,7 @@ void LogClient::operator+=(LogEntryBuilder& builder) const {
 
   // Fail on recursive log calls.
   internal::LoggerThreadInfo& info = GetThreadInfo();
-  if (info.log_entry != nullptr) {
+  if (info.log_entry != nullptr || info.binary_log_site != nullptr) {
     [&]() INTRINSIC_SUPPRESS_REALTIME_CHECK {
       LOG(FATAL) << "Recursive INTRINSIC_RT_LOG log call at " << entry.filename
                  << " line " << entry.line;
@@ -165,5 +168,28 @@ void LogClient::operator+=(LogEntryBuilder& builder) const {
   errno = save_errno;
 }
 
+void LogBinaryRecord(const BinaryLogSite& site,
+                     absl::Span<const uint8_t> packed_args) {
+  int save_errno = errno;
+  int64_t robot_timestamp_ns;
+  int64_t wall_timestamp_ns;
+  GlobalLogContext::GetTime(&robot_timestamp_ns, &wall_timestamp_ns);
+
+  // Fail on recursive log calls.
+  internal::LoggerThreadInfo& info = GetThreadInfo();
+  if (info.log_entry != nullptr || info.binary_log_site != nullptr) {
+    [&]() INTRINSIC_SUPPRESS_REALTIME_CHECK {
+      LOG(FATAL) << "Recursive INTRINSIC_RT_BINARY_LOG log call at "
+                 << site.filename << " line " << site.line;
+    }();
+  }
+  info.binary_log_site = &site;
+  GlobalLogContext::GetThreadLocalLogSinkOrFallback().LogBinary(
+      site, robot_timestamp_ns, wall_timestamp_ns, packed_args);
+  info.binary_log_site = nullptr;
+
+  errno = save_errno;
+}
+
 }  // namespace internal
 }  // namespace intrinsic::icon
@@ -13,7 +13,9 @@
 
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "intrinsic/icon/release/source_location.h"
+#include "intrinsic/icon/utils/binary_log_args.h"
 #include "intrinsic/icon/utils/fixed_string.h"
 #include "intrinsic/icon/utils/log_sink.h"
 
@@ -176,6 +178,21 @@ class LogClient {
   void operator+=(LogEntryBuilder& builder) const;
 };
 
+// Passes a binary log record to the thread-local LogSink.
+void LogBinaryRecord(const BinaryLogSite& site,
+                     absl::Span<const uint8_t> packed_args);
+
+// Packs `args` and passes them to the thread-local LogSink. Used by
+// INTRINSIC_RT_BINARY_LOG.
+template <typename... Args>
+void LogBinary(const BinaryLogSite& site, const Args&... args) {
+  static_assert(sizeof...(Args) <= BinaryLogArgs::kMaxArgs,
+                "INTRINSIC_RT_BINARY_LOG supports at most 10 arguments.");
+  BinaryLogArgs packed_args;
+  (packed_args.Add(args), ...);
+  LogBinaryRecord(site, packed_args.data());
+}
+
 }  // namespace internal
 }  // namespace intrinsic::icon
 
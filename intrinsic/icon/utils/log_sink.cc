@@ -10,6 +10,8 @@
 
 #include "absl/log/check.h"
 #include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "intrinsic/icon/utils/binary_log_args.h"
 
 namespace intrinsic::icon {
 
@@ -59,6 +61,29 @@ int LogEntryFormatToBuffer(char* buffer, int buffer_size,
   return std::min(num_chars, buffer_size - 1);
 }
 
+void LogEntryFromBinary(const BinaryLogSite& site, int64_t robot_timestamp_ns,
+                        int64_t wall_timestamp_ns,
+                        absl::Span<const uint8_t> packed_args,
+                        LogSinkInterface::LogEntry& entry) {
+  entry.priority = site.priority;
+  entry.robot_timestamp_ns = robot_timestamp_ns;
+  entry.wall_timestamp_ns = wall_timestamp_ns;
+  entry.filename = site.filename;
+  entry.line = site.line;
+  entry.msglen = FormatBinaryLogMessage(site.format, packed_args, entry.msg,
+                                        sizeof(entry.msg));
+}
+
+void LogSinkInterface::LogBinary(const BinaryLogSite& site,
+                                 int64_t robot_timestamp_ns,
+                                 int64_t wall_timestamp_ns,
+                                 absl::Span<const uint8_t> packed_args) {
+  LogEntry entry;
+  LogEntryFromBinary(site, robot_timestamp_ns, wall_timestamp_ns, packed_args,
+                     entry);
+  Log(entry);
+}
+
 void StderrLogSink::Log(const LogEntry& entry) {
   char buffer[kLogMessageMaxSize] = {0};
   LogEntryFormatToBuffer(buffer, sizeof(buffer), entry);
@@ -8,6 +8,7 @@
 
 #include "absl/base/log_severity.h"
 #include "absl/time/time.h"
+#include "absl/types/span.h"
 
 namespace intrinsic::icon {
 
@@ -17,6 +18,18 @@ enum class LogPriority : int {
   ERROR = static_cast<int>(absl::LogSeverity::kError),
 };
 
+// Static description of an INTRINSIC_RT_BINARY_LOG call site. Its address
+// identifies the format of the call site's log records.
+struct BinaryLogSite {
+  LogPriority priority = LogPriority::INFO;
+  // File name where the log was written.
+  const char* filename = "";
+  // Line number where the log was written.
+  int32_t line = 0;
+  // Format string with absl::Substitute-style placeholders "$0" to "$9".
+  const char* format = "";
+};
+
 class LogSinkInterface {
  public:
   static constexpr size_t kLogMessageMaxSize = 2048 - 1;
@@ -47,6 +60,16 @@ class LogSinkInterface {
   // It is forbidden to call INTRINSIC_RT_LOG inside this function or call Log
   // recursively.
   virtual void Log(const LogEntry& entry) = 0;
+
+  // Writes a log entry whose message is described by `site->format` and the
+  // arguments in `packed_args` (see BinaryLogArgs). `site` outlives the sink.
+  // Sinks that can defer formatting to a lower-priority thread should override
+  // this. The default implementation formats the message right away and calls
+  // Log().
+  // The same restrictions as for Log() apply.
+  virtual void LogBinary(const BinaryLogSite& site, int64_t robot_timestamp_ns,
+                         int64_t wall_timestamp_ns,
+                         absl::Span<const uint8_t> packed_args);
 };
 
 // Returns the string name for priority.
@@ -63,6 +86,14 @@ int LogEntryFormatToBuffer(char* buffer, int buffer_size,
                            const LogSinkInterface::LogEntry& entry,
                            absl::TimeZone timezone = absl::UTCTimeZone());
 
+// Fills `entry` with the message of a binary log record (see
+// LogSinkInterface::LogBinary).
+// Does not allocate.
+void LogEntryFromBinary(const BinaryLogSite& site, int64_t robot_timestamp_ns,
+                        int64_t wall_timestamp_ns,
+                        absl::Span<const uint8_t> packed_args,
+                        LogSinkInterface::LogEntry& entry);
+
 // A default logger class that writes the log to standard error.
 class StderrLogSink : public LogSinkInterface {
  public:
@@ -54,6 +54,35 @@ TEST(IconUtilsLogTest, LogsSeverityLineFilename) {
                         HasSubstr("log_test.cc"), HasSubstr("dof:3 d:0.5"))));
 }
 
+TEST(IconUtilsLogTest, BinaryLogFormatsMessage) {
+  auto unique_logger = std::make_unique<FakeLogger>();
+  auto* logger = unique_logger.get();
+  GlobalLogContext::SetThreadLocalLogSink(std::move(unique_logger));
+  std::string s = "text";
+  INTRINSIC_RT_BINARY_LOG(ERROR, "dof:$0 d:$1 $2 $3", 3, 0.5, s, false);
+  auto location = INTRINSIC_LOC;
+  std::string expected_line_number = absl::StrCat(":", location.line() - 1);
+  INTRINSIC_RT_BINARY_LOG(INFO, "no arguments");
+  EXPECT_THAT(logger->messages_,
+              ElementsAre(StrEq("dof:3 d:0.5 text false"),
+                          StrEq("no arguments")));
+  EXPECT_THAT(logger->text_,
+              ElementsAre(AllOf(StartsWith("E"),
+                                HasSubstr(expected_line_number),
+                                HasSubstr("log_test.cc"),
+                                HasSubstr("dof:3 d:0.5 text false")),
+                          StartsWith("I")));
+}
+
+TEST(IconUtilsLogTest, BinaryLogDoesNotAllocate) {
+  GlobalLogContext::SetThreadLocalLogSink(nullptr);
+  RtLogInitForThisThread();
+  std::string s = "text";
+  for (int i = 0; i < 2000; ++i) {
+    INTRINSIC_RT_BINARY_LOG(INFO, "i:$0 d:$1 s:$2", i, 0.5, s);
+  }
+}
+
 TEST(IconUtilsLogTest, Throttles) {
   auto unique_logger = std::make_unique<FakeLogger>();
   auto* logger = unique_logger.get();
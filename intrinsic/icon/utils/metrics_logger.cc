@@ -2,53 +2,204 @@
 
 #include "intrinsic/icon/utils/metrics_logger.h"
 
+#include <time.h>
+
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "google/protobuf/struct.pb.h"
+#include "intrinsic/icon/interprocess/log2_histogram.h"
 #include "intrinsic/logging/data_logger_client.h"
 #include "intrinsic/logging/proto/log_item.pb.h"
 #include "intrinsic/performance/analysis/proto/performance_metrics.pb.h"
-#include "intrinsic/platform/common/buffers/realtime_write_queue.h"
+#include "intrinsic/util/page_fault_info.h"
 #include "intrinsic/util/status/status_macros.h"
 #include "intrinsic/util/thread/thread.h"
 
-using intrinsic_proto::data_logger::LogItem;
-using intrinsic_proto::performance::analysis::proto::PerformanceMetrics;
-
 namespace intrinsic::icon {
+namespace {
+
+int64_t MonotonicNowNs() {
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return int64_t{now.tv_sec} * 1'000'000'000 + now.tv_nsec;
+}
+
+}  // namespace
+
+absl::Duration CycleMetricsHistogram::Snapshot::Percentile(
+    double quantile) const {
+  return Log2HistogramPercentile(buckets, max_ns, quantile);
+}
+
+absl::Duration CycleMetricsHistogram::Snapshot::Mean() const {
+  if (count == 0) {
+    return absl::ZeroDuration();
+  }
+  return absl::Nanoseconds(sum_ns) / static_cast<double>(count);
+}
+
+void CycleMetricsHistogram::Record(int64_t duration_ns) {
+  duration_ns = std::max<int64_t>(duration_ns, 0);
+  buckets_[Log2HistogramBucket(duration_ns)].fetch_add(
+      1, std::memory_order_relaxed);
+  sum_ns_.fetch_add(duration_ns, std::memory_order_relaxed);
+  // Single writer, so a plain store is enough. A concurrent TakeSnapshot()
+  // might reset the maximum in between, which only loses a single value for
+  // the maximum of the next period.
+  if (duration_ns > max_ns_.load(std::memory_order_relaxed)) {
+    max_ns_.store(duration_ns, std::memory_order_relaxed);
+  }
+}
+
+CycleMetricsHistogram::Snapshot CycleMetricsHistogram::TakeSnapshot() {
+  Snapshot snapshot;
+  for (size_t i = 0; i < kNumBuckets; ++i) {
+    const uint64_t bucket = buckets_[i].load(std::memory_order_relaxed);
+    snapshot.buckets[i] = bucket - previous_buckets_[i];
+    snapshot.count += snapshot.buckets[i];
+    previous_buckets_[i] = bucket;
+  }
+  const int64_t sum_ns = sum_ns_.load(std::memory_order_relaxed);
+  snapshot.sum_ns = sum_ns - previous_sum_ns_;
+  previous_sum_ns_ = sum_ns;
+  snapshot.max_ns = max_ns_.exchange(0, std::memory_order_relaxed);
+  return snapshot;
+}
 
-static constexpr std::size_t kRtQueueSize = 1000;
+CycleMetricsRecorder::CycleMetricsRecorder(absl::Duration cycle_period,
+                                           int page_fault_sample_interval)
+    : cycle_period_(cycle_period),
+      cycle_period_ns_(absl::ToInt64Nanoseconds(cycle_period)),
+      page_fault_sample_interval_(std::max(page_fault_sample_interval, 1)) {}
+
+void CycleMetricsRecorder::StartCycle() {
+  previous_cycle_start_ns_ = cycle_start_ns_;
+  cycle_start_ns_ = MonotonicNowNs();
+  if (previous_cycle_start_ns_ == 0) {
+    return;
+  }
+  const int64_t duration_ns = cycle_start_ns_ - previous_cycle_start_ns_;
+  cycle_duration_.Record(duration_ns);
+  jitter_.Record(duration_ns > cycle_period_ns_
+                     ? duration_ns - cycle_period_ns_
+                     : cycle_period_ns_ - duration_ns);
+}
+
+void CycleMetricsRecorder::EndCycle() {
+  const int64_t execution_time_ns = MonotonicNowNs() - cycle_start_ns_;
+  execution_time_.Record(execution_time_ns);
+  const bool started_late =
+      previous_cycle_start_ns_ != 0 &&
+      cycle_start_ns_ - previous_cycle_start_ns_ > 2 * cycle_period_ns_;
+  if (started_late || execution_time_ns > cycle_period_ns_) {
+    deadline_misses_.fetch_add(1, std::memory_order_relaxed);
+  }
+  cycles_.fetch_add(1, std::memory_order_relaxed);
+
+  if (++cycles_since_page_fault_sample_ < page_fault_sample_interval_ &&
+      page_faults_initialized_) {
+    return;
+  }
+  cycles_since_page_fault_sample_ = 0;
+  const PagefaultInfo page_faults = GetPagefaultInfo();
+  if (page_faults_initialized_) {
+    minor_page_faults_.fetch_add(
+        page_faults.minor_faults - previous_minor_faults_,
+        std::memory_order_relaxed);
+    major_page_faults_.fetch_add(
+        page_faults.major_faults - previous_major_faults_,
+        std::memory_order_relaxed);
+  }
+  previous_minor_faults_ = page_faults.minor_faults;
+  previous_major_faults_ = page_faults.major_faults;
+  page_faults_initialized_ = true;
+}
+
+MetricsLogger::MetricsLogger(std::string module_name)
+    : MetricsLogger(std::move(module_name), Options()) {}
+
+MetricsLogger::MetricsLogger(std::string module_name, Options options)
+    : module_name_(std::move(module_name)), options_(std::move(options)) {
+  if (!options_.log_function) {
+    options_.log_function = [](LogItem&& item) {
+      data_logger::LogAsync(std::move(item));
+    };
+  }
+}
 
 MetricsLogger::~MetricsLogger() {
   if (metrics_publisher_thread_.Joinable()) {
-    shutdown_requested_.store(true);
+    shutdown_requested_.Notify();
     metrics_publisher_thread_.Join();
   }
 }
 
+absl::StatusOr<CycleMetricsRecorder*> MetricsLogger::AddRecorder(
+    absl::string_view name, absl::Duration cycle_period) {
+  if (cycle_period <= absl::ZeroDuration()) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Cycle period for metrics of '", name,
+                     "' must be positive, got ",
+                     absl::FormatDuration(cycle_period)));
+  }
+  absl::MutexLock lock(&mutex_);
+  recorders_.push_back(
+      {.name = std::string(name),
+       .recorder = std::make_unique<CycleMetricsRecorder>(
+           cycle_period, options_.page_fault_sample_interval)});
+  return recorders_.back().recorder.get();
+}
+
 absl::Status MetricsLogger::Start() {
   if (metrics_publisher_thread_.Joinable()) {
     return absl::FailedPreconditionError(
         "Metrics publisher thread is already running");
   }
+  if (options_.publish_period <= absl::ZeroDuration()) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Publish period must be positive, got ",
+                     absl::FormatDuration(options_.publish_period)));
+  }
 
   intrinsic::Thread::Options options;
   options.SetNormalPriorityAndScheduler();
   options.SetName("metrics_publisher_thread_");
-  shutdown_requested_.store(false);
   INTR_RETURN_IF_ERROR(
       metrics_publisher_thread_.Start(options, [this]() { LoggerFunction(); }));
 
   return absl::OkStatus();
 }
+
 void MetricsLogger::LoggerFunction() {
-  // Read the queue until empty
-  while (!shutdown_requested_.load()) {
-    // Build performance metrics log
-    LogItem log_item = BuildMetricsLog();
+  absl::Time next_publish_time = absl::Now() + options_.publish_period;
+  while (!shutdown_requested_.WaitForNotificationWithDeadline(
+      next_publish_time)) {
+    PublishMetrics();
+    next_publish_time += options_.publish_period;
+  }
+  // Publish what has been recorded since the last period.
+  PublishMetrics();
+}
+
+void MetricsLogger::PublishMetrics() {
+  absl::MutexLock lock(&mutex_);
+  for (const NamedRecorder& named_recorder : recorders_) {
+    options_.log_function(BuildMetricsLog(named_recorder));
   }
 }
 
@@ -57,18 +208,81 @@ void InsertNumericField(PerformanceMetrics& perf_metrics,
                         std::string field_name, double field_value) {
   google::protobuf::Value field_value_proto;
   field_value_proto.set_number_value(field_value);
-  perf_metrics.mutable_metrics()->mutable_metrics()->mutable_fields()->insert(
-      std::make_pair(field_name, field_value_proto));
+  (*perf_metrics.mutable_metrics()->mutable_metrics()->mutable_fields())
+      [field_name] = std::move(field_value_proto);
 }
 
 void InsertStringField(PerformanceMetrics& perf_metrics, std::string field_name,
                        std::string field_value) {
   google::protobuf::Value field_value_proto;
   field_value_proto.set_string_value(field_value);
-  perf_metrics.mutable_metrics()->mutable_metrics()->mutable_fields()->insert(
-      std::make_pair(field_name, field_value_proto));
+  (*perf_metrics.mutable_metrics()->mutable_metrics()->mutable_fields())
+      [field_name] = std::move(field_value_proto);
+}
+
+// Inserts the mean, p50, p99 and max of `snapshot` in microseconds.
+void InsertDurationFields(PerformanceMetrics& perf_metrics,
+                          absl::string_view name,
+                          const CycleMetricsHistogram::Snapshot& snapshot) {
+  if (snapshot.count == 0) {
+    return;
+  }
+  InsertNumericField(perf_metrics, absl::StrCat(name, "_mean_us"),
+                     absl::ToDoubleMicroseconds(snapshot.Mean()));
+  InsertNumericField(perf_metrics, absl::StrCat(name, "_p50_us"),
+                     absl::ToDoubleMicroseconds(snapshot.Percentile(0.5)));
+  InsertNumericField(perf_metrics, absl::StrCat(name, "_p99_us"),
+                     absl::ToDoubleMicroseconds(snapshot.Percentile(0.99)));
+  InsertNumericField(
+      perf_metrics, absl::StrCat(name, "_max_us"),
+      absl::ToDoubleMicroseconds(absl::Nanoseconds(snapshot.max_ns)));
 }
 
-LogItem MetricsLogger::BuildMetricsLog() {}
+LogItem MetricsLogger::BuildMetricsLog(const NamedRecorder& named_recorder) {
+  CycleMetricsRecorder& recorder = *named_recorder.recorder;
+  PerformanceMetrics perf_metrics;
+  perf_metrics.set_app_name(module_name_);
+  perf_metrics.set_metric_name(named_recorder.name);
+  perf_metrics.set_cycle_number(
+      absl::StrCat(recorder.cycles_.load(std::memory_order_relaxed)));
+
+  InsertStringField(perf_metrics, "module", module_name_);
+  InsertNumericField(perf_metrics, "cycle_period_us",
+                     absl::ToDoubleMicroseconds(recorder.cycle_period()));
+  InsertNumericField(perf_metrics, "publish_period_s",
+                     absl::ToDoubleSeconds(options_.publish_period));
+  const CycleMetricsHistogram::Snapshot cycle_duration =
+      recorder.cycle_duration_.TakeSnapshot();
+  InsertNumericField(perf_metrics, "cycles", cycle_duration.count);
+  InsertDurationFields(perf_metrics, "cycle_duration", cycle_duration);
+  InsertDurationFields(perf_metrics, "jitter",
+                       recorder.jitter_.TakeSnapshot());
+  InsertDurationFields(perf_metrics, "execution_time",
+                       recorder.execution_time_.TakeSnapshot());
+  InsertDurationFields(perf_metrics, "read_status",
+                       recorder.read_status_.TakeSnapshot());
+  InsertDurationFields(perf_metrics, "apply_command",
+                       recorder.apply_command_.TakeSnapshot());
+  InsertNumericField(
+      perf_metrics, "deadline_misses",
+      recorder.deadline_misses_.exchange(0, std::memory_order_relaxed));
+  InsertNumericField(
+      perf_metrics, "minor_page_faults",
+      recorder.minor_page_faults_.exchange(0, std::memory_order_relaxed));
+  InsertNumericField(
+      perf_metrics, "major_page_faults",
+      recorder.major_page_faults_.exchange(0, std::memory_order_relaxed));
+
+  LogItem log_item;
+  log_item.mutable_metadata()->set_event_source(options_.event_source);
+  const absl::Time now = absl::Now();
+  log_item.mutable_metadata()->mutable_acquisition_time()->set_seconds(
+      absl::ToUnixSeconds(now));
+  log_item.mutable_metadata()->mutable_acquisition_time()->set_nanos(
+      (now - absl::FromUnixSeconds(absl::ToUnixSeconds(now))) /
+      absl::Nanoseconds(1));
+  log_item.mutable_payload()->mutable_any()->PackFrom(perf_metrics);
+  return log_item;
+}
 
 }  // namespace intrinsic::icon
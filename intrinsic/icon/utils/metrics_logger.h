@@ -3,16 +3,26 @@
 #ifndef INTRINSIC_ICON_UTILS_METRICS_LOGGER_H_
 #define INTRINSIC_ICON_UTILS_METRICS_LOGGER_H_
 
-#include <stdbool.h>
-
+#include <array>
 #include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <string>
+#include <vector>
 
+#include "absl/base/thread_annotations.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/time.h"
+#include "intrinsic/icon/interprocess/log2_histogram.h"
 #include "intrinsic/icon/testing/realtime_annotations.h"
 #include "intrinsic/logging/proto/log_item.pb.h"
 #include "intrinsic/performance/analysis/proto/performance_metrics.pb.h"
-#include "intrinsic/platform/common/buffers/realtime_write_queue.h"
 #include "intrinsic/util/thread/thread.h"
 
 namespace intrinsic::icon {
@@ -20,28 +30,181 @@ namespace intrinsic::icon {
 using ::intrinsic_proto::data_logger::LogItem;
 using ::intrinsic_proto::performance::analysis::proto::PerformanceMetrics;
 
-// A non-realtime logger that can be used to log messages from realtime
-// contexts.
+// Histogram of durations, written by a single realtime thread and read by the
+// metrics publisher.
+//
+// The buckets are powers of two in nanoseconds, see
+// intrinsic/icon/interprocess/log2_histogram.h.
+//
+// Recording is lock-free and realtime safe. The publisher reads the values
+// recorded since its previous read with TakeSnapshot().
+class CycleMetricsHistogram {
+ public:
+  static constexpr size_t kNumBuckets = kNumLog2HistogramBuckets;
+
+  // Values recorded in a publish period.
+  struct Snapshot {
+    std::array<uint64_t, kNumBuckets> buckets = {};
+    uint64_t count = 0;
+    int64_t sum_ns = 0;
+    int64_t max_ns = 0;
+
+    // Returns an upper bound of the `quantile` (in [0, 1]), see
+    // Log2HistogramPercentile(), or zero if there are no values.
+    absl::Duration Percentile(double quantile) const;
+    // Returns the mean, or zero if there are no values.
+    absl::Duration Mean() const;
+  };
+
+  CycleMetricsHistogram() = default;
+  CycleMetricsHistogram(const CycleMetricsHistogram&) = delete;
+  CycleMetricsHistogram& operator=(const CycleMetricsHistogram&) = delete;
+
+  // Records a duration. Negative durations are recorded as zero.
+  // Realtime safe, but must only be called from one thread at a time.
+  void Record(int64_t duration_ns) INTRINSIC_CHECK_REALTIME_SAFE;
+
+  // Returns the values recorded since the previous call.
+  // Must only be called from one thread at a time, concurrent calls to
+  // Record() are allowed.
+  Snapshot TakeSnapshot();
+
+ private:
+  std::array<std::atomic<uint64_t>, kNumBuckets> buckets_ = {};
+  std::atomic<int64_t> sum_ns_ = 0;
+  // Largest value since the previous snapshot.
+  std::atomic<int64_t> max_ns_ = 0;
+  // Cumulative values at the previous snapshot. Only used by TakeSnapshot().
+  std::array<uint64_t, kNumBuckets> previous_buckets_ = {};
+  int64_t previous_sum_ns_ = 0;
+};
+
+// Records the timing of the cycles of one realtime thread.
+//
+// Call StartCycle() at the beginning of every cycle and EndCycle() when the
+// work of the cycle is done. The recorder derives
+// * the cycle duration, i.e. the time between two consecutive StartCycle()
+//   calls,
+// * the jitter, i.e. the deviation of the cycle duration from the nominal
+//   cycle period,
+// * the execution time from StartCycle() to EndCycle(), and
+// * the number of deadline misses, i.e. cycles whose execution time exceeds
+//   the cycle period, or whose start is more than one period late.
+// Optionally, record the time of the ReadStatus and ApplyCommand phases.
+//
+// EndCycle() also samples the page faults of the calling thread every
+// `page_fault_sample_interval` cycles (see GetPagefaultInfo()).
+//
+// All recording functions are realtime safe, but must be called from the same
+// thread.
+class CycleMetricsRecorder {
+ public:
+  CycleMetricsRecorder(absl::Duration cycle_period,
+                       int page_fault_sample_interval);
+
+  // Marks the start of a cycle.
+  void StartCycle() INTRINSIC_CHECK_REALTIME_SAFE;
+  // Marks the end of the work of the current cycle.
+  void EndCycle() INTRINSIC_CHECK_REALTIME_SAFE;
+
+  void RecordReadStatus(absl::Duration duration) INTRINSIC_CHECK_REALTIME_SAFE {
+    read_status_.Record(absl::ToInt64Nanoseconds(duration));
+  }
+  void RecordApplyCommand(absl::Duration duration)
+      INTRINSIC_CHECK_REALTIME_SAFE {
+    apply_command_.Record(absl::ToInt64Nanoseconds(duration));
+  }
+
+  absl::Duration cycle_period() const { return cycle_period_; }
+
+ private:
+  friend class MetricsLogger;
+
+  const absl::Duration cycle_period_;
+  const int64_t cycle_period_ns_;
+  const int page_fault_sample_interval_;
+
+  CycleMetricsHistogram cycle_duration_;
+  CycleMetricsHistogram jitter_;
+  CycleMetricsHistogram execution_time_;
+  CycleMetricsHistogram read_status_;
+  CycleMetricsHistogram apply_command_;
+  std::atomic<uint64_t> cycles_ = 0;
+  std::atomic<uint64_t> deadline_misses_ = 0;
+  std::atomic<uint64_t> minor_page_faults_ = 0;
+  std::atomic<uint64_t> major_page_faults_ = 0;
+
+  // State of the recording thread.
+  int64_t cycle_start_ns_ = 0;
+  int64_t previous_cycle_start_ns_ = 0;
+  uint64_t cycles_since_page_fault_sample_ = 0;
+  uint64_t previous_minor_faults_ = 0;
+  uint64_t previous_major_faults_ = 0;
+  bool page_faults_initialized_ = false;
+};
+
+// Publishes the cycle metrics of realtime threads.
+//
+// Realtime threads record their cycles into a CycleMetricsRecorder each. A
+// non-realtime publisher thread aggregates all recorders every
+// `publish_period` into one `PerformanceMetrics` LogItem per recorder and
+// sends it to the data logger.
 class MetricsLogger {
  public:
+  struct Options {
+    // Period at which the metrics are aggregated and published.
+    absl::Duration publish_period = absl::Seconds(10);
+    // Number of cycles between two samples of the page fault counters. Reading
+    // them is a system call, so don't sample in every cycle.
+    int page_fault_sample_interval = 100;
+    // Event source of the published LogItems.
+    std::string event_source = "icon_performance_metrics";
+    // Sends the LogItems. Defaults to `data_logger::LogAsync`.
+    std::function<void(LogItem&&)> log_function;
+  };
+
   explicit MetricsLogger(std::string module_name);
+  MetricsLogger(std::string module_name, Options options);
 
+  // Stops the publisher thread, if it is running.
   ~MetricsLogger();
 
-  // Starts the metrics logger thread
+  // Adds a recorder for a realtime thread with the nominal `cycle_period`.
+  // `name` is published as the metric name. The returned recorder is owned by
+  // this logger.
+  // Not realtime safe.
+  absl::StatusOr<CycleMetricsRecorder*> AddRecorder(
+      absl::string_view name, absl::Duration cycle_period);
+
+  // Starts the metrics publisher thread.
   absl::Status Start();
 
+  // Aggregates the metrics recorded since the previous call and publishes
+  // them. Called periodically by the publisher thread.
+  // Not realtime safe.
+  void PublishMetrics();
+
  private:
+  struct NamedRecorder {
+    std::string name;
+    std::unique_ptr<CycleMetricsRecorder> recorder;
+  };
+
   // Thread function
   void LoggerFunction();
-  LogItem BuildMetricsLog();
-  //  Thread to publish metrics (non-real-time)
-  intrinsic::Thread metrics_publisher_thread_;
-  // Atomic flag to enable/disable the metrics thread.
-  std::atomic<bool> shutdown_requested_;
+  LogItem BuildMetricsLog(const NamedRecorder& named_recorder);
+
   // The name of the module that is logging metrics
   std::string module_name_;
+  Options options_;
+  absl::Mutex mutex_;
+  std::vector<NamedRecorder> recorders_ ABSL_GUARDED_BY(mutex_);
+  // Notified to stop the metrics thread.
+  absl::Notification shutdown_requested_;
+  //  Thread to publish metrics (non-real-time)
+  intrinsic::Thread metrics_publisher_thread_;
 };
+
 }  // namespace intrinsic::icon
 
 #endif  // INTRINSIC_ICON_UTILS_METRICS_LOGGER_H_
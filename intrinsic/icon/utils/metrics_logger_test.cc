@@ -0,0 +1,162 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/icon/utils/metrics_logger.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "google/protobuf/struct.pb.h"
+#include "intrinsic/logging/proto/log_item.pb.h"
+#include "intrinsic/performance/analysis/proto/performance_metrics.pb.h"
+#include "intrinsic/util/testing/gtest_wrapper.h"
+
+namespace intrinsic::icon {
+namespace {
+
+using ::intrinsic::testing::StatusIs;
+using ::testing::Contains;
+using ::testing::Key;
+using ::testing::Not;
+using ::testing::SizeIs;
+
+// Collects the metrics that a MetricsLogger publishes.
+class MetricsCollector {
+ public:
+  MetricsLogger::Options Options(absl::Duration publish_period) {
+    return {.publish_period = publish_period,
+            .page_fault_sample_interval = 1,
+            .log_function = [this](LogItem&& item) {
+              PerformanceMetrics metrics;
+              EXPECT_EQ(item.metadata().event_source(),
+                        "icon_performance_metrics");
+              EXPECT_TRUE(item.payload().any().UnpackTo(&metrics));
+              absl::MutexLock lock(&mutex_);
+              metrics_.push_back(std::move(metrics));
+            }};
+  }
+
+  std::vector<PerformanceMetrics> metrics() {
+    absl::MutexLock lock(&mutex_);
+    return metrics_;
+  }
+
+ private:
+  absl::Mutex mutex_;
+  std::vector<PerformanceMetrics> metrics_ ABSL_GUARDED_BY(mutex_);
+};
+
+double Field(const PerformanceMetrics& metrics, const std::string& name) {
+  const auto& fields = metrics.metrics().metrics().fields();
+  auto it = fields.find(name);
+  EXPECT_NE(it, fields.end()) << name;
+  return it == fields.end() ? 0.0 : it->second.number_value();
+}
+
+TEST(CycleMetricsHistogramTest, ReportsValuesSincePreviousSnapshot) {
+  CycleMetricsHistogram histogram;
+  for (int i = 0; i < 99; ++i) {
+    histogram.Record(1000);
+  }
+  histogram.Record(1'000'000);
+
+  CycleMetricsHistogram::Snapshot snapshot = histogram.TakeSnapshot();
+  EXPECT_EQ(snapshot.count, 100);
+  EXPECT_EQ(snapshot.max_ns, 1'000'000);
+  EXPECT_EQ(snapshot.Mean(), absl::Nanoseconds(10990));
+  // Percentiles are the upper bound of their power of two bucket.
+  EXPECT_EQ(snapshot.Percentile(0.5), absl::Nanoseconds(1024));
+  EXPECT_EQ(snapshot.Percentile(0.99), absl::Nanoseconds(1024));
+  EXPECT_EQ(snapshot.Percentile(1.0), absl::Nanoseconds(1'000'000));
+
+  histogram.Record(-5);
+  snapshot = histogram.TakeSnapshot();
+  EXPECT_EQ(snapshot.count, 1);
+  EXPECT_EQ(snapshot.max_ns, 0);
+  EXPECT_EQ(snapshot.Percentile(0.5), absl::ZeroDuration());
+
+  snapshot = histogram.TakeSnapshot();
+  EXPECT_EQ(snapshot.count, 0);
+  EXPECT_EQ(snapshot.Mean(), absl::ZeroDuration());
+}
+
+TEST(MetricsLoggerTest, RejectsInvalidCyclePeriod) {
+  MetricsLogger logger("test_module");
+  EXPECT_THAT(logger.AddRecorder("rt_loop", absl::ZeroDuration()),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(MetricsLoggerTest, PublishesCycleMetrics) {
+  MetricsCollector collector;
+  MetricsLogger logger("test_module", collector.Options(absl::Hours(1)));
+  ASSERT_OK_AND_ASSIGN(CycleMetricsRecorder * recorder,
+                       logger.AddRecorder("rt_loop", absl::Milliseconds(1)));
+  for (int i = 0; i < 3; ++i) {
+    recorder->StartCycle();
+    recorder->RecordReadStatus(absl::Microseconds(20));
+    recorder->RecordApplyCommand(absl::Microseconds(30));
+    recorder->EndCycle();
+  }
+  // The execution time of this cycle exceeds the cycle period.
+  recorder->StartCycle();
+  absl::SleepFor(absl::Milliseconds(2));
+  recorder->EndCycle();
+
+  logger.PublishMetrics();
+  std::vector<PerformanceMetrics> metrics = collector.metrics();
+  ASSERT_THAT(metrics, SizeIs(1));
+  EXPECT_EQ(metrics[0].app_name(), "test_module");
+  EXPECT_EQ(metrics[0].metric_name(), "rt_loop");
+  EXPECT_EQ(metrics[0].cycle_number(), "4");
+  EXPECT_EQ(Field(metrics[0], "cycle_period_us"), 1000.0);
+  // The first cycle has no predecessor, so there are three cycle durations.
+  EXPECT_EQ(Field(metrics[0], "cycles"), 3.0);
+  EXPECT_EQ(Field(metrics[0], "deadline_misses"), 1.0);
+  EXPECT_GE(Field(metrics[0], "execution_time_max_us"), 2000.0);
+  EXPECT_EQ(Field(metrics[0], "read_status_mean_us"), 20.0);
+  EXPECT_EQ(Field(metrics[0], "apply_command_max_us"), 30.0);
+  EXPECT_GE(Field(metrics[0], "jitter_max_us"), 0.0);
+  EXPECT_GE(Field(metrics[0], "minor_page_faults"), 0.0);
+  EXPECT_GE(Field(metrics[0], "major_page_faults"), 0.0);
+
+  // The next publication only contains the counters since the previous one.
+  logger.PublishMetrics();
+  metrics = collector.metrics();
+  ASSERT_THAT(metrics, SizeIs(2));
+  EXPECT_EQ(metrics[1].cycle_number(), "4");
+  EXPECT_EQ(Field(metrics[1], "cycles"), 0.0);
+  EXPECT_EQ(Field(metrics[1], "deadline_misses"), 0.0);
+  EXPECT_THAT(metrics[1].metrics().metrics().fields(),
+              Not(Contains(Key("execution_time_max_us"))));
+}
+
+TEST(MetricsLoggerTest, PublishesPeriodically) {
+  MetricsCollector collector;
+  {
+    MetricsLogger logger("test_module",
+                         collector.Options(absl::Milliseconds(10)));
+    ASSERT_OK(logger.AddRecorder("first", absl::Milliseconds(1)).status());
+    ASSERT_OK(logger.AddRecorder("second", absl::Milliseconds(4)).status());
+    ASSERT_OK(logger.Start());
+    EXPECT_THAT(logger.Start(),
+                StatusIs(absl::StatusCode::kFailedPrecondition));
+    absl::SleepFor(absl::Milliseconds(50));
+  }
+  // Publishes once more on shutdown.
+  std::vector<PerformanceMetrics> metrics = collector.metrics();
+  ASSERT_THAT(metrics, Not(SizeIs(0)));
+  EXPECT_EQ(metrics.size() % 2, 0);
+  EXPECT_EQ(metrics[0].metric_name(), "first");
+  EXPECT_EQ(metrics[1].metric_name(), "second");
+}
+
+}  // namespace
+}  // namespace intrinsic::icon
@@ -5,34 +5,74 @@
 #include <errno.h>
 #include <pthread.h>
 #include <sched.h>
+#include <sys/uio.h>
+#include <unistd.h>
 
 #include <algorithm>
+#include <array>
 #include <atomic>
-#include <cstdio>
+#include <cstddef>
+#include <cstdint>
 #include <cstring>
-#include <iostream>
 #include <memory>
-#include <ostream>
 #include <thread>  // NOLINT(build/c++11)
 #include <utility>
 
 #include "absl/base/thread_annotations.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/synchronization/notification.h"
 #include "absl/time/time.h"
+#include "absl/types/span.h"
 #include "intrinsic/icon/interprocess/binary_futex.h"
+#include "intrinsic/icon/utils/binary_log_file.h"
+#include "intrinsic/icon/utils/log_internal.h"
 #include "intrinsic/icon/utils/log_sink.h"
 #include "intrinsic/icon/utils/realtime_guard.h"
-#include "intrinsic/platform/common/buffers/realtime_write_queue.h"
+#include "intrinsic/platform/common/buffers/spsc_byte_ring.h"
 
 namespace intrinsic::icon {
+namespace {
+
+// Header of every message in the byte ring of a RealtimeLogSink. Followed by
+// the message of a text record or the packed arguments of a binary record.
+struct QueuedRecord {
+  int64_t robot_timestamp_ns;
+  int64_t wall_timestamp_ns;
+  // Call site of a binary record, nullptr for a text record.
+  const BinaryLogSite* site;
+  // Only set for text records.
+  const char* filename;
+  int32_t line;
+  LogPriority priority;
+};
+
+// Maximum number of lines written by one writev() call.
+constexpr int kMaxBatchLines = 64;
+// Size of the buffer for one formatted line.
+constexpr int kLineSize = LogSinkInterface::kLogMessageMaxSize + 1;
+
+}  // namespace
+
+struct RealtimeLogSink::Queue {
+  SpscByteRing ring{RealtimeLogSink::kBufferSize};
+  // Number of messages that were dropped because the ring was full.
+  std::atomic<uint64_t> dropped = 0;
+  // Number of dropped messages that have been reported. Only accessed by the
+  // GlobalLogSink.
+  uint64_t reported_dropped = 0;
+};
 
 class GlobalLogSink {
  public:
   GlobalLogSink()
-      : reader_thread_([this]() {
+      : entry_(std::make_unique<LogSinkInterface::LogEntry>()),
+        lines_(std::make_unique<char[]>(kMaxBatchLines * kLineSize)),
+        reader_thread_([this]() {
           reader_thread_started_.Notify();
           Run();
         }) {
@@ -55,76 +95,235 @@ class GlobalLogSink {
     if (reader_thread_.joinable()) reader_thread_.join();
   }
 
-  RealtimeWriteQueue<LogSinkInterface::LogEntry>::RtWriter* CreateWriter() {
+  RealtimeLogSink::Queue* CreateQueue() {
     absl::MutexLock lock(&mutex_);
-    auto queue =
-        std::make_unique<RealtimeWriteQueue<LogSinkInterface::LogEntry>>(
-            /*capacity=*/1000);
-    auto* writer = &queue->Writer();
-    queues_[writer] = std::move(queue);
-    return writer;
+    auto queue = std::make_unique<RealtimeLogSink::Queue>();
+    auto* queue_ptr = queue.get();
+    queues_[queue_ptr] = std::move(queue);
+    return queue_ptr;
   }
 
-  void RemoveWriter(
-      RealtimeWriteQueue<LogSinkInterface::LogEntry>::RtWriter* writer) {
+  void RemoveQueue(RealtimeLogSink::Queue* queue) {
     absl::MutexLock lock(&mutex_);
-    FlushAndRemoveWriter(writer);
+    DrainQueue(*queue);
+    WriteLines();
+    queues_.erase(queue);
   }
 
   void Run() {
     while (true) {
-      (void)notify_reader_.WaitFor(absl::InfiniteDuration());
-      if (stop_reader_thread_) break;
-      absl::MutexLock lock(&mutex_);
-      for (auto& [_, queue] : queues_) {
-        if (queue->Reader().Empty()) continue;
-        LogSinkInterface::LogEntry entry;
-        // Do not wait.
-        auto result =
-            queue->Reader().ReadWithTimeout(entry, absl::InfinitePast());
-        if (result != ReadResult::kConsumed) continue;
-        char buffer[LogSinkInterface::kLogMessageMaxSize];
-        LogEntryFormatToBuffer(buffer, sizeof(buffer), entry);
-        fprintf(stderr, "%s", buffer);
-        fflush(stderr);
-        if (!queue->Reader().Empty()) (void)notify_reader_.Post();
+      {
+        absl::MutexLock lock(&mutex_);
+        DrainQueues();
+        if (stop_reader_thread_) break;
+        // Pairs with the fence in Notify(): Either the writer sees that we are
+        // waiting, or we see its message here.
+        reader_waiting_.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!QueuesEmpty()) {
+          reader_waiting_.store(false, std::memory_order_relaxed);
+          continue;
+        }
       }
+      (void)notify_reader_.WaitFor(absl::InfiniteDuration());
+      reader_waiting_.store(false, std::memory_order_relaxed);
     }
     absl::MutexLock lock(&mutex_);
-    while (!queues_.empty()) {
-      FlushAndRemoveWriter(queues_.begin()->first);
-    }
+    queues_.clear();
   }
 
   // RT safe.
-  void Notify() { (void)notify_reader_.Post(); }
+  // Wakes up the reader thread, unless it is draining the queues anyway. Must
+  // be called after a message has been committed.
+  void Notify() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (reader_waiting_.load(std::memory_order_relaxed)) {
+      (void)notify_reader_.Post();
+    }
+  }
+
+  void Flush() {
+    absl::MutexLock lock(&mutex_);
+    DrainQueues();
+  }
+
+  absl::Status EnableBinaryFile(absl::string_view path, size_t max_size_bytes,
+                                bool write_to_stderr) {
+    auto binary_file = BinaryLogFileWriter::Create(path, max_size_bytes);
+    if (!binary_file.ok()) {
+      return binary_file.status();
+    }
+    absl::MutexLock lock(&mutex_);
+    DrainQueues();
+    binary_file_ = *std::move(binary_file);
+    binary_file_full_ = false;
+    write_to_stderr_ = write_to_stderr;
+    return absl::OkStatus();
+  }
+
+  void DisableBinaryFile() {
+    absl::MutexLock lock(&mutex_);
+    DrainQueues();
+    binary_file_.reset();
+    write_to_stderr_ = true;
+  }
 
  private:
-  void FlushAndRemoveWriter(
-      RealtimeWriteQueue<LogSinkInterface::LogEntry>::RtWriter* writer)
+  // Writes all queued messages.
+  void DrainQueues() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    for (auto& [queue, _] : queues_) {
+      DrainQueue(*queue);
+    }
+    WriteLines();
+  }
+
+  bool QueuesEmpty() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    for (const auto& [queue, _] : queues_) {
+      if (!queue->ring.Empty()) return false;
+    }
+    return true;
+  }
+
+  void DrainQueue(RealtimeLogSink::Queue& queue)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    for (absl::Span<const uint8_t> record = queue.ring.Front();
+         !record.empty(); record = queue.ring.Front()) {
+      QueuedRecord header;
+      std::memcpy(&header, record.data(), sizeof(header));
+      const absl::Span<const uint8_t> payload =
+          record.subspan(sizeof(QueuedRecord));
+      if (header.site != nullptr) {
+        OutputBinary(*header.site, header.robot_timestamp_ns,
+                     header.wall_timestamp_ns, payload);
+      } else {
+        LogSinkInterface::LogEntry& entry = *entry_;
+        entry.priority = header.priority;
+        entry.robot_timestamp_ns = header.robot_timestamp_ns;
+        entry.wall_timestamp_ns = header.wall_timestamp_ns;
+        entry.filename = header.filename;
+        entry.line = header.line;
+        entry.msglen = payload.size();
+        std::memcpy(entry.msg, payload.data(), payload.size());
+        entry.msg[payload.size()] = '\0';
+        OutputText(entry);
+      }
+      queue.ring.DropFront();
+    }
+    const uint64_t dropped = queue.dropped.load(std::memory_order_relaxed);
+    if (dropped != queue.reported_dropped) {
+      OutputWarning(
+          absl::StrCat("Dropped ", dropped - queue.reported_dropped,
+                       " log messages, because the log buffer was full."));
+      queue.reported_dropped = dropped;
+    }
+  }
+
+  void OutputBinary(const BinaryLogSite& site, int64_t robot_timestamp_ns,
+                    int64_t wall_timestamp_ns,
+                    absl::Span<const uint8_t> packed_args)
       ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
-    writer->Close();
-    auto& queue = queues_.find(writer)->second;
-    while (!queue->Reader().Empty()) {
-      LogSinkInterface::LogEntry entry;
-      auto result =
-          queue->Reader().ReadWithTimeout(entry, absl::InfinitePast());
-      if (result != ReadResult::kConsumed) break;
-      char buffer[LogSinkInterface::kLogMessageMaxSize];
-      LogEntryFormatToBuffer(buffer, sizeof(buffer), entry);
-      fprintf(stderr, "%s", buffer);
-      fflush(stderr);
+    if (binary_file_ != nullptr && !binary_file_full_ &&
+        !binary_file_->WriteBinary(site, robot_timestamp_ns,
+                                   wall_timestamp_ns, packed_args)) {
+      OnBinaryFileFull();
     }
-    queues_.erase(writer);
+    if (write_to_stderr_) {
+      LogEntryFromBinary(site, robot_timestamp_ns, wall_timestamp_ns,
+                         packed_args, *entry_);
+      AddLine(*entry_);
+    }
+  }
+
+  void OutputText(const LogSinkInterface::LogEntry& entry)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    if (binary_file_ != nullptr && !binary_file_full_ &&
+        !binary_file_->WriteText(entry)) {
+      OnBinaryFileFull();
+    }
+    if (write_to_stderr_) {
+      AddLine(entry);
+    }
+  }
+
+  // Reports a problem of the log sink itself.
+  void OutputWarning(absl::string_view message)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    // Not `entry_`, which might hold the message that caused the warning.
+    LogSinkInterface::LogEntry entry;
+    entry.priority = LogPriority::WARNING;
+    internal::LogGetTime(&entry.robot_timestamp_ns, &entry.wall_timestamp_ns);
+    entry.filename = __FILE__;
+    entry.line = __LINE__;
+    entry.msglen = std::min(message.size(), sizeof(entry.msg) - 1);
+    std::memcpy(entry.msg, message.data(), entry.msglen);
+    entry.msg[entry.msglen] = '\0';
+    OutputText(entry);
+  }
+
+  void OnBinaryFileFull() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    binary_file_full_ = true;
+    write_to_stderr_ = true;
+    OutputWarning(absl::StrCat("Binary log file is full after ",
+                               binary_file_->size(),
+                               " bytes, writing to stderr instead."));
+  }
+
+  // Formats `entry` into the next line buffer. Writes all buffered lines if
+  // there are no buffers left.
+  void AddLine(const LogSinkInterface::LogEntry& entry)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    char* line = &lines_[num_lines_ * kLineSize];
+    const int size = LogEntryFormatToBuffer(line, kLineSize, entry);
+    iovecs_[num_lines_] = {.iov_base = line,
+                           .iov_len = static_cast<size_t>(std::max(size, 0))};
+    if (++num_lines_ == kMaxBatchLines) {
+      WriteLines();
+    }
+  }
+
+  // Writes all buffered lines to stderr with as few system calls as possible.
+  void WriteLines() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    iovec* iov = iovecs_.data();
+    int count = num_lines_;
+    while (count > 0) {
+      const ssize_t written = writev(STDERR_FILENO, iov, count);
+      if (written < 0) {
+        if (errno == EINTR) continue;
+        break;
+      }
+      // Skip what has been written already.
+      size_t remaining = written;
+      while (count > 0 && remaining >= iov->iov_len) {
+        remaining -= iov->iov_len;
+        ++iov;
+        --count;
+      }
+      if (count > 0) {
+        iov->iov_base = static_cast<char*>(iov->iov_base) + remaining;
+        iov->iov_len -= remaining;
+      }
+    }
+    num_lines_ = 0;
   }
 
   absl::Mutex mutex_;
-  absl::flat_hash_map<
-      RealtimeWriteQueue<LogSinkInterface::LogEntry>::RtWriter*,
-      std::unique_ptr<RealtimeWriteQueue<LogSinkInterface::LogEntry>>>
+  absl::flat_hash_map<RealtimeLogSink::Queue*,
+                      std::unique_ptr<RealtimeLogSink::Queue>>
       queues_ ABSL_GUARDED_BY(mutex_);
+  // Optional binary output, see EnableRealtimeLogBinaryFile().
+  std::unique_ptr<BinaryLogFileWriter> binary_file_ ABSL_GUARDED_BY(mutex_);
+  bool binary_file_full_ ABSL_GUARDED_BY(mutex_) = false;
+  bool write_to_stderr_ ABSL_GUARDED_BY(mutex_) = true;
+  // Scratch entry for formatting.
+  std::unique_ptr<LogSinkInterface::LogEntry> entry_ ABSL_GUARDED_BY(mutex_);
+  // Formatted lines that have not been written yet.
+  std::unique_ptr<char[]> lines_ ABSL_GUARDED_BY(mutex_);
+  std::array<iovec, kMaxBatchLines> iovecs_ ABSL_GUARDED_BY(mutex_);
+  int num_lines_ ABSL_GUARDED_BY(mutex_) = 0;
   absl::Notification reader_thread_started_;
   std::atomic<bool> stop_reader_thread_ = false;
+  // True while the reader thread is (about to be) blocked on `notify_reader_`.
+  std::atomic<bool> reader_waiting_ = false;
   BinaryFutex notify_reader_;
   // We cannot use intrinsic::Thread here to avoid cyclic dependency.
   std::thread reader_thread_;
@@ -138,19 +337,72 @@ GlobalLogSink& GetGlobalLogSink() {
 
 RealtimeLogSink::RealtimeLogSink() {
   INTRINSIC_ASSERT_NON_REALTIME();
-  writer_ = GetGlobalLogSink().CreateWriter();
+  queue_ = GetGlobalLogSink().CreateQueue();
 }
 
 RealtimeLogSink::~RealtimeLogSink() {
   INTRINSIC_ASSERT_NON_REALTIME();
-  GetGlobalLogSink().RemoveWriter(writer_);
+  GetGlobalLogSink().RemoveQueue(queue_);
 }
 
 void RealtimeLogSink::Log(const LogEntry& entry) {
-  if (!writer_->Closed()) {
-    (void)writer_->Write(entry);
-    GetGlobalLogSink().Notify();
+  const size_t msglen =
+      std::clamp<size_t>(entry.msglen, 0, LogSinkInterface::kLogMessageMaxSize);
+  uint8_t* record = queue_->ring.PrepareWrite(sizeof(QueuedRecord) + msglen);
+  if (record == nullptr) {
+    queue_->dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
   }
+  const QueuedRecord header{.robot_timestamp_ns = entry.robot_timestamp_ns,
+                            .wall_timestamp_ns = entry.wall_timestamp_ns,
+                            .site = nullptr,
+                            .filename = entry.filename,
+                            .line = entry.line,
+                            .priority = entry.priority};
+  std::memcpy(record, &header, sizeof(header));
+  std::memcpy(record + sizeof(header), entry.msg, msglen);
+  queue_->ring.CommitWrite();
+  GetGlobalLogSink().Notify();
+}
+
+void RealtimeLogSink::LogBinary(const BinaryLogSite& site,
+                                int64_t robot_timestamp_ns,
+                                int64_t wall_timestamp_ns,
+                                absl::Span<const uint8_t> packed_args) {
+  uint8_t* record =
+      queue_->ring.PrepareWrite(sizeof(QueuedRecord) + packed_args.size());
+  if (record == nullptr) {
+    queue_->dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  const QueuedRecord header{.robot_timestamp_ns = robot_timestamp_ns,
+                            .wall_timestamp_ns = wall_timestamp_ns,
+                            .site = &site,
+                            .filename = site.filename,
+                            .line = site.line,
+                            .priority = site.priority};
+  std::memcpy(record, &header, sizeof(header));
+  std::memcpy(record + sizeof(header), packed_args.data(), packed_args.size());
+  queue_->ring.CommitWrite();
+  GetGlobalLogSink().Notify();
+}
+
+absl::Status EnableRealtimeLogBinaryFile(absl::string_view path,
+                                         size_t max_size_bytes,
+                                         bool write_to_stderr) {
+  INTRINSIC_ASSERT_NON_REALTIME();
+  return GetGlobalLogSink().EnableBinaryFile(path, max_size_bytes,
+                                             write_to_stderr);
+}
+
+void DisableRealtimeLogBinaryFile() {
+  INTRINSIC_ASSERT_NON_REALTIME();
+  GetGlobalLogSink().DisableBinaryFile();
+}
+
+void FlushRealtimeLogSinks() {
+  INTRINSIC_ASSERT_NON_REALTIME();
+  GetGlobalLogSink().Flush();
 }
 
 }  // namespace intrinsic::icon
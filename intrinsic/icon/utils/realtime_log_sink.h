@@ -4,18 +4,30 @@
 #define INTRINSIC_ICON_UTILS_REALTIME_LOG_SINK_H_
 
 #include <cstddef>
+#include <cstdint>
 
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "intrinsic/icon/utils/log_sink.h"
-#include "intrinsic/platform/common/buffers/realtime_write_queue.h"
 
 namespace intrinsic::icon {
 
 // A real-time safe log sink that writes to std::cerr.
 // When there are multiple threads, each should create a thread-local object.
-// Messages are buffered by a single, global non-RT thread and written out
-// message by message.
+// Messages are buffered in a byte ring per sink. A single, global non-RT
+// thread drains all rings whenever it is woken up, formats the messages and
+// writes them in batches.
+//
+// Binary log records (see INTRINSIC_RT_BINARY_LOG) are queued unformatted, so
+// the realtime thread only copies the packed arguments.
 class RealtimeLogSink : public LogSinkInterface {
  public:
+  // Number of bytes buffered per sink. A text message occupies about 48 bytes
+  // plus its length, a binary message about 48 bytes plus its packed
+  // arguments.
+  static constexpr size_t kBufferSize = 64 * 1024;
+
   // Not RT safe.
   RealtimeLogSink();
 
@@ -27,13 +39,44 @@ class RealtimeLogSink : public LogSinkInterface {
   // Not thread-safe, but concurrent use is allowed when each thread uses a
   // separate RealtimeLogSink object.
   // Messages reaching or exceeding kMessageMaxSize will be truncated.
-  // If the buffer is full, messages may be dropped.
+  // If the buffer is full, messages are dropped. The number of dropped
+  // messages is logged once the buffer has been drained.
   void Log(const LogEntry& entry) override;
 
+  // RT safe.
+  // Same as Log(), but defers formatting to the non-RT thread.
+  void LogBinary(const BinaryLogSite& site, int64_t robot_timestamp_ns,
+                 int64_t wall_timestamp_ns,
+                 absl::Span<const uint8_t> packed_args) override;
+
+  // Per-sink state shared with the global non-RT thread.
+  struct Queue;
+
  private:
-  RealtimeWriteQueue<LogEntry>::RtWriter* writer_;
+  Queue* queue_;
 };
 
+// Not RT safe.
+// Additionally writes the messages of all RealtimeLogSinks to a memory-mapped
+// binary file at `path`, without formatting them. Stops writing once the file
+// holds `max_size_bytes`. If `write_to_stderr` is false, messages are only
+// written to the file, which minimizes the work of the non-RT thread.
+// Use DecodeBinaryLogFile() in binary_log_file.h to read the file.
+// Replaces a previously configured file.
+absl::Status EnableRealtimeLogBinaryFile(absl::string_view path,
+                                         size_t max_size_bytes,
+                                         bool write_to_stderr = true);
+
+// Not RT safe.
+// Stops writing to the file configured with EnableRealtimeLogBinaryFile() and
+// resumes writing to stderr.
+void DisableRealtimeLogBinaryFile();
+
+// Not RT safe.
+// Blocks until all messages that have been logged to RealtimeLogSinks before
+// the call have been written.
+void FlushRealtimeLogSinks();
+
 }  // namespace intrinsic::icon
 
 #endif  // INTRINSIC_ICON_UTILS_REALTIME_LOG_SINK_H_
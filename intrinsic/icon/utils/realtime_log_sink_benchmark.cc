@@ -0,0 +1,76 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+// Measures the cost of a log call on the realtime thread, i.e. the time until
+// INTRINSIC_RT_LOG or INTRINSIC_RT_BINARY_LOG returns with a RealtimeLogSink
+// installed. Formatting and writing happen on the GlobalLogSink thread and are
+// not included.
+//
+// Every 256 iterations, the timer is paused until the log sink has caught up,
+// so that the numbers don't include the cost of dropping messages. stderr is
+// redirected to /dev/null.
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdint>
+
+#include "absl/log/check.h"
+#include "benchmark/benchmark.h"
+#include "intrinsic/icon/utils/log.h"
+#include "intrinsic/icon/utils/realtime_log_sink.h"
+
+namespace intrinsic::icon {
+namespace {
+
+constexpr int64_t kBatchSize = 256;
+
+void RedirectStderrToDevNull() {
+  static const bool redirected = []() {
+    int fd = open("/dev/null", O_WRONLY);
+    CHECK_GE(fd, 0);
+    CHECK_GE(dup2(fd, STDERR_FILENO), 0);
+    close(fd);
+    return true;
+  }();
+  (void)redirected;
+}
+
+void WaitForLogSink(benchmark::State& state) {
+  state.PauseTiming();
+  FlushRealtimeLogSinks();
+  state.ResumeTiming();
+}
+
+void BM_RtLog(benchmark::State& state) {
+  RedirectStderrToDevNull();
+  RtLogInitForThisThread();
+  int64_t i = 0;
+  const double position = 0.12345;
+  for (auto _ : state) {
+    INTRINSIC_RT_LOG(INFO) << "cycle " << i << " joint " << 3
+                           << " position: " << position << " state: ok";
+    if (++i % kBatchSize == 0) {
+      WaitForLogSink(state);
+    }
+  }
+}
+
+void BM_RtBinaryLog(benchmark::State& state) {
+  RedirectStderrToDevNull();
+  RtLogInitForThisThread();
+  int64_t i = 0;
+  const double position = 0.12345;
+  for (auto _ : state) {
+    INTRINSIC_RT_BINARY_LOG(INFO, "cycle $0 joint $1 position: $2 state: $3",
+                            i, 3, position, "ok");
+    if (++i % kBatchSize == 0) {
+      WaitForLogSink(state);
+    }
+  }
+}
+
+BENCHMARK(BM_RtLog);
+BENCHMARK(BM_RtBinaryLog);
+
+}  // namespace
+}  // namespace intrinsic::icon
@@ -0,0 +1,155 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/icon/utils/realtime_log_sink.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "intrinsic/icon/utils/binary_log_args.h"
+#include "intrinsic/icon/utils/binary_log_file.h"
+#include "intrinsic/icon/utils/log.h"
+#include "intrinsic/icon/utils/log_sink.h"
+#include "intrinsic/util/testing/gtest_wrapper.h"
+
+namespace intrinsic::icon {
+namespace {
+
+using ::intrinsic::testing::StatusIs;
+using ::testing::AllOf;
+using ::testing::ElementsAre;
+using ::testing::EndsWith;
+using ::testing::HasSubstr;
+using ::testing::IsEmpty;
+using ::testing::Not;
+using ::testing::SizeIs;
+using ::testing::StartsWith;
+
+std::string TestFilePath(absl::string_view name) {
+  return absl::StrCat(::testing::TempDir(), "/", name, "_", getpid(), ".blog");
+}
+
+struct DecodedEntry {
+  LogPriority priority;
+  std::string filename;
+  int line;
+  std::string message;
+};
+
+std::vector<DecodedEntry> Decode(absl::string_view path) {
+  std::vector<DecodedEntry> entries;
+  EXPECT_OK(DecodeBinaryLogFile(
+      path, [&entries](const LogSinkInterface::LogEntry& entry) {
+        entries.push_back({.priority = entry.priority,
+                           .filename = entry.filename,
+                           .line = entry.line,
+                           .message = std::string(entry.msg, entry.msglen)});
+      }));
+  return entries;
+}
+
+TEST(RealtimeLogSinkTest, WritesTextAndBinaryRecordsToFile) {
+  const std::string path = TestFilePath("records");
+  ASSERT_OK(EnableRealtimeLogBinaryFile(path, /*max_size_bytes=*/1 << 20,
+                                        /*write_to_stderr=*/false));
+  {
+    RealtimeLogSink sink;
+    LogSinkInterface::LogEntry entry;
+    entry.priority = LogPriority::WARNING;
+    entry.filename = "some/dir/file.cc";
+    entry.line = 12;
+    entry.msglen = 4;
+    std::memcpy(entry.msg, "text", 5);
+    sink.Log(entry);
+    static constexpr BinaryLogSite kSite{.priority = LogPriority::ERROR,
+                                         .filename = "other.cc",
+                                         .line = 34,
+                                         .format = "$0 of $1"};
+    for (int i = 0; i < 3; ++i) {
+      BinaryLogArgs args;
+      args.Add(i);
+      args.Add("three");
+      sink.LogBinary(kSite, /*robot_timestamp_ns=*/i,
+                     /*wall_timestamp_ns=*/i, args.data());
+    }
+  }
+  DisableRealtimeLogBinaryFile();
+
+  std::vector<DecodedEntry> entries = Decode(path);
+  ASSERT_THAT(entries, SizeIs(4));
+  EXPECT_EQ(entries[0].priority, LogPriority::WARNING);
+  EXPECT_EQ(entries[0].filename, "some/dir/file.cc");
+  EXPECT_EQ(entries[0].line, 12);
+  EXPECT_EQ(entries[0].message, "text");
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(entries[i + 1].priority, LogPriority::ERROR);
+    EXPECT_EQ(entries[i + 1].filename, "other.cc");
+    EXPECT_EQ(entries[i + 1].line, 34);
+    EXPECT_EQ(entries[i + 1].message, absl::StrCat(i, " of three"));
+  }
+}
+
+TEST(RealtimeLogSinkTest, WritesMacroCallsToFile) {
+  const std::string path = TestFilePath("macros");
+  ASSERT_OK(EnableRealtimeLogBinaryFile(path, /*max_size_bytes=*/1 << 20,
+                                        /*write_to_stderr=*/false));
+  RtLogInitForThisThread();
+  INTRINSIC_RT_LOG(INFO) << "joint " << 2;
+  INTRINSIC_RT_BINARY_LOG(WARNING, "joint $0 at $1", 3, 0.25);
+  FlushRealtimeLogSinks();
+  GlobalLogContext::SetThreadLocalLogSink(nullptr);
+  DisableRealtimeLogBinaryFile();
+
+  std::vector<std::string> lines;
+  ASSERT_OK(DecodeBinaryLogFile(
+      path, [&lines](const LogSinkInterface::LogEntry& entry) {
+        char buffer[LogSinkInterface::kLogMessageMaxSize];
+        LogEntryFormatToBuffer(buffer, sizeof(buffer), entry);
+        lines.emplace_back(buffer);
+      }));
+  EXPECT_THAT(lines,
+              ElementsAre(AllOf(StartsWith("I"),
+                                HasSubstr("realtime_log_sink_test.cc"),
+                                EndsWith("joint 2\n")),
+                          AllOf(StartsWith("W"),
+                                HasSubstr("realtime_log_sink_test.cc"),
+                                EndsWith("joint 3 at 0.25\n"))));
+}
+
+TEST(RealtimeLogSinkTest, StopsWritingWhenFileIsFull) {
+  const std::string path = TestFilePath("full");
+  ASSERT_OK(EnableRealtimeLogBinaryFile(path, /*max_size_bytes=*/256,
+                                        /*write_to_stderr=*/false));
+  {
+    RealtimeLogSink sink;
+    static constexpr BinaryLogSite kSite{.format = "message $0"};
+    for (int i = 0; i < 100; ++i) {
+      BinaryLogArgs args;
+      args.Add(i);
+      sink.LogBinary(kSite, 0, 0, args.data());
+    }
+  }
+  DisableRealtimeLogBinaryFile();
+
+  std::vector<DecodedEntry> entries = Decode(path);
+  ASSERT_THAT(entries, Not(IsEmpty()));
+  EXPECT_LT(entries.size(), 100);
+  EXPECT_EQ(entries.back().message,
+            absl::StrCat("message ", entries.size() - 1));
+}
+
+TEST(RealtimeLogSinkTest, RejectsMissingFile) {
+  EXPECT_THAT(DecodeBinaryLogFile(TestFilePath("missing"),
+                                  [](const LogSinkInterface::LogEntry&) {}),
+              StatusIs(absl::StatusCode::kNotFound));
+}
+
+}  // namespace
+}  // namespace intrinsic::icon
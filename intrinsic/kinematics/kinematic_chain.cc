@@ -0,0 +1,168 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/kinematics/kinematic_chain.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
+#include "intrinsic/eigenmath/types.h"
+#include "intrinsic/icon/utils/realtime_status.h"
+#include "intrinsic/icon/utils/realtime_status_macro.h"
+#include "intrinsic/icon/utils/realtime_status_or.h"
+#include "intrinsic/kinematics/proto/kinematics.pb.h"
+#include "intrinsic/kinematics/proto/skeleton.pb.h"
+#include "intrinsic/math/pose3.h"
+#include "intrinsic/math/proto_conversion.h"
+#include "intrinsic/util/status/status_macros.h"
+
+namespace intrinsic::kinematics {
+
+absl::StatusOr<KinematicChain> KinematicChain::Create(
+    std::vector<ChainJoint> joints, const Pose3d& last_t_tip, int num_dof) {
+  if (num_dof < 0 || num_dof > kMaxNumDof) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "The number of DoFs must be in [0, ", kMaxNumDof, "], got ", num_dof));
+  }
+  std::vector<bool> dof_used(num_dof, false);
+  for (ChainJoint& joint : joints) {
+    if (joint.dof_index < 0 || joint.dof_index >= num_dof) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("DoF index ", joint.dof_index, " is out of range for ",
+                       num_dof, " DoFs."));
+    }
+    if (dof_used[joint.dof_index]) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "More than one joint has the DoF index ", joint.dof_index, "."));
+    }
+    dof_used[joint.dof_index] = true;
+    const double axis_norm = joint.axis.norm();
+    if (axis_norm < 1e-9) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "The joint with DoF index ", joint.dof_index, " has a zero axis."));
+    }
+    joint.axis /= axis_norm;
+  }
+  return KinematicChain(std::move(joints), last_t_tip, num_dof);
+}
+
+absl::StatusOr<KinematicChain> KinematicChain::FromSkeleton(
+    const intrinsic_proto::Skeleton& skeleton, uint32_t base_element_id,
+    uint32_t tip_element_id) {
+  absl::flat_hash_map<uint32_t, const intrinsic_proto::Element*> elements;
+  absl::flat_hash_map<uint32_t, const intrinsic_proto::Joint*> joints;
+  for (const intrinsic_proto::Link& link : skeleton.links()) {
+    elements.emplace(link.element().id(), &link.element());
+  }
+  for (const intrinsic_proto::Joint& joint : skeleton.joints()) {
+    elements.emplace(joint.element().id(), &joint.element());
+    joints.emplace(joint.element().id(), &joint);
+  }
+  for (const intrinsic_proto::CoordinateFrame& frame :
+       skeleton.coordinate_frames()) {
+    elements.emplace(frame.element().id(), &frame.element());
+  }
+
+  // The elements from the tip up to, but excluding, the base.
+  std::vector<const intrinsic_proto::Element*> path;
+  for (uint32_t id = tip_element_id; id != base_element_id;) {
+    auto it = elements.find(id);
+    if (it == elements.end()) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Skeleton \"", skeleton.name(), "\" has no element ",
+                       id, " on the path from element ", tip_element_id,
+                       " to element ", base_element_id, "."));
+    }
+    if (path.size() == elements.size()) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "Element ", base_element_id, " of skeleton \"", skeleton.name(),
+          "\" is not an ancestor of element ", tip_element_id, "."));
+    }
+    path.push_back(it->second);
+    id = it->second->parent();
+  }
+  std::reverse(path.begin(), path.end());
+
+  std::vector<ChainJoint> chain_joints;
+  Pose3d previous_t_element;
+  for (const intrinsic_proto::Element* element : path) {
+    INTR_ASSIGN_OR_RETURN(Pose3d parent_t_element,
+                          intrinsic_proto::FromProto(element->parent_t_this()));
+    previous_t_element = previous_t_element * parent_t_element;
+    auto joint_it = joints.find(element->id());
+    if (joint_it == joints.end()) {
+      continue;
+    }
+    const intrinsic_proto::Joint::Parameters& parameters =
+        joint_it->second->parameters();
+    ChainJoint::Type type;
+    switch (parameters.type()) {
+      case intrinsic_proto::Joint::REVOLUTE:
+        type = ChainJoint::Type::kRevolute;
+        break;
+      case intrinsic_proto::Joint::PRISMATIC:
+        type = ChainJoint::Type::kPrismatic;
+        break;
+      default:
+        continue;
+    }
+    auto dof_it = skeleton.element_id_to_dof_index().find(element->id());
+    if (dof_it == skeleton.element_id_to_dof_index().end()) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Joint ", element->id(), " of skeleton \"",
+                       skeleton.name(), "\" has no DoF index."));
+    }
+    chain_joints.push_back({.type = type,
+                            .dof_index = static_cast<int>(dof_it->second),
+                            .previous_t_inboard = previous_t_element,
+                            .axis = intrinsic_proto::FromProto(
+                                parameters.axis())});
+    previous_t_element = Pose3d();
+  }
+  return Create(std::move(chain_joints), previous_t_element,
+                skeleton.element_id_to_dof_index_size());
+}
+
+KinematicChain::KinematicChain(std::vector<ChainJoint> joints,
+                               const Pose3d& last_t_tip, int num_dof)
+    : joints_(std::move(joints)), last_t_tip_(last_t_tip), num_dof_(num_dof) {}
+
+icon::RealtimeStatusOr<eigenmath::Matrix6Nd> KinematicChain::ComputeJacobian(
+    const eigenmath::VectorNd& dof_positions) const {
+  eigenmath::Matrix6Nd jacobian;
+  if (icon::RealtimeStatus status = ComputeJacobian(dof_positions, jacobian);
+      !status.ok()) {
+    return status;
+  }
+  return std::move(jacobian);
+}
+
+icon::RealtimeStatus KinematicChain::ComputeFkBatch(
+    absl::Span<const eigenmath::VectorNd> dof_positions,
+    absl::Span<Pose3d> base_t_tips) const {
+  if (dof_positions.size() != base_t_tips.size()) {
+    return icon::InvalidArgumentError(icon::RealtimeStatus::StrCat(
+        "Got ", dof_positions.size(), " configurations but space for ",
+        base_t_tips.size(), " poses."));
+  }
+  for (int i = 0; i < dof_positions.size(); ++i) {
+    INTRINSIC_RT_ASSIGN_OR_RETURN(base_t_tips[i], ComputeFk(dof_positions[i]));
+  }
+  return icon::OkStatus();
+}
+
+icon::RealtimeStatus KinematicChain::CheckNumDof(int size) const {
+  if (size != num_dof_) {
+    return icon::InvalidArgumentError(icon::RealtimeStatus::StrCat(
+        "Expected ", num_dof_, " DoF positions, got ", size, "."));
+  }
+  return icon::OkStatus();
+}
+
+}  // namespace intrinsic::kinematics
@@ -0,0 +1,232 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#ifndef INTRINSIC_KINEMATICS_KINEMATIC_CHAIN_H_
+#define INTRINSIC_KINEMATICS_KINEMATIC_CHAIN_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "Eigen/Core"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "intrinsic/eigenmath/types.h"
+#include "intrinsic/icon/utils/realtime_status.h"
+#include "intrinsic/icon/utils/realtime_status_or.h"
+#include "intrinsic/kinematics/proto/skeleton.pb.h"
+#include "intrinsic/math/pose3.h"
+
+namespace intrinsic::kinematics {
+
+// An actuated joint of a KinematicChain.
+struct ChainJoint {
+  enum class Type { kRevolute, kPrismatic };
+
+  Type type = Type::kRevolute;
+
+  // Index of the position of this joint in the DoF vector.
+  int dof_index = 0;
+
+  // Pose of the inboard frame of this joint in the space of the outboard frame
+  // of the previous joint, or of the chain base for the first joint. Fixed
+  // joints and links in between are folded into this pose.
+  Pose3d previous_t_inboard;
+
+  // Axis of this joint in its inboard frame. Normalized on creation.
+  eigenmath::Vector3d axis = eigenmath::Vector3d::UnitZ();
+};
+
+// Evaluates the forward kinematics and the geometric Jacobian of a serial chain
+// of revolute and prismatic joints.
+//
+// Creating a chain allocates, evaluating it does not, so the Compute*()
+// methods are realtime-safe. They take the positions of all DoFs of the
+// kinematic model the chain was extracted from, which may be more than the
+// chain has joints. Passing fixed-size Eigen types (e.g., eigenmath::Vector7d
+// and eigenmath::Matrix6NdAligned<7>) lets the compiler size all vectors and
+// matrices at compile time.
+//
+// The outboard frame of a joint is its inboard frame moved by the joint
+// position: rotated about the axis for revolute joints and translated along it
+// for prismatic joints.
+class KinematicChain {
+ public:
+  // The maximum number of DoFs of the kinematic model of a chain.
+  static constexpr int kMaxNumDof = eigenmath::MAX_EIGEN_MATRIX_SIZE;
+
+  // Creates a chain from `joints`, ordered from the base to the tip.
+  // `last_t_tip` is the pose of the tip in the space of the outboard frame of
+  // the last joint, or of the base if `joints` is empty. `num_dof` is the
+  // number of DoFs of the kinematic model, which must cover every
+  // ChainJoint::dof_index.
+  static absl::StatusOr<KinematicChain> Create(std::vector<ChainJoint> joints,
+                                               const Pose3d& last_t_tip,
+                                               int num_dof);
+
+  // Creates the chain from the element with id `base_element_id` to the
+  // element with id `tip_element_id` of `skeleton`. Each element's
+  // parent_t_this places it in the space of its parent element, i.e., in the
+  // outboard frame if the parent is a joint. The DoF vector is indexed
+  // according to skeleton.element_id_to_dof_index().
+  static absl::StatusOr<KinematicChain> FromSkeleton(
+      const intrinsic_proto::Skeleton& skeleton, uint32_t base_element_id,
+      uint32_t tip_element_id);
+
+  // The number of DoFs of the kinematic model, i.e., the size of the DoF vector
+  // and the number of columns of the Jacobian.
+  int num_dof() const { return num_dof_; }
+
+  // The actuated joints of the chain, from the base to the tip.
+  absl::Span<const ChainJoint> joints() const { return joints_; }
+
+  const Pose3d& last_t_tip() const { return last_t_tip_; }
+
+  // Returns the pose of the tip in the space of the base.
+  template <typename Derived>
+  icon::RealtimeStatusOr<Pose3d> ComputeFk(
+      const Eigen::MatrixBase<Derived>& dof_positions) const;
+
+  // Writes the pose of the outboard frame of each joint in the space of the
+  // base into `base_t_frames`, followed by the pose of the tip. Thus,
+  // `base_t_frames` must have joints().size() + 1 elements.
+  template <typename Derived>
+  icon::RealtimeStatus ComputeAllFramesFk(
+      const Eigen::MatrixBase<Derived>& dof_positions,
+      absl::Span<Pose3d> base_t_frames) const;
+
+  // Writes the geometric Jacobian of the tip, in the space of the base, into
+  // `jacobian`. Rows are the linear and then the angular velocity, columns the
+  // DoFs. Columns of DoFs which do not move the chain are zero. Does not
+  // allocate if `jacobian` has a fixed number of columns or a fixed maximum
+  // number of columns, like eigenmath::Matrix6Nd.
+  template <typename Derived, typename JacobianDerived>
+  icon::RealtimeStatus ComputeJacobian(
+      const Eigen::MatrixBase<Derived>& dof_positions,
+      Eigen::PlainObjectBase<JacobianDerived>& jacobian) const;
+  icon::RealtimeStatusOr<eigenmath::Matrix6Nd> ComputeJacobian(
+      const eigenmath::VectorNd& dof_positions) const;
+
+  // Computes the pose of the tip for each element of `dof_positions` and writes
+  // it to the same index of `base_t_tips`, which must have the same size.
+  // Stops at the first element with the wrong number of DoF positions.
+  icon::RealtimeStatus ComputeFkBatch(
+      absl::Span<const eigenmath::VectorNd> dof_positions,
+      absl::Span<Pose3d> base_t_tips) const;
+
+ private:
+  KinematicChain(std::vector<ChainJoint> joints, const Pose3d& last_t_tip,
+                 int num_dof);
+
+  icon::RealtimeStatus CheckNumDof(int size) const;
+
+  // Returns the pose of the outboard frame of `joint` in the space of its
+  // inboard frame.
+  static Pose3d InboardTOutboard(const ChainJoint& joint, double position);
+
+  std::vector<ChainJoint> joints_;
+  Pose3d last_t_tip_;
+  int num_dof_;
+};
+
+inline Pose3d KinematicChain::InboardTOutboard(const ChainJoint& joint,
+                                               double position) {
+  switch (joint.type) {
+    case ChainJoint::Type::kRevolute:
+      return Pose3d(
+          eigenmath::Quaterniond(eigenmath::AngleAxisd(position, joint.axis)),
+          eigenmath::Vector3d::Zero(), eigenmath::kDoNotNormalize);
+    case ChainJoint::Type::kPrismatic:
+      return Pose3d(eigenmath::Vector3d(position * joint.axis));
+  }
+  return Pose3d();
+}
+
+template <typename Derived>
+icon::RealtimeStatusOr<Pose3d> KinematicChain::ComputeFk(
+    const Eigen::MatrixBase<Derived>& dof_positions) const {
+  if (icon::RealtimeStatus status = CheckNumDof(dof_positions.size());
+      !status.ok()) {
+    return status;
+  }
+  Pose3d base_t_frame;
+  for (const ChainJoint& joint : joints_) {
+    base_t_frame = base_t_frame * joint.previous_t_inboard *
+                   InboardTOutboard(joint, dof_positions[joint.dof_index]);
+  }
+  return Pose3d(base_t_frame * last_t_tip_);
+}
+
+template <typename Derived>
+icon::RealtimeStatus KinematicChain::ComputeAllFramesFk(
+    const Eigen::MatrixBase<Derived>& dof_positions,
+    absl::Span<Pose3d> base_t_frames) const {
+  if (icon::RealtimeStatus status = CheckNumDof(dof_positions.size());
+      !status.ok()) {
+    return status;
+  }
+  if (base_t_frames.size() != joints_.size() + 1) {
+    return icon::InvalidArgumentError(icon::RealtimeStatus::StrCat(
+        "Expected space for ", joints_.size() + 1, " frames, got ",
+        base_t_frames.size(), "."));
+  }
+  Pose3d base_t_frame;
+  for (int i = 0; i < joints_.size(); ++i) {
+    const ChainJoint& joint = joints_[i];
+    base_t_frame = base_t_frame * joint.previous_t_inboard *
+                   InboardTOutboard(joint, dof_positions[joint.dof_index]);
+    base_t_frames[i] = base_t_frame;
+  }
+  base_t_frames.back() = base_t_frame * last_t_tip_;
+  return icon::OkStatus();
+}
+
+template <typename Derived, typename JacobianDerived>
+icon::RealtimeStatus KinematicChain::ComputeJacobian(
+    const Eigen::MatrixBase<Derived>& dof_positions,
+    Eigen::PlainObjectBase<JacobianDerived>& jacobian) const {
+  if (icon::RealtimeStatus status = CheckNumDof(dof_positions.size());
+      !status.ok()) {
+    return status;
+  }
+  if (JacobianDerived::ColsAtCompileTime != Eigen::Dynamic &&
+      JacobianDerived::ColsAtCompileTime != num_dof_) {
+    return icon::InvalidArgumentError(icon::RealtimeStatus::StrCat(
+        "Expected a Jacobian with ", num_dof_, " columns, got ",
+        JacobianDerived::ColsAtCompileTime, "."));
+  }
+  jacobian.resize(6, num_dof_);
+  jacobian.setZero();
+  // The first pass stores the axis and the origin of each joint in the space of
+  // the base in its column, since the position of the tip is only known at the
+  // end. Rotating a frame about (or moving it along) an axis leaves the axis
+  // unchanged, so the inboard and outboard frames share it.
+  Pose3d base_t_frame;
+  for (const ChainJoint& joint : joints_) {
+    base_t_frame = base_t_frame * joint.previous_t_inboard *
+                   InboardTOutboard(joint, dof_positions[joint.dof_index]);
+    jacobian.col(joint.dof_index).template head<3>() =
+        base_t_frame.translation();
+    jacobian.col(joint.dof_index).template tail<3>() =
+        base_t_frame.so3() * joint.axis;
+  }
+  const eigenmath::Vector3d base_p_tip =
+      (base_t_frame * last_t_tip_).translation();
+  for (const ChainJoint& joint : joints_) {
+    auto column = jacobian.col(joint.dof_index);
+    const eigenmath::Vector3d base_p_joint = column.template head<3>();
+    const eigenmath::Vector3d axis = column.template tail<3>();
+    switch (joint.type) {
+      case ChainJoint::Type::kRevolute:
+        column.template head<3>() = axis.cross(base_p_tip - base_p_joint);
+        break;
+      case ChainJoint::Type::kPrismatic:
+        column.template head<3>() = axis;
+        column.template tail<3>().setZero();
+        break;
+    }
+  }
+  return icon::OkStatus();
+}
+
+}  // namespace intrinsic::kinematics
+
+#endif  // INTRINSIC_KINEMATICS_KINEMATIC_CHAIN_H_
@@ -0,0 +1,148 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+// Measures forward kinematics and Jacobians of a 7-DoF KinematicChain, once
+// with dynamically sized and once with compile-time sized Eigen types, and
+// the batched forward kinematics. Before measuring, checks the Jacobian
+// against central differences of the forward kinematics.
+//
+// Run with `bazel run -c opt` for meaningful numbers.
+
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include "Eigen/Geometry"
+#include "absl/log/check.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "benchmark/benchmark.h"
+#include "intrinsic/eigenmath/types.h"
+#include "intrinsic/kinematics/kinematic_chain.h"
+#include "intrinsic/math/pose3.h"
+
+namespace intrinsic::kinematics {
+namespace {
+
+constexpr int kNumDof = 7;
+
+// Returns a chain with the geometry of a typical 7-DoF arm with alternating
+// joint axes.
+KinematicChain MakeChain() {
+  const eigenmath::Quaterniond x_to_z(
+      eigenmath::AngleAxisd(-M_PI / 2, eigenmath::Vector3d::UnitX()));
+  const eigenmath::Quaterniond z_to_x(
+      eigenmath::AngleAxisd(M_PI / 2, eigenmath::Vector3d::UnitX()));
+  std::vector<ChainJoint> joints = {
+      {.dof_index = 0,
+       .previous_t_inboard = Pose3d(eigenmath::Vector3d(0, 0, 0.34))},
+      {.dof_index = 1, .previous_t_inboard = Pose3d(x_to_z)},
+      {.dof_index = 2,
+       .previous_t_inboard =
+           Pose3d(z_to_x, eigenmath::Vector3d(0, -0.4, 0))},
+      {.dof_index = 3, .previous_t_inboard = Pose3d(z_to_x)},
+      {.dof_index = 4,
+       .previous_t_inboard =
+           Pose3d(x_to_z, eigenmath::Vector3d(0, 0.4, 0))},
+      {.dof_index = 5, .previous_t_inboard = Pose3d(z_to_x)},
+      {.dof_index = 6,
+       .previous_t_inboard = Pose3d(x_to_z)},
+  };
+  absl::StatusOr<KinematicChain> chain = KinematicChain::Create(
+      std::move(joints), Pose3d(eigenmath::Vector3d(0, 0, 0.126)), kNumDof);
+  CHECK_OK(chain.status());
+  return *std::move(chain);
+}
+
+eigenmath::VectorNd MakeDofPositions(int seed) {
+  eigenmath::VectorNd dof_positions(kNumDof);
+  for (int i = 0; i < kNumDof; ++i) {
+    dof_positions[i] = std::sin(0.7 * seed + 1.3 * i);
+  }
+  return dof_positions;
+}
+
+// Checks ComputeJacobian() against central differences of ComputeFk().
+void CheckJacobian(const KinematicChain& chain) {
+  constexpr double kStep = 1e-6;
+  const eigenmath::VectorNd dof_positions = MakeDofPositions(1);
+  const eigenmath::Matrix6Nd jacobian =
+      chain.ComputeJacobian(dof_positions).value();
+  for (int i = 0; i < kNumDof; ++i) {
+    eigenmath::VectorNd plus = dof_positions;
+    plus[i] += kStep;
+    eigenmath::VectorNd minus = dof_positions;
+    minus[i] -= kStep;
+    const Pose3d base_t_plus = chain.ComputeFk(plus).value();
+    const Pose3d base_t_minus = chain.ComputeFk(minus).value();
+    const eigenmath::AngleAxisd rotation(base_t_plus.rotationMatrix() *
+                                         base_t_minus.rotationMatrix()
+                                             .transpose());
+    eigenmath::Vector6d expected;
+    expected << (base_t_plus.translation() - base_t_minus.translation()) /
+                    (2 * kStep),
+        rotation.axis() * rotation.angle() / (2 * kStep);
+    CHECK(jacobian.col(i).isApprox(expected, 1e-6))
+        << "Column " << i << " of the Jacobian is " << jacobian.col(i).transpose()
+        << ", but central differences give " << expected.transpose();
+  }
+}
+
+void BM_ComputeFkDynamic(benchmark::State& state) {
+  const KinematicChain chain = MakeChain();
+  const eigenmath::VectorNd dof_positions = MakeDofPositions(1);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(chain.ComputeFk(dof_positions).value());
+  }
+}
+BENCHMARK(BM_ComputeFkDynamic);
+
+void BM_ComputeFkFixed(benchmark::State& state) {
+  const KinematicChain chain = MakeChain();
+  const eigenmath::Vectord<kNumDof> dof_positions = MakeDofPositions(1);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(chain.ComputeFk(dof_positions).value());
+  }
+}
+BENCHMARK(BM_ComputeFkFixed);
+
+void BM_ComputeJacobianDynamic(benchmark::State& state) {
+  const KinematicChain chain = MakeChain();
+  CheckJacobian(chain);
+  const eigenmath::VectorNd dof_positions = MakeDofPositions(1);
+  eigenmath::Matrix6Nd jacobian;
+  for (auto _ : state) {
+    CHECK(chain.ComputeJacobian(dof_positions, jacobian).ok());
+    benchmark::DoNotOptimize(jacobian);
+  }
+}
+BENCHMARK(BM_ComputeJacobianDynamic);
+
+void BM_ComputeJacobianFixed(benchmark::State& state) {
+  const KinematicChain chain = MakeChain();
+  const eigenmath::Vectord<kNumDof> dof_positions = MakeDofPositions(1);
+  eigenmath::Matrix6NdAligned<kNumDof> jacobian;
+  for (auto _ : state) {
+    CHECK(chain.ComputeJacobian(dof_positions, jacobian).ok());
+    benchmark::DoNotOptimize(jacobian);
+  }
+}
+BENCHMARK(BM_ComputeJacobianFixed);
+
+void BM_ComputeFkBatch(benchmark::State& state) {
+  const KinematicChain chain = MakeChain();
+  std::vector<eigenmath::VectorNd> dof_positions;
+  for (int i = 0; i < state.range(0); ++i) {
+    dof_positions.push_back(MakeDofPositions(i));
+  }
+  std::vector<Pose3d> base_t_tips(dof_positions.size());
+  for (auto _ : state) {
+    CHECK(chain.ComputeFkBatch(dof_positions, absl::MakeSpan(base_t_tips))
+              .ok());
+    benchmark::DoNotOptimize(base_t_tips.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ComputeFkBatch)->Arg(1'000)->Arg(100'000);
+
+}  // namespace
+}  // namespace intrinsic::kinematics
@@ -0,0 +1,469 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/kinematics/kinematic_chain.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "intrinsic/eigenmath/types.h"
+#include "intrinsic/icon/utils/realtime_status.h"
+#include "intrinsic/icon/utils/realtime_status_or.h"
+#include "intrinsic/kinematics/proto/skeleton.pb.h"
+#include "intrinsic/math/pose3.h"
+#include "intrinsic/util/proto/parse_text_proto.h"
+#include "intrinsic/util/testing/gtest_wrapper.h"
+
+namespace intrinsic::kinematics {
+namespace {
+
+using ::intrinsic::icon::RealtimeStatusOr;
+using ::intrinsic::testing::StatusIs;
+using ::testing::HasSubstr;
+
+constexpr double kTolerance = 1e-9;
+
+// Converts for the status matchers, which take absl::Status.
+absl::Status ToAbslStatus(const icon::RealtimeStatus& status) {
+  return status;
+}
+
+// Denavit-Hartenberg parameters of one link.
+struct DhParameters {
+  double d;
+  double a;
+  double alpha;
+};
+
+// DH parameters of a UR5-like 6-DoF arm.
+constexpr std::array<DhParameters, 6> kDhArm = {{
+    {.d = 0.089159, .a = 0.0, .alpha = M_PI / 2},
+    {.d = 0.0, .a = -0.425, .alpha = 0.0},
+    {.d = 0.0, .a = -0.39225, .alpha = 0.0},
+    {.d = 0.10915, .a = 0.0, .alpha = M_PI / 2},
+    {.d = 0.09465, .a = 0.0, .alpha = -M_PI / 2},
+    {.d = 0.0823, .a = 0.0, .alpha = 0.0},
+}};
+
+// Returns the classic DH transform Rz(theta) * Tz(d) * Tx(a) * Rx(alpha),
+// written out independently of Pose3d.
+eigenmath::Matrix4d DhTransform(const DhParameters& dh, double theta) {
+  const double ct = std::cos(theta);
+  const double st = std::sin(theta);
+  const double ca = std::cos(dh.alpha);
+  const double sa = std::sin(dh.alpha);
+  eigenmath::Matrix4d transform;
+  transform << ct, -st * ca, st * sa, dh.a * ct,  //
+      st, ct * ca, -ct * sa, dh.a * st,           //
+      0, sa, ca, dh.d,                            //
+      0, 0, 0, 1;
+  return transform;
+}
+
+// Returns the chain of `kDhArm`, with the revolute joints about the z-axes of
+// the DH frames. Each link contributes Tz(d) * Tx(a) * Rx(alpha) after its
+// joint.
+KinematicChain MakeDhChain() {
+  std::vector<ChainJoint> joints;
+  Pose3d previous_t_inboard;
+  for (int i = 0; i < kDhArm.size(); ++i) {
+    joints.push_back(
+        {.dof_index = i, .previous_t_inboard = previous_t_inboard});
+    previous_t_inboard =
+        Pose3d(eigenmath::Quaterniond(eigenmath::AngleAxisd(
+                   kDhArm[i].alpha, eigenmath::Vector3d::UnitX())),
+               eigenmath::Vector3d(kDhArm[i].a, 0, kDhArm[i].d));
+  }
+  absl::StatusOr<KinematicChain> chain = KinematicChain::Create(
+      std::move(joints), previous_t_inboard, kDhArm.size());
+  CHECK_OK(chain.status());
+  return *std::move(chain);
+}
+
+eigenmath::VectorNd MakeDofPositions(int num_dof, int seed) {
+  eigenmath::VectorNd dof_positions(num_dof);
+  for (int i = 0; i < num_dof; ++i) {
+    dof_positions[i] = std::sin(0.7 * seed + 1.3 * i);
+  }
+  return dof_positions;
+}
+
+// Returns the Jacobian of `chain` from central differences of ComputeFk().
+eigenmath::Matrix6Nd NumericJacobian(const KinematicChain& chain,
+                                     const eigenmath::VectorNd& dof_positions) {
+  constexpr double kStep = 1e-6;
+  eigenmath::Matrix6Nd jacobian(6, chain.num_dof());
+  for (int i = 0; i < chain.num_dof(); ++i) {
+    eigenmath::VectorNd plus = dof_positions;
+    plus[i] += kStep;
+    eigenmath::VectorNd minus = dof_positions;
+    minus[i] -= kStep;
+    const Pose3d base_t_plus = chain.ComputeFk(plus).value();
+    const Pose3d base_t_minus = chain.ComputeFk(minus).value();
+    const eigenmath::AngleAxisd rotation(
+        base_t_plus.rotationMatrix() *
+        base_t_minus.rotationMatrix().transpose());
+    jacobian.col(i) << (base_t_plus.translation() -
+                        base_t_minus.translation()) /
+                           (2 * kStep),
+        rotation.axis() * rotation.angle() / (2 * kStep);
+  }
+  return jacobian;
+}
+
+TEST(KinematicChainTest, MatchesDhModel) {
+  const KinematicChain chain = MakeDhChain();
+  for (int seed = 0; seed < 10; ++seed) {
+    const eigenmath::VectorNd dof_positions =
+        MakeDofPositions(kDhArm.size(), seed);
+    eigenmath::Matrix4d expected = eigenmath::Matrix4d::Identity();
+    for (int i = 0; i < kDhArm.size(); ++i) {
+      expected = expected * DhTransform(kDhArm[i], dof_positions[i]);
+    }
+
+    const RealtimeStatusOr<Pose3d> base_t_tip_or =
+        chain.ComputeFk(dof_positions);
+    ASSERT_TRUE(base_t_tip_or.ok()) << ToAbslStatus(base_t_tip_or.status());
+    const Pose3d& base_t_tip = *base_t_tip_or;
+    EXPECT_TRUE(base_t_tip.matrix().isApprox(expected, kTolerance))
+        << "Seed " << seed << ": got\n"
+        << base_t_tip.matrix() << "\nexpected\n"
+        << expected;
+  }
+}
+
+TEST(KinematicChainTest, FixedSizeTypesMatchDynamicTypes) {
+  const KinematicChain chain = MakeDhChain();
+  const eigenmath::VectorNd dof_positions = MakeDofPositions(6, 1);
+  const eigenmath::Vector6d fixed_dof_positions = dof_positions;
+
+  const RealtimeStatusOr<Pose3d> base_t_tip_or = chain.ComputeFk(dof_positions);
+  ASSERT_TRUE(base_t_tip_or.ok()) << ToAbslStatus(base_t_tip_or.status());
+  const Pose3d& base_t_tip = *base_t_tip_or;
+  const RealtimeStatusOr<Pose3d> fixed_base_t_tip_or =
+      chain.ComputeFk(fixed_dof_positions);
+  ASSERT_TRUE(fixed_base_t_tip_or.ok())
+      << ToAbslStatus(fixed_base_t_tip_or.status());
+  const Pose3d& fixed_base_t_tip = *fixed_base_t_tip_or;
+  EXPECT_TRUE(fixed_base_t_tip.isApprox(base_t_tip, kTolerance));
+
+  const RealtimeStatusOr<eigenmath::Matrix6Nd> jacobian_or =
+      chain.ComputeJacobian(dof_positions);
+  ASSERT_TRUE(jacobian_or.ok()) << ToAbslStatus(jacobian_or.status());
+  const eigenmath::Matrix6Nd& jacobian = *jacobian_or;
+  eigenmath::Matrix6NdAligned<6> fixed_jacobian;
+  ASSERT_OK(ToAbslStatus(
+      chain.ComputeJacobian(fixed_dof_positions, fixed_jacobian)));
+  EXPECT_TRUE(fixed_jacobian.isApprox(jacobian, kTolerance));
+}
+
+TEST(KinematicChainTest, JacobianMatchesCentralDifferences) {
+  const KinematicChain chain = MakeDhChain();
+  for (int seed = 0; seed < 10; ++seed) {
+    const eigenmath::VectorNd dof_positions =
+        MakeDofPositions(kDhArm.size(), seed);
+    const RealtimeStatusOr<eigenmath::Matrix6Nd> jacobian_or =
+        chain.ComputeJacobian(dof_positions);
+    ASSERT_TRUE(jacobian_or.ok()) << ToAbslStatus(jacobian_or.status());
+    const eigenmath::Matrix6Nd& jacobian = *jacobian_or;
+    EXPECT_TRUE(
+        jacobian.isApprox(NumericJacobian(chain, dof_positions), 1e-6))
+        << "Seed " << seed;
+  }
+}
+
+TEST(KinematicChainTest, AllFramesEndWithTheTip) {
+  const KinematicChain chain = MakeDhChain();
+  const eigenmath::VectorNd dof_positions = MakeDofPositions(6, 2);
+  std::vector<Pose3d> base_t_frames(chain.joints().size() + 1);
+
+  ASSERT_OK(ToAbslStatus(
+      chain.ComputeAllFramesFk(dof_positions, absl::MakeSpan(base_t_frames))));
+
+  // The outboard frame of the first joint is only rotated about the z-axis.
+  EXPECT_TRUE(base_t_frames.front().isApprox(
+      Pose3d(eigenmath::Quaterniond(eigenmath::AngleAxisd(
+          dof_positions[0], eigenmath::Vector3d::UnitZ()))),
+      kTolerance));
+  const RealtimeStatusOr<Pose3d> base_t_tip_or = chain.ComputeFk(dof_positions);
+  ASSERT_TRUE(base_t_tip_or.ok()) << ToAbslStatus(base_t_tip_or.status());
+  const Pose3d& base_t_tip = *base_t_tip_or;
+  EXPECT_TRUE(base_t_frames.back().isApprox(base_t_tip, kTolerance));
+
+  base_t_frames.pop_back();
+  EXPECT_THAT(ToAbslStatus(chain.ComputeAllFramesFk(
+                  dof_positions, absl::MakeSpan(base_t_frames))),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(KinematicChainTest, PrismaticJointsMoveAlongTheirAxis) {
+  // A prismatic joint along x with DoF index 1, followed by a revolute joint
+  // about z with DoF index 0, and the tip 1 m along x of the latter.
+  ASSERT_OK_AND_ASSIGN(
+      const KinematicChain chain,
+      KinematicChain::Create(
+          {{.type = ChainJoint::Type::kPrismatic,
+            .dof_index = 1,
+            .previous_t_inboard = Pose3d(eigenmath::Vector3d(0, 0, 0.5)),
+            .axis = eigenmath::Vector3d(2, 0, 0)},
+           {.dof_index = 0}},
+          Pose3d(eigenmath::Vector3d(1, 0, 0)), /*num_dof=*/2));
+  // The axis is normalized.
+  EXPECT_TRUE(chain.joints()[0].axis.isApprox(eigenmath::Vector3d::UnitX()));
+
+  const eigenmath::VectorNd dof_positions = eigenmath::Vector2d(M_PI / 2, 0.3);
+  const RealtimeStatusOr<Pose3d> base_t_tip_or = chain.ComputeFk(dof_positions);
+  ASSERT_TRUE(base_t_tip_or.ok()) << ToAbslStatus(base_t_tip_or.status());
+  const Pose3d& base_t_tip = *base_t_tip_or;
+  EXPECT_TRUE(base_t_tip.translation().isApprox(
+      eigenmath::Vector3d(0.3, 1, 0.5), kTolerance))
+      << base_t_tip.translation().transpose();
+
+  const RealtimeStatusOr<eigenmath::Matrix6Nd> jacobian_or =
+      chain.ComputeJacobian(dof_positions);
+  ASSERT_TRUE(jacobian_or.ok()) << ToAbslStatus(jacobian_or.status());
+  const eigenmath::Matrix6Nd& jacobian = *jacobian_or;
+  // The prismatic joint moves the tip along its axis without rotating it.
+  eigenmath::Vector6d prismatic_column;
+  prismatic_column << 1, 0, 0, 0, 0, 0;
+  EXPECT_TRUE(jacobian.col(1).isApprox(prismatic_column, kTolerance))
+      << jacobian.col(1).transpose();
+  eigenmath::Vector6d revolute_column;
+  revolute_column << -1, 0, 0, 0, 0, 1;
+  EXPECT_TRUE(jacobian.col(0).isApprox(revolute_column, kTolerance))
+      << jacobian.col(0).transpose();
+  EXPECT_TRUE(jacobian.isApprox(NumericJacobian(chain, dof_positions), 1e-6));
+}
+
+TEST(KinematicChainTest, DofsOutsideTheChainHaveZeroColumns) {
+  ASSERT_OK_AND_ASSIGN(
+      const KinematicChain chain,
+      KinematicChain::Create({{.dof_index = 2}},
+                             Pose3d(eigenmath::Vector3d(1, 0, 0)),
+                             /*num_dof=*/3));
+
+  const RealtimeStatusOr<eigenmath::Matrix6Nd> jacobian_or =
+      chain.ComputeJacobian(eigenmath::VectorNd::Zero(3));
+  ASSERT_TRUE(jacobian_or.ok()) << ToAbslStatus(jacobian_or.status());
+  const eigenmath::Matrix6Nd& jacobian = *jacobian_or;
+  EXPECT_TRUE(jacobian.col(0).isZero());
+  EXPECT_TRUE(jacobian.col(1).isZero());
+  EXPECT_FALSE(jacobian.col(2).isZero());
+}
+
+TEST(KinematicChainTest, RejectsWrongNumberOfDofPositions) {
+  const KinematicChain chain = MakeDhChain();
+  EXPECT_THAT(
+      ToAbslStatus(chain.ComputeFk(eigenmath::VectorNd::Zero(5)).status()),
+      StatusIs(absl::StatusCode::kInvalidArgument));
+  eigenmath::Matrix6NdAligned<7> jacobian;
+  EXPECT_THAT(ToAbslStatus(chain.ComputeJacobian(eigenmath::VectorNd::Zero(6),
+                                                 jacobian)),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+
+  const std::vector<eigenmath::VectorNd> dof_positions = {
+      eigenmath::VectorNd::Zero(6), eigenmath::VectorNd::Zero(5)};
+  std::vector<Pose3d> base_t_tips(dof_positions.size());
+  EXPECT_THAT(ToAbslStatus(chain.ComputeFkBatch(dof_positions,
+                                                absl::MakeSpan(base_t_tips))),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  base_t_tips.pop_back();
+  EXPECT_THAT(ToAbslStatus(chain.ComputeFkBatch(dof_positions,
+                                                absl::MakeSpan(base_t_tips))),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(KinematicChainTest, FkBatchMatchesFk) {
+  const KinematicChain chain = MakeDhChain();
+  std::vector<eigenmath::VectorNd> dof_positions;
+  for (int seed = 0; seed < 5; ++seed) {
+    dof_positions.push_back(MakeDofPositions(6, seed));
+  }
+  std::vector<Pose3d> base_t_tips(dof_positions.size());
+
+  ASSERT_OK(ToAbslStatus(
+      chain.ComputeFkBatch(dof_positions, absl::MakeSpan(base_t_tips))));
+
+  for (int i = 0; i < dof_positions.size(); ++i) {
+    const RealtimeStatusOr<Pose3d> base_t_tip_or =
+        chain.ComputeFk(dof_positions[i]);
+    ASSERT_TRUE(base_t_tip_or.ok()) << ToAbslStatus(base_t_tip_or.status());
+    const Pose3d& base_t_tip = *base_t_tip_or;
+    EXPECT_TRUE(base_t_tips[i].isApprox(base_t_tip, kTolerance));
+  }
+}
+
+TEST(KinematicChainTest, CreateRejectsInvalidJoints) {
+  EXPECT_THAT(KinematicChain::Create({{.dof_index = 1}}, Pose3d(), 1),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("out of range")));
+  EXPECT_THAT(
+      KinematicChain::Create({{.dof_index = 0}, {.dof_index = 0}}, Pose3d(), 1),
+      StatusIs(absl::StatusCode::kInvalidArgument,
+               HasSubstr("More than one joint")));
+  EXPECT_THAT(KinematicChain::Create(
+                  {{.dof_index = 0, .axis = eigenmath::Vector3d::Zero()}},
+                  Pose3d(), 1),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("zero axis")));
+  EXPECT_THAT(KinematicChain::Create({}, Pose3d(), -1),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+// Base link 0, revolute joint 1 about z, link 2, prismatic joint 3 along x,
+// link 4 and the tool frame 5. Link 6 hangs off the base on another branch.
+intrinsic_proto::Skeleton MakeSkeleton() {
+  return ParseTextProtoOrDie(R"pb(
+    name: "robot"
+    links {
+      element {
+        id: 0
+        parent_t_this { orientation { w: 1 } }
+      }
+    }
+    joints {
+      element {
+        id: 1
+        parent: 0
+        parent_t_this {
+          position { z: 0.5 }
+          orientation { w: 1 }
+        }
+      }
+      parameters {
+        type: REVOLUTE
+        axis { z: 1 }
+      }
+    }
+    links {
+      element {
+        id: 2
+        parent: 1
+        parent_t_this {
+          position { x: 1 }
+          orientation { w: 1 }
+        }
+      }
+    }
+    joints {
+      element {
+        id: 3
+        parent: 2
+        parent_t_this { orientation { w: 1 } }
+      }
+      parameters {
+        type: PRISMATIC
+        axis { x: 1 }
+      }
+    }
+    links {
+      element {
+        id: 4
+        parent: 3
+        parent_t_this { orientation { w: 1 } }
+      }
+    }
+    coordinate_frames {
+      element {
+        id: 5
+        parent: 4
+        parent_t_this {
+          position { z: -0.1 }
+          orientation { w: 1 }
+        }
+      }
+    }
+    links {
+      element {
+        id: 6
+        parent: 0
+        parent_t_this { orientation { w: 1 } }
+      }
+    }
+    element_id_to_dof_index { key: 1 value: 0 }
+    element_id_to_dof_index { key: 3 value: 1 }
+  )pb");
+}
+
+TEST(KinematicChainFromSkeletonTest, FollowsThePathFromBaseToTip) {
+  ASSERT_OK_AND_ASSIGN(const KinematicChain chain,
+                       KinematicChain::FromSkeleton(MakeSkeleton(),
+                                                    /*base_element_id=*/0,
+                                                    /*tip_element_id=*/5));
+  ASSERT_EQ(chain.num_dof(), 2);
+  ASSERT_EQ(chain.joints().size(), 2);
+  EXPECT_EQ(chain.joints()[0].type, ChainJoint::Type::kRevolute);
+  EXPECT_EQ(chain.joints()[1].type, ChainJoint::Type::kPrismatic);
+
+  // Rotating by 90 degrees turns the link and the prismatic axis to y.
+  const RealtimeStatusOr<Pose3d> base_t_tip_or =
+      chain.ComputeFk(eigenmath::VectorNd(eigenmath::Vector2d(M_PI / 2, 0.25)));
+  ASSERT_TRUE(base_t_tip_or.ok()) << ToAbslStatus(base_t_tip_or.status());
+  const Pose3d& base_t_tip = *base_t_tip_or;
+  EXPECT_TRUE(base_t_tip.translation().isApprox(
+      eigenmath::Vector3d(0, 1.25, 0.4), kTolerance))
+      << base_t_tip.translation().transpose();
+}
+
+TEST(KinematicChainFromSkeletonTest, StartsAtTheBaseElement) {
+  ASSERT_OK_AND_ASSIGN(const KinematicChain chain,
+                       KinematicChain::FromSkeleton(MakeSkeleton(),
+                                                    /*base_element_id=*/2,
+                                                    /*tip_element_id=*/5));
+  // Only the prismatic joint is on the path, but the DoF vector still covers
+  // all joints of the skeleton.
+  ASSERT_EQ(chain.joints().size(), 1);
+  EXPECT_EQ(chain.joints()[0].dof_index, 1);
+  EXPECT_EQ(chain.num_dof(), 2);
+  const RealtimeStatusOr<Pose3d> base_t_tip_or =
+      chain.ComputeFk(eigenmath::VectorNd(eigenmath::Vector2d(M_PI / 2, 0.25)));
+  ASSERT_TRUE(base_t_tip_or.ok()) << ToAbslStatus(base_t_tip_or.status());
+  const Pose3d& base_t_tip = *base_t_tip_or;
+  EXPECT_TRUE(base_t_tip.translation().isApprox(
+      eigenmath::Vector3d(0.25, 0, -0.1), kTolerance))
+      << base_t_tip.translation().transpose();
+}
+
+TEST(KinematicChainFromSkeletonTest, RejectsJointWithoutDofIndex) {
+  intrinsic_proto::Skeleton skeleton = MakeSkeleton();
+  skeleton.mutable_element_id_to_dof_index()->erase(3);
+  EXPECT_THAT(
+      KinematicChain::FromSkeleton(skeleton, 0, 5),
+      StatusIs(absl::StatusCode::kInvalidArgument,
+               HasSubstr("Joint 3 of skeleton \"robot\" has no DoF index")));
+}
+
+TEST(KinematicChainFromSkeletonTest, RejectsBaseWhichIsNoAncestor) {
+  EXPECT_THAT(KinematicChain::FromSkeleton(MakeSkeleton(),
+                                           /*base_element_id=*/6,
+                                           /*tip_element_id=*/5),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("is not an ancestor")));
+}
+
+TEST(KinematicChainFromSkeletonTest, RejectsUnknownTip) {
+  EXPECT_THAT(KinematicChain::FromSkeleton(MakeSkeleton(),
+                                           /*base_element_id=*/0,
+                                           /*tip_element_id=*/42),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("has no element 42")));
+}
+
+TEST(KinematicChainFromSkeletonTest, RejectsZeroAxis) {
+  intrinsic_proto::Skeleton skeleton = MakeSkeleton();
+  skeleton.mutable_joints(1)->mutable_parameters()->clear_axis();
+  EXPECT_THAT(KinematicChain::FromSkeleton(skeleton, 0, 5),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("zero axis")));
+}
+
+}  // namespace
+}  // namespace intrinsic::kinematics
@@ -37,11 +37,25 @@ class LoggingData {
     return *logging_data;
   }
 
-  absl::Status Init(std::unique_ptr<StructuredLoggingClient::LoggerStub> stub) {
-    logging_client_.emplace(std::move(stub));
+  absl::Status Init(
+      std::unique_ptr<StructuredLoggingClient::LoggerStub> stub,
+      std::optional<StructuredLoggingClient::BufferingOptions>
+          buffering_options = std::nullopt) {
+    if (buffering_options.has_value()) {
+      logging_client_.emplace(std::move(stub), *buffering_options);
+    } else {
+      logging_client_.emplace(std::move(stub));
+    }
     return absl::OkStatus();
   }
 
+  absl::Status Flush(absl::Time deadline) {
+    if (!logging_client_.has_value()) {
+      return absl::FailedPreconditionError(kLoggerNotInitialized);
+    }
+    return logging_client_->Flush(deadline);
+  }
+
   absl::Status Log(const intrinsic_proto::data_logger::LogItem& item) {
     if (!logging_client_.has_value()) {
       return absl::FailedPreconditionError(kLoggerNotInitialized);
@@ -144,4 +158,29 @@ absl::Status StartUpIntrinsicLoggerViaStub(
   return logging_data.Init(std::move(stub));
 }
 
+absl::Status StartUpBufferedIntrinsicLoggerViaGrpc(
+    absl::string_view target_address,
+    const StructuredLoggingClient::BufferingOptions& buffering_options,
+    absl::Duration timeout) {
+  INTR_ASSIGN_OR_RETURN(
+      std::shared_ptr<grpc::Channel> channel,
+      CreateClientChannel(target_address, absl::Now() + timeout,
+                          UnlimitedMessageSizeGrpcChannelArgs()));
+  return StartUpBufferedIntrinsicLoggerViaStub(
+      intrinsic_proto::data_logger::DataLogger::NewStub(channel),
+      buffering_options);
+}
+
+absl::Status StartUpBufferedIntrinsicLoggerViaStub(
+    std::unique_ptr<intrinsic_proto::data_logger::DataLogger::StubInterface>
+        stub,
+    const StructuredLoggingClient::BufferingOptions& buffering_options) {
+  LoggingData& logging_data = LoggingData::Instance();
+  return logging_data.Init(std::move(stub), buffering_options);
+}
+
+absl::Status FlushLogs(absl::Time deadline) {
+  return LoggingData::Instance().Flush(deadline);
+}
+
 }  // namespace intrinsic::data_logger
@@ -11,6 +11,7 @@
 #include "absl/strings/string_view.h"
 #include "absl/time/time.h"
 #include "intrinsic/logging/proto/log_item.pb.h"
+#include "intrinsic/logging/structured_logging_client.h"
 #include "intrinsic/logging/proto/logger_service.grpc.pb.h"
 #include "intrinsic/util/grpc/grpc.h"
 
@@ -28,6 +29,27 @@ absl::Status StartUpIntrinsicLoggerViaStub(
     std::unique_ptr<intrinsic_proto::data_logger::DataLogger::StubInterface>
         stub);
 
+// Like StartUpIntrinsicLoggerViaGrpc(), but buffers the items passed to
+// LogAsync() and sends them in batches, see
+// StructuredLoggingClient::BufferingOptions. Call FlushLogs() before the
+// program exits, items which are still buffered at exit are lost.
+absl::Status StartUpBufferedIntrinsicLoggerViaGrpc(
+    absl::string_view target_address,
+    const StructuredLoggingClient::BufferingOptions& buffering_options,
+    absl::Duration timeout = intrinsic::kGrpcClientConnectDefaultTimeout);
+
+// Like StartUpIntrinsicLoggerViaStub(), but buffers the items passed to
+// LogAsync(). Intended for testing.
+absl::Status StartUpBufferedIntrinsicLoggerViaStub(
+    std::unique_ptr<intrinsic_proto::data_logger::DataLogger::StubInterface>
+        stub,
+    const StructuredLoggingClient::BufferingOptions& buffering_options);
+
+// Sends the items buffered by LogAsync() and waits until they are logged, or
+// until `deadline`. Returns the first error of any batch since the previous
+// FlushLogs(). Returns OK right away if the logger does not buffer.
+absl::Status FlushLogs(absl::Time deadline);
+
 // Generates a random integer with sufficient entropy to be considered globally
 // unique.
 uint64_t GenerateUid();
@@ -0,0 +1,268 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/logging/log_item_batcher.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "intrinsic/util/thread/thread.h"
+
+namespace intrinsic {
+
+LogItemBatcher::LogItemBatcher(const Options& options, SendBatchFn send_batch)
+    : options_(options), send_batch_(std::move(send_batch)) {
+  thread_ = Thread([this] { Run(); });
+}
+
+LogItemBatcher::~LogItemBatcher() {
+  std::vector<Callback> cancelled;
+  {
+    absl::MutexLock lock(&mutex_);
+    stop_ = true;
+    auto all_sent = [this]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+      return sources_.empty() && in_flight_.empty();
+    };
+    if (!mutex_.AwaitWithTimeout(absl::Condition(&all_sent),
+                                 options_.shutdown_timeout)) {
+      for (auto& [event_source, source] : sources_) {
+        for (Entry& entry : source.entries) {
+          cancelled.push_back(std::move(entry.callback));
+        }
+      }
+      stats_.items_dropped += cancelled.size();
+      sources_.clear();
+      buffered_bytes_ = 0;
+    }
+  }
+  for (Callback& callback : cancelled) {
+    if (callback) {
+      callback(absl::CancelledError(
+          "Shut down before the log item could be sent."));
+    }
+  }
+  thread_.Join();
+
+  // The completion callbacks of batches in flight still refer to this object.
+  absl::MutexLock lock(&mutex_);
+  mutex_.Await(absl::Condition(
+      +[](std::multiset<uint64_t>* in_flight) { return in_flight->empty(); },
+      &in_flight_));
+}
+
+void LogItemBatcher::Add(LogItem&& item, Callback callback) {
+  const size_t bytes = item.ByteSizeLong();
+  std::vector<Callback> dropped;
+  {
+    absl::MutexLock lock(&mutex_);
+    if (options_.overflow_policy == Options::OverflowPolicy::kBlock) {
+      auto has_space = [this, bytes]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+        // An item larger than the whole buffer is accepted once the buffer
+        // is empty.
+        return buffered_bytes_ == 0 ||
+               buffered_bytes_ + bytes <= options_.max_buffered_bytes;
+      };
+      mutex_.Await(absl::Condition(&has_space));
+    } else {
+      while (buffered_bytes_ > 0 &&
+             buffered_bytes_ + bytes > options_.max_buffered_bytes) {
+        dropped.push_back(DropOldest());
+      }
+    }
+    Source& source = sources_[item.metadata().event_source()];
+    source.entries.push_back(Entry{.item = std::move(item),
+                                   .bytes = bytes,
+                                   .callback = std::move(callback),
+                                   .sequence = next_sequence_++,
+                                   .added = absl::Now()});
+    source.bytes += bytes;
+    buffered_bytes_ += bytes;
+  }
+  for (Callback& callback : dropped) {
+    if (callback) {
+      callback(absl::ResourceExhaustedError(
+          "Log item dropped because the log buffer is full."));
+    }
+  }
+}
+
+absl::Status LogItemBatcher::Flush(absl::Time deadline) {
+  absl::MutexLock lock(&mutex_);
+  const uint64_t sequence = next_sequence_;
+  flush_sequence_ = std::max(flush_sequence_, sequence);
+  auto acknowledged = [this, sequence]()
+                          ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+                            return IsAcknowledged(sequence);
+                          };
+  if (!mutex_.AwaitWithDeadline(absl::Condition(&acknowledged), deadline)) {
+    return absl::DeadlineExceededError(
+        "Deadline exceeded while flushing buffered log items.");
+  }
+  return std::exchange(status_, absl::OkStatus());
+}
+
+LogItemBatcher::Stats LogItemBatcher::stats() const {
+  absl::MutexLock lock(&mutex_);
+  return stats_;
+}
+
+bool LogItemBatcher::IsReady(const Source& source, absl::Time now) const {
+  if (source.entries.empty()) {
+    return false;
+  }
+  return stop_ || source.entries.size() >=
+             static_cast<size_t>(options_.max_batch_items) ||
+         source.bytes >= options_.max_batch_bytes ||
+         source.entries.front().sequence < flush_sequence_ ||
+         now - source.entries.front().added >= options_.max_delay;
+}
+
+bool LogItemBatcher::IsAcknowledged(uint64_t sequence) const {
+  if (!in_flight_.empty() && *in_flight_.begin() < sequence) {
+    return false;
+  }
+  for (const auto& [event_source, source] : sources_) {
+    if (!source.entries.empty() &&
+        source.entries.front().sequence < sequence) {
+      return false;
+    }
+  }
+  return true;
+}
+
+LogItemBatcher::Callback LogItemBatcher::DropOldest() {
+  auto oldest = sources_.end();
+  for (auto it = sources_.begin(); it != sources_.end(); ++it) {
+    if (oldest == sources_.end() ||
+        it->second.entries.front().sequence <
+            oldest->second.entries.front().sequence) {
+      oldest = it;
+    }
+  }
+  Source& source = oldest->second;
+  Callback callback = std::move(source.entries.front().callback);
+  source.bytes -= source.entries.front().bytes;
+  buffered_bytes_ -= source.entries.front().bytes;
+  source.entries.pop_front();
+  if (source.entries.empty()) {
+    sources_.erase(oldest);
+  }
+  ++stats_.items_dropped;
+  return callback;
+}
+
+LogItemBatcher::Batch LogItemBatcher::TakeBatch(absl::string_view event_source,
+                                                Source& source) {
+  Batch batch;
+  batch.event_source = std::string(event_source);
+  batch.first_sequence = source.entries.front().sequence;
+  size_t bytes = 0;
+  // Always takes at least one item, so items larger than max_batch_bytes are
+  // sent on their own.
+  while (!source.entries.empty() &&
+         batch.items.size() < static_cast<size_t>(options_.max_batch_items) &&
+         (batch.items.empty() ||
+          bytes + source.entries.front().bytes <= options_.max_batch_bytes)) {
+    Entry& entry = source.entries.front();
+    bytes += entry.bytes;
+    batch.items.push_back(std::move(entry.item));
+    batch.callbacks.push_back(std::move(entry.callback));
+    source.entries.pop_front();
+  }
+  source.bytes -= bytes;
+  buffered_bytes_ -= bytes;
+  return batch;
+}
+
+void LogItemBatcher::Send(Batch batch) {
+  send_batch_(
+      std::move(batch.items),
+      [this, callbacks = std::move(batch.callbacks),
+       first_sequence = batch.first_sequence](absl::Status status) {
+        for (const Callback& callback : callbacks) {
+          if (callback) {
+            callback(status);
+          }
+        }
+        absl::MutexLock lock(&mutex_);
+        in_flight_.erase(in_flight_.find(first_sequence));
+        if (status.ok()) {
+          ++stats_.batches_sent;
+          stats_.items_sent += callbacks.size();
+        } else {
+          ++stats_.batches_failed;
+          status_.Update(status);
+        }
+      });
+}
+
+void LogItemBatcher::Run() {
+  absl::MutexLock lock(&mutex_);
+  while (!stop_ || !sources_.empty()) {
+    const bool at_capacity =
+        in_flight_.size() >=
+        static_cast<size_t>(options_.max_batches_in_flight);
+    absl::Time next_deadline = absl::InfiniteFuture();
+    if (!at_capacity) {
+      // Sends the ready source with the oldest item first, so that one busy
+      // event source cannot starve the others.
+      const absl::Time now = absl::Now();
+      auto ready = sources_.end();
+      for (auto it = sources_.begin(); it != sources_.end(); ++it) {
+        const Source& source = it->second;
+        if (IsReady(source, now)) {
+          if (ready == sources_.end() ||
+              source.entries.front().sequence <
+                  ready->second.entries.front().sequence) {
+            ready = it;
+          }
+        } else if (!source.entries.empty()) {
+          next_deadline = std::min(
+              next_deadline, source.entries.front().added + options_.max_delay);
+        }
+      }
+      if (ready != sources_.end()) {
+        Batch batch = TakeBatch(ready->first, ready->second);
+        if (ready->second.entries.empty()) {
+          sources_.erase(ready);
+        }
+        in_flight_.insert(batch.first_sequence);
+        mutex_.Unlock();
+        Send(std::move(batch));
+        mutex_.Lock();
+        continue;
+      }
+    }
+
+    // Sources which become ready by age are covered by `next_deadline`.
+    auto has_work = [this, at_capacity]()
+                        ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+                          if (at_capacity) {
+                            return in_flight_.size() <
+                                   static_cast<size_t>(
+                                       options_.max_batches_in_flight);
+                          }
+                          if (stop_ && sources_.empty()) {
+                            return true;
+                          }
+                          for (const auto& [event_source, source] : sources_) {
+                            if (IsReady(source, absl::InfinitePast())) {
+                              return true;
+                            }
+                          }
+                          return false;
+                        };
+    mutex_.AwaitWithDeadline(absl::Condition(&has_work), next_deadline);
+  }
+}
+
+}  // namespace intrinsic
@@ -0,0 +1,157 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#ifndef INTRINSIC_LOGGING_LOG_ITEM_BATCHER_H_
+#define INTRINSIC_LOGGING_LOG_ITEM_BATCHER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "intrinsic/logging/proto/log_item.pb.h"
+#include "intrinsic/util/thread/thread.h"
+
+namespace intrinsic {
+
+// Buffers LogItems per event source and hands them to a sender in batches,
+// from a background thread. A batch is sent when its event source has enough
+// buffered items or bytes, or when its oldest item has waited long enough.
+//
+// The class is thread-safe.
+class LogItemBatcher {
+ public:
+  using LogItem = ::intrinsic_proto::data_logger::LogItem;
+  using Callback = std::function<void(absl::Status)>;
+
+  // Sends `items`, which all have the same event source, and calls `done` once
+  // with the result. May be called again before `done` was called, up to
+  // Options::max_batches_in_flight times.
+  using SendBatchFn =
+      std::function<void(std::vector<LogItem> items, Callback done)>;
+
+  struct Options {
+    // What Add() does when the buffer is full.
+    enum class OverflowPolicy {
+      // Drops the oldest buffered item, whose callback receives a
+      // ResourceExhausted error.
+      kDropOldest,
+      // Blocks until there is space in the buffer.
+      kBlock,
+    };
+
+    // An event source is sent once it has this many buffered items ...
+    int max_batch_items = 512;
+    // ... or this many buffered bytes ...
+    size_t max_batch_bytes = 1 << 20;
+    // ... or once its oldest buffered item is this old.
+    absl::Duration max_delay = absl::Milliseconds(100);
+
+    // Bounds the serialized size of all items which were added but not sent
+    // yet.
+    size_t max_buffered_bytes = 32 << 20;
+    OverflowPolicy overflow_policy = OverflowPolicy::kDropOldest;
+
+    // Number of batches that may be sent concurrently.
+    int max_batches_in_flight = 4;
+
+    // How long the destructor waits for buffered items to be sent.
+    absl::Duration shutdown_timeout = absl::Seconds(5);
+  };
+
+  struct Stats {
+    // Items of batches the sender acknowledged.
+    int64_t items_sent = 0;
+    // Items dropped because the buffer was full or at shutdown.
+    int64_t items_dropped = 0;
+    // Batches the sender acknowledged.
+    int64_t batches_sent = 0;
+    // Batches the sender reported an error for.
+    int64_t batches_failed = 0;
+  };
+
+  LogItemBatcher(const Options& options, SendBatchFn send_batch);
+
+  // Sends the buffered items, waiting at most Options::shutdown_timeout, and
+  // then waits for all batches in flight. The callbacks of items that could not
+  // be sent in time receive a Cancelled error.
+  ~LogItemBatcher();
+
+  LogItemBatcher(const LogItemBatcher&) = delete;
+  LogItemBatcher& operator=(const LogItemBatcher&) = delete;
+
+  // Buffers `item`. `callback`, which may be empty, is called with the result
+  // of the batch that contains the item. It may be called on any thread,
+  // including the calling thread if the item is dropped right away.
+  void Add(LogItem&& item, Callback callback);
+
+  // Sends all items which were added before the call without waiting for
+  // their batches to fill up, and waits until they are acknowledged. Returns
+  // the first error of any batch since the previous Flush(), or
+  // DeadlineExceeded if waiting takes until `deadline`.
+  absl::Status Flush(absl::Time deadline);
+
+  Stats stats() const;
+
+ private:
+  struct Entry {
+    LogItem item;
+    size_t bytes;
+    Callback callback;
+    uint64_t sequence;
+    absl::Time added;
+  };
+  struct Source {
+    std::deque<Entry> entries;
+    size_t bytes = 0;
+  };
+  struct Batch {
+    std::string event_source;
+    std::vector<LogItem> items;
+    std::vector<Callback> callbacks;
+    uint64_t first_sequence;
+  };
+
+  // Returns true if a batch of `source` should be sent at `now`.
+  bool IsReady(const Source& source, absl::Time now) const
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Returns true if all items up to `sequence` are acknowledged.
+  bool IsAcknowledged(uint64_t sequence) const
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Removes the oldest buffered item and returns its callback.
+  Callback DropOldest() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  Batch TakeBatch(absl::string_view event_source, Source& source)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void Send(Batch batch);
+  void Run();
+
+  const Options options_;
+  const SendBatchFn send_batch_;
+
+  mutable absl::Mutex mutex_;
+  absl::flat_hash_map<std::string, Source> sources_ ABSL_GUARDED_BY(mutex_);
+  size_t buffered_bytes_ ABSL_GUARDED_BY(mutex_) = 0;
+  uint64_t next_sequence_ ABSL_GUARDED_BY(mutex_) = 0;
+  // Items up to this sequence are sent regardless of their batch size.
+  uint64_t flush_sequence_ ABSL_GUARDED_BY(mutex_) = 0;
+  // The first sequence of each batch in flight.
+  std::multiset<uint64_t> in_flight_ ABSL_GUARDED_BY(mutex_);
+  bool stop_ ABSL_GUARDED_BY(mutex_) = false;
+  // The first batch error since the previous Flush().
+  absl::Status status_ ABSL_GUARDED_BY(mutex_);
+  Stats stats_ ABSL_GUARDED_BY(mutex_);
+
+  Thread thread_;
+};
+
+}  // namespace intrinsic
+
+#endif  // INTRINSIC_LOGGING_LOG_ITEM_BATCHER_H_
@@ -0,0 +1,254 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/logging/log_item_batcher.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "intrinsic/logging/proto/log_item.pb.h"
+#include "intrinsic/util/testing/gtest_wrapper.h"
+#include "intrinsic/util/thread/thread.h"
+
+namespace intrinsic {
+namespace {
+
+using ::intrinsic::testing::StatusIs;
+using ::intrinsic_proto::data_logger::LogItem;
+using ::testing::ElementsAre;
+using ::testing::UnorderedElementsAre;
+
+LogItem Item(absl::string_view event_source, absl::string_view payload = "") {
+  LogItem item;
+  item.mutable_metadata()->set_event_source(std::string(event_source));
+  item.mutable_payload()->mutable_any()->set_value(std::string(payload));
+  return item;
+}
+
+// Records the batches it receives and acknowledges them right away, unless
+// `hold` is set.
+class FakeSender {
+ public:
+  LogItemBatcher::SendBatchFn AsFunction() {
+    return [this](std::vector<LogItem> items, LogItemBatcher::Callback done) {
+      absl::MutexLock lock(&mutex_);
+      std::vector<std::string> event_sources;
+      for (const LogItem& item : items) {
+        event_sources.push_back(item.metadata().event_source());
+      }
+      batches_.push_back(std::move(event_sources));
+      if (hold_) {
+        held_.push_back(std::move(done));
+        return;
+      }
+      const absl::Status status = status_;
+      mutex_.Unlock();
+      done(status);
+      mutex_.Lock();
+    };
+  }
+
+  void set_hold(bool hold) {
+    absl::MutexLock lock(&mutex_);
+    hold_ = hold;
+  }
+  void set_status(absl::Status status) {
+    absl::MutexLock lock(&mutex_);
+    status_ = std::move(status);
+  }
+
+  // Acknowledges all held batches.
+  void Release() {
+    std::vector<LogItemBatcher::Callback> held;
+    {
+      absl::MutexLock lock(&mutex_);
+      held.swap(held_);
+      hold_ = false;
+    }
+    for (LogItemBatcher::Callback& done : held) {
+      done(absl::OkStatus());
+    }
+  }
+
+  std::vector<std::vector<std::string>> batches() {
+    absl::MutexLock lock(&mutex_);
+    return batches_;
+  }
+
+  void WaitForBatches(size_t count) {
+    absl::MutexLock lock(&mutex_);
+    auto received = [this, count]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+      return batches_.size() >= count;
+    };
+    mutex_.Await(absl::Condition(&received));
+  }
+
+ private:
+  absl::Mutex mutex_;
+  bool hold_ ABSL_GUARDED_BY(mutex_) = false;
+  absl::Status status_ ABSL_GUARDED_BY(mutex_);
+  std::vector<std::vector<std::string>> batches_ ABSL_GUARDED_BY(mutex_);
+  std::vector<LogItemBatcher::Callback> held_ ABSL_GUARDED_BY(mutex_);
+};
+
+TEST(LogItemBatcherTest, SendsFullBatchesPerEventSource) {
+  FakeSender sender;
+  LogItemBatcher batcher({.max_batch_items = 2, .max_delay = absl::Hours(1)},
+                         sender.AsFunction());
+  batcher.Add(Item("a"), nullptr);
+  batcher.Add(Item("b"), nullptr);
+  batcher.Add(Item("a"), nullptr);
+  batcher.Add(Item("b"), nullptr);
+
+  sender.WaitForBatches(2);
+  EXPECT_THAT(sender.batches(), UnorderedElementsAre(ElementsAre("a", "a"),
+                                                    ElementsAre("b", "b")));
+}
+
+TEST(LogItemBatcherTest, SendsPartialBatchesAfterMaxDelay) {
+  FakeSender sender;
+  LogItemBatcher batcher(
+      {.max_batch_items = 100, .max_delay = absl::Milliseconds(10)},
+      sender.AsFunction());
+  absl::Notification done;
+  batcher.Add(Item("a"), [&](absl::Status status) {
+    EXPECT_OK(status);
+    done.Notify();
+  });
+  EXPECT_TRUE(done.WaitForNotificationWithTimeout(absl::Seconds(10)));
+  EXPECT_THAT(sender.batches(), ElementsAre(ElementsAre("a")));
+}
+
+TEST(LogItemBatcherTest, FlushSendsAndWaitsForBufferedItems) {
+  FakeSender sender;
+  LogItemBatcher batcher({.max_batch_items = 100, .max_delay = absl::Hours(1)},
+                         sender.AsFunction());
+  int acknowledged = 0;
+  for (int i = 0; i < 3; ++i) {
+    batcher.Add(Item("a"), [&](absl::Status status) {
+      EXPECT_OK(status);
+      ++acknowledged;
+    });
+  }
+  ASSERT_OK(batcher.Flush(absl::Now() + absl::Seconds(10)));
+  EXPECT_EQ(acknowledged, 3);
+  EXPECT_THAT(sender.batches(), ElementsAre(ElementsAre("a", "a", "a")));
+  EXPECT_EQ(batcher.stats().items_sent, 3);
+}
+
+TEST(LogItemBatcherTest, FlushTimesOutWhileBatchesAreInFlight) {
+  FakeSender sender;
+  sender.set_hold(true);
+  LogItemBatcher batcher({.max_delay = absl::Hours(1)}, sender.AsFunction());
+  batcher.Add(Item("a"), nullptr);
+  EXPECT_THAT(batcher.Flush(absl::Now() + absl::Milliseconds(10)),
+              StatusIs(absl::StatusCode::kDeadlineExceeded));
+  sender.Release();
+  EXPECT_OK(batcher.Flush(absl::Now() + absl::Seconds(10)));
+}
+
+TEST(LogItemBatcherTest, DropsOldestItemsWhenFull) {
+  FakeSender sender;
+  const size_t item_bytes = Item("a", "payload").ByteSizeLong();
+  LogItemBatcher batcher({.max_batch_items = 100,
+                          .max_delay = absl::Hours(1),
+                          .max_buffered_bytes = 2 * item_bytes},
+                         sender.AsFunction());
+  std::vector<absl::Status> statuses(3);
+  for (int i = 0; i < 3; ++i) {
+    batcher.Add(Item("a", "payload"),
+                [&statuses, i](absl::Status status) { statuses[i] = status; });
+  }
+  ASSERT_OK(batcher.Flush(absl::Now() + absl::Seconds(10)));
+  EXPECT_THAT(statuses[0], StatusIs(absl::StatusCode::kResourceExhausted));
+  EXPECT_OK(statuses[1]);
+  EXPECT_OK(statuses[2]);
+  EXPECT_EQ(batcher.stats().items_dropped, 1);
+}
+
+TEST(LogItemBatcherTest, BlocksWhenFull) {
+  FakeSender sender;
+  sender.set_hold(true);
+  const size_t item_bytes = Item("a", "payload").ByteSizeLong();
+  LogItemBatcher batcher(
+      {.max_batch_items = 1,
+       .max_buffered_bytes = item_bytes,
+       .overflow_policy = LogItemBatcher::Options::OverflowPolicy::kBlock,
+       .max_batches_in_flight = 1},
+      sender.AsFunction());
+  // The first item is held in flight, the second one fills the buffer.
+  batcher.Add(Item("a", "payload"), nullptr);
+  sender.WaitForBatches(1);
+  batcher.Add(Item("a", "payload"), nullptr);
+
+  absl::Notification added;
+  Thread thread([&] {
+    batcher.Add(Item("a", "payload"), nullptr);
+    added.Notify();
+  });
+  EXPECT_FALSE(added.WaitForNotificationWithTimeout(absl::Milliseconds(50)));
+  sender.Release();
+  EXPECT_TRUE(added.WaitForNotificationWithTimeout(absl::Seconds(10)));
+  thread.Join();
+  ASSERT_OK(batcher.Flush(absl::Now() + absl::Seconds(10)));
+  EXPECT_EQ(batcher.stats().items_dropped, 0);
+  EXPECT_EQ(batcher.stats().items_sent, 3);
+}
+
+TEST(LogItemBatcherTest, PassesSendErrorsToCallbacks) {
+  FakeSender sender;
+  sender.set_status(absl::UnavailableError("down"));
+  LogItemBatcher batcher({.max_delay = absl::Hours(1)}, sender.AsFunction());
+  absl::Status result;
+  batcher.Add(Item("a"), [&](absl::Status status) { result = status; });
+  EXPECT_THAT(batcher.Flush(absl::Now() + absl::Seconds(10)),
+              StatusIs(absl::StatusCode::kUnavailable));
+  EXPECT_THAT(result, StatusIs(absl::StatusCode::kUnavailable));
+  EXPECT_EQ(batcher.stats().batches_sent, 0);
+  EXPECT_EQ(batcher.stats().batches_failed, 1);
+  EXPECT_EQ(batcher.stats().items_sent, 0);
+}
+
+TEST(LogItemBatcherTest, FlushReturnsFirstErrorOnce) {
+  FakeSender sender;
+  LogItemBatcher batcher({.max_delay = absl::Hours(1)}, sender.AsFunction());
+  sender.set_status(absl::UnavailableError("down"));
+  batcher.Add(Item("a"), nullptr);
+  batcher.Add(Item("b"), nullptr);
+  EXPECT_THAT(batcher.Flush(absl::Now() + absl::Seconds(10)),
+              StatusIs(absl::StatusCode::kUnavailable));
+
+  sender.set_status(absl::OkStatus());
+  batcher.Add(Item("a"), nullptr);
+  EXPECT_OK(batcher.Flush(absl::Now() + absl::Seconds(10)));
+  const LogItemBatcher::Stats stats = batcher.stats();
+  EXPECT_EQ(stats.batches_sent, 1);
+  EXPECT_EQ(stats.batches_failed, 2);
+  EXPECT_EQ(stats.items_sent, 1);
+}
+
+TEST(LogItemBatcherTest, SendsBufferedItemsOnDestruction) {
+  FakeSender sender;
+  {
+    LogItemBatcher batcher({.max_batch_items = 100,
+                            .max_delay = absl::Hours(1)},
+                           sender.AsFunction());
+    batcher.Add(Item("a"), nullptr);
+    batcher.Add(Item("b"), nullptr);
+  }
+  EXPECT_THAT(sender.batches(),
+              UnorderedElementsAre(ElementsAre("a"), ElementsAre("b")));
+}
+
+}  // namespace
+}  // namespace intrinsic
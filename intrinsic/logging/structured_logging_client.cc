@@ -2,6 +2,7 @@
 
 #include "intrinsic/logging/structured_logging_client.h"
 
+#include <atomic>
 #include <functional>
 #include <iterator>
 #include <limits>
@@ -15,10 +16,14 @@
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
 #include "absl/time/time.h"
+#include "google/protobuf/arena.h"
 #include "grpcpp/channel.h"
 #include "grpcpp/client_context.h"
 #include "grpcpp/support/status.h"
+#include "intrinsic/logging/log_item_batcher.h"
 #include "intrinsic/logging/proto/logger_service.grpc.pb.h"
 #include "intrinsic/logging/proto/logger_service.pb.h"
 #include "intrinsic/util/grpc/grpc.h"
@@ -30,6 +35,41 @@ namespace intrinsic {
 
 using intrinsic_proto::data_logger::LogOptions;
 
+namespace {
+
+// Sends one log item with the unary Log RPC.
+void LogUnbuffered(StructuredLoggingClient::LoggerStub& stub,
+                   StructuredLoggingClient::LogItem&& item,
+                   std::function<void(absl::Status)> callback) {
+  struct LogArgs {
+    // Both, the context as well as the response need to persist until the
+    // callback function is invoked regardless of whether the response is used
+    // in the callback or not.
+    grpc::ClientContext context;
+    google::protobuf::Empty response;
+    std::function<void(absl::Status)> callback;
+  };
+
+  intrinsic_proto::data_logger::LogRequest request;
+  *request.mutable_item() = std::move(item);
+
+  // We need a shared_ptr here because the lambda below must remain copyable and
+  // this is not the case if we used a unique_ptr.
+  auto args = std::make_shared<LogArgs>();
+  args->callback = std::move(callback);
+  stub.async()->Log(
+      &args->context, &request, &args->response,
+      [args](grpc::Status s) mutable {
+        // Releases the call before running the callback, which may let the
+        // owner destroy the client and its channel.
+        std::function<void(absl::Status)> callback = std::move(args->callback);
+        args.reset();
+        callback(ToAbslStatus(s));
+      });
+}
+
+}  // namespace
+
 struct StructuredLoggingClient::StructuredLoggingClientImpl {
   explicit StructuredLoggingClientImpl(
       const std::shared_ptr<grpc::Channel>& channel)
@@ -39,12 +79,223 @@ struct StructuredLoggingClient::StructuredLoggingClientImpl {
       std::unique_ptr<StructuredLoggingClient::LoggerStub> stub)
       : stub(std::move(stub)) {}
 
+  void EnableBuffering(const BufferingOptions& options) {
+    batcher = std::make_unique<LogItemBatcher>(
+        options, [this](std::vector<LogItem> items,
+                        LogItemBatcher::Callback done) {
+          SendBatch(std::move(items), std::move(done));
+        });
+  }
+
+  // Sends `items` with one LogBatch RPC, or with one Log RPC per item if the
+  // service does not implement LogBatch.
+  void SendBatch(std::vector<LogItem> items, LogItemBatcher::Callback done) {
+    // Warns once per failed batch, instead of once per item like the default
+    // callback of unbuffered LogAsync() calls.
+    done = [done = std::move(done), num_items = items.size(),
+            event_source = items.front().metadata().event_source()](
+               absl::Status status) {
+      if (!status.ok()) {
+        LOG(WARNING) << "Failed to log " << num_items
+                     << " items for event source '" << event_source
+                     << "' in async call: " << status;
+      }
+      done(std::move(status));
+    };
+    if (log_batch_unimplemented.load(std::memory_order_relaxed)) {
+      SendIndividually(std::move(items), std::move(done));
+      return;
+    }
+
+    struct LogBatchArgs {
+      grpc::ClientContext context;
+      intrinsic_proto::data_logger::LogBatchRequest request;
+      google::protobuf::Empty response;
+      LogItemBatcher::Callback done;
+    };
+    auto args = std::make_shared<LogBatchArgs>();
+    args->request.mutable_items()->Reserve(items.size());
+    for (LogItem& item : items) {
+      *args->request.add_items() = std::move(item);
+    }
+    args->done = std::move(done);
+    stub->async()->LogBatch(
+        &args->context, &args->request, &args->response,
+        [this, args](grpc::Status s) mutable {
+          // Like in LogUnbuffered(), the call is released before `done` runs,
+          // since the client may be destroyed as soon as the batch is done.
+          LogItemBatcher::Callback done = std::move(args->done);
+          if (s.error_code() == grpc::StatusCode::UNIMPLEMENTED) {
+            LOG(INFO) << "The logging service does not implement LogBatch, "
+                         "falling back to one Log call per item.";
+            log_batch_unimplemented.store(true, std::memory_order_relaxed);
+            std::vector<LogItem> items(
+                std::make_move_iterator(args->request.mutable_items()->begin()),
+                std::make_move_iterator(args->request.mutable_items()->end()));
+            args.reset();
+            SendIndividually(std::move(items), std::move(done));
+            return;
+          }
+          args.reset();
+          done(ToAbslStatus(s));
+        });
+  }
+
+  // Pipelines one Log RPC per item and calls `done` with the first error once
+  // all of them finished.
+  void SendIndividually(std::vector<LogItem> items,
+                        LogItemBatcher::Callback done) {
+    struct Pending {
+      absl::Mutex mutex;
+      size_t remaining ABSL_GUARDED_BY(mutex);
+      absl::Status status ABSL_GUARDED_BY(mutex);
+      LogItemBatcher::Callback done;
+    };
+    auto pending = std::make_shared<Pending>();
+    pending->remaining = items.size();
+    pending->done = std::move(done);
+    for (LogItem& item : items) {
+      LogUnbuffered(*stub, std::move(item), [pending](absl::Status s) {
+        absl::Status status;
+        {
+          absl::MutexLock lock(&pending->mutex);
+          pending->status.Update(s);
+          if (--pending->remaining > 0) {
+            return;
+          }
+          status = pending->status;
+        }
+        pending->done(std::move(status));
+      });
+    }
+  }
+
   // We do not need to protect the stub with a dedicated mutex since the "stub
   // is thread-safe and should be re-used for multiple (concurrent) RPCs".
   // https://github.com/grpc/grpc/issues/5649
   std::unique_ptr<intrinsic_proto::data_logger::DataLogger::StubInterface> stub;
+
+  // Set once the service answered a LogBatch call with UNIMPLEMENTED.
+  std::atomic<bool> log_batch_unimplemented = false;
+
+  // Only set for buffering clients. Declared last, so that the buffered items
+  // are sent before the stub is destroyed.
+  std::unique_ptr<LogItemBatcher> batcher;
 };
 
+struct StructuredLoggingClient::LogItemReader::LogItemReaderImpl {
+  // One GetLogItems call and its response.
+  struct Page {
+    grpc::ClientContext context;
+    intrinsic_proto::data_logger::GetLogItemsRequest request;
+    intrinsic_proto::data_logger::GetLogItemsResponse* response = nullptr;
+    // Owns `response` unless it is allocated on ReadOptions::arena.
+    std::unique_ptr<intrinsic_proto::data_logger::GetLogItemsResponse>
+        owned_response;
+    grpc::Status status;
+    absl::Notification done;
+  };
+
+  LogItemReaderImpl(LoggerStub* stub, const ReadOptions& options,
+                    intrinsic_proto::data_logger::GetLogItemsRequest request)
+      : stub(stub), options(options), request(std::move(request)) {}
+
+  ~LogItemReaderImpl() {
+    if (pending != nullptr) {
+      pending->context.TryCancel();
+      pending->done.WaitForNotification();
+    }
+  }
+
+  // Starts the GetLogItems call which continues at `cursor`, or at
+  // ReadOptions::start_time for the first page.
+  std::unique_ptr<Page> Fetch(absl::string_view cursor) {
+    auto page = std::make_unique<Page>();
+    page->request = request;
+    if (!cursor.empty()) {
+      page->request.set_cursor(std::string(cursor));
+    }
+    if (options.arena != nullptr) {
+      page->response = google::protobuf::Arena::CreateMessage<
+          intrinsic_proto::data_logger::GetLogItemsResponse>(options.arena);
+    } else {
+      page->owned_response = std::make_unique<
+          intrinsic_proto::data_logger::GetLogItemsResponse>();
+      page->response = page->owned_response.get();
+    }
+    Page* page_ptr = page.get();
+    stub->async()->GetLogItems(&page->context, &page->request, page->response,
+                               [page_ptr](grpc::Status s) {
+                                 page_ptr->status = std::move(s);
+                                 page_ptr->done.Notify();
+                               });
+    return page;
+  }
+
+  absl::StatusOr<const LogItem*> Next() {
+    while (true) {
+      if (current != nullptr && index < current->response->log_items_size()) {
+        return &current->response->log_items(index++);
+      }
+      if (pending == nullptr) {
+        if (finished) {
+          return nullptr;
+        }
+        pending = Fetch(next_cursor);
+      }
+      pending->done.WaitForNotification();
+      // Frees the page which was read last.
+      current = std::move(pending);
+      index = 0;
+      if (!current->status.ok()) {
+        finished = true;
+        return ToAbslStatus(current->status);
+      }
+      // The service returns fewer items than requested when it reaches its
+      // response size limit, so only `truncated` tells whether more items
+      // follow. It always returns a cursor, to allow polling for new items.
+      finished = !current->response->truncated() ||
+                 current->response->log_items_size() == 0;
+      if (!finished) {
+        next_cursor = current->response->cursor();
+        if (options.prefetch) {
+          pending = Fetch(next_cursor);
+        }
+      }
+    }
+  }
+
+  LoggerStub* stub;
+  const ReadOptions options;
+  // The request for the first page. Later pages additionally set the cursor.
+  const intrinsic_proto::data_logger::GetLogItemsRequest request;
+
+  std::unique_ptr<Page> current;
+  int index = 0;
+  // The page being fetched, if any.
+  std::unique_ptr<Page> pending;
+  std::string next_cursor;
+  // Set once no further page needs to be fetched.
+  bool finished = false;
+};
+
+StructuredLoggingClient::LogItemReader::LogItemReader(
+    std::unique_ptr<LogItemReaderImpl> impl)
+    : impl_(std::move(impl)) {}
+
+StructuredLoggingClient::LogItemReader::LogItemReader(LogItemReader&&) =
+    default;
+
+StructuredLoggingClient::LogItemReader&
+StructuredLoggingClient::LogItemReader::operator=(LogItemReader&&) = default;
+
+StructuredLoggingClient::LogItemReader::~LogItemReader() = default;
+
+absl::StatusOr<const StructuredLoggingClient::LogItem*>
+StructuredLoggingClient::LogItemReader::Next() {
+  return impl_->Next();
+}
+
 absl::StatusOr<StructuredLoggingClient> StructuredLoggingClient::Create(
     absl::string_view address, absl::Time deadline) {
   INTR_ASSIGN_OR_RETURN(
@@ -62,6 +313,20 @@ StructuredLoggingClient::StructuredLoggingClient(
     std::unique_ptr<StructuredLoggingClient::LoggerStub> stub)
     : impl_(std::make_unique<StructuredLoggingClientImpl>(std::move(stub))) {}
 
+StructuredLoggingClient::StructuredLoggingClient(
+    const std::shared_ptr<grpc::Channel>& channel,
+    const BufferingOptions& buffering_options)
+    : StructuredLoggingClient(channel) {
+  impl_->EnableBuffering(buffering_options);
+}
+
+StructuredLoggingClient::StructuredLoggingClient(
+    std::unique_ptr<StructuredLoggingClient::LoggerStub> stub,
+    const BufferingOptions& buffering_options)
+    : StructuredLoggingClient(std::move(stub)) {
+  impl_->EnableBuffering(buffering_options);
+}
+
 // Functions are defaulted here because of the pimpl idiom.
 // StructuredLoggingClientImpl is an incomplete type when only inspecting the
 // header file.
@@ -89,6 +354,11 @@ absl::Status StructuredLoggingClient::Log(const LogItem& item) const {
 }
 
 void StructuredLoggingClient::LogAsync(LogItem&& item) const {
+  if (impl_->batcher != nullptr) {
+    // Failures are reported per batch.
+    impl_->batcher->Add(std::move(item), nullptr);
+    return;
+  }
   std::string event_source = item.metadata().event_source();
   return LogAsync(std::move(item),
                   [event_source = std::move(event_source)](absl::Status s) {
@@ -101,25 +371,11 @@ void StructuredLoggingClient::LogAsync(LogItem&& item) const {
 
 void StructuredLoggingClient::LogAsync(
     LogItem&& item, std::function<void(absl::Status)> callback) const {
-  struct LogArgs {
-    // Both, the context as well as the response need to persist until the
-    // callback function is invoked regardless of whether the response is used
-    // in the callback or not.
-    grpc::ClientContext context;
-    google::protobuf::Empty response;
-    std::function<void(absl::Status)> callback;
-  };
-
-  intrinsic_proto::data_logger::LogRequest request;
-  *request.mutable_item() = std::move(item);
-
-  // We need a shared_ptr here because the lambda below must remain copyable and
-  // this is not the case if we used a unique_ptr.
-  auto args = std::make_shared<LogArgs>();
-  args->callback = std::move(callback);
-  impl_->stub->async()->Log(
-      &args->context, &request, &args->response,
-      [args](grpc::Status s) { args->callback(ToAbslStatus(s)); });
+  if (impl_->batcher != nullptr) {
+    impl_->batcher->Add(std::move(item), std::move(callback));
+    return;
+  }
+  LogUnbuffered(*impl_->stub, std::move(item), std::move(callback));
 }
 
 void StructuredLoggingClient::LogAsync(const LogItem& item) const {
@@ -133,6 +389,13 @@ void StructuredLoggingClient::LogAsync(
   return LogAsync(std::move(log_item), std::move(callback));
 }
 
+absl::Status StructuredLoggingClient::Flush(absl::Time deadline) const {
+  if (impl_->batcher == nullptr) {
+    return absl::OkStatus();
+  }
+  return impl_->batcher->Flush(deadline);
+}
+
 // Returns a list of `event_source` that can be requested using GetLogItems.
 absl::StatusOr<std::vector<std::string>>
 StructuredLoggingClient::ListLogSources() const {
@@ -186,6 +449,29 @@ StructuredLoggingClient::GetLogItems(absl::string_view event_source,
                    .next_page_token = std::move(response.cursor())};
 }
 
+absl::StatusOr<StructuredLoggingClient::LogItemReader>
+StructuredLoggingClient::ReadLogItems(absl::string_view event_source) const {
+  return ReadLogItems(event_source, ReadOptions());
+}
+
+absl::StatusOr<StructuredLoggingClient::LogItemReader>
+StructuredLoggingClient::ReadLogItems(absl::string_view event_source,
+                                      const ReadOptions& options) const {
+  if (options.page_size <= 0) {
+    return absl::InvalidArgumentError("page_size must be positive.");
+  }
+  intrinsic_proto::data_logger::GetLogItemsRequest request;
+  request.add_event_sources(std::string{event_source});
+  *request.mutable_start_time() =
+      FromAbslTimeClampToValidRange(options.start_time);
+  *request.mutable_end_time() = FromAbslTimeClampToValidRange(options.end_time);
+  request.set_max_num_items(options.page_size);
+  auto impl = std::make_unique<LogItemReader::LogItemReaderImpl>(
+      impl_->stub.get(), options, std::move(request));
+  impl->pending = impl->Fetch("");
+  return LogItemReader(std::move(impl));
+}
+
 // Returns the most recent LogItem that has been logged for the given event
 // source, from an in-memory cache. If no LogItem with a matching event_source
 // has been logged since --file_ttl, then NOT_FOUND will be returned instead.
@@ -15,7 +15,9 @@
 #include "absl/strings/string_view.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
+#include "google/protobuf/arena.h"
 #include "grpcpp/channel.h"
+#include "intrinsic/logging/log_item_batcher.h"
 #include "intrinsic/logging/proto/log_item.pb.h"
 #include "intrinsic/logging/proto/logger_service.grpc.pb.h"
 #include "intrinsic/logging/proto/logger_service.pb.h"
@@ -31,6 +33,10 @@ class StructuredLoggingClient {
   using LogOptions = ::intrinsic_proto::data_logger::LogOptions;
   using LoggerStub = ::intrinsic_proto::data_logger::DataLogger::StubInterface;
 
+  // Configures client-side buffering of LogAsync() calls, see
+  // LogItemBatcher::Options.
+  using BufferingOptions = LogItemBatcher::Options;
+
   struct ListResult {
     std::vector<LogItem> log_items;
     std::string next_page_token;
@@ -38,6 +44,46 @@ class StructuredLoggingClient {
 
   using GetResult = ListResult;
 
+  struct ReadOptions {
+    // Number of items requested per GetLogItems call.
+    int page_size = 1000;
+    absl::Time start_time = absl::UniversalEpoch();
+    absl::Time end_time = absl::InfiniteFuture();
+    // If true, the next page is requested while the items of the current one
+    // are read.
+    bool prefetch = true;
+    // If set, pages are decoded into this arena, which must outlive the
+    // reader. The items then stay valid until the arena is destroyed.
+    // Otherwise each page is freed once the reader moves past it.
+    google::protobuf::Arena* arena = nullptr;
+  };
+
+  // Iterates over the log items of one event source page by page, see
+  // ReadLogItems(). Must not outlive the client that created it. Not
+  // thread-safe.
+  class LogItemReader {
+   public:
+    ~LogItemReader();
+
+    LogItemReader(const LogItemReader&) = delete;
+    LogItemReader& operator=(const LogItemReader&) = delete;
+
+    LogItemReader(LogItemReader&&);
+    LogItemReader& operator=(LogItemReader&&);
+
+    // Returns the next item, or nullptr after the last one. Unless
+    // ReadOptions::arena is set, the item is only valid until the next call.
+    absl::StatusOr<const LogItem*> Next();
+
+   private:
+    friend class StructuredLoggingClient;
+    struct LogItemReaderImpl;
+
+    explicit LogItemReader(std::unique_ptr<LogItemReaderImpl> impl);
+
+    std::unique_ptr<LogItemReaderImpl> impl_;
+  };
+
   // Creates a structured logging client by connecting to the specified address.
   // If the connection cannot be established when the deadline is met, the
   // function returns an error.
@@ -51,6 +97,18 @@ class StructuredLoggingClient {
   // Direct stub injection, typically used to inject mocks for testing.
   explicit StructuredLoggingClient(std::unique_ptr<LoggerStub> stub);
 
+  // Constructs a client which buffers the items passed to LogAsync() per event
+  // source and sends them in batches with the LogBatch RPC, with up to
+  // `buffering_options.max_batches_in_flight` requests outstanding. Falls back
+  // to one Log RPC per item if the service does not implement LogBatch.
+  //
+  // Buffered items are sent when the client is destroyed. Log() is not
+  // buffered and may overtake items previously passed to LogAsync().
+  StructuredLoggingClient(const std::shared_ptr<grpc::Channel>& channel,
+                          const BufferingOptions& buffering_options);
+  StructuredLoggingClient(std::unique_ptr<LoggerStub> stub,
+                          const BufferingOptions& buffering_options);
+
   StructuredLoggingClient(const StructuredLoggingClient&) = delete;
   StructuredLoggingClient& operator=(const StructuredLoggingClient&) = delete;
 
@@ -86,6 +144,12 @@ class StructuredLoggingClient {
   void LogAsync(const LogItem& item,
                 std::function<void(absl::Status)> callback) const;
 
+  // Sends the items buffered by LogAsync() and waits until the service
+  // acknowledged them, or until `deadline`. Returns the first error of any
+  // batch since the previous Flush(). Returns OK right away if the client does
+  // not buffer.
+  absl::Status Flush(absl::Time deadline) const;
+
   // Returns a list of `event_source` that can be requested using list requests.
   absl::StatusOr<std::vector<std::string>> ListLogSources() const;
 
@@ -115,6 +179,15 @@ class StructuredLoggingClient {
       absl::Time start_time = absl::UniversalEpoch(),
       absl::Time end_time = absl::Now()) const;
 
+  // Returns a reader which streams the log items for the specified event
+  // source, instead of returning them all at once. It requests
+  // `options.page_size` items at a time, so that memory stays bounded by about
+  // two pages. The first page is requested right away.
+  absl::StatusOr<LogItemReader> ReadLogItems(
+      absl::string_view event_source) const;
+  absl::StatusOr<LogItemReader> ReadLogItems(absl::string_view event_source,
+                                             const ReadOptions& options) const;
+
   // Returns the most recent LogItem that has been logged for the given event
   // source. If no LogItem with a matching event_source has been logged since
   // --file_ttl, then NOT_FOUND will be returned instead.
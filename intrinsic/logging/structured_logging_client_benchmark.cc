@@ -0,0 +1,145 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+// Compares the throughput of StructuredLoggingClient::LogAsync with one Log
+// RPC per item against the buffering client, which sends batches with the
+// LogBatch RPC. Both talk to a fake DataLogger service over an in-process
+// channel. Payloads are 100B, 1KiB and 64KiB.
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "absl/log/check.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "benchmark/benchmark.h"
+#include "google/protobuf/empty.pb.h"
+#include "google/protobuf/wrappers.pb.h"
+#include "grpcpp/channel.h"
+#include "grpcpp/server.h"
+#include "grpcpp/server_builder.h"
+#include "grpcpp/server_context.h"
+#include "grpcpp/support/channel_arguments.h"
+#include "grpcpp/support/status.h"
+#include "intrinsic/logging/proto/log_item.pb.h"
+#include "intrinsic/logging/proto/logger_service.grpc.pb.h"
+#include "intrinsic/logging/proto/logger_service.pb.h"
+#include "intrinsic/logging/structured_logging_client.h"
+
+namespace intrinsic {
+namespace {
+
+using ::intrinsic_proto::data_logger::LogItem;
+
+// Accepts and discards all items.
+class FakeDataLogger
+    : public intrinsic_proto::data_logger::DataLogger::Service {
+ public:
+  grpc::Status Log(grpc::ServerContext* context,
+                   const intrinsic_proto::data_logger::LogRequest* request,
+                   google::protobuf::Empty* response) override {
+    return grpc::Status::OK;
+  }
+
+  grpc::Status LogBatch(
+      grpc::ServerContext* context,
+      const intrinsic_proto::data_logger::LogBatchRequest* request,
+      google::protobuf::Empty* response) override {
+    return grpc::Status::OK;
+  }
+};
+
+class FakeDataLoggerServer {
+ public:
+  FakeDataLoggerServer() {
+    grpc::ServerBuilder builder;
+    builder.RegisterService(&service_);
+    server_ = builder.BuildAndStart();
+    CHECK(server_ != nullptr);
+  }
+  ~FakeDataLoggerServer() { server_->Shutdown(); }
+
+  std::shared_ptr<grpc::Channel> Channel() {
+    return server_->InProcessChannel(grpc::ChannelArguments());
+  }
+
+ private:
+  FakeDataLogger service_;
+  std::unique_ptr<grpc::Server> server_;
+};
+
+LogItem MakeItem(int64_t payload_size) {
+  LogItem item;
+  item.mutable_metadata()->set_event_source("benchmark");
+  google::protobuf::BytesValue payload;
+  payload.set_value(std::string(payload_size, 'x'));
+  item.mutable_payload()->mutable_any()->PackFrom(payload);
+  return item;
+}
+
+// Counts the acknowledged items, so that the benchmark includes the time until
+// the service received all of them.
+class Acknowledgements {
+ public:
+  void Add() {
+    absl::MutexLock lock(&mutex_);
+    ++count_;
+  }
+
+  void WaitFor(int64_t count) {
+    absl::MutexLock lock(&mutex_);
+    auto done = [this, count]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+      return count_ >= count;
+    };
+    CHECK(mutex_.AwaitWithTimeout(absl::Condition(&done), absl::Minutes(1)));
+  }
+
+ private:
+  absl::Mutex mutex_;
+  int64_t count_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
+void RunLogAsync(benchmark::State& state, StructuredLoggingClient& client) {
+  const LogItem item = MakeItem(state.range(0));
+  Acknowledgements acknowledgements;
+  int64_t items = 0;
+  for (auto _ : state) {
+    client.LogAsync(item, [&acknowledgements](absl::Status status) {
+      CHECK_OK(status);
+      acknowledgements.Add();
+    });
+    ++items;
+  }
+  CHECK_OK(client.Flush(absl::Now() + absl::Minutes(1)));
+  acknowledgements.WaitFor(items);
+  state.SetItemsProcessed(items);
+  state.SetBytesProcessed(items * item.ByteSizeLong());
+}
+
+void BM_LogAsyncUnbuffered(benchmark::State& state) {
+  FakeDataLoggerServer server;
+  StructuredLoggingClient client(server.Channel());
+  RunLogAsync(state, client);
+}
+
+void BM_LogAsyncBuffered(benchmark::State& state) {
+  FakeDataLoggerServer server;
+  StructuredLoggingClient client(server.Channel(),
+                                 StructuredLoggingClient::BufferingOptions{});
+  RunLogAsync(state, client);
+}
+
+BENCHMARK(BM_LogAsyncUnbuffered)
+    ->Arg(100)
+    ->Arg(1 << 10)
+    ->Arg(64 << 10)
+    ->UseRealTime();
+BENCHMARK(BM_LogAsyncBuffered)
+    ->Arg(100)
+    ->Arg(1 << 10)
+    ->Arg(64 << 10)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace intrinsic
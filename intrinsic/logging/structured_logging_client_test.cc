@@ -0,0 +1,264 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/logging/structured_logging_client.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "google/protobuf/arena.h"
+#include "google/protobuf/empty.pb.h"
+#include "grpcpp/server.h"
+#include "grpcpp/server_builder.h"
+#include "grpcpp/server_context.h"
+#include "grpcpp/support/channel_arguments.h"
+#include "grpcpp/support/status.h"
+#include "intrinsic/logging/proto/log_item.pb.h"
+#include "intrinsic/logging/proto/logger_service.grpc.pb.h"
+#include "intrinsic/logging/proto/logger_service.pb.h"
+#include "intrinsic/util/status/status_macros.h"
+#include "intrinsic/util/testing/gtest_wrapper.h"
+
+namespace intrinsic {
+namespace {
+
+using ::intrinsic::testing::IsOkAndHolds;
+using ::intrinsic::testing::StatusIs;
+using ::intrinsic_proto::data_logger::GetLogItemsRequest;
+using ::intrinsic_proto::data_logger::GetLogItemsResponse;
+using ::intrinsic_proto::data_logger::LogBatchRequest;
+using ::intrinsic_proto::data_logger::LogItem;
+using ::intrinsic_proto::data_logger::LogRequest;
+using ::testing::ElementsAreArray;
+using ::testing::UnorderedElementsAreArray;
+
+constexpr char kEventSource[] = "test_source";
+
+// Serves `num_items` items for kEventSource. The cursor is the index of the
+// next item. Like the real service, returns at most `max_items_per_response`
+// items, standing in for its byte limit, and marks responses which reached
+// either limit as truncated. Like an older service, doesn't implement
+// LogBatch, and records the uids of the items passed to Log.
+class FakeDataLogger
+    : public intrinsic_proto::data_logger::DataLogger::Service {
+ public:
+  explicit FakeDataLogger(
+      int num_items,
+      int max_items_per_response = std::numeric_limits<int>::max())
+      : num_items_(num_items),
+        max_items_per_response_(max_items_per_response) {}
+
+  grpc::Status GetLogItems(grpc::ServerContext* context,
+                           const GetLogItemsRequest* request,
+                           GetLogItemsResponse* response) override {
+    ++num_calls_;
+    if (request->event_sources_size() != 1 ||
+        request->event_sources(0) != kEventSource) {
+      return grpc::Status(grpc::StatusCode::NOT_FOUND, "Unknown source");
+    }
+    int begin = 0;
+    if (request->has_cursor() && !absl::SimpleAtoi(request->cursor(), &begin)) {
+      return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "Bad cursor");
+    }
+    const int limit =
+        std::min(request->max_num_items(), max_items_per_response_);
+    const int end = std::min(num_items_, begin + limit);
+    for (int i = begin; i < end; ++i) {
+      LogItem* item = response->add_log_items();
+      item->mutable_metadata()->set_event_source(kEventSource);
+      item->mutable_metadata()->set_uid(i);
+    }
+    response->set_cursor(absl::StrCat(end));
+    response->set_truncated(end == begin + limit);
+    return grpc::Status::OK;
+  }
+
+  grpc::Status Log(grpc::ServerContext* context, const LogRequest* request,
+                   google::protobuf::Empty* response) override {
+    absl::MutexLock lock(&mutex_);
+    logged_uids_.push_back(request->item().metadata().uid());
+    return grpc::Status::OK;
+  }
+
+  grpc::Status LogBatch(grpc::ServerContext* context,
+                        const LogBatchRequest* request,
+                        google::protobuf::Empty* response) override {
+    ++num_log_batch_calls_;
+    return grpc::Status(grpc::StatusCode::UNIMPLEMENTED, "Not implemented");
+  }
+
+  int num_calls() const { return num_calls_; }
+  int num_log_batch_calls() const { return num_log_batch_calls_; }
+
+  std::vector<uint64_t> logged_uids() const {
+    absl::MutexLock lock(&mutex_);
+    return logged_uids_;
+  }
+
+ private:
+  const int num_items_;
+  const int max_items_per_response_;
+  std::atomic<int> num_calls_ = 0;
+  std::atomic<int> num_log_batch_calls_ = 0;
+  mutable absl::Mutex mutex_;
+  std::vector<uint64_t> logged_uids_ ABSL_GUARDED_BY(mutex_);
+};
+
+class StructuredLoggingClientTest : public ::testing::Test {
+ protected:
+  void StartServer(
+      int num_items,
+      int max_items_per_response = std::numeric_limits<int>::max()) {
+    service_ =
+        std::make_unique<FakeDataLogger>(num_items, max_items_per_response);
+    grpc::ServerBuilder builder;
+    builder.RegisterService(service_.get());
+    server_ = builder.BuildAndStart();
+    client_ = std::make_unique<StructuredLoggingClient>(
+        server_->InProcessChannel(grpc::ChannelArguments()));
+  }
+
+  void TearDown() override {
+    client_.reset();
+    if (server_ != nullptr) {
+      server_->Shutdown();
+    }
+  }
+
+  // Returns the uids of all items of `reader`.
+  static absl::StatusOr<std::vector<uint64_t>> ReadAll(
+      StructuredLoggingClient::LogItemReader& reader) {
+    std::vector<uint64_t> uids;
+    while (true) {
+      INTR_ASSIGN_OR_RETURN(const LogItem* item, reader.Next());
+      if (item == nullptr) {
+        return uids;
+      }
+      uids.push_back(item->metadata().uid());
+    }
+  }
+
+  static std::vector<uint64_t> Range(int begin, int end) {
+    std::vector<uint64_t> uids;
+    for (int i = begin; i < end; ++i) {
+      uids.push_back(i);
+    }
+    return uids;
+  }
+  static std::vector<uint64_t> Range(int n) { return Range(0, n); }
+
+  static LogItem MakeItem(uint64_t uid) {
+    LogItem item;
+    item.mutable_metadata()->set_event_source(kEventSource);
+    item.mutable_metadata()->set_uid(uid);
+    return item;
+  }
+
+  std::unique_ptr<FakeDataLogger> service_;
+  std::unique_ptr<grpc::Server> server_;
+  std::unique_ptr<StructuredLoggingClient> client_;
+};
+
+TEST_F(StructuredLoggingClientTest, ReadsItemsAcrossPages) {
+  StartServer(10);
+  ASSERT_OK_AND_ASSIGN(
+      StructuredLoggingClient::LogItemReader reader,
+      client_->ReadLogItems(kEventSource, {.page_size = 3}));
+  EXPECT_THAT(ReadAll(reader), IsOkAndHolds(ElementsAreArray(Range(10))));
+  EXPECT_EQ(service_->num_calls(), 4);
+}
+
+TEST_F(StructuredLoggingClientTest, StopsAfterEmptyPage) {
+  StartServer(6);
+  ASSERT_OK_AND_ASSIGN(StructuredLoggingClient::LogItemReader reader,
+                       client_->ReadLogItems(
+                           kEventSource, {.page_size = 3, .prefetch = false}));
+  EXPECT_THAT(ReadAll(reader), IsOkAndHolds(ElementsAreArray(Range(6))));
+  EXPECT_EQ(service_->num_calls(), 3);
+}
+
+TEST_F(StructuredLoggingClientTest, ContinuesAfterShortTruncatedPage) {
+  // The service returns pages of 2 instead of 5 items, as if it hit its byte
+  // limit.
+  StartServer(7, /*max_items_per_response=*/2);
+  ASSERT_OK_AND_ASSIGN(
+      StructuredLoggingClient::LogItemReader reader,
+      client_->ReadLogItems(kEventSource, {.page_size = 5}));
+  EXPECT_THAT(ReadAll(reader), IsOkAndHolds(ElementsAreArray(Range(7))));
+  EXPECT_EQ(service_->num_calls(), 4);
+}
+
+TEST_F(StructuredLoggingClientTest, DecodesIntoArena) {
+  StartServer(5);
+  google::protobuf::Arena arena;
+  std::vector<const LogItem*> items;
+  {
+    ASSERT_OK_AND_ASSIGN(
+        StructuredLoggingClient::LogItemReader reader,
+        client_->ReadLogItems(kEventSource,
+                              {.page_size = 2, .arena = &arena}));
+    while (true) {
+      ASSERT_OK_AND_ASSIGN(const LogItem* item, reader.Next());
+      if (item == nullptr) break;
+      EXPECT_EQ(item->GetArena(), &arena);
+      items.push_back(item);
+    }
+  }
+  // The items outlive the reader.
+  ASSERT_EQ(items.size(), 5);
+  EXPECT_EQ(items[0]->metadata().uid(), 0);
+  EXPECT_EQ(items[4]->metadata().uid(), 4);
+}
+
+TEST_F(StructuredLoggingClientTest, ReturnsErrors) {
+  StartServer(5);
+  ASSERT_OK_AND_ASSIGN(StructuredLoggingClient::LogItemReader reader,
+                       client_->ReadLogItems("unknown_source"));
+  EXPECT_THAT(reader.Next(), StatusIs(absl::StatusCode::kNotFound));
+  EXPECT_THAT(reader.Next(), IsOkAndHolds(nullptr));
+}
+
+TEST_F(StructuredLoggingClientTest, FallsBackToLogIfLogBatchIsUnimplemented) {
+  StartServer(0);
+  StructuredLoggingClient client(
+      server_->InProcessChannel(grpc::ChannelArguments()),
+      {.max_batch_items = 2, .max_batches_in_flight = 1});
+
+  client.LogAsync(MakeItem(0));
+  client.LogAsync(MakeItem(1));
+  EXPECT_OK(client.Flush(absl::Now() + absl::Seconds(10)));
+  EXPECT_EQ(service_->num_log_batch_calls(), 1);
+  EXPECT_THAT(service_->logged_uids(), UnorderedElementsAreArray(Range(2)));
+
+  // Later batches skip LogBatch.
+  for (int i = 2; i < 6; ++i) {
+    client.LogAsync(MakeItem(i));
+  }
+  EXPECT_OK(client.Flush(absl::Now() + absl::Seconds(10)));
+  EXPECT_EQ(service_->num_log_batch_calls(), 1);
+  EXPECT_THAT(service_->logged_uids(), UnorderedElementsAreArray(Range(6)));
+}
+
+TEST_F(StructuredLoggingClientTest, RejectsInvalidPageSize) {
+  StartServer(5);
+  EXPECT_THAT(client_->ReadLogItems(kEventSource, {.page_size = 0}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace intrinsic
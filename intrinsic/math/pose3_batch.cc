@@ -0,0 +1,267 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/math/pose3_batch.h"
+
+#include <cmath>
+#include <cstddef>
+
+#include "Eigen/Core"
+#include "intrinsic/eigenmath/types.h"
+#include "intrinsic/math/pose3.h"
+#include "intrinsic/math/twist.h"
+
+// Compiles a kernel once per instruction set and dispatches at load time.
+#if defined(__x86_64__) && defined(__has_attribute)
+#if __has_attribute(target_clones)
+#define INTRINSIC_POSE3_BATCH_KERNEL \
+  __attribute__((target_clones("arch=skylake-avx512", "arch=haswell", \
+                               "default")))
+#endif
+#endif
+#ifndef INTRINSIC_POSE3_BATCH_KERNEL
+#define INTRINSIC_POSE3_BATCH_KERNEL
+#endif
+
+namespace intrinsic {
+namespace {
+
+// The kernels below read all inputs of element i before writing its outputs,
+// so outputs may alias inputs of the same element. `#pragma omp simd` (enabled
+// by -fopenmp-simd, without an OpenMP runtime) states that iterations are
+// otherwise independent, which spares the compiler runtime alias checks and
+// makes it vectorize regardless of its cost model. -fno-math-errno lets it
+// vectorize std::sqrt.
+
+INTRINSIC_POSE3_BATCH_KERNEL
+void TransformPointsKernel(const double* rotation, const double* translation,
+                           size_t size, const double* x, const double* y,
+                           const double* z, double* out_x, double* out_y,
+                           double* out_z) {
+  // Row-major rotation matrix.
+  const double r00 = rotation[0], r01 = rotation[1], r02 = rotation[2];
+  const double r10 = rotation[3], r11 = rotation[4], r12 = rotation[5];
+  const double r20 = rotation[6], r21 = rotation[7], r22 = rotation[8];
+  const double t0 = translation[0], t1 = translation[1], t2 = translation[2];
+#pragma omp simd
+  for (size_t i = 0; i < size; ++i) {
+    const double px = x[i], py = y[i], pz = z[i];
+    out_x[i] = r00 * px + r01 * py + r02 * pz + t0;
+    out_y[i] = r10 * px + r11 * py + r12 * pz + t1;
+    out_z[i] = r20 * px + r21 * py + r22 * pz + t2;
+  }
+}
+
+// Computes (tx, ty, tz, q) * (b_t, b_q) for each element.
+INTRINSIC_POSE3_BATCH_KERNEL
+void ComposePosesKernel(const double* b_t, const double* b_q, size_t size,
+                        const double* tx, const double* ty, const double* tz,
+                        const double* qx, const double* qy, const double* qz,
+                        const double* qw, double* out_tx, double* out_ty,
+                        double* out_tz, double* out_qx, double* out_qy,
+                        double* out_qz, double* out_qw) {
+  const double vx = b_t[0], vy = b_t[1], vz = b_t[2];
+  const double bx = b_q[0], by = b_q[1], bz = b_q[2], bw = b_q[3];
+#pragma omp simd
+  for (size_t i = 0; i < size; ++i) {
+    const double x = qx[i], y = qy[i], z = qz[i], w = qw[i];
+    // Rotates b_t by q as v + w * t + u x t with t = 2 * (u x v), where u is
+    // the vector part of q.
+    const double cx = 2.0 * (y * vz - z * vy);
+    const double cy = 2.0 * (z * vx - x * vz);
+    const double cz = 2.0 * (x * vy - y * vx);
+    out_tx[i] = tx[i] + vx + w * cx + (y * cz - z * cy);
+    out_ty[i] = ty[i] + vy + w * cy + (z * cx - x * cz);
+    out_tz[i] = tz[i] + vz + w * cz + (x * cy - y * cx);
+    const double rx = w * bx + x * bw + y * bz - z * by;
+    const double ry = w * by - x * bz + y * bw + z * bx;
+    const double rz = w * bz + x * by - y * bx + z * bw;
+    const double rw = w * bw - x * bx - y * by - z * bz;
+    // Removes the rounding drift of the product like SO3::operator*=().
+    const double nsq = rx * rx + ry * ry + rz * rz + rw * rw;
+    const double scale = (3.0 + nsq) / (1.0 + 3.0 * nsq);
+    out_qx[i] = rx * scale;
+    out_qy[i] = ry * scale;
+    out_qz[i] = rz * scale;
+    out_qw[i] = rw * scale;
+  }
+}
+
+INTRINSIC_POSE3_BATCH_KERNEL
+void InvertPosesKernel(size_t size, const double* tx, const double* ty,
+                       const double* tz, const double* qx, const double* qy,
+                       const double* qz, const double* qw, double* out_tx,
+                       double* out_ty, double* out_tz, double* out_qx,
+                       double* out_qy, double* out_qz, double* out_qw) {
+#pragma omp simd
+  for (size_t i = 0; i < size; ++i) {
+    // The inverse rotation is the conjugate, -u, and the inverse translation
+    // is -(conj(q) * t), i.e., t rotated by -u and negated.
+    const double x = qx[i], y = qy[i], z = qz[i], w = qw[i];
+    const double vx = tx[i], vy = ty[i], vz = tz[i];
+    const double cx = 2.0 * (z * vy - y * vz);
+    const double cy = 2.0 * (x * vz - z * vx);
+    const double cz = 2.0 * (y * vx - x * vy);
+    out_tx[i] = -(vx + w * cx + (z * cy - y * cz));
+    out_ty[i] = -(vy + w * cy + (x * cz - z * cx));
+    out_tz[i] = -(vz + w * cz + (y * cx - x * cy));
+    out_qx[i] = -x;
+    out_qy[i] = -y;
+    out_qz[i] = -z;
+    out_qw[i] = w;
+  }
+}
+
+INTRINSIC_POSE3_BATCH_KERNEL
+void NormalizeQuaternionsKernel(size_t size, double* qx, double* qy,
+                                double* qz, double* qw) {
+#pragma omp simd
+  for (size_t i = 0; i < size; ++i) {
+    const double x = qx[i], y = qy[i], z = qz[i], w = qw[i];
+    const double scale = 1.0 / std::sqrt(x * x + y * y + z * z + w * w);
+    qx[i] = x * scale;
+    qy[i] = y * scale;
+    qz[i] = z * scale;
+    qw[i] = w * scale;
+  }
+}
+
+INTRINSIC_POSE3_BATCH_KERNEL
+void TransformWrenchesKernel(const double* rotation, const double* translation,
+                             size_t size, const double* fx, const double* fy,
+                             const double* fz, const double* tx,
+                             const double* ty, const double* tz,
+                             double* out_fx, double* out_fy, double* out_fz,
+                             double* out_tx, double* out_ty, double* out_tz) {
+  // Row-major rotation matrix.
+  const double r00 = rotation[0], r01 = rotation[1], r02 = rotation[2];
+  const double r10 = rotation[3], r11 = rotation[4], r12 = rotation[5];
+  const double r20 = rotation[6], r21 = rotation[7], r22 = rotation[8];
+  const double p0 = translation[0], p1 = translation[1], p2 = translation[2];
+#pragma omp simd
+  for (size_t i = 0; i < size; ++i) {
+    const double f0 = fx[i], f1 = fy[i], f2 = fz[i];
+    const double m0 = tx[i], m1 = ty[i], m2 = tz[i];
+    const double a_f0 = r00 * f0 + r01 * f1 + r02 * f2;
+    const double a_f1 = r10 * f0 + r11 * f1 + r12 * f2;
+    const double a_f2 = r20 * f0 + r21 * f1 + r22 * f2;
+    out_fx[i] = a_f0;
+    out_fy[i] = a_f1;
+    out_fz[i] = a_f2;
+    out_tx[i] = r00 * m0 + r01 * m1 + r02 * m2 + (p1 * a_f2 - p2 * a_f1);
+    out_ty[i] = r10 * m0 + r11 * m1 + r12 * m2 + (p2 * a_f0 - p0 * a_f2);
+    out_tz[i] = r20 * m0 + r21 * m1 + r22 * m2 + (p0 * a_f1 - p1 * a_f0);
+  }
+}
+
+}  // namespace
+
+void Points3dBatch::resize(size_t size) {
+  x_.resize(size);
+  y_.resize(size);
+  z_.resize(size);
+}
+
+void Points3dBatch::Set(size_t i, const eigenmath::Vector3d& point) {
+  x_[i] = point.x();
+  y_[i] = point.y();
+  z_[i] = point.z();
+}
+
+void Poses3dBatch::resize(size_t size) {
+  tx_.resize(size);
+  ty_.resize(size);
+  tz_.resize(size);
+  qx_.resize(size);
+  qy_.resize(size);
+  qz_.resize(size);
+  qw_.resize(size, 1.0);
+}
+
+Pose3d Poses3dBatch::Get(size_t i) const {
+  return Pose3d(eigenmath::Quaterniond(qw_[i], qx_[i], qy_[i], qz_[i]),
+                eigenmath::Vector3d(tx_[i], ty_[i], tz_[i]),
+                eigenmath::kDoNotNormalize);
+}
+
+void Poses3dBatch::Set(size_t i, const Pose3d& pose) {
+  tx_[i] = pose.translation().x();
+  ty_[i] = pose.translation().y();
+  tz_[i] = pose.translation().z();
+  qx_[i] = pose.quaternion().x();
+  qy_[i] = pose.quaternion().y();
+  qz_[i] = pose.quaternion().z();
+  qw_[i] = pose.quaternion().w();
+}
+
+void WrenchBatch::resize(size_t size) {
+  fx_.resize(size);
+  fy_.resize(size);
+  fz_.resize(size);
+  tx_.resize(size);
+  ty_.resize(size);
+  tz_.resize(size);
+}
+
+void WrenchBatch::Set(size_t i, const Wrench& wrench) {
+  fx_[i] = wrench[0];
+  fy_[i] = wrench[1];
+  fz_[i] = wrench[2];
+  tx_[i] = wrench[3];
+  ty_[i] = wrench[4];
+  tz_[i] = wrench[5];
+}
+
+void TransformPoints(const Pose3d& a_t_b, const Points3dBatch& b_points,
+                     Points3dBatch& a_points) {
+  a_points.resize(b_points.size());
+  const Eigen::Matrix<double, 3, 3, Eigen::RowMajor> rotation =
+      a_t_b.quaternion().toRotationMatrix();
+  TransformPointsKernel(rotation.data(), a_t_b.translation().data(),
+                        b_points.size(), b_points.x().data(),
+                        b_points.y().data(), b_points.z().data(),
+                        a_points.x().data(), a_points.y().data(),
+                        a_points.z().data());
+}
+
+void ComposePoses(const Poses3dBatch& a_t_b, const Pose3d& b_t_c,
+                  Poses3dBatch& a_t_c) {
+  a_t_c.resize(a_t_b.size());
+  // Quaternion coefficients are stored as (x, y, z, w).
+  ComposePosesKernel(b_t_c.translation().data(),
+                     b_t_c.quaternion().coeffs().data(), a_t_b.size(),
+                     a_t_b.tx().data(), a_t_b.ty().data(), a_t_b.tz().data(),
+                     a_t_b.qx().data(), a_t_b.qy().data(), a_t_b.qz().data(),
+                     a_t_b.qw().data(), a_t_c.tx().data(), a_t_c.ty().data(),
+                     a_t_c.tz().data(), a_t_c.qx().data(), a_t_c.qy().data(),
+                     a_t_c.qz().data(), a_t_c.qw().data());
+}
+
+void InvertPoses(const Poses3dBatch& a_t_b, Poses3dBatch& b_t_a) {
+  b_t_a.resize(a_t_b.size());
+  InvertPosesKernel(a_t_b.size(), a_t_b.tx().data(), a_t_b.ty().data(),
+                    a_t_b.tz().data(), a_t_b.qx().data(), a_t_b.qy().data(),
+                    a_t_b.qz().data(), a_t_b.qw().data(), b_t_a.tx().data(),
+                    b_t_a.ty().data(), b_t_a.tz().data(), b_t_a.qx().data(),
+                    b_t_a.qy().data(), b_t_a.qz().data(), b_t_a.qw().data());
+}
+
+void NormalizeQuaternions(Poses3dBatch& poses) {
+  NormalizeQuaternionsKernel(poses.size(), poses.qx().data(),
+                             poses.qy().data(), poses.qz().data(),
+                             poses.qw().data());
+}
+
+void TransformWrenches(const Pose3d& a_t_b, const WrenchBatch& b_wrenches,
+                       WrenchBatch& a_wrenches) {
+  a_wrenches.resize(b_wrenches.size());
+  const Eigen::Matrix<double, 3, 3, Eigen::RowMajor> rotation =
+      a_t_b.quaternion().toRotationMatrix();
+  TransformWrenchesKernel(
+      rotation.data(), a_t_b.translation().data(), b_wrenches.size(),
+      b_wrenches.fx().data(), b_wrenches.fy().data(), b_wrenches.fz().data(),
+      b_wrenches.tx().data(), b_wrenches.ty().data(), b_wrenches.tz().data(),
+      a_wrenches.fx().data(), a_wrenches.fy().data(), a_wrenches.fz().data(),
+      a_wrenches.tx().data(), a_wrenches.ty().data(), a_wrenches.tz().data());
+}
+
+}  // namespace intrinsic
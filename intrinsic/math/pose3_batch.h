@@ -0,0 +1,149 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#ifndef INTRINSIC_MATH_POSE3_BATCH_H_
+#define INTRINSIC_MATH_POSE3_BATCH_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "absl/types/span.h"
+#include "intrinsic/eigenmath/types.h"
+#include "intrinsic/math/pose3.h"
+#include "intrinsic/math/twist.h"
+
+namespace intrinsic {
+
+// Batches of points, poses and wrenches stored as a structure of arrays, i.e.,
+// one contiguous array per coordinate. The batch functions below loop over
+// these arrays element by element, which lets the compiler process several
+// elements per instruction.
+//
+// The batch functions are compiled for several x86-64 instruction sets (AVX2
+// with FMA, AVX-512 and the baseline) and pick the best one the CPU supports
+// at load time. On other platforms, they are compiled once.
+
+// A batch of 3D points.
+class Points3dBatch {
+ public:
+  explicit Points3dBatch(size_t size = 0) { resize(size); }
+
+  size_t size() const { return x_.size(); }
+  void resize(size_t size);
+
+  eigenmath::Vector3d Get(size_t i) const {
+    return eigenmath::Vector3d(x_[i], y_[i], z_[i]);
+  }
+  void Set(size_t i, const eigenmath::Vector3d& point);
+
+  absl::Span<const double> x() const { return x_; }
+  absl::Span<const double> y() const { return y_; }
+  absl::Span<const double> z() const { return z_; }
+  absl::Span<double> x() { return absl::MakeSpan(x_); }
+  absl::Span<double> y() { return absl::MakeSpan(y_); }
+  absl::Span<double> z() { return absl::MakeSpan(z_); }
+
+ private:
+  std::vector<double> x_;
+  std::vector<double> y_;
+  std::vector<double> z_;
+};
+
+// A batch of poses, each stored as its translation and its rotation
+// quaternion. Like Pose3d, the batch functions assume unit quaternions unless
+// stated otherwise.
+class Poses3dBatch {
+ public:
+  explicit Poses3dBatch(size_t size = 0) { resize(size); }
+
+  size_t size() const { return tx_.size(); }
+  // New elements are identity poses.
+  void resize(size_t size);
+
+  Pose3d Get(size_t i) const;
+  void Set(size_t i, const Pose3d& pose);
+
+  absl::Span<const double> tx() const { return tx_; }
+  absl::Span<const double> ty() const { return ty_; }
+  absl::Span<const double> tz() const { return tz_; }
+  absl::Span<const double> qx() const { return qx_; }
+  absl::Span<const double> qy() const { return qy_; }
+  absl::Span<const double> qz() const { return qz_; }
+  absl::Span<const double> qw() const { return qw_; }
+  absl::Span<double> tx() { return absl::MakeSpan(tx_); }
+  absl::Span<double> ty() { return absl::MakeSpan(ty_); }
+  absl::Span<double> tz() { return absl::MakeSpan(tz_); }
+  absl::Span<double> qx() { return absl::MakeSpan(qx_); }
+  absl::Span<double> qy() { return absl::MakeSpan(qy_); }
+  absl::Span<double> qz() { return absl::MakeSpan(qz_); }
+  absl::Span<double> qw() { return absl::MakeSpan(qw_); }
+
+ private:
+  std::vector<double> tx_;
+  std::vector<double> ty_;
+  std::vector<double> tz_;
+  std::vector<double> qx_;
+  std::vector<double> qy_;
+  std::vector<double> qz_;
+  std::vector<double> qw_;
+};
+
+// A batch of wrenches (fx, fy, fz, tx, ty, tz).
+class WrenchBatch {
+ public:
+  explicit WrenchBatch(size_t size = 0) { resize(size); }
+
+  size_t size() const { return fx_.size(); }
+  void resize(size_t size);
+
+  Wrench Get(size_t i) const {
+    return Wrench(fx_[i], fy_[i], fz_[i], tx_[i], ty_[i], tz_[i]);
+  }
+  void Set(size_t i, const Wrench& wrench);
+
+  absl::Span<const double> fx() const { return fx_; }
+  absl::Span<const double> fy() const { return fy_; }
+  absl::Span<const double> fz() const { return fz_; }
+  absl::Span<const double> tx() const { return tx_; }
+  absl::Span<const double> ty() const { return ty_; }
+  absl::Span<const double> tz() const { return tz_; }
+  absl::Span<double> fx() { return absl::MakeSpan(fx_); }
+  absl::Span<double> fy() { return absl::MakeSpan(fy_); }
+  absl::Span<double> fz() { return absl::MakeSpan(fz_); }
+  absl::Span<double> tx() { return absl::MakeSpan(tx_); }
+  absl::Span<double> ty() { return absl::MakeSpan(ty_); }
+  absl::Span<double> tz() { return absl::MakeSpan(tz_); }
+
+ private:
+  std::vector<double> fx_;
+  std::vector<double> fy_;
+  std::vector<double> fz_;
+  std::vector<double> tx_;
+  std::vector<double> ty_;
+  std::vector<double> tz_;
+};
+
+// The functions below resize their output to the size of their input. The
+// output may be the input, for in-place updates.
+
+// Computes a_points[i] = a_t_b * b_points[i].
+void TransformPoints(const Pose3d& a_t_b, const Points3dBatch& b_points,
+                     Points3dBatch& a_points);
+
+// Computes a_t_c[i] = a_t_b[i] * b_t_c.
+void ComposePoses(const Poses3dBatch& a_t_b, const Pose3d& b_t_c,
+                  Poses3dBatch& a_t_c);
+
+// Computes b_t_a[i] = a_t_b[i].inverse().
+void InvertPoses(const Poses3dBatch& a_t_b, Poses3dBatch& b_t_a);
+
+// Normalizes the quaternion of each pose, e.g., to remove the drift of
+// repeated compositions. The quaternions must not be zero.
+void NormalizeQuaternions(Poses3dBatch& poses);
+
+// Computes a_wrenches[i] = TransformWrench(a_t_b, b_wrenches[i]).
+void TransformWrenches(const Pose3d& a_t_b, const WrenchBatch& b_wrenches,
+                       WrenchBatch& a_wrenches);
+
+}  // namespace intrinsic
+
+#endif  // INTRINSIC_MATH_POSE3_BATCH_H_
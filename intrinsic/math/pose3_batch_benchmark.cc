@@ -0,0 +1,233 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+// Measures the batch functions of pose3_batch.h against loops of the
+// corresponding per-element Pose3d operations. pose3_batch_test checks that
+// both give the same results.
+//
+// Run with `bazel run -c opt` for meaningful numbers.
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "intrinsic/eigenmath/types.h"
+#include "intrinsic/math/pose3.h"
+#include "intrinsic/math/pose3_batch.h"
+#include "intrinsic/math/transform_utils.h"
+#include "intrinsic/math/twist.h"
+
+namespace intrinsic {
+namespace {
+
+const Pose3d& TestPose() {
+  static const Pose3d* const pose =
+      new Pose3d(eigenmath::Quaterniond(eigenmath::AngleAxisd(
+                     0.7, eigenmath::Vector3d(1, 2, 3).normalized())),
+                 eigenmath::Vector3d(0.1, -0.2, 0.3));
+  return *pose;
+}
+
+eigenmath::Vector3d MakePoint(size_t i) {
+  return eigenmath::Vector3d(std::sin(0.1 * i), std::cos(0.2 * i),
+                             std::sin(0.3 * i + 1.0));
+}
+
+Pose3d MakePose(size_t i) {
+  return Pose3d(eigenmath::Quaterniond(eigenmath::AngleAxisd(
+                    0.01 * i, MakePoint(i + 1).normalized())),
+                MakePoint(i));
+}
+
+Wrench MakeWrench(size_t i) {
+  const eigenmath::Vector3d force = MakePoint(i);
+  const eigenmath::Vector3d torque = MakePoint(i + 7);
+  return Wrench(force.x(), force.y(), force.z(), torque.x(), torque.y(),
+                torque.z());
+}
+
+std::vector<eigenmath::Vector3d> MakePoints(size_t size) {
+  std::vector<eigenmath::Vector3d> points(size);
+  for (size_t i = 0; i < size; ++i) {
+    points[i] = MakePoint(i);
+  }
+  return points;
+}
+
+Points3dBatch MakePointsBatch(size_t size) {
+  Points3dBatch points(size);
+  for (size_t i = 0; i < size; ++i) {
+    points.Set(i, MakePoint(i));
+  }
+  return points;
+}
+
+std::vector<Pose3d> MakePoses(size_t size) {
+  std::vector<Pose3d> poses(size);
+  for (size_t i = 0; i < size; ++i) {
+    poses[i] = MakePose(i);
+  }
+  return poses;
+}
+
+Poses3dBatch MakePosesBatch(size_t size) {
+  Poses3dBatch poses(size);
+  for (size_t i = 0; i < size; ++i) {
+    poses.Set(i, MakePose(i));
+  }
+  return poses;
+}
+
+std::vector<Wrench> MakeWrenches(size_t size) {
+  std::vector<Wrench> wrenches(size);
+  for (size_t i = 0; i < size; ++i) {
+    wrenches[i] = MakeWrench(i);
+  }
+  return wrenches;
+}
+
+WrenchBatch MakeWrenchBatch(size_t size) {
+  WrenchBatch wrenches(size);
+  for (size_t i = 0; i < size; ++i) {
+    wrenches.Set(i, MakeWrench(i));
+  }
+  return wrenches;
+}
+
+// The argument of each benchmark is the number of elements.
+void BM_TransformPointsPerElement(benchmark::State& state) {
+  const Pose3d& pose = TestPose();
+  const std::vector<eigenmath::Vector3d> b_points = MakePoints(state.range(0));
+  std::vector<eigenmath::Vector3d> a_points(b_points.size());
+  for (auto _ : state) {
+    for (size_t i = 0; i < b_points.size(); ++i) {
+      a_points[i] = pose * b_points[i];
+    }
+    benchmark::DoNotOptimize(a_points.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_TransformPointsPerElement)->Arg(1 << 10)->Arg(1 << 16);
+
+void BM_TransformPointsBatch(benchmark::State& state) {
+  const Pose3d& pose = TestPose();
+  const Points3dBatch b_points = MakePointsBatch(state.range(0));
+  Points3dBatch a_points;
+  for (auto _ : state) {
+    TransformPoints(pose, b_points, a_points);
+    benchmark::DoNotOptimize(a_points.x().data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_TransformPointsBatch)->Arg(1 << 10)->Arg(1 << 16);
+
+void BM_ComposePosesPerElement(benchmark::State& state) {
+  const Pose3d& pose = TestPose();
+  const std::vector<Pose3d> a_t_b = MakePoses(state.range(0));
+  std::vector<Pose3d> a_t_c(a_t_b.size());
+  for (auto _ : state) {
+    for (size_t i = 0; i < a_t_b.size(); ++i) {
+      a_t_c[i] = a_t_b[i] * pose;
+    }
+    benchmark::DoNotOptimize(a_t_c.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ComposePosesPerElement)->Arg(1 << 10)->Arg(1 << 16);
+
+void BM_ComposePosesBatch(benchmark::State& state) {
+  const Pose3d& pose = TestPose();
+  const Poses3dBatch a_t_b = MakePosesBatch(state.range(0));
+  Poses3dBatch a_t_c;
+  for (auto _ : state) {
+    ComposePoses(a_t_b, pose, a_t_c);
+    benchmark::DoNotOptimize(a_t_c.tx().data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ComposePosesBatch)->Arg(1 << 10)->Arg(1 << 16);
+
+void BM_InvertPosesPerElement(benchmark::State& state) {
+  const std::vector<Pose3d> a_t_b = MakePoses(state.range(0));
+  std::vector<Pose3d> b_t_a(a_t_b.size());
+  for (auto _ : state) {
+    for (size_t i = 0; i < a_t_b.size(); ++i) {
+      b_t_a[i] = a_t_b[i].inverse();
+    }
+    benchmark::DoNotOptimize(b_t_a.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_InvertPosesPerElement)->Arg(1 << 10)->Arg(1 << 16);
+
+void BM_InvertPosesBatch(benchmark::State& state) {
+  const Poses3dBatch a_t_b = MakePosesBatch(state.range(0));
+  Poses3dBatch b_t_a;
+  for (auto _ : state) {
+    InvertPoses(a_t_b, b_t_a);
+    benchmark::DoNotOptimize(b_t_a.tx().data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_InvertPosesBatch)->Arg(1 << 10)->Arg(1 << 16);
+
+void BM_NormalizeQuaternionsPerElement(benchmark::State& state) {
+  std::vector<Pose3d> poses = MakePoses(state.range(0));
+  for (auto _ : state) {
+    for (Pose3d& pose : poses) {
+      pose = Pose3d(pose.quaternion(), pose.translation());
+    }
+    benchmark::DoNotOptimize(poses.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_NormalizeQuaternionsPerElement)->Arg(1 << 10)->Arg(1 << 16);
+
+void BM_NormalizeQuaternionsBatch(benchmark::State& state) {
+  Poses3dBatch poses = MakePosesBatch(state.range(0));
+  for (auto _ : state) {
+    NormalizeQuaternions(poses);
+    benchmark::DoNotOptimize(poses.qw().data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_NormalizeQuaternionsBatch)->Arg(1 << 10)->Arg(1 << 16);
+
+void BM_TransformWrenchesPerElement(benchmark::State& state) {
+  const Pose3d& pose = TestPose();
+  const std::vector<Wrench> b_wrenches = MakeWrenches(state.range(0));
+  std::vector<Wrench> a_wrenches(b_wrenches.size());
+  for (auto _ : state) {
+    for (size_t i = 0; i < b_wrenches.size(); ++i) {
+      a_wrenches[i] = TransformWrench(pose, b_wrenches[i]);
+    }
+    benchmark::DoNotOptimize(a_wrenches.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_TransformWrenchesPerElement)->Arg(1 << 10)->Arg(1 << 16);
+
+void BM_TransformWrenchesBatch(benchmark::State& state) {
+  const Pose3d& pose = TestPose();
+  const WrenchBatch b_wrenches = MakeWrenchBatch(state.range(0));
+  WrenchBatch a_wrenches;
+  for (auto _ : state) {
+    TransformWrenches(pose, b_wrenches, a_wrenches);
+    benchmark::DoNotOptimize(a_wrenches.fx().data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_TransformWrenchesBatch)->Arg(1 << 10)->Arg(1 << 16);
+
+}  // namespace
+}  // namespace intrinsic
@@ -0,0 +1,203 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/math/pose3_batch.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstddef>
+
+#include "intrinsic/eigenmath/types.h"
+#include "intrinsic/math/pose3.h"
+#include "intrinsic/math/transform_utils.h"
+#include "intrinsic/math/twist.h"
+#include "intrinsic/util/testing/gtest_wrapper.h"
+
+namespace intrinsic {
+namespace {
+
+constexpr double kTolerance = 1e-12;
+
+Pose3d TestPose() {
+  return Pose3d(eigenmath::Quaterniond(eigenmath::AngleAxisd(
+                    0.7, eigenmath::Vector3d(1, 2, 3).normalized())),
+                eigenmath::Vector3d(0.1, -0.2, 0.3));
+}
+
+eigenmath::Vector3d MakePoint(size_t i) {
+  return eigenmath::Vector3d(std::sin(0.1 * i), std::cos(0.2 * i),
+                             std::sin(0.3 * i + 1.0));
+}
+
+Pose3d MakePose(size_t i) {
+  return Pose3d(eigenmath::Quaterniond(eigenmath::AngleAxisd(
+                    0.01 * i, MakePoint(i + 1).normalized())),
+                MakePoint(i));
+}
+
+Wrench MakeWrench(size_t i) {
+  const eigenmath::Vector3d force = MakePoint(i);
+  const eigenmath::Vector3d torque = MakePoint(i + 7);
+  return Wrench(force.x(), force.y(), force.z(), torque.x(), torque.y(),
+                torque.z());
+}
+
+Points3dBatch MakePointsBatch(size_t size) {
+  Points3dBatch points(size);
+  for (size_t i = 0; i < size; ++i) {
+    points.Set(i, MakePoint(i));
+  }
+  return points;
+}
+
+Poses3dBatch MakePosesBatch(size_t size) {
+  Poses3dBatch poses(size);
+  for (size_t i = 0; i < size; ++i) {
+    poses.Set(i, MakePose(i));
+  }
+  return poses;
+}
+
+WrenchBatch MakeWrenchBatch(size_t size) {
+  WrenchBatch wrenches(size);
+  for (size_t i = 0; i < size; ++i) {
+    wrenches.Set(i, MakeWrench(i));
+  }
+  return wrenches;
+}
+
+TEST(Poses3dBatchTest, ResizeAddsIdentityPoses) {
+  Poses3dBatch poses(2);
+  EXPECT_TRUE(poses.Get(0).isApprox(Pose3d()));
+  EXPECT_TRUE(poses.Get(1).isApprox(Pose3d()));
+}
+
+TEST(Poses3dBatchTest, SetAndGetRoundTrip) {
+  Poses3dBatch poses(1);
+  poses.Set(0, MakePose(5));
+  EXPECT_TRUE(poses.Get(0).isApprox(MakePose(5), kTolerance));
+}
+
+// The parameter is the batch size. Sizes which are not multiples of the
+// vector width exercise the remainder loops of the vectorized kernels.
+class Pose3BatchTest : public ::testing::TestWithParam<size_t> {};
+
+TEST_P(Pose3BatchTest, TransformPoints) {
+  const size_t size = GetParam();
+  const Points3dBatch b_points = MakePointsBatch(size);
+  Points3dBatch a_points;
+  TransformPoints(TestPose(), b_points, a_points);
+  ASSERT_EQ(a_points.size(), size);
+  for (size_t i = 0; i < size; ++i) {
+    EXPECT_TRUE(
+        a_points.Get(i).isApprox(TestPose() * MakePoint(i), kTolerance))
+        << "at " << i;
+  }
+}
+
+TEST_P(Pose3BatchTest, TransformPointsInPlace) {
+  const size_t size = GetParam();
+  Points3dBatch points = MakePointsBatch(size);
+  TransformPoints(TestPose(), points, points);
+  ASSERT_EQ(points.size(), size);
+  for (size_t i = 0; i < size; ++i) {
+    EXPECT_TRUE(points.Get(i).isApprox(TestPose() * MakePoint(i), kTolerance))
+        << "at " << i;
+  }
+}
+
+TEST_P(Pose3BatchTest, ComposePoses) {
+  const size_t size = GetParam();
+  const Poses3dBatch a_t_b = MakePosesBatch(size);
+  Poses3dBatch a_t_c;
+  ComposePoses(a_t_b, TestPose(), a_t_c);
+  ASSERT_EQ(a_t_c.size(), size);
+  for (size_t i = 0; i < size; ++i) {
+    EXPECT_TRUE(a_t_c.Get(i).isApprox(MakePose(i) * TestPose(), kTolerance))
+        << "at " << i;
+  }
+}
+
+TEST_P(Pose3BatchTest, ComposePosesInPlace) {
+  const size_t size = GetParam();
+  Poses3dBatch poses = MakePosesBatch(size);
+  ComposePoses(poses, TestPose(), poses);
+  ASSERT_EQ(poses.size(), size);
+  for (size_t i = 0; i < size; ++i) {
+    EXPECT_TRUE(poses.Get(i).isApprox(MakePose(i) * TestPose(), kTolerance))
+        << "at " << i;
+  }
+}
+
+TEST_P(Pose3BatchTest, InvertPoses) {
+  const size_t size = GetParam();
+  const Poses3dBatch a_t_b = MakePosesBatch(size);
+  Poses3dBatch b_t_a;
+  InvertPoses(a_t_b, b_t_a);
+  ASSERT_EQ(b_t_a.size(), size);
+  for (size_t i = 0; i < size; ++i) {
+    EXPECT_TRUE(b_t_a.Get(i).isApprox(MakePose(i).inverse(), kTolerance))
+        << "at " << i;
+  }
+}
+
+TEST_P(Pose3BatchTest, InvertPosesInPlace) {
+  const size_t size = GetParam();
+  Poses3dBatch poses = MakePosesBatch(size);
+  InvertPoses(poses, poses);
+  ASSERT_EQ(poses.size(), size);
+  for (size_t i = 0; i < size; ++i) {
+    EXPECT_TRUE(poses.Get(i).isApprox(MakePose(i).inverse(), kTolerance))
+        << "at " << i;
+  }
+}
+
+TEST_P(Pose3BatchTest, NormalizeQuaternions) {
+  const size_t size = GetParam();
+  Poses3dBatch poses = MakePosesBatch(size);
+  for (size_t i = 0; i < size; ++i) {
+    poses.qx()[i] *= 1.5;
+    poses.qy()[i] *= 1.5;
+    poses.qz()[i] *= 1.5;
+    poses.qw()[i] *= 1.5;
+  }
+  NormalizeQuaternions(poses);
+  ASSERT_EQ(poses.size(), size);
+  for (size_t i = 0; i < size; ++i) {
+    EXPECT_NEAR(poses.Get(i).quaternion().norm(), 1.0, kTolerance)
+        << "at " << i;
+    EXPECT_TRUE(poses.Get(i).isApprox(MakePose(i), kTolerance)) << "at " << i;
+  }
+}
+
+TEST_P(Pose3BatchTest, TransformWrenches) {
+  const size_t size = GetParam();
+  const WrenchBatch b_wrenches = MakeWrenchBatch(size);
+  WrenchBatch a_wrenches;
+  TransformWrenches(TestPose(), b_wrenches, a_wrenches);
+  ASSERT_EQ(a_wrenches.size(), size);
+  for (size_t i = 0; i < size; ++i) {
+    EXPECT_TRUE(a_wrenches.Get(i).isApprox(
+        TransformWrench(TestPose(), MakeWrench(i)), kTolerance))
+        << "at " << i;
+  }
+}
+
+TEST_P(Pose3BatchTest, TransformWrenchesInPlace) {
+  const size_t size = GetParam();
+  WrenchBatch wrenches = MakeWrenchBatch(size);
+  TransformWrenches(TestPose(), wrenches, wrenches);
+  ASSERT_EQ(wrenches.size(), size);
+  for (size_t i = 0; i < size; ++i) {
+    EXPECT_TRUE(wrenches.Get(i).isApprox(
+        TransformWrench(TestPose(), MakeWrench(i)), kTolerance))
+        << "at " << i;
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(Sizes, Pose3BatchTest,
+                         ::testing::Values(0, 1, 3, 8, 37, 1027));
+
+}  // namespace
+}  // namespace intrinsic
@@ -2,18 +2,30 @@
 
 #include "intrinsic/motion_planning/motion_planner_client.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <functional>
+#include <limits>
 #include <memory>
 #include <optional>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "Eigen/Core"
+#include "absl/base/thread_annotations.h"
+#include "absl/functional/function_ref.h"
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
 #include "google/protobuf/duration.pb.h"
 #include "google/protobuf/empty.pb.h"
+#include "google/protobuf/repeated_field.h"
 #include "grpcpp/client_context.h"
+#include "grpcpp/support/status.h"
 #include "intrinsic/eigenmath/types.h"
 #include "intrinsic/icon/proto/joint_space.pb.h"
 #include "intrinsic/logging/proto/context.pb.h"
@@ -29,11 +41,21 @@
 #include "intrinsic/util/status/status_macros.h"
 #include "intrinsic/world/objects/kinematic_object.h"
 #include "intrinsic/world/objects/transform_node.h"
+#include "intrinsic/world/proto/geometric_constraints.pb.h"
 #include "intrinsic/world/proto/object_world_refs.pb.h"
 
 namespace intrinsic {
 namespace motion_planning {
 
+const MotionPlannerClient::BatchOptions&
+MotionPlannerClient::BatchOptions::Defaults() {
+  static const auto* defaults = new MotionPlannerClient::BatchOptions({
+      .max_in_flight = 16,
+  });
+
+  return *defaults;
+}
+
 const MotionPlannerClient::MotionPlanningOptions&
 MotionPlannerClient::MotionPlanningOptions::Defaults() {
   static const auto* defaults = new MotionPlannerClient::MotionPlanningOptions({
@@ -96,11 +118,12 @@ MotionPlannerClient::PlanTrajectory(
   return result;
 }
 
-absl::StatusOr<std::vector<eigenmath::VectorXd>> MotionPlannerClient::ComputeIk(
-    const world::KinematicObject& robot,
+namespace {
+
+intrinsic_proto::world::geometric_constraints::GeometricConstraint
+ToGeometricConstraint(
     const intrinsic_proto::motion_planning::CartesianMotionTarget&
-        cartesian_target,
-    const IkOptions& options) {
+        cartesian_target) {
   // Convert CartesianMotionTarget to GeometricConstraint::PoseEquality.
   intrinsic_proto::world::geometric_constraints::GeometricConstraint
       geometric_target;
@@ -112,17 +135,16 @@ absl::StatusOr<std::vector<eigenmath::VectorXd>> MotionPlannerClient::ComputeIk(
     *geometric_target.mutable_pose_equality()->mutable_target_frame_offset() =
         cartesian_target.offset();
   }
-
-  return ComputeIk(robot, geometric_target, options);
+  return geometric_target;
 }
 
-absl::StatusOr<std::vector<eigenmath::VectorXd>> MotionPlannerClient::ComputeIk(
-    const world::KinematicObject& robot,
+intrinsic_proto::motion_planning::IkRequest MakeIkRequest(
+    const std::string& world_id, const world::KinematicObject& robot,
     const intrinsic_proto::world::geometric_constraints::GeometricConstraint&
         geometric_target,
-    const IkOptions& options) {
+    const MotionPlannerClient::IkOptions& options) {
   intrinsic_proto::motion_planning::IkRequest request;
-  request.set_world_id(world_id_);
+  request.set_world_id(world_id);
   request.mutable_robot_reference()->mutable_object_id()->set_id(
       robot.Id().value());
 
@@ -146,6 +168,125 @@ absl::StatusOr<std::vector<eigenmath::VectorXd>> MotionPlannerClient::ComputeIk(
 
   request.set_prefer_same_branch(options.prefer_same_branch);
 
+  return request;
+}
+
+intrinsic_proto::motion_planning::FkRequest MakeFkRequest(
+    const std::string& world_id, const world::KinematicObject& robot,
+    const eigenmath::VectorXd& joint_values,
+    const intrinsic_proto::world::TransformNodeReference& reference,
+    const intrinsic_proto::world::TransformNodeReference& target) {
+  intrinsic_proto::motion_planning::FkRequest request;
+  request.set_world_id(world_id);
+  request.mutable_robot_reference()->mutable_object_id()->set_id(
+      robot.Id().value());
+  VectorXdToRepeatedDouble(joint_values,
+                           request.mutable_joints()->mutable_joints());
+
+  *request.mutable_reference() = reference;
+  *request.mutable_target() = target;
+  return request;
+}
+
+absl::Status CheckBatchOptions(
+    const MotionPlannerClient::BatchOptions& batch_options) {
+  if (batch_options.max_in_flight <= 0) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("max_in_flight must be positive, got ",
+                     batch_options.max_in_flight, "."));
+  }
+  return absl::OkStatus();
+}
+
+// Makes one unary call per item with at most `max_in_flight` calls in flight
+// at once. `start_call` starts a call with the callback API of the stub.
+// `make_request` fills the request for an item and `handle_response` consumes
+// the status and response of an item. Both run on the calling thread, which
+// blocks until all calls finished.
+template <typename Request, typename Response>
+void CallWindowed(
+    int num_items, int max_in_flight,
+    absl::FunctionRef<void(grpc::ClientContext*, const Request*, Response*,
+                           std::function<void(grpc::Status)>)>
+        start_call,
+    absl::FunctionRef<void(int, Request&)> make_request,
+    absl::FunctionRef<void(int, const grpc::Status&, const Response&)>
+        handle_response) {
+  // Each call in flight occupies a slot, which is reused once its response was
+  // handled. Contexts cannot be reused, so each call gets a new one.
+  struct Slot {
+    int item = 0;
+    std::optional<grpc::ClientContext> context;
+    Request request;
+    Response response;
+    grpc::Status status;
+  };
+  // Shared with the callbacks, which may still be returning when the last
+  // response was handled.
+  struct Window {
+    std::vector<std::unique_ptr<Slot>> slots;
+    absl::Mutex mutex;
+    std::vector<Slot*> finished ABSL_GUARDED_BY(mutex);
+  };
+  auto window = std::make_shared<Window>();
+  std::vector<Slot*> idle;
+  for (int i = 0; i < std::min(num_items, max_in_flight); ++i) {
+    idle.push_back(
+        window->slots.emplace_back(std::make_unique<Slot>()).get());
+  }
+
+  int next_item = 0;
+  int num_handled = 0;
+  std::vector<Slot*> finished;
+  while (num_handled < num_items) {
+    for (; next_item < num_items && !idle.empty(); ++next_item) {
+      Slot* slot = idle.back();
+      idle.pop_back();
+      slot->item = next_item;
+      slot->context.emplace();
+      make_request(next_item, slot->request);
+      start_call(&*slot->context, &slot->request, &slot->response,
+                 [window, slot](grpc::Status s) {
+                   slot->status = std::move(s);
+                   absl::MutexLock lock(&window->mutex);
+                   window->finished.push_back(slot);
+                 });
+    }
+    {
+      absl::MutexLock lock(&window->mutex);
+      window->mutex.Await(absl::Condition(
+          +[](std::vector<Slot*>* finished) { return !finished->empty(); },
+          &window->finished));
+      finished.swap(window->finished);
+    }
+    for (Slot* slot : finished) {
+      handle_response(slot->item, slot->status, slot->response);
+      slot->context.reset();
+      idle.push_back(slot);
+      ++num_handled;
+    }
+    finished.clear();
+  }
+}
+
+}  // namespace
+
+absl::StatusOr<std::vector<eigenmath::VectorXd>> MotionPlannerClient::ComputeIk(
+    const world::KinematicObject& robot,
+    const intrinsic_proto::motion_planning::CartesianMotionTarget&
+        cartesian_target,
+    const IkOptions& options) {
+  return ComputeIk(robot, ToGeometricConstraint(cartesian_target), options);
+}
+
+absl::StatusOr<std::vector<eigenmath::VectorXd>> MotionPlannerClient::ComputeIk(
+    const world::KinematicObject& robot,
+    const intrinsic_proto::world::geometric_constraints::GeometricConstraint&
+        geometric_target,
+    const IkOptions& options) {
+  intrinsic_proto::motion_planning::IkRequest request =
+      MakeIkRequest(world_id_, robot, geometric_target, options);
+
   intrinsic_proto::motion_planning::IkResponse response;
   grpc::ClientContext ctx;
   INTR_RETURN_IF_ERROR(ToAbslStatus(
@@ -154,6 +295,87 @@ absl::StatusOr<std::vector<eigenmath::VectorXd>> MotionPlannerClient::ComputeIk(
   return ToVectorXds(response.solutions());
 }
 
+absl::StatusOr<MotionPlannerClient::IkBatchResult>
+MotionPlannerClient::ComputeIkBatch(
+    const world::KinematicObject& robot,
+    absl::Span<const intrinsic_proto::motion_planning::CartesianMotionTarget>
+        cartesian_targets,
+    const IkOptions& options, const BatchOptions& batch_options) {
+  std::vector<
+      intrinsic_proto::world::geometric_constraints::GeometricConstraint>
+      geometric_targets;
+  geometric_targets.reserve(cartesian_targets.size());
+  for (const intrinsic_proto::motion_planning::CartesianMotionTarget&
+           cartesian_target : cartesian_targets) {
+    geometric_targets.push_back(ToGeometricConstraint(cartesian_target));
+  }
+  return ComputeIkBatch(robot, geometric_targets, options, batch_options);
+}
+
+absl::StatusOr<MotionPlannerClient::IkBatchResult>
+MotionPlannerClient::ComputeIkBatch(
+    const world::KinematicObject& robot,
+    absl::Span<const intrinsic_proto::world::geometric_constraints::
+                   GeometricConstraint>
+        geometric_targets,
+    const IkOptions& options, const BatchOptions& batch_options) {
+  INTR_RETURN_IF_ERROR(CheckBatchOptions(batch_options));
+  auto* async_stub = motion_planner_service_->async();
+  if (async_stub == nullptr) {
+    return absl::UnimplementedError(
+        "The MotionPlannerService stub does not support asynchronous calls.");
+  }
+  const intrinsic_proto::motion_planning::IkRequest base_request =
+      MakeIkRequest(
+          world_id_, robot,
+          intrinsic_proto::world::geometric_constraints::GeometricConstraint(),
+          options);
+
+  IkBatchResult result;
+  result.solutions.setConstant(robot.JointPositions().size(),
+                               geometric_targets.size(),
+                               std::numeric_limits<double>::quiet_NaN());
+  result.num_solutions.resize(geometric_targets.size(), 0);
+  result.status.resize(geometric_targets.size());
+  CallWindowed<intrinsic_proto::motion_planning::IkRequest,
+               intrinsic_proto::motion_planning::IkResponse>(
+      geometric_targets.size(), batch_options.max_in_flight,
+      [async_stub](grpc::ClientContext* context,
+                   const intrinsic_proto::motion_planning::IkRequest* request,
+                   intrinsic_proto::motion_planning::IkResponse* response,
+                   std::function<void(grpc::Status)> done) {
+        async_stub->ComputeIk(context, request, response, std::move(done));
+      },
+      [&](int i, intrinsic_proto::motion_planning::IkRequest& request) {
+        request = base_request;
+        *request.mutable_target() = geometric_targets[i];
+      },
+      [&](int i, const grpc::Status& status,
+          const intrinsic_proto::motion_planning::IkResponse& response) {
+        if (!status.ok()) {
+          result.status[i] = ToAbslStatus(status);
+          return;
+        }
+        result.num_solutions[i] = response.solutions_size();
+        if (response.solutions().empty()) {
+          result.status[i] = absl::NotFoundError(
+              absl::StrCat("Found no IK solution for target ", i, "."));
+          return;
+        }
+        const google::protobuf::RepeatedField<double>& joints =
+            response.solutions(0).joints();
+        if (joints.size() != result.solutions.rows()) {
+          result.status[i] = absl::InternalError(absl::StrCat(
+              "The IK solution for target ", i, " has ", joints.size(),
+              " joints, but the robot has ", result.solutions.rows(), "."));
+          return;
+        }
+        result.solutions.col(i) =
+            Eigen::Map<const Eigen::VectorXd>(joints.data(), joints.size());
+      });
+  return result;
+}
+
 namespace {
 
 // Common adaptor to handle different specifications of reference, target.
@@ -165,15 +387,8 @@ absl::StatusOr<Pose3d> ComputeFkInternal(
     const std::string& world_id,
     intrinsic_proto::motion_planning::MotionPlannerService::StubInterface&
         motion_planner_service) {
-  intrinsic_proto::motion_planning::FkRequest request;
-  request.set_world_id(world_id);
-  request.mutable_robot_reference()->mutable_object_id()->set_id(
-      robot.Id().value());
-  VectorXdToRepeatedDouble(joint_values,
-                           request.mutable_joints()->mutable_joints());
-
-  *request.mutable_reference() = reference;
-  *request.mutable_target() = target;
+  intrinsic_proto::motion_planning::FkRequest request =
+      MakeFkRequest(world_id, robot, joint_values, reference, target);
 
   intrinsic_proto::motion_planning::FkResponse response;
   grpc::ClientContext ctx;
@@ -183,6 +398,60 @@ absl::StatusOr<Pose3d> ComputeFkInternal(
   return FromProto(response.reference_t_target());
 }
 
+absl::StatusOr<MotionPlannerClient::FkBatchResult> ComputeFkBatchInternal(
+    const world::KinematicObject& robot,
+    absl::Span<const eigenmath::VectorXd> joint_values,
+    const intrinsic_proto::world::TransformNodeReference& reference,
+    const intrinsic_proto::world::TransformNodeReference& target,
+    const MotionPlannerClient::BatchOptions& batch_options,
+    const std::string& world_id,
+    intrinsic_proto::motion_planning::MotionPlannerService::StubInterface&
+        motion_planner_service) {
+  INTR_RETURN_IF_ERROR(CheckBatchOptions(batch_options));
+  auto* async_stub = motion_planner_service.async();
+  if (async_stub == nullptr) {
+    return absl::UnimplementedError(
+        "The MotionPlannerService stub does not support asynchronous calls.");
+  }
+  const intrinsic_proto::motion_planning::FkRequest base_request =
+      MakeFkRequest(world_id, robot, eigenmath::VectorXd(), reference, target);
+
+  MotionPlannerClient::FkBatchResult result;
+  result.poses.setConstant(7, joint_values.size(),
+                           std::numeric_limits<double>::quiet_NaN());
+  result.status.resize(joint_values.size());
+  CallWindowed<intrinsic_proto::motion_planning::FkRequest,
+               intrinsic_proto::motion_planning::FkResponse>(
+      joint_values.size(), batch_options.max_in_flight,
+      [async_stub](grpc::ClientContext* context,
+                   const intrinsic_proto::motion_planning::FkRequest* request,
+                   intrinsic_proto::motion_planning::FkResponse* response,
+                   std::function<void(grpc::Status)> done) {
+        async_stub->ComputeFk(context, request, response, std::move(done));
+      },
+      [&](int i, intrinsic_proto::motion_planning::FkRequest& request) {
+        request = base_request;
+        VectorXdToRepeatedDouble(joint_values[i],
+                                 request.mutable_joints()->mutable_joints());
+      },
+      [&](int i, const grpc::Status& status,
+          const intrinsic_proto::motion_planning::FkResponse& response) {
+        if (!status.ok()) {
+          result.status[i] = ToAbslStatus(status);
+          return;
+        }
+        absl::StatusOr<Pose3d> reference_t_target =
+            FromProto(response.reference_t_target());
+        if (!reference_t_target.ok()) {
+          result.status[i] = reference_t_target.status();
+          return;
+        }
+        result.poses.col(i) << reference_t_target->translation(),
+            reference_t_target->quaternion().coeffs();
+      });
+  return result;
+}
+
 }  // namespace
 
 absl::StatusOr<Pose3d> MotionPlannerClient::ComputeFk(
@@ -210,6 +479,43 @@ absl::StatusOr<Pose3d> MotionPlannerClient::ComputeFk(
                            world_id_, *motion_planner_service_);
 }
 
+Pose3d MotionPlannerClient::FkBatchResult::Pose(int i) const {
+  return Pose3d(eigenmath::Quaterniond(poses(6, i), poses(3, i), poses(4, i),
+                                       poses(5, i)),
+                poses.col(i).head<3>(), eigenmath::kDoNotNormalize);
+}
+
+absl::StatusOr<MotionPlannerClient::FkBatchResult>
+MotionPlannerClient::ComputeFkBatch(
+    const world::KinematicObject& robot,
+    absl::Span<const eigenmath::VectorXd> joint_values,
+    const intrinsic_proto::world::TransformNodeReferenceByName& reference,
+    const intrinsic_proto::world::TransformNodeReferenceByName& target,
+    const BatchOptions& batch_options) {
+  intrinsic_proto::world::TransformNodeReference reference_proto;
+  *reference_proto.mutable_by_name() = reference;
+  intrinsic_proto::world::TransformNodeReference target_proto;
+  *target_proto.mutable_by_name() = target;
+  return ComputeFkBatchInternal(robot, joint_values, reference_proto,
+                                target_proto, batch_options, world_id_,
+                                *motion_planner_service_);
+}
+
+absl::StatusOr<MotionPlannerClient::FkBatchResult>
+MotionPlannerClient::ComputeFkBatch(
+    const world::KinematicObject& robot,
+    absl::Span<const eigenmath::VectorXd> joint_values,
+    const world::TransformNode& reference, const world::TransformNode& target,
+    const BatchOptions& batch_options) {
+  intrinsic_proto::world::TransformNodeReference reference_proto;
+  reference_proto.set_id(reference.Id().value());
+  intrinsic_proto::world::TransformNodeReference target_proto;
+  target_proto.set_id(target.Id().value());
+  return ComputeFkBatchInternal(robot, joint_values, reference_proto,
+                                target_proto, batch_options, world_id_,
+                                *motion_planner_service_);
+}
+
 absl::StatusOr<intrinsic_proto::motion_planning::CheckCollisionsResponse>
 MotionPlannerClient::CheckCollisions(
     const world::KinematicObject& robot,
@@ -8,8 +8,11 @@
 #include <string>
 #include <vector>
 
+#include "Eigen/Core"
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "google/protobuf/empty.pb.h"
 #include "intrinsic/eigenmath/types.h"
 #include "intrinsic/geometry/service/transformed_geometry_storage_refs.pb.h"
@@ -23,6 +26,7 @@
 #include "intrinsic/world/objects/kinematic_object.h"
 #include "intrinsic/world/objects/transform_node.h"
 #include "intrinsic/world/proto/collision_settings.pb.h"
+#include "intrinsic/world/proto/geometric_constraints.pb.h"
 #include "intrinsic/world/proto/object_world_refs.pb.h"
 
 namespace intrinsic {
@@ -148,6 +152,84 @@ class MotionPlannerClient {
                                    const eigenmath::VectorXd& joint_values,
                                    const world::TransformNode& reference,
                                    const world::TransformNode& target);
+
+  // Options for the batch variants of ComputeIk() and ComputeFk().
+  struct BatchOptions {
+    // The maximum number of calls to the motion planner service in flight at
+    // once. Must be positive.
+    int max_in_flight = 16;
+
+    // Returns the default set of options to use with the batch requests.
+    static const BatchOptions& Defaults();
+  };
+
+  // Result of ComputeIkBatch().
+  struct IkBatchResult {
+    // Column i is the first solution for target i, or NaN if status[i] is not
+    // OK. Has one row per joint of the robot.
+    eigenmath::MatrixXd solutions;
+
+    // The total number of solutions the service returned for each target.
+    std::vector<int> num_solutions;
+
+    // Per target: NotFoundError if the service found no solution, the error of
+    // the call if it failed, OK otherwise.
+    std::vector<absl::Status> status;
+  };
+
+  // Computes inverse kinematics like ComputeIk() for each target, with several
+  // calls to the motion planner service in flight at once. Only the first
+  // solution per target is kept, so set IkOptions::max_num_solutions = 1 unless
+  // the server orders its solutions by preference. Returns an error only for
+  // invalid options or a stub without asynchronous calls (e.g. a mock); the
+  // outcome for each target is in IkBatchResult::status.
+  absl::StatusOr<IkBatchResult> ComputeIkBatch(
+      const world::KinematicObject& robot,
+      absl::Span<const intrinsic_proto::motion_planning::CartesianMotionTarget>
+          cartesian_targets,
+      const IkOptions& options = {.ensure_same_branch = false,
+                                  .prefer_same_branch = false},
+      const BatchOptions& batch_options = BatchOptions::Defaults());
+  absl::StatusOr<IkBatchResult> ComputeIkBatch(
+      const world::KinematicObject& robot,
+      absl::Span<const intrinsic_proto::world::geometric_constraints::
+                     GeometricConstraint>
+          geometric_targets,
+      const IkOptions& options = {.ensure_same_branch = false,
+                                  .prefer_same_branch = false},
+      const BatchOptions& batch_options = BatchOptions::Defaults());
+
+  // Result of ComputeFkBatch().
+  struct FkBatchResult {
+    // Column i is reference_t_target for joint configuration i as
+    // (x, y, z, qx, qy, qz, qw), or NaN if status[i] is not OK.
+    Eigen::Matrix<double, 7, Eigen::Dynamic> poses;
+
+    // Per joint configuration: the error of the call if it failed, OK
+    // otherwise.
+    std::vector<absl::Status> status;
+
+    // Returns column i of `poses` as a pose.
+    Pose3d Pose(int i) const;
+  };
+
+  // Computes forward kinematics like ComputeFk() for each of `joint_values`,
+  // with several calls to the motion planner service in flight at once.
+  // Returns an error only for invalid options or a stub without asynchronous
+  // calls (e.g. a mock); the outcome for each joint configuration is in
+  // FkBatchResult::status.
+  absl::StatusOr<FkBatchResult> ComputeFkBatch(
+      const world::KinematicObject& robot,
+      absl::Span<const eigenmath::VectorXd> joint_values,
+      const intrinsic_proto::world::TransformNodeReferenceByName& reference,
+      const intrinsic_proto::world::TransformNodeReferenceByName& target,
+      const BatchOptions& batch_options = BatchOptions::Defaults());
+  absl::StatusOr<FkBatchResult> ComputeFkBatch(
+      const world::KinematicObject& robot,
+      absl::Span<const eigenmath::VectorXd> joint_values,
+      const world::TransformNode& reference, const world::TransformNode& target,
+      const BatchOptions& batch_options = BatchOptions::Defaults());
+
   // Options for check collisions.
   struct CheckCollisionsOptions {
     // Optional collision settings.
@@ -0,0 +1,173 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+// Measures the throughput of forward and inverse kinematics through
+// MotionPlannerClient, once with one blocking call per item and once with the
+// batch variants at several in-flight windows. The motion planner service is a
+// fake on an in-process channel which sleeps for a configurable time per call
+// to stand in for the network round trip and the computation of a real
+// service.
+
+#include <string>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "absl/status/statusor.h"
+#include "absl/time/time.h"
+#include "benchmark/benchmark.h"
+#include "intrinsic/eigenmath/types.h"
+#include "intrinsic/math/pose3.h"
+#include "intrinsic/math/proto_conversion.h"
+#include "intrinsic/motion_planning/motion_planner_client.h"
+#include "intrinsic/motion_planning/testing/fake_motion_planner_service.h"
+#include "intrinsic/world/objects/kinematic_object.h"
+#include "intrinsic/world/proto/geometric_constraints.pb.h"
+#include "intrinsic/world/proto/object_world_refs.pb.h"
+#include "intrinsic/world/proto/object_world_service.pb.h"
+
+namespace intrinsic {
+namespace motion_planning {
+namespace {
+
+using ::intrinsic_proto::world::geometric_constraints::GeometricConstraint;
+
+constexpr char kWorldId[] = "world";
+constexpr int kNumDof = 6;
+// The number of items per benchmark iteration.
+constexpr int kNumItems = 200;
+
+world::KinematicObject MakeRobot() {
+  intrinsic_proto::world::Object proto;
+  proto.set_world_id(kWorldId);
+  proto.set_id("robot");
+  proto.set_name("robot");
+  proto.set_type(intrinsic_proto::world::ObjectType::KINEMATIC_OBJECT);
+  *proto.mutable_object_component()->mutable_parent_t_this() =
+      ToProto(Pose3d());
+  for (int i = 0; i < kNumDof; ++i) {
+    proto.mutable_kinematic_object_component()->add_joint_positions(0.0);
+  }
+  absl::StatusOr<world::KinematicObject> robot =
+      world::KinematicObject::Create(proto);
+  CHECK_OK(robot.status());
+  return *robot;
+}
+
+std::vector<eigenmath::VectorXd> MakeJointValues() {
+  std::vector<eigenmath::VectorXd> joint_values;
+  for (int i = 0; i < kNumItems; ++i) {
+    joint_values.push_back(eigenmath::VectorXd::Constant(kNumDof, 0.01 * i));
+  }
+  return joint_values;
+}
+
+intrinsic_proto::world::TransformNodeReferenceByName FrameByName(
+    const std::string& name) {
+  intrinsic_proto::world::TransformNodeReferenceByName reference;
+  reference.mutable_frame()->set_object_name("robot");
+  reference.mutable_frame()->set_frame_name(name);
+  return reference;
+}
+
+std::vector<GeometricConstraint> MakeTargets() {
+  std::vector<GeometricConstraint> targets(kNumItems);
+  for (int i = 0; i < kNumItems; ++i) {
+    intrinsic_proto::world::geometric_constraints::PoseEquality* pose_equality =
+        targets[i].mutable_pose_equality();
+    *pose_equality->mutable_target_frame()->mutable_by_name() =
+        FrameByName("target");
+    *pose_equality->mutable_moving_frame()->mutable_by_name() =
+        FrameByName("tool");
+    *pose_equality->mutable_target_frame_offset() =
+        ToProto(Pose3d(eigenmath::Vector3d(0.01 * i, 0.0, 0.0)));
+  }
+  return targets;
+}
+
+// The first argument of each benchmark is the latency of the fake service in
+// microseconds.
+void BM_ComputeFkSequential(benchmark::State& state) {
+  FakeMotionPlannerServer server(kNumDof, absl::Microseconds(state.range(0)));
+  MotionPlannerClient client = server.MakeClient(kWorldId);
+  const world::KinematicObject robot = MakeRobot();
+  const std::vector<eigenmath::VectorXd> joint_values = MakeJointValues();
+  for (auto _ : state) {
+    for (const eigenmath::VectorXd& joints : joint_values) {
+      absl::StatusOr<Pose3d> pose = client.ComputeFk(
+          robot, joints, FrameByName("base"), FrameByName("flange"));
+      CHECK_OK(pose.status());
+      benchmark::DoNotOptimize(pose);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kNumItems);
+}
+BENCHMARK(BM_ComputeFkSequential)->Arg(0)->Arg(200)->UseRealTime();
+
+// The second argument is the in-flight window.
+void BM_ComputeFkBatch(benchmark::State& state) {
+  FakeMotionPlannerServer server(kNumDof, absl::Microseconds(state.range(0)));
+  MotionPlannerClient client = server.MakeClient(kWorldId);
+  const world::KinematicObject robot = MakeRobot();
+  const std::vector<eigenmath::VectorXd> joint_values = MakeJointValues();
+  const MotionPlannerClient::BatchOptions batch_options = {
+      .max_in_flight = static_cast<int>(state.range(1))};
+  for (auto _ : state) {
+    absl::StatusOr<MotionPlannerClient::FkBatchResult> result =
+        client.ComputeFkBatch(robot, joint_values, FrameByName("base"),
+                              FrameByName("flange"), batch_options);
+    CHECK_OK(result.status());
+    for (int i = 0; i < kNumItems; ++i) {
+      CHECK_OK(result->status[i]);
+      CHECK(result->Pose(i).translation().isApprox(
+          joint_values[i].head<3>()));
+    }
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetItemsProcessed(state.iterations() * kNumItems);
+}
+BENCHMARK(BM_ComputeFkBatch)
+    ->ArgsProduct({{0, 200}, {1, 8, 32}})
+    ->UseRealTime();
+
+void BM_ComputeIkSequential(benchmark::State& state) {
+  FakeMotionPlannerServer server(kNumDof, absl::Microseconds(state.range(0)));
+  MotionPlannerClient client = server.MakeClient(kWorldId);
+  const world::KinematicObject robot = MakeRobot();
+  const std::vector<GeometricConstraint> targets = MakeTargets();
+  for (auto _ : state) {
+    for (const GeometricConstraint& target : targets) {
+      absl::StatusOr<std::vector<eigenmath::VectorXd>> solutions =
+          client.ComputeIk(robot, target);
+      CHECK_OK(solutions.status());
+      benchmark::DoNotOptimize(solutions);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kNumItems);
+}
+BENCHMARK(BM_ComputeIkSequential)->Arg(0)->Arg(200)->UseRealTime();
+
+void BM_ComputeIkBatch(benchmark::State& state) {
+  FakeMotionPlannerServer server(kNumDof, absl::Microseconds(state.range(0)));
+  MotionPlannerClient client = server.MakeClient(kWorldId);
+  const world::KinematicObject robot = MakeRobot();
+  const std::vector<GeometricConstraint> targets = MakeTargets();
+  const MotionPlannerClient::BatchOptions batch_options = {
+      .max_in_flight = static_cast<int>(state.range(1))};
+  for (auto _ : state) {
+    absl::StatusOr<MotionPlannerClient::IkBatchResult> result =
+        client.ComputeIkBatch(robot, targets, {}, batch_options);
+    CHECK_OK(result.status());
+    for (int i = 0; i < kNumItems; ++i) {
+      CHECK_OK(result->status[i]);
+      CHECK_EQ(result->solutions(0, i), 0.01 * i);
+    }
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetItemsProcessed(state.iterations() * kNumItems);
+}
+BENCHMARK(BM_ComputeIkBatch)
+    ->ArgsProduct({{0, 200}, {1, 8, 32}})
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace motion_planning
+}  // namespace intrinsic
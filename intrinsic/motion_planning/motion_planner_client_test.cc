@@ -0,0 +1,308 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/motion_planning/motion_planner_client.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/time/time.h"
+#include "grpcpp/support/status.h"
+#include "intrinsic/eigenmath/types.h"
+#include "intrinsic/math/pose3.h"
+#include "intrinsic/math/proto_conversion.h"
+#include "intrinsic/motion_planning/proto/motion_planner_service_mock.grpc.pb.h"
+#include "intrinsic/motion_planning/proto/motion_target.pb.h"
+#include "intrinsic/motion_planning/testing/fake_motion_planner_service.h"
+#include "intrinsic/util/testing/gtest_wrapper.h"
+#include "intrinsic/world/objects/kinematic_object.h"
+#include "intrinsic/world/proto/geometric_constraints.pb.h"
+#include "intrinsic/world/proto/object_world_refs.pb.h"
+#include "intrinsic/world/proto/object_world_service.pb.h"
+
+namespace intrinsic {
+namespace motion_planning {
+namespace {
+
+using ::intrinsic::testing::StatusIs;
+using ::intrinsic_proto::world::geometric_constraints::GeometricConstraint;
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+using ::testing::IsEmpty;
+using ::testing::Le;
+
+constexpr char kWorldId[] = "world";
+constexpr int kNumDof = 6;
+
+world::KinematicObject MakeRobot() {
+  intrinsic_proto::world::Object proto;
+  proto.set_world_id(kWorldId);
+  proto.set_id("robot");
+  proto.set_name("robot");
+  proto.set_type(intrinsic_proto::world::ObjectType::KINEMATIC_OBJECT);
+  *proto.mutable_object_component()->mutable_parent_t_this() =
+      ToProto(Pose3d());
+  for (int i = 0; i < kNumDof; ++i) {
+    proto.mutable_kinematic_object_component()->add_joint_positions(0.0);
+  }
+  absl::StatusOr<world::KinematicObject> robot =
+      world::KinematicObject::Create(proto);
+  CHECK_OK(robot.status());
+  return *robot;
+}
+
+intrinsic_proto::world::TransformNodeReferenceByName FrameByName(
+    const std::string& name) {
+  intrinsic_proto::world::TransformNodeReferenceByName reference;
+  reference.mutable_frame()->set_object_name("robot");
+  reference.mutable_frame()->set_frame_name(name);
+  return reference;
+}
+
+// Returns one joint configuration per item, whose first joint value is the
+// index of the item. This is the key of the item for the fake service.
+std::vector<eigenmath::VectorXd> MakeJointValues(int num_items) {
+  std::vector<eigenmath::VectorXd> joint_values;
+  for (int i = 0; i < num_items; ++i) {
+    eigenmath::VectorXd joints = eigenmath::VectorXd::Zero(kNumDof);
+    joints.head<3>() << i, 2.0 * i, 3.0 * i;
+    joint_values.push_back(joints);
+  }
+  return joint_values;
+}
+
+// Returns one target per item, whose x offset is the index of the item. This
+// is the key of the item for the fake service.
+std::vector<GeometricConstraint> MakeTargets(int num_items) {
+  std::vector<GeometricConstraint> targets(num_items);
+  for (int i = 0; i < num_items; ++i) {
+    intrinsic_proto::world::geometric_constraints::PoseEquality* pose_equality =
+        targets[i].mutable_pose_equality();
+    *pose_equality->mutable_target_frame()->mutable_by_name() =
+        FrameByName("target");
+    *pose_equality->mutable_moving_frame()->mutable_by_name() =
+        FrameByName("tool");
+    *pose_equality->mutable_target_frame_offset() =
+        ToProto(Pose3d(eigenmath::Vector3d(i, 0.0, 0.0)));
+  }
+  return targets;
+}
+
+// Lets the calls of later items finish first.
+void ReverseCompletionOrder(FakeMotionPlannerService& service,
+                            int num_items) {
+  for (int i = 0; i < num_items; ++i) {
+    service.SetLatency(i, absl::Milliseconds(20 * (num_items - i)));
+  }
+}
+
+TEST(MotionPlannerClientBatchTest, IkResultsAreInTargetOrder) {
+  constexpr int kNumItems = 5;
+  FakeMotionPlannerServer server(kNumDof);
+  ReverseCompletionOrder(server.service(), kNumItems);
+  MotionPlannerClient client = server.MakeClient(kWorldId);
+
+  ASSERT_OK_AND_ASSIGN(
+      const MotionPlannerClient::IkBatchResult result,
+      client.ComputeIkBatch(MakeRobot(), MakeTargets(kNumItems), {},
+                            {.max_in_flight = 2 * kNumItems}));
+
+  // All calls were in flight at once and completed in reverse order.
+  EXPECT_EQ(server.service().max_calls_in_flight(), kNumItems);
+  EXPECT_THAT(server.service().answered_keys(), ElementsAre(4, 3, 2, 1, 0));
+  ASSERT_EQ(result.solutions.rows(), kNumDof);
+  ASSERT_EQ(result.solutions.cols(), kNumItems);
+  EXPECT_THAT(result.num_solutions, ElementsAre(1, 1, 1, 1, 1));
+  for (int i = 0; i < kNumItems; ++i) {
+    EXPECT_OK(result.status[i]);
+    EXPECT_EQ(result.solutions(0, i), i);
+  }
+}
+
+TEST(MotionPlannerClientBatchTest, FkResultsAreInConfigurationOrder) {
+  constexpr int kNumItems = 5;
+  FakeMotionPlannerServer server(kNumDof);
+  ReverseCompletionOrder(server.service(), kNumItems);
+  MotionPlannerClient client = server.MakeClient(kWorldId);
+
+  ASSERT_OK_AND_ASSIGN(
+      const MotionPlannerClient::FkBatchResult result,
+      client.ComputeFkBatch(MakeRobot(), MakeJointValues(kNumItems),
+                            FrameByName("base"), FrameByName("flange"),
+                            {.max_in_flight = 2 * kNumItems}));
+
+  EXPECT_EQ(server.service().max_calls_in_flight(), kNumItems);
+  EXPECT_THAT(server.service().answered_keys(), ElementsAre(4, 3, 2, 1, 0));
+  ASSERT_EQ(result.poses.cols(), kNumItems);
+  for (int i = 0; i < kNumItems; ++i) {
+    EXPECT_OK(result.status[i]);
+    EXPECT_TRUE(result.Pose(i).isApprox(
+        Pose3d(eigenmath::Vector3d(i, 2.0 * i, 3.0 * i))))
+        << "Pose " << i << ": " << result.poses.col(i).transpose();
+  }
+}
+
+TEST(MotionPlannerClientBatchTest, IkErrorsAreReportedPerTarget) {
+  FakeMotionPlannerServer server(kNumDof);
+  server.service().SetNoIkSolution(1);
+  server.service().SetStatus(
+      2, grpc::Status(grpc::StatusCode::UNAVAILABLE, "Planner restarting."));
+  MotionPlannerClient client = server.MakeClient(kWorldId);
+
+  ASSERT_OK_AND_ASSIGN(const MotionPlannerClient::IkBatchResult result,
+                       client.ComputeIkBatch(MakeRobot(), MakeTargets(4)));
+
+  EXPECT_OK(result.status[0]);
+  EXPECT_THAT(result.status[1], StatusIs(absl::StatusCode::kNotFound,
+                                         HasSubstr("target 1")));
+  EXPECT_THAT(result.status[2], StatusIs(absl::StatusCode::kUnavailable,
+                                         HasSubstr("Planner restarting.")));
+  EXPECT_OK(result.status[3]);
+  EXPECT_THAT(result.num_solutions, ElementsAre(1, 0, 0, 1));
+  EXPECT_EQ(result.solutions(0, 0), 0);
+  EXPECT_TRUE(result.solutions.col(1).array().isNaN().all());
+  EXPECT_TRUE(result.solutions.col(2).array().isNaN().all());
+  EXPECT_EQ(result.solutions(0, 3), 3);
+}
+
+TEST(MotionPlannerClientBatchTest, FkErrorsAreReportedPerConfiguration) {
+  FakeMotionPlannerServer server(kNumDof);
+  server.service().SetStatus(
+      1, grpc::Status(grpc::StatusCode::NOT_FOUND, "Unknown frame."));
+  MotionPlannerClient client = server.MakeClient(kWorldId);
+  std::vector<eigenmath::VectorXd> joint_values = MakeJointValues(4);
+  // The fake service rejects configurations of the wrong size.
+  joint_values[2] = eigenmath::VectorXd::Zero(kNumDof - 1);
+
+  ASSERT_OK_AND_ASSIGN(
+      const MotionPlannerClient::FkBatchResult result,
+      client.ComputeFkBatch(MakeRobot(), joint_values, FrameByName("base"),
+                            FrameByName("flange")));
+
+  EXPECT_OK(result.status[0]);
+  EXPECT_THAT(result.status[1], StatusIs(absl::StatusCode::kNotFound));
+  EXPECT_THAT(result.status[2], StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_OK(result.status[3]);
+  EXPECT_TRUE(result.poses.col(1).array().isNaN().all());
+  EXPECT_TRUE(result.poses.col(2).array().isNaN().all());
+  EXPECT_TRUE(result.Pose(3).translation().isApprox(
+      eigenmath::Vector3d(3.0, 6.0, 9.0)));
+}
+
+TEST(MotionPlannerClientBatchTest, MaxInFlightOfOneCallsOneAtATime) {
+  constexpr int kNumItems = 5;
+  FakeMotionPlannerServer server(kNumDof, absl::Milliseconds(1));
+  ReverseCompletionOrder(server.service(), kNumItems);
+  MotionPlannerClient client = server.MakeClient(kWorldId);
+
+  ASSERT_OK_AND_ASSIGN(
+      const MotionPlannerClient::FkBatchResult result,
+      client.ComputeFkBatch(MakeRobot(), MakeJointValues(kNumItems),
+                            FrameByName("base"), FrameByName("flange"),
+                            {.max_in_flight = 1}));
+
+  EXPECT_EQ(server.service().max_calls_in_flight(), 1);
+  EXPECT_THAT(server.service().answered_keys(), ElementsAre(0, 1, 2, 3, 4));
+  for (int i = 0; i < kNumItems; ++i) {
+    EXPECT_OK(result.status[i]);
+  }
+}
+
+TEST(MotionPlannerClientBatchTest, MaxInFlightLimitsCallsInFlight) {
+  constexpr int kNumItems = 20;
+  FakeMotionPlannerServer server(kNumDof, absl::Milliseconds(5));
+  MotionPlannerClient client = server.MakeClient(kWorldId);
+
+  ASSERT_OK_AND_ASSIGN(
+      const MotionPlannerClient::IkBatchResult result,
+      client.ComputeIkBatch(MakeRobot(), MakeTargets(kNumItems), {},
+                            {.max_in_flight = 3}));
+
+  EXPECT_THAT(server.service().max_calls_in_flight(), Le(3));
+  EXPECT_EQ(server.service().answered_keys().size(), kNumItems);
+  for (int i = 0; i < kNumItems; ++i) {
+    EXPECT_OK(result.status[i]);
+    EXPECT_EQ(result.solutions(0, i), i);
+  }
+}
+
+TEST(MotionPlannerClientBatchTest, CartesianTargetsUseTheirOffset) {
+  FakeMotionPlannerServer server(kNumDof);
+  MotionPlannerClient client = server.MakeClient(kWorldId);
+  std::vector<intrinsic_proto::motion_planning::CartesianMotionTarget> targets(
+      2);
+  for (int i = 0; i < 2; ++i) {
+    *targets[i].mutable_tool()->mutable_by_name() = FrameByName("tool");
+    *targets[i].mutable_frame()->mutable_by_name() = FrameByName("target");
+    *targets[i].mutable_offset() =
+        ToProto(Pose3d(eigenmath::Vector3d(i + 1, 0.0, 0.0)));
+  }
+
+  ASSERT_OK_AND_ASSIGN(const MotionPlannerClient::IkBatchResult result,
+                       client.ComputeIkBatch(MakeRobot(), targets));
+
+  EXPECT_OK(result.status[0]);
+  EXPECT_OK(result.status[1]);
+  EXPECT_EQ(result.solutions(0, 0), 1);
+  EXPECT_EQ(result.solutions(0, 1), 2);
+}
+
+TEST(MotionPlannerClientBatchTest, EmptyBatchesMakeNoCalls) {
+  FakeMotionPlannerServer server(kNumDof);
+  MotionPlannerClient client = server.MakeClient(kWorldId);
+
+  ASSERT_OK_AND_ASSIGN(const MotionPlannerClient::IkBatchResult ik_result,
+                       client.ComputeIkBatch(MakeRobot(), MakeTargets(0)));
+  ASSERT_OK_AND_ASSIGN(
+      const MotionPlannerClient::FkBatchResult fk_result,
+      client.ComputeFkBatch(MakeRobot(), MakeJointValues(0),
+                            FrameByName("base"), FrameByName("flange")));
+
+  EXPECT_EQ(ik_result.solutions.cols(), 0);
+  EXPECT_THAT(ik_result.status, IsEmpty());
+  EXPECT_EQ(fk_result.poses.cols(), 0);
+  EXPECT_THAT(fk_result.status, IsEmpty());
+  EXPECT_THAT(server.service().answered_keys(), IsEmpty());
+}
+
+TEST(MotionPlannerClientBatchTest, RejectsNonPositiveMaxInFlight) {
+  FakeMotionPlannerServer server(kNumDof);
+  MotionPlannerClient client = server.MakeClient(kWorldId);
+
+  for (int max_in_flight : {0, -1}) {
+    EXPECT_THAT(client.ComputeIkBatch(MakeRobot(), MakeTargets(2), {},
+                                      {.max_in_flight = max_in_flight}),
+                StatusIs(absl::StatusCode::kInvalidArgument,
+                         HasSubstr("max_in_flight")));
+    EXPECT_THAT(
+        client.ComputeFkBatch(MakeRobot(), MakeJointValues(2),
+                              FrameByName("base"), FrameByName("flange"),
+                              {.max_in_flight = max_in_flight}),
+        StatusIs(absl::StatusCode::kInvalidArgument,
+                 HasSubstr("max_in_flight")));
+  }
+  EXPECT_THAT(server.service().answered_keys(), IsEmpty());
+}
+
+TEST(MotionPlannerClientBatchTest, RejectsStubsWithoutAsyncCalls) {
+  // Mock stubs don't implement async().
+  auto stub = std::make_shared<
+      intrinsic_proto::motion_planning::MockMotionPlannerServiceStub>();
+  MotionPlannerClient client(kWorldId, stub);
+
+  EXPECT_THAT(client.ComputeIkBatch(MakeRobot(), MakeTargets(2)),
+              StatusIs(absl::StatusCode::kUnimplemented));
+  EXPECT_THAT(client.ComputeFkBatch(MakeRobot(), MakeJointValues(2),
+                                    FrameByName("base"), FrameByName("flange")),
+              StatusIs(absl::StatusCode::kUnimplemented));
+}
+
+}  // namespace
+}  // namespace motion_planning
+}  // namespace intrinsic
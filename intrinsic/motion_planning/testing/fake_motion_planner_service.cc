@@ -0,0 +1,141 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/motion_planning/testing/fake_motion_planner_service.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "grpcpp/server.h"
+#include "grpcpp/server_builder.h"
+#include "grpcpp/server_context.h"
+#include "grpcpp/support/channel_arguments.h"
+#include "grpcpp/support/status.h"
+#include "intrinsic/eigenmath/types.h"
+#include "intrinsic/icon/proto/joint_space.pb.h"
+#include "intrinsic/math/pose3.h"
+#include "intrinsic/math/proto_conversion.h"
+#include "intrinsic/motion_planning/motion_planner_client.h"
+#include "intrinsic/motion_planning/proto/motion_planner_service.grpc.pb.h"
+#include "intrinsic/motion_planning/proto/motion_planner_service.pb.h"
+
+namespace intrinsic {
+namespace motion_planning {
+
+FakeMotionPlannerService::FakeMotionPlannerService(int num_dof,
+                                                   absl::Duration latency)
+    : num_dof_(num_dof), latency_(latency) {
+  CHECK_GE(num_dof_, 3);
+}
+
+grpc::Status FakeMotionPlannerService::ComputeFk(
+    grpc::ServerContext* context,
+    const intrinsic_proto::motion_planning::FkRequest* request,
+    intrinsic_proto::motion_planning::FkResponse* response) {
+  const auto& joints = request->joints().joints();
+  if (joints.size() != num_dof_) {
+    return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                        "Wrong number of joints.");
+  }
+  if (grpc::Status status = Answer(joints[0]); !status.ok()) {
+    return status;
+  }
+  *response->mutable_reference_t_target() =
+      ToProto(Pose3d(eigenmath::Vector3d(joints[0], joints[1], joints[2])));
+  return grpc::Status::OK;
+}
+
+grpc::Status FakeMotionPlannerService::ComputeIk(
+    grpc::ServerContext* context,
+    const intrinsic_proto::motion_planning::IkRequest* request,
+    intrinsic_proto::motion_planning::IkResponse* response) {
+  const double key =
+      request->target().pose_equality().target_frame_offset().position().x();
+  if (grpc::Status status = Answer(key); !status.ok()) {
+    return status;
+  }
+  {
+    absl::MutexLock lock(&mutex_);
+    if (keys_without_ik_solution_.contains(key)) {
+      return grpc::Status::OK;
+    }
+  }
+  intrinsic_proto::icon::JointVec* solution = response->add_solutions();
+  solution->add_joints(key);
+  for (int i = 1; i < num_dof_; ++i) {
+    solution->add_joints(0.0);
+  }
+  return grpc::Status::OK;
+}
+
+void FakeMotionPlannerService::SetLatency(double key, absl::Duration latency) {
+  absl::MutexLock lock(&mutex_);
+  latencies_[key] = latency;
+}
+
+void FakeMotionPlannerService::SetStatus(double key,
+                                         const grpc::Status& status) {
+  absl::MutexLock lock(&mutex_);
+  statuses_[key] = status;
+}
+
+void FakeMotionPlannerService::SetNoIkSolution(double key) {
+  absl::MutexLock lock(&mutex_);
+  keys_without_ik_solution_.insert(key);
+}
+
+std::vector<double> FakeMotionPlannerService::answered_keys() const {
+  absl::MutexLock lock(&mutex_);
+  return answered_keys_;
+}
+
+int FakeMotionPlannerService::max_calls_in_flight() const {
+  absl::MutexLock lock(&mutex_);
+  return max_calls_in_flight_;
+}
+
+grpc::Status FakeMotionPlannerService::Answer(double key) {
+  absl::Duration latency = latency_;
+  {
+    absl::MutexLock lock(&mutex_);
+    ++calls_in_flight_;
+    max_calls_in_flight_ = std::max(max_calls_in_flight_, calls_in_flight_);
+    if (auto it = latencies_.find(key); it != latencies_.end()) {
+      latency = it->second;
+    }
+  }
+  absl::SleepFor(latency);
+  absl::MutexLock lock(&mutex_);
+  --calls_in_flight_;
+  answered_keys_.push_back(key);
+  if (auto it = statuses_.find(key); it != statuses_.end()) {
+    return it->second;
+  }
+  return grpc::Status::OK;
+}
+
+FakeMotionPlannerServer::FakeMotionPlannerServer(int num_dof,
+                                                 absl::Duration latency)
+    : service_(num_dof, latency) {
+  grpc::ServerBuilder builder;
+  builder.RegisterService(&service_);
+  server_ = builder.BuildAndStart();
+  CHECK(server_ != nullptr);
+  stub_ = intrinsic_proto::motion_planning::MotionPlannerService::NewStub(
+      server_->InProcessChannel(grpc::ChannelArguments()));
+}
+
+FakeMotionPlannerServer::~FakeMotionPlannerServer() { server_->Shutdown(); }
+
+MotionPlannerClient FakeMotionPlannerServer::MakeClient(
+    absl::string_view world_id) const {
+  return MotionPlannerClient(world_id, stub_);
+}
+
+}  // namespace motion_planning
+}  // namespace intrinsic
@@ -0,0 +1,109 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#ifndef INTRINSIC_MOTION_PLANNING_TESTING_FAKE_MOTION_PLANNER_SERVICE_H_
+#define INTRINSIC_MOTION_PLANNING_TESTING_FAKE_MOTION_PLANNER_SERVICE_H_
+
+#include <memory>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "grpcpp/server.h"
+#include "grpcpp/server_context.h"
+#include "grpcpp/support/status.h"
+#include "intrinsic/motion_planning/motion_planner_client.h"
+#include "intrinsic/motion_planning/proto/motion_planner_service.grpc.pb.h"
+#include "intrinsic/motion_planning/proto/motion_planner_service.pb.h"
+
+namespace intrinsic {
+namespace motion_planning {
+
+// A motion planner service for tests and benchmarks of MotionPlannerClient,
+// which only implements ComputeFk and ComputeIk.
+//
+// ComputeFk answers with the first three joint values as the translation of
+// reference_t_target. ComputeIk answers with a single solution whose first
+// joint value is the x coordinate of the target frame offset. These values are
+// the keys of the calls, by which tests can select the latency and the outcome
+// of single calls.
+class FakeMotionPlannerService
+    : public intrinsic_proto::motion_planning::MotionPlannerService::Service {
+ public:
+  // Expects `num_dof` joints per ComputeFk call, returns `num_dof` joints per
+  // IK solution and sleeps for `latency` before each answer. `num_dof` must be
+  // at least 3.
+  explicit FakeMotionPlannerService(
+      int num_dof, absl::Duration latency = absl::ZeroDuration());
+
+  grpc::Status ComputeFk(
+      grpc::ServerContext* context,
+      const intrinsic_proto::motion_planning::FkRequest* request,
+      intrinsic_proto::motion_planning::FkResponse* response) override;
+
+  grpc::Status ComputeIk(
+      grpc::ServerContext* context,
+      const intrinsic_proto::motion_planning::IkRequest* request,
+      intrinsic_proto::motion_planning::IkResponse* response) override;
+
+  // Sleeps for `latency` instead of the default latency before answering the
+  // call with `key`.
+  void SetLatency(double key, absl::Duration latency);
+
+  // Ends the call with `key` with `status`.
+  void SetStatus(double key, const grpc::Status& status);
+
+  // Answers ComputeIk for `key` without a solution.
+  void SetNoIkSolution(double key);
+
+  // Returns the keys of all answered calls in the order of the answers.
+  std::vector<double> answered_keys() const;
+
+  // Returns the maximum number of calls that were in flight at once.
+  int max_calls_in_flight() const;
+
+ private:
+  // Sleeps and tracks the calls in flight. Returns the status of the call with
+  // `key`.
+  grpc::Status Answer(double key);
+
+  const int num_dof_;
+  const absl::Duration latency_;
+
+  mutable absl::Mutex mutex_;
+  absl::flat_hash_map<double, absl::Duration> latencies_
+      ABSL_GUARDED_BY(mutex_);
+  absl::flat_hash_map<double, grpc::Status> statuses_ ABSL_GUARDED_BY(mutex_);
+  absl::flat_hash_set<double> keys_without_ik_solution_ ABSL_GUARDED_BY(mutex_);
+  std::vector<double> answered_keys_ ABSL_GUARDED_BY(mutex_);
+  int calls_in_flight_ ABSL_GUARDED_BY(mutex_) = 0;
+  int max_calls_in_flight_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
+// Serves a FakeMotionPlannerService on an in-process channel.
+class FakeMotionPlannerServer {
+ public:
+  explicit FakeMotionPlannerServer(
+      int num_dof, absl::Duration latency = absl::ZeroDuration());
+  ~FakeMotionPlannerServer();
+
+  FakeMotionPlannerService& service() { return service_; }
+
+  // Returns a client for the world `world_id` which calls the fake service.
+  MotionPlannerClient MakeClient(absl::string_view world_id) const;
+
+ private:
+  FakeMotionPlannerService service_;
+  std::unique_ptr<grpc::Server> server_;
+  std::shared_ptr<
+      intrinsic_proto::motion_planning::MotionPlannerService::StubInterface>
+      stub_;
+};
+
+}  // namespace motion_planning
+}  // namespace intrinsic
+
+#endif  // INTRINSIC_MOTION_PLANNING_TESTING_FAKE_MOTION_PLANNER_SERVICE_H_
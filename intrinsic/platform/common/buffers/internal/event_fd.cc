@@ -41,8 +41,8 @@ bool EventFd::TestAndClear() const {
   return ret == sizeof(val);
 }
 
-void EventFd::Signal() const {
-  uint64_t val = 1;
+void EventFd::Signal(uint64_t count) const {
+  uint64_t val = count;
   // The manual says that the write size must be 8 bytes.
   int e = write(fd_, &val, 8);
   if (e < 0) {
@@ -29,8 +29,8 @@ class EventFd {
   // signaled.
   bool TestAndClear() const;
 
-  // Signals the EventFd.
-  void Signal() const;
+  // Signals the EventFd by adding `count` to its counter.
+  void Signal(uint64_t count = 1) const;
 
   // Reads the associated filed descriptor using a non-blocking read. Returns
   // the count in the file descriptor, or returns zero on EAGAIN. Resets the
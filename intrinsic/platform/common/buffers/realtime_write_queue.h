@@ -3,6 +3,7 @@
 #ifndef INTRINSIC_PLATFORM_COMMON_BUFFERS_REALTIME_WRITE_QUEUE_H_
 #define INTRINSIC_PLATFORM_COMMON_BUFFERS_REALTIME_WRITE_QUEUE_H_
 
+#include <algorithm>
 #include <cerrno>
 #include <cstddef>
 #include <cstdint>
@@ -10,12 +11,14 @@
 #include <optional>
 
 #include "absl/base/attributes.h"
+#include "absl/functional/function_ref.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/time/time.h"
 #include "absl/types/optional.h"
+#include "absl/types/span.h"
 #include "intrinsic/platform/common/buffers/internal/event_fd.h"
-#include "intrinsic/platform/common/buffers/rt_queue_buffer.h"
+#include "intrinsic/platform/common/buffers/spsc_ring_buffer.h"
 
 namespace intrinsic {
 
@@ -69,17 +72,48 @@ class RealtimeWriteQueue {
       return ReadWithTimeout(item, absl::InfiniteFuture());
     }
 
+    // Like ReadWithTimeout, but once items are available, copies up to
+    // `items.size()` of them into `items` and sets `count` to the number of
+    // items read. `count` is only meaningful if this returns kConsumed, in
+    // which case it is at least one. `items` must not be empty.
+    ABSL_MUST_USE_RESULT ReadResult ReadBatchWithTimeout(absl::Span<T> items,
+                                                         size_t& count,
+                                                         absl::Time deadline);
+
+    ABSL_MUST_USE_RESULT ReadResult ReadBatch(absl::Span<T> items,
+                                              size_t& count) {
+      return ReadBatchWithTimeout(items, count, absl::InfiniteFuture());
+    }
+
+    // Like ReadWithTimeout, but once items are available, calls `consumer` on
+    // every item signaled by the writer so far, in order and without copying
+    // them, and removes them from the queue.
+    ABSL_MUST_USE_RESULT ReadResult DrainIntoWithTimeout(
+        absl::FunctionRef<void(T&)> consumer, absl::Time deadline);
+
+    ABSL_MUST_USE_RESULT ReadResult
+    DrainInto(absl::FunctionRef<void(T&)> consumer) {
+      return DrainIntoWithTimeout(consumer, absl::InfiniteFuture());
+    }
+
     // Returns true when the buffer is empty.
     bool Empty() const { return buffer_.Empty(); }
 
    private:
     friend RealtimeWriteQueue;
-    explicit NonRtReader(internal::RtQueueBuffer<T>& buffer,
+    explicit NonRtReader(internal::SpscRingBuffer<T>& buffer,
                          internal::EventFd& count_event_fd,
                          internal::EventFd& closed_event_fd);
     void PollEvents(absl::Time deadline);
-
-    internal::RtQueueBuffer<T>& buffer_;
+    // Blocks until items are available, the queue is closed or `deadline` is
+    // reached. Returns kConsumed if `count_available_` is non-zero.
+    ReadResult WaitForItems(absl::Time deadline);
+    // Calls `consumer` on up to `max_count` available items, removes them and
+    // returns their number.
+    size_t ConsumeAvailable(size_t max_count,
+                            absl::FunctionRef<void(T&)> consumer);
+
+    internal::SpscRingBuffer<T>& buffer_;
     internal::EventFd& count_event_fd_;
     internal::EventFd& closed_event_fd_;
 
@@ -92,7 +126,26 @@ class RealtimeWriteQueue {
    public:
     // Returns true if the write succeeded. A write can fail if the queue is
     // full. It is invalid to call Write() after calling Close().
-    ABSL_MUST_USE_RESULT bool Write(const T& item);
+    ABSL_MUST_USE_RESULT bool Write(const T& item) {
+      return WriteBatch(absl::MakeConstSpan(&item, 1)) == 1;
+    }
+
+    // Copies as many of `items` into the queue as fit, in order, and wakes up
+    // the reader once for all of them. Returns the number of written items,
+    // which is less than `items.size()` if the queue is full. It is invalid to
+    // call WriteBatch() after calling Close().
+    ABSL_MUST_USE_RESULT size_t WriteBatch(absl::Span<const T> items);
+
+    // Gets up to `max_count` contiguous free elements, or an empty span if the
+    // queue is full. The span may hold fewer elements than are free. The
+    // elements should be set and then FinishInsertN must be called, which
+    // wakes up the reader once. It is invalid to call PrepareInsertN() after
+    // calling Close().
+    ABSL_MUST_USE_RESULT absl::Span<T> PrepareInsertN(size_t max_count);
+
+    // Makes the first `count` elements of the span returned by PrepareInsertN
+    // available to the reader.
+    void FinishInsertN(size_t count);
 
     // Marks the queue as 'closed', further attempts to Write() to the queue
     // are invalid.
@@ -103,10 +156,10 @@ class RealtimeWriteQueue {
 
    private:
     friend RealtimeWriteQueue;
-    explicit RtWriter(internal::RtQueueBuffer<T>& buffer,
+    explicit RtWriter(internal::SpscRingBuffer<T>& buffer,
                       internal::EventFd& count_event_fd,
                       internal::EventFd& closed_event_fd);
-    internal::RtQueueBuffer<T>& buffer_;
+    internal::SpscRingBuffer<T>& buffer_;
     internal::EventFd& count_event_fd_;
     internal::EventFd& closed_event_fd_;
 
@@ -124,7 +177,7 @@ class RealtimeWriteQueue {
  private:
   void InitEventFds();
 
-  internal::RtQueueBuffer<T> buffer_;
+  internal::SpscRingBuffer<T> buffer_;
   // A non-blocking eventfd to signal when and how many items are in the queue.
   internal::EventFd count_event_fd_;
   // A non-blocking eventfd to signal when the queue is closed.
@@ -137,6 +190,38 @@ class RealtimeWriteQueue {
 template <typename T>
 ReadResult RealtimeWriteQueue<T>::NonRtReader::ReadWithTimeout(
     T& item, absl::Time deadline) {
+  size_t count = 0;
+  return ReadBatchWithTimeout(absl::MakeSpan(&item, 1), count, deadline);
+}
+
+template <typename T>
+ReadResult RealtimeWriteQueue<T>::NonRtReader::ReadBatchWithTimeout(
+    absl::Span<T> items, size_t& count, absl::Time deadline) {
+  CHECK(!items.empty()) << "ReadBatch requires a non-empty output span";
+  ReadResult result = WaitForItems(deadline);
+  if (result != ReadResult::kConsumed) {
+    return result;
+  }
+  auto item_it = items.begin();
+  count = ConsumeAvailable(items.size(),
+                           [&item_it](T& element) { *item_it++ = element; });
+  return ReadResult::kConsumed;
+}
+
+template <typename T>
+ReadResult RealtimeWriteQueue<T>::NonRtReader::DrainIntoWithTimeout(
+    absl::FunctionRef<void(T&)> consumer, absl::Time deadline) {
+  ReadResult result = WaitForItems(deadline);
+  if (result != ReadResult::kConsumed) {
+    return result;
+  }
+  (void)ConsumeAvailable(count_available_, consumer);
+  return ReadResult::kConsumed;
+}
+
+template <typename T>
+ReadResult RealtimeWriteQueue<T>::NonRtReader::WaitForItems(
+    absl::Time deadline) {
   // Block until items are ready.
   if (count_available_ == 0 && closed_) {
     return ReadResult::kClosed;
@@ -153,22 +238,34 @@ ReadResult RealtimeWriteQueue<T>::NonRtReader::ReadWithTimeout(
   if (count_available_ == 0) {
     return ReadResult::kClosed;  // must have closed.
   }
-
-  T* element = buffer_.Front();
-  // This is guaranteed to never happen, since we check that
-  // `count_available_` is not zero before calling `buffer_.Front()`, and during
-  // Writer::Write() the count is incremented after inserting to the queue.
-  CHECK(element != nullptr) << "Attempted to read when no count_available_";
-  item = *element;
-  buffer_.DropFront();
-
-  count_available_--;
   return ReadResult::kConsumed;
 }
 
+template <typename T>
+size_t RealtimeWriteQueue<T>::NonRtReader::ConsumeAvailable(
+    size_t max_count, absl::FunctionRef<void(T&)> consumer) {
+  size_t consumed = 0;
+  // The available items are split into at most two contiguous ranges.
+  while (consumed < max_count && count_available_ > 0) {
+    absl::Span<T> elements =
+        buffer_.FrontN(std::min(max_count - consumed, count_available_));
+    // This is guaranteed to never happen, since `count_available_` is not
+    // zero, and during RtWriter::FinishInsertN() the count is incremented
+    // after inserting to the queue.
+    CHECK(!elements.empty()) << "Attempted to read when no count_available_";
+    for (T& element : elements) {
+      consumer(element);
+    }
+    buffer_.DropFrontN(elements.size());
+    consumed += elements.size();
+    count_available_ -= elements.size();
+  }
+  return consumed;
+}
+
 template <typename T>
 RealtimeWriteQueue<T>::NonRtReader::NonRtReader(
-    internal::RtQueueBuffer<T>& buffer, internal::EventFd& count_event_fd,
+    internal::SpscRingBuffer<T>& buffer, internal::EventFd& count_event_fd,
     internal::EventFd& closed_event_fd)
     : buffer_(buffer),
       count_event_fd_(count_event_fd),
@@ -200,16 +297,38 @@ void RealtimeWriteQueue<T>::NonRtReader::PollEvents(absl::Time deadline) {
 }
 
 template <typename T>
-bool RealtimeWriteQueue<T>::RtWriter::Write(const T& item) {
+size_t RealtimeWriteQueue<T>::RtWriter::WriteBatch(absl::Span<const T> items) {
   CHECK(!closed_) << "Invalid to Write() after Close()ing the queue";
-  T* element = buffer_.PrepareInsert();
-  if (element == nullptr) {
-    return false;
+  size_t written = 0;
+  // The free elements are split into at most two contiguous ranges.
+  while (written < items.size()) {
+    absl::Span<T> elements = buffer_.PrepareInsertN(items.size() - written);
+    if (elements.empty()) {
+      break;
+    }
+    std::copy_n(items.begin() + written, elements.size(), elements.begin());
+    buffer_.FinishInsertN(elements.size());
+    written += elements.size();
+  }
+  if (written > 0) {
+    count_event_fd_.Signal(written);
+  }
+  return written;
+}
+
+template <typename T>
+absl::Span<T> RealtimeWriteQueue<T>::RtWriter::PrepareInsertN(
+    size_t max_count) {
+  CHECK(!closed_) << "Invalid to Write() after Close()ing the queue";
+  return buffer_.PrepareInsertN(max_count);
+}
+
+template <typename T>
+void RealtimeWriteQueue<T>::RtWriter::FinishInsertN(size_t count) {
+  buffer_.FinishInsertN(count);
+  if (count > 0) {
+    count_event_fd_.Signal(count);
   }
-  *element = item;
-  buffer_.FinishInsert();
-  count_event_fd_.Signal();
-  return true;
 }
 
 template <typename T>
@@ -224,7 +343,7 @@ bool RealtimeWriteQueue<T>::RtWriter::Closed() const {
 }
 
 template <typename T>
-RealtimeWriteQueue<T>::RtWriter::RtWriter(internal::RtQueueBuffer<T>& buffer,
+RealtimeWriteQueue<T>::RtWriter::RtWriter(internal::SpscRingBuffer<T>& buffer,
                                           internal::EventFd& count_event_fd,
                                           internal::EventFd& closed_event_fd)
     : buffer_(buffer),
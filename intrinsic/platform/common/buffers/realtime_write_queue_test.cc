@@ -0,0 +1,117 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/platform/common/buffers/realtime_write_queue.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "intrinsic/util/testing/gtest_wrapper.h"
+#include "intrinsic/util/thread/thread.h"
+
+namespace intrinsic {
+namespace {
+
+using ::testing::ElementsAre;
+
+TEST(RealtimeWriteQueueTest, SingleWriteAndRead) {
+  RealtimeWriteQueue<int> queue;
+  ASSERT_TRUE(queue.Writer().Write(5));
+  int value = 0;
+  ASSERT_EQ(queue.Reader().Read(value), ReadResult::kConsumed);
+  EXPECT_EQ(value, 5);
+  EXPECT_EQ(queue.Reader().ReadWithTimeout(value, absl::Now()),
+            ReadResult::kDeadlineExceeded);
+}
+
+TEST(RealtimeWriteQueueTest, WriteBatchStopsWhenFull) {
+  RealtimeWriteQueue<int> queue(/*capacity=*/3);
+  const std::array<int, 5> items = {1, 2, 3, 4, 5};
+  EXPECT_EQ(queue.Writer().WriteBatch(items), 3);
+  EXPECT_EQ(queue.Writer().WriteBatch(items), 0);
+}
+
+TEST(RealtimeWriteQueueTest, ReadBatchReadsAcrossWrapAround) {
+  RealtimeWriteQueue<int> queue(/*capacity=*/4);
+  std::array<int, 4> out;
+  size_t count = 0;
+
+  // Advance the indices so that the next batch wraps around the storage.
+  ASSERT_EQ(queue.Writer().WriteBatch(std::array<int, 3>{0, 0, 0}), 3);
+  ASSERT_EQ(queue.Reader().ReadBatch(absl::MakeSpan(out), count),
+            ReadResult::kConsumed);
+  ASSERT_EQ(count, 3);
+
+  ASSERT_EQ(queue.Writer().WriteBatch(std::array<int, 4>{1, 2, 3, 4}), 4);
+  ASSERT_EQ(queue.Reader().ReadBatch(absl::MakeSpan(out), count),
+            ReadResult::kConsumed);
+  EXPECT_EQ(count, 4);
+  EXPECT_THAT(out, ElementsAre(1, 2, 3, 4));
+}
+
+TEST(RealtimeWriteQueueTest, DrainIntoConsumesAllSignaledItems) {
+  RealtimeWriteQueue<int> queue(/*capacity=*/8);
+  ASSERT_EQ(queue.Writer().WriteBatch(std::array<int, 3>{1, 2, 3}), 3);
+  ASSERT_TRUE(queue.Writer().Write(4));
+
+  std::vector<int> drained;
+  ASSERT_EQ(queue.Reader().DrainInto([&drained](int& v) {
+    drained.push_back(v);
+  }),
+            ReadResult::kConsumed);
+  EXPECT_THAT(drained, ElementsAre(1, 2, 3, 4));
+  EXPECT_TRUE(queue.Reader().Empty());
+}
+
+TEST(RealtimeWriteQueueTest, PrepareAndFinishInsertN) {
+  RealtimeWriteQueue<int> queue(/*capacity=*/4);
+  absl::Span<int> elements = queue.Writer().PrepareInsertN(2);
+  ASSERT_EQ(elements.size(), 2);
+  elements[0] = 7;
+  elements[1] = 8;
+  queue.Writer().FinishInsertN(2);
+
+  std::array<int, 4> out;
+  size_t count = 0;
+  ASSERT_EQ(queue.Reader().ReadBatch(absl::MakeSpan(out), count),
+            ReadResult::kConsumed);
+  EXPECT_EQ(count, 2);
+  EXPECT_EQ(out[0], 7);
+  EXPECT_EQ(out[1], 8);
+}
+
+TEST(RealtimeWriteQueueTest, ReportsClosedAfterDrainingBatches) {
+  constexpr int kNumBatches = 100;
+  constexpr int kBatchSize = 10;
+  RealtimeWriteQueue<int> queue(/*capacity=*/kBatchSize * kNumBatches);
+
+  intrinsic::Thread writer([&queue]() {
+    std::array<int, kBatchSize> batch;
+    for (int b = 0; b < kNumBatches; ++b) {
+      for (int i = 0; i < kBatchSize; ++i) {
+        batch[i] = b * kBatchSize + i;
+      }
+      EXPECT_EQ(queue.Writer().WriteBatch(batch),
+                static_cast<size_t>(kBatchSize));
+    }
+    queue.Writer().Close();
+  });
+
+  int expected = 0;
+  while (queue.Reader().DrainInto([&expected](int& v) {
+    EXPECT_EQ(v, expected);
+    ++expected;
+  }) == ReadResult::kConsumed) {
+  }
+  writer.Join();
+  EXPECT_EQ(expected, kBatchSize * kNumBatches);
+}
+
+}  // namespace
+}  // namespace intrinsic
@@ -0,0 +1,345 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#ifndef INTRINSIC_PLATFORM_COMMON_BUFFERS_RT_MPSC_QUEUE_H_
+#define INTRINSIC_PLATFORM_COMMON_BUFFERS_RT_MPSC_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "absl/base/attributes.h"
+#include "absl/base/optimization.h"
+#include "absl/functional/function_ref.h"
+#include "absl/log/check.h"
+#include "intrinsic/icon/utils/realtime_guard.h"
+
+namespace intrinsic {
+
+// Implementation of a Realtime-safe multi-producer single-consumer queue.
+//
+// This is a bounded first-in-first-out (FIFO) lock-free queue. Any number of
+// threads, including realtime threads, may write to it concurrently, and a
+// single thread reads from it. Each slot carries a sequence number that tells
+// producers whether the slot is free and the consumer whether it has been
+// published, so producers only contend on a single atomic index and never
+// block each other.
+//
+// Like RealtimeQueue, elements are recycled without any reset or clearing and
+// can be accessed without copying:
+//
+// RealtimeMpscQueue<MyProtoType> queue(/*capacity=*/64);
+//
+// // On any number of writing threads.
+// MyProtoType* item = queue.writer()->PrepareInsert();
+// if (item) {  // nullptr if queue is full.
+//   item->set_...;
+//   queue.writer()->FinishInsert(item);
+// }
+//
+// // On the reading thread.
+// const MyProtoType* item = queue.reader()->Front();
+// if (item) {  // nullptr if queue is empty.
+//   DoSomething(*item);
+//   queue.reader()->DropFront();  // or KeepFront() to leave item in queue.
+// }
+//
+// Unlike RealtimeQueue, FinishInsert takes the pointer returned by
+// PrepareInsert, since several inserts may be in progress at the same time.
+// A writer must call FinishInsert for every non-null result of PrepareInsert;
+// the reader cannot see any later element until it does.
+//
+// The capacity is rounded up to the next power of two (and at least 2).
+template <typename T>
+class RealtimeMpscQueue {
+ public:
+  // Reader accesses and removes elements from the queue.
+  // It is thread-safe with respect to writers, and thread-compatible for
+  // multiple reading threads.
+  class Reader {
+   public:
+    // Not copyable or moveable.
+    Reader(const Reader&) = delete;
+    Reader(Reader&&) = delete;
+
+    using value_type = T;
+
+    // Gets a pointer to the front element, or nullptr if no element has been
+    // published yet. If not empty, KeepFront, or DropFront, must be called
+    // before another call to Front is allowed.
+    ABSL_MUST_USE_RESULT T* Front();
+    // Keeps the front element. This signals that leaving that element in place
+    // is deliberate, and allows Front to be called again.
+    void KeepFront();
+    // Removes the front element and makes its slot available to writers.
+    void DropFront();
+    // Removes and returns a copy of the first element, or nullopt if empty.
+    // Due to the copy, this is not realtime safe for non-trivially-copyable
+    // objects; use Front/DropFront for realtime safety with non-trivial types.
+    ABSL_MUST_USE_RESULT std::optional<T> Pop();
+    // Returns true when the front element has not been published yet. Writers
+    // that are between PrepareInsert and FinishInsert can make this return
+    // true even if Size() is not zero.
+    bool Empty() const;
+
+   private:
+    friend RealtimeMpscQueue;
+    explicit Reader(RealtimeMpscQueue& queue) : queue_(queue) {}
+    RealtimeMpscQueue& queue_;
+    bool front_accessed_ = false;
+  };
+
+  // Writer adds elements to the queue.
+  // It is thread-safe, i.e. it may be shared by any number of writing threads.
+  class Writer {
+   public:
+    using value_type = T;
+
+    // Not copyable or moveable.
+    Writer(const Writer&) = delete;
+    Writer(Writer&&) = delete;
+
+    // Claims the next available element and returns a pointer to it, or
+    // nullptr if the queue is full. The element should be set and then
+    // FinishInsert must be called with the returned pointer.
+    ABSL_MUST_USE_RESULT T* PrepareInsert();
+    // Makes `element`, which must have been returned by PrepareInsert,
+    // available to the reader.
+    void FinishInsert(T* element);
+    // Moves `item` into the queue and returns true if there is space, or
+    // false if the queue was full. Realtime safe if T's move assignment is.
+    ABSL_MUST_USE_RESULT bool Insert(T&& item);
+    // Copies `item` into the queue and returns true if there is space, or
+    // false if the queue was full. Due to the copy, this is not realtime safe
+    // for non-trivially-copyable objects; use PrepareInsert/FinishInsert for
+    // realtime safety with non-trivial types.
+    ABSL_MUST_USE_RESULT bool Insert(const T& item);
+    // Sets a function which is called by PrepareInsert to reset the recycled
+    // element before it's inserted. Must not be called concurrently with
+    // PrepareInsert.
+    void SetElementResetFunction(std::function<void(T*)> reset_function) {
+      reset_function_ = reset_function;
+    }
+
+   private:
+    friend RealtimeMpscQueue;
+    explicit Writer(RealtimeMpscQueue& queue) : queue_(queue) {}
+    RealtimeMpscQueue& queue_;
+    std::function<void(T*)> reset_function_ = nullptr;
+  };
+
+  static constexpr size_t kDefaultBufferCapacity = 128;
+  using value_type = T;
+
+  // Not copyable or moveable (that would invalidate the reader/writer).
+  RealtimeMpscQueue(const RealtimeMpscQueue&) = delete;
+  RealtimeMpscQueue(RealtimeMpscQueue&&) = delete;
+
+  explicit RealtimeMpscQueue(std::optional<size_t> capacity = std::nullopt,
+                             std::function<void(T*)> init_function = nullptr);
+
+  // Get a pointer to the reader.
+  Reader* reader() { return &reader_; }
+
+  // Get a pointer to the writer.
+  Writer* writer() { return &writer_; }
+
+  // Initialize all the elements in the buffer. This function is not thread-safe
+  // and cannot be called concurrently with read/write operations.
+  void InitElements(absl::FunctionRef<void(T*)> init_function) {
+    for (size_t i = 0; i < Capacity(); ++i) {
+      init_function(&elements_[i]);
+    }
+  }
+
+  // Returns the number of claimed elements, including those that are still
+  // being written. Thread-safe, but only a snapshot under concurrent access.
+  size_t Size() const {
+    const size_t dequeue_pos = dequeue_pos_.load(std::memory_order_acquire);
+    const size_t enqueue_pos = enqueue_pos_.load(std::memory_order_acquire);
+    return enqueue_pos - dequeue_pos;
+  }
+
+  // Returns true when all elements are claimed. Thread-safe.
+  bool Full() const { return Size() >= Capacity(); }
+
+  // Returns the capacity of the queue.
+  size_t Capacity() const { return mask_ + 1; }
+
+ private:
+  // Sequence number of a slot, on its own cache line so that producers
+  // publishing neighboring slots don't interfere with each other.
+  //
+  // For the slot at position `pos` (modulo capacity), a sequence of
+  //  * `pos` means the slot is free for the writer that claims `pos`,
+  //  * `pos + 1` means it holds a published element for the reader,
+  //  * `pos + capacity` means the reader has released it for the next round.
+  struct alignas(ABSL_CACHELINE_SIZE) Sequence {
+    std::atomic_size_t value;
+  };
+
+  // Returns the smallest power of two that is >= `capacity` and at least 2.
+  static size_t StorageSize(size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    return size;
+  }
+
+  // Next position to be claimed by a writer. Shared by all writers.
+  alignas(ABSL_CACHELINE_SIZE) std::atomic_size_t enqueue_pos_ = 0;
+  // Next position to be read. Only written by the reader.
+  alignas(ABSL_CACHELINE_SIZE) std::atomic_size_t dequeue_pos_ = 0;
+
+  alignas(ABSL_CACHELINE_SIZE) const size_t mask_;
+  std::unique_ptr<Sequence[]> sequences_;
+  std::unique_ptr<T[]> elements_;
+
+  Reader reader_;
+  Writer writer_;
+};
+
+template <typename T>
+RealtimeMpscQueue<T>::RealtimeMpscQueue(std::optional<size_t> capacity,
+                                        std::function<void(T*)> init_function)
+    : mask_(StorageSize(capacity.value_or(kDefaultBufferCapacity)) - 1),
+      sequences_(std::make_unique<Sequence[]>(mask_ + 1)),
+      elements_(std::make_unique<T[]>(mask_ + 1)),
+      reader_(*this),
+      writer_(*this) {
+  for (size_t i = 0; i <= mask_; ++i) {
+    sequences_[i].value.store(i, std::memory_order_relaxed);
+  }
+  if (init_function != nullptr) {
+    InitElements(init_function);
+  }
+}
+
+template <typename T>
+T* RealtimeMpscQueue<T>::Reader::Front() {
+  CHECK(!front_accessed_)
+      << "KeepFront or DropFront must be called before another "
+         "call to Front is allowed.";
+  const size_t pos = queue_.dequeue_pos_.load(std::memory_order_relaxed);
+  const size_t index = pos & queue_.mask_;
+  if (queue_.sequences_[index].value.load(std::memory_order_acquire) !=
+      pos + 1) {
+    return nullptr;
+  }
+  front_accessed_ = true;
+  return &queue_.elements_[index];
+}
+
+template <typename T>
+void RealtimeMpscQueue<T>::Reader::KeepFront() {
+  CHECK(front_accessed_) << "Front must be called before KeepFront.";
+  front_accessed_ = false;
+}
+
+template <typename T>
+void RealtimeMpscQueue<T>::Reader::DropFront() {
+  CHECK(front_accessed_) << "Front must be called before DropFront.";
+  front_accessed_ = false;
+  const size_t pos = queue_.dequeue_pos_.load(std::memory_order_relaxed);
+  queue_.sequences_[pos & queue_.mask_].value.store(
+      pos + queue_.mask_ + 1, std::memory_order_release);
+  queue_.dequeue_pos_.store(pos + 1, std::memory_order_release);
+}
+
+template <typename T>
+bool RealtimeMpscQueue<T>::Reader::Empty() const {
+  const size_t pos = queue_.dequeue_pos_.load(std::memory_order_relaxed);
+  return queue_.sequences_[pos & queue_.mask_].value.load(
+             std::memory_order_acquire) != pos + 1;
+}
+
+template <typename T>
+std::optional<T> RealtimeMpscQueue<T>::Reader::Pop() {
+  if (!std::is_trivially_copyable<T>::value) {
+    INTRINSIC_ASSERT_NON_REALTIME();
+  }
+  const T* front_ptr = Front();
+  if (front_ptr) {
+    T front = *front_ptr;
+    DropFront();
+    return front;
+  } else {
+    return std::nullopt;
+  }
+}
+
+template <typename T>
+T* RealtimeMpscQueue<T>::Writer::PrepareInsert() {
+  size_t pos = queue_.enqueue_pos_.load(std::memory_order_relaxed);
+  while (true) {
+    const size_t index = pos & queue_.mask_;
+    const size_t sequence =
+        queue_.sequences_[index].value.load(std::memory_order_acquire);
+    const intptr_t difference =
+        static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+    if (difference == 0) {
+      // The slot is free; try to claim it. On failure, `pos` is updated to the
+      // current value and we retry.
+      if (queue_.enqueue_pos_.compare_exchange_weak(
+              pos, pos + 1, std::memory_order_relaxed)) {
+        T* element = &queue_.elements_[index];
+        if (reset_function_) {
+          reset_function_(element);
+        }
+        return element;
+      }
+    } else if (difference < 0) {
+      // The reader has not released this slot from the previous round yet.
+      return nullptr;
+    } else {
+      // Another writer claimed `pos` in the meantime.
+      pos = queue_.enqueue_pos_.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+template <typename T>
+void RealtimeMpscQueue<T>::Writer::FinishInsert(T* element) {
+  CHECK(element != nullptr) << "FinishInsert called with nullptr.";
+  const size_t index = element - queue_.elements_.get();
+  CHECK(index <= queue_.mask_)
+      << "FinishInsert called with an element that is not part of the queue.";
+  std::atomic_size_t& sequence = queue_.sequences_[index].value;
+  // While the element is claimed, only this writer touches its sequence.
+  sequence.store(sequence.load(std::memory_order_relaxed) + 1,
+                 std::memory_order_release);
+}
+
+template <typename T>
+bool RealtimeMpscQueue<T>::Writer::Insert(T&& item) {
+  T* element = PrepareInsert();
+  if (element == nullptr) {
+    return false;
+  }
+  *element = std::move(item);
+  FinishInsert(element);
+  return true;
+}
+
+template <typename T>
+bool RealtimeMpscQueue<T>::Writer::Insert(const T& item) {
+  if (!std::is_trivially_copyable<T>::value) {
+    INTRINSIC_ASSERT_NON_REALTIME();
+  }
+  T* element = PrepareInsert();
+  if (element == nullptr) {
+    return false;
+  }
+  *element = item;
+  FinishInsert(element);
+  return true;
+}
+
+}  // namespace intrinsic
+
+#endif  // INTRINSIC_PLATFORM_COMMON_BUFFERS_RT_MPSC_QUEUE_H_
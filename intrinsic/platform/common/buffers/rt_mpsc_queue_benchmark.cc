@@ -0,0 +1,111 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+// Compares RealtimeMpscQueue with a RealtimeQueue behind the mutex-based
+// RealtimeQueueMultiWriter when 1 to N producer threads feed a single
+// consumer.
+//
+// Run with `bazel run -c opt` for meaningful numbers.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "intrinsic/platform/common/buffers/rt_mpsc_queue.h"
+#include "intrinsic/platform/common/buffers/rt_queue.h"
+#include "intrinsic/platform/common/buffers/rt_queue_multi_writer.h"
+#include "intrinsic/util/thread/thread.h"
+
+namespace intrinsic {
+namespace {
+
+constexpr size_t kCapacity = 1024;
+constexpr int64_t kItemsPerIteration = 1024;
+
+// Runs `state.range(0)` producers calling `insert` in a loop until the
+// benchmark is done, while the benchmark thread consumes with `consume`.
+// `consume` returns true if it removed an element.
+template <typename InsertFn, typename ConsumeFn>
+void RunProducersAndConsumer(benchmark::State& state, InsertFn insert,
+                             ConsumeFn consume) {
+  std::atomic_bool stop = false;
+  std::vector<intrinsic::Thread> producers;
+  for (int64_t p = 0; p < state.range(0); ++p) {
+    producers.emplace_back([&stop, &insert, p]() {
+      uint64_t value = static_cast<uint64_t>(p) << 32;
+      while (!stop.load(std::memory_order_relaxed)) {
+        if (insert(value)) {
+          ++value;
+        }
+      }
+    });
+  }
+
+  for (auto _ : state) {
+    for (int64_t received = 0; received < kItemsPerIteration;) {
+      if (consume()) {
+        ++received;
+      }
+    }
+  }
+  stop.store(true, std::memory_order_relaxed);
+  for (intrinsic::Thread& producer : producers) {
+    producer.Join();
+  }
+  state.SetItemsProcessed(state.iterations() * kItemsPerIteration);
+}
+
+void BM_RealtimeMpscQueue(benchmark::State& state) {
+  RealtimeMpscQueue<uint64_t> queue(kCapacity);
+  RunProducersAndConsumer(
+      state,
+      [&queue](uint64_t value) {
+        uint64_t* element = queue.writer()->PrepareInsert();
+        if (element == nullptr) {
+          return false;
+        }
+        *element = value;
+        queue.writer()->FinishInsert(element);
+        return true;
+      },
+      [&queue]() {
+        uint64_t* front = queue.reader()->Front();
+        if (front == nullptr) {
+          return false;
+        }
+        benchmark::DoNotOptimize(*front);
+        queue.reader()->DropFront();
+        return true;
+      });
+}
+BENCHMARK(BM_RealtimeMpscQueue)
+    ->RangeMultiplier(2)
+    ->Range(1, 16)
+    ->UseRealTime();
+
+void BM_RealtimeQueueMultiWriter(benchmark::State& state) {
+  RealtimeQueue<uint64_t> queue(kCapacity);
+  RealtimeQueueMultiWriter<uint64_t> writer(*queue.writer());
+  RunProducersAndConsumer(
+      state,
+      [&writer](uint64_t value) {
+        return writer.Insert(std::move(value)).ok();
+      },
+      [&queue]() {
+        uint64_t* front = queue.reader()->Front();
+        if (front == nullptr) {
+          return false;
+        }
+        benchmark::DoNotOptimize(*front);
+        queue.reader()->DropFront();
+        return true;
+      });
+}
+BENCHMARK(BM_RealtimeQueueMultiWriter)
+    ->RangeMultiplier(2)
+    ->Range(1, 16)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace intrinsic
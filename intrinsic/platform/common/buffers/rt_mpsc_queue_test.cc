@@ -0,0 +1,119 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/platform/common/buffers/rt_mpsc_queue.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "intrinsic/util/testing/gtest_wrapper.h"
+#include "intrinsic/util/thread/thread.h"
+
+namespace intrinsic {
+namespace {
+
+using ::testing::NotNull;
+using ::testing::Optional;
+
+TEST(RealtimeMpscQueueTest, SingleInsert) {
+  RealtimeMpscQueue<int> queue;
+  ASSERT_TRUE(queue.writer()->Insert(123));
+  EXPECT_EQ(queue.Size(), 1);
+  EXPECT_THAT(queue.reader()->Pop(), Optional(123));
+  EXPECT_TRUE(queue.reader()->Empty());
+}
+
+TEST(RealtimeMpscQueueTest, RoundsCapacityUpToPowerOfTwo) {
+  EXPECT_EQ(RealtimeMpscQueue<int>(/*capacity=*/1).Capacity(), 2);
+  EXPECT_EQ(RealtimeMpscQueue<int>(/*capacity=*/5).Capacity(), 8);
+  EXPECT_EQ(RealtimeMpscQueue<int>(/*capacity=*/16).Capacity(), 16);
+}
+
+TEST(RealtimeMpscQueueTest, ReportsFullQueue) {
+  RealtimeMpscQueue<int> queue(/*capacity=*/2);
+  ASSERT_TRUE(queue.writer()->Insert(1));
+  ASSERT_TRUE(queue.writer()->Insert(2));
+  EXPECT_TRUE(queue.Full());
+  EXPECT_FALSE(queue.writer()->Insert(3));
+
+  EXPECT_THAT(queue.reader()->Pop(), Optional(1));
+  EXPECT_TRUE(queue.writer()->Insert(3));
+  EXPECT_THAT(queue.reader()->Pop(), Optional(2));
+  EXPECT_THAT(queue.reader()->Pop(), Optional(3));
+}
+
+TEST(RealtimeMpscQueueTest, ReaderWaitsForUnfinishedInsert) {
+  RealtimeMpscQueue<int> queue(/*capacity=*/4);
+  int* first = queue.writer()->PrepareInsert();
+  ASSERT_THAT(first, NotNull());
+  int* second = queue.writer()->PrepareInsert();
+  ASSERT_THAT(second, NotNull());
+  *second = 2;
+  queue.writer()->FinishInsert(second);
+
+  // The first claimed element blocks the ones behind it.
+  EXPECT_TRUE(queue.reader()->Empty());
+  EXPECT_EQ(queue.reader()->Front(), nullptr);
+  EXPECT_EQ(queue.Size(), 2);
+
+  *first = 1;
+  queue.writer()->FinishInsert(first);
+  EXPECT_THAT(queue.reader()->Pop(), Optional(1));
+  EXPECT_THAT(queue.reader()->Pop(), Optional(2));
+}
+
+TEST(RealtimeMpscQueueTest, KeepFrontLeavesElementInPlace) {
+  RealtimeMpscQueue<int> queue;
+  ASSERT_TRUE(queue.writer()->Insert(42));
+  int* front = queue.reader()->Front();
+  ASSERT_THAT(front, NotNull());
+  queue.reader()->KeepFront();
+  EXPECT_THAT(queue.reader()->Pop(), Optional(42));
+}
+
+TEST(RealtimeMpscQueueTest, ConcurrentInsert) {
+  constexpr int kNumWriters = 4;
+  constexpr int kItemsPerWriter = 1000;
+  // Use a non-trivially-copyable type to make things a bit harder.
+  RealtimeMpscQueue<std::unique_ptr<int>> queue(/*capacity=*/16);
+
+  std::vector<intrinsic::Thread> writers;
+  for (int w = 0; w < kNumWriters; ++w) {
+    writers.emplace_back([&queue, w]() {
+      for (int i = 0; i < kItemsPerWriter; ++i) {
+        auto item = std::make_unique<int>(w * kItemsPerWriter + i);
+        while (!queue.writer()->Insert(std::move(item))) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+
+  // Items of each writer must arrive in order, and all of them must arrive.
+  std::vector<int> next_per_writer(kNumWriters, 0);
+  int received = 0;
+  while (received < kNumWriters * kItemsPerWriter) {
+    std::unique_ptr<int>* front = queue.reader()->Front();
+    if (front == nullptr) {
+      std::this_thread::yield();
+      continue;
+    }
+    const int writer = **front / kItemsPerWriter;
+    EXPECT_EQ(**front % kItemsPerWriter, next_per_writer[writer]);
+    ++next_per_writer[writer];
+    queue.reader()->DropFront();
+    ++received;
+  }
+  for (intrinsic::Thread& writer : writers) {
+    writer.Join();
+  }
+  EXPECT_TRUE(queue.reader()->Empty());
+  EXPECT_EQ(queue.Size(), 0);
+}
+
+}  // namespace
+}  // namespace intrinsic
@@ -17,7 +17,7 @@
 #include "intrinsic/icon/utils/realtime_status.h"
 #include "intrinsic/icon/utils/realtime_status_macro.h"
 #include "intrinsic/icon/utils/realtime_status_or.h"
-#include "intrinsic/platform/common/buffers/rt_queue_buffer.h"
+#include "intrinsic/platform/common/buffers/spsc_ring_buffer.h"
 
 namespace intrinsic {
 
@@ -182,7 +182,7 @@ class RealtimePromise {
   // Constructor.
   // Does not take ownership of any pointers, thus all pointers must outlive the
   // promise.
-  RealtimePromise(internal::RtQueueBuffer<T>* buffer,
+  RealtimePromise(internal::SpscRingBuffer<T>* buffer,
                   icon::BinaryFutex* is_ready,
                   icon::BinaryFutex* is_cancel_acknowledged,
                   icon::BinaryFutex* is_destroyed,
@@ -194,7 +194,7 @@ class RealtimePromise {
         is_cancelled_(is_cancelled) {}
 
   // The buffer used for passing the value from the promise to the future.
-  internal::RtQueueBuffer<T>* buffer_ = nullptr;
+  internal::SpscRingBuffer<T>* buffer_ = nullptr;
   // The future waits on this to receive a value.
   icon::BinaryFutex* is_ready_ = nullptr;
   // The future waits on this to make sure the promise has received a cancel
@@ -352,7 +352,7 @@ class NonRealtimeFuture {
   }
 
   // Used for passing the value from the promise to the future.
-  internal::RtQueueBuffer<T> buffer_;
+  internal::SpscRingBuffer<T> buffer_;
   // Used by the future to wait for the value (and the promise to set the
   // value).
   icon::BinaryFutex is_ready_;
@@ -3,6 +3,7 @@
 #ifndef INTRINSIC_PLATFORM_COMMON_BUFFERS_RT_QUEUE_H_
 #define INTRINSIC_PLATFORM_COMMON_BUFFERS_RT_QUEUE_H_
 
+#include <algorithm>
 #include <cstddef>
 #include <functional>
 #include <optional>
@@ -11,8 +12,9 @@
 #include "absl/base/attributes.h"
 #include "absl/functional/function_ref.h"
 #include "absl/types/optional.h"
+#include "absl/types/span.h"
 #include "intrinsic/icon/utils/realtime_guard.h"
-#include "intrinsic/platform/common/buffers/rt_queue_buffer.h"
+#include "intrinsic/platform/common/buffers/spsc_ring_buffer.h"
 
 namespace intrinsic {
 
@@ -83,6 +85,17 @@ class RealtimeQueueBase {
 // You may mix the access methods too- eg, a non-realtime writing thread can
 // use Insert while a realtime reading thread uses Front/DropFront.
 //
+// To move many elements at once, use the batch variants. They publish or
+// release a whole range of elements with one atomic index update:
+//
+// absl::Span<MyProtoType> items = writer->PrepareInsertN(16);
+// for (MyProtoType& item : items) {  // empty if queue is full.
+//   item.set_...;
+// }
+// writer->FinishInsertN(items.size());
+//
+// reader->DrainInto([](MyProtoType& item) { DoSomething(item); });
+//
 // The Reader and Writer classes are thread compatible, so you can have multiple
 // non-realtime readers or writers by protecting their access with an external
 // mutex. It is not possible to have multiple realtime readers or writers.
@@ -116,10 +129,30 @@ class RealtimeQueue : public RealtimeQueueBase {
     // Returns true when the buffer is empty.
     bool Empty() const { return buffer_.Empty(); }
 
+    // Gets up to `max_count` contiguous elements from the front of the queue,
+    // or an empty span if the queue is empty. The span may hold fewer elements
+    // than are available (e.g. when they wrap around the end of the internal
+    // storage). If not empty, KeepFront or DropFrontN must be called before
+    // another call to Front/FrontN is allowed.
+    ABSL_MUST_USE_RESULT absl::Span<T> FrontN(size_t max_count) {
+      return buffer_.FrontN(max_count);
+    }
+    // Removes the first `count` elements of the span returned by FrontN.
+    void DropFrontN(size_t count) { buffer_.DropFrontN(count); }
+    // Removes up to `items.size()` elements from the queue and copies them into
+    // `items`. Returns the number of elements read. Due to the copy, this is
+    // not realtime safe for non-trivially-copyable objects; use FrontN/
+    // DropFrontN or DrainInto for realtime safety with non-trivial types.
+    ABSL_MUST_USE_RESULT size_t ReadBatch(absl::Span<T> items);
+    // Calls `consumer` on every element that is currently in the queue, in
+    // order, and removes them. Returns the number of consumed elements. This
+    // does not copy elements, so it is realtime safe if `consumer` is.
+    size_t DrainInto(absl::FunctionRef<void(T&)> consumer);
+
    private:
     friend RealtimeQueue;
-    explicit Reader(internal::RtQueueBuffer<T>& buffer) : buffer_(buffer) {}
-    internal::RtQueueBuffer<T>& buffer_;
+    explicit Reader(internal::SpscRingBuffer<T>& buffer) : buffer_(buffer) {}
+    internal::SpscRingBuffer<T>& buffer_;
   };
 
   // Writer adds elements to the queue.
@@ -136,20 +169,38 @@ class RealtimeQueue : public RealtimeQueueBase {
     // Gets a pointer to the next available element, or nullptr if the queue is
     // full. The element should be set and then FinishInsert must be called.
     ABSL_MUST_USE_RESULT T* PrepareInsert() {
-      T* element = buffer_.PrepareInsert();
-      if (reset_function_) {
-        reset_function_(element);
-      }
-      return element;
+      absl::Span<T> elements = PrepareInsertN(1);
+      return elements.empty() ? nullptr : elements.data();
     }
     // Make the element referenced by the return value of PrepareInsert
     // available to the reader.
     void FinishInsert() { buffer_.FinishInsert(); }
+    // Gets up to `max_count` contiguous free elements, or an empty span if the
+    // queue is full. The span may hold fewer elements than are free (e.g. when
+    // they wrap around the end of the internal storage). If not empty, the
+    // elements should be set and then FinishInsertN must be called.
+    ABSL_MUST_USE_RESULT absl::Span<T> PrepareInsertN(size_t max_count) {
+      absl::Span<T> elements = buffer_.PrepareInsertN(max_count);
+      if (reset_function_) {
+        for (T& element : elements) {
+          reset_function_(&element);
+        }
+      }
+      return elements;
+    }
+    // Makes the first `count` elements of the span returned by PrepareInsertN
+    // available to the reader.
+    void FinishInsertN(size_t count) { buffer_.FinishInsertN(count); }
     // Copy item into the queue and return true if there is space, or false if
     // it was not copied because the queue was full. Due to the copy, this is
     // not realtime safe for non-trivially-copyable objects; use
     // PrepareInsert/FinishInsert for realtime safety with non-trivial types.
-    ABSL_MUST_USE_RESULT bool Insert(const T& item);
+    ABSL_MUST_USE_RESULT bool Insert(const T& item) {
+      return InsertBatch(absl::MakeConstSpan(&item, 1)) == 1;
+    }
+    // Copies as many of `items` into the queue as fit, in order, and returns
+    // the number of copied items. Same realtime considerations as Insert.
+    ABSL_MUST_USE_RESULT size_t InsertBatch(absl::Span<const T> items);
     // Sets a function which is called by PrepareInsert to reset the recycled
     // element before it's inserted.
     void SetElementResetFunction(std::function<void(T*)> reset_function) {
@@ -158,8 +209,8 @@ class RealtimeQueue : public RealtimeQueueBase {
 
    private:
     friend RealtimeQueue;
-    explicit Writer(internal::RtQueueBuffer<T>& buffer) : buffer_(buffer) {}
-    internal::RtQueueBuffer<T>& buffer_;
+    explicit Writer(internal::SpscRingBuffer<T>& buffer) : buffer_(buffer) {}
+    internal::SpscRingBuffer<T>& buffer_;
     std::function<void(T*)> reset_function_ = nullptr;
   };
 
@@ -198,7 +249,7 @@ class RealtimeQueue : public RealtimeQueueBase {
   size_t Capacity() const { return buffer_.Capacity(); }
 
  private:
-  internal::RtQueueBuffer<T> buffer_;
+  internal::SpscRingBuffer<T> buffer_;
 
   Reader reader_;
   Writer writer_;
@@ -232,18 +283,59 @@ std::optional<T> RealtimeQueue<T>::Reader::Pop() {
 }
 
 template <typename T>
-bool RealtimeQueue<T>::Writer::Insert(const T& item) {
+size_t RealtimeQueue<T>::Reader::ReadBatch(absl::Span<T> items) {
   if (!std::is_trivially_copyable<T>::value) {
     INTRINSIC_ASSERT_NON_REALTIME();
   }
-  T* item_ptr = PrepareInsert();
-  if (item_ptr) {
-    *item_ptr = item;
-    FinishInsert();
-    return true;
-  } else {
-    return false;
+  size_t read = 0;
+  // At most two iterations, since the available elements are split into at
+  // most two contiguous ranges.
+  while (read < items.size()) {
+    absl::Span<T> front = buffer_.FrontN(items.size() - read);
+    if (front.empty()) {
+      break;
+    }
+    std::copy(front.begin(), front.end(), items.begin() + read);
+    buffer_.DropFrontN(front.size());
+    read += front.size();
+  }
+  return read;
+}
+
+template <typename T>
+size_t RealtimeQueue<T>::Reader::DrainInto(
+    absl::FunctionRef<void(T&)> consumer) {
+  size_t drained = 0;
+  while (true) {
+    absl::Span<T> front = buffer_.FrontN(buffer_.Capacity());
+    if (front.empty()) {
+      break;
+    }
+    for (T& element : front) {
+      consumer(element);
+    }
+    buffer_.DropFrontN(front.size());
+    drained += front.size();
+  }
+  return drained;
+}
+
+template <typename T>
+size_t RealtimeQueue<T>::Writer::InsertBatch(absl::Span<const T> items) {
+  if (!std::is_trivially_copyable<T>::value) {
+    INTRINSIC_ASSERT_NON_REALTIME();
+  }
+  size_t inserted = 0;
+  while (inserted < items.size()) {
+    absl::Span<T> elements = PrepareInsertN(items.size() - inserted);
+    if (elements.empty()) {
+      break;
+    }
+    std::copy_n(items.begin() + inserted, elements.size(), elements.begin());
+    FinishInsertN(elements.size());
+    inserted += elements.size();
   }
+  return inserted;
 }
 
 }  // namespace intrinsic
@@ -15,6 +15,9 @@ namespace intrinsic {
 // multiple concurrent writers. In doing this, we drop the realtime safety of
 // the write operation. Any readers of the RealtimeQueue are of course still
 // realtime safe.
+//
+// Prefer RealtimeMpscQueue (rt_mpsc_queue.h) for new code. It supports
+// concurrent writers without a mutex, including realtime ones.
 template <class T>
 class RealtimeQueueMultiWriter {
  public:
@@ -0,0 +1,189 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#ifndef INTRINSIC_PLATFORM_COMMON_BUFFERS_SPSC_BYTE_RING_H_
+#define INTRINSIC_PLATFORM_COMMON_BUFFERS_SPSC_BYTE_RING_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+#include "absl/base/attributes.h"
+#include "absl/base/optimization.h"
+#include "absl/log/check.h"
+#include "absl/types/span.h"
+
+namespace intrinsic {
+
+// A single-producer single-consumer ring buffer for variable-length records.
+//
+// Every record is stored contiguously, prefixed by its size and padded to
+// `kAlignment` bytes. If a record doesn't fit into the space left before the
+// end of the storage, the producer marks that space as padding and writes the
+// record at the start of the storage instead. The consumer skips padding
+// transparently.
+//
+// Like SpscRingBuffer, producer and consumer own a monotonically increasing
+// byte index each, on separate cache lines, and only reload the opposite index
+// when their cached copy says the ring is full/empty.
+//
+// PrepareWrite/CommitWrite must only be called by the producer and
+// Front/DropFront only by the consumer. Empty and Capacity are thread-safe.
+// All calls are realtime safe.
+class SpscByteRing {
+ public:
+  // Alignment of every record.
+  static constexpr size_t kAlignment = 8;
+
+  // Creates a ring with `capacity` bytes, rounded up to the next power of two.
+  // Each record occupies its size plus `kAlignment` bytes for the header,
+  // rounded up to a multiple of `kAlignment`.
+  explicit SpscByteRing(size_t capacity)
+      : capacity_(StorageSize(capacity)),
+        mask_(capacity_ - 1),
+        buffer_(new(std::align_val_t{kAlignment}) uint8_t[capacity_]) {}
+
+  SpscByteRing(const SpscByteRing&) = delete;
+  SpscByteRing& operator=(const SpscByteRing&) = delete;
+
+  // Returns `size` contiguous bytes for the next record, or nullptr if there
+  // is not enough space. The bytes are aligned to `kAlignment`. The record is
+  // published by CommitWrite(). A prepared record that isn't committed is
+  // discarded by the next call to PrepareWrite().
+  ABSL_MUST_USE_RESULT uint8_t* PrepareWrite(size_t size);
+
+  // Publishes the record returned by the preceding PrepareWrite() call.
+  void CommitWrite();
+
+  // Returns the oldest record, or an empty span if there is none. After
+  // reading the record, the consumer must call DropFront().
+  ABSL_MUST_USE_RESULT absl::Span<const uint8_t> Front();
+
+  // Releases the record returned by the preceding Front() call.
+  void DropFront();
+
+  // Returns true if there are no records. Thread-safe.
+  bool Empty() const {
+    return consumer_.tail.load(std::memory_order_acquire) ==
+           producer_.head.load(std::memory_order_acquire);
+  }
+
+  // Returns the size of the storage in bytes.
+  size_t Capacity() const { return capacity_; }
+
+ private:
+  // Marks the remainder of the storage as padding.
+  static constexpr uint64_t kPaddingSize = ~uint64_t{0};
+
+  static constexpr size_t AlignUp(size_t size) {
+    return (size + kAlignment - 1) & ~(kAlignment - 1);
+  }
+
+  static size_t StorageSize(size_t capacity) {
+    size_t size = 2 * kAlignment;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    return size;
+  }
+
+  struct BufferDeleter {
+    void operator()(uint8_t* buffer) const {
+      ::operator delete[](buffer, std::align_val_t{kAlignment});
+    }
+  };
+
+  // State written by the producer only.
+  struct alignas(ABSL_CACHELINE_SIZE) ProducerState {
+    std::atomic<uint64_t> head = 0;
+    // Last value of `consumer_.tail` observed by the producer.
+    uint64_t cached_tail = 0;
+    // Value of `head` after the pending record, or 0 if there is none.
+    uint64_t pending_head = 0;
+  };
+
+  // State written by the consumer only.
+  struct alignas(ABSL_CACHELINE_SIZE) ConsumerState {
+    std::atomic<uint64_t> tail = 0;
+    // Last value of `producer_.head` observed by the consumer.
+    uint64_t cached_head = 0;
+    // Value of `tail` after the record returned by Front(), or 0 if none.
+    uint64_t front_end = 0;
+  };
+
+  ProducerState producer_;
+  ConsumerState consumer_;
+
+  // Read-only after construction; kept off the producer/consumer lines.
+  alignas(ABSL_CACHELINE_SIZE) const size_t capacity_;
+  const size_t mask_;
+  std::unique_ptr<uint8_t[], BufferDeleter> buffer_;
+};
+
+inline uint8_t* SpscByteRing::PrepareWrite(size_t size) {
+  const size_t record_size = kAlignment + AlignUp(size);
+  if (ABSL_PREDICT_FALSE(record_size > capacity_)) {
+    return nullptr;
+  }
+  const uint64_t head = producer_.head.load(std::memory_order_relaxed);
+  const size_t position = head & mask_;
+  const size_t until_end = capacity_ - position;
+  // Records never wrap around, so skip the rest of the storage if needed.
+  const size_t padding = record_size > until_end ? until_end : 0;
+  const size_t required = padding + record_size;
+  if (capacity_ - (head - producer_.cached_tail) < required) {
+    producer_.cached_tail = consumer_.tail.load(std::memory_order_acquire);
+    if (capacity_ - (head - producer_.cached_tail) < required) {
+      return nullptr;
+    }
+  }
+  if (padding > 0) {
+    std::memcpy(&buffer_[position], &kPaddingSize, sizeof(kPaddingSize));
+  }
+  uint8_t* record = &buffer_[(head + padding) & mask_];
+  const uint64_t record_payload_size = size;
+  std::memcpy(record, &record_payload_size, sizeof(record_payload_size));
+  producer_.pending_head = head + required;
+  return record + kAlignment;
+}
+
+inline void SpscByteRing::CommitWrite() {
+  CHECK_NE(producer_.pending_head, 0)
+      << "PrepareWrite must be called before CommitWrite.";
+  producer_.head.store(producer_.pending_head, std::memory_order_release);
+  producer_.pending_head = 0;
+}
+
+inline absl::Span<const uint8_t> SpscByteRing::Front() {
+  CHECK_EQ(consumer_.front_end, 0)
+      << "DropFront must be called before another call to Front is allowed.";
+  uint64_t tail = consumer_.tail.load(std::memory_order_relaxed);
+  if (consumer_.cached_head == tail) {
+    consumer_.cached_head = producer_.head.load(std::memory_order_acquire);
+    if (consumer_.cached_head == tail) {
+      return {};
+    }
+  }
+  const size_t position = tail & mask_;
+  uint64_t size;
+  std::memcpy(&size, &buffer_[position], sizeof(size));
+  if (size == kPaddingSize) {
+    // A record follows at the start of the storage.
+    tail += capacity_ - position;
+    std::memcpy(&size, &buffer_[0], sizeof(size));
+  }
+  consumer_.front_end = tail + kAlignment + AlignUp(size);
+  return absl::MakeConstSpan(&buffer_[(tail & mask_) + kAlignment], size);
+}
+
+inline void SpscByteRing::DropFront() {
+  CHECK_NE(consumer_.front_end, 0)
+      << "Front must be called before DropFront.";
+  consumer_.tail.store(consumer_.front_end, std::memory_order_release);
+  consumer_.front_end = 0;
+}
+
+}  // namespace intrinsic
+
+#endif  // INTRINSIC_PLATFORM_COMMON_BUFFERS_SPSC_BYTE_RING_H_
@@ -0,0 +1,142 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/platform/common/buffers/spsc_byte_ring.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "intrinsic/util/testing/gtest_wrapper.h"
+#include "intrinsic/util/thread/thread.h"
+
+namespace intrinsic {
+namespace {
+
+using ::testing::IsNull;
+using ::testing::NotNull;
+
+bool Write(SpscByteRing& ring, absl::string_view data) {
+  uint8_t* record = ring.PrepareWrite(data.size());
+  if (record == nullptr) {
+    return false;
+  }
+  std::memcpy(record, data.data(), data.size());
+  ring.CommitWrite();
+  return true;
+}
+
+std::string Read(SpscByteRing& ring) {
+  absl::Span<const uint8_t> record = ring.Front();
+  std::string data(record.begin(), record.end());
+  if (!record.empty()) {
+    ring.DropFront();
+  }
+  return data;
+}
+
+TEST(SpscByteRingTest, RoundsCapacityUpToPowerOfTwo) {
+  EXPECT_EQ(SpscByteRing(/*capacity=*/0).Capacity(), 16);
+  EXPECT_EQ(SpscByteRing(/*capacity=*/100).Capacity(), 128);
+  EXPECT_EQ(SpscByteRing(/*capacity=*/128).Capacity(), 128);
+}
+
+TEST(SpscByteRingTest, ReturnsRecordsInOrder) {
+  SpscByteRing ring(/*capacity=*/128);
+  EXPECT_TRUE(ring.Empty());
+  EXPECT_TRUE(ring.Front().empty());
+  ASSERT_TRUE(Write(ring, "first"));
+  ASSERT_TRUE(Write(ring, "second record"));
+  EXPECT_FALSE(ring.Empty());
+  EXPECT_EQ(Read(ring), "first");
+  EXPECT_EQ(Read(ring), "second record");
+  EXPECT_TRUE(ring.Empty());
+}
+
+TEST(SpscByteRingTest, AlignsRecords) {
+  SpscByteRing ring(/*capacity=*/128);
+  for (size_t size : {1, 3, 8, 13}) {
+    uint8_t* record = ring.PrepareWrite(size);
+    ASSERT_THAT(record, NotNull());
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(record) % SpscByteRing::kAlignment,
+              0);
+    ring.CommitWrite();
+  }
+}
+
+TEST(SpscByteRingTest, RejectsRecordsThatDontFit) {
+  SpscByteRing ring(/*capacity=*/64);
+  // Every record needs 8 bytes for its header.
+  EXPECT_THAT(ring.PrepareWrite(57), IsNull());
+  ASSERT_TRUE(Write(ring, std::string(24, 'a')));
+  // 32 bytes are used, 32 bytes are left.
+  EXPECT_THAT(ring.PrepareWrite(25), IsNull());
+  ASSERT_TRUE(Write(ring, std::string(24, 'b')));
+  EXPECT_THAT(ring.PrepareWrite(0), IsNull());
+  EXPECT_EQ(Read(ring), std::string(24, 'a'));
+  EXPECT_TRUE(Write(ring, std::string(20, 'c')));
+}
+
+TEST(SpscByteRingTest, SkipsPaddingAtEndOfStorage) {
+  SpscByteRing ring(/*capacity=*/64);
+  ASSERT_TRUE(Write(ring, std::string(32, 'a')));
+  EXPECT_EQ(Read(ring), std::string(32, 'a'));
+  // 24 bytes are left before the end of the storage, so the record has to
+  // start at the beginning and the remaining bytes become padding.
+  ASSERT_TRUE(Write(ring, std::string(24, 'b')));
+  EXPECT_EQ(Read(ring), std::string(24, 'b'));
+  EXPECT_TRUE(ring.Empty());
+}
+
+TEST(SpscByteRingTest, DiscardsUncommittedRecord) {
+  SpscByteRing ring(/*capacity=*/64);
+  ASSERT_THAT(ring.PrepareWrite(8), NotNull());
+  EXPECT_TRUE(ring.Empty());
+  ASSERT_TRUE(Write(ring, "kept"));
+  EXPECT_EQ(Read(ring), "kept");
+  EXPECT_TRUE(ring.Empty());
+}
+
+TEST(SpscByteRingTest, TransfersRecordsBetweenThreads) {
+  SpscByteRing ring(/*capacity=*/256);
+  constexpr uint32_t kNumRecords = 20000;
+  intrinsic::Thread producer([&ring]() {
+    for (uint32_t i = 0; i < kNumRecords;) {
+      // Records of varying size exercise the padding at the end.
+      const size_t size = sizeof(i) + i % 23;
+      uint8_t* record = ring.PrepareWrite(size);
+      if (record == nullptr) {
+        std::this_thread::yield();
+        continue;
+      }
+      std::memset(record, 0, size);
+      std::memcpy(record, &i, sizeof(i));
+      ring.CommitWrite();
+      ++i;
+    }
+  });
+  for (uint32_t expected = 0; expected < kNumRecords;) {
+    absl::Span<const uint8_t> record = ring.Front();
+    if (record.empty()) {
+      std::this_thread::yield();
+      continue;
+    }
+    ASSERT_EQ(record.size(), sizeof(expected) + expected % 23);
+    uint32_t value;
+    std::memcpy(&value, record.data(), sizeof(value));
+    ASSERT_EQ(value, expected);
+    ring.DropFront();
+    ++expected;
+  }
+  producer.Join();
+  EXPECT_TRUE(ring.Empty());
+}
+
+}  // namespace
+}  // namespace intrinsic
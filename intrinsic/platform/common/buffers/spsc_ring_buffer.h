@@ -0,0 +1,280 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#ifndef INTRINSIC_PLATFORM_COMMON_BUFFERS_SPSC_RING_BUFFER_H_
+#define INTRINSIC_PLATFORM_COMMON_BUFFERS_SPSC_RING_BUFFER_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+#include "absl/base/attributes.h"
+#include "absl/base/optimization.h"
+#include "absl/functional/function_ref.h"
+#include "absl/log/check.h"
+#include "absl/types/span.h"
+
+// IWYU pragma: no_forward_declare absl::FunctionRef
+
+namespace intrinsic {
+namespace internal {
+
+// A single-producer single-consumer ring buffer with the same interface as
+// RtQueueBuffer.
+//
+// Unlike RtQueueBuffer, producer and consumer never write to a shared counter:
+//  * The producer owns `head_` and the consumer owns `tail_`. Both are
+//    monotonically increasing and live on separate cache lines, together with
+//    the state that is private to the respective side.
+//  * Each side keeps a cached copy of the opposite index and only reloads it
+//    (with acquire semantics) when the cached value says the buffer is
+//    full/empty. In steady state this avoids touching the other side's cache
+//    line at all.
+//  * Indices are mapped to slots with a mask. The storage is rounded up to the
+//    next power of two, while `Capacity()` still reports the requested
+//    capacity, so `Full()` behaves exactly like it does for RtQueueBuffer.
+//
+// The batch variants (FrontN/DropFrontN and PrepareInsertN/FinishInsertN)
+// publish or release a whole range of elements with a single index update;
+// the single element calls are implemented on top of them.
+//
+// Front(N)/DropFront(N)/KeepFront must only be called by the consumer and
+// PrepareInsert(N)/FinishInsert(N) only by the producer.
+// Size/Empty/Full/Capacity are thread-safe.
+template <typename T>
+class SpscRingBuffer {
+ public:
+  explicit SpscRingBuffer(size_t capacity);
+
+  SpscRingBuffer(size_t capacity, absl::FunctionRef<void(T*)> init_function);
+
+  // Gets a pointer to the front element, or nullptr if empty. After a call to
+  // Front(), must call DropFront() or KeepFront() prior to subsequent calls to
+  // Front().
+  ABSL_MUST_USE_RESULT T* Front();
+
+  // Removes the front element; no-op if the queue is empty.
+  void DropFront();
+
+  // Keeps the front element.
+  void KeepFront();
+
+  // Gets a pointer to the next available element, or nullptr if the queue is
+  // full. The element should be set and then FinishInsert must be called.
+  ABSL_MUST_USE_RESULT T* PrepareInsert();
+
+  // Make the element referenced by the return value of PrepareInsert
+  // available to the reader.
+  void FinishInsert();
+
+  // Gets up to `max_count` contiguous elements starting at the front. The
+  // returned span is empty if the buffer is empty, and may be shorter than the
+  // number of available elements when they wrap around the end of the
+  // storage. If not empty, DropFrontN or KeepFront must be called before
+  // another call to Front/FrontN is allowed.
+  ABSL_MUST_USE_RESULT absl::Span<T> FrontN(size_t max_count);
+
+  // Removes the first `count` elements returned by the preceding FrontN call.
+  // `count` may be smaller than the size of that span. DropFrontN(0) is a
+  // no-op if FrontN returned an empty span.
+  void DropFrontN(size_t count);
+
+  // Gets up to `max_count` contiguous free elements. The returned span is empty
+  // if the buffer is full, and may be shorter than the number of free elements
+  // when they wrap around the end of the storage. If not empty, the elements
+  // should be set and then FinishInsertN must be called.
+  ABSL_MUST_USE_RESULT absl::Span<T> PrepareInsertN(size_t max_count);
+
+  // Makes the first `count` elements returned by the preceding PrepareInsertN
+  // call available to the reader. `count` may be smaller than the size of that
+  // span, including zero. FinishInsertN(0) is a no-op if PrepareInsertN
+  // returned an empty span.
+  void FinishInsertN(size_t count);
+
+  // Returns the number of elements in the buffer. Thread-safe.
+  size_t Size() const {
+    // Load the consumer index first. The producer index can only grow, so the
+    // difference is never negative, but it may overshoot if the consumer
+    // advanced in between.
+    const size_t tail = consumer_.tail.load(std::memory_order_acquire);
+    const size_t head = producer_.head.load(std::memory_order_acquire);
+    return std::min(head - tail, capacity_);
+  }
+
+  // Returns true when the buffer is empty. Thread-safe.
+  bool Empty() const { return Size() == 0; }
+
+  // Returns true when the buffer is full. Thread-safe.
+  bool Full() const { return Size() == capacity_; }
+
+  // Returns the capacity of the buffer.
+  size_t Capacity() const { return capacity_; }
+
+  void InitElements(absl::FunctionRef<void(T*)> init_function);
+
+ private:
+  // Returns the smallest power of two that is >= `capacity` (and at least 1).
+  static size_t StorageSize(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    return size;
+  }
+
+  // State written by the producer only.
+  struct alignas(ABSL_CACHELINE_SIZE) ProducerState {
+    std::atomic_size_t head = 0;
+    // Last value of `consumer_.tail` observed by the producer.
+    size_t cached_tail = 0;
+    bool insert_in_progress = false;
+    // Number of elements handed out by the pending PrepareInsert(N) call.
+    size_t prepared_count = 0;
+  };
+
+  // State written by the consumer only.
+  struct alignas(ABSL_CACHELINE_SIZE) ConsumerState {
+    std::atomic_size_t tail = 0;
+    // Last value of `producer_.head` observed by the consumer.
+    size_t cached_head = 0;
+    bool front_accessed = false;
+    // Number of elements handed out by the pending Front(N) call.
+    size_t accessed_count = 0;
+  };
+
+  ProducerState producer_;
+  ConsumerState consumer_;
+
+  // Read-only after construction; kept off the producer/consumer lines.
+  alignas(ABSL_CACHELINE_SIZE) const size_t capacity_;
+  const size_t mask_;
+  std::unique_ptr<T[]> buffer_;
+};
+
+template <typename T>
+SpscRingBuffer<T>::SpscRingBuffer(size_t capacity)
+    : capacity_(capacity),
+      mask_(StorageSize(capacity) - 1),
+      buffer_(std::make_unique<T[]>(mask_ + 1)) {}
+
+template <typename T>
+SpscRingBuffer<T>::SpscRingBuffer(size_t capacity,
+                                  absl::FunctionRef<void(T*)> init_function)
+    : SpscRingBuffer(capacity) {
+  InitElements(init_function);
+}
+
+template <typename T>
+void SpscRingBuffer<T>::InitElements(
+    absl::FunctionRef<void(T*)> init_function) {
+  for (size_t i = 0; i <= mask_; ++i) {
+    init_function(&buffer_[i]);
+  }
+}
+
+template <typename T>
+T* SpscRingBuffer<T>::Front() {
+  absl::Span<T> front = FrontN(1);
+  return front.empty() ? nullptr : front.data();
+}
+
+template <typename T>
+void SpscRingBuffer<T>::KeepFront() {
+  CHECK(consumer_.front_accessed) << "Front must be called before KeepFront.";
+  consumer_.front_accessed = false;
+  consumer_.accessed_count = 0;
+}
+
+template <typename T>
+void SpscRingBuffer<T>::DropFront() {
+  CHECK(consumer_.front_accessed) << "Front must be called before DropFront.";
+  DropFrontN(1);
+}
+
+template <typename T>
+absl::Span<T> SpscRingBuffer<T>::FrontN(size_t max_count) {
+  CHECK(!consumer_.front_accessed)
+      << "KeepFront or DropFront must be called before another "
+         "call to Front is allowed.";
+  const size_t tail = consumer_.tail.load(std::memory_order_relaxed);
+  if (consumer_.cached_head - tail < max_count) {
+    consumer_.cached_head = producer_.head.load(std::memory_order_acquire);
+  }
+  const size_t index = tail & mask_;
+  const size_t count = std::min({max_count, consumer_.cached_head - tail,
+                                 mask_ + 1 - index});
+  if (count == 0) {
+    return {};
+  }
+  consumer_.front_accessed = true;
+  consumer_.accessed_count = count;
+  return absl::MakeSpan(&buffer_[index], count);
+}
+
+template <typename T>
+void SpscRingBuffer<T>::DropFrontN(size_t count) {
+  if (count == 0 && !consumer_.front_accessed) {
+    return;
+  }
+  CHECK(consumer_.front_accessed) << "FrontN must be called before DropFrontN.";
+  CHECK(count <= consumer_.accessed_count)
+      << "Cannot drop more elements than returned by FrontN.";
+  consumer_.front_accessed = false;
+  consumer_.accessed_count = 0;
+  consumer_.tail.store(consumer_.tail.load(std::memory_order_relaxed) + count,
+                       std::memory_order_release);
+}
+
+template <typename T>
+T* SpscRingBuffer<T>::PrepareInsert() {
+  absl::Span<T> free = PrepareInsertN(1);
+  return free.empty() ? nullptr : free.data();
+}
+
+template <typename T>
+void SpscRingBuffer<T>::FinishInsert() {
+  CHECK(producer_.insert_in_progress)
+      << "PrepareInsert must be called before FinishInsert.";
+  FinishInsertN(1);
+}
+
+template <typename T>
+absl::Span<T> SpscRingBuffer<T>::PrepareInsertN(size_t max_count) {
+  CHECK(!producer_.insert_in_progress)
+      << "FinishInsert must be called before another call to "
+         "PrepareInsert is allowed.";
+  const size_t head = producer_.head.load(std::memory_order_relaxed);
+  if (capacity_ - (head - producer_.cached_tail) < max_count) {
+    producer_.cached_tail = consumer_.tail.load(std::memory_order_acquire);
+  }
+  const size_t index = head & mask_;
+  const size_t count =
+      std::min({max_count, capacity_ - (head - producer_.cached_tail),
+                mask_ + 1 - index});
+  if (count == 0) {
+    return {};
+  }
+  producer_.insert_in_progress = true;
+  producer_.prepared_count = count;
+  return absl::MakeSpan(&buffer_[index], count);
+}
+
+template <typename T>
+void SpscRingBuffer<T>::FinishInsertN(size_t count) {
+  if (count == 0 && !producer_.insert_in_progress) {
+    return;
+  }
+  CHECK(producer_.insert_in_progress)
+      << "PrepareInsertN must be called before FinishInsertN.";
+  CHECK(count <= producer_.prepared_count)
+      << "Cannot finish more elements than returned by PrepareInsertN.";
+  producer_.insert_in_progress = false;
+  producer_.prepared_count = 0;
+  producer_.head.store(producer_.head.load(std::memory_order_relaxed) + count,
+                       std::memory_order_release);
+}
+
+}  // namespace internal
+}  // namespace intrinsic
+
+#endif  // INTRINSIC_PLATFORM_COMMON_BUFFERS_SPSC_RING_BUFFER_H_
@@ -0,0 +1,122 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+// Compares the throughput of internal::SpscRingBuffer with the previous
+// internal::RtQueueBuffer when a producer and a consumer run on different
+// threads.
+//
+// Run with e.g.
+//   bazel run -c opt \
+//     //intrinsic/platform/common/buffers:spsc_ring_buffer_benchmark
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "benchmark/benchmark.h"
+#include "intrinsic/platform/common/buffers/rt_queue_buffer.h"
+#include "intrinsic/platform/common/buffers/spsc_ring_buffer.h"
+#include "intrinsic/util/thread/thread.h"
+
+namespace intrinsic::internal {
+namespace {
+
+// An element of `kSize` bytes, the first eight of which carry a sequence
+// number.
+template <size_t kSize>
+struct Element {
+  static_assert(kSize >= sizeof(uint64_t));
+  uint64_t sequence;
+  std::array<uint8_t, kSize - sizeof(uint64_t)> payload;
+};
+
+// Pushes state.range(0)-sized batches of elements through a buffer of
+// capacity state.range(1). The producer runs on a separate thread, the
+// consumer is the benchmark thread.
+template <template <typename> class Buffer, size_t kElementSize>
+void BM_ProducerConsumer(benchmark::State& state) {
+  using ElementT = Element<kElementSize>;
+  const int64_t items_per_iteration = state.range(0);
+  Buffer<ElementT> buffer(static_cast<size_t>(state.range(1)));
+  std::atomic_bool stop = false;
+
+  intrinsic::Thread producer([&buffer, &stop]() {
+    uint64_t sequence = 0;
+    while (!stop.load(std::memory_order_relaxed)) {
+      ElementT* element = buffer.PrepareInsert();
+      if (element == nullptr) {
+        continue;
+      }
+      element->sequence = sequence++;
+      element->payload[0] = static_cast<uint8_t>(sequence);
+      buffer.FinishInsert();
+    }
+  });
+
+  for (auto _ : state) {
+    for (int64_t received = 0; received < items_per_iteration;) {
+      ElementT* front = buffer.Front();
+      if (front == nullptr) {
+        continue;
+      }
+      benchmark::DoNotOptimize(front->sequence);
+      buffer.DropFront();
+      ++received;
+    }
+  }
+  stop.store(true, std::memory_order_relaxed);
+  producer.Join();
+
+  state.SetItemsProcessed(state.iterations() * items_per_iteration);
+  state.SetBytesProcessed(state.iterations() * items_per_iteration *
+                          kElementSize);
+}
+
+// Single-threaded insert followed by drop, i.e. the uncontended cost of one
+// round trip through the buffer.
+template <template <typename> class Buffer, size_t kElementSize>
+void BM_InsertDropSingleThread(benchmark::State& state) {
+  using ElementT = Element<kElementSize>;
+  Buffer<ElementT> buffer(static_cast<size_t>(state.range(0)));
+  uint64_t sequence = 0;
+  for (auto _ : state) {
+    ElementT* element = buffer.PrepareInsert();
+    element->sequence = sequence++;
+    buffer.FinishInsert();
+    ElementT* front = buffer.Front();
+    benchmark::DoNotOptimize(front->sequence);
+    buffer.DropFront();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+void ProducerConsumerArgs(benchmark::internal::Benchmark* b) {
+  for (int64_t capacity : {16, 100, 1024, 4096}) {
+    b->Args({/*items_per_iteration=*/1024, capacity});
+  }
+  b->UseRealTime();
+}
+
+void SingleThreadArgs(benchmark::internal::Benchmark* b) {
+  for (int64_t capacity : {16, 100, 1024}) {
+    b->Arg(capacity);
+  }
+}
+
+#define INTRINSIC_REGISTER_BUFFER_BENCHMARKS(size)                         \
+  BENCHMARK(BM_ProducerConsumer<RtQueueBuffer, size>)                      \
+      ->Apply(ProducerConsumerArgs);                                       \
+  BENCHMARK(BM_ProducerConsumer<SpscRingBuffer, size>)                     \
+      ->Apply(ProducerConsumerArgs);                                       \
+  BENCHMARK(BM_InsertDropSingleThread<RtQueueBuffer, size>)                \
+      ->Apply(SingleThreadArgs);                                           \
+  BENCHMARK(BM_InsertDropSingleThread<SpscRingBuffer, size>)               \
+      ->Apply(SingleThreadArgs)
+
+INTRINSIC_REGISTER_BUFFER_BENCHMARKS(16);
+INTRINSIC_REGISTER_BUFFER_BENCHMARKS(64);
+INTRINSIC_REGISTER_BUFFER_BENCHMARKS(512);
+INTRINSIC_REGISTER_BUFFER_BENCHMARKS(2048);
+
+}  // namespace
+}  // namespace intrinsic::internal
@@ -0,0 +1,180 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/platform/common/buffers/spsc_ring_buffer.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <thread>  // NOLINT(build/c++11)
+
+#include "absl/types/span.h"
+#include "intrinsic/util/testing/gtest_wrapper.h"
+#include "intrinsic/util/thread/thread.h"
+
+namespace intrinsic::internal {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::NotNull;
+
+TEST(SpscRingBufferTest, KeepsRequestedCapacityForNonPowerOfTwo) {
+  SpscRingBuffer<int> buffer(/*capacity=*/3);
+  EXPECT_EQ(buffer.Capacity(), 3);
+  for (int i = 0; i < 3; ++i) {
+    int* element = buffer.PrepareInsert();
+    ASSERT_THAT(element, NotNull());
+    *element = i;
+    buffer.FinishInsert();
+  }
+  EXPECT_TRUE(buffer.Full());
+  EXPECT_EQ(buffer.Size(), 3);
+  EXPECT_EQ(buffer.PrepareInsert(), nullptr);
+}
+
+TEST(SpscRingBufferTest, ZeroCapacityIsAlwaysFull) {
+  SpscRingBuffer<int> buffer(/*capacity=*/0);
+  EXPECT_TRUE(buffer.Full());
+  EXPECT_TRUE(buffer.Empty());
+  EXPECT_EQ(buffer.PrepareInsert(), nullptr);
+  EXPECT_EQ(buffer.Front(), nullptr);
+}
+
+TEST(SpscRingBufferTest, WrapsAroundInOrder) {
+  SpscRingBuffer<int> buffer(/*capacity=*/5);
+  int next_write = 0;
+  int next_read = 0;
+  // Run enough rounds to wrap the indices around the storage several times.
+  for (int round = 0; round < 20; ++round) {
+    while (int* element = buffer.PrepareInsert()) {
+      *element = next_write++;
+      buffer.FinishInsert();
+    }
+    // Leave a couple of elements behind to shift the start of the next round.
+    while (buffer.Size() > 2) {
+      int* front = buffer.Front();
+      ASSERT_THAT(front, NotNull());
+      EXPECT_EQ(*front, next_read++);
+      buffer.DropFront();
+    }
+  }
+}
+
+TEST(SpscRingBufferTest, KeepFrontLeavesElementInPlace) {
+  SpscRingBuffer<int> buffer(/*capacity=*/2);
+  int* element = buffer.PrepareInsert();
+  ASSERT_THAT(element, NotNull());
+  *element = 42;
+  buffer.FinishInsert();
+
+  int* front = buffer.Front();
+  ASSERT_THAT(front, NotNull());
+  buffer.KeepFront();
+  EXPECT_EQ(buffer.Size(), 1);
+  front = buffer.Front();
+  ASSERT_THAT(front, NotNull());
+  EXPECT_EQ(*front, 42);
+  buffer.DropFront();
+  EXPECT_TRUE(buffer.Empty());
+}
+
+TEST(SpscRingBufferTest, InitElementsInitializesWholeStorage) {
+  SpscRingBuffer<int> buffer(/*capacity=*/3, [](int* v) { *v = 7; });
+  // Every slot that can ever be handed out must have been initialized, even
+  // those beyond the requested capacity.
+  for (int i = 0; i < 10; ++i) {
+    int* element = buffer.PrepareInsert();
+    ASSERT_THAT(element, NotNull());
+    EXPECT_EQ(*element, 7);
+    buffer.FinishInsert();
+    int* front = buffer.Front();
+    ASSERT_THAT(front, NotNull());
+    buffer.DropFront();
+  }
+}
+
+TEST(SpscRingBufferTest, BatchSpansStopAtEndOfStorage) {
+  // Storage is rounded up to 8 elements.
+  SpscRingBuffer<int> buffer(/*capacity=*/6);
+  absl::Span<int> elements = buffer.PrepareInsertN(5);
+  ASSERT_EQ(elements.size(), 5);
+  buffer.FinishInsertN(5);
+  absl::Span<int> front = buffer.FrontN(10);
+  ASSERT_EQ(front.size(), 5);
+  buffer.DropFrontN(5);
+
+  // Only three contiguous elements remain before the end of the storage.
+  elements = buffer.PrepareInsertN(6);
+  ASSERT_EQ(elements.size(), 3);
+  elements[0] = 1;
+  elements[1] = 2;
+  elements[2] = 3;
+  buffer.FinishInsertN(3);
+  elements = buffer.PrepareInsertN(6);
+  ASSERT_EQ(elements.size(), 3);
+  elements[0] = 4;
+  elements[1] = 5;
+  elements[2] = 6;
+  buffer.FinishInsertN(3);
+  EXPECT_TRUE(buffer.Full());
+  EXPECT_TRUE(buffer.PrepareInsertN(1).empty());
+
+  front = buffer.FrontN(10);
+  EXPECT_THAT(front, ElementsAre(1, 2, 3));
+  buffer.DropFrontN(2);
+  front = buffer.FrontN(10);
+  EXPECT_THAT(front, ElementsAre(3));
+  buffer.DropFrontN(1);
+  front = buffer.FrontN(10);
+  EXPECT_THAT(front, ElementsAre(4, 5, 6));
+  buffer.KeepFront();
+  EXPECT_EQ(buffer.Size(), 3);
+}
+
+TEST(SpscRingBufferTest, FinishingFewerElementsThanPrepared) {
+  SpscRingBuffer<int> buffer(/*capacity=*/4);
+  absl::Span<int> elements = buffer.PrepareInsertN(4);
+  ASSERT_EQ(elements.size(), 4);
+  elements[0] = 10;
+  buffer.FinishInsertN(1);
+  EXPECT_EQ(buffer.Size(), 1);
+
+  // Zero-sized finishes and drops are no-ops when nothing is pending.
+  buffer.FinishInsertN(0);
+  buffer.DropFrontN(0);
+  EXPECT_EQ(buffer.Size(), 1);
+}
+
+TEST(SpscRingBufferTest, ConcurrentProducerConsumer) {
+  constexpr uint64_t kIterations = 10000;
+  SpscRingBuffer<uint64_t> buffer(/*capacity=*/7);
+
+  intrinsic::Thread producer([&buffer]() {
+    uint64_t next = 0;
+    while (next < kIterations) {
+      if (uint64_t* element = buffer.PrepareInsert(); element != nullptr) {
+        *element = next++;
+        buffer.FinishInsert();
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  uint64_t expected = 0;
+  while (expected < kIterations) {
+    if (uint64_t* front = buffer.Front(); front != nullptr) {
+      EXPECT_EQ(*front, expected);
+      ++expected;
+      buffer.DropFront();
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.Join();
+  EXPECT_TRUE(buffer.Empty());
+}
+
+}  // namespace
+}  // namespace intrinsic::internal
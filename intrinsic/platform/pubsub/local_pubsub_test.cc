@@ -0,0 +1,145 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/wrappers.pb.h"
+#include "intrinsic/platform/pubsub/adapters/pubsub.pb.h"
+#include "intrinsic/platform/pubsub/publisher.h"
+#include "intrinsic/platform/pubsub/publisher_stats.h"
+#include "intrinsic/platform/pubsub/pubsub.h"
+#include "intrinsic/platform/pubsub/pubsub_packet_view.h"
+#include "intrinsic/platform/pubsub/subscription.h"
+#include "intrinsic/util/testing/gtest_wrapper.h"
+
+namespace intrinsic {
+namespace {
+
+using ::intrinsic::testing::IsOkAndHolds;
+using ::intrinsic::testing::StatusIs;
+using ::intrinsic_proto::pubsub::PubSubPacket;
+using ::testing::ElementsAre;
+
+google::protobuf::StringValue StringMessage(absl::string_view value) {
+  google::protobuf::StringValue message;
+  message.set_value(std::string(value));
+  return message;
+}
+
+TEST(LocalPubSubTest, PassesPublishedMessageToTypedSubscribers) {
+  PubSub pubsub = PubSub::LocalOnly();
+  std::vector<const google::protobuf::StringValue*> received;
+  ASSERT_OK_AND_ASSIGN(
+      Subscription subscription,
+      pubsub.CreateSubscription<google::protobuf::StringValue>(
+          "/local_pubsub_test/typed", TopicConfig(),
+          [&](const google::protobuf::StringValue& message) {
+            received.push_back(&message);
+          }));
+  ASSERT_OK_AND_ASSIGN(
+      Publisher publisher,
+      pubsub.CreatePublisher("/local_pubsub_test/typed", TopicConfig()));
+
+  const google::protobuf::StringValue message = StringMessage("hello");
+  ASSERT_OK(publisher.Publish(message));
+  EXPECT_THAT(received, ElementsAre(&message));
+}
+
+TEST(LocalPubSubTest, ReportsTypeMismatch) {
+  PubSub pubsub = PubSub::LocalOnly();
+  std::vector<absl::Status> errors;
+  ASSERT_OK_AND_ASSIGN(
+      Subscription subscription,
+      pubsub.CreateSubscription<google::protobuf::Int64Value>(
+          "/local_pubsub_test/mismatch", TopicConfig(),
+          [](const google::protobuf::Int64Value&) {
+            ADD_FAILURE() << "Unexpected message";
+          },
+          [&](absl::string_view packet, absl::Status error) {
+            errors.push_back(std::move(error));
+          }));
+  ASSERT_OK_AND_ASSIGN(
+      Publisher publisher,
+      pubsub.CreatePublisher("/local_pubsub_test/mismatch", TopicConfig()));
+
+  ASSERT_OK(publisher.Publish(StringMessage("hello")));
+  EXPECT_THAT(errors,
+              ElementsAre(StatusIs(absl::StatusCode::kInvalidArgument)));
+}
+
+TEST(LocalPubSubTest, MatchesWildcardSubscriptions) {
+  PubSub pubsub = PubSub::LocalOnly();
+  std::vector<std::string> received;
+  ASSERT_OK_AND_ASSIGN(
+      Subscription subscription,
+      pubsub.CreateSubscription(
+          "/local_pubsub_test/wildcard/**", TopicConfig(),
+          SubscriptionOkExpandedCallback<PubSubPacket>(
+              [&](absl::string_view topic, const PubSubPacket& packet) {
+                google::protobuf::StringValue message;
+                ASSERT_TRUE(packet.payload().UnpackTo(&message));
+                received.push_back(
+                    absl::StrCat(topic, "=", message.value()));
+              })));
+  ASSERT_OK_AND_ASSIGN(Publisher matching,
+                       pubsub.CreatePublisher(
+                           "/local_pubsub_test/wildcard/a/b", TopicConfig()));
+  ASSERT_OK_AND_ASSIGN(
+      Publisher other,
+      pubsub.CreatePublisher("/local_pubsub_test/other", TopicConfig()));
+
+  ASSERT_OK(matching.Publish(StringMessage("x")));
+  ASSERT_OK(other.Publish(StringMessage("y")));
+  EXPECT_THAT(received, ElementsAre("/local_pubsub_test/wildcard/a/b=x"));
+}
+
+TEST(LocalPubSubTest, StopsAfterUnsubscribe) {
+  PubSub pubsub = PubSub::LocalOnly();
+  std::vector<std::string> received;
+  ASSERT_OK_AND_ASSIGN(
+      Subscription subscription,
+      pubsub.CreateRawSubscription(
+          "/local_pubsub_test/unsubscribe", TopicConfig(),
+          [&](const PubSubPacketView& packet) {
+            received.emplace_back(packet.payload_type_name());
+          }));
+  ASSERT_OK_AND_ASSIGN(
+      Publisher publisher,
+      pubsub.CreatePublisher("/local_pubsub_test/unsubscribe", TopicConfig()));
+
+  ASSERT_OK(publisher.Publish(StringMessage("x")));
+  subscription.Unsubscribe();
+  ASSERT_OK(publisher.Publish(StringMessage("y")));
+  EXPECT_THAT(received, ElementsAre("google.protobuf.StringValue"));
+}
+
+TEST(LocalPubSubTest, CountsPublishedMessages) {
+  PubSub pubsub = PubSub::LocalOnly();
+  ASSERT_OK_AND_ASSIGN(
+      Publisher publisher,
+      pubsub.CreatePublisher("/local_pubsub_test/stats", TopicConfig()));
+  const int before = internal::MessagesPublished("/local_pubsub_test/stats");
+  ASSERT_OK(publisher.Publish(StringMessage("x")));
+  EXPECT_EQ(internal::MessagesPublished("/local_pubsub_test/stats"),
+            before + 1);
+}
+
+TEST(LocalPubSubTest, EvaluatesKeyexprsLocally) {
+  PubSub pubsub = PubSub::LocalOnly();
+  EXPECT_TRUE(pubsub.KeyexprIsCanon("/a/*/c"));
+  EXPECT_FALSE(pubsub.KeyexprIsCanon("/a//c"));
+  EXPECT_THAT(pubsub.KeyexprIntersects("/a/*", "/a/b"), IsOkAndHolds(true));
+  EXPECT_THAT(pubsub.KeyexprIncludes("/a/b", "/a/*"), IsOkAndHolds(false));
+  EXPECT_THAT(pubsub.KeyexprIntersects("/a//b", "/a/b"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace intrinsic
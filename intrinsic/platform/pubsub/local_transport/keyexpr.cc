@@ -0,0 +1,207 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/platform/pubsub/local_transport/keyexpr.h"
+
+#include <cstddef>
+#include <cstdint>
+
+#include "absl/container/inlined_vector.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+
+namespace intrinsic::local_transport {
+namespace {
+
+constexpr absl::string_view kAnyChunk = "*";
+constexpr absl::string_view kAnyChunks = "**";
+constexpr absl::string_view kSubchunkWildcard = "$*";
+
+using Chunks = absl::InlinedVector<absl::string_view, 16>;
+// A chunk with every "$*" replaced by '*', which can't appear otherwise.
+using Pattern = absl::InlinedVector<char, 32>;
+
+Chunks Split(absl::string_view keyexpr) {
+  Chunks chunks;
+  for (absl::string_view chunk : absl::StrSplit(keyexpr, '/')) {
+    chunks.push_back(chunk);
+  }
+  return chunks;
+}
+
+Pattern ToPattern(absl::string_view chunk) {
+  Pattern pattern;
+  if (chunk == kAnyChunk) {
+    pattern.push_back('*');
+    return pattern;
+  }
+  for (size_t i = 0; i < chunk.size(); ++i) {
+    if (chunk.substr(i, 2) == kSubchunkWildcard) {
+      pattern.push_back('*');
+      ++i;
+    } else {
+      pattern.push_back(chunk[i]);
+    }
+  }
+  return pattern;
+}
+
+// Memoizes a function of two indices in [0, n] x [0, m].
+class Memo {
+ public:
+  Memo(size_t n, size_t m)
+      : m_(m + 1), values_((n + 1) * (m + 1), kUnknown) {}
+
+  template <typename F>
+  bool Get(size_t i, size_t j, F&& f) {
+    int8_t& value = values_[i * m_ + j];
+    if (value == kUnknown) {
+      value = f() ? 1 : 0;
+    }
+    return value == 1;
+  }
+
+ private:
+  static constexpr int8_t kUnknown = -1;
+  size_t m_;
+  absl::InlinedVector<int8_t, 256> values_;
+};
+
+// Returns true if a string matches both patterns.
+bool PatternsIntersect(const Pattern& a, const Pattern& b) {
+  Memo memo(a.size(), b.size());
+  auto intersect = [&](auto& self, size_t i, size_t j) -> bool {
+    return memo.Get(i, j, [&]() {
+      if (i == a.size() && j == b.size()) {
+        return true;
+      }
+      if (i < a.size() && a[i] == '*') {
+        // The wildcard matches nothing more, or also the next element of b.
+        return self(self, i + 1, j) || (j < b.size() && self(self, i, j + 1));
+      }
+      if (j < b.size() && b[j] == '*') {
+        return self(self, i, j + 1) || (i < a.size() && self(self, i + 1, j));
+      }
+      return i < a.size() && j < b.size() && a[i] == b[j] &&
+             self(self, i + 1, j + 1);
+    });
+  };
+  return intersect(intersect, 0, 0);
+}
+
+// Returns true if all strings matching `b` also match `a`.
+bool PatternIncludes(const Pattern& a, const Pattern& b) {
+  Memo memo(a.size(), b.size());
+  auto includes = [&](auto& self, size_t i, size_t j) -> bool {
+    return memo.Get(i, j, [&]() {
+      if (i == a.size()) {
+        return j == b.size();
+      }
+      if (a[i] == '*') {
+        // A wildcard of `a` can absorb anything, including wildcards of `b`.
+        return self(self, i + 1, j) || (j < b.size() && self(self, i, j + 1));
+      }
+      return j < b.size() && b[j] != '*' && a[i] == b[j] &&
+             self(self, i + 1, j + 1);
+    });
+  };
+  return includes(includes, 0, 0);
+}
+
+bool ChunksIntersect(absl::string_view a, absl::string_view b) {
+  if (a == kAnyChunk || b == kAnyChunk) {
+    return true;
+  }
+  return PatternsIntersect(ToPattern(a), ToPattern(b));
+}
+
+bool ChunkIncludes(absl::string_view a, absl::string_view b) {
+  return a == kAnyChunk || PatternIncludes(ToPattern(a), ToPattern(b));
+}
+
+bool IsChunkCanon(absl::string_view chunk) {
+  if (chunk.empty()) {
+    return false;
+  }
+  if (chunk == kAnyChunk || chunk == kAnyChunks) {
+    return true;
+  }
+  // A lone "$*" is written as "*".
+  if (chunk == kSubchunkWildcard) {
+    return false;
+  }
+  for (size_t i = 0; i < chunk.size(); ++i) {
+    const char c = chunk[i];
+    if (c == '*' || c == '#' || c == '?') {
+      return false;
+    }
+    if (c == '$') {
+      if (chunk.substr(i, 2) != kSubchunkWildcard ||
+          absl::StartsWith(chunk.substr(i + 2), kSubchunkWildcard)) {
+        return false;
+      }
+      ++i;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+bool KeyexprIsCanon(absl::string_view keyexpr) {
+  const Chunks chunks = Split(keyexpr);
+  for (size_t i = 0; i < chunks.size(); ++i) {
+    if (!IsChunkCanon(chunks[i])) {
+      return false;
+    }
+    // "**/**" is written as "**" and "**/*" as "*/**".
+    if (chunks[i] == kAnyChunks && i + 1 < chunks.size() &&
+        (chunks[i + 1] == kAnyChunks || chunks[i + 1] == kAnyChunk)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool KeyexprIntersects(absl::string_view left, absl::string_view right) {
+  const Chunks a = Split(left);
+  const Chunks b = Split(right);
+  Memo memo(a.size(), b.size());
+  auto intersect = [&](auto& self, size_t i, size_t j) -> bool {
+    return memo.Get(i, j, [&]() {
+      if (i == a.size() && j == b.size()) {
+        return true;
+      }
+      if (i < a.size() && a[i] == kAnyChunks) {
+        return self(self, i + 1, j) || (j < b.size() && self(self, i, j + 1));
+      }
+      if (j < b.size() && b[j] == kAnyChunks) {
+        return self(self, i, j + 1) || (i < a.size() && self(self, i + 1, j));
+      }
+      return i < a.size() && j < b.size() && ChunksIntersect(a[i], b[j]) &&
+             self(self, i + 1, j + 1);
+    });
+  };
+  return intersect(intersect, 0, 0);
+}
+
+bool KeyexprIncludes(absl::string_view left, absl::string_view right) {
+  const Chunks a = Split(left);
+  const Chunks b = Split(right);
+  Memo memo(a.size(), b.size());
+  auto includes = [&](auto& self, size_t i, size_t j) -> bool {
+    return memo.Get(i, j, [&]() {
+      if (i == a.size()) {
+        return j == b.size();
+      }
+      if (a[i] == kAnyChunks) {
+        return self(self, i + 1, j) || (j < b.size() && self(self, i, j + 1));
+      }
+      return j < b.size() && b[j] != kAnyChunks &&
+             ChunkIncludes(a[i], b[j]) && self(self, i + 1, j + 1);
+    });
+  };
+  return includes(includes, 0, 0);
+}
+
+}  // namespace intrinsic::local_transport
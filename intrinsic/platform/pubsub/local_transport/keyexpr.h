@@ -0,0 +1,31 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#ifndef INTRINSIC_PLATFORM_PUBSUB_LOCAL_TRANSPORT_KEYEXPR_H_
+#define INTRINSIC_PLATFORM_PUBSUB_LOCAL_TRANSPORT_KEYEXPR_H_
+
+#include "absl/strings/string_view.h"
+
+namespace intrinsic::local_transport {
+
+// Key expression matching for the local transports, following the semantics
+// of Zenoh key expressions:
+//
+// * A key expression is a '/' separated list of non-empty chunks.
+// * The chunk "*" matches exactly one chunk.
+// * The chunk "**" matches zero or more chunks.
+// * "$*" within a chunk matches any, possibly empty, part of a chunk.
+
+// Returns true if `keyexpr` is canonical, i.e. it has no empty chunks, no
+// trailing slash, wildcards only where they are allowed and no redundant
+// wildcards like "**/**" or "$*$*".
+bool KeyexprIsCanon(absl::string_view keyexpr);
+
+// Returns true if there is a key that matches both `left` and `right`.
+bool KeyexprIntersects(absl::string_view left, absl::string_view right);
+
+// Returns true if all keys that match `right` also match `left`.
+bool KeyexprIncludes(absl::string_view left, absl::string_view right);
+
+}  // namespace intrinsic::local_transport
+
+#endif  // INTRINSIC_PLATFORM_PUBSUB_LOCAL_TRANSPORT_KEYEXPR_H_
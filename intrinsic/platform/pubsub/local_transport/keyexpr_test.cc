@@ -0,0 +1,62 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/platform/pubsub/local_transport/keyexpr.h"
+
+#include <gtest/gtest.h>
+
+namespace intrinsic::local_transport {
+namespace {
+
+TEST(KeyexprTest, IsCanon) {
+  EXPECT_TRUE(KeyexprIsCanon("a/b/c"));
+  EXPECT_TRUE(KeyexprIsCanon("a/*/c"));
+  EXPECT_TRUE(KeyexprIsCanon("a/**"));
+  EXPECT_TRUE(KeyexprIsCanon("a/*/**"));
+  EXPECT_TRUE(KeyexprIsCanon("a/b$*/c"));
+
+  EXPECT_FALSE(KeyexprIsCanon(""));
+  EXPECT_FALSE(KeyexprIsCanon("a//b"));
+  EXPECT_FALSE(KeyexprIsCanon("a/b/"));
+  EXPECT_FALSE(KeyexprIsCanon("a/**/**"));
+  EXPECT_FALSE(KeyexprIsCanon("a/**/*"));
+  EXPECT_FALSE(KeyexprIsCanon("a/b*"));
+  EXPECT_FALSE(KeyexprIsCanon("a/$*"));
+  EXPECT_FALSE(KeyexprIsCanon("a/b$*$*"));
+  EXPECT_FALSE(KeyexprIsCanon("a/b#"));
+}
+
+TEST(KeyexprTest, Intersects) {
+  EXPECT_TRUE(KeyexprIntersects("a/b", "a/b"));
+  EXPECT_FALSE(KeyexprIntersects("a/b", "a/c"));
+  EXPECT_FALSE(KeyexprIntersects("a/b", "a/b/c"));
+
+  EXPECT_TRUE(KeyexprIntersects("a/*", "a/b"));
+  EXPECT_FALSE(KeyexprIntersects("a/*", "a/b/c"));
+  EXPECT_FALSE(KeyexprIntersects("a/*", "a"));
+
+  EXPECT_TRUE(KeyexprIntersects("a/**", "a"));
+  EXPECT_TRUE(KeyexprIntersects("a/**", "a/b/c"));
+  EXPECT_TRUE(KeyexprIntersects("**/c", "a/b/c"));
+  EXPECT_TRUE(KeyexprIntersects("a/**/c", "**/b/c"));
+  EXPECT_FALSE(KeyexprIntersects("a/**/c", "b/**"));
+
+  EXPECT_TRUE(KeyexprIntersects("a/b$*", "a/bcd"));
+  EXPECT_TRUE(KeyexprIntersects("a/b$*", "a/b"));
+  EXPECT_TRUE(KeyexprIntersects("a/b$*", "a/$*c"));
+  EXPECT_FALSE(KeyexprIntersects("a/b$*", "a/cd"));
+}
+
+TEST(KeyexprTest, Includes) {
+  EXPECT_TRUE(KeyexprIncludes("a/b", "a/b"));
+  EXPECT_TRUE(KeyexprIncludes("a/*", "a/b"));
+  EXPECT_FALSE(KeyexprIncludes("a/b", "a/*"));
+  EXPECT_TRUE(KeyexprIncludes("a/**", "a/*/c"));
+  EXPECT_TRUE(KeyexprIncludes("a/**", "a/**"));
+  EXPECT_FALSE(KeyexprIncludes("a/*", "a/**"));
+  EXPECT_TRUE(KeyexprIncludes("a/b$*", "a/bc$*"));
+  EXPECT_FALSE(KeyexprIncludes("a/bc$*", "a/b$*"));
+  EXPECT_TRUE(KeyexprIncludes("a/*", "a/b$*"));
+}
+
+}  // namespace
+}  // namespace intrinsic::local_transport
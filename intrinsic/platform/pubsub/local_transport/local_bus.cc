@@ -0,0 +1,396 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/platform/pubsub/local_transport/local_bus.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/inlined_vector.h"
+#include "absl/functional/function_ref.h"
+#include "absl/log/log.h"
+#include "absl/random/random.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "google/protobuf/message.h"
+#include "intrinsic/platform/pubsub/local_transport/keyexpr.h"
+#include "intrinsic/platform/pubsub/local_transport/shared_memory_ring.h"
+#include "intrinsic/platform/pubsub/pubsub_packet_encoder.h"
+#include "intrinsic/platform/pubsub/pubsub_packet_view.h"
+#include "intrinsic/util/thread/thread.h"
+
+namespace intrinsic::local_transport {
+namespace {
+
+// How often the reader thread checks whether it should stop, in case a wake up
+// gets lost.
+constexpr absl::Duration kReaderPollInterval = absl::Milliseconds(100);
+
+// The reader thread caches the matching subscribers of at most this many
+// topics, so that topics that are used only once don't accumulate.
+constexpr size_t kMaxCachedTopics = 1024;
+
+// The subscribers whose callbacks are running on this thread. A callback may
+// publish or unsubscribe, so there can be more than one.
+thread_local absl::InlinedVector<const LocalSubscriber*, 4>
+    running_subscribers;
+
+bool IsRunningOnThisThread(const LocalSubscriber* subscriber) {
+  return std::find(running_subscribers.begin(), running_subscribers.end(),
+                   subscriber) != running_subscribers.end();
+}
+
+// Marks a subscriber as running on this thread and holds its callback mutex in
+// reader mode, unless this thread already does.
+class CallbackScope {
+ public:
+  CallbackScope(const LocalSubscriber* subscriber, absl::Mutex& mutex)
+      : mutex_(IsRunningOnThisThread(subscriber) ? nullptr : &mutex) {
+    if (mutex_ != nullptr) {
+      mutex_->ReaderLock();
+    }
+    running_subscribers.push_back(subscriber);
+  }
+  ~CallbackScope() {
+    running_subscribers.pop_back();
+    if (mutex_ != nullptr) {
+      mutex_->ReaderUnlock();
+    }
+  }
+
+ private:
+  absl::Mutex* mutex_;
+};
+
+// Encodes a message lazily, at most once per publish. The encoders are reused
+// across publishes on the same thread; there is one per nesting level because
+// a callback may publish again.
+class LazyPacket {
+ public:
+  LazyPacket(const google::protobuf::Message& message, absl::Time publish_time)
+      : message_(message), publish_time_(publish_time) {
+    if (encoders_.size() <= depth_) {
+      encoders_.push_back(std::make_unique<internal::PubSubPacketEncoder>());
+    }
+    encoder_ = encoders_[depth_].get();
+    ++depth_;
+  }
+  ~LazyPacket() { --depth_; }
+
+  // Returns nullptr if the message can't be encoded.
+  const PubSubPacketView* Get() {
+    if (!status_.ok()) {
+      return nullptr;
+    }
+    if (!view_.has_value()) {
+      absl::StatusOr<absl::string_view> packet =
+          encoder_->Encode(message_, publish_time_);
+      if (packet.ok()) {
+        absl::StatusOr<PubSubPacketView> view =
+            PubSubPacketView::Parse(*packet);
+        if (view.ok()) {
+          view_ = *std::move(view);
+          return &*view_;
+        }
+        status_ = view.status();
+      } else {
+        status_ = packet.status();
+      }
+      return nullptr;
+    }
+    return &*view_;
+  }
+
+  const absl::Status& status() const { return status_; }
+  size_t size() const {
+    return view_.has_value() ? view_->serialized_packet().size() : 0;
+  }
+
+ private:
+  static thread_local std::vector<
+      std::unique_ptr<internal::PubSubPacketEncoder>>
+      encoders_;
+  static thread_local size_t depth_;
+
+  const google::protobuf::Message& message_;
+  const absl::Time publish_time_;
+  internal::PubSubPacketEncoder* encoder_;
+  std::optional<PubSubPacketView> view_;
+  absl::Status status_;
+};
+
+thread_local std::vector<std::unique_ptr<internal::PubSubPacketEncoder>>
+    LazyPacket::encoders_;
+thread_local size_t LazyPacket::depth_ = 0;
+
+}  // namespace
+
+LocalSubscriber::LocalSubscriber(LocalBus& bus, absl::string_view keyexpr,
+                                 bool shared_memory,
+                                 LocalSubscriberCallbacks callbacks)
+    : bus_(bus),
+      keyexpr_(keyexpr),
+      shared_memory_(shared_memory),
+      callbacks_(std::move(callbacks)) {}
+
+void LocalSubscriber::Unsubscribe() {
+  if (!active_.exchange(false)) {
+    return;
+  }
+  bus_.Remove(this);
+  if (!IsRunningOnThisThread(this)) {
+    // Waits for the callbacks that are running on other threads.
+    absl::WriterMutexLock lock(&callback_mutex_);
+  }
+}
+
+void LocalSubscriber::Deliver(
+    const google::protobuf::Message& message, absl::string_view topic,
+    absl::FunctionRef<const PubSubPacketView*()> encode) {
+  CallbackScope scope(this, callback_mutex_);
+  if (!active_.load(std::memory_order_acquire)) {
+    return;
+  }
+  if (callbacks_.message_callback != nullptr &&
+      callbacks_.message_callback(message)) {
+    return;
+  }
+  if (callbacks_.packet_callback != nullptr) {
+    if (const PubSubPacketView* packet = encode(); packet != nullptr) {
+      callbacks_.packet_callback(topic, *packet);
+    }
+  }
+}
+
+void LocalSubscriber::Deliver(absl::string_view topic,
+                              const PubSubPacketView& packet) {
+  CallbackScope scope(this, callback_mutex_);
+  if (!active_.load(std::memory_order_acquire) ||
+      callbacks_.packet_callback == nullptr) {
+    return;
+  }
+  callbacks_.packet_callback(topic, packet);
+}
+
+LocalPublisher::LocalPublisher(LocalBus& bus, absl::string_view topic,
+                               bool shared_memory)
+    : bus_(bus), topic_(topic), shared_memory_(shared_memory) {}
+
+std::shared_ptr<const LocalPublisher::Subscribers>
+LocalPublisher::MatchingSubscribers() {
+  if (unmatched_version_.load(std::memory_order_acquire) == bus_.version()) {
+    return nullptr;
+  }
+  absl::MutexLock lock(&mutex_);
+  if (matches_ != nullptr && version_ == bus_.version()) {
+    return matches_;
+  }
+  auto matches = std::make_shared<Subscribers>();
+  for (const std::shared_ptr<LocalSubscriber>& subscriber :
+       *bus_.subscribers(version_)) {
+    if (KeyexprIntersects(subscriber->keyexpr(), topic_)) {
+      matches->push_back(subscriber);
+    }
+  }
+  unmatched_version_.store(matches->empty() ? version_ : UINT64_MAX,
+                           std::memory_order_release);
+  matches_ = std::move(matches);
+  return matches_;
+}
+
+absl::Status LocalPublisher::Publish(const google::protobuf::Message& message,
+                                     absl::Time publish_time,
+                                     size_t& packet_size) {
+  LazyPacket packet(message, publish_time);
+  if (const std::shared_ptr<const Subscribers> matches = MatchingSubscribers();
+      matches != nullptr) {
+    for (const std::shared_ptr<LocalSubscriber>& subscriber : *matches) {
+      subscriber->Deliver(message, topic_, [&]() { return packet.Get(); });
+    }
+  }
+  if (shared_memory_) {
+    const PubSubPacketView* view = packet.Get();
+    if (view != nullptr) {
+      absl::StatusOr<SharedMemoryRing*> ring = bus_.ring();
+      if (!ring.ok()) {
+        return ring.status();
+      }
+      if (absl::Status status =
+              (*ring)->Write(bus_.id_, topic_, view->serialized_packet());
+          !status.ok()) {
+        return status;
+      }
+    }
+  }
+  packet_size = packet.size();
+  return packet.status();
+}
+
+LocalBus& LocalBus::Global() {
+  static auto* bus = new LocalBus();
+  return *bus;
+}
+
+LocalBus::LocalBus(absl::string_view shared_memory_name)
+    : shared_memory_name_(shared_memory_name),
+      id_(absl::Uniform<uint64_t>(absl::BitGen())),
+      subscribers_(std::make_shared<Subscribers>()) {}
+
+LocalBus::~LocalBus() {
+  stop_reader_.store(true);
+  absl::MutexLock lock(&ring_mutex_);
+  if (reader_.Joinable()) {
+    ring_->Wake();
+    reader_.Join();
+  }
+}
+
+absl::StatusOr<std::unique_ptr<LocalPublisher>> LocalBus::CreatePublisher(
+    absl::string_view topic, bool shared_memory) {
+  if (shared_memory) {
+    // Fails early if the ring can't be opened.
+    if (absl::StatusOr<SharedMemoryRing*> ring = this->ring(); !ring.ok()) {
+      return ring.status();
+    }
+  }
+  return std::make_unique<LocalPublisher>(*this, topic, shared_memory);
+}
+
+absl::StatusOr<std::shared_ptr<LocalSubscriber>> LocalBus::Subscribe(
+    absl::string_view keyexpr, bool shared_memory,
+    LocalSubscriberCallbacks callbacks) {
+  if (shared_memory) {
+    absl::StatusOr<SharedMemoryRing*> ring = this->ring();
+    if (!ring.ok()) {
+      return ring.status();
+    }
+    absl::MutexLock lock(&ring_mutex_);
+    if (!reader_.Joinable()) {
+      // Starts at the current position, so that the subscriber receives all
+      // records that are written after Subscribe() returns.
+      reader_ = Thread([this, ring = *ring,
+                        position = (*ring)->WritePosition()]() {
+        ReadSharedMemory(*ring, position);
+      });
+    }
+  }
+  auto subscriber = std::make_shared<LocalSubscriber>(
+      *this, keyexpr, shared_memory, std::move(callbacks));
+  absl::MutexLock lock(&mutex_);
+  auto subscribers = std::make_shared<Subscribers>(*subscribers_);
+  subscribers->push_back(subscriber);
+  subscribers_ = std::move(subscribers);
+  version_.fetch_add(1, std::memory_order_release);
+  return subscriber;
+}
+
+void LocalBus::Remove(const LocalSubscriber* subscriber) {
+  absl::MutexLock lock(&mutex_);
+  auto subscribers = std::make_shared<Subscribers>();
+  subscribers->reserve(subscribers_->size());
+  for (const std::shared_ptr<LocalSubscriber>& other : *subscribers_) {
+    if (other.get() != subscriber) {
+      subscribers->push_back(other);
+    }
+  }
+  subscribers_ = std::move(subscribers);
+  version_.fetch_add(1, std::memory_order_release);
+}
+
+std::shared_ptr<const LocalBus::Subscribers> LocalBus::subscribers(
+    uint64_t& version) {
+  absl::MutexLock lock(&mutex_);
+  version = version_.load(std::memory_order_relaxed);
+  return subscribers_;
+}
+
+absl::StatusOr<SharedMemoryRing*> LocalBus::ring() {
+  absl::MutexLock lock(&ring_mutex_);
+  if (ring_ == nullptr) {
+    absl::StatusOr<std::unique_ptr<SharedMemoryRing>> ring =
+        SharedMemoryRing::Open(shared_memory_name_);
+    if (!ring.ok()) {
+      return ring.status();
+    }
+    ring_ = *std::move(ring);
+  }
+  return ring_.get();
+}
+
+void LocalBus::ReadSharedMemory(const SharedMemoryRing& ring,
+                                uint64_t position) {
+  std::string buffer;
+  SharedMemoryRing::Record record;
+
+  // The shared memory subscribers that match a topic, for the subscriber list
+  // with version `matches_version`.
+  absl::flat_hash_map<std::string, Subscribers> matches_by_topic;
+  uint64_t matches_version = UINT64_MAX;
+
+  while (!stop_reader_.load()) {
+    switch (ring.Read(position, buffer, record)) {
+      case SharedMemoryRing::ReadResult::kEmpty:
+        ring.Wait(position, kReaderPollInterval);
+        continue;
+      case SharedMemoryRing::ReadResult::kOverrun:
+        overruns_.fetch_add(1, std::memory_order_relaxed);
+        LOG_EVERY_N(WARNING, 100) << "Messages in the shared memory ring \""
+                                  << shared_memory_name_
+                                  << "\" were overwritten before they could "
+                                     "be read.";
+        continue;
+      case SharedMemoryRing::ReadResult::kRecord:
+        break;
+    }
+    // Subscribers of this bus received the message from the publisher.
+    if (record.writer_id == id_) {
+      continue;
+    }
+    absl::StatusOr<PubSubPacketView> packet =
+        PubSubPacketView::Parse(record.packet);
+    if (!packet.ok()) {
+      LOG_EVERY_N(ERROR, 100) << "Invalid packet in shared memory on topic "
+                              << record.topic << ": " << packet.status();
+      continue;
+    }
+
+    if (matches_version != version() ||
+        matches_by_topic.size() >= kMaxCachedTopics) {
+      matches_by_topic.clear();
+    }
+    auto [it, inserted] = matches_by_topic.try_emplace(record.topic);
+    if (inserted) {
+      uint64_t subscribers_version;
+      for (const std::shared_ptr<LocalSubscriber>& subscriber :
+           *subscribers(subscribers_version)) {
+        if (subscriber->shared_memory() &&
+            KeyexprIntersects(subscriber->keyexpr(), record.topic)) {
+          it->second.push_back(subscriber);
+        }
+      }
+      if (subscribers_version != matches_version) {
+        // The subscriber list changed since the other entries were computed.
+        Subscribers matches = std::move(it->second);
+        matches_by_topic.clear();
+        it = matches_by_topic.emplace(record.topic, std::move(matches)).first;
+        matches_version = subscribers_version;
+      }
+    }
+    for (const std::shared_ptr<LocalSubscriber>& subscriber : it->second) {
+      subscriber->Deliver(record.topic, *packet);
+    }
+  }
+}
+
+}  // namespace intrinsic::local_transport
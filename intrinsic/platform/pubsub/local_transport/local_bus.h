@@ -0,0 +1,192 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#ifndef INTRINSIC_PLATFORM_PUBSUB_LOCAL_TRANSPORT_LOCAL_BUS_H_
+#define INTRINSIC_PLATFORM_PUBSUB_LOCAL_TRANSPORT_LOCAL_BUS_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/functional/function_ref.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "google/protobuf/message.h"
+#include "intrinsic/platform/pubsub/local_transport/shared_memory_ring.h"
+#include "intrinsic/platform/pubsub/pubsub_packet_view.h"
+#include "intrinsic/util/thread/thread.h"
+
+namespace intrinsic::local_transport {
+
+class LocalBus;
+
+// Callbacks of a subscriber of the local bus.
+struct LocalSubscriberCallbacks {
+  // Receives messages that are published in this process, without
+  // serialization. Returns false if it can't handle the type of the message,
+  // which is then serialized and passed to `packet_callback` instead. May be
+  // empty.
+  std::function<bool(const google::protobuf::Message& message)>
+      message_callback;
+  // Receives serialized PubSubPackets together with the topic they were
+  // published on.
+  std::function<void(absl::string_view topic, const PubSubPacketView& packet)>
+      packet_callback;
+};
+
+// A subscription to the local bus.
+class LocalSubscriber {
+ public:
+  LocalSubscriber(LocalBus& bus, absl::string_view keyexpr, bool shared_memory,
+                  LocalSubscriberCallbacks callbacks);
+
+  absl::string_view keyexpr() const { return keyexpr_; }
+  bool shared_memory() const { return shared_memory_; }
+
+  // Stops the delivery of messages. When this returns, no callback is running
+  // anymore, unless Unsubscribe() is called from a callback of this
+  // subscriber.
+  void Unsubscribe();
+
+ private:
+  friend class LocalBus;
+  friend class LocalPublisher;
+
+  // Passes `message` to the message callback, or the packet returned by
+  // `encode` to the packet callback. `encode` returns nullptr if encoding
+  // failed.
+  void Deliver(const google::protobuf::Message& message,
+               absl::string_view topic,
+               absl::FunctionRef<const PubSubPacketView*()> encode);
+  void Deliver(absl::string_view topic, const PubSubPacketView& packet);
+
+  LocalBus& bus_;
+  const std::string keyexpr_;
+  const bool shared_memory_;
+  const LocalSubscriberCallbacks callbacks_;
+  std::atomic<bool> active_ = true;
+  // Held in reader mode while a callback runs, so that Unsubscribe() can wait
+  // for running callbacks.
+  absl::Mutex callback_mutex_;
+};
+
+// Publishes to the subscribers of the local bus whose key expressions
+// intersect the topic. Thread-safe.
+class LocalPublisher {
+ public:
+  LocalPublisher(LocalBus& bus, absl::string_view topic, bool shared_memory);
+
+  // Hands `message` to the matching subscribers of this process on the calling
+  // thread, and writes it to the shared memory ring if the publisher was
+  // created for shared memory. Sets `packet_size` to the size of the
+  // serialized message, or to zero if it wasn't serialized.
+  absl::Status Publish(const google::protobuf::Message& message,
+                       absl::Time publish_time, size_t& packet_size);
+
+ private:
+  using Subscribers = std::vector<std::shared_ptr<LocalSubscriber>>;
+
+  std::shared_ptr<const Subscribers> MatchingSubscribers();
+
+  LocalBus& bus_;
+  const std::string topic_;
+  const bool shared_memory_;
+
+  absl::Mutex mutex_;
+  // Valid for the subscriber list with version `version_`.
+  uint64_t version_ ABSL_GUARDED_BY(mutex_) = 0;
+  std::shared_ptr<const Subscribers> matches_ ABSL_GUARDED_BY(mutex_);
+  // The subscriber list version for which no subscriber matches, if any. Lets
+  // Publish() skip `mutex_` in that case, which is the common case for Zenoh
+  // publishers.
+  std::atomic<uint64_t> unmatched_version_ = UINT64_MAX;
+};
+
+// An in-process stand-in for Zenoh which connects the publishers and
+// subscribers of this process directly, and optionally those of all processes
+// on this host through a SharedMemoryRing.
+//
+// Messages are delivered synchronously on the publishing thread, i.e. the
+// subscribers of this process receive a message before Publish() returns.
+// Messages from other buses are delivered on a reader thread, which is started
+// with the first shared memory subscriber. Each bus tags its records in the
+// ring with a random id to recognize its own, which works across PID
+// namespaces.
+//
+// Topics and key expressions follow the Zenoh semantics, see keyexpr.h.
+class LocalBus {
+ public:
+  // Name of the shared memory ring of the global bus.
+  static constexpr absl::string_view kDefaultSharedMemoryName =
+      "/intrinsic_pubsub_local_bus";
+
+  // The bus of this process, which is never destroyed.
+  static LocalBus& Global();
+
+  explicit LocalBus(
+      absl::string_view shared_memory_name = kDefaultSharedMemoryName);
+  ~LocalBus();
+
+  LocalBus(const LocalBus&) = delete;
+  LocalBus& operator=(const LocalBus&) = delete;
+
+  // Returns an error if `shared_memory` is set and the shared memory ring
+  // can't be opened.
+  absl::StatusOr<std::unique_ptr<LocalPublisher>> CreatePublisher(
+      absl::string_view topic, bool shared_memory);
+
+  // Subscribes to all messages on topics that intersect `keyexpr`. With
+  // `shared_memory`, this includes the messages that other processes publish
+  // through the shared memory ring. Call LocalSubscriber::Unsubscribe() to
+  // stop the subscription.
+  absl::StatusOr<std::shared_ptr<LocalSubscriber>> Subscribe(
+      absl::string_view keyexpr, bool shared_memory,
+      LocalSubscriberCallbacks callbacks);
+
+  // Number of records from other buses that were lost because the reader
+  // thread fell behind.
+  int64_t shared_memory_overruns() const {
+    return overruns_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  friend class LocalPublisher;
+  friend class LocalSubscriber;
+  using Subscribers = std::vector<std::shared_ptr<LocalSubscriber>>;
+
+  // Returns the current subscribers and their version.
+  std::shared_ptr<const Subscribers> subscribers(uint64_t& version);
+  uint64_t version() const { return version_.load(std::memory_order_acquire); }
+  void Remove(const LocalSubscriber* subscriber);
+  absl::StatusOr<SharedMemoryRing*> ring();
+  // Delivers the records of other buses from `position` on.
+  void ReadSharedMemory(const SharedMemoryRing& ring, uint64_t position);
+
+  const std::string shared_memory_name_;
+  // Identifies the records of this bus in the shared memory ring.
+  const uint64_t id_;
+
+  absl::Mutex mutex_;
+  // Copied on write, so that publishers can use it without holding `mutex_`.
+  std::shared_ptr<const Subscribers> subscribers_ ABSL_GUARDED_BY(mutex_);
+  // Incremented whenever `subscribers_` changes.
+  std::atomic<uint64_t> version_ = 0;
+
+  absl::Mutex ring_mutex_;
+  std::unique_ptr<SharedMemoryRing> ring_ ABSL_GUARDED_BY(ring_mutex_);
+  std::atomic<bool> stop_reader_ = false;
+  std::atomic<int64_t> overruns_ = 0;
+  // Started with the first shared memory subscriber.
+  Thread reader_ ABSL_GUARDED_BY(ring_mutex_);
+};
+
+}  // namespace intrinsic::local_transport
+
+#endif  // INTRINSIC_PLATFORM_PUBSUB_LOCAL_TRANSPORT_LOCAL_BUS_H_
@@ -0,0 +1,248 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/platform/pubsub/local_transport/local_bus.h"
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "google/protobuf/message.h"
+#include "google/protobuf/wrappers.pb.h"
+#include "intrinsic/platform/pubsub/pubsub_packet_view.h"
+#include "intrinsic/util/testing/gtest_wrapper.h"
+
+namespace intrinsic::local_transport {
+namespace {
+
+using ::testing::ElementsAre;
+
+class LocalBusTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    shared_memory_name_ = absl::StrCat(
+        "/local_bus_test_", getpid(), "_",
+        ::testing::UnitTest::GetInstance()->current_test_info()->name());
+    shm_unlink(shared_memory_name_.c_str());
+  }
+  void TearDown() override { shm_unlink(shared_memory_name_.c_str()); }
+
+  std::string shared_memory_name_;
+};
+
+google::protobuf::StringValue Message(absl::string_view value) {
+  google::protobuf::StringValue message;
+  message.set_value(std::string(value));
+  return message;
+}
+
+TEST_F(LocalBusTest, HandsMessagesToMatchingSubscribers) {
+  LocalBus bus(shared_memory_name_);
+  std::vector<const google::protobuf::Message*> received;
+  ASSERT_OK_AND_ASSIGN(
+      std::shared_ptr<LocalSubscriber> matching,
+      bus.Subscribe("a/*", /*shared_memory=*/false,
+                    {.message_callback =
+                         [&](const google::protobuf::Message& message) {
+                           received.push_back(&message);
+                           return true;
+                         }}));
+  ASSERT_OK_AND_ASSIGN(
+      std::shared_ptr<LocalSubscriber> other,
+      bus.Subscribe("b/**", /*shared_memory=*/false,
+                    {.message_callback =
+                         [&](const google::protobuf::Message&) {
+                           ADD_FAILURE() << "Unexpected message";
+                           return true;
+                         }}));
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<LocalPublisher> publisher,
+                       bus.CreatePublisher("a/b", /*shared_memory=*/false));
+
+  const google::protobuf::StringValue message = Message("hello");
+  size_t packet_size = 1;
+  ASSERT_OK(publisher->Publish(message, absl::Now(), packet_size));
+  // The subscriber received the published object itself, so nothing was
+  // serialized.
+  EXPECT_THAT(received, ElementsAre(&message));
+  EXPECT_EQ(packet_size, 0);
+}
+
+TEST_F(LocalBusTest, EncodesPacketsForPacketSubscribers) {
+  LocalBus bus(shared_memory_name_);
+  std::vector<std::string> values;
+  std::vector<std::string> topics;
+  auto packet_callback = [&](absl::string_view topic,
+                             const PubSubPacketView& packet) {
+    google::protobuf::StringValue message;
+    ASSERT_TRUE(packet.UnpackTo(&message));
+    topics.emplace_back(topic);
+    values.push_back(message.value());
+  };
+  // Rejects the message object, so it falls back to the packet.
+  ASSERT_OK_AND_ASSIGN(
+      std::shared_ptr<LocalSubscriber> rejecting,
+      bus.Subscribe("a/**", /*shared_memory=*/false,
+                    {.message_callback =
+                         [](const google::protobuf::Message&) { return false; },
+                     .packet_callback = packet_callback}));
+  ASSERT_OK_AND_ASSIGN(std::shared_ptr<LocalSubscriber> raw,
+                       bus.Subscribe("a/b", /*shared_memory=*/false,
+                                     {.packet_callback = packet_callback}));
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<LocalPublisher> publisher,
+                       bus.CreatePublisher("a/b", /*shared_memory=*/false));
+
+  size_t packet_size = 0;
+  ASSERT_OK(publisher->Publish(Message("x"), absl::Now(), packet_size));
+  EXPECT_THAT(values, ElementsAre("x", "x"));
+  EXPECT_THAT(topics, ElementsAre("a/b", "a/b"));
+  EXPECT_GT(packet_size, 0);
+}
+
+TEST_F(LocalBusTest, StopsDeliveringAfterUnsubscribe) {
+  LocalBus bus(shared_memory_name_);
+  int received = 0;
+  std::shared_ptr<LocalSubscriber> subscriber;
+  ASSERT_OK_AND_ASSIGN(
+      subscriber,
+      bus.Subscribe("a", /*shared_memory=*/false,
+                    {.message_callback =
+                         [&](const google::protobuf::Message&) {
+                           ++received;
+                           // Unsubscribing from the callback must not block.
+                           subscriber->Unsubscribe();
+                           return true;
+                         }}));
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<LocalPublisher> publisher,
+                       bus.CreatePublisher("a", /*shared_memory=*/false));
+  size_t packet_size;
+  ASSERT_OK(publisher->Publish(Message("1"), absl::Now(), packet_size));
+  ASSERT_OK(publisher->Publish(Message("2"), absl::Now(), packet_size));
+  EXPECT_EQ(received, 1);
+}
+
+TEST_F(LocalBusTest, DeliversThroughSharedMemoryAcrossProcesses) {
+  LocalBus subscriber_bus(shared_memory_name_);
+  absl::Mutex mutex;
+  std::vector<std::string> values;
+  ASSERT_OK_AND_ASSIGN(
+      std::shared_ptr<LocalSubscriber> subscriber,
+      subscriber_bus.Subscribe(
+          "a/*", /*shared_memory=*/true,
+          {.packet_callback = [&](absl::string_view topic,
+                                  const PubSubPacketView& packet) {
+            google::protobuf::StringValue message;
+            ASSERT_TRUE(packet.UnpackTo(&message));
+            absl::MutexLock lock(&mutex);
+            values.push_back(absl::StrCat(topic, "=", message.value()));
+          }}));
+
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<SharedMemoryRing> ring,
+                       SharedMemoryRing::Open(shared_memory_name_));
+  // Not a PubSubPacket, so the reader drops it.
+  ASSERT_OK(ring->Write(/*writer_id=*/1, "a/b", "invalid"));
+
+  const pid_t child = fork();
+  ASSERT_NE(child, -1);
+  if (child == 0) {
+    LocalBus publisher_bus(shared_memory_name_);
+    auto publisher =
+        publisher_bus.CreatePublisher("a/b", /*shared_memory=*/true);
+    size_t packet_size;
+    const bool ok = publisher.ok() &&
+                    (*publisher)->Publish(Message("x"), absl::Now(),
+                                          packet_size).ok() &&
+                    (*publisher)->Publish(Message("y"), absl::Now(),
+                                          packet_size).ok();
+    _exit(ok ? 0 : 1);
+  }
+  int status;
+  ASSERT_EQ(waitpid(child, &status, 0), child);
+  ASSERT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+  absl::MutexLock lock(&mutex);
+  EXPECT_TRUE(mutex.AwaitWithTimeout(
+      absl::Condition(
+          +[](std::vector<std::string>* values) { return values->size() == 2; },
+          &values),
+      absl::Seconds(10)));
+  EXPECT_THAT(values, ElementsAre("a/b=x", "a/b=y"));
+  EXPECT_EQ(subscriber_bus.shared_memory_overruns(), 0);
+}
+
+TEST_F(LocalBusTest, DeliversThroughSharedMemoryBetweenBusesOfOneProcess) {
+  // Buses skip only their own records, which does not depend on process ids.
+  LocalBus subscriber_bus(shared_memory_name_);
+  LocalBus publisher_bus(shared_memory_name_);
+  absl::Mutex mutex;
+  std::vector<std::string> values;
+  auto packet_callback = [&](absl::string_view topic,
+                             const PubSubPacketView& packet) {
+    google::protobuf::StringValue message;
+    ASSERT_TRUE(packet.UnpackTo(&message));
+    absl::MutexLock lock(&mutex);
+    values.push_back(absl::StrCat(topic, "=", message.value()));
+  };
+  ASSERT_OK_AND_ASSIGN(std::shared_ptr<LocalSubscriber> subscriber,
+                       subscriber_bus.Subscribe(
+                           "a", /*shared_memory=*/true,
+                           {.packet_callback = packet_callback}));
+  // Receives the message directly from the publisher, and not again from the
+  // ring.
+  ASSERT_OK_AND_ASSIGN(std::shared_ptr<LocalSubscriber> publisher_subscriber,
+                       publisher_bus.Subscribe(
+                           "a", /*shared_memory=*/true,
+                           {.packet_callback = packet_callback}));
+  ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<LocalPublisher> publisher,
+      publisher_bus.CreatePublisher("a", /*shared_memory=*/true));
+  size_t packet_size;
+  ASSERT_OK(publisher->Publish(Message("x"), absl::Now(), packet_size));
+
+  absl::MutexLock lock(&mutex);
+  EXPECT_TRUE(mutex.AwaitWithTimeout(
+      absl::Condition(
+          +[](std::vector<std::string>* values) { return values->size() >= 2; },
+          &values),
+      absl::Seconds(10)));
+  // Gives a duplicate delivery a chance to show up.
+  mutex.AwaitWithTimeout(
+      absl::Condition(
+          +[](std::vector<std::string>* values) { return values->size() > 2; },
+          &values),
+      absl::Milliseconds(100));
+  EXPECT_THAT(values, ElementsAre("a=x", "a=x"));
+}
+
+TEST_F(LocalBusTest, IntraProcessSubscribersIgnoreOtherProcesses) {
+  LocalBus bus(shared_memory_name_);
+  std::vector<std::string> topics;
+  ASSERT_OK_AND_ASSIGN(
+      std::shared_ptr<LocalSubscriber> subscriber,
+      bus.Subscribe("**", /*shared_memory=*/false,
+                    {.packet_callback = [&](absl::string_view topic,
+                                            const PubSubPacketView&) {
+                      topics.emplace_back(topic);
+                    }}));
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<LocalPublisher> publisher,
+                       bus.CreatePublisher("a", /*shared_memory=*/true));
+  size_t packet_size;
+  ASSERT_OK(publisher->Publish(Message("x"), absl::Now(), packet_size));
+  // Delivered once, directly.
+  EXPECT_THAT(topics, ElementsAre("a"));
+  EXPECT_GT(packet_size, 0);
+}
+
+}  // namespace
+}  // namespace intrinsic::local_transport
@@ -0,0 +1,415 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/platform/pubsub/local_transport/shared_memory_ring.h"
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <new>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+namespace intrinsic::local_transport {
+namespace {
+
+// Changes whenever the layout of the segment changes, so that processes with
+// different layouts never share a segment.
+constexpr uint64_t kMagic = 0x326e6952'6d687350;  // "PshmRin2"
+constexpr mode_t kShmMode = 0644;
+constexpr size_t kAlignment = 8;
+// Offset of the data from the start of the shared memory, i.e. the space for
+// the header, rounded up to full cache lines.
+constexpr size_t kDataOffset = 256;
+// How long Open() waits for another process to initialize a new ring, before
+// it considers the ring stale.
+constexpr absl::Duration kInitializationTimeout = absl::Seconds(1);
+
+// Marks a record that only fills up the end of the ring.
+constexpr uint32_t kPaddingTopicSize = 0xFFFFFFFF;
+
+struct RecordHeader {
+  uint64_t writer_id;
+  // Size of the record including this header and the alignment.
+  uint32_t size;
+  uint32_t topic_size;
+  uint32_t packet_size;
+  uint32_t reserved;
+};
+static_assert(sizeof(RecordHeader) % kAlignment == 0);
+
+constexpr size_t AlignUp(size_t size) {
+  return (size + kAlignment - 1) & ~(kAlignment - 1);
+}
+
+int64_t Futex(std::atomic<uint32_t>* word, int op, uint32_t value,
+              const timespec* timeout) {
+  // The futex is shared between processes, so FUTEX_PRIVATE_FLAG must not be
+  // set.
+  return syscall(SYS_futex, word, op, value, timeout, nullptr, 0);
+}
+
+absl::Status ErrnoError(absl::string_view what, absl::string_view name) {
+  return absl::InternalError(absl::StrCat(what, " failed for shared memory \"",
+                                          name, "\" with error: ",
+                                          strerror(errno), "."));
+}
+
+// Removes the shared memory `name` if it is still the segment that `fd` refers
+// to, i.e. if no other process replaced it in the meantime. Two processes that
+// find the same stale segment at the same time can still both remove it, in
+// which case the slower one may remove the replacement of the faster one. The
+// processes that mapped the removed replacement are then cut off from the
+// others until they reopen the ring.
+void UnlinkIfUnchanged(const std::string& name, int fd) {
+  const int current_fd = shm_open(name.c_str(), O_RDONLY, 0);
+  if (current_fd == -1) {
+    return;
+  }
+  struct stat stale_attributes;
+  struct stat current_attributes;
+  if (fstat(fd, &stale_attributes) == 0 &&
+      fstat(current_fd, &current_attributes) == 0 &&
+      stale_attributes.st_dev == current_attributes.st_dev &&
+      stale_attributes.st_ino == current_attributes.st_ino) {
+    shm_unlink(name.c_str());
+  }
+  close(current_fd);
+}
+
+}  // namespace
+
+// Lives at the start of the shared memory, followed by the data.
+struct SharedMemoryRing::Header {
+  std::atomic<uint64_t> magic;
+  uint64_t capacity;
+  // Serializes writers.
+  pthread_mutex_t mutex;
+  // Writers may be overwriting the data before this position.
+  alignas(64) std::atomic<uint64_t> reserve_position;
+  // End of the last complete record.
+  std::atomic<uint64_t> write_position;
+  // Incremented on every write so that readers can wait for it.
+  alignas(64) std::atomic<uint32_t> futex_word;
+  std::atomic<uint32_t> waiters;
+};
+
+absl::StatusOr<std::unique_ptr<SharedMemoryRing>> SharedMemoryRing::Open(
+    absl::string_view name, size_t capacity) {
+  static_assert(sizeof(Header) <= kDataOffset);
+  const std::string name_string(name);
+  capacity = AlignUp(capacity);
+  if (capacity < 4 * sizeof(RecordHeader)) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Capacity of ", capacity, " bytes is too small."));
+  }
+  absl::StatusOr<std::unique_ptr<SharedMemoryRing>> ring =
+      OpenOnce(name_string, capacity, /*replace_stale=*/true);
+  if (absl::IsAborted(ring.status())) {
+    // The stale segment was removed, so this creates a new one, unless another
+    // process was faster.
+    ring = OpenOnce(name_string, capacity, /*replace_stale=*/false);
+  }
+  return ring;
+}
+
+absl::StatusOr<std::unique_ptr<SharedMemoryRing>> SharedMemoryRing::OpenOnce(
+    const std::string& name, size_t capacity, bool replace_stale) {
+  int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, kShmMode);
+  const bool created = fd != -1;
+  if (!created && errno == EEXIST) {
+    fd = shm_open(name.c_str(), O_RDWR, kShmMode);
+  }
+  if (fd == -1) {
+    return ErrnoError("shm_open", name);
+  }
+  // Handles a segment that is not initialized in time. Its creator most
+  // likely died, and nobody else would ever initialize it.
+  auto stale = [&](absl::string_view reason) {
+    if (replace_stale) {
+      UnlinkIfUnchanged(name, fd);
+    }
+    close(fd);
+    const std::string message =
+        absl::StrCat("Shared memory \"", name, "\" ", reason, ".");
+    return replace_stale ? absl::AbortedError(message)
+                         : absl::FailedPreconditionError(message);
+  };
+
+  size_t mapping_size = kDataOffset + capacity;
+  if (created) {
+    if (ftruncate(fd, static_cast<off_t>(mapping_size)) == -1) {
+      const absl::Status status = ErrnoError("ftruncate", name);
+      close(fd);
+      shm_unlink(name.c_str());
+      return status;
+    }
+  } else {
+    // The creator might still be sizing the segment.
+    const absl::Time deadline = absl::Now() + kInitializationTimeout;
+    struct stat file_attributes;
+    while (true) {
+      if (fstat(fd, &file_attributes) == -1) {
+        const absl::Status status = ErrnoError("fstat", name);
+        close(fd);
+        return status;
+      }
+      if (file_attributes.st_size > static_cast<off_t>(kDataOffset)) {
+        break;
+      }
+      if (absl::Now() > deadline) {
+        return stale("was not initialized in time");
+      }
+      absl::SleepFor(absl::Milliseconds(1));
+    }
+    mapping_size = static_cast<size_t>(file_attributes.st_size);
+  }
+
+  void* mapping =
+      mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (mapping == MAP_FAILED) {
+    const absl::Status status = ErrnoError("mmap", name);
+    close(fd);
+    return status;
+  }
+  std::unique_ptr<SharedMemoryRing> ring(
+      new SharedMemoryRing(mapping, mapping_size));
+  Header& header = ring->header();
+
+  if (created) {
+    // The segment is zero-initialized, so the atomics already hold zero.
+    header.capacity = capacity;
+    pthread_mutexattr_t attributes;
+    pthread_mutexattr_init(&attributes);
+    pthread_mutexattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attributes, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(&header.mutex, &attributes);
+    pthread_mutexattr_destroy(&attributes);
+    header.magic.store(kMagic, std::memory_order_release);
+  } else {
+    const absl::Time deadline = absl::Now() + kInitializationTimeout;
+    while (true) {
+      const uint64_t magic = header.magic.load(std::memory_order_acquire);
+      if (magic == kMagic) {
+        break;
+      }
+      if (magic != 0) {
+        return stale("is not a ring or has an incompatible layout");
+      }
+      if (absl::Now() > deadline) {
+        return stale("was not initialized in time");
+      }
+      absl::SleepFor(absl::Milliseconds(1));
+    }
+    if (header.capacity == 0 || header.capacity % kAlignment != 0 ||
+        kDataOffset + header.capacity > mapping_size) {
+      close(fd);
+      return absl::FailedPreconditionError(absl::StrCat(
+          "Shared memory \"", name, "\" has an invalid capacity of ",
+          header.capacity, " bytes."));
+    }
+  }
+  close(fd);
+  ring->capacity_ = header.capacity;
+  return ring;
+}
+
+SharedMemoryRing::SharedMemoryRing(void* mapping, size_t mapping_size)
+    : mapping_(mapping),
+      mapping_size_(mapping_size),
+      header_(static_cast<Header*>(mapping)),
+      capacity_(0) {}
+
+SharedMemoryRing::~SharedMemoryRing() { munmap(mapping_, mapping_size_); }
+
+uint8_t* SharedMemoryRing::data() const {
+  return static_cast<uint8_t*>(mapping_) + kDataOffset;
+}
+
+size_t SharedMemoryRing::MaxRecordSize() const {
+  // Bounds how much a single write can skip at the end of the ring.
+  return capacity_ / 4 - sizeof(RecordHeader);
+}
+
+uint64_t SharedMemoryRing::WritePosition() const {
+  return header().write_position.load(std::memory_order_acquire);
+}
+
+absl::Status SharedMemoryRing::Write(uint64_t writer_id,
+                                     absl::string_view topic,
+                                     absl::string_view packet) {
+  if (topic.size() + packet.size() > MaxRecordSize()) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Record of ", topic.size() + packet.size(),
+        " bytes exceeds the limit of ", MaxRecordSize(), " bytes."));
+  }
+  const size_t record_size =
+      AlignUp(sizeof(RecordHeader) + topic.size() + packet.size());
+  Header& header = this->header();
+
+  int result = pthread_mutex_lock(&header.mutex);
+  if (result == EOWNERDEAD) {
+    // The previous writer died while writing. Its record was never committed
+    // because the write position is only advanced at the very end.
+    pthread_mutex_consistent(&header.mutex);
+  } else if (result != 0) {
+    return absl::InternalError(absl::StrCat(
+        "Locking the ring failed with error: ", strerror(result), "."));
+  }
+
+  uint64_t position = header.write_position.load(std::memory_order_relaxed);
+  size_t offset = position % capacity_;
+  const size_t padding =
+      capacity_ - offset < record_size ? capacity_ - offset : 0;
+  const uint64_t end = position + padding + record_size;
+
+  // Seqlock protocol: Announce the overwritten range before touching it, so
+  // that readers of the old data can detect that they read garbage.
+  header.reserve_position.store(end, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  if (padding >= sizeof(RecordHeader)) {
+    const RecordHeader padding_header = {
+        .writer_id = 0,
+        .size = static_cast<uint32_t>(padding),
+        .topic_size = kPaddingTopicSize,
+        .packet_size = 0,
+        .reserved = 0};
+    std::memcpy(data() + offset, &padding_header, sizeof(padding_header));
+  }
+  if (padding > 0) {
+    position += padding;
+    offset = 0;
+  }
+  const RecordHeader record_header = {
+      .writer_id = writer_id,
+      .size = static_cast<uint32_t>(record_size),
+      .topic_size = static_cast<uint32_t>(topic.size()),
+      .packet_size = static_cast<uint32_t>(packet.size()),
+      .reserved = 0};
+  uint8_t* record = data() + offset;
+  std::memcpy(record, &record_header, sizeof(record_header));
+  std::memcpy(record + sizeof(record_header), topic.data(), topic.size());
+  std::memcpy(record + sizeof(record_header) + topic.size(), packet.data(),
+              packet.size());
+
+  header.write_position.store(end, std::memory_order_seq_cst);
+  pthread_mutex_unlock(&header.mutex);
+
+  header.futex_word.fetch_add(1, std::memory_order_seq_cst);
+  if (header.waiters.load(std::memory_order_seq_cst) > 0) {
+    Futex(&header.futex_word, FUTEX_WAKE, INT_MAX, nullptr);
+  }
+  return absl::OkStatus();
+}
+
+SharedMemoryRing::ReadResult SharedMemoryRing::Read(uint64_t& position,
+                                                    std::string& buffer,
+                                                    Record& record) const {
+  const Header& header = this->header();
+  const uint64_t write_position =
+      header.write_position.load(std::memory_order_acquire);
+  // Returns true if the data at `position` might have been overwritten since
+  // it was copied.
+  auto overwritten = [&]() {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return header.reserve_position.load(std::memory_order_relaxed) >
+           position + capacity_;
+  };
+  auto overrun = [&]() {
+    position = header.write_position.load(std::memory_order_acquire);
+    return ReadResult::kOverrun;
+  };
+
+  while (true) {
+    if (position >= write_position) {
+      // A larger position means that the ring was recreated.
+      position = write_position;
+      return ReadResult::kEmpty;
+    }
+    if (write_position - position > capacity_) {
+      return overrun();
+    }
+
+    const size_t offset = position % capacity_;
+    const size_t remaining = capacity_ - offset;
+    if (remaining < sizeof(RecordHeader)) {
+      position += remaining;
+      continue;
+    }
+    RecordHeader record_header;
+    std::memcpy(&record_header, data() + offset, sizeof(record_header));
+    if (overwritten()) {
+      return overrun();
+    }
+    if (record_header.size < sizeof(RecordHeader) ||
+        record_header.size % kAlignment != 0 ||
+        record_header.size > remaining) {
+      // Only possible if another process corrupted the ring.
+      return overrun();
+    }
+    if (record_header.topic_size == kPaddingTopicSize) {
+      position += record_header.size;
+      continue;
+    }
+    const size_t payload_size =
+        size_t{record_header.topic_size} + record_header.packet_size;
+    if (sizeof(RecordHeader) + payload_size > record_header.size) {
+      return overrun();
+    }
+
+    buffer.resize(payload_size);
+    std::memcpy(buffer.data(), data() + offset + sizeof(RecordHeader),
+                payload_size);
+    if (overwritten()) {
+      return overrun();
+    }
+    record.writer_id = record_header.writer_id;
+    record.topic = absl::string_view(buffer.data(), record_header.topic_size);
+    record.packet = absl::string_view(buffer.data() + record_header.topic_size,
+                                      record_header.packet_size);
+    position += record_header.size;
+    return ReadResult::kRecord;
+  }
+}
+
+void SharedMemoryRing::Wait(uint64_t position, absl::Duration timeout) const {
+  Header& header = this->header();
+  const uint32_t futex_value =
+      header.futex_word.load(std::memory_order_seq_cst);
+  header.waiters.fetch_add(1, std::memory_order_seq_cst);
+  // A writer that advanced the position before the increment above might not
+  // have seen this waiter, so check again before sleeping.
+  if (header.write_position.load(std::memory_order_seq_cst) == position) {
+    const timespec relative_timeout = absl::ToTimespec(timeout);
+    // Returns immediately if the futex word changed since it was read.
+    Futex(&header.futex_word, FUTEX_WAIT, futex_value, &relative_timeout);
+  }
+  header.waiters.fetch_sub(1, std::memory_order_seq_cst);
+}
+
+void SharedMemoryRing::Wake() {
+  Header& header = this->header();
+  header.futex_word.fetch_add(1, std::memory_order_seq_cst);
+  Futex(&header.futex_word, FUTEX_WAKE, INT_MAX, nullptr);
+}
+
+}  // namespace intrinsic::local_transport
@@ -0,0 +1,112 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#ifndef INTRINSIC_PLATFORM_PUBSUB_LOCAL_TRANSPORT_SHARED_MEMORY_RING_H_
+#define INTRINSIC_PLATFORM_PUBSUB_LOCAL_TRANSPORT_SHARED_MEMORY_RING_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+
+namespace intrinsic::local_transport {
+
+// A broadcast ring of (topic, packet) records in a POSIX shared memory segment,
+// shared by all processes on a host that open the same name.
+//
+// Any thread of any process can write records. Writers are serialized by a
+// robust, process-shared mutex, so a writer that dies while holding it does
+// not block the others. Every reader keeps its own read position, so all
+// readers see all records. Readers never block writers: A reader that falls
+// more than the capacity behind loses the overwritten records and continues
+// with the records that are written afterwards.
+//
+// The segment outlives the processes and is reused by later processes. A
+// segment that was left uninitialized by a creator that died, or that has an
+// incompatible layout, is replaced by the next process that opens it.
+class SharedMemoryRing {
+ public:
+  static constexpr size_t kDefaultCapacity = 8 << 20;
+
+  struct Record {
+    // The `writer_id` that was passed to Write().
+    uint64_t writer_id;
+    absl::string_view topic;
+    absl::string_view packet;
+  };
+
+  enum class ReadResult {
+    // A record was read.
+    kRecord,
+    // There are no new records.
+    kEmpty,
+    // Records were overwritten before they could be read. The read position
+    // was moved to the current write position.
+    kOverrun,
+  };
+
+  // Opens the ring with the shared memory `name` (e.g. "/my_ring"), and
+  // creates it with `capacity` bytes (rounded up to a multiple of 8) if it
+  // doesn't exist yet. An existing ring keeps its capacity.
+  static absl::StatusOr<std::unique_ptr<SharedMemoryRing>> Open(
+      absl::string_view name, size_t capacity = kDefaultCapacity);
+
+  ~SharedMemoryRing();
+
+  SharedMemoryRing(const SharedMemoryRing&) = delete;
+  SharedMemoryRing& operator=(const SharedMemoryRing&) = delete;
+
+  // Appends a record. `writer_id` identifies the writer to the readers, e.g.
+  // so that they can skip their own records. Returns an error if the record is
+  // larger than MaxRecordSize(). Thread-safe and process-safe.
+  absl::Status Write(uint64_t writer_id, absl::string_view topic,
+                     absl::string_view packet);
+
+  // Size limit of the topic plus the packet of a record.
+  size_t MaxRecordSize() const;
+
+  // Position after the last record, i.e. the read position that only sees
+  // records that are written in the future.
+  uint64_t WritePosition() const;
+
+  // Reads the record at `position`. On success, copies it into `buffer`,
+  // which is reused across calls, points `record` into it and advances
+  // `position` to the next record. Thread-safe as long as every thread uses
+  // its own `position` and `buffer`.
+  ReadResult Read(uint64_t& position, std::string& buffer,
+                  Record& record) const;
+
+  // Waits until a record is written after `position`, until the `timeout`
+  // expires, or until Wake() is called.
+  void Wait(uint64_t position, absl::Duration timeout) const;
+
+  // Wakes all readers that wait on this ring, in all processes.
+  void Wake();
+
+ private:
+  struct Header;
+
+  // Like Open(). If the segment is stale, i.e. it was never initialized or has
+  // an incompatible layout, removes it with `replace_stale` and returns
+  // kAborted, or returns kFailedPrecondition otherwise.
+  static absl::StatusOr<std::unique_ptr<SharedMemoryRing>> OpenOnce(
+      const std::string& name, size_t capacity, bool replace_stale);
+
+  SharedMemoryRing(void* mapping, size_t mapping_size);
+
+  Header& header() const { return *header_; }
+  uint8_t* data() const;
+
+  void* mapping_;
+  size_t mapping_size_;
+  Header* header_;
+  size_t capacity_;
+};
+
+}  // namespace intrinsic::local_transport
+
+#endif  // INTRINSIC_PLATFORM_PUBSUB_LOCAL_TRANSPORT_SHARED_MEMORY_RING_H_
@@ -0,0 +1,180 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/platform/pubsub/local_transport/shared_memory_ring.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/time/time.h"
+#include "intrinsic/util/testing/gtest_wrapper.h"
+#include "intrinsic/util/thread/thread.h"
+
+namespace intrinsic::local_transport {
+namespace {
+
+using ::intrinsic::testing::StatusIs;
+using ReadResult = SharedMemoryRing::ReadResult;
+
+constexpr uint64_t kWriterId = 0x1234'5678'9abc'def0;
+
+// Creates a fresh ring that is unlinked again when the test ends.
+class SharedMemoryRingTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    name_ = absl::StrCat("/shared_memory_ring_test_", getpid(), "_",
+                         ::testing::UnitTest::GetInstance()
+                             ->current_test_info()
+                             ->name());
+    shm_unlink(name_.c_str());
+  }
+  void TearDown() override { shm_unlink(name_.c_str()); }
+
+  std::string name_;
+};
+
+TEST_F(SharedMemoryRingTest, ReadsWrittenRecords) {
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<SharedMemoryRing> writer,
+                       SharedMemoryRing::Open(name_, /*capacity=*/4096));
+  // A second mapping of the same ring, as another process would see it.
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<SharedMemoryRing> reader,
+                       SharedMemoryRing::Open(name_, /*capacity=*/1024));
+  EXPECT_EQ(reader->MaxRecordSize(), writer->MaxRecordSize());
+
+  uint64_t position = reader->WritePosition();
+  std::string buffer;
+  SharedMemoryRing::Record record;
+  EXPECT_EQ(reader->Read(position, buffer, record), ReadResult::kEmpty);
+
+  ASSERT_OK(writer->Write(kWriterId, "topic/a", "first"));
+  ASSERT_OK(writer->Write(kWriterId, "topic/b", ""));
+
+  ASSERT_EQ(reader->Read(position, buffer, record), ReadResult::kRecord);
+  EXPECT_EQ(record.writer_id, kWriterId);
+  EXPECT_EQ(record.topic, "topic/a");
+  EXPECT_EQ(record.packet, "first");
+  ASSERT_EQ(reader->Read(position, buffer, record), ReadResult::kRecord);
+  EXPECT_EQ(record.topic, "topic/b");
+  EXPECT_EQ(record.packet, "");
+  EXPECT_EQ(reader->Read(position, buffer, record), ReadResult::kEmpty);
+}
+
+TEST_F(SharedMemoryRingTest, WrapsAround) {
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<SharedMemoryRing> ring,
+                       SharedMemoryRing::Open(name_, /*capacity=*/1024));
+  uint64_t position = ring->WritePosition();
+  std::string buffer;
+  SharedMemoryRing::Record record;
+  // Record sizes that don't divide the capacity, so that records have to
+  // skip the end of the ring.
+  for (int i = 0; i < 100; ++i) {
+    const std::string packet(i % 50, static_cast<char>('a' + i % 26));
+    ASSERT_OK(ring->Write(kWriterId, "t", packet));
+    ASSERT_EQ(ring->Read(position, buffer, record), ReadResult::kRecord);
+    EXPECT_EQ(record.packet, packet);
+  }
+  EXPECT_GT(position, 1024);
+}
+
+TEST_F(SharedMemoryRingTest, DetectsOverrun) {
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<SharedMemoryRing> ring,
+                       SharedMemoryRing::Open(name_, /*capacity=*/1024));
+  uint64_t position = ring->WritePosition();
+  std::string buffer;
+  SharedMemoryRing::Record record;
+  for (int i = 0; i < 20; ++i) {
+    ASSERT_OK(ring->Write(kWriterId, "t", std::string(100, 'x')));
+  }
+  EXPECT_EQ(ring->Read(position, buffer, record), ReadResult::kOverrun);
+  EXPECT_EQ(position, ring->WritePosition());
+
+  ASSERT_OK(ring->Write(kWriterId, "t", "after"));
+  ASSERT_EQ(ring->Read(position, buffer, record), ReadResult::kRecord);
+  EXPECT_EQ(record.packet, "after");
+}
+
+TEST_F(SharedMemoryRingTest, RejectsLargeRecords) {
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<SharedMemoryRing> ring,
+                       SharedMemoryRing::Open(name_, /*capacity=*/1024));
+  EXPECT_THAT(ring->Write(kWriterId, "t", std::string(ring->MaxRecordSize(), 'x')),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_OK(ring->Write(kWriterId, "t", std::string(ring->MaxRecordSize() - 1, 'x')));
+}
+
+TEST_F(SharedMemoryRingTest, ReplacesUninitializedSegment) {
+  // A creator that died before it initialized the segment leaves it like this.
+  const int fd = shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+  ASSERT_NE(fd, -1);
+  ASSERT_EQ(ftruncate(fd, 4096), 0);
+  close(fd);
+
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<SharedMemoryRing> ring,
+                       SharedMemoryRing::Open(name_, /*capacity=*/1024));
+  uint64_t position = ring->WritePosition();
+  ASSERT_OK(ring->Write(kWriterId, "t", "x"));
+  std::string buffer;
+  SharedMemoryRing::Record record;
+  ASSERT_EQ(ring->Read(position, buffer, record), ReadResult::kRecord);
+  EXPECT_EQ(record.packet, "x");
+}
+
+TEST_F(SharedMemoryRingTest, ReplacesSegmentWithOtherLayout) {
+  const int fd = shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+  ASSERT_NE(fd, -1);
+  ASSERT_EQ(ftruncate(fd, 4096), 0);
+  const uint64_t other_magic = 0x676e6952'6d687350;
+  ASSERT_EQ(pwrite(fd, &other_magic, sizeof(other_magic), 0),
+            sizeof(other_magic));
+  close(fd);
+
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<SharedMemoryRing> ring,
+                       SharedMemoryRing::Open(name_, /*capacity=*/1024));
+  EXPECT_OK(ring->Write(kWriterId, "t", "x"));
+}
+
+TEST_F(SharedMemoryRingTest, WakesWaitingReader) {
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<SharedMemoryRing> ring,
+                       SharedMemoryRing::Open(name_, /*capacity=*/4096));
+  constexpr int kRecords = 1000;
+  uint64_t position = ring->WritePosition();
+  int received = 0;
+  int overruns = 0;
+  intrinsic::Thread reader([&]() {
+    std::string buffer;
+    SharedMemoryRing::Record record;
+    while (received + overruns < kRecords) {
+      switch (ring->Read(position, buffer, record)) {
+        case ReadResult::kRecord:
+          ++received;
+          break;
+        case ReadResult::kOverrun:
+          // The count of lost records is unknown, stop at the next record.
+          overruns = kRecords;
+          break;
+        case ReadResult::kEmpty:
+          ring->Wait(position, absl::Seconds(10));
+          break;
+      }
+    }
+  });
+  for (int i = 0; i < kRecords; ++i) {
+    ASSERT_OK(ring->Write(kWriterId, "topic", absl::StrCat(i)));
+    if (i % 10 == 0) {
+      // Gives the reader a chance to keep up.
+      absl::SleepFor(absl::Microseconds(100));
+    }
+  }
+  reader.Join();
+  EXPECT_GT(received, 0);
+}
+
+}  // namespace
+}  // namespace intrinsic::local_transport
@@ -2,30 +2,146 @@
 
 #include "intrinsic/platform/pubsub/publisher_stats.h"
 
-#include <limits>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "intrinsic/icon/interprocess/log2_histogram.h"
 
 namespace intrinsic::internal {
 
-int PublisherStats::GetCount(absl::string_view topic) {
+absl::Duration TopicPublisherStatsSnapshot::LatencyPercentile(
+    double quantile) const {
+  return icon::Log2HistogramPercentile(
+      latency_buckets, absl::ToInt64Nanoseconds(max_latency), quantile);
+}
+
+void TopicPublisherStats::RecordPublish(size_t bytes, absl::Duration latency) {
+  messages_.fetch_add(1, std::memory_order_relaxed);
+  bytes_.fetch_add(static_cast<int64_t>(bytes), std::memory_order_relaxed);
+  RecordLatency(latency);
+}
+
+void TopicPublisherStats::RecordFailure(absl::Duration latency) {
+  failures_.fetch_add(1, std::memory_order_relaxed);
+  RecordLatency(latency);
+}
+
+void TopicPublisherStats::RecordLatency(absl::Duration latency) {
+  const int64_t latency_ns =
+      std::max<int64_t>(absl::ToInt64Nanoseconds(latency), 0);
+  latency_buckets_[icon::Log2HistogramBucket(latency_ns)].fetch_add(
+      1, std::memory_order_relaxed);
+  int64_t max_ns = max_latency_ns_.load(std::memory_order_relaxed);
+  while (latency_ns > max_ns &&
+         !max_latency_ns_.compare_exchange_weak(max_ns, latency_ns,
+                                                std::memory_order_relaxed)) {
+  }
+}
+
+void TopicPublisherStats::Reset() {
+  messages_.store(0, std::memory_order_relaxed);
+  bytes_.store(0, std::memory_order_relaxed);
+  failures_.store(0, std::memory_order_relaxed);
+  for (std::atomic<uint64_t>& bucket : latency_buckets_) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+  max_latency_ns_.store(0, std::memory_order_relaxed);
+}
+
+std::shared_ptr<TopicPublisherStats> PublisherStats::Register(
+    absl::string_view topic) {
   absl::MutexLock lock(&mu_);
-  return counts_[topic];
+  Topic& entry = topics_[topic];
+  if (entry.stats == nullptr) {
+    entry.stats = std::make_shared<TopicPublisherStats>();
+    entry.start_time = absl::Now();
+  }
+  return entry.stats;
 }
 
-void PublisherStats::Increment(absl::string_view topic) {
+int PublisherStats::GetCount(absl::string_view topic) {
   absl::MutexLock lock(&mu_);
-  if (counts_[topic] == std::numeric_limits<int64_t>::max()) {
-    counts_[topic] = 0;
+  auto it = topics_.find(topic);
+  if (it == topics_.end()) {
+    return 0;
+  }
+  return static_cast<int>(it->second.stats->messages_published());
+}
+
+std::vector<TopicPublisherStatsSnapshot> PublisherStats::Snapshot(
+    absl::Span<const TopicPublisherStatsSnapshot> previous) const {
+  absl::flat_hash_map<absl::string_view, const TopicPublisherStatsSnapshot*>
+      previous_by_topic;
+  previous_by_topic.reserve(previous.size());
+  for (const TopicPublisherStatsSnapshot& snapshot : previous) {
+    previous_by_topic[snapshot.topic] = &snapshot;
   }
-  counts_[topic]++;
+
+  std::vector<TopicPublisherStatsSnapshot> snapshots;
+  absl::ReaderMutexLock lock(&mu_);
+  const absl::Time now = absl::Now();
+  snapshots.reserve(topics_.size());
+  for (const auto& [topic, entry] : topics_) {
+    const TopicPublisherStats& stats = *entry.stats;
+    TopicPublisherStatsSnapshot& snapshot = snapshots.emplace_back();
+    snapshot.topic = topic;
+    snapshot.time = now;
+    snapshot.messages_published =
+        stats.messages_.load(std::memory_order_relaxed);
+    snapshot.bytes_published = stats.bytes_.load(std::memory_order_relaxed);
+    snapshot.failed_publishes = stats.failures_.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < kNumPublishLatencyBuckets; ++i) {
+      snapshot.latency_buckets[i] =
+          stats.latency_buckets_[i].load(std::memory_order_relaxed);
+    }
+    snapshot.max_latency = absl::Nanoseconds(
+        stats.max_latency_ns_.load(std::memory_order_relaxed));
+
+    absl::Time start_time = entry.start_time;
+    int64_t start_messages = 0;
+    int64_t start_bytes = 0;
+    // A snapshot from before a reset counts more than the counters now.
+    if (auto it = previous_by_topic.find(topic);
+        it != previous_by_topic.end() && it->second->time >= entry.start_time) {
+      start_time = it->second->time;
+      start_messages = it->second->messages_published;
+      start_bytes = it->second->bytes_published;
+    }
+    const double elapsed_seconds = absl::ToDoubleSeconds(now - start_time);
+    if (elapsed_seconds > 0.0) {
+      snapshot.messages_per_second =
+          (snapshot.messages_published - start_messages) / elapsed_seconds;
+      snapshot.bytes_per_second =
+          (snapshot.bytes_published - start_bytes) / elapsed_seconds;
+    }
+  }
+  std::sort(snapshots.begin(), snapshots.end(),
+            [](const TopicPublisherStatsSnapshot& a,
+               const TopicPublisherStatsSnapshot& b) {
+              return a.topic < b.topic;
+            });
+  return snapshots;
 }
 
 void PublisherStats::Reset() {
   absl::MutexLock lock(&mu_);
-  counts_.clear();
+  const absl::Time now = absl::Now();
+  // Publishers keep pointers to the counters, so reset them in place.
+  for (auto& [topic, entry] : topics_) {
+    entry.stats->Reset();
+    entry.start_time = now;
+  }
 }
 
 void ResetMessagesPublished() { return PublisherStats::Singleton().Reset(); }
@@ -34,4 +150,9 @@ int MessagesPublished(absl::string_view topic) {
   return PublisherStats::Singleton().GetCount(topic);
 }
 
+std::vector<TopicPublisherStatsSnapshot> GetPublisherStats(
+    absl::Span<const TopicPublisherStatsSnapshot> previous) {
+  return PublisherStats::Singleton().Snapshot(previous);
+}
+
 }  // namespace intrinsic::internal
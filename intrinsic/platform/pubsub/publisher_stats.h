@@ -3,21 +3,110 @@
 #ifndef INTRINSIC_PLATFORM_PUBSUB_PUBLISHER_STATS_H_
 #define INTRINSIC_PLATFORM_PUBSUB_PUBLISHER_STATS_H_
 
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "absl/base/thread_annotations.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "intrinsic/icon/interprocess/log2_histogram.h"
 
 namespace intrinsic::internal {
 
+// Number of publish latency histogram buckets. The buckets are powers of two
+// in nanoseconds, see intrinsic/icon/interprocess/log2_histogram.h.
+inline constexpr size_t kNumPublishLatencyBuckets =
+    icon::kNumLog2HistogramBuckets;
+
+// Statistics of the publishers of one topic at a point in time.
+struct TopicPublisherStatsSnapshot {
+  std::string topic;
+  // When the snapshot was taken.
+  absl::Time time = absl::InfinitePast();
+  // Successfully published messages and their serialized size. Messages that
+  // were only handed to subscribers in this process without serialization
+  // don't count towards the size.
+  int64_t messages_published = 0;
+  int64_t bytes_published = 0;
+  int64_t failed_publishes = 0;
+  // Histogram and maximum of the time spent in Publisher::Publish(), including
+  // failed publishes.
+  std::array<uint64_t, kNumPublishLatencyBuckets> latency_buckets = {};
+  absl::Duration max_latency = absl::ZeroDuration();
+  // Rate of published messages and bytes since the previous snapshot passed to
+  // PublisherStats::Snapshot(), or since the topic was registered or reset
+  // without one.
+  double messages_per_second = 0.0;
+  double bytes_per_second = 0.0;
+
+  // Returns an upper bound of the `quantile` (in [0, 1]) of the publish
+  // latency, see icon::Log2HistogramPercentile(), or zero if nothing was
+  // published.
+  absl::Duration LatencyPercentile(double quantile) const;
+};
+
+// Counters of the publishers of one topic.
+//
+// Recording is lock-free. The counters are aligned to cache lines, so that
+// publishers of different topics don't contend.
+class TopicPublisherStats {
+ public:
+  TopicPublisherStats() = default;
+  TopicPublisherStats(const TopicPublisherStats&) = delete;
+  TopicPublisherStats& operator=(const TopicPublisherStats&) = delete;
+
+  // Records a successful publish of a message of `bytes` bytes.
+  void RecordPublish(size_t bytes, absl::Duration latency);
+  // Records a failed publish.
+  void RecordFailure(absl::Duration latency);
+
+  int64_t messages_published() const {
+    return messages_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  friend class PublisherStats;
+
+  void RecordLatency(absl::Duration latency);
+  void Reset();
+
+  alignas(64) std::atomic<int64_t> messages_ = 0;
+  std::atomic<int64_t> bytes_ = 0;
+  std::atomic<int64_t> failures_ = 0;
+  alignas(64) std::array<std::atomic<uint64_t>, kNumPublishLatencyBuckets>
+      latency_buckets_ = {};
+  std::atomic<int64_t> max_latency_ns_ = 0;
+};
+
+// Registry of the publisher statistics of this process.
+//
+// Publishers register their topic once when they are created and then record
+// into the returned counters without taking a lock. Only registration and
+// reading the statistics lock the registry. Reading doesn't modify the
+// registry, so several readers don't affect each other's rates.
 class PublisherStats {
  public:
+  // Returns the counters of `topic`. All publishers of a topic share the same
+  // counters.
+  std::shared_ptr<TopicPublisherStats> Register(absl::string_view topic);
+
   int GetCount(absl::string_view topic);
 
-  void Increment(absl::string_view topic);
+  // Returns the statistics of all registered topics, ordered by topic. The
+  // rates cover the time since the snapshot of the same topic in `previous`,
+  // usually the result of the caller's previous call.
+  std::vector<TopicPublisherStatsSnapshot> Snapshot(
+      absl::Span<const TopicPublisherStatsSnapshot> previous = {}) const;
 
+  // Resets all counters to zero.
   void Reset();
 
   static PublisherStats& Singleton() {
@@ -26,14 +115,25 @@ class PublisherStats {
   }
 
  private:
-  absl::Mutex mu_;
-  absl::flat_hash_map<std::string, int64_t> counts_ ABSL_GUARDED_BY(mu_);
+  struct Topic {
+    std::shared_ptr<TopicPublisherStats> stats;
+    // When the topic was registered or last reset. Rates of snapshots without
+    // a previous one, or with one from before a reset, start here.
+    absl::Time start_time;
+  };
+
+  mutable absl::Mutex mu_;
+  absl::flat_hash_map<std::string, Topic> topics_ ABSL_GUARDED_BY(mu_);
 };
 
 // How many pubsub messages have been sent by this process for a given topic.
 int MessagesPublished(absl::string_view topic);
 // Reset the MessagePublished counters to 0.
 void ResetMessagesPublished();
+// Returns the publisher statistics of all topics of this process, with rates
+// since `previous`, see PublisherStats::Snapshot().
+std::vector<TopicPublisherStatsSnapshot> GetPublisherStats(
+    absl::Span<const TopicPublisherStatsSnapshot> previous = {});
 
 }  // namespace intrinsic::internal
 
@@ -0,0 +1,142 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/platform/pubsub/publisher_stats.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "intrinsic/util/testing/gtest_wrapper.h"
+#include "intrinsic/util/thread/thread.h"
+
+namespace intrinsic::internal {
+namespace {
+
+using ::testing::SizeIs;
+
+TEST(PublisherStatsTest, SharesCountersPerTopic) {
+  PublisherStats registry;
+  std::shared_ptr<TopicPublisherStats> first = registry.Register("/a");
+  std::shared_ptr<TopicPublisherStats> second = registry.Register("/a");
+  EXPECT_EQ(first, second);
+  EXPECT_NE(registry.Register("/b"), first);
+
+  first->RecordPublish(/*bytes=*/10, absl::Microseconds(3));
+  second->RecordPublish(/*bytes=*/20, absl::Microseconds(3));
+  EXPECT_EQ(registry.GetCount("/a"), 2);
+  EXPECT_EQ(registry.GetCount("/b"), 0);
+  EXPECT_EQ(registry.GetCount("/unknown"), 0);
+}
+
+TEST(PublisherStatsTest, SnapshotsCountersAndLatency) {
+  PublisherStats registry;
+  std::shared_ptr<TopicPublisherStats> stats = registry.Register("/b");
+  registry.Register("/a");
+  for (int i = 0; i < 9; ++i) {
+    stats->RecordPublish(/*bytes=*/100, absl::Nanoseconds(1000));
+  }
+  stats->RecordFailure(absl::Milliseconds(1));
+
+  std::vector<TopicPublisherStatsSnapshot> snapshots = registry.Snapshot();
+  ASSERT_THAT(snapshots, SizeIs(2));
+  EXPECT_EQ(snapshots[0].topic, "/a");
+  EXPECT_EQ(snapshots[0].messages_published, 0);
+  EXPECT_EQ(snapshots[0].LatencyPercentile(0.5), absl::ZeroDuration());
+  const TopicPublisherStatsSnapshot& snapshot = snapshots[1];
+  EXPECT_EQ(snapshot.topic, "/b");
+  EXPECT_EQ(snapshot.messages_published, 9);
+  EXPECT_EQ(snapshot.bytes_published, 900);
+  EXPECT_EQ(snapshot.failed_publishes, 1);
+  EXPECT_GT(snapshot.messages_per_second, 0.0);
+  EXPECT_GT(snapshot.bytes_per_second, 0.0);
+  EXPECT_EQ(snapshot.max_latency, absl::Milliseconds(1));
+  // 1000ns is in the bucket [512ns, 1024ns). 1ms is in [2^19ns, 2^20ns), for
+  // which the maximum is the tighter bound.
+  EXPECT_EQ(snapshot.LatencyPercentile(0.5), absl::Nanoseconds(1024));
+  EXPECT_EQ(snapshot.LatencyPercentile(1.0), absl::Milliseconds(1));
+
+  // Rates only cover the time since the previous snapshot.
+  snapshots = registry.Snapshot(snapshots);
+  EXPECT_EQ(snapshots[1].messages_published, 9);
+  EXPECT_EQ(snapshots[1].messages_per_second, 0.0);
+}
+
+TEST(PublisherStatsTest, ReadersDontAffectEachOthersRates) {
+  PublisherStats registry;
+  std::shared_ptr<TopicPublisherStats> stats = registry.Register("/a");
+  stats->RecordPublish(/*bytes=*/10, absl::ZeroDuration());
+  const std::vector<TopicPublisherStatsSnapshot> first_reader =
+      registry.Snapshot();
+  ASSERT_THAT(first_reader, SizeIs(1));
+
+  stats->RecordPublish(/*bytes=*/10, absl::ZeroDuration());
+  // Another reader in between doesn't restart the rate of the first one.
+  const std::vector<TopicPublisherStatsSnapshot> second_reader =
+      registry.Snapshot();
+  ASSERT_THAT(second_reader, SizeIs(1));
+  EXPECT_GT(second_reader[0].messages_per_second, 0.0);
+
+  const std::vector<TopicPublisherStatsSnapshot> snapshots =
+      registry.Snapshot(first_reader);
+  ASSERT_THAT(snapshots, SizeIs(1));
+  EXPECT_EQ(snapshots[0].messages_published, 2);
+  EXPECT_GT(snapshots[0].messages_per_second, 0.0);
+  EXPECT_GT(snapshots[0].bytes_per_second, 0.0);
+}
+
+TEST(PublisherStatsTest, RatesIgnoreSnapshotsFromBeforeAReset) {
+  PublisherStats registry;
+  std::shared_ptr<TopicPublisherStats> stats = registry.Register("/a");
+  for (int i = 0; i < 10; ++i) {
+    stats->RecordPublish(/*bytes=*/10, absl::ZeroDuration());
+  }
+  const std::vector<TopicPublisherStatsSnapshot> before_reset =
+      registry.Snapshot();
+  absl::SleepFor(absl::Milliseconds(1));
+  registry.Reset();
+  stats->RecordPublish(/*bytes=*/10, absl::ZeroDuration());
+
+  const std::vector<TopicPublisherStatsSnapshot> snapshots =
+      registry.Snapshot(before_reset);
+  ASSERT_THAT(snapshots, SizeIs(1));
+  EXPECT_EQ(snapshots[0].messages_published, 1);
+  EXPECT_GT(snapshots[0].messages_per_second, 0.0);
+}
+
+TEST(PublisherStatsTest, ResetKeepsRegisteredCounters) {
+  PublisherStats registry;
+  std::shared_ptr<TopicPublisherStats> stats = registry.Register("/a");
+  stats->RecordPublish(/*bytes=*/1, absl::ZeroDuration());
+  registry.Reset();
+  EXPECT_EQ(registry.GetCount("/a"), 0);
+  stats->RecordPublish(/*bytes=*/1, absl::ZeroDuration());
+  EXPECT_EQ(registry.GetCount("/a"), 1);
+}
+
+TEST(PublisherStatsTest, CountsConcurrentPublishes) {
+  PublisherStats registry;
+  constexpr int kThreads = 4;
+  constexpr int kPublishesPerThread = 10000;
+  std::vector<intrinsic::Thread> threads;
+  for (int i = 0; i < kThreads; ++i) {
+    threads.emplace_back([stats = registry.Register("/a")]() {
+      for (int j = 0; j < kPublishesPerThread; ++j) {
+        stats->RecordPublish(/*bytes=*/2, absl::Nanoseconds(j));
+      }
+    });
+  }
+  for (intrinsic::Thread& thread : threads) {
+    thread.Join();
+  }
+  std::vector<TopicPublisherStatsSnapshot> snapshots = registry.Snapshot();
+  ASSERT_THAT(snapshots, SizeIs(1));
+  EXPECT_EQ(snapshots[0].messages_published, kThreads * kPublishesPerThread);
+  EXPECT_EQ(snapshots[0].bytes_published, 2 * kThreads * kPublishesPerThread);
+}
+
+}  // namespace
+}  // namespace intrinsic::internal
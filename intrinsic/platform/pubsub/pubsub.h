@@ -5,6 +5,8 @@
 
 #include <functional>
 #include <memory>
+#include <string>
+#include <type_traits>
 #include <utility>
 
 #include "absl/log/log.h"
@@ -12,10 +14,11 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
-#include "google/protobuf/any.pb.h"
+#include "absl/synchronization/mutex.h"
 #include "google/protobuf/message.h"
 #include "intrinsic/platform/pubsub/adapters/pubsub.pb.h"
 #include "intrinsic/platform/pubsub/publisher.h"
+#include "intrinsic/platform/pubsub/pubsub_packet_view.h"
 #include "intrinsic/platform/pubsub/subscription.h"
 
 // The PubSub class implements an interface to a publisher-subscriber
@@ -64,7 +67,24 @@ struct TopicConfig {
     HighReliability = 1,
   };
 
+  // How messages are exchanged between publishers and subscribers. Topics and
+  // key expressions have the same semantics for all transports.
+  enum class Transport {
+    // Zenoh, which reaches all participants. Publishers also hand their
+    // messages to the subscribers of the local transports in this process.
+    kZenoh,
+    // Only within this process. Messages are delivered on the publishing
+    // thread before Publish() returns, and subscribers of the published type
+    // receive the published message itself, without serialization.
+    kIntraProcess,
+    // Like kIntraProcess, plus a shared memory ring which reaches the
+    // kSharedMemory subscribers of all processes on this host.
+    kSharedMemory,
+  };
+
   TopicQoS topic_qos = HighReliability;
+  // The QoS only applies to kZenoh.
+  Transport transport = Transport::kZenoh;
 };
 
 // The following two callbacks are defined to be used asynchronously when a
@@ -88,6 +108,44 @@ using SubscriptionErrorCallback =
 
 struct PubSubData;
 
+namespace internal {
+
+// A message which is reused to parse the payloads of a subscription.
+//
+// Use() hands out the reused message if no other thread is using it, which is
+// the common case because packets of a topic are delivered in order.
+// Otherwise, it creates a temporary message, so concurrent callbacks never
+// block each other.
+template <typename T>
+class ReusableMessage {
+ public:
+  explicit ReusableMessage(const T& exemplar)
+      : message_(exemplar.New()),
+        type_name_(exemplar.GetDescriptor()->full_name()) {}
+
+  const std::string& type_name() const { return type_name_; }
+  bool Is(absl::string_view type_name) const { return type_name == type_name_; }
+
+  template <typename F>
+  void Use(F&& f) {
+    if (mutex_.TryLock()) {
+      f(*message_);
+      mutex_.Unlock();
+      return;
+    }
+    std::unique_ptr<T> message(message_->New());
+    f(*message);
+  }
+
+ private:
+  absl::Mutex mutex_;
+  // Only accessed while holding `mutex_`, except for calling New().
+  std::unique_ptr<T> message_;
+  const std::string type_name_;
+};
+
+}  // namespace internal
+
 // This class is thread-safe.
 class PubSub {
  public:
@@ -95,6 +153,11 @@ class PubSub {
   explicit PubSub(absl::string_view participant_name);
   explicit PubSub(absl::string_view participant_name, absl::string_view config);
 
+  // Creates a PubSub which doesn't connect to Zenoh, e.g. as a hermetic
+  // stand-in for tests. All topics use TopicConfig::Transport::kIntraProcess,
+  // unless they ask for kSharedMemory.
+  static PubSub LocalOnly();
+
   PubSub(const PubSub&) = delete;
   PubSub& operator=(const PubSub&) = delete;
   PubSub(PubSub&&) = default;
@@ -141,9 +204,11 @@ class PubSub {
   // Creates a subscription using an exemplar, i.e. a sample proto message.
   //
   // This function requires an exemplar (a sample message) to be passed in
-  // which can hold the payload of a PubSubPacket. The exemplar is used during
-  // each callback to create a new proto message, to extract the payload from
-  // the PubSubPacket and it is then passed to the actual callback function.
+  // which can hold the payload of a PubSubPacket. The type of the exemplar is
+  // resolved once, and the payload of each received packet is parsed into a
+  // message created from the exemplar, which is then passed to the actual
+  // callback function. The message is reused for subsequent packets, so the
+  // callback must not keep references to it.
   template <typename T>
   absl::StatusOr<Subscription> CreateSubscription(
       absl::string_view topic, const TopicConfig& config, const T& exemplar,
@@ -153,28 +218,50 @@ class PubSub {
                   "Protocol buffers are the only supported serialization "
                   "format for PubSub.");
 
-    // This payload is shared between callbacks and may be read from multiple
+    // The payload is shared between callbacks, which may run on multiple
     // threads. We need a shared_ptr here because a std::function must be
     // copyable.
-    std::shared_ptr<T> shared_payload(exemplar.New());
-
-    // The message callback is never copied. It is merely moved to this helper
-    // lambda which is itself moved to the subscription class.
-    auto package_to_payload =
-        [callback = std::move(msg_callback),
-         error_callback = std::move(error_callback),
-         shared_payload = std::move(shared_payload)](
-            const intrinsic_proto::pubsub::PubSubPacket& packet) {
-          // Create a local copy of the shared payload which we can safely
-          // modify in different threads.
-          std::unique_ptr<T> payload(shared_payload->New());
-          if (!packet.payload().UnpackTo(payload.get())) {
-            HandleError(error_callback, packet, *payload);
-            return;
+    auto payload = std::make_shared<internal::ReusableMessage<T>>(exemplar);
+    // The message callback is never copied. It is shared by the helper lambdas
+    // below, which are moved to the subscription class.
+    auto callback =
+        std::make_shared<SubscriptionOkCallback<T>>(std::move(msg_callback));
+
+    auto packet_to_payload = [callback,
+                              error_callback = std::move(error_callback),
+                              payload = std::move(payload)](
+                                 const PubSubPacketView& packet) {
+      if (!payload->Is(packet.payload_type_name())) {
+        HandleError(error_callback, packet, payload->type_name());
+        return;
+      }
+      payload->Use([&](T& message) {
+        if (!message.ParseFromArray(
+                packet.serialized_payload().data(),
+                static_cast<int>(packet.serialized_payload().size()))) {
+          HandleError(error_callback, packet, payload->type_name());
+          return;
+        }
+        (*callback)(message);
+      });
+    };
+    // Receives the published message itself from publishers of the local
+    // transports. Messages of another type take the packet path instead.
+    auto message_to_payload =
+        [callback, descriptor = exemplar.GetDescriptor()](
+            const google::protobuf::Message& message) {
+          if (message.GetDescriptor() != descriptor) {
+            return false;
           }
-          callback(*payload);
+          const T* typed_message = dynamic_cast<const T*>(&message);
+          if (typed_message == nullptr) {
+            return false;
+          }
+          (*callback)(*typed_message);
+          return true;
         };
-    return CreateSubscription(topic, config, std::move(package_to_payload));
+    return CreateRawSubscription(topic, config, std::move(packet_to_payload),
+                                 std::move(message_to_payload));
   }
 
   // Creates a subscription for a raw PubSubPacket. This kind of subscription is
@@ -190,6 +277,15 @@ class PubSub {
       SubscriptionOkExpandedCallback<intrinsic_proto::pubsub::PubSubPacket>
           msg_callback) const;
 
+  // Creates a subscription which hands each packet to the callback as a lazily
+  // parsed view. Only the envelope of the packet is decoded, so subscribers
+  // that filter packets, e.g. by payload type or publish time, never decode
+  // the payload unless they call PubSubPacketView::UnpackTo(). The view is
+  // only valid during the callback.
+  absl::StatusOr<Subscription> CreateRawSubscription(
+      absl::string_view topic, const TopicConfig& config,
+      SubscriptionOkCallback<PubSubPacketView> msg_callback) const;
+
   // Test if a key expression is "canonical", meaning that it has a valid
   // combination of wildcards, no illegal characters, no trailing slash, etc.
   bool KeyexprIsCanon(absl::string_view keyexpr) const;
@@ -207,20 +303,34 @@ class PubSub {
                                        absl::string_view right) const;
 
  private:
+  explicit PubSub(std::shared_ptr<PubSubData> data);
+
+  // Like the public overload, but subscriptions of a local transport pass the
+  // published message itself to `message_callback` if it returns true, see
+  // local_transport::LocalSubscriberCallbacks.
+  absl::StatusOr<Subscription> CreateRawSubscription(
+      absl::string_view topic, const TopicConfig& config,
+      SubscriptionOkCallback<PubSubPacketView> msg_callback,
+      std::function<bool(const google::protobuf::Message&)> message_callback)
+      const;
+
   static void HandleError(const SubscriptionErrorCallback& error_callback,
-                          const intrinsic_proto::pubsub::PubSubPacket& packet,
-                          const google::protobuf::Message& payload) {
+                          const PubSubPacketView& packet,
+                          absl::string_view expected_type_name) {
+    absl::Status error = absl::InvalidArgumentError(
+        absl::StrCat("Expected payload of type ", expected_type_name,
+                     " but got ", packet.type_url()));
     if (error_callback == nullptr) {
-      LOG(ERROR) << (packet.DebugString(),
-                     absl::InvalidArgumentError(absl::StrCat(
-                         "Expected payload of type ", payload.GetTypeName(),
-                         " but got ", packet.payload().type_url())));
+      LOG(ERROR) << error;
       return;
     }
-    error_callback(packet.DebugString(),
-                   absl::InvalidArgumentError(absl::StrCat(
-                       "Expected payload of type ", payload.GetTypeName(),
-                       " but got ", packet.payload().type_url())));
+    // Only the error path decodes the whole packet.
+    absl::StatusOr<intrinsic_proto::pubsub::PubSubPacket> packet_proto =
+        packet.ToProto();
+    const std::string packet_string = packet_proto.ok()
+                                          ? packet_proto->DebugString()
+                                          : std::string(packet.type_url());
+    error_callback(packet_string, error);
   }
 
   // We use a shared_ptr here because it allows us to auto generate the
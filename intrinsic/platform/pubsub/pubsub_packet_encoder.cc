@@ -0,0 +1,134 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/platform/pubsub/pubsub_packet_encoder.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/message.h"
+#include "google/protobuf/timestamp.pb.h"
+#include "intrinsic/util/proto_time.h"
+#include "intrinsic/util/status/status_macros.h"
+
+namespace intrinsic::internal {
+namespace {
+
+using ::google::protobuf::io::CodedOutputStream;
+
+constexpr absl::string_view kTypeUrlPrefix = "type.googleapis.com/";
+
+// Tags of the fields in `PubSubPacket`, `google.protobuf.Any` and
+// `google.protobuf.Timestamp` that the encoder writes. All of them fit into a
+// single byte.
+constexpr uint8_t kPacketPayloadTag = (1 << 3) | 2;      // length delimited
+constexpr uint8_t kPacketPublishTimeTag = (2 << 3) | 2;  // length delimited
+constexpr uint8_t kAnyTypeUrlTag = (1 << 3) | 2;         // length delimited
+constexpr uint8_t kAnyValueTag = (2 << 3) | 2;           // length delimited
+constexpr uint8_t kTimestampSecondsTag = (1 << 3) | 0;   // varint
+constexpr uint8_t kTimestampNanosTag = (2 << 3) | 0;     // varint
+
+// Size of a length delimited field with a payload of `size` bytes.
+size_t LengthDelimitedSize(size_t size) {
+  return 1 + CodedOutputStream::VarintSize32(static_cast<uint32_t>(size)) +
+         size;
+}
+
+uint8_t* WriteLengthDelimitedHeader(uint8_t tag, size_t size,
+                                    uint8_t* target) {
+  *target++ = tag;
+  return CodedOutputStream::WriteVarint32ToArray(static_cast<uint32_t>(size),
+                                                 target);
+}
+
+}  // namespace
+
+absl::StatusOr<absl::string_view> PubSubPacketEncoder::Encode(
+    const google::protobuf::Message& message, absl::Time publish_time) {
+  INTR_ASSIGN_OR_RETURN(const google::protobuf::Timestamp timestamp,
+                        FromAbslTime(publish_time));
+
+  const google::protobuf::Descriptor* descriptor = message.GetDescriptor();
+  if (descriptor != descriptor_) {
+    type_url_ = absl::StrCat(kTypeUrlPrefix, descriptor->full_name());
+    descriptor_ = descriptor;
+  }
+
+  // Also caches the sizes for SerializeWithCachedSizesToArray() below.
+  const size_t value_size = message.ByteSizeLong();
+  // Leave room for the envelope, which is limited by the same 2GiB limit.
+  if (value_size > std::numeric_limits<int32_t>::max() / 2) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Message of type ", descriptor->full_name(), " is too ",
+                     "large to publish: ", value_size, " bytes"));
+  }
+
+  // Proto3 omits fields with default values.
+  size_t any_size = LengthDelimitedSize(type_url_.size());
+  if (value_size > 0) {
+    any_size += LengthDelimitedSize(value_size);
+  }
+  size_t timestamp_size = 0;
+  if (timestamp.seconds() != 0) {
+    timestamp_size += 1 + CodedOutputStream::VarintSize64(
+                              static_cast<uint64_t>(timestamp.seconds()));
+  }
+  if (timestamp.nanos() != 0) {
+    timestamp_size += 1 + CodedOutputStream::VarintSize32(
+                              static_cast<uint32_t>(timestamp.nanos()));
+  }
+  const size_t packet_size =
+      LengthDelimitedSize(any_size) + LengthDelimitedSize(timestamp_size);
+
+  uint8_t* const begin = Reserve(packet_size);
+  uint8_t* target = begin;
+  target = WriteLengthDelimitedHeader(kPacketPayloadTag, any_size, target);
+  target =
+      WriteLengthDelimitedHeader(kAnyTypeUrlTag, type_url_.size(), target);
+  target = CodedOutputStream::WriteRawToArray(type_url_.data(),
+                                              type_url_.size(), target);
+  if (value_size > 0) {
+    target = WriteLengthDelimitedHeader(kAnyValueTag, value_size, target);
+    target = message.SerializeWithCachedSizesToArray(target);
+  }
+  target = WriteLengthDelimitedHeader(kPacketPublishTimeTag, timestamp_size,
+                                      target);
+  if (timestamp.seconds() != 0) {
+    *target++ = kTimestampSecondsTag;
+    target = CodedOutputStream::WriteVarint64ToArray(
+        static_cast<uint64_t>(timestamp.seconds()), target);
+  }
+  if (timestamp.nanos() != 0) {
+    *target++ = kTimestampNanosTag;
+    target = CodedOutputStream::WriteVarint32ToArray(
+        static_cast<uint32_t>(timestamp.nanos()), target);
+  }
+
+  if (static_cast<size_t>(target - begin) != packet_size) {
+    // The message changed while it was serialized.
+    return absl::InternalError(
+        absl::StrCat("Serialized size of ", descriptor->full_name(),
+                     " does not match its computed size"));
+  }
+  return absl::string_view(reinterpret_cast<const char*>(begin), packet_size);
+}
+
+uint8_t* PubSubPacketEncoder::Reserve(size_t size) {
+  if (size > capacity_) {
+    // Grow geometrically so that slowly growing messages don't reallocate on
+    // every call. The contents don't need to be preserved or initialized.
+    capacity_ = std::max(size, capacity_ + capacity_ / 2);
+    buffer_.reset(new uint8_t[capacity_]);
+  }
+  return buffer_.get();
+}
+
+}  // namespace intrinsic::internal
@@ -0,0 +1,60 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#ifndef INTRINSIC_PLATFORM_PUBSUB_PUBSUB_PACKET_ENCODER_H_
+#define INTRINSIC_PLATFORM_PUBSUB_PUBSUB_PACKET_ENCODER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/message.h"
+
+namespace intrinsic::internal {
+
+// Serializes `PubSubPacket`s into a reusable buffer.
+//
+// The encoder writes the packet envelope (the `Any` payload and the publish
+// time) directly around the serialized message, so the message is serialized
+// exactly once and no temporary `Any` or `std::string` is created. The result
+// is byte-identical to packing the message into a `PubSubPacket` and calling
+// `SerializeAsString()`.
+//
+// The buffer only grows, so once it fits the largest message, encoding does
+// not allocate, unless the message type changes between calls.
+//
+// Not thread-safe.
+class PubSubPacketEncoder {
+ public:
+  PubSubPacketEncoder() = default;
+  PubSubPacketEncoder(const PubSubPacketEncoder&) = delete;
+  PubSubPacketEncoder& operator=(const PubSubPacketEncoder&) = delete;
+
+  // Encodes a `PubSubPacket` with `message` as payload and `publish_time`.
+  // The returned bytes are valid until the next call to Encode() or until the
+  // encoder is destroyed.
+  //
+  // Returns an error if `publish_time` cannot be represented as a
+  // `google.protobuf.Timestamp` or if the message is too large to serialize.
+  absl::StatusOr<absl::string_view> Encode(
+      const google::protobuf::Message& message, absl::Time publish_time);
+
+ private:
+  // Returns a buffer with space for at least `size` bytes.
+  uint8_t* Reserve(size_t size);
+
+  // Type URL of the last encoded message type.
+  const google::protobuf::Descriptor* descriptor_ = nullptr;
+  std::string type_url_;
+
+  std::unique_ptr<uint8_t[]> buffer_;
+  size_t capacity_ = 0;
+};
+
+}  // namespace intrinsic::internal
+
+#endif  // INTRINSIC_PLATFORM_PUBSUB_PUBSUB_PACKET_ENCODER_H_
@@ -0,0 +1,59 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+// Compares the cost of encoding a PubSubPacket by packing the message into an
+// `Any` and serializing the packet with the PubSubPacketEncoder, which
+// Publisher::Publish uses. Payloads are BytesValue messages of 1KiB, 64KiB and
+// 4MiB.
+
+#include <cstdint>
+#include <string>
+
+#include "absl/log/check.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "benchmark/benchmark.h"
+#include "google/protobuf/wrappers.pb.h"
+#include "intrinsic/platform/pubsub/adapters/pubsub.pb.h"
+#include "intrinsic/platform/pubsub/pubsub_packet_encoder.h"
+#include "intrinsic/util/proto_time.h"
+
+namespace intrinsic::internal {
+namespace {
+
+google::protobuf::BytesValue MakePayload(int64_t size) {
+  google::protobuf::BytesValue payload;
+  payload.set_value(std::string(size, 'x'));
+  return payload;
+}
+
+void BM_PackAndSerializeAsString(benchmark::State& state) {
+  const google::protobuf::BytesValue payload = MakePayload(state.range(0));
+  for (auto _ : state) {
+    intrinsic_proto::pubsub::PubSubPacket packet;
+    packet.mutable_payload()->PackFrom(payload);
+    CHECK_OK(FromAbslTime(absl::Now(), packet.mutable_publish_time()));
+    std::string serialized = packet.SerializeAsString();
+    benchmark::DoNotOptimize(serialized.data());
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+void BM_PubSubPacketEncoder(benchmark::State& state) {
+  const google::protobuf::BytesValue payload = MakePayload(state.range(0));
+  PubSubPacketEncoder encoder;
+  for (auto _ : state) {
+    auto packet = encoder.Encode(payload, absl::Now());
+    CHECK_OK(packet.status());
+    benchmark::DoNotOptimize(packet->data());
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_PackAndSerializeAsString)
+    ->Arg(1 << 10)
+    ->Arg(64 << 10)
+    ->Arg(4 << 20);
+BENCHMARK(BM_PubSubPacketEncoder)->Arg(1 << 10)->Arg(64 << 10)->Arg(4 << 20);
+
+}  // namespace
+}  // namespace intrinsic::internal
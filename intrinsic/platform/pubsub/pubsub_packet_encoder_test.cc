@@ -0,0 +1,83 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/platform/pubsub/pubsub_packet_encoder.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "google/protobuf/empty.pb.h"
+#include "google/protobuf/message.h"
+#include "google/protobuf/timestamp.pb.h"
+#include "google/protobuf/wrappers.pb.h"
+#include "intrinsic/platform/pubsub/adapters/pubsub.pb.h"
+#include "intrinsic/util/proto_time.h"
+#include "intrinsic/util/testing/gtest_wrapper.h"
+
+namespace intrinsic::internal {
+namespace {
+
+using ::intrinsic::testing::StatusIs;
+
+// Encodes the packet the way Publisher::Publish used to.
+std::string SerializePacket(const google::protobuf::Message& message,
+                            absl::Time publish_time) {
+  intrinsic_proto::pubsub::PubSubPacket packet;
+  packet.mutable_payload()->PackFrom(message);
+  EXPECT_OK(FromAbslTime(publish_time, packet.mutable_publish_time()));
+  return packet.SerializeAsString();
+}
+
+TEST(PubSubPacketEncoderTest, MatchesPackedPacket) {
+  PubSubPacketEncoder encoder;
+  google::protobuf::StringValue string_value;
+  string_value.set_value(std::string(300, 'x'));
+  google::protobuf::Timestamp timestamp;
+  timestamp.set_seconds(12);
+  google::protobuf::Empty empty;
+
+  for (absl::Time publish_time :
+       {absl::FromUnixNanos(1'700'000'000'123'456'789), absl::UnixEpoch(),
+        absl::FromUnixSeconds(-5) + absl::Milliseconds(1),
+        absl::FromUnixSeconds(3)}) {
+    for (const google::protobuf::Message* message :
+         std::initializer_list<const google::protobuf::Message*>{
+             &string_value, &timestamp, &empty}) {
+      ASSERT_OK_AND_ASSIGN(absl::string_view packet,
+                           encoder.Encode(*message, publish_time));
+      EXPECT_EQ(packet, SerializePacket(*message, publish_time))
+          << message->GetTypeName() << " at " << publish_time;
+    }
+  }
+}
+
+TEST(PubSubPacketEncoderTest, DecodesAsPubSubPacket) {
+  PubSubPacketEncoder encoder;
+  google::protobuf::BytesValue payload;
+  payload.set_value(std::string(1 << 20, '\x7f'));
+  const absl::Time publish_time = absl::FromUnixMillis(1234567);
+  ASSERT_OK_AND_ASSIGN(absl::string_view packet,
+                       encoder.Encode(payload, publish_time));
+
+  intrinsic_proto::pubsub::PubSubPacket decoded;
+  ASSERT_TRUE(decoded.ParseFromArray(packet.data(), packet.size()));
+  google::protobuf::BytesValue decoded_payload;
+  ASSERT_TRUE(decoded.payload().UnpackTo(&decoded_payload));
+  EXPECT_EQ(decoded_payload.value(), payload.value());
+  ASSERT_OK_AND_ASSIGN(absl::Time decoded_time,
+                       ToAbslTime(decoded.publish_time()));
+  EXPECT_EQ(decoded_time, publish_time);
+}
+
+TEST(PubSubPacketEncoderTest, RejectsInvalidPublishTime) {
+  PubSubPacketEncoder encoder;
+  EXPECT_THAT(
+      encoder.Encode(google::protobuf::Empty(), absl::InfiniteFuture()),
+      StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace intrinsic::internal
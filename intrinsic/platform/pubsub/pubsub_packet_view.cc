@@ -0,0 +1,167 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/platform/pubsub/pubsub_packet_view.h"
+
+#include <cstddef>
+#include <cstdint>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/message.h"
+#include "google/protobuf/wire_format_lite.h"
+#include "intrinsic/platform/pubsub/adapters/pubsub.pb.h"
+
+namespace intrinsic {
+namespace {
+
+using ::google::protobuf::internal::WireFormatLite;
+using ::google::protobuf::io::CodedInputStream;
+
+constexpr uint32_t Tag(int field_number, WireFormatLite::WireType type) {
+  return (static_cast<uint32_t>(field_number) << 3) | type;
+}
+
+// Fields of `PubSubPacket`, `google.protobuf.Any` and
+// `google.protobuf.Timestamp`.
+constexpr uint32_t kPacketPayloadTag =
+    Tag(1, WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
+constexpr uint32_t kPacketPublishTimeTag =
+    Tag(2, WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
+constexpr uint32_t kPacketTraceIdTag = Tag(4, WireFormatLite::WIRETYPE_VARINT);
+constexpr uint32_t kPacketSpanIdTag = Tag(5, WireFormatLite::WIRETYPE_VARINT);
+constexpr uint32_t kAnyTypeUrlTag =
+    Tag(1, WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
+constexpr uint32_t kAnyValueTag =
+    Tag(2, WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
+constexpr uint32_t kTimestampSecondsTag =
+    Tag(1, WireFormatLite::WIRETYPE_VARINT);
+constexpr uint32_t kTimestampNanosTag = Tag(2, WireFormatLite::WIRETYPE_VARINT);
+
+CodedInputStream MakeInput(absl::string_view data) {
+  return CodedInputStream(reinterpret_cast<const uint8_t*>(data.data()),
+                          static_cast<int>(data.size()));
+}
+
+// Reads the contents of a length delimited field from `input`, which reads
+// from `data`.
+bool ReadLengthDelimited(absl::string_view data, CodedInputStream& input,
+                         absl::string_view& value) {
+  uint32_t length;
+  if (!input.ReadVarint32(&length)) {
+    return false;
+  }
+  const int offset = input.CurrentPosition();
+  if (!input.Skip(static_cast<int>(length))) {
+    return false;
+  }
+  value = data.substr(offset, length);
+  return true;
+}
+
+bool ParseAny(absl::string_view data, absl::string_view& type_url,
+              absl::string_view& value) {
+  CodedInputStream input = MakeInput(data);
+  while (uint32_t tag = input.ReadTag()) {
+    bool ok;
+    if (tag == kAnyTypeUrlTag) {
+      ok = ReadLengthDelimited(data, input, type_url);
+    } else if (tag == kAnyValueTag) {
+      ok = ReadLengthDelimited(data, input, value);
+    } else {
+      ok = WireFormatLite::SkipField(&input, tag);
+    }
+    if (!ok) {
+      return false;
+    }
+  }
+  return input.ConsumedEntireMessage();
+}
+
+bool ParseTimestamp(absl::string_view data, absl::Time& time) {
+  CodedInputStream input = MakeInput(data);
+  uint64_t seconds = 0;
+  uint32_t nanos = 0;
+  while (uint32_t tag = input.ReadTag()) {
+    bool ok;
+    if (tag == kTimestampSecondsTag) {
+      ok = input.ReadVarint64(&seconds);
+    } else if (tag == kTimestampNanosTag) {
+      ok = input.ReadVarint32(&nanos);
+    } else {
+      ok = WireFormatLite::SkipField(&input, tag);
+    }
+    if (!ok) {
+      return false;
+    }
+  }
+  if (!input.ConsumedEntireMessage()) {
+    return false;
+  }
+  time = absl::FromUnixSeconds(static_cast<int64_t>(seconds)) +
+         absl::Nanoseconds(static_cast<int32_t>(nanos));
+  return true;
+}
+
+}  // namespace
+
+absl::StatusOr<PubSubPacketView> PubSubPacketView::Parse(
+    absl::string_view serialized_packet) {
+  PubSubPacketView view;
+  view.serialized_packet_ = serialized_packet;
+  CodedInputStream input = MakeInput(serialized_packet);
+  // Like the proto parser, the last occurrence of a field wins. Unlike it,
+  // repeated occurrences of the payload or the publish time are not merged.
+  while (uint32_t tag = input.ReadTag()) {
+    bool ok;
+    absl::string_view field;
+    if (tag == kPacketPayloadTag) {
+      ok = ReadLengthDelimited(serialized_packet, input, field) &&
+           ParseAny(field, view.type_url_, view.serialized_payload_);
+    } else if (tag == kPacketPublishTimeTag) {
+      ok = ReadLengthDelimited(serialized_packet, input, field) &&
+           ParseTimestamp(field, view.publish_time_);
+    } else if (tag == kPacketTraceIdTag) {
+      ok = input.ReadVarint64(&view.trace_id_);
+    } else if (tag == kPacketSpanIdTag) {
+      ok = input.ReadVarint64(&view.span_id_);
+    } else {
+      ok = WireFormatLite::SkipField(&input, tag);
+    }
+    if (!ok) {
+      return absl::InvalidArgumentError("Failed to parse PubSubPacket");
+    }
+  }
+  if (!input.ConsumedEntireMessage()) {
+    return absl::InvalidArgumentError("Failed to parse PubSubPacket");
+  }
+  return view;
+}
+
+absl::string_view PubSubPacketView::payload_type_name() const {
+  const size_t slash = type_url_.rfind('/');
+  return slash == absl::string_view::npos ? type_url_
+                                          : type_url_.substr(slash + 1);
+}
+
+bool PubSubPacketView::UnpackTo(google::protobuf::Message* message) const {
+  if (!PayloadIs(*message)) {
+    return false;
+  }
+  return message->ParseFromArray(serialized_payload_.data(),
+                                 static_cast<int>(serialized_payload_.size()));
+}
+
+absl::StatusOr<intrinsic_proto::pubsub::PubSubPacket>
+PubSubPacketView::ToProto() const {
+  intrinsic_proto::pubsub::PubSubPacket packet;
+  if (!packet.ParseFromArray(serialized_packet_.data(),
+                             static_cast<int>(serialized_packet_.size()))) {
+    return absl::InvalidArgumentError("Failed to parse PubSubPacket");
+  }
+  return packet;
+}
+
+}  // namespace intrinsic
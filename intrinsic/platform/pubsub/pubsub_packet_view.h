@@ -0,0 +1,74 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#ifndef INTRINSIC_PLATFORM_PUBSUB_PUBSUB_PACKET_VIEW_H_
+#define INTRINSIC_PLATFORM_PUBSUB_PUBSUB_PACKET_VIEW_H_
+
+#include <cstdint>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "google/protobuf/message.h"
+#include "intrinsic/platform/pubsub/adapters/pubsub.pb.h"
+
+namespace intrinsic {
+
+// A lazily parsed, non-owning view of a serialized PubSubPacket.
+//
+// Parse() only decodes the envelope of the packet, i.e. the type URL of the
+// payload, the publish time and the trace context. The payload itself stays
+// serialized until UnpackTo() is called, so subscribers which filter packets
+// by type or time don't pay for decoding the payload. Neither parsing nor
+// reading the view allocates.
+//
+// The view references the serialized packet, which must outlive it.
+class PubSubPacketView {
+ public:
+  // Parses the envelope of `serialized_packet`. Returns an error if it is not
+  // a valid PubSubPacket.
+  static absl::StatusOr<PubSubPacketView> Parse(
+      absl::string_view serialized_packet);
+
+  // The type URL of the payload, e.g.
+  // "type.googleapis.com/intrinsic_proto.Foo".
+  absl::string_view type_url() const { return type_url_; }
+  // The full name of the payload type, i.e. the part of the type URL after
+  // the last '/'.
+  absl::string_view payload_type_name() const;
+  // The serialized payload message.
+  absl::string_view serialized_payload() const { return serialized_payload_; }
+
+  absl::Time publish_time() const { return publish_time_; }
+  uint64_t trace_id() const { return trace_id_; }
+  uint64_t span_id() const { return span_id_; }
+
+  // The complete serialized packet.
+  absl::string_view serialized_packet() const { return serialized_packet_; }
+
+  // Returns true if the payload is of the same type as `message`.
+  bool PayloadIs(const google::protobuf::Message& message) const {
+    return payload_type_name() == message.GetDescriptor()->full_name();
+  }
+
+  // Parses the payload into `message`, reusing its allocated memory. Returns
+  // false if the payload has a different type or cannot be parsed, like
+  // google::protobuf::Any::UnpackTo().
+  bool UnpackTo(google::protobuf::Message* message) const;
+
+  // Parses the complete packet, including the payload.
+  absl::StatusOr<intrinsic_proto::pubsub::PubSubPacket> ToProto() const;
+
+ private:
+  PubSubPacketView() = default;
+
+  absl::string_view serialized_packet_;
+  absl::string_view type_url_;
+  absl::string_view serialized_payload_;
+  absl::Time publish_time_ = absl::UnixEpoch();
+  uint64_t trace_id_ = 0;
+  uint64_t span_id_ = 0;
+};
+
+}  // namespace intrinsic
+
+#endif  // INTRINSIC_PLATFORM_PUBSUB_PUBSUB_PACKET_VIEW_H_
@@ -0,0 +1,107 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/platform/pubsub/pubsub_packet_view.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "google/protobuf/duration.pb.h"
+#include "google/protobuf/wrappers.pb.h"
+#include "intrinsic/platform/pubsub/adapters/pubsub.pb.h"
+#include "intrinsic/platform/pubsub/pubsub_packet_encoder.h"
+#include "intrinsic/util/testing/gtest_wrapper.h"
+
+namespace intrinsic {
+namespace {
+
+using ::intrinsic::testing::StatusIs;
+
+TEST(PubSubPacketViewTest, ParsesEnvelope) {
+  intrinsic_proto::pubsub::PubSubPacket packet;
+  google::protobuf::StringValue payload;
+  payload.set_value("hello");
+  packet.mutable_payload()->PackFrom(payload);
+  packet.mutable_publish_time()->set_seconds(-3);
+  packet.mutable_publish_time()->set_nanos(5);
+  packet.set_trace_id(17);
+  packet.set_span_id(42);
+  const std::string serialized = packet.SerializeAsString();
+
+  ASSERT_OK_AND_ASSIGN(PubSubPacketView view,
+                       PubSubPacketView::Parse(serialized));
+  EXPECT_EQ(view.type_url(),
+            "type.googleapis.com/google.protobuf.StringValue");
+  EXPECT_EQ(view.payload_type_name(), "google.protobuf.StringValue");
+  EXPECT_EQ(view.serialized_payload(), payload.SerializeAsString());
+  EXPECT_EQ(view.publish_time(),
+            absl::FromUnixSeconds(-3) + absl::Nanoseconds(5));
+  EXPECT_EQ(view.trace_id(), 17);
+  EXPECT_EQ(view.span_id(), 42);
+  EXPECT_EQ(view.serialized_packet(), serialized);
+
+  ASSERT_OK_AND_ASSIGN(intrinsic_proto::pubsub::PubSubPacket proto,
+                       view.ToProto());
+  EXPECT_EQ(proto.SerializeAsString(), serialized);
+}
+
+TEST(PubSubPacketViewTest, ParsesEncodedPacket) {
+  internal::PubSubPacketEncoder encoder;
+  google::protobuf::Int64Value payload;
+  payload.set_value(-12345);
+  const absl::Time publish_time = absl::FromUnixMicros(1'700'000'000'123'456);
+  ASSERT_OK_AND_ASSIGN(absl::string_view serialized,
+                       encoder.Encode(payload, publish_time));
+
+  ASSERT_OK_AND_ASSIGN(PubSubPacketView view,
+                       PubSubPacketView::Parse(serialized));
+  EXPECT_EQ(view.publish_time(), publish_time);
+  EXPECT_TRUE(view.PayloadIs(payload));
+  google::protobuf::Int64Value unpacked;
+  unpacked.set_value(99);
+  ASSERT_TRUE(view.UnpackTo(&unpacked));
+  EXPECT_EQ(unpacked.value(), -12345);
+}
+
+TEST(PubSubPacketViewTest, RejectsPayloadOfOtherType) {
+  intrinsic_proto::pubsub::PubSubPacket packet;
+  packet.mutable_payload()->PackFrom(google::protobuf::Duration());
+  const std::string serialized = packet.SerializeAsString();
+  ASSERT_OK_AND_ASSIGN(PubSubPacketView view,
+                       PubSubPacketView::Parse(serialized));
+
+  google::protobuf::Int64Value unpacked;
+  EXPECT_FALSE(view.PayloadIs(unpacked));
+  EXPECT_FALSE(view.UnpackTo(&unpacked));
+}
+
+TEST(PubSubPacketViewTest, SkipsUnknownFields) {
+  intrinsic_proto::pubsub::PubSubPacket packet;
+  packet.mutable_payload()->PackFrom(google::protobuf::Int64Value());
+  std::string serialized = packet.SerializeAsString();
+  // Field 9, varint 1 and field 10, length delimited "ab".
+  serialized += std::string("\x48\x01\x52\x02" "ab", 6);
+
+  ASSERT_OK_AND_ASSIGN(PubSubPacketView view,
+                       PubSubPacketView::Parse(serialized));
+  EXPECT_EQ(view.payload_type_name(), "google.protobuf.Int64Value");
+  EXPECT_EQ(view.publish_time(), absl::UnixEpoch());
+}
+
+TEST(PubSubPacketViewTest, RejectsInvalidPacket) {
+  intrinsic_proto::pubsub::PubSubPacket packet;
+  packet.mutable_payload()->PackFrom(google::protobuf::Int64Value());
+  const std::string serialized = packet.SerializeAsString();
+  EXPECT_THAT(PubSubPacketView::Parse(
+                  absl::string_view(serialized).substr(
+                      0, serialized.size() - 1)),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(PubSubPacketView::Parse("\xff"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace intrinsic
@@ -1,22 +1,22 @@
 // Copyright 2023 Intrinsic Innovation LLC
 
+#include <cstddef>
 #include <memory>
 #include <string>
 #include <utility>
 
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
-#include "google/protobuf/any.pb.h"
 #include "google/protobuf/message.h"
-#include "intrinsic/platform/pubsub/adapters/pubsub.pb.h"
 #include "intrinsic/platform/pubsub/publisher.h"
 #include "intrinsic/platform/pubsub/publisher_stats.h"
+#include "intrinsic/platform/pubsub/pubsub_packet_encoder.h"
 #include "intrinsic/platform/pubsub/zenoh_publisher_data.h"
 #include "intrinsic/platform/pubsub/zenoh_util/zenoh_handle.h"
-#include "intrinsic/util/proto_time.h"
-#include "intrinsic/util/status/status_macros.h"
 #include "opencensus/stats/stats.h"
 
 namespace intrinsic {
@@ -24,7 +24,8 @@ namespace intrinsic {
 Publisher::Publisher(Publisher&&) = default;
 
 Publisher& Publisher::operator=(Publisher&& other) {
-  if (publisher_data_ && !publisher_data_->prefixed_name.empty()) {
+  if (publisher_data_ && publisher_data_->zenoh &&
+      !publisher_data_->prefixed_name.empty()) {
     Zenoh().imw_destroy_publisher(publisher_data_->prefixed_name.c_str());
   }
   topic_name_ = std::move(other.topic_name_);
@@ -34,35 +35,65 @@ Publisher& Publisher::operator=(Publisher&& other) {
 
 Publisher::Publisher(absl::string_view topic_name,
                      std::unique_ptr<PublisherData> publisher_data)
-    : topic_name_(topic_name), publisher_data_(std::move(publisher_data)) {}
+    : topic_name_(topic_name), publisher_data_(std::move(publisher_data)) {
+  if (publisher_data_ && publisher_data_->stats == nullptr) {
+    publisher_data_->stats =
+        internal::PublisherStats::Singleton().Register(topic_name_);
+  }
+}
 
 Publisher::~Publisher() {
-  if (publisher_data_ && !publisher_data_->prefixed_name.empty()) {
+  if (publisher_data_ && publisher_data_->zenoh &&
+      !publisher_data_->prefixed_name.empty()) {
     Zenoh().imw_destroy_publisher(publisher_data_->prefixed_name.c_str());
   }
 }
 
 absl::Status Publisher::Publish(const google::protobuf::Message& message,
                                 absl::Time event_time) const {
-  intrinsic_proto::pubsub::PubSubPacket wrapper;
-  wrapper.mutable_payload()->PackFrom(message);
   // When the pubsub message was sent out.
   absl::Time publish_time = absl::Now();
-  INTR_ASSIGN_OR_RETURN(*wrapper.mutable_publish_time(),
-                        FromAbslTime(publish_time));
   if (event_time > publish_time) {
     return absl::InvalidArgumentError("event_time should not be in the future");
   }
 
-  imw_ret_t ret = Zenoh().imw_publish(publisher_data_->prefixed_name.c_str(),
-                                      wrapper.SerializeAsString().c_str(),
-                                      wrapper.ByteSizeLong());
-
-  intrinsic::internal::PublisherStats::Singleton().Increment(topic_name_);
+  imw_ret_t ret = IMW_OK;
+  size_t packet_size = 0;
+  if (publisher_data_->zenoh) {
+    // Serializes the message once, directly into the publisher's buffer.
+    absl::MutexLock lock(&publisher_data_->encoder_mutex);
+    absl::StatusOr<absl::string_view> packet =
+        publisher_data_->encoder.Encode(message, publish_time);
+    if (!packet.ok()) {
+      publisher_data_->stats->RecordFailure(absl::Now() - publish_time);
+      return packet.status();
+    }
+    ret = Zenoh().imw_publish(publisher_data_->prefixed_name.c_str(),
+                              packet->data(), packet->size());
+    packet_size = packet->size();
+  }
+  absl::Status local_status;
+  if (ret == IMW_OK && publisher_data_->local != nullptr) {
+    // Subscribers of the local transports in this process may receive the
+    // message itself, in which case it isn't serialized at all.
+    size_t local_packet_size = 0;
+    local_status = publisher_data_->local->Publish(message, publish_time,
+                                                   local_packet_size);
+    if (!publisher_data_->zenoh) {
+      packet_size = local_packet_size;
+    }
+  }
+  const absl::Duration latency = absl::Now() - publish_time;
 
   if (ret != IMW_OK) {
+    publisher_data_->stats->RecordFailure(latency);
     return absl::InternalError("Error publishing message");
   }
+  if (!local_status.ok()) {
+    publisher_data_->stats->RecordFailure(latency);
+    return local_status;
+  }
+  publisher_data_->stats->RecordPublish(packet_size, latency);
   return absl::OkStatus();
 }
 
@@ -3,12 +3,31 @@
 #ifndef INTRINSIC_PLATFORM_PUBSUB_ZENOH_PUBLISHER_DATA_H_
 #define INTRINSIC_PLATFORM_PUBSUB_ZENOH_PUBLISHER_DATA_H_
 
+#include <memory>
 #include <string>
 
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "intrinsic/platform/pubsub/local_transport/local_bus.h"
+#include "intrinsic/platform/pubsub/publisher_stats.h"
+#include "intrinsic/platform/pubsub/pubsub_packet_encoder.h"
+
 namespace intrinsic {
 
 struct PublisherData {
   std::string prefixed_name;
+
+  // Whether messages are published through Zenoh.
+  bool zenoh = true;
+  // Hands messages to the subscribers of the local transports.
+  std::unique_ptr<local_transport::LocalPublisher> local;
+
+  // Registered when the publisher is created.
+  std::shared_ptr<internal::TopicPublisherStats> stats;
+
+  // Reused for every published message of this publisher.
+  absl::Mutex encoder_mutex;
+  internal::PubSubPacketEncoder encoder ABSL_GUARDED_BY(encoder_mutex);
 };
 
 }  // namespace intrinsic
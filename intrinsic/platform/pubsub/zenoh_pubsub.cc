@@ -1,18 +1,24 @@
 // Copyright 2023 Intrinsic Innovation LLC
 
 #include <cstddef>
+#include <functional>
 #include <memory>
 #include <string>
 #include <utility>
 
 #include "absl/log/log.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/match.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
+#include "google/protobuf/message.h"
 #include "intrinsic/platform/pubsub/adapters/pubsub.pb.h"
+#include "intrinsic/platform/pubsub/local_transport/keyexpr.h"
+#include "intrinsic/platform/pubsub/local_transport/local_bus.h"
 #include "intrinsic/platform/pubsub/publisher.h"
 #include "intrinsic/platform/pubsub/pubsub.h"
+#include "intrinsic/platform/pubsub/pubsub_packet_view.h"
 #include "intrinsic/platform/pubsub/subscription.h"
 #include "intrinsic/platform/pubsub/zenoh_publisher_data.h"
 #include "intrinsic/platform/pubsub/zenoh_pubsub_data.h"
@@ -48,6 +54,31 @@ std::unique_ptr<PubSubData> MakePubSubData(
   return data;
 }
 
+TopicConfig::Transport GetTransport(const PubSubData &data,
+                                   const TopicConfig &config) {
+  if (data.local_only && config.transport == TopicConfig::Transport::kZenoh) {
+    return TopicConfig::Transport::kIntraProcess;
+  }
+  return config.transport;
+}
+
+absl::StatusOr<Subscription> CreateLocalSubscription(
+    absl::string_view topic_name, absl::string_view prefixed_name,
+    TopicConfig::Transport transport,
+    local_transport::LocalSubscriberCallbacks callbacks) {
+  INTR_ASSIGN_OR_RETURN(
+      std::shared_ptr<local_transport::LocalSubscriber> subscriber,
+      local_transport::LocalBus::Global().Subscribe(
+          prefixed_name,
+          /*shared_memory=*/transport ==
+              TopicConfig::Transport::kSharedMemory,
+          std::move(callbacks)));
+  auto subscription_data = std::make_unique<SubscriptionData>();
+  subscription_data->prefixed_name = std::string(prefixed_name);
+  subscription_data->local = std::move(subscriber);
+  return Subscription(topic_name, std::move(subscription_data));
+}
+
 PubSub::PubSub() : data_(MakePubSubData()) {}
 
 PubSub::PubSub(absl::string_view participant_name) : data_(MakePubSubData()) {}
@@ -55,7 +86,20 @@ PubSub::PubSub(absl::string_view participant_name) : data_(MakePubSubData()) {}
 PubSub::PubSub(absl::string_view participant_name, absl::string_view config)
     : data_(MakePubSubData(config)) {}
 
-PubSub::~PubSub() { Zenoh().imw_fini(); }
+PubSub::PubSub(std::shared_ptr<PubSubData> data) : data_(std::move(data)) {}
+
+PubSub PubSub::LocalOnly() {
+  auto data = std::make_shared<PubSubData>();
+  data->local_only = true;
+  return PubSub(std::move(data));
+}
+
+PubSub::~PubSub() {
+  if (data_ != nullptr && data_->local_only) {
+    return;
+  }
+  Zenoh().imw_fini();
+}
 
 absl::StatusOr<Publisher> PubSub::CreatePublisher(
     absl::string_view topic_name, const TopicConfig &config) const {
@@ -64,15 +108,27 @@ absl::StatusOr<Publisher> PubSub::CreatePublisher(
     return prefixed_name.status();
   }
 
-  imw_ret_t ret = Zenoh().imw_create_publisher(
-      prefixed_name->c_str(),
-      intrinsic::PubSubQoSToZenohQos(config.topic_qos).c_str());
+  const TopicConfig::Transport transport = GetTransport(*data_, config);
+  INTR_ASSIGN_OR_RETURN(
+      std::unique_ptr<local_transport::LocalPublisher> local_publisher,
+      local_transport::LocalBus::Global().CreatePublisher(
+          *prefixed_name,
+          /*shared_memory=*/transport ==
+              TopicConfig::Transport::kSharedMemory));
 
-  if (ret == IMW_ERROR) {
-    return absl::InternalError("Error creating a publisher");
+  if (transport == TopicConfig::Transport::kZenoh) {
+    imw_ret_t ret = Zenoh().imw_create_publisher(
+        prefixed_name->c_str(),
+        intrinsic::PubSubQoSToZenohQos(config.topic_qos).c_str());
+
+    if (ret == IMW_ERROR) {
+      return absl::InternalError("Error creating a publisher");
+    }
   }
   auto publisher_data = std::make_unique<PublisherData>();
   publisher_data->prefixed_name = *prefixed_name;
+  publisher_data->zenoh = transport == TopicConfig::Transport::kZenoh;
+  publisher_data->local = std::move(local_publisher);
   return Publisher(topic_name, std::move(publisher_data));
 }
 
@@ -84,6 +140,22 @@ absl::StatusOr<Subscription> PubSub::CreateSubscription(
   if (!prefixed_name.ok()) {
     return prefixed_name.status();
   }
+  if (const TopicConfig::Transport transport = GetTransport(*data_, config);
+      transport != TopicConfig::Transport::kZenoh) {
+    return CreateLocalSubscription(
+        topic_name, *prefixed_name, transport,
+        {.packet_callback = [msg_callback](absl::string_view topic,
+                                           const PubSubPacketView &packet) {
+          absl::StatusOr<intrinsic_proto::pubsub::PubSubPacket> msg =
+              packet.ToProto();
+          if (!msg.ok()) {
+            LOG_EVERY_N(ERROR, 1)
+                << "Deserializing message failed. Topic: " << topic;
+            return;
+          }
+          msg_callback(*msg);
+        }});
+  }
 
   auto subscription_data = std::make_unique<SubscriptionData>();
   subscription_data->prefixed_name = *prefixed_name;
@@ -124,6 +196,28 @@ absl::StatusOr<Subscription> PubSub::CreateSubscription(
   if (!prefixed_name.ok()) {
     return prefixed_name.status();
   }
+  if (const TopicConfig::Transport transport = GetTransport(*data_, config);
+      transport != TopicConfig::Transport::kZenoh) {
+    return CreateLocalSubscription(
+        topic_name, *prefixed_name, transport,
+        {.packet_callback = [msg_callback](absl::string_view topic,
+                                           const PubSubPacketView &packet) {
+          absl::StatusOr<intrinsic_proto::pubsub::PubSubPacket> msg =
+              packet.ToProto();
+          if (!msg.ok()) {
+            LOG_EVERY_N(ERROR, 1)
+                << "Deserializing message failed. Topic: " << topic;
+            return;
+          }
+          auto topic_name = ZenohHandle::remove_topic_prefix(topic);
+          if (!topic_name.ok()) {
+            LOG_EVERY_N(ERROR, 1)
+                << "Topic name error: " << topic_name.status();
+            return;
+          }
+          msg_callback(*topic_name, *msg);
+        }});
+  }
 
   auto subscription_data = std::make_unique<SubscriptionData>();
   subscription_data->prefixed_name = *prefixed_name;
@@ -160,9 +254,69 @@ absl::StatusOr<Subscription> PubSub::CreateSubscription(
   return Subscription(topic_name, std::move(subscription_data));
 }
 
+absl::StatusOr<Subscription> PubSub::CreateRawSubscription(
+    absl::string_view topic_name, const TopicConfig &config,
+    SubscriptionOkCallback<PubSubPacketView> msg_callback) const {
+  return CreateRawSubscription(topic_name, config, std::move(msg_callback),
+                               /*message_callback=*/nullptr);
+}
+
+absl::StatusOr<Subscription> PubSub::CreateRawSubscription(
+    absl::string_view topic_name, const TopicConfig &config,
+    SubscriptionOkCallback<PubSubPacketView> msg_callback,
+    std::function<bool(const google::protobuf::Message &)> message_callback)
+    const {
+  auto prefixed_name = ZenohHandle::add_topic_prefix(topic_name);
+  if (!prefixed_name.ok()) {
+    return prefixed_name.status();
+  }
+  if (const TopicConfig::Transport transport = GetTransport(*data_, config);
+      transport != TopicConfig::Transport::kZenoh) {
+    return CreateLocalSubscription(
+        topic_name, *prefixed_name, transport,
+        {.message_callback = std::move(message_callback),
+         .packet_callback =
+             [msg_callback = std::move(msg_callback)](
+                 absl::string_view topic, const PubSubPacketView &packet) {
+               msg_callback(packet);
+             }});
+  }
+
+  auto subscription_data = std::make_unique<SubscriptionData>();
+  subscription_data->prefixed_name = *prefixed_name;
+  auto callback = std::make_unique<imw_callback_functor_t>(
+      [msg_callback](const char *keyexpr, const void *blob,
+                     const size_t blob_len) {
+        if (absl::StartsWith(keyexpr, kIntrospectionTopicPrefix)) return;
+
+        absl::StatusOr<PubSubPacketView> msg = PubSubPacketView::Parse(
+            absl::string_view(static_cast<const char *>(blob), blob_len));
+        if (!msg.ok()) {
+          LOG_EVERY_N(ERROR, 1)
+              << absl::StrFormat("Deserializing message failed. Topic: ")
+              << keyexpr;
+          return;
+        }
+        msg_callback(*msg);
+      });
+  subscription_data->callback_functor = std::move(callback);
+
+  imw_ret_t ret = Zenoh().imw_create_subscription(
+      prefixed_name->c_str(), zenoh_static_callback,
+      intrinsic::PubSubQoSToZenohQos(config.topic_qos).c_str(),
+      subscription_data->callback_functor.get());
+  if (ret != IMW_OK) {
+    return absl::InternalError("Error creating a subscription");
+  }
+  return Subscription(topic_name, std::move(subscription_data));
+}
+
 bool PubSub::KeyexprIsCanon(absl::string_view keyexpr) const {
   const auto prefixed_keyexpr = ZenohHandle::add_topic_prefix(keyexpr);
   if (!prefixed_keyexpr.ok()) return false;
+  if (data_->local_only) {
+    return local_transport::KeyexprIsCanon(*prefixed_keyexpr);
+  }
   return Zenoh().imw_keyexpr_is_canon(prefixed_keyexpr->c_str()) == 0;
 }
 
@@ -172,6 +326,13 @@ absl::StatusOr<bool> PubSub::KeyexprIntersects(absl::string_view left,
                         ZenohHandle::add_topic_prefix(left));
   INTR_ASSIGN_OR_RETURN(const std::string prefixed_right,
                         ZenohHandle::add_topic_prefix(right));
+  if (data_->local_only) {
+    if (!local_transport::KeyexprIsCanon(prefixed_left) ||
+        !local_transport::KeyexprIsCanon(prefixed_right)) {
+      return absl::InvalidArgumentError("A key expression is invalid");
+    }
+    return local_transport::KeyexprIntersects(prefixed_left, prefixed_right);
+  }
   const int result = Zenoh().imw_keyexpr_intersects(prefixed_left.c_str(),
                                                     prefixed_right.c_str());
   switch (result) {
@@ -190,6 +351,13 @@ absl::StatusOr<bool> PubSub::KeyexprIncludes(absl::string_view left,
                         ZenohHandle::add_topic_prefix(left));
   INTR_ASSIGN_OR_RETURN(const std::string prefixed_right,
                         ZenohHandle::add_topic_prefix(right));
+  if (data_->local_only) {
+    if (!local_transport::KeyexprIsCanon(prefixed_left) ||
+        !local_transport::KeyexprIsCanon(prefixed_right)) {
+      return absl::InvalidArgumentError("A key expression is invalid");
+    }
+    return local_transport::KeyexprIncludes(prefixed_left, prefixed_right);
+  }
   const int result = Zenoh().imw_keyexpr_includes(prefixed_left.c_str(),
                                                   prefixed_right.c_str());
   switch (result) {
@@ -5,7 +5,10 @@
 
 namespace intrinsic {
 
-struct PubSubData {};
+struct PubSubData {
+  // Set for PubSub::LocalOnly(), which doesn't use Zenoh at all.
+  bool local_only = false;
+};
 
 }  // namespace intrinsic
 
@@ -10,6 +10,19 @@
 #include "intrinsic/platform/pubsub/zenoh_util/zenoh_handle.h"
 
 namespace intrinsic {
+namespace {
+
+void DestroySubscription(SubscriptionData &data) {
+  if (data.local != nullptr) {
+    data.local->Unsubscribe();
+    return;
+  }
+  Zenoh().imw_destroy_subscription(data.prefixed_name.c_str(),
+                                   zenoh_static_callback,
+                                   data.callback_functor.get());
+}
+
+}  // namespace
 
 Subscription::Subscription() = default;
 
@@ -22,9 +35,7 @@ Subscription::Subscription(Subscription &&) = default;
 
 Subscription &Subscription::operator=(Subscription &&other) {
   if (!topic_name_.empty()) {
-    Zenoh().imw_destroy_subscription(
-        subscription_data_->prefixed_name.c_str(), zenoh_static_callback,
-        subscription_data_->callback_functor.get());
+    DestroySubscription(*subscription_data_);
   }
   topic_name_ = std::move(other.topic_name_);
   subscription_data_ = std::move(other.subscription_data_);
@@ -35,9 +46,7 @@ Subscription::~Subscription() { Unsubscribe(); }
 
 void Subscription::Unsubscribe() {
   if (!topic_name_.empty()) {
-    Zenoh().imw_destroy_subscription(
-        subscription_data_->prefixed_name.c_str(), zenoh_static_callback,
-        subscription_data_->callback_functor.get());
+    DestroySubscription(*subscription_data_);
     topic_name_.clear();
   }
 }
@@ -6,6 +6,7 @@
 #include <memory>
 #include <string>
 
+#include "intrinsic/platform/pubsub/local_transport/local_bus.h"
 #include "intrinsic/platform/pubsub/zenoh_util/zenoh_handle.h"
 
 namespace intrinsic {
@@ -13,6 +14,8 @@ namespace intrinsic {
 struct SubscriptionData {
   std::unique_ptr<imw_callback_functor_t> callback_functor;
   std::string prefixed_name;
+  // Set instead of `callback_functor` for subscriptions of a local transport.
+  std::shared_ptr<local_transport::LocalSubscriber> local;
 };
 
 }  // namespace intrinsic
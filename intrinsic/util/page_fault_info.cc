@@ -8,7 +8,8 @@
 namespace intrinsic {
 
 PagefaultInfo GetPagefaultInfo() {
-  static PagefaultInfo info;
+  // The counters are per thread, so the previous values have to be as well.
+  thread_local PagefaultInfo info;
 
   rusage usage;
   getrusage(RUSAGE_THREAD, &usage);
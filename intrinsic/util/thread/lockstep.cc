@@ -7,6 +7,7 @@
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "intrinsic/icon/interprocess/binary_futex.h"
+#include "intrinsic/icon/interprocess/futex_wait_policy.h"
 #include "intrinsic/icon/utils/log.h"
 #include "intrinsic/icon/utils/realtime_status.h"
 #include "intrinsic/icon/utils/realtime_status_macro.h"
@@ -24,7 +25,14 @@ Lockstep &Lockstep::operator=(Lockstep &&other) {
 
 icon::RealtimeStatus Lockstep::StartOperationAWithDeadline(
     absl::Time deadline) {
-  INTRINSIC_RT_RETURN_IF_ERROR(b_finished_.WaitUntil(deadline));
+  return StartOperationAWithDeadline(deadline, icon::FutexWaitPolicy::Futex());
+}
+
+icon::RealtimeStatus Lockstep::StartOperationAWithDeadline(
+    absl::Time deadline, const icon::FutexWaitPolicy &policy,
+    icon::WakeupLatencyHistogram *histogram) {
+  INTRINSIC_RT_RETURN_IF_ERROR(
+      b_finished_.WaitUntil(deadline, policy, histogram));
   if (state_ == State::kCancelled) {
     // Ignore error because returning Aborted to the caller is more important.
     (void)b_finished_.Post();
@@ -57,7 +65,14 @@ icon::RealtimeStatus Lockstep::EndOperationA() {
 
 icon::RealtimeStatus Lockstep::StartOperationBWithDeadline(
     absl::Time deadline) {
-  INTRINSIC_RT_RETURN_IF_ERROR(a_finished_.WaitUntil(deadline));
+  return StartOperationBWithDeadline(deadline, icon::FutexWaitPolicy::Futex());
+}
+
+icon::RealtimeStatus Lockstep::StartOperationBWithDeadline(
+    absl::Time deadline, const icon::FutexWaitPolicy &policy,
+    icon::WakeupLatencyHistogram *histogram) {
+  INTRINSIC_RT_RETURN_IF_ERROR(
+      a_finished_.WaitUntil(deadline, policy, histogram));
   if (state_ == State::kCancelled) {
     // Ignore error because returning Aborted to the caller is more important.
     (void)a_finished_.Post();
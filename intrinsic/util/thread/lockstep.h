@@ -7,6 +7,7 @@
 
 #include "absl/time/time.h"
 #include "intrinsic/icon/interprocess/binary_futex.h"
+#include "intrinsic/icon/interprocess/futex_wait_policy.h"
 #include "intrinsic/icon/utils/realtime_status.h"
 
 namespace intrinsic {
@@ -83,6 +84,15 @@ class Lockstep {
   // Futex wait timed out or `kInternal` in case of an internal futex error.
   icon::RealtimeStatus StartOperationAWithDeadline(absl::Time deadline);
 
+  // Like `StartOperationAWithDeadline()` above, but waits according to
+  // `policy`, e.g. spins for a while before sleeping. If `histogram` is not
+  // null, records the time between `EndOperationB()` and the return from this
+  // call. The policy only applies to the calling thread, so the other side of
+  // the lockstep can use a different one.
+  icon::RealtimeStatus StartOperationAWithDeadline(
+      absl::Time deadline, const icon::FutexWaitPolicy &policy,
+      icon::WakeupLatencyHistogram *histogram = nullptr);
+
   // Signals that Operation A has completed, potentially waking a thread that is
   // waiting on `StartOperationB...()`.
   //
@@ -117,6 +127,13 @@ class Lockstep {
   // Futex wait timed out or `kInternal` in case of an internal futex error.
   icon::RealtimeStatus StartOperationBWithDeadline(absl::Time deadline);
 
+  // Like `StartOperationBWithDeadline()` above, but waits according to
+  // `policy`. If `histogram` is not null, records the time between
+  // `EndOperationA()` and the return from this call.
+  icon::RealtimeStatus StartOperationBWithDeadline(
+      absl::Time deadline, const icon::FutexWaitPolicy &policy,
+      icon::WakeupLatencyHistogram *histogram = nullptr);
+
   // Signals that Operation B has completed, potentially waking a thread that is
   // waiting on `StartOperationA...()`.
   //
@@ -0,0 +1,250 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/world/objects/coalescing_world_updater.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "intrinsic/eigenmath/types.h"
+#include "intrinsic/math/pose3.h"
+#include "intrinsic/math/proto_conversion.h"
+#include "intrinsic/util/eigen.h"
+#include "intrinsic/util/thread/thread.h"
+#include "intrinsic/world/objects/kinematic_object.h"
+#include "intrinsic/world/objects/object_world_client.h"
+#include "intrinsic/world/objects/object_world_ids.h"
+#include "intrinsic/world/objects/transform_node.h"
+#include "intrinsic/world/proto/object_world_service.pb.h"
+#include "intrinsic/world/proto/object_world_updates.pb.h"
+
+namespace intrinsic {
+namespace world {
+
+CoalescingWorldUpdater::CoalescingWorldUpdater(ObjectWorldClient* client,
+                                               const Options& options)
+    : client_(client), world_id_(client->GetWorldID()), options_(options) {
+  thread_ = Thread([this] { Run(); });
+}
+
+CoalescingWorldUpdater::~CoalescingWorldUpdater() {
+  {
+    absl::MutexLock lock(&mutex_);
+    stop_ = true;
+  }
+  thread_.Join();
+  absl::MutexLock lock(&mutex_);
+  if (!status_.ok()) {
+    LOG(WARNING) << "Unreported error of a world update batch: " << status_;
+  }
+}
+
+void CoalescingWorldUpdater::UpdateJointPositions(
+    const KinematicObject& kinematic_object,
+    const eigenmath::VectorXd& joint_positions) {
+  intrinsic_proto::world::ObjectWorldUpdate update;
+  intrinsic_proto::world::UpdateObjectJointsRequest& request =
+      *update.mutable_update_object_joints();
+  request.set_world_id(world_id_);
+  request.mutable_object()->set_id(kinematic_object.Id().value());
+  VectorXdToRepeatedDouble(joint_positions, request.mutable_joint_positions());
+  // Use minimalistic view since we are ignoring the response.
+  request.set_view(intrinsic_proto::world::ObjectView::BASIC);
+  Add(pending_joints_, kinematic_object.Id(), std::move(update));
+}
+
+void CoalescingWorldUpdater::UpdateTransform(const TransformNode& node_a,
+                                             const TransformNode& node_b,
+                                             const Pose3d& a_t_b) {
+  intrinsic_proto::world::ObjectWorldUpdate update;
+  intrinsic_proto::world::UpdateTransformRequest& request =
+      *update.mutable_update_transform();
+  request.set_world_id(world_id_);
+  request.mutable_node_a()->set_id(node_a.Id().value());
+  request.mutable_node_b()->set_id(node_b.Id().value());
+  *request.mutable_a_t_b() = ToProto(a_t_b);
+  // Use minimalistic view since we are ignoring the response.
+  request.set_view(intrinsic_proto::world::ObjectView::BASIC);
+  Add(pending_transforms_,
+      TransformKey(node_a.Id(), node_b.Id(), ObjectWorldResourceId()),
+      std::move(update));
+}
+
+void CoalescingWorldUpdater::UpdateTransform(
+    const TransformNode& node_a, const TransformNode& node_b,
+    const TransformNode& node_to_update, const Pose3d& a_t_b) {
+  intrinsic_proto::world::ObjectWorldUpdate update;
+  intrinsic_proto::world::UpdateTransformRequest& request =
+      *update.mutable_update_transform();
+  request.set_world_id(world_id_);
+  request.mutable_node_a()->set_id(node_a.Id().value());
+  request.mutable_node_b()->set_id(node_b.Id().value());
+  request.mutable_node_to_update()->set_id(node_to_update.Id().value());
+  *request.mutable_a_t_b() = ToProto(a_t_b);
+  // Use minimalistic view since we are ignoring the response.
+  request.set_view(intrinsic_proto::world::ObjectView::BASIC);
+  Add(pending_transforms_,
+      TransformKey(node_a.Id(), node_b.Id(), node_to_update.Id()),
+      std::move(update));
+}
+
+void CoalescingWorldUpdater::Flush() {
+  absl::MutexLock lock(&mutex_);
+  flush_requested_ = true;
+}
+
+absl::Status CoalescingWorldUpdater::Barrier(absl::Time deadline) {
+  absl::MutexLock lock(&mutex_);
+  const uint64_t sequence = next_sequence_;
+  flush_requested_ = true;
+  auto done = [this, sequence]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return done_sequence_ >= sequence;
+  };
+  if (!mutex_.AwaitWithDeadline(absl::Condition(&done), deadline)) {
+    return absl::DeadlineExceededError(
+        "Deadline exceeded while waiting for world updates to be applied.");
+  }
+  return std::exchange(status_, absl::OkStatus());
+}
+
+CoalescingWorldUpdater::Stats CoalescingWorldUpdater::stats() const {
+  absl::MutexLock lock(&mutex_);
+  return stats_;
+}
+
+template <typename Key>
+void CoalescingWorldUpdater::Add(
+    absl::flat_hash_map<Key, PendingUpdate>& pending, const Key& key,
+    intrinsic_proto::world::ObjectWorldUpdate&& update) {
+  absl::MutexLock lock(&mutex_);
+  if (!HasPending()) {
+    first_pending_ = absl::Now();
+  }
+  auto [it, inserted] = pending.try_emplace(key);
+  it->second.sequence = next_sequence_++;
+  it->second.update = std::move(update);
+  ++stats_.updates_added;
+  if (!inserted) {
+    ++stats_.updates_coalesced;
+  }
+}
+
+intrinsic_proto::world::ObjectWorldUpdates
+CoalescingWorldUpdater::TakePending() {
+  std::vector<PendingUpdate*> ordered;
+  ordered.reserve(pending_joints_.size() + pending_transforms_.size());
+  for (auto& [key, pending] : pending_joints_) {
+    ordered.push_back(&pending);
+  }
+  for (auto& [key, pending] : pending_transforms_) {
+    ordered.push_back(&pending);
+  }
+  std::sort(ordered.begin(), ordered.end(),
+            [](const PendingUpdate* a, const PendingUpdate* b) {
+              return a->sequence < b->sequence;
+            });
+  intrinsic_proto::world::ObjectWorldUpdates updates;
+  updates.mutable_updates()->Reserve(ordered.size());
+  for (PendingUpdate* pending : ordered) {
+    *updates.add_updates() = std::move(pending->update);
+  }
+  pending_joints_.clear();
+  pending_transforms_.clear();
+  return updates;
+}
+
+bool CoalescingWorldUpdater::HasPending() const {
+  return !pending_joints_.empty() || !pending_transforms_.empty();
+}
+
+bool CoalescingWorldUpdater::IsFull() const {
+  return pending_joints_.size() + pending_transforms_.size() >=
+         static_cast<size_t>(options_.max_pending_updates);
+}
+
+absl::Status CoalescingWorldUpdater::SendIndividually(
+    const intrinsic_proto::world::ObjectWorldUpdates& updates,
+    int64_t& failed) {
+  absl::Status status;
+  failed = 0;
+  intrinsic_proto::world::ObjectWorldUpdates single;
+  for (const intrinsic_proto::world::ObjectWorldUpdate& update :
+       updates.updates()) {
+    *single.add_updates() = update;
+    if (absl::Status update_status = client_->BatchUpdate(single);
+        !update_status.ok()) {
+      ++failed;
+      status.Update(update_status);
+    }
+    single.clear_updates();
+  }
+  if (failed > 0) {
+    LOG(WARNING) << "Discarded " << failed << " of " << updates.updates_size()
+                 << " world updates which failed on their own: " << status;
+  }
+  return status;
+}
+
+void CoalescingWorldUpdater::Run() {
+  absl::MutexLock lock(&mutex_);
+  while (true) {
+    // Without pending updates, the first update sets the deadline.
+    const bool had_pending = HasPending();
+    auto wake = [this, had_pending]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+      return stop_ || flush_requested_ || IsFull() ||
+             (!had_pending && HasPending());
+    };
+    const absl::Time deadline = had_pending
+                                    ? first_pending_ + options_.flush_period
+                                    : absl::InfiniteFuture();
+    if (mutex_.AwaitWithDeadline(absl::Condition(&wake), deadline) && !stop_ &&
+        !flush_requested_ && !IsFull()) {
+      continue;
+    }
+    flush_requested_ = false;
+    if (!HasPending()) {
+      // Barriers wait for sequence numbers, which are only assigned to updates.
+      done_sequence_ = next_sequence_;
+      if (stop_) {
+        return;
+      }
+      continue;
+    }
+    const uint64_t sequence = next_sequence_;
+    intrinsic_proto::world::ObjectWorldUpdates updates = TakePending();
+
+    mutex_.Unlock();
+    absl::Status status = client_->BatchUpdate(updates);
+    mutex_.Lock();
+
+    ++stats_.batches_sent;
+    if (!status.ok()) {
+      ++stats_.batches_failed;
+      LOG(WARNING) << "Failed to apply a batch of " << updates.updates_size()
+                   << " world updates: " << status;
+      // Otherwise an update that keeps failing, e.g. of a removed object,
+      // would discard all other updates as well.
+      int64_t failed = 1;
+      if (updates.updates_size() > 1) {
+        mutex_.Unlock();
+        status = SendIndividually(updates, failed);
+        mutex_.Lock();
+      }
+      stats_.updates_failed += failed;
+      status_.Update(status);
+    }
+    done_sequence_ = sequence;
+  }
+}
+
+}  // namespace world
+}  // namespace intrinsic
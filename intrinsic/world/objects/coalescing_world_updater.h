@@ -0,0 +1,153 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#ifndef INTRINSIC_WORLD_OBJECTS_COALESCING_WORLD_UPDATER_H_
+#define INTRINSIC_WORLD_OBJECTS_COALESCING_WORLD_UPDATER_H_
+
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "intrinsic/eigenmath/types.h"
+#include "intrinsic/math/pose3.h"
+#include "intrinsic/util/thread/thread.h"
+#include "intrinsic/world/objects/kinematic_object.h"
+#include "intrinsic/world/objects/object_world_client.h"
+#include "intrinsic/world/objects/object_world_ids.h"
+#include "intrinsic/world/objects/transform_node.h"
+#include "intrinsic/world/proto/object_world_updates.pb.h"
+
+namespace intrinsic {
+namespace world {
+
+// Write-behind variant of ObjectWorldClient::UpdateJointPositions() and
+// ObjectWorldClient::UpdateTransform() for mirroring fast-changing state, such
+// as the joint positions of a live robot, into a world.
+//
+// Update calls return right away. The latest update per kinematic object and
+// per transform replaces earlier ones which were not sent yet, and a
+// background thread sends the remaining updates with a single
+// ObjectWorldClient::BatchUpdate() call, in the order of their latest change.
+// A batch is atomic, so if it fails, its updates are sent again one by one and
+// only the failing ones are discarded. Errors are logged and the first one is
+// returned from the next Barrier().
+//
+// The class is thread-safe.
+class CoalescingWorldUpdater {
+ public:
+  struct Options {
+    // Pending updates are sent at the latest this long after the first of them
+    // was made.
+    absl::Duration flush_period = absl::Milliseconds(20);
+    // Pending updates are sent right away once this many kinematic objects and
+    // transforms have one.
+    int max_pending_updates = 256;
+  };
+
+  struct Stats {
+    // Updates passed to the Update*() methods.
+    int64_t updates_added = 0;
+    // Updates that replaced a pending update of the same object or transform.
+    int64_t updates_coalesced = 0;
+    int64_t batches_sent = 0;
+    // Batches that failed as a whole, before their updates were sent one by
+    // one.
+    int64_t batches_failed = 0;
+    // Updates that were discarded because they failed on their own.
+    int64_t updates_failed = 0;
+  };
+
+  // `client` must outlive the updater and must not be moved while the updater
+  // exists. It may be used concurrently by other callers.
+  CoalescingWorldUpdater(ObjectWorldClient* client, const Options& options);
+
+  // Sends the pending updates and waits for them.
+  ~CoalescingWorldUpdater();
+
+  CoalescingWorldUpdater(const CoalescingWorldUpdater&) = delete;
+  CoalescingWorldUpdater& operator=(const CoalescingWorldUpdater&) = delete;
+
+  // Like ObjectWorldClient::UpdateJointPositions(), but write-behind.
+  void UpdateJointPositions(const KinematicObject& kinematic_object,
+                            const eigenmath::VectorXd& joint_positions);
+
+  // Like the ObjectWorldClient::UpdateTransform() overloads without entity
+  // filters, but write-behind.
+  void UpdateTransform(const TransformNode& node_a, const TransformNode& node_b,
+                       const Pose3d& a_t_b);
+  void UpdateTransform(const TransformNode& node_a, const TransformNode& node_b,
+                       const TransformNode& node_to_update,
+                       const Pose3d& a_t_b);
+
+  // Sends the pending updates without waiting for the flush period. Does not
+  // wait for them to be applied.
+  void Flush();
+
+  // Sends the pending updates and waits until all updates made before the call
+  // are applied, so that subsequent reads through the ObjectWorldClient see
+  // them. Returns the first error of any batch since the previous Barrier(),
+  // or DeadlineExceeded if waiting takes until `deadline`.
+  absl::Status Barrier(absl::Time deadline = absl::InfiniteFuture());
+
+  Stats stats() const;
+
+ private:
+  // node_a, node_b and node_to_update of an UpdateTransform(), with an empty
+  // node_to_update if none was given.
+  using TransformKey = std::tuple<ObjectWorldResourceId, ObjectWorldResourceId,
+                                  ObjectWorldResourceId>;
+
+  struct PendingUpdate {
+    // Sequence number of the latest change.
+    uint64_t sequence;
+    intrinsic_proto::world::ObjectWorldUpdate update;
+  };
+
+  // Adds or replaces the pending update in `pending`.
+  template <typename Key>
+  void Add(absl::flat_hash_map<Key, PendingUpdate>& pending, const Key& key,
+           intrinsic_proto::world::ObjectWorldUpdate&& update);
+  // Returns the pending updates, ordered by their sequence number.
+  intrinsic_proto::world::ObjectWorldUpdates TakePending()
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  bool HasPending() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Returns true if Options::max_pending_updates is reached.
+  bool IsFull() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Sends `updates` with one BatchUpdate() call each. Returns the first error
+  // and sets `failed` to the number of failed updates.
+  absl::Status SendIndividually(
+      const intrinsic_proto::world::ObjectWorldUpdates& updates,
+      int64_t& failed) ABSL_LOCKS_EXCLUDED(mutex_);
+  void Run();
+
+  ObjectWorldClient* const client_;
+  const std::string world_id_;
+  const Options options_;
+
+  mutable absl::Mutex mutex_;
+  absl::flat_hash_map<ObjectWorldResourceId, PendingUpdate> pending_joints_
+      ABSL_GUARDED_BY(mutex_);
+  absl::flat_hash_map<TransformKey, PendingUpdate> pending_transforms_
+      ABSL_GUARDED_BY(mutex_);
+  // When the oldest pending update was made.
+  absl::Time first_pending_ ABSL_GUARDED_BY(mutex_);
+  uint64_t next_sequence_ ABSL_GUARDED_BY(mutex_) = 0;
+  // Updates before this sequence number are applied or failed.
+  uint64_t done_sequence_ ABSL_GUARDED_BY(mutex_) = 0;
+  bool flush_requested_ ABSL_GUARDED_BY(mutex_) = false;
+  bool stop_ ABSL_GUARDED_BY(mutex_) = false;
+  absl::Status status_ ABSL_GUARDED_BY(mutex_);
+  Stats stats_ ABSL_GUARDED_BY(mutex_);
+
+  Thread thread_;
+};
+
+}  // namespace world
+}  // namespace intrinsic
+
+#endif  // INTRINSIC_WORLD_OBJECTS_COALESCING_WORLD_UPDATER_H_
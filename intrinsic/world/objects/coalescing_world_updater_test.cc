@@ -0,0 +1,262 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/world/objects/coalescing_world_updater.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "grpcpp/server.h"
+#include "grpcpp/server_builder.h"
+#include "grpcpp/server_context.h"
+#include "grpcpp/support/channel_arguments.h"
+#include "grpcpp/support/status.h"
+#include "intrinsic/eigenmath/types.h"
+#include "intrinsic/math/pose3.h"
+#include "intrinsic/math/proto_conversion.h"
+#include "intrinsic/util/testing/gtest_wrapper.h"
+#include "intrinsic/world/objects/kinematic_object.h"
+#include "intrinsic/world/objects/object_world_client.h"
+#include "intrinsic/world/proto/object_world_service.grpc.pb.h"
+#include "intrinsic/world/proto/object_world_service.pb.h"
+#include "intrinsic/world/proto/object_world_updates.pb.h"
+
+namespace intrinsic {
+namespace world {
+namespace {
+
+using ::intrinsic::testing::StatusIs;
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+using ::testing::Pair;
+using ::testing::UnorderedElementsAre;
+
+constexpr char kWorldId[] = "world";
+
+// Applies joint updates atomically per UpdateWorldResources() call, like the
+// world service, and records them.
+class FakeObjectWorldService
+    : public intrinsic_proto::world::ObjectWorldService::Service {
+ public:
+  grpc::Status UpdateWorldResources(
+      grpc::ServerContext* context,
+      const intrinsic_proto::world::UpdateWorldResourcesRequest* request,
+      intrinsic_proto::world::UpdateWorldResourcesResponse* response) override {
+    absl::MutexLock lock(&mutex_);
+    std::vector<std::string> batch;
+    for (const intrinsic_proto::world::ObjectWorldUpdate& update :
+         request->world_updates().updates()) {
+      const std::string& id = update.update_object_joints().object().id();
+      if (failing_objects_.contains(id)) {
+        return grpc::Status(grpc::StatusCode::NOT_FOUND,
+                            "Object " + id + " does not exist.");
+      }
+      batch.push_back(id);
+    }
+    for (const intrinsic_proto::world::ObjectWorldUpdate& update :
+         request->world_updates().updates()) {
+      const intrinsic_proto::world::UpdateObjectJointsRequest& joints =
+          update.update_object_joints();
+      joint_positions_[joints.object().id()] = std::vector<double>(
+          joints.joint_positions().begin(), joints.joint_positions().end());
+    }
+    batches_.push_back(std::move(batch));
+    return grpc::Status::OK;
+  }
+
+  // Lets all updates of object `id` fail.
+  void FailUpdatesOf(const std::string& id) {
+    absl::MutexLock lock(&mutex_);
+    failing_objects_.insert(id);
+  }
+
+  // Returns the object ids of each applied batch.
+  std::vector<std::vector<std::string>> batches() const {
+    absl::MutexLock lock(&mutex_);
+    return batches_;
+  }
+
+  // Returns the applied joint positions per object id.
+  absl::flat_hash_map<std::string, std::vector<double>> joint_positions()
+      const {
+    absl::MutexLock lock(&mutex_);
+    return joint_positions_;
+  }
+
+  // Returns true once `num_batches` batches were applied, false if that takes
+  // until `deadline`.
+  bool AwaitBatches(size_t num_batches, absl::Time deadline) const {
+    absl::MutexLock lock(&mutex_);
+    auto applied = [this, num_batches]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(
+                       mutex_) { return batches_.size() >= num_batches; };
+    return mutex_.AwaitWithDeadline(absl::Condition(&applied), deadline);
+  }
+
+ private:
+  mutable absl::Mutex mutex_;
+  absl::flat_hash_set<std::string> failing_objects_ ABSL_GUARDED_BY(mutex_);
+  std::vector<std::vector<std::string>> batches_ ABSL_GUARDED_BY(mutex_);
+  absl::flat_hash_map<std::string, std::vector<double>> joint_positions_
+      ABSL_GUARDED_BY(mutex_);
+};
+
+KinematicObject MakeRobot(const std::string& id) {
+  intrinsic_proto::world::Object proto;
+  proto.set_world_id(kWorldId);
+  proto.set_id(id);
+  proto.set_name(id);
+  proto.set_type(intrinsic_proto::world::ObjectType::KINEMATIC_OBJECT);
+  *proto.mutable_object_component()->mutable_parent_t_this() =
+      ToProto(Pose3d());
+  proto.mutable_kinematic_object_component()->add_joint_positions(0.0);
+  absl::StatusOr<KinematicObject> robot = KinematicObject::Create(proto);
+  CHECK_OK(robot.status());
+  return *std::move(robot);
+}
+
+eigenmath::VectorXd JointPositions(double position) {
+  return eigenmath::VectorXd::Constant(1, position);
+}
+
+class CoalescingWorldUpdaterTest : public ::testing::Test {
+ protected:
+  CoalescingWorldUpdaterTest() {
+    grpc::ServerBuilder builder;
+    builder.RegisterService(&service_);
+    server_ = builder.BuildAndStart();
+    stub_ = intrinsic_proto::world::ObjectWorldService::NewStub(
+        server_->InProcessChannel(grpc::ChannelArguments()));
+    client_ = std::make_unique<ObjectWorldClient>(kWorldId, stub_);
+  }
+  ~CoalescingWorldUpdaterTest() override { server_->Shutdown(); }
+
+  // Options which only send updates when asked to.
+  static CoalescingWorldUpdater::Options OnlyExplicitFlushes() {
+    return {.flush_period = absl::InfiniteDuration(),
+            .max_pending_updates = 1000};
+  }
+
+  FakeObjectWorldService service_;
+  std::unique_ptr<grpc::Server> server_;
+  std::shared_ptr<intrinsic_proto::world::ObjectWorldService::StubInterface>
+      stub_;
+  std::unique_ptr<ObjectWorldClient> client_;
+};
+
+TEST_F(CoalescingWorldUpdaterTest, LatestUpdateWins) {
+  CoalescingWorldUpdater updater(client_.get(), OnlyExplicitFlushes());
+  const KinematicObject robot_a = MakeRobot("a");
+  const KinematicObject robot_b = MakeRobot("b");
+
+  updater.UpdateJointPositions(robot_a, JointPositions(1.0));
+  updater.UpdateJointPositions(robot_b, JointPositions(2.0));
+  updater.UpdateJointPositions(robot_a, JointPositions(3.0));
+  ASSERT_OK(updater.Barrier());
+
+  // One batch in the order of the latest changes.
+  EXPECT_THAT(service_.batches(), ElementsAre(ElementsAre("b", "a")));
+  EXPECT_THAT(service_.joint_positions(),
+              UnorderedElementsAre(Pair("a", ElementsAre(3.0)),
+                                   Pair("b", ElementsAre(2.0))));
+  const CoalescingWorldUpdater::Stats stats = updater.stats();
+  EXPECT_EQ(stats.updates_added, 3);
+  EXPECT_EQ(stats.updates_coalesced, 1);
+  EXPECT_EQ(stats.batches_sent, 1);
+  EXPECT_EQ(stats.batches_failed, 0);
+}
+
+TEST_F(CoalescingWorldUpdaterTest, BarrierWaitsUntilUpdatesAreApplied) {
+  CoalescingWorldUpdater updater(client_.get(), OnlyExplicitFlushes());
+  const KinematicObject robot = MakeRobot("a");
+
+  for (int i = 1; i <= 3; ++i) {
+    updater.UpdateJointPositions(robot, JointPositions(i));
+    ASSERT_OK(updater.Barrier());
+    EXPECT_THAT(service_.joint_positions(),
+                UnorderedElementsAre(Pair("a", ElementsAre(i))));
+  }
+  EXPECT_EQ(updater.stats().batches_sent, 3);
+
+  // Without pending updates, there is nothing to wait for.
+  ASSERT_OK(updater.Barrier());
+  EXPECT_EQ(updater.stats().batches_sent, 3);
+}
+
+TEST_F(CoalescingWorldUpdaterTest, SendsOnceMaxPendingUpdatesIsReached) {
+  CoalescingWorldUpdater updater(
+      client_.get(), {.flush_period = absl::InfiniteDuration(),
+                      .max_pending_updates = 2});
+
+  updater.UpdateJointPositions(MakeRobot("a"), JointPositions(1.0));
+  EXPECT_FALSE(service_.AwaitBatches(1, absl::Now() + absl::Milliseconds(50)));
+  updater.UpdateJointPositions(MakeRobot("b"), JointPositions(2.0));
+  ASSERT_TRUE(service_.AwaitBatches(1, absl::Now() + absl::Seconds(10)));
+
+  EXPECT_THAT(service_.batches(), ElementsAre(ElementsAre("a", "b")));
+}
+
+TEST_F(CoalescingWorldUpdaterTest, SendsAfterFlushPeriod) {
+  CoalescingWorldUpdater updater(
+      client_.get(), {.flush_period = absl::Milliseconds(10),
+                      .max_pending_updates = 1000});
+
+  updater.UpdateJointPositions(MakeRobot("a"), JointPositions(1.0));
+  ASSERT_TRUE(service_.AwaitBatches(1, absl::Now() + absl::Seconds(10)));
+
+  EXPECT_THAT(service_.batches(), ElementsAre(ElementsAre("a")));
+}
+
+TEST_F(CoalescingWorldUpdaterTest, FailingUpdateDoesNotDiscardOthers) {
+  CoalescingWorldUpdater updater(client_.get(), OnlyExplicitFlushes());
+  service_.FailUpdatesOf("b");
+
+  updater.UpdateJointPositions(MakeRobot("a"), JointPositions(1.0));
+  updater.UpdateJointPositions(MakeRobot("b"), JointPositions(2.0));
+  updater.UpdateJointPositions(MakeRobot("c"), JointPositions(3.0));
+  EXPECT_THAT(updater.Barrier(), StatusIs(absl::StatusCode::kNotFound));
+
+  EXPECT_THAT(service_.joint_positions(),
+              UnorderedElementsAre(Pair("a", ElementsAre(1.0)),
+                                   Pair("c", ElementsAre(3.0))));
+  const CoalescingWorldUpdater::Stats stats = updater.stats();
+  EXPECT_EQ(stats.batches_failed, 1);
+  EXPECT_EQ(stats.updates_failed, 1);
+
+  // The error is only reported once, and the failing object doesn't block
+  // later updates of the others.
+  ASSERT_OK(updater.Barrier());
+  updater.UpdateJointPositions(MakeRobot("b"), JointPositions(4.0));
+  updater.UpdateJointPositions(MakeRobot("a"), JointPositions(5.0));
+  EXPECT_THAT(updater.Barrier(), StatusIs(absl::StatusCode::kNotFound));
+  EXPECT_THAT(service_.joint_positions(),
+              UnorderedElementsAre(Pair("a", ElementsAre(5.0)),
+                                   Pair("c", ElementsAre(3.0))));
+  EXPECT_EQ(updater.stats().updates_failed, 2);
+}
+
+TEST_F(CoalescingWorldUpdaterTest, DestructorSendsPendingUpdates) {
+  {
+    CoalescingWorldUpdater updater(client_.get(), OnlyExplicitFlushes());
+    updater.UpdateJointPositions(MakeRobot("a"), JointPositions(1.0));
+    EXPECT_THAT(service_.batches(), IsEmpty());
+  }
+
+  EXPECT_THAT(service_.joint_positions(),
+              UnorderedElementsAre(Pair("a", ElementsAre(1.0))));
+}
+
+}  // namespace
+}  // namespace world
+}  // namespace intrinsic
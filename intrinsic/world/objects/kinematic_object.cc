@@ -9,14 +9,18 @@
 #include <vector>
 
 #include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/substitute.h"
 #include "intrinsic/eigenmath/types.h"
 #include "intrinsic/icon/proto/cart_space_conversion.h"
+#include "intrinsic/kinematics/kinematic_chain.h"
 #include "intrinsic/kinematics/types/cartesian_limits.h"
 #include "intrinsic/kinematics/types/joint_limits_xd.h"
+#include "intrinsic/math/pose3.h"
+#include "intrinsic/math/proto_conversion.h"
 #include "intrinsic/util/eigen.h"
 #include "intrinsic/util/status/status_macros.h"
 #include "intrinsic/world/objects/frame.h"
@@ -166,6 +170,97 @@ absl::StatusOr<std::optional<RobotPayload>> KinematicObject::GetMountedPayload()
   return GetData().MountedPayload();
 }
 
+absl::StatusOr<kinematics::KinematicChain> KinematicObject::GetKinematicChain()
+    const {
+  const intrinsic_proto::world::Object& proto = GetData().Proto();
+  const auto& entities = proto.entities();
+  if (entities.empty()) {
+    return absl::FailedPreconditionError(absl::Substitute(
+        "Kinematic object \"$0\" has no entities, it must be retrieved with "
+        "the FULL view.",
+        Name().value()));
+  }
+  absl::flat_hash_set<std::string> parent_ids;
+  for (const auto& [id, entity] : entities) {
+    parent_ids.insert(entity.parent_id());
+  }
+  std::vector<std::string> final_entity_ids;
+  for (const auto& [id, entity] : entities) {
+    if (!parent_ids.contains(id)) {
+      final_entity_ids.push_back(id);
+    }
+  }
+  if (final_entity_ids.size() != 1) {
+    return absl::FailedPreconditionError(absl::Substitute(
+        "Kinematic object \"$0\" has $1 final entities, but exactly one was "
+        "expected.",
+        Name().value(), final_entity_ids.size()));
+  }
+
+  // The entities from the final entity up to, but excluding, the root entity.
+  std::vector<const intrinsic_proto::world::Entity*> path;
+  for (std::string id = final_entity_ids.front(); id != proto.root_entity_id();
+       id = path.back()->parent_id()) {
+    auto it = entities.find(id);
+    if (it == entities.end() || path.size() == entities.size()) {
+      return absl::InvalidArgumentError(absl::Substitute(
+          "The final entity of kinematic object \"$0\" is not connected to "
+          "its root entity.",
+          Name().value()));
+    }
+    path.push_back(&it->second);
+  }
+
+  const auto& joint_entity_ids =
+      proto.kinematic_object_component().joint_entity_ids();
+  std::vector<kinematics::ChainJoint> joints;
+  Pose3d previous_t_entity;
+  for (auto it = path.rbegin(); it != path.rend(); ++it) {
+    const intrinsic_proto::world::Entity& entity = **it;
+    const intrinsic_proto::world::KinematicsComponent& kinematics =
+        entity.kinematics_component();
+    kinematics::ChainJoint::Type type;
+    switch (kinematics.motion_type()) {
+      case intrinsic_proto::world::KinematicsComponent::MOTION_TYPE_REVOLUTE:
+        type = kinematics::ChainJoint::Type::kRevolute;
+        break;
+      case intrinsic_proto::world::KinematicsComponent::MOTION_TYPE_PRISMATIC:
+        type = kinematics::ChainJoint::Type::kPrismatic;
+        break;
+      default: {
+        INTR_ASSIGN_OR_RETURN(
+            Pose3d parent_t_entity,
+            intrinsic_proto::FromProto(entity.parent_t_this()));
+        previous_t_entity = previous_t_entity * parent_t_entity;
+        continue;
+      }
+    }
+    auto dof_it = absl::c_find(joint_entity_ids, entity.id());
+    if (dof_it == joint_entity_ids.end()) {
+      return absl::InvalidArgumentError(absl::Substitute(
+          "Entity \"$0\" of kinematic object \"$1\" has a kinematics "
+          "component but is not one of its joint entities.",
+          entity.name(), Name().value()));
+    }
+    INTR_ASSIGN_OR_RETURN(
+        Pose3d parent_t_inboard,
+        intrinsic_proto::FromProto(kinematics.parent_t_inboard()));
+    joints.push_back(
+        {.type = type,
+         .dof_index = static_cast<int>(dof_it - joint_entity_ids.begin()),
+         .previous_t_inboard = previous_t_entity * parent_t_inboard,
+         .axis = kinematics.has_axis()
+                     ? eigenmath::Vector3d(kinematics.axis().x(),
+                                           kinematics.axis().y(),
+                                           kinematics.axis().z())
+                     : eigenmath::Vector3d::UnitZ()});
+    previous_t_entity = Pose3d();
+  }
+  return kinematics::KinematicChain::Create(std::move(joints),
+                                            previous_t_entity,
+                                            joint_entity_ids.size());
+}
+
 const KinematicObject::Data& KinematicObject::GetData() const {
   // This has to succeed because instances of KinematicObject are always only
   // created with an instance of KinematicObject::Data or a subclass thereof.
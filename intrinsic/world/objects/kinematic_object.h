@@ -9,6 +9,7 @@
 
 #include "absl/status/statusor.h"
 #include "intrinsic/eigenmath/types.h"
+#include "intrinsic/kinematics/kinematic_chain.h"
 #include "intrinsic/kinematics/types/cartesian_limits.h"
 #include "intrinsic/kinematics/types/joint_limits_xd.h"
 #include "intrinsic/world/objects/frame.h"
@@ -75,6 +76,16 @@ class KinematicObject : public WorldObject {
   // Gets the mounted payload if it is set, nullopt otherwise.
   absl::StatusOr<std::optional<RobotPayload>> GetMountedPayload() const;
 
+  // Returns the kinematic chain from the origin of this object to its final
+  // entity, which evaluates forward kinematics and Jacobians locally. The chain
+  // takes joint positions ordered like JointPositions().
+  //
+  // Joint entities are placed by their KinematicsComponent and the joint
+  // position, all other entities by their parent_t_this. Returns an error if
+  // the object has no unique final entity or was retrieved without the FULL
+  // view.
+  absl::StatusOr<kinematics::KinematicChain> GetKinematicChain() const;
+
  private:
   class Data final : public WorldObject::Data {
    public:
@@ -0,0 +1,158 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/world/objects/kinematic_object.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "absl/status/status.h"
+#include "intrinsic/eigenmath/types.h"
+#include "intrinsic/icon/utils/realtime_status_or.h"
+#include "intrinsic/kinematics/kinematic_chain.h"
+#include "intrinsic/math/pose3.h"
+#include "intrinsic/util/proto/parse_text_proto.h"
+#include "intrinsic/util/testing/gtest_wrapper.h"
+#include "intrinsic/world/proto/object_world_service.pb.h"
+
+namespace intrinsic {
+namespace world {
+namespace {
+
+using ::intrinsic::testing::StatusIs;
+using ::testing::HasSubstr;
+
+// A robot as returned with the FULL view: the root entity, a revolute joint
+// about z, a prismatic joint along x and a flange without kinematics.
+intrinsic_proto::world::Object MakeFullViewRobot() {
+  return ParseTextProtoOrDie(R"pb(
+    world_id: "world"
+    id: "robot"
+    name: "robot"
+    type: KINEMATIC_OBJECT
+    object_component { parent_t_this { orientation { w: 1 } } }
+    kinematic_object_component {
+      joint_positions: 0
+      joint_positions: 0
+      joint_entity_ids: "joint_1"
+      joint_entity_ids: "joint_2"
+    }
+    root_entity_id: "root"
+    entities {
+      key: "root"
+      value {
+        id: "root"
+        name: "root"
+        parent_t_this { orientation { w: 1 } }
+      }
+    }
+    entities {
+      key: "joint_1"
+      value {
+        id: "joint_1"
+        name: "joint_1"
+        parent_id: "root"
+        kinematics_component {
+          motion_type: MOTION_TYPE_REVOLUTE
+          parent_t_inboard {
+            position { z: 0.5 }
+            orientation { w: 1 }
+          }
+          axis { z: 1 }
+        }
+      }
+    }
+    entities {
+      key: "joint_2"
+      value {
+        id: "joint_2"
+        name: "joint_2"
+        parent_id: "joint_1"
+        kinematics_component {
+          motion_type: MOTION_TYPE_PRISMATIC
+          parent_t_inboard {
+            position { x: 1 }
+            orientation { w: 1 }
+          }
+          axis { x: 1 }
+        }
+      }
+    }
+    entities {
+      key: "flange"
+      value {
+        id: "flange"
+        name: "flange"
+        parent_id: "joint_2"
+        parent_t_this {
+          position { z: -0.1 }
+          orientation { w: 1 }
+        }
+      }
+    }
+  )pb");
+}
+
+TEST(KinematicObjectTest, GetKinematicChainFromFullView) {
+  ASSERT_OK_AND_ASSIGN(const KinematicObject robot,
+                       KinematicObject::Create(MakeFullViewRobot()));
+
+  ASSERT_OK_AND_ASSIGN(const kinematics::KinematicChain chain,
+                       robot.GetKinematicChain());
+
+  ASSERT_EQ(chain.num_dof(), 2);
+  ASSERT_EQ(chain.joints().size(), 2);
+  EXPECT_EQ(chain.joints()[0].type, kinematics::ChainJoint::Type::kRevolute);
+  EXPECT_EQ(chain.joints()[0].dof_index, 0);
+  EXPECT_EQ(chain.joints()[1].type, kinematics::ChainJoint::Type::kPrismatic);
+  EXPECT_EQ(chain.joints()[1].dof_index, 1);
+  // Rotating by 90 degrees turns the link and the prismatic axis to y.
+  const icon::RealtimeStatusOr<Pose3d> base_t_tip_or = chain.ComputeFk(
+      eigenmath::VectorNd(eigenmath::Vector2d(M_PI / 2, 0.25)));
+  ASSERT_TRUE(base_t_tip_or.ok());
+  const Pose3d& base_t_tip = *base_t_tip_or;
+  EXPECT_TRUE(base_t_tip.translation().isApprox(
+      eigenmath::Vector3d(0, 1.25, 0.4), 1e-9))
+      << base_t_tip.translation().transpose();
+}
+
+TEST(KinematicObjectTest, GetKinematicChainRequiresFullView) {
+  intrinsic_proto::world::Object proto = MakeFullViewRobot();
+  proto.clear_entities();
+  ASSERT_OK_AND_ASSIGN(const KinematicObject robot,
+                       KinematicObject::Create(proto));
+
+  EXPECT_THAT(robot.GetKinematicChain(),
+              StatusIs(absl::StatusCode::kFailedPrecondition,
+                       HasSubstr("FULL view")));
+}
+
+TEST(KinematicObjectTest, GetKinematicChainRejectsBranches) {
+  intrinsic_proto::world::Object proto = MakeFullViewRobot();
+  intrinsic_proto::world::Entity& camera =
+      (*proto.mutable_entities())["camera"];
+  camera.set_id("camera");
+  camera.set_parent_id("joint_1");
+  ASSERT_OK_AND_ASSIGN(const KinematicObject robot,
+                       KinematicObject::Create(proto));
+
+  EXPECT_THAT(robot.GetKinematicChain(),
+              StatusIs(absl::StatusCode::kFailedPrecondition,
+                       HasSubstr("2 final entities")));
+}
+
+TEST(KinematicObjectTest, GetKinematicChainRejectsUnknownJointEntities) {
+  intrinsic_proto::world::Object proto = MakeFullViewRobot();
+  proto.mutable_kinematic_object_component()
+      ->mutable_joint_entity_ids()
+      ->RemoveLast();
+  ASSERT_OK_AND_ASSIGN(const KinematicObject robot,
+                       KinematicObject::Create(proto));
+
+  EXPECT_THAT(robot.GetKinematicChain(),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("\"joint_2\"")));
+}
+
+}  // namespace
+}  // namespace world
+}  // namespace intrinsic
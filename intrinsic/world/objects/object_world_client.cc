@@ -8,11 +8,15 @@
 #include <utility>
 #include <vector>
 
+#include "absl/base/thread_annotations.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "grpcpp/client_context.h"
 #include "grpcpp/support/status.h"
 #include "intrinsic/eigenmath/types.h"
@@ -28,6 +32,7 @@
 #include "intrinsic/resources/proto/resource_handle.pb.h"
 #include "intrinsic/skills/proto/equipment.pb.h"
 #include "intrinsic/util/eigen.h"
+#include "intrinsic/util/proto_time.h"
 #include "intrinsic/util/status/status_conversion_grpc.h"
 #include "intrinsic/util/status/status_macros.h"
 #include "intrinsic/world/objects/frame.h"
@@ -35,6 +40,7 @@
 #include "intrinsic/world/objects/object_entity_filter.h"
 #include "intrinsic/world/objects/object_world_ids.h"
 #include "intrinsic/world/objects/transform_node.h"
+#include "intrinsic/world/objects/transform_tree_snapshot.h"
 #include "intrinsic/world/objects/world_object.h"
 #include "intrinsic/world/proto/collision_settings.pb.h"
 #include "intrinsic/world/proto/object_world_refs.pb.h"
@@ -151,12 +157,32 @@ absl::Status CallCreateFrame(
 
 }  // namespace
 
+struct ObjectWorldClient::TransformCache {
+  explicit TransformCache(const TransformCacheOptions& options)
+      : options(options) {}
+
+  const TransformCacheOptions options;
+
+  absl::Mutex mutex;
+  // Null if the snapshot has to be rebuilt.
+  std::shared_ptr<const TransformTreeSnapshot> snapshot ABSL_GUARDED_BY(mutex);
+  // The time of the last update of the world when `snapshot` was built, and
+  // when that was last checked. Only used with a world version check interval.
+  absl::Time world_last_update ABSL_GUARDED_BY(mutex) = absl::InfinitePast();
+  absl::Time last_version_check ABSL_GUARDED_BY(mutex) = absl::InfinitePast();
+};
+
 ObjectWorldClient::ObjectWorldClient(
     absl::string_view world_id,
     std::shared_ptr<ObjectWorldService::StubInterface> object_world_service)
     : world_id_(world_id),
       object_world_service_(std::move(object_world_service)) {}
 
+ObjectWorldClient::ObjectWorldClient(ObjectWorldClient&& other) = default;
+ObjectWorldClient& ObjectWorldClient::operator=(ObjectWorldClient&& other) =
+    default;
+ObjectWorldClient::~ObjectWorldClient() = default;
+
 namespace {
 
 absl::StatusOr<TransformNode> GetTransformNodeById(
@@ -305,6 +331,7 @@ absl::Status ObjectWorldClient::DeleteObject(const WorldObject& object,
   google::protobuf::Empty response;
   INTR_RETURN_IF_ERROR(ToAbslStatus(
       object_world_service_->DeleteObject(&ctx, request, &response)));
+  InvalidateTransformCache();
   return absl::OkStatus();
 }
 
@@ -441,8 +468,11 @@ absl::Status ObjectWorldClient::CreateFrame(const FrameName& new_frame_name,
                                             const Pose3d& parent_t_new_frame) {
   intrinsic_proto::world::CreateFrameRequest request;
   request.mutable_parent_object()->set_id(parent_object.Id().value());
-  return CallCreateFrame(std::move(request), new_frame_name, parent_t_new_frame,
-                         world_id_, *object_world_service_);
+  INTR_RETURN_IF_ERROR(CallCreateFrame(std::move(request), new_frame_name,
+                                       parent_t_new_frame, world_id_,
+                                       *object_world_service_));
+  InvalidateTransformCache();
+  return absl::OkStatus();
 }
 
 absl::Status ObjectWorldClient::CreateFrame(const FrameName& new_frame_name,
@@ -450,8 +480,11 @@ absl::Status ObjectWorldClient::CreateFrame(const FrameName& new_frame_name,
                                             const Pose3d& parent_t_new_frame) {
   intrinsic_proto::world::CreateFrameRequest request;
   request.mutable_parent_frame()->set_id(parent_frame.Id().value());
-  return CallCreateFrame(std::move(request), new_frame_name, parent_t_new_frame,
-                         world_id_, *object_world_service_);
+  INTR_RETURN_IF_ERROR(CallCreateFrame(std::move(request), new_frame_name,
+                                       parent_t_new_frame, world_id_,
+                                       *object_world_service_));
+  InvalidateTransformCache();
+  return absl::OkStatus();
 }
 
 absl::Status ObjectWorldClient::UpdateObjectName(
@@ -495,6 +528,17 @@ absl::StatusOr<Pose3d> ObjectWorldClient::GetTransform(
     std::optional<ObjectEntityFilter> node_a_filter,
     const TransformNode& node_b,
     std::optional<ObjectEntityFilter> node_b_filter) const {
+  if (transform_cache_ != nullptr && !node_a_filter.has_value() &&
+      !node_b_filter.has_value()) {
+    INTR_ASSIGN_OR_RETURN(std::shared_ptr<const TransformTreeSnapshot> snapshot,
+                          GetTransformTreeSnapshot());
+    // Nodes which are not in the snapshot may have been created by another
+    // client since, so ask the world service.
+    if (snapshot->Contains(node_a.Id()) && snapshot->Contains(node_b.Id())) {
+      return snapshot->GetTransform(node_a.Id(), node_b.Id());
+    }
+  }
+
   grpc::ClientContext ctx;
   intrinsic_proto::world::GetTransformRequest request;
   request.set_world_id(world_id_);
@@ -517,17 +561,21 @@ absl::StatusOr<Pose3d> ObjectWorldClient::GetTransform(
 absl::Status ObjectWorldClient::UpdateTransform(const TransformNode& node_a,
                                                 const TransformNode& node_b,
                                                 const Pose3d& a_t_b) {
-  return CallUpdateTransform(node_a.Id(), std::nullopt, node_b.Id(),
-                             std::nullopt, std::nullopt, std::nullopt, a_t_b,
-                             world_id_, *object_world_service_);
+  INTR_RETURN_IF_ERROR(CallUpdateTransform(
+      node_a.Id(), std::nullopt, node_b.Id(), std::nullopt, std::nullopt,
+      std::nullopt, a_t_b, world_id_, *object_world_service_));
+  InvalidateTransformCache();
+  return absl::OkStatus();
 }
 
 absl::Status ObjectWorldClient::UpdateTransform(
     const TransformNode& node_a, const TransformNode& node_b,
     const TransformNode& node_to_update, const Pose3d& a_t_b) {
-  return CallUpdateTransform(node_a.Id(), std::nullopt, node_b.Id(),
-                             std::nullopt, node_to_update.Id(), std::nullopt,
-                             a_t_b, world_id_, *object_world_service_);
+  INTR_RETURN_IF_ERROR(CallUpdateTransform(
+      node_a.Id(), std::nullopt, node_b.Id(), std::nullopt, node_to_update.Id(),
+      std::nullopt, a_t_b, world_id_, *object_world_service_));
+  InvalidateTransformCache();
+  return absl::OkStatus();
 }
 
 absl::Status ObjectWorldClient::UpdateTransform(
@@ -535,10 +583,12 @@ absl::Status ObjectWorldClient::UpdateTransform(
     const TransformNode& node_b, const ObjectEntityFilter& node_b_filter,
     const TransformNode& node_to_update,
     const ObjectEntityFilter& node_to_update_filter, const Pose3d& a_t_b) {
-  return CallUpdateTransform(node_a.Id(), node_a_filter, node_b.Id(),
-                             node_b_filter, node_to_update.Id(),
-                             node_to_update_filter, a_t_b, world_id_,
-                             *object_world_service_);
+  INTR_RETURN_IF_ERROR(CallUpdateTransform(
+      node_a.Id(), node_a_filter, node_b.Id(), node_b_filter,
+      node_to_update.Id(), node_to_update_filter, a_t_b, world_id_,
+      *object_world_service_));
+  InvalidateTransformCache();
+  return absl::OkStatus();
 }
 
 absl::Status ObjectWorldClient::UpdateJointPositions(
@@ -554,6 +604,7 @@ absl::Status ObjectWorldClient::UpdateJointPositions(
   intrinsic_proto::world::Object response;
   INTR_RETURN_IF_ERROR(ToAbslStatus(
       object_world_service_->UpdateObjectJoints(&ctx, request, &response)));
+  InvalidateTransformCache();
   return absl::OkStatus();
 }
 
@@ -655,6 +706,7 @@ absl::Status ObjectWorldClient::BatchUpdate(
   intrinsic_proto::world::UpdateWorldResourcesResponse response;
   INTR_RETURN_IF_ERROR(ToAbslStatus(
       object_world_service_->UpdateWorldResources(&ctx, request, &response)));
+  InvalidateTransformCache();
   return absl::OkStatus();
 }
 
@@ -693,8 +745,10 @@ absl::Status ObjectWorldClient::ReparentObject(const WorldObject& object,
 absl::Status ObjectWorldClient::ReparentObject(
     const WorldObject& object, const WorldObject& new_parent,
     const ObjectEntityFilter& filter) {
-  return CallReparentObject(object, new_parent, filter.ToProto(), world_id_,
-                            *object_world_service_);
+  INTR_RETURN_IF_ERROR(CallReparentObject(object, new_parent, filter.ToProto(),
+                                          world_id_, *object_world_service_));
+  InvalidateTransformCache();
+  return absl::OkStatus();
 }
 
 absl::Status ObjectWorldClient::ReparentObjectToFinalEntity(
@@ -781,5 +835,61 @@ absl::Status ObjectWorldClient::EnableCollisions(
                               world_id_, *object_world_service_);
 }
 
+void ObjectWorldClient::EnableTransformCache(
+    const TransformCacheOptions& options) {
+  transform_cache_ = std::make_unique<TransformCache>(options);
+}
+
+void ObjectWorldClient::DisableTransformCache() { transform_cache_.reset(); }
+
+void ObjectWorldClient::InvalidateTransformCache() const {
+  if (transform_cache_ == nullptr) {
+    return;
+  }
+  absl::MutexLock lock(&transform_cache_->mutex);
+  transform_cache_->snapshot.reset();
+}
+
+absl::StatusOr<std::shared_ptr<const TransformTreeSnapshot>>
+ObjectWorldClient::GetTransformTreeSnapshot() const {
+  if (transform_cache_ == nullptr) {
+    return absl::FailedPreconditionError(
+        "The transform cache is not enabled.");
+  }
+  TransformCache& cache = *transform_cache_;
+  const std::optional<absl::Duration>& check_interval =
+      cache.options.world_version_check_interval;
+  // Holding the lock during the calls below lets concurrent callers wait for
+  // one rebuild instead of each rebuilding the snapshot.
+  absl::MutexLock lock(&cache.mutex);
+  if (check_interval.has_value() &&
+      absl::Now() - cache.last_version_check >= *check_interval) {
+    INTR_ASSIGN_OR_RETURN(absl::Time world_last_update, GetWorldLastUpdate());
+    cache.last_version_check = absl::Now();
+    if (world_last_update != cache.world_last_update) {
+      cache.snapshot.reset();
+      cache.world_last_update = world_last_update;
+    }
+  }
+  if (cache.snapshot == nullptr) {
+    INTR_ASSIGN_OR_RETURN(std::vector<WorldObject> objects, ListObjects());
+    INTR_ASSIGN_OR_RETURN(TransformTreeSnapshot snapshot,
+                          TransformTreeSnapshot::Create(objects));
+    cache.snapshot =
+        std::make_shared<const TransformTreeSnapshot>(std::move(snapshot));
+  }
+  return cache.snapshot;
+}
+
+absl::StatusOr<absl::Time> ObjectWorldClient::GetWorldLastUpdate() const {
+  grpc::ClientContext ctx;
+  intrinsic_proto::world::GetWorldRequest request;
+  request.set_world_id(world_id_);
+  intrinsic_proto::world::WorldMetadata response;
+  INTR_RETURN_IF_ERROR(
+      ToAbslStatus(object_world_service_->GetWorld(&ctx, request, &response)));
+  return ToAbslTime(response.last_update());
+}
+
 }  // namespace world
 }  // namespace intrinsic
@@ -11,6 +11,7 @@
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/time.h"
 #include "intrinsic/eigenmath/types.h"
 #include "intrinsic/kinematics/types/cartesian_limits.h"
 #include "intrinsic/kinematics/types/joint_limits_xd.h"
@@ -23,6 +24,7 @@
 #include "intrinsic/world/objects/object_entity_filter.h"
 #include "intrinsic/world/objects/object_world_ids.h"
 #include "intrinsic/world/objects/transform_node.h"
+#include "intrinsic/world/objects/transform_tree_snapshot.h"
 #include "intrinsic/world/objects/world_object.h"
 #include "intrinsic/world/proto/collision_settings.pb.h"
 #include "intrinsic/world/proto/geometry_component.pb.h"
@@ -34,6 +36,15 @@
 namespace intrinsic {
 namespace world {
 
+// Options for ObjectWorldClient::EnableTransformCache().
+struct TransformCacheOptions {
+  // If set, the cache asks the world service for the time of the last update of
+  // the world at most once per interval, and is rebuilt if the world was
+  // changed by another client. If not set, only the updates made through the
+  // same ObjectWorldClient invalidate the cache.
+  std::optional<absl::Duration> world_version_check_interval;
+};
+
 // Provides access to a remote world in the world service.
 //
 // Uses the object-based-view onto a world, i.e., a world is exposed in the
@@ -47,8 +58,9 @@ class ObjectWorldClient {
       absl::string_view world_id,
       std::shared_ptr<ObjectWorldService::StubInterface> object_world_service);
 
-  ObjectWorldClient(ObjectWorldClient&& other) = default;
-  ObjectWorldClient& operator=(ObjectWorldClient&& other) = default;
+  ObjectWorldClient(ObjectWorldClient&& other);
+  ObjectWorldClient& operator=(ObjectWorldClient&& other);
+  ~ObjectWorldClient();
 
   // Returns the ID of the world.
   absl::string_view GetWorldID() const { return world_id_; }
@@ -180,6 +192,8 @@ class ObjectWorldClient {
   // Returns the transform 'a_t_b', i.e., the pose of 'node_b' in the space of
   // 'node_a'. 'node_a' and 'node_b' can be arbitrary nodes in the transform
   // tree of the world and don't have to be parent and child.
+  //
+  // Resolved locally if the transform cache is enabled and contains both nodes.
   absl::StatusOr<Pose3d> GetTransform(const TransformNode& node_a,
                                       const TransformNode& node_b) const;
 
@@ -187,6 +201,9 @@ class ObjectWorldClient {
   // described by the given filter in the space of the entity within 'node_a'
   // described by the given filter. 'node_a' and 'node_b' can be arbitrary nodes
   // in the transform tree of the world and don't have to be parent and child.
+  //
+  // Resolved locally if the transform cache is enabled, contains both nodes and
+  // no filters are given.
   absl::StatusOr<Pose3d> GetTransform(
       const TransformNode& node_a,
       std::optional<ObjectEntityFilter> node_a_filter,
@@ -342,9 +359,43 @@ class ObjectWorldClient {
                                 const WorldObject& object_b,
                                 const ObjectEntityFilter& entity_filter_b);
 
+  // Enables the transform cache, which lets GetTransform() resolve transforms
+  // locally from a TransformTreeSnapshot instead of calling the world service
+  // each time. The snapshot is built from a single ListObjects() call when it
+  // is first needed, and rebuilt after this client changed a pose (e.g., with
+  // UpdateTransform(), UpdateJointPositions() or BatchUpdate()) or, depending
+  // on `options`, after another client changed the world.
+  //
+  // Only enable this if the world is not changed by other clients, or if
+  // `options.world_version_check_interval` bounds how long a stale transform
+  // is acceptable.
+  void EnableTransformCache(const TransformCacheOptions& options = {});
+
+  // Disables the transform cache and discards the cached snapshot.
+  void DisableTransformCache();
+
+  // Discards the cached snapshot, so that it is rebuilt when it is needed
+  // next. Call this if the world was changed by another client.
+  void InvalidateTransformCache() const;
+
+  // Returns the snapshot of the transform tree that GetTransform() uses,
+  // building it first if necessary. Useful to resolve many transforms at once
+  // without locking. Returns kFailedPrecondition if the transform cache is not
+  // enabled.
+  absl::StatusOr<std::shared_ptr<const TransformTreeSnapshot>>
+  GetTransformTreeSnapshot() const;
+
  private:
+  // Holds the state of the transform cache. Defined in the .cc file.
+  struct TransformCache;
+
+  // Returns the time of the last update of the world.
+  absl::StatusOr<absl::Time> GetWorldLastUpdate() const;
+
   std::string world_id_;
   std::shared_ptr<ObjectWorldService::StubInterface> object_world_service_;
+  // Only set if the transform cache is enabled.
+  std::unique_ptr<TransformCache> transform_cache_;
 };
 
 }  // namespace world
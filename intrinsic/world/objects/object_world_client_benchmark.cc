@@ -0,0 +1,315 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+// Resolves transforms between the frames of a chain of objects through
+// ObjectWorldClient::GetTransform(), once with a call to the world service per
+// transform and once with the transform cache enabled. Also updates the joint
+// positions of several robots per tick, once with a call to the world service
+// per robot and once through a CoalescingWorldUpdater. The world service is a
+// fake on an in-process channel, so the measured differences are lower bounds
+// for those against a remote world service.
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+#include "grpcpp/server.h"
+#include "grpcpp/server_builder.h"
+#include "grpcpp/server_context.h"
+#include "grpcpp/support/channel_arguments.h"
+#include "grpcpp/support/status.h"
+#include "intrinsic/eigenmath/types.h"
+#include "intrinsic/math/pose3.h"
+#include "intrinsic/math/proto_conversion.h"
+#include "intrinsic/world/objects/coalescing_world_updater.h"
+#include "intrinsic/world/objects/frame.h"
+#include "intrinsic/world/objects/kinematic_object.h"
+#include "intrinsic/world/objects/object_world_client.h"
+#include "intrinsic/world/objects/object_world_ids.h"
+#include "intrinsic/world/objects/transform_tree_snapshot.h"
+#include "intrinsic/world/objects/world_object.h"
+#include "intrinsic/world/proto/object_world_service.grpc.pb.h"
+#include "intrinsic/world/proto/object_world_service.pb.h"
+
+namespace intrinsic {
+namespace world {
+namespace {
+
+constexpr char kWorldId[] = "world";
+constexpr int kNumObjects = 20;
+constexpr int kNumFramesPerObject = 4;
+// The number of transforms resolved per benchmark iteration.
+constexpr int kNumTransforms = 50;
+// The number of robots whose joint positions are updated per tick.
+constexpr int kNumRobots = 10;
+constexpr int kNumDof = 6;
+
+// Returns a world of kNumObjects objects, each attached to the previous one,
+// with kNumFramesPerObject frames each.
+std::vector<intrinsic_proto::world::Object> MakeObjects() {
+  std::vector<intrinsic_proto::world::Object> objects;
+  intrinsic_proto::world::Object& root = objects.emplace_back();
+  root.set_world_id(kWorldId);
+  root.set_id(RootObjectId().value());
+  root.set_name("root");
+  root.set_type(intrinsic_proto::world::ObjectType::ROOT);
+  for (int i = 0; i < kNumObjects; ++i) {
+    const intrinsic_proto::world::Object& parent = objects.back();
+    intrinsic_proto::world::Object object;
+    object.set_world_id(kWorldId);
+    object.set_id(absl::StrCat("object_", i));
+    object.set_name(absl::StrCat("object_", i));
+    object.set_type(intrinsic_proto::world::ObjectType::PHYSICAL_OBJECT);
+    object.mutable_parent()->set_id(parent.id());
+    object.mutable_parent()->set_name(parent.name());
+    *object.mutable_object_component()->mutable_parent_t_this() =
+        ToProto(Pose3d(eigenmath::Quaterniond(eigenmath::AngleAxisd(
+                           0.1, eigenmath::Vector3d::UnitZ())),
+                       eigenmath::Vector3d(0.1, 0.0, 0.0)));
+    for (int j = 0; j < kNumFramesPerObject; ++j) {
+      intrinsic_proto::world::Frame* frame = object.add_frames();
+      frame->set_world_id(kWorldId);
+      frame->set_id(absl::StrCat(object.id(), "_frame_", j));
+      frame->set_name(absl::StrCat("frame_", j));
+      frame->mutable_object()->set_id(object.id());
+      frame->mutable_object()->set_name(object.name());
+      *frame->mutable_parent_t_this() =
+          ToProto(Pose3d(eigenmath::Vector3d(0.0, 0.0, 0.1 * j)));
+    }
+    objects.push_back(std::move(object));
+  }
+  return objects;
+}
+
+// Serves the objects of MakeObjects() and the transforms between them.
+class FakeObjectWorldService
+    : public intrinsic_proto::world::ObjectWorldService::Service {
+ public:
+  FakeObjectWorldService() : objects_(MakeObjects()) {
+    std::vector<WorldObject> world_objects;
+    for (const intrinsic_proto::world::Object& object : objects_) {
+      world_objects.push_back(*WorldObject::Create(object));
+    }
+    absl::StatusOr<TransformTreeSnapshot> snapshot =
+        TransformTreeSnapshot::Create(world_objects);
+    CHECK_OK(snapshot.status());
+    snapshot_ = std::make_unique<TransformTreeSnapshot>(*std::move(snapshot));
+  }
+
+  grpc::Status GetWorld(grpc::ServerContext* context,
+                        const intrinsic_proto::world::GetWorldRequest* request,
+                        intrinsic_proto::world::WorldMetadata* response)
+      override {
+    response->set_id(kWorldId);
+    return grpc::Status::OK;
+  }
+
+  grpc::Status ListObjects(
+      grpc::ServerContext* context,
+      const intrinsic_proto::world::ListObjectsRequest* request,
+      intrinsic_proto::world::ListObjectsResponse* response) override {
+    for (const intrinsic_proto::world::Object& object : objects_) {
+      *response->add_objects() = object;
+    }
+    return grpc::Status::OK;
+  }
+
+  grpc::Status GetTransform(
+      grpc::ServerContext* context,
+      const intrinsic_proto::world::GetTransformRequest* request,
+      intrinsic_proto::world::GetTransformResponse* response) override {
+    absl::StatusOr<Pose3d> a_t_b = snapshot_->GetTransform(
+        ObjectWorldResourceId(request->node_a().id()),
+        ObjectWorldResourceId(request->node_b().id()));
+    if (!a_t_b.ok()) {
+      return grpc::Status(grpc::StatusCode::NOT_FOUND,
+                          std::string(a_t_b.status().message()));
+    }
+    *response->mutable_a_t_b() = ToProto(*a_t_b);
+    return grpc::Status::OK;
+  }
+
+  grpc::Status UpdateObjectJoints(
+      grpc::ServerContext* context,
+      const intrinsic_proto::world::UpdateObjectJointsRequest* request,
+      intrinsic_proto::world::Object* response) override {
+    response->set_id(request->object().id());
+    return grpc::Status::OK;
+  }
+
+  grpc::Status UpdateWorldResources(
+      grpc::ServerContext* context,
+      const intrinsic_proto::world::UpdateWorldResourcesRequest* request,
+      intrinsic_proto::world::UpdateWorldResourcesResponse* response) override {
+    return grpc::Status::OK;
+  }
+
+ private:
+  const std::vector<intrinsic_proto::world::Object> objects_;
+  std::unique_ptr<TransformTreeSnapshot> snapshot_;
+};
+
+class FakeWorldServer {
+ public:
+  FakeWorldServer() {
+    grpc::ServerBuilder builder;
+    builder.RegisterService(&service_);
+    server_ = builder.BuildAndStart();
+    CHECK(server_ != nullptr);
+    stub_ = intrinsic_proto::world::ObjectWorldService::NewStub(
+        server_->InProcessChannel(grpc::ChannelArguments()));
+  }
+  ~FakeWorldServer() { server_->Shutdown(); }
+
+  ObjectWorldClient MakeClient() { return ObjectWorldClient(kWorldId, stub_); }
+
+ private:
+  FakeObjectWorldService service_;
+  std::unique_ptr<grpc::Server> server_;
+  std::shared_ptr<intrinsic_proto::world::ObjectWorldService::StubInterface>
+      stub_;
+};
+
+// Returns all frames of the world, in the order of the objects.
+std::vector<Frame> ListFrames(const ObjectWorldClient& client) {
+  absl::StatusOr<std::vector<WorldObject>> objects = client.ListObjects();
+  CHECK_OK(objects.status());
+  std::vector<Frame> frames;
+  for (const WorldObject& object : *objects) {
+    for (Frame& frame : object.Frames()) {
+      frames.push_back(std::move(frame));
+    }
+  }
+  return frames;
+}
+
+// Resolves kNumTransforms transforms between frames spread over the chain.
+void GetTransforms(const ObjectWorldClient& client,
+                   const std::vector<Frame>& frames) {
+  for (int i = 0; i < kNumTransforms; ++i) {
+    const Frame& a = frames[i % frames.size()];
+    const Frame& b = frames[frames.size() - 1 - (i * 7) % frames.size()];
+    absl::StatusOr<Pose3d> a_t_b = client.GetTransform(a, b);
+    CHECK_OK(a_t_b.status());
+    benchmark::DoNotOptimize(a_t_b);
+  }
+}
+
+void BM_GetTransformRpc(benchmark::State& state) {
+  FakeWorldServer server;
+  ObjectWorldClient client = server.MakeClient();
+  const std::vector<Frame> frames = ListFrames(client);
+  for (auto _ : state) {
+    GetTransforms(client, frames);
+  }
+  state.SetItemsProcessed(state.iterations() * kNumTransforms);
+}
+BENCHMARK(BM_GetTransformRpc);
+
+void BM_GetTransformCached(benchmark::State& state) {
+  FakeWorldServer server;
+  ObjectWorldClient client = server.MakeClient();
+  client.EnableTransformCache();
+  const std::vector<Frame> frames = ListFrames(client);
+  for (auto _ : state) {
+    GetTransforms(client, frames);
+  }
+  state.SetItemsProcessed(state.iterations() * kNumTransforms);
+}
+BENCHMARK(BM_GetTransformCached);
+
+// Like BM_GetTransformCached, but the world changes before each batch of
+// transforms, so that each iteration rebuilds the snapshot.
+void BM_GetTransformCachedRebuild(benchmark::State& state) {
+  FakeWorldServer server;
+  ObjectWorldClient client = server.MakeClient();
+  client.EnableTransformCache();
+  const std::vector<Frame> frames = ListFrames(client);
+  for (auto _ : state) {
+    client.InvalidateTransformCache();
+    GetTransforms(client, frames);
+  }
+  state.SetItemsProcessed(state.iterations() * kNumTransforms);
+}
+BENCHMARK(BM_GetTransformCachedRebuild);
+
+std::vector<KinematicObject> MakeRobots() {
+  std::vector<KinematicObject> robots;
+  for (int i = 0; i < kNumRobots; ++i) {
+    intrinsic_proto::world::Object proto;
+    proto.set_world_id(kWorldId);
+    proto.set_id(absl::StrCat("robot_", i));
+    proto.set_name(absl::StrCat("robot_", i));
+    proto.set_type(intrinsic_proto::world::ObjectType::KINEMATIC_OBJECT);
+    *proto.mutable_object_component()->mutable_parent_t_this() =
+        ToProto(Pose3d());
+    for (int j = 0; j < kNumDof; ++j) {
+      proto.mutable_kinematic_object_component()->add_joint_positions(0.0);
+    }
+    absl::StatusOr<KinematicObject> robot = KinematicObject::Create(proto);
+    CHECK_OK(robot.status());
+    robots.push_back(*std::move(robot));
+  }
+  return robots;
+}
+
+void BM_UpdateJointPositionsRpc(benchmark::State& state) {
+  FakeWorldServer server;
+  ObjectWorldClient client = server.MakeClient();
+  const std::vector<KinematicObject> robots = MakeRobots();
+  eigenmath::VectorXd joint_positions = eigenmath::VectorXd::Zero(kNumDof);
+  for (auto _ : state) {
+    joint_positions.array() += 0.001;
+    for (const KinematicObject& robot : robots) {
+      CHECK_OK(client.UpdateJointPositions(robot, joint_positions));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kNumRobots);
+}
+BENCHMARK(BM_UpdateJointPositionsRpc);
+
+// Waits for the updates of each tick, so that each tick sends one batch.
+void BM_UpdateJointPositionsCoalescedBarrier(benchmark::State& state) {
+  FakeWorldServer server;
+  ObjectWorldClient client = server.MakeClient();
+  CoalescingWorldUpdater updater(&client, {});
+  const std::vector<KinematicObject> robots = MakeRobots();
+  eigenmath::VectorXd joint_positions = eigenmath::VectorXd::Zero(kNumDof);
+  for (auto _ : state) {
+    joint_positions.array() += 0.001;
+    for (const KinematicObject& robot : robots) {
+      updater.UpdateJointPositions(robot, joint_positions);
+    }
+    CHECK_OK(updater.Barrier());
+  }
+  state.SetItemsProcessed(state.iterations() * kNumRobots);
+}
+BENCHMARK(BM_UpdateJointPositionsCoalescedBarrier);
+
+// Only waits once at the end, so that the updates of many ticks coalesce.
+void BM_UpdateJointPositionsWriteBehind(benchmark::State& state) {
+  FakeWorldServer server;
+  ObjectWorldClient client = server.MakeClient();
+  CoalescingWorldUpdater updater(&client, {});
+  const std::vector<KinematicObject> robots = MakeRobots();
+  eigenmath::VectorXd joint_positions = eigenmath::VectorXd::Zero(kNumDof);
+  for (auto _ : state) {
+    joint_positions.array() += 0.001;
+    for (const KinematicObject& robot : robots) {
+      updater.UpdateJointPositions(robot, joint_positions);
+    }
+  }
+  CHECK_OK(updater.Barrier());
+  const CoalescingWorldUpdater::Stats stats = updater.stats();
+  state.counters["batches"] = stats.batches_sent;
+  state.SetItemsProcessed(state.iterations() * kNumRobots);
+}
+BENCHMARK(BM_UpdateJointPositionsWriteBehind);
+
+}  // namespace
+}  // namespace world
+}  // namespace intrinsic
@@ -0,0 +1,144 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/world/objects/transform_tree_snapshot.h"
+
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
+#include "intrinsic/math/pose3.h"
+#include "intrinsic/world/objects/frame.h"
+#include "intrinsic/world/objects/object_world_ids.h"
+#include "intrinsic/world/objects/world_object.h"
+
+namespace intrinsic {
+namespace world {
+
+namespace {
+
+// A node as it was listed, before sorting.
+struct ListedNode {
+  ObjectWorldResourceId id;
+  // Unset for the root object.
+  std::optional<ObjectWorldResourceId> parent_id;
+  Pose3d parent_t_this;
+};
+
+}  // namespace
+
+absl::StatusOr<TransformTreeSnapshot> TransformTreeSnapshot::Create(
+    absl::Span<const WorldObject> objects) {
+  std::vector<ListedNode> listed_nodes;
+  listed_nodes.reserve(objects.size() + 1);
+  bool has_root = false;
+  for (const WorldObject& object : objects) {
+    if (object.Id() == RootObjectId()) {
+      has_root = true;
+      listed_nodes.push_back({.id = object.Id(), .parent_t_this = Pose3d()});
+    } else {
+      listed_nodes.push_back({.id = object.Id(),
+                              .parent_id = object.ParentId(),
+                              .parent_t_this = object.ParentTThis()});
+    }
+    for (const Frame& frame : object.Frames()) {
+      listed_nodes.push_back(
+          {.id = frame.Id(),
+           .parent_id = frame.ParentFrameId().value_or(frame.ObjectId()),
+           .parent_t_this = frame.ParentTThis()});
+    }
+  }
+  if (!has_root) {
+    listed_nodes.push_back({.id = RootObjectId(), .parent_t_this = Pose3d()});
+  }
+
+  absl::flat_hash_map<ObjectWorldResourceId, int> listed_index;
+  listed_index.reserve(listed_nodes.size());
+  for (int i = 0; i < listed_nodes.size(); ++i) {
+    if (!listed_index.try_emplace(listed_nodes[i].id, i).second) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Transform node \"", listed_nodes[i].id.value(),
+                       "\" is listed more than once."));
+    }
+  }
+  std::vector<std::vector<int>> listed_children(listed_nodes.size());
+  for (int i = 0; i < listed_nodes.size(); ++i) {
+    if (!listed_nodes[i].parent_id.has_value()) {
+      continue;
+    }
+    auto parent_it = listed_index.find(*listed_nodes[i].parent_id);
+    if (parent_it == listed_index.end()) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "The parent \"", listed_nodes[i].parent_id->value(),
+          "\" of transform node \"", listed_nodes[i].id.value(),
+          "\" is not listed."));
+    }
+    listed_children[parent_it->second].push_back(i);
+  }
+
+  // Breadth-first from the root, so that parents precede their children and
+  // each root-relative pose is a single composition.
+  absl::flat_hash_map<ObjectWorldResourceId, int> node_index;
+  node_index.reserve(listed_nodes.size());
+  std::vector<Pose3d> root_t_node;
+  root_t_node.reserve(listed_nodes.size());
+  std::vector<int> listed_order = {listed_index.at(RootObjectId())};
+  listed_order.reserve(listed_nodes.size());
+  node_index.emplace(RootObjectId(), 0);
+  root_t_node.push_back(Pose3d());
+  for (int node = 0; node < listed_order.size(); ++node) {
+    for (int child : listed_children[listed_order[node]]) {
+      node_index.emplace(listed_nodes[child].id, listed_order.size());
+      listed_order.push_back(child);
+      root_t_node.push_back(root_t_node[node] *
+                            listed_nodes[child].parent_t_this);
+    }
+  }
+  if (listed_order.size() != listed_nodes.size()) {
+    return absl::InvalidArgumentError(
+        absl::StrCat(listed_nodes.size() - listed_order.size(),
+                     " transform node(s) are not connected to the root."));
+  }
+  return TransformTreeSnapshot(std::move(node_index), std::move(root_t_node));
+}
+
+TransformTreeSnapshot::TransformTreeSnapshot(
+    absl::flat_hash_map<ObjectWorldResourceId, int> node_index,
+    std::vector<Pose3d> root_t_node)
+    : node_index_(std::move(node_index)),
+      root_t_node_(std::move(root_t_node)) {}
+
+bool TransformTreeSnapshot::Contains(const ObjectWorldResourceId& id) const {
+  return node_index_.contains(id);
+}
+
+absl::StatusOr<Pose3d> TransformTreeSnapshot::GetTransform(
+    const ObjectWorldResourceId& a_id,
+    const ObjectWorldResourceId& b_id) const {
+  absl::StatusOr<int> a = NodeIndex(a_id);
+  if (!a.ok()) {
+    return a.status();
+  }
+  absl::StatusOr<int> b = NodeIndex(b_id);
+  if (!b.ok()) {
+    return b.status();
+  }
+  return root_t_node_[*a].inverse() * root_t_node_[*b];
+}
+
+absl::StatusOr<int> TransformTreeSnapshot::NodeIndex(
+    const ObjectWorldResourceId& id) const {
+  auto it = node_index_.find(id);
+  if (it == node_index_.end()) {
+    return absl::NotFoundError(absl::StrCat(
+        "Transform node \"", id.value(), "\" is not in the snapshot."));
+  }
+  return it->second;
+}
+
+}  // namespace world
+}  // namespace intrinsic
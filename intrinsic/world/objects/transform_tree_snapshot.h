@@ -0,0 +1,68 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#ifndef INTRINSIC_WORLD_OBJECTS_TRANSFORM_TREE_SNAPSHOT_H_
+#define INTRINSIC_WORLD_OBJECTS_TRANSFORM_TREE_SNAPSHOT_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "intrinsic/math/pose3.h"
+#include "intrinsic/world/objects/object_world_ids.h"
+#include "intrinsic/world/objects/world_object.h"
+
+namespace intrinsic {
+namespace world {
+
+// An immutable local copy of the transform tree of a world, i.e., of the poses
+// of all objects and frames.
+//
+// The tree is flattened into arrays indexed by node, and the pose of every node
+// in the space of the root object is computed once on creation. Resolving a
+// transform between two nodes is thus a lookup and a single pose composition,
+// independent of the depth of the tree.
+//
+// Relies on TransformNode::ParentTThis() being the pose in the space of the
+// parent object's origin or the parent frame, as computed by the world service
+// for the current joint positions.
+class TransformTreeSnapshot {
+ public:
+  // Creates a snapshot from `objects` and their frames, which must contain
+  // every object of the world except, optionally, the root object (e.g., the
+  // result of ObjectWorldClient::ListObjects()). Returns an error if a node
+  // appears twice or is not connected to the root object.
+  static absl::StatusOr<TransformTreeSnapshot> Create(
+      absl::Span<const WorldObject> objects);
+
+  // Returns true if the snapshot contains the object or frame with the given
+  // id.
+  bool Contains(const ObjectWorldResourceId& id) const;
+
+  // Returns the transform 'a_t_b', i.e., the pose of the node with id 'b_id' in
+  // the space of the node with id 'a_id'. Returns kNotFound if the snapshot
+  // contains no such node.
+  absl::StatusOr<Pose3d> GetTransform(const ObjectWorldResourceId& a_id,
+                                      const ObjectWorldResourceId& b_id) const;
+
+  // Returns the number of objects and frames in the snapshot.
+  size_t size() const { return root_t_node_.size(); }
+
+ private:
+  TransformTreeSnapshot(
+      absl::flat_hash_map<ObjectWorldResourceId, int> node_index,
+      std::vector<Pose3d> root_t_node);
+
+  absl::StatusOr<int> NodeIndex(const ObjectWorldResourceId& id) const;
+
+  absl::flat_hash_map<ObjectWorldResourceId, int> node_index_;
+  // The pose of each node in the space of the root object. Parents precede
+  // their children.
+  std::vector<Pose3d> root_t_node_;
+};
+
+}  // namespace world
+}  // namespace intrinsic
+
+#endif  // INTRINSIC_WORLD_OBJECTS_TRANSFORM_TREE_SNAPSHOT_H_
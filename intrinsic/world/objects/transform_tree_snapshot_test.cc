@@ -0,0 +1,551 @@
+// Copyright 2023 Intrinsic Innovation LLC
+
+#include "intrinsic/world/objects/transform_tree_snapshot.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <memory>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "grpcpp/server.h"
+#include "grpcpp/server_builder.h"
+#include "grpcpp/server_context.h"
+#include "grpcpp/support/channel_arguments.h"
+#include "grpcpp/support/status.h"
+#include "intrinsic/eigenmath/types.h"
+#include "intrinsic/math/pose3.h"
+#include "intrinsic/math/proto_conversion.h"
+#include "intrinsic/util/testing/gtest_wrapper.h"
+#include "intrinsic/world/objects/object_entity_filter.h"
+#include "intrinsic/world/objects/object_world_client.h"
+#include "intrinsic/world/objects/object_world_ids.h"
+#include "intrinsic/world/objects/world_object.h"
+#include "intrinsic/world/proto/object_world_service.grpc.pb.h"
+#include "intrinsic/world/proto/object_world_service.pb.h"
+#include "intrinsic/world/proto/object_world_updates.pb.h"
+
+namespace intrinsic {
+namespace world {
+namespace {
+
+using ::intrinsic::testing::StatusIs;
+using ::testing::HasSubstr;
+
+constexpr char kWorldId[] = "world";
+
+const Pose3d kRootTA(eigenmath::Vector3d(1.0, 0.0, 0.0));
+const Pose3d kATB(eigenmath::Quaterniond(eigenmath::AngleAxisd(
+                      M_PI / 2, eigenmath::Vector3d::UnitZ())),
+                  eigenmath::Vector3d(0.0, 1.0, 0.0));
+const Pose3d kBTFrame(eigenmath::Vector3d(0.0, 0.0, 0.5));
+const Pose3d kFrameTChildFrame(eigenmath::Vector3d(0.5, 0.0, 0.0));
+
+intrinsic_proto::world::Object MakeRootObject() {
+  intrinsic_proto::world::Object object;
+  object.set_world_id(kWorldId);
+  object.set_id(RootObjectId().value());
+  object.set_name("root");
+  object.set_type(intrinsic_proto::world::ObjectType::ROOT);
+  return object;
+}
+
+intrinsic_proto::world::Object MakeObject(const std::string& id,
+                                          const std::string& parent_id,
+                                          const Pose3d& parent_t_this) {
+  intrinsic_proto::world::Object object;
+  object.set_world_id(kWorldId);
+  object.set_id(id);
+  object.set_name(id);
+  object.set_type(intrinsic_proto::world::ObjectType::PHYSICAL_OBJECT);
+  object.mutable_parent()->set_id(parent_id);
+  *object.mutable_object_component()->mutable_parent_t_this() =
+      ToProto(parent_t_this);
+  return object;
+}
+
+// Adds a frame to `object`, which is attached to the frame `parent_frame_id`
+// if set, and to the object otherwise.
+void AddFrame(intrinsic_proto::world::Object& object, const std::string& id,
+              std::optional<std::string> parent_frame_id,
+              const Pose3d& parent_t_this) {
+  intrinsic_proto::world::Frame* frame = object.add_frames();
+  frame->set_world_id(kWorldId);
+  frame->set_id(id);
+  frame->set_name(id);
+  frame->mutable_object()->set_id(object.id());
+  frame->mutable_object()->set_name(object.name());
+  if (parent_frame_id.has_value()) {
+    frame->mutable_parent_frame()->set_id(*parent_frame_id);
+    frame->mutable_parent_frame()->set_name(*parent_frame_id);
+  }
+  *frame->mutable_parent_t_this() = ToProto(parent_t_this);
+}
+
+// Returns the objects "a" and "b", where "b" is attached to "a" and has a
+// frame "frame" with a child frame "child_frame". Does not include the root
+// object.
+std::vector<intrinsic_proto::world::Object> MakeObjects() {
+  std::vector<intrinsic_proto::world::Object> objects;
+  objects.push_back(MakeObject("a", RootObjectId().value(), kRootTA));
+  intrinsic_proto::world::Object& b =
+      objects.emplace_back(MakeObject("b", "a", kATB));
+  AddFrame(b, "frame", std::nullopt, kBTFrame);
+  AddFrame(b, "child_frame", "frame", kFrameTChildFrame);
+  return objects;
+}
+
+std::vector<WorldObject> ToWorldObjects(
+    const std::vector<intrinsic_proto::world::Object>& protos) {
+  std::vector<WorldObject> objects;
+  for (const intrinsic_proto::world::Object& proto : protos) {
+    absl::StatusOr<WorldObject> object = WorldObject::Create(proto);
+    CHECK_OK(object.status());
+    objects.push_back(*std::move(object));
+  }
+  return objects;
+}
+
+WorldObject ToWorldObject(const intrinsic_proto::world::Object& proto) {
+  return ToWorldObjects({proto}).front();
+}
+
+ObjectWorldResourceId Id(const std::string& id) {
+  return ObjectWorldResourceId(id);
+}
+
+TEST(TransformTreeSnapshotTest, ResolvesTransformsBetweenAllNodes) {
+  ASSERT_OK_AND_ASSIGN(const TransformTreeSnapshot snapshot,
+                       TransformTreeSnapshot::Create(
+                           ToWorldObjects(MakeObjects())));
+
+  // The root object is added if it is not listed.
+  EXPECT_EQ(snapshot.size(), 5);
+  EXPECT_TRUE(snapshot.Contains(RootObjectId()));
+  EXPECT_TRUE(snapshot.Contains(Id("child_frame")));
+  EXPECT_FALSE(snapshot.Contains(Id("unknown")));
+
+  const Pose3d root_t_child_frame = kRootTA * kATB * kBTFrame *
+                                    kFrameTChildFrame;
+  ASSERT_OK_AND_ASSIGN(Pose3d pose,
+                       snapshot.GetTransform(RootObjectId(),
+                                             Id("child_frame")));
+  EXPECT_TRUE(pose.isApprox(root_t_child_frame));
+  ASSERT_OK_AND_ASSIGN(pose,
+                       snapshot.GetTransform(Id("child_frame"), Id("a")));
+  EXPECT_TRUE(pose.isApprox((kATB * kBTFrame * kFrameTChildFrame).inverse()));
+  ASSERT_OK_AND_ASSIGN(pose, snapshot.GetTransform(Id("b"), Id("b")));
+  EXPECT_TRUE(pose.isApprox(Pose3d()));
+}
+
+TEST(TransformTreeSnapshotTest, AcceptsTheRootObjectInAnyOrder) {
+  // Children may also be listed before their parents.
+  std::vector<intrinsic_proto::world::Object> objects = MakeObjects();
+  std::swap(objects[0], objects[1]);
+  objects.push_back(MakeRootObject());
+
+  ASSERT_OK_AND_ASSIGN(
+      const TransformTreeSnapshot snapshot,
+      TransformTreeSnapshot::Create(ToWorldObjects(objects)));
+
+  EXPECT_EQ(snapshot.size(), 5);
+  ASSERT_OK_AND_ASSIGN(const Pose3d root_t_b,
+                       snapshot.GetTransform(RootObjectId(), Id("b")));
+  EXPECT_TRUE(root_t_b.isApprox(kRootTA * kATB));
+}
+
+TEST(TransformTreeSnapshotTest, RejectsDuplicateNodes) {
+  std::vector<intrinsic_proto::world::Object> objects = MakeObjects();
+  objects.push_back(objects.front());
+
+  EXPECT_THAT(TransformTreeSnapshot::Create(ToWorldObjects(objects)),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("\"a\" is listed more than once")));
+}
+
+TEST(TransformTreeSnapshotTest, RejectsFramesWithTheIdOfAnObject) {
+  std::vector<intrinsic_proto::world::Object> objects = MakeObjects();
+  AddFrame(objects[1], "a", std::nullopt, Pose3d());
+
+  EXPECT_THAT(TransformTreeSnapshot::Create(ToWorldObjects(objects)),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("\"a\" is listed more than once")));
+}
+
+TEST(TransformTreeSnapshotTest, RejectsUnlistedParents) {
+  std::vector<intrinsic_proto::world::Object> objects = MakeObjects();
+  objects.push_back(MakeObject("c", "unknown", Pose3d()));
+
+  EXPECT_THAT(TransformTreeSnapshot::Create(ToWorldObjects(objects)),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("The parent \"unknown\" of transform node "
+                                 "\"c\" is not listed")));
+}
+
+TEST(TransformTreeSnapshotTest, RejectsUnlistedParentFrames) {
+  std::vector<intrinsic_proto::world::Object> objects = MakeObjects();
+  AddFrame(objects[0], "orphan", "unknown_frame", Pose3d());
+
+  EXPECT_THAT(TransformTreeSnapshot::Create(ToWorldObjects(objects)),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("\"unknown_frame\"")));
+}
+
+TEST(TransformTreeSnapshotTest, RejectsNodesNotConnectedToTheRoot) {
+  // "c" and "d" are each other's parent.
+  std::vector<intrinsic_proto::world::Object> objects = MakeObjects();
+  objects.push_back(MakeObject("c", "d", Pose3d()));
+  objects.push_back(MakeObject("d", "c", Pose3d()));
+  AddFrame(objects.back(), "d_frame", std::nullopt, Pose3d());
+
+  EXPECT_THAT(TransformTreeSnapshot::Create(ToWorldObjects(objects)),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("3 transform node(s) are not connected")));
+}
+
+TEST(TransformTreeSnapshotTest, GetTransformRejectsUnknownNodes) {
+  ASSERT_OK_AND_ASSIGN(const TransformTreeSnapshot snapshot,
+                       TransformTreeSnapshot::Create(
+                           ToWorldObjects(MakeObjects())));
+
+  EXPECT_THAT(snapshot.GetTransform(Id("a"), Id("unknown")),
+              StatusIs(absl::StatusCode::kNotFound, HasSubstr("\"unknown\"")));
+  EXPECT_THAT(snapshot.GetTransform(Id("unknown"), Id("a")),
+              StatusIs(absl::StatusCode::kNotFound));
+}
+
+// Serves a mutable world of objects and counts the calls that read it.
+// UpdateTransform (also within UpdateWorldResources) only supports setting the
+// pose of a node relative to its parent, and ReparentObject keeps the pose of
+// the object relative to its parent.
+class FakeObjectWorldService
+    : public intrinsic_proto::world::ObjectWorldService::Service {
+ public:
+  FakeObjectWorldService() : objects_(MakeObjects()) {
+    objects_.insert(objects_.begin(), MakeRootObject());
+  }
+
+  grpc::Status GetWorld(grpc::ServerContext* context,
+                        const intrinsic_proto::world::GetWorldRequest* request,
+                        intrinsic_proto::world::WorldMetadata* response)
+      override {
+    absl::MutexLock lock(&mutex_);
+    response->set_id(kWorldId);
+    response->mutable_last_update()->set_seconds(num_updates_);
+    return grpc::Status::OK;
+  }
+
+  grpc::Status ListObjects(
+      grpc::ServerContext* context,
+      const intrinsic_proto::world::ListObjectsRequest* request,
+      intrinsic_proto::world::ListObjectsResponse* response) override {
+    absl::MutexLock lock(&mutex_);
+    ++num_list_objects_calls_;
+    for (const intrinsic_proto::world::Object& object : objects_) {
+      *response->add_objects() = object;
+    }
+    return grpc::Status::OK;
+  }
+
+  grpc::Status GetTransform(
+      grpc::ServerContext* context,
+      const intrinsic_proto::world::GetTransformRequest* request,
+      intrinsic_proto::world::GetTransformResponse* response) override {
+    absl::MutexLock lock(&mutex_);
+    ++num_get_transform_calls_;
+    absl::StatusOr<TransformTreeSnapshot> snapshot =
+        TransformTreeSnapshot::Create(ToWorldObjects(objects_));
+    CHECK_OK(snapshot.status());
+    absl::StatusOr<Pose3d> a_t_b =
+        snapshot->GetTransform(Id(request->node_a().id()),
+                               Id(request->node_b().id()));
+    if (!a_t_b.ok()) {
+      return grpc::Status(grpc::StatusCode::NOT_FOUND,
+                          std::string(a_t_b.status().message()));
+    }
+    *response->mutable_a_t_b() = ToProto(*a_t_b);
+    return grpc::Status::OK;
+  }
+
+  grpc::Status UpdateTransform(
+      grpc::ServerContext* context,
+      const intrinsic_proto::world::UpdateTransformRequest* request,
+      intrinsic_proto::world::UpdateTransformResponse* response) override {
+    absl::MutexLock lock(&mutex_);
+    return ApplyUpdateTransform(*request);
+  }
+
+  grpc::Status UpdateWorldResources(
+      grpc::ServerContext* context,
+      const intrinsic_proto::world::UpdateWorldResourcesRequest* request,
+      intrinsic_proto::world::UpdateWorldResourcesResponse* response) override {
+    absl::MutexLock lock(&mutex_);
+    for (const intrinsic_proto::world::ObjectWorldUpdate& update :
+         request->world_updates().updates()) {
+      if (!update.has_update_transform()) {
+        return grpc::Status(grpc::StatusCode::UNIMPLEMENTED,
+                            "Only transform updates are supported.");
+      }
+      if (grpc::Status status = ApplyUpdateTransform(update.update_transform());
+          !status.ok()) {
+        return status;
+      }
+    }
+    return grpc::Status::OK;
+  }
+
+  grpc::Status ReparentObject(
+      grpc::ServerContext* context,
+      const intrinsic_proto::world::ReparentObjectRequest* request,
+      intrinsic_proto::world::Object* response) override {
+    absl::MutexLock lock(&mutex_);
+    intrinsic_proto::world::Object* object = FindObject(request->object().id());
+    if (object == nullptr) {
+      return grpc::Status(grpc::StatusCode::NOT_FOUND, "Unknown object.");
+    }
+    object->mutable_parent()->set_id(request->new_parent().reference().id());
+    ++num_updates_;
+    return grpc::Status::OK;
+  }
+
+  // Adds `object` to the world as if another client had created it.
+  void AddObject(const intrinsic_proto::world::Object& object) {
+    absl::MutexLock lock(&mutex_);
+    objects_.push_back(object);
+    ++num_updates_;
+  }
+
+  int num_list_objects_calls() const {
+    absl::MutexLock lock(&mutex_);
+    return num_list_objects_calls_;
+  }
+
+  int num_get_transform_calls() const {
+    absl::MutexLock lock(&mutex_);
+    return num_get_transform_calls_;
+  }
+
+ private:
+  intrinsic_proto::world::Object* FindObject(const std::string& id)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    for (intrinsic_proto::world::Object& object : objects_) {
+      if (object.id() == id) {
+        return &object;
+      }
+    }
+    return nullptr;
+  }
+
+  grpc::Status ApplyUpdateTransform(
+      const intrinsic_proto::world::UpdateTransformRequest& request)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    const std::string& node_id = request.has_node_to_update()
+                                     ? request.node_to_update().id()
+                                     : request.node_b().id();
+    if (node_id != request.node_b().id()) {
+      return grpc::Status(grpc::StatusCode::UNIMPLEMENTED,
+                          "Only node_b can be updated.");
+    }
+    for (intrinsic_proto::world::Object& object : objects_) {
+      if (object.id() == node_id &&
+          object.parent().id() == request.node_a().id()) {
+        *object.mutable_object_component()->mutable_parent_t_this() =
+            request.a_t_b();
+        ++num_updates_;
+        return grpc::Status::OK;
+      }
+      for (intrinsic_proto::world::Frame& frame : *object.mutable_frames()) {
+        const std::string& parent_id = frame.has_parent_frame()
+                                           ? frame.parent_frame().id()
+                                           : frame.object().id();
+        if (frame.id() == node_id && parent_id == request.node_a().id()) {
+          *frame.mutable_parent_t_this() = request.a_t_b();
+          ++num_updates_;
+          return grpc::Status::OK;
+        }
+      }
+    }
+    return grpc::Status(grpc::StatusCode::UNIMPLEMENTED,
+                        "node_a must be the parent of node_b.");
+  }
+
+  mutable absl::Mutex mutex_;
+  std::vector<intrinsic_proto::world::Object> objects_ ABSL_GUARDED_BY(mutex_);
+  int num_updates_ ABSL_GUARDED_BY(mutex_) = 0;
+  int num_list_objects_calls_ ABSL_GUARDED_BY(mutex_) = 0;
+  int num_get_transform_calls_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
+class TransformCacheTest : public ::testing::Test {
+ protected:
+  TransformCacheTest() {
+    grpc::ServerBuilder builder;
+    builder.RegisterService(&service_);
+    server_ = builder.BuildAndStart();
+    stub_ = intrinsic_proto::world::ObjectWorldService::NewStub(
+        server_->InProcessChannel(grpc::ChannelArguments()));
+    client_ = std::make_unique<ObjectWorldClient>(kWorldId, stub_);
+  }
+  ~TransformCacheTest() override { server_->Shutdown(); }
+
+  FakeObjectWorldService service_;
+  std::unique_ptr<grpc::Server> server_;
+  std::shared_ptr<intrinsic_proto::world::ObjectWorldService::StubInterface>
+      stub_;
+  std::unique_ptr<ObjectWorldClient> client_;
+
+  const WorldObject root_ = ToWorldObject(MakeRootObject());
+  const WorldObject a_ = ToWorldObject(MakeObjects()[0]);
+  const WorldObject b_ = ToWorldObject(MakeObjects()[1]);
+  const Frame child_frame_ = b_.Frames()[1];
+};
+
+TEST_F(TransformCacheTest, ResolvesTransformsLocally) {
+  client_->EnableTransformCache();
+
+  ASSERT_OK_AND_ASSIGN(Pose3d pose, client_->GetTransform(root_, b_));
+  EXPECT_TRUE(pose.isApprox(kRootTA * kATB));
+  ASSERT_OK_AND_ASSIGN(pose, client_->GetTransform(a_, child_frame_));
+  EXPECT_TRUE(pose.isApprox(kATB * kBTFrame * kFrameTChildFrame));
+
+  EXPECT_EQ(service_.num_list_objects_calls(), 1);
+  EXPECT_EQ(service_.num_get_transform_calls(), 0);
+}
+
+TEST_F(TransformCacheTest, CallsTheServiceIfDisabled) {
+  ASSERT_OK(client_->GetTransform(root_, b_));
+  EXPECT_THAT(client_->GetTransformTreeSnapshot(),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+
+  client_->EnableTransformCache();
+  ASSERT_OK(client_->GetTransform(root_, b_));
+  client_->DisableTransformCache();
+  ASSERT_OK(client_->GetTransform(root_, b_));
+
+  EXPECT_EQ(service_.num_list_objects_calls(), 1);
+  EXPECT_EQ(service_.num_get_transform_calls(), 2);
+}
+
+TEST_F(TransformCacheTest, CallsTheServiceForFiltersAndUnknownNodes) {
+  client_->EnableTransformCache();
+  ASSERT_OK(client_->GetTransformTreeSnapshot());
+  const ObjectEntityFilter filter = ObjectEntityFilter().IncludeBaseEntity();
+  ASSERT_OK(client_->GetTransform(root_, filter, b_, filter));
+
+  // Created by another client after the snapshot was built.
+  const intrinsic_proto::world::Object c_proto =
+      MakeObject("c", "b", Pose3d(eigenmath::Vector3d(0.0, 0.0, 1.0)));
+  service_.AddObject(c_proto);
+  ASSERT_OK_AND_ASSIGN(const Pose3d b_t_c,
+                       client_->GetTransform(b_, ToWorldObject(c_proto)));
+
+  EXPECT_TRUE(b_t_c.isApprox(Pose3d(eigenmath::Vector3d(0.0, 0.0, 1.0))));
+  EXPECT_EQ(service_.num_list_objects_calls(), 1);
+  EXPECT_EQ(service_.num_get_transform_calls(), 2);
+}
+
+TEST_F(TransformCacheTest, UpdateTransformInvalidatesTheCache) {
+  client_->EnableTransformCache();
+  ASSERT_OK(client_->GetTransform(root_, child_frame_));
+
+  const Pose3d new_b_t_frame(eigenmath::Vector3d(0.0, 0.0, 2.0));
+  ASSERT_OK(client_->UpdateTransform(b_, b_.Frames()[0], new_b_t_frame));
+
+  ASSERT_OK_AND_ASSIGN(const Pose3d root_t_child_frame,
+                       client_->GetTransform(root_, child_frame_));
+  EXPECT_TRUE(root_t_child_frame.isApprox(kRootTA * kATB * new_b_t_frame *
+                                          kFrameTChildFrame));
+  EXPECT_EQ(service_.num_list_objects_calls(), 2);
+}
+
+TEST_F(TransformCacheTest, BatchUpdateInvalidatesTheCache) {
+  client_->EnableTransformCache();
+  ASSERT_OK(client_->GetTransform(root_, b_));
+
+  const Pose3d new_root_t_a(eigenmath::Vector3d(-1.0, 0.0, 0.0));
+  const Pose3d new_a_t_b(eigenmath::Vector3d(0.0, -1.0, 0.0));
+  intrinsic_proto::world::ObjectWorldUpdates updates;
+  for (const auto& [parent, child, parent_t_child] :
+       {std::make_tuple(root_, a_, new_root_t_a),
+        std::make_tuple(a_, b_, new_a_t_b)}) {
+    intrinsic_proto::world::UpdateTransformRequest* update =
+        updates.add_updates()->mutable_update_transform();
+    update->set_world_id(kWorldId);
+    update->mutable_node_a()->set_id(parent.Id().value());
+    update->mutable_node_b()->set_id(child.Id().value());
+    *update->mutable_a_t_b() = ToProto(parent_t_child);
+  }
+  ASSERT_OK(client_->BatchUpdate(updates));
+
+  ASSERT_OK_AND_ASSIGN(const Pose3d root_t_b,
+                       client_->GetTransform(root_, b_));
+  EXPECT_TRUE(root_t_b.isApprox(new_root_t_a * new_a_t_b));
+  EXPECT_EQ(service_.num_list_objects_calls(), 2);
+}
+
+TEST_F(TransformCacheTest, ReparentObjectInvalidatesTheCache) {
+  client_->EnableTransformCache();
+  ASSERT_OK(client_->GetTransform(root_, b_));
+
+  ASSERT_OK(client_->ReparentObject(b_, root_));
+
+  ASSERT_OK_AND_ASSIGN(const Pose3d root_t_b,
+                       client_->GetTransform(root_, b_));
+  EXPECT_TRUE(root_t_b.isApprox(kATB));
+  EXPECT_EQ(service_.num_list_objects_calls(), 2);
+}
+
+TEST_F(TransformCacheTest, FailedUpdatesKeepTheCache) {
+  client_->EnableTransformCache();
+  ASSERT_OK(client_->GetTransform(root_, b_));
+
+  // The fake service only updates nodes relative to their parent.
+  EXPECT_THAT(client_->UpdateTransform(root_, b_, Pose3d()),
+              StatusIs(absl::StatusCode::kUnimplemented));
+
+  ASSERT_OK(client_->GetTransform(root_, b_));
+  EXPECT_EQ(service_.num_list_objects_calls(), 1);
+}
+
+TEST_F(TransformCacheTest, UpdatesOfOtherClientsRequireAVersionCheck) {
+  ObjectWorldClient other_client(kWorldId, stub_);
+  client_->EnableTransformCache();
+  ASSERT_OK(client_->GetTransform(root_, a_));
+
+  const Pose3d new_root_t_a(eigenmath::Vector3d(2.0, 0.0, 0.0));
+  ASSERT_OK(other_client.UpdateTransform(root_, a_, new_root_t_a));
+
+  // Without version checks, the cache is stale until it is invalidated.
+  ASSERT_OK_AND_ASSIGN(Pose3d root_t_a, client_->GetTransform(root_, a_));
+  EXPECT_TRUE(root_t_a.isApprox(kRootTA));
+  client_->InvalidateTransformCache();
+  ASSERT_OK_AND_ASSIGN(root_t_a, client_->GetTransform(root_, a_));
+  EXPECT_TRUE(root_t_a.isApprox(new_root_t_a));
+
+  // Checking the version before each use picks up every change.
+  client_->EnableTransformCache(
+      {.world_version_check_interval = absl::ZeroDuration()});
+  ASSERT_OK(client_->GetTransform(root_, a_));
+  const int num_list_objects_calls = service_.num_list_objects_calls();
+  ASSERT_OK(client_->GetTransform(root_, a_));
+  EXPECT_EQ(service_.num_list_objects_calls(), num_list_objects_calls);
+  ASSERT_OK(other_client.UpdateTransform(root_, a_, kRootTA));
+  ASSERT_OK_AND_ASSIGN(root_t_a, client_->GetTransform(root_, a_));
+  EXPECT_TRUE(root_t_a.isApprox(kRootTA));
+  EXPECT_EQ(service_.num_list_objects_calls(), num_list_objects_calls + 1);
+}
+
+}  // namespace
+}  // namespace world
+}  // namespace intrinsic